@@ -238,6 +238,9 @@ namespace Ogre
         /** Set a listener for this track. */
         virtual void setListener(Listener* l) { mListener = l; }
 
+        /** Gets the listener of this track, if any. */
+        Listener* getListener() const { return mListener; }
+
         /** Returns the parent Animation object for this track. */
         Animation *getParent() const { return mParent; }
     protected:
@@ -367,9 +370,69 @@ namespace Ogre
         /// @copydoc AnimationTrack::_keyFrameDataChanged
         void _keyFrameDataChanged(void) const;
 
-        /** Returns the KeyFrame at the specified index. */
+        /** Returns the KeyFrame at the specified index.
+        @note Not available for compressed tracks, see getNodeKeyFrameTransform.
+        */
         virtual TransformKeyFrame* getNodeKeyFrame(unsigned short index) const;
 
+        /** Copies the transform of the keyframe at the specified index into kf.
+        @remarks
+            Unlike getNodeKeyFrame this also works for compressed tracks.
+        */
+        void getNodeKeyFrameTransform(unsigned short index, TransformKeyFrame* kf) const;
+        /** Returns the time of the keyframe at the specified index, also for compressed tracks. */
+        Real getNodeKeyFrameTime(unsigned short index) const;
+
+        /** Gets the transforms of the 2 keyframes active at the time given, and the blend value between them.
+        @remarks
+            As AnimationTrack::getKeyFramesAtTime, but copies the transforms into
+            keyFrame1 and keyFrame2 so that it also works for compressed tracks.
+        */
+        Real getKeyFrameTransformsAtTime(const TimeIndex& timeIndex, TransformKeyFrame* keyFrame1,
+            TransformKeyFrame* keyFrame2, unsigned short* firstKeyIndex = 0) const;
+
+        /// @copydoc AnimationTrack::getNumKeyFrames
+        virtual unsigned short getNumKeyFrames(void) const;
+        /** @copydoc AnimationTrack::getKeyFrame
+        @note Throws for compressed tracks, see getNodeKeyFrameTransform.
+        */
+        virtual KeyFrame* getKeyFrame(unsigned short index) const;
+        /// @copydoc AnimationTrack::removeKeyFrame
+        virtual void removeKeyFrame(unsigned short index);
+        /// @copydoc AnimationTrack::getKeyFramesAtTime
+        virtual Real getKeyFramesAtTime(const TimeIndex& timeIndex, KeyFrame** keyFrame1, KeyFrame** keyFrame2,
+            unsigned short* firstKeyIndex = 0) const;
+        /// @copydoc AnimationTrack::removeAllKeyFrames
+        virtual void removeAllKeyFrames(void);
+
+        /** Replaces the keyframes with a compressed copy.
+        @remarks
+            Keyframes which linear interpolation of their neighbours reproduces
+            within tolerance are dropped first, unless the parent animation uses
+            spline interpolation. The translation, rotation and scale are then
+            stored once if they don't change, or not at all if they are the
+            identity, and quantised otherwise, see CompressedTransformKeyFrames.
+            This typically uses a fraction of the memory of the keyframe objects.
+        @par
+            A compressed track is sampled like any other, but its keyframes can't
+            be edited or accessed with getNodeKeyFrame; call decompress first.
+        @param translateTolerance Largest translation error, in units
+        @param rotationTolerance Largest rotation error
+        @param scaleTolerance Largest scale error
+        */
+        void compress(Real translateTolerance = 1e-3f, const Radian& rotationTolerance = Radian(1e-3f),
+            Real scaleTolerance = 1e-3f);
+        /** Recreates editable keyframes from the compressed ones. */
+        void decompress(void);
+        /** Returns whether the keyframes are compressed. */
+        bool isCompressed(void) const { return mCompressed != 0; }
+        /** Returns the compressed keyframes, or null if the track is not compressed. */
+        const CompressedTransformKeyFrames* getCompressedKeyFrames(void) const { return mCompressed; }
+        /** Replaces the keyframes with already compressed ones, taking ownership (internal use only). */
+        void _setCompressedKeyFrames(CompressedTransformKeyFrames* keyFrames);
+
+        /** Returns the number of bytes used by the keyframes. */
+        size_t calculateSize(void) const;
 
         /** Method to determine if this track has any KeyFrames which are
             doing anything useful - can be used to determine if this track
@@ -380,6 +443,11 @@ namespace Ogre
         /** Optimise the current track by removing any duplicate keyframes. */
         virtual void optimise(void);
 
+        /// @copydoc AnimationTrack::_collectKeyFrameTimes
+        virtual void _collectKeyFrameTimes(vector<Real>::type& keyFrameTimes);
+        /// @copydoc AnimationTrack::_buildKeyFrameIndexMap
+        virtual void _buildKeyFrameIndexMap(const vector<Real>::type& keyFrameTimes);
+
         /** Clone this track (internal use only) */
         NodeAnimationTrack* _clone(Animation* newParent) const;
         
@@ -405,6 +473,12 @@ namespace Ogre
         mutable bool mSplineBuildNeeded;
         /// Defines if rotation is done using shortest path
         mutable bool mUseShortestRotationPath ;
+        /// Compressed keyframes, replacing mKeyFrames when not null
+        CompressedTransformKeyFrames* mCompressed;
+
+        /// As getKeyFramesAtTime, for the compressed keyframes
+        Real getCompressedKeyFramesAtTime(const TimeIndex& timeIndex, unsigned short* keyIndex1,
+            unsigned short* keyIndex2) const;
     };
 
     /** Type of vertex animation.
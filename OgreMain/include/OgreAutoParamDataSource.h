@@ -124,6 +124,18 @@ namespace Ogre {
 
         Light mBlankLight;
     public:
+        /// Blocks of automatic constants shared by all programs, by how often they change
+        enum SharedBlock
+        {
+            /// Camera, viewport and time, updated when the camera changes
+            SB_FRAME,
+            /// Ambient light, surface and fog, updated when the pass changes
+            SB_PASS,
+            SB_COUNT
+        };
+        /// Names of the shared parameter sets of the blocks, "OgreFrameParams" and "OgrePassParams"
+        static const String SHARED_BLOCK_NAMES[SB_COUNT];
+
         AutoParamDataSource();
         virtual ~AutoParamDataSource();
         /** Updates the current renderable */
@@ -257,6 +269,39 @@ namespace Ogre {
         virtual void setPassNumber(const int passNumber);
         virtual void incPassNumber(void);
         virtual void updateLightCustomGpuParameter(const GpuProgramParameters::AutoConstantEntry& constantEntry, GpuProgramParameters *params) const;
+
+        /** Sets whether the blocks of shared constants are kept up to date.
+        @remarks
+            When enabled, the GpuSharedParameters named in SHARED_BLOCK_NAMES are
+            created if need be, with a constant for each automatic constant of the
+            block named as in material scripts, e.g. "viewproj_matrix" in
+            OgreFrameParams. Programs using a block through shared_params_ref get
+            these from it, so they are evaluated once per camera or pass rather
+            than for every program, and only changed values are copied.
+        */
+        void setSharedBlocksEnabled(bool enabled);
+        /** Gets whether the blocks of shared constants are kept up to date. */
+        bool getSharedBlocksEnabled(void) const { return mSharedBlocksEnabled; }
+        /** Gets the shared parameters of a block, null unless enabled. */
+        const GpuSharedParametersPtr& getSharedBlock(SharedBlock block) const;
+        /** Evaluates the constants of a block for the current camera or pass.
+        @remarks
+            Does nothing when the blocks are disabled, or when there is no current
+            camera and viewport, or pass, for the block. Otherwise clears the current
+            renderable, as the block does not depend on one.
+        */
+        virtual void updateSharedBlock(SharedBlock block);
+
+    protected:
+        bool mSharedBlocksEnabled;
+        GpuSharedParametersPtr mSharedBlocks[SB_COUNT];
+        /// Automatic constants of each block, laid out as its shared parameters
+        GpuProgramParametersSharedPtr mSharedBlockSources[SB_COUNT];
+        /// Version of the shared parameter definitions each source was created for
+        unsigned long mSharedBlockVersions[SB_COUNT];
+
+        /// Creates the automatic constants of a block for its current definitions
+        void createSharedBlockSource(SharedBlock block);
     };
     /** @} */
     /** @} */
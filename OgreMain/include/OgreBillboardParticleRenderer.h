@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 #include "OgreParticleSystemRenderer.h"
 #include "OgreBillboardSet.h"
+#include "OgreBillboard.h"
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre {
@@ -203,6 +204,11 @@ namespace Ogre {
         /// @copydoc ParticleSystemRenderer::_updateRenderQueue
         void _updateRenderQueue(RenderQueue* queue, 
             list<Particle*>::type& currentParticles, bool cullIndividually);
+        /// @copydoc ParticleSystemRenderer::_supportsParticleArrays
+        bool _supportsParticleArrays(void) const { return true; }
+        /// @copydoc ParticleSystemRenderer::_updateRenderQueueFromArrays
+        void _updateRenderQueueFromArrays(RenderQueue* queue,
+            const ParticleArrays& particles, bool cullIndividually);
         /// @copydoc ParticleSystemRenderer::visitRenderables
         void visitRenderables(Renderable::Visitor* visitor, 
             bool debugRenderables = false);
@@ -241,6 +247,8 @@ namespace Ogre {
         static CmdPointRendering msPointRenderingCmd;
         static CmdAccurateFacing msAccurateFacingCmd;
 
+        /// Particles as billboards, when they are injected all at once
+        vector<Billboard>::type mBillboards;
 
     };
 
@@ -236,7 +236,7 @@ namespace Ogre {
         @remarks
             Optional parameter pBill is only present for type BBT_ORIENTED_SELF and BBT_PERPENDICULAR_SELF
         */
-        void genBillboardAxes(Vector3* pX, Vector3 *pY, const Billboard* pBill = 0);
+        void genBillboardAxes(Vector3* pX, Vector3 *pY, const Billboard* pBill = 0) const;
 
         /** Internal method, generates parametric offsets based on origin.
         */
@@ -248,6 +248,22 @@ namespace Ogre {
         */
         void genVertices(const Vector3* const offsets, const Billboard& pBillboard);
 
+        /** Internal method for generating vertex data at pDest.
+        @return The position after the vertices written
+        */
+        float* genVertices(float* pDest, const Vector3* const offsets, const Billboard& pBillboard) const;
+
+        /** Internal method generating the vertices of a billboard at pDest, see injectBillboard.
+        @remarks
+            Unlike injectBillboard this leaves the state of the set alone, so it
+            can run for different billboards on several threads at once.
+        @return The position after the vertices written
+        */
+        float* genBillboardVertices(float* pDest, const Billboard& bb) const;
+
+        /// Returns whether the axes have to be generated for each billboard
+        bool hasPerBillboardAxes(void) const;
+
         /** Internal method generates vertex offsets.
         @remarks
             Takes in parametric offsets as generated from getParametericOffsets, width and height values
@@ -257,7 +273,7 @@ namespace Ogre {
         */
         void genVertOffsets(Real inleft, Real inright, Real intop, Real inbottom,
             Real width, Real height,
-            const Vector3& x, const Vector3& y, Vector3* pDestVec);
+            const Vector3& x, const Vector3& y, Vector3* pDestVec) const;
 
 
         /** Sort by direction functor */
@@ -298,6 +314,35 @@ namespace Ogre {
         bool mAutoUpdate;
         /// True if the billboard data changed. Will cause vertex buffer update.
         bool mBillboardDataChanged;
+        /// Number of updates the vertex buffer holds, see setStreamingFrames
+        size_t mStreamingFrames;
+        /// First vertex written by the last update
+        size_t mStreamVertexStart;
+        /// First vertex the next update writes when streaming
+        size_t mStreamNextVertex;
+        /// See setParallelBillboardThreshold
+        size_t mParallelBillboardThreshold;
+        /// Active billboards gathered for the worker threads
+        vector<const Billboard*>::type mInjectBillboards;
+        /// Colour format of the vertex buffer
+        VertexElementType mColourType;
+
+        /// Smallest number of billboards a worker thread is given at once
+        static const size_t MIN_PARALLEL_CHUNK_BILLBOARDS = 256;
+
+        /// Billboards given to injectBillboards, by value or by pointer
+        struct BillboardSource
+        {
+            const Billboard* values;
+            const Billboard* const* pointers;
+
+            const Billboard& operator[](size_t i) const;
+        };
+        struct GenVerticesTask;
+        friend struct GenVerticesTask;
+
+        /// Defines billboards from either source
+        void injectBillboards(const BillboardSource& source, size_t count);
 
         /** Internal method creates vertex and index buffers.
         */
@@ -548,6 +593,15 @@ namespace Ogre {
         void beginBillboards(size_t numBillboards = 0);
         /** Define a billboard. */
         void injectBillboard(const Billboard& bb);
+        /** Define a number of billboards.
+        @remarks
+            Equivalent to calling injectBillboard for each of them, except that
+            their vertices are generated on the worker threads of the
+            TaskScheduler when there are at least as many as
+            setParallelBillboardThreshold asks for, and the set does not cull
+            billboards individually.
+        */
+        void injectBillboards(const Billboard* billboards, size_t count);
         /** Finish defining billboards. */
         void endBillboards(void);
         /** Set the bounds of the BillboardSet.
@@ -855,6 +909,39 @@ namespace Ogre {
         */
         void notifyBillboardDataChanged(void) { mBillboardDataChanged = true; }
 
+        /** Sets the number of updates the vertex buffer has room for.
+        @remarks
+            By default each update of an auto updating set discards the vertex
+            buffer and writes it from the start, which stalls or makes the
+            driver rename the buffer while the GPU still reads the previous
+            vertices. With several frames of room, each update writes after the
+            previous one without overwriting it, and the buffer is only
+            discarded when it runs out of room, so it works as a ring.
+        @param numFrames The number of updates to make room for, 0 or 1 for
+            the default of discarding the buffer on every update.
+        */
+        void setStreamingFrames(size_t numFrames);
+
+        /** Returns the number of updates the vertex buffer has room for.
+        @see BillboardSet::setStreamingFrames
+        */
+        size_t getStreamingFrames(void) const { return mStreamingFrames; }
+
+        /** Sets the number of billboards from which their vertices are
+            generated on the worker threads of the TaskScheduler.
+        @remarks
+            This applies to the billboards of the set and to injectBillboards,
+            as long as the set does not cull billboards individually.
+        @param minBillboards The smallest number of billboards to split, or 0
+            to always generate the vertices on the calling thread, the default.
+        */
+        void setParallelBillboardThreshold(size_t minBillboards);
+
+        /** Returns the number of billboards from which their vertices are
+            generated on worker threads, 0 if they never are.
+        */
+        size_t getParallelBillboardThreshold(void) const { return mParallelBillboardThreshold; }
+
         /** @copydoc MovableObject::_releaseManualHardwareResources */
         void _releaseManualHardwareResources() { _destroyBuffers(); }
 
@@ -0,0 +1,173 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __CompressedTransformKeyFrames_H__
+#define __CompressedTransformKeyFrames_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreVector3.h"
+#include "OgreQuaternion.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre {
+
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup Animation
+    *  @{
+    */
+    /** Compact, read only storage of the keyframes of a NodeAnimationTrack.
+    @remarks
+        The keyframe times and the quantised transforms are kept in a single
+        allocation, and any keyframe can be decoded on its own, so a track can
+        be sampled without decompressing it. Each part of the transform is
+        stored in one of the ChannelMode ways: translations and scales are
+        quantised to 16 bits per component within the range the track covers
+        when that is within tolerance, rotations to 48 bits by storing the 3
+        smallest components.
+    @par
+        Use NodeAnimationTrack::compress rather than this class directly.
+    */
+    class _OgreExport CompressedTransformKeyFrames : public AnimationAlloc
+    {
+    public:
+        /// Parts of the transform of a keyframe
+        enum Channel
+        {
+            CH_TRANSLATE,
+            CH_ROTATION,
+            CH_SCALE,
+            CH_COUNT
+        };
+
+        /// How a channel is stored
+        enum ChannelMode
+        {
+            /// Zero translation, identity rotation or unit scale in every keyframe, nothing stored
+            CM_IDENTITY = 0,
+            /// The same value in every keyframe, stored once
+            CM_CONSTANT = 1,
+            /// A quantised value for every keyframe, 6 bytes each
+            CM_QUANTISED = 2,
+            /** A full precision value for every keyframe, for translations and
+                scales with a range too wide to quantise within tolerance */
+            CM_FULL = 3
+        };
+
+        CompressedTransformKeyFrames();
+        CompressedTransformKeyFrames(const CompressedTransformKeyFrames& rhs);
+        ~CompressedTransformKeyFrames();
+
+        /** Replaces the contents with the keyframes given.
+        @param numKeyFrames Number of keyframes, the times must be in ascending order
+        @param translateTolerance, rotationTolerance, scaleTolerance Largest difference
+            between the keyframes of a channel for it to be stored once, and from
+            the identity for it not to be stored at all
+        */
+        void encode(unsigned short numKeyFrames, const Real* times, const Vector3* translates,
+            const Quaternion* rotations, const Vector3* scales, Real translateTolerance,
+            const Radian& rotationTolerance, Real scaleTolerance);
+
+        /** Returns the number of keyframes. */
+        unsigned short getNumKeyFrames(void) const { return mNumKeyFrames; }
+        /** Returns the times of the keyframes, in ascending order. */
+        const Real* getTimes(void) const { return mTimes; }
+        /** Returns how a channel is stored. */
+        ChannelMode getChannelMode(Channel channel) const { return static_cast<ChannelMode>(mModes[channel]); }
+
+        /** Decodes the translation of a keyframe. */
+        Vector3 getTranslate(unsigned short index) const;
+        /** Decodes the rotation of a keyframe. */
+        Quaternion getRotation(unsigned short index) const;
+        /** Decodes the scale of a keyframe. */
+        Vector3 getScale(unsigned short index) const;
+        /** Decodes the transform of a keyframe into kf, leaving its time alone. */
+        void getKeyFrame(unsigned short index, TransformKeyFrame* kf) const;
+
+        /** Re-bases the keyframes relative to a given keyframe.
+        @see NodeAnimationTrack::_applyBaseKeyFrame
+        */
+        void applyBaseKeyFrame(const TransformKeyFrame* base);
+
+        /** Returns the number of bytes used, including this object. */
+        size_t calculateSize(void) const;
+
+        /** Returns the angle of the rotation between two orientations.
+        @remarks
+            Unlike Quaternion::equals this stays accurate for the small angles
+            compression tolerances are given in.
+        */
+        static Radian getRotationError(const Quaternion& a, const Quaternion& b);
+
+    protected:
+        friend class SkeletonSerializer;
+
+        unsigned short mNumKeyFrames;
+        /// ChannelMode of each Channel
+        uint8 mModes[CH_COUNT];
+        /// Constant value, or smallest value of the quantised range
+        Vector3 mTranslateBase;
+        Vector3 mScaleBase;
+        /// Difference between successive quantised values
+        Vector3 mTranslateStep;
+        Vector3 mScaleStep;
+        /// Constant rotation
+        Quaternion mRotation;
+        /// Keyframe times, followed by the channel data in the same allocation
+        Real* mTimes;
+        /// 3 values per keyframe for each CM_FULL channel, null otherwise
+        Real* mFull[CH_COUNT];
+        /// 3 values per keyframe for each CM_QUANTISED channel, null otherwise
+        uint16* mQuantised[CH_COUNT];
+
+        /// Allocates the keyframe data for the current modes
+        void allocate(unsigned short numKeyFrames);
+        void deallocate(void);
+        /// Returns the size of the keyframe data in bytes
+        size_t getDataSize(void) const;
+
+        /// Picks the mode of a translation or scale channel, and its base and step
+        static ChannelMode analyseVectors(unsigned short numKeyFrames, const Vector3* values,
+            const Vector3& identity, Real tolerance, Vector3& base, Vector3& step);
+        /// Stores the values of a translation or scale channel once allocated
+        void storeVectors(Channel channel, const Vector3* values, const Vector3& base,
+            const Vector3& step);
+        Vector3 decodeVector(Channel channel, unsigned short index, const Vector3& identity,
+            const Vector3& base, const Vector3& step) const;
+
+    private:
+        CompressedTransformKeyFrames& operator=(const CompressedTransformKeyFrames&);
+    };
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -650,6 +650,32 @@ namespace Ogre {
         void close(void);
 
     };
+
+    /** Read-only stream over a file mapped into memory.
+    @remarks
+        Being a MemoryDataStream, the contents can be parsed in place through
+        getPtr rather than copied to the heap first, and the pages are only
+        read from disk as they are touched. The file stays mapped until the
+        stream is closed.
+    */
+    class _OgreExport MemoryMappedDataStream : public MemoryDataStream
+    {
+    public:
+        /** Map a file.
+        @param name The name to give the stream
+        @param path The path of the file to map
+        @note Throws an exception if the file can't be mapped.
+        */
+        MemoryMappedDataStream(const String& name, const String& path);
+        ~MemoryMappedDataStream();
+
+        /** @copydoc DataStream::close
+        */
+        void close(void);
+
+        /// Gets whether memory mapping files is supported on this platform
+        static bool isSupported(void);
+    };
     /** @} */
     /** @} */
 }
@@ -0,0 +1,291 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __DynamicAABBTree_H__
+#define __DynamicAABBTree_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreAxisAlignedBox.h"
+#include "OgreRay.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre {
+
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup Scene
+    *  @{
+    */
+    /** A bounding volume hierarchy of axis aligned boxes which can be updated incrementally.
+    @remarks
+        Each box inserted becomes a leaf ('proxy') of a balanced binary tree whose inner
+        nodes bound their two children. Proxies store a slightly enlarged ('fat') copy of
+        the box they were given, so objects moving by small amounts do not change the tree
+        at all; larger moves remove and reinsert the leaf. Insertion picks the sibling
+        with the least increase in surface area and the tree is rebalanced with rotations
+        on the way back up, so box, ray and volume queries visit O(log n) nodes for
+        typical scenes.
+    @par
+        Infinite boxes are kept out of the hierarchy and reported by every query, null
+        boxes are not accepted. The tree holds no reference to the objects themselves,
+        only the user data pointer given on insertion; queries only test the fat boxes,
+        the callback is expected to do any exact test required.
+    */
+    class _OgreExport DynamicAABBTree : public SceneMgtAlloc
+    {
+    public:
+        /// Value returned for and used as an invalid proxy
+        static const int NULL_PROXY = -1;
+
+        /** Constructor.
+        @param fatness
+            Fraction of the box size added on each side of a box when it is inserted.
+        @param minMargin
+            Smallest distance added on each side, so that small and zero size boxes
+            (point objects) can also move a little without being reinserted.
+        */
+        explicit DynamicAABBTree(Real fatness = 0.1f, Real minMargin = 0.1f);
+        ~DynamicAABBTree();
+
+        /** Inserts a box and returns its proxy. */
+        int createProxy(const AxisAlignedBox& box, void* userData);
+
+        /** Removes a proxy from the tree. */
+        void destroyProxy(int proxy);
+
+        /** Updates the box of a proxy.
+        @return
+            true if the proxy had to be reinserted, false if the new box still
+            fitted in its fat box.
+        */
+        bool moveProxy(int proxy, const AxisAlignedBox& box);
+
+        /** Gets the user data of a proxy. */
+        void* getUserData(int proxy) const { return mNodes[proxy].userData; }
+
+        /** Removes all proxies. */
+        void clear(void);
+
+        /** Gets the number of proxies in the tree. */
+        size_t getProxyCount(void) const { return mProxyCount; }
+
+        /** Gets the height of the tree, 0 for a single leaf, -1 when empty. */
+        int getHeight(void) const { return mRoot == NULL_PROXY ? -1 : mNodes[mRoot].height; }
+
+        /** Calls callback(proxy) for each proxy whose fat box overlaps box.
+        @remarks
+            The query stops early if the callback returns false.
+        @return
+            false if the query was stopped by the callback.
+        */
+        template <typename Callback>
+        bool query(const AxisAlignedBox& box, Callback& callback) const
+        {
+            if (box.isNull())
+                return true;
+            if (!queryInfinite(callback))
+                return false;
+            if (box.isInfinite())
+                return queryAll(callback);
+
+            const Vector3& boxMin = box.getMinimum();
+            const Vector3& boxMax = box.getMaximum();
+            return traverse(OverlapTest(boxMin, boxMax), callback);
+        }
+
+        /** Calls callback(proxy) for each proxy whose fat box is hit by ray.
+        @remarks
+            Proxies are not reported in order of distance. The query stops early if the
+            callback returns false.
+        @return
+            false if the query was stopped by the callback.
+        */
+        template <typename Callback>
+        bool raycast(const Ray& ray, Callback& callback) const
+        {
+            if (!queryInfinite(callback))
+                return false;
+            return traverse(RayTest(ray), callback);
+        }
+
+        /** Calls callback(proxy) for each proxy whose fat box may be inside volume.
+        @remarks
+            Volume is any type with an intersects(const AxisAlignedBox&) method that
+            never misses an intersection, e.g. PlaneBoundedVolume.
+        @return
+            false if the query was stopped by the callback.
+        */
+        template <typename Volume, typename Callback>
+        bool queryVolume(const Volume& volume, Callback& callback) const
+        {
+            if (!queryInfinite(callback))
+                return false;
+            return traverse(VolumeTest<Volume>(volume), callback);
+        }
+
+    protected:
+        /// Traversal stack depth which does not need a heap allocation
+        static const int STACK_SIZE = 64;
+
+        struct TreeNode
+        {
+            Vector3 minimum;
+            Vector3 maximum;
+            void* userData;
+            /// Parent node, or next free node when on the free list
+            int parent;
+            int child1;
+            int child2;
+            /// 0 for leaves, -1 for free nodes and infinite proxies
+            int height;
+
+            bool isLeaf(void) const { return child1 == NULL_PROXY; }
+        };
+
+        struct OverlapTest
+        {
+            const Vector3& mMin;
+            const Vector3& mMax;
+            OverlapTest(const Vector3& minimum, const Vector3& maximum)
+                : mMin(minimum), mMax(maximum) {}
+            bool operator()(const TreeNode& node) const
+            {
+                return !(node.maximum.x < mMin.x || node.maximum.y < mMin.y || node.maximum.z < mMin.z ||
+                    node.minimum.x > mMax.x || node.minimum.y > mMax.y || node.minimum.z > mMax.z);
+            }
+        };
+
+        struct RayTest
+        {
+            Vector3 mOrigin;
+            Vector3 mInvDir;
+            RayTest(const Ray& ray);
+            bool operator()(const TreeNode& node) const;
+        };
+
+        template <typename Volume>
+        struct VolumeTest
+        {
+            const Volume& mVolume;
+            VolumeTest(const Volume& volume) : mVolume(volume) {}
+            bool operator()(const TreeNode& node) const
+            {
+                return mVolume.intersects(AxisAlignedBox(node.minimum, node.maximum));
+            }
+        };
+
+        template <typename Test, typename Callback>
+        bool traverse(const Test& test, Callback& callback) const
+        {
+            if (mRoot == NULL_PROXY)
+                return true;
+
+            // Depth first, the stack never holds more than height + 1 nodes. Queries
+            // keep no state in the tree so they may run concurrently or be nested.
+            int localStack[STACK_SIZE];
+            vector<int>::type heapStack;
+            int* stack = localStack;
+            if (mNodes[mRoot].height >= STACK_SIZE)
+            {
+                heapStack.resize(mNodes[mRoot].height + 1);
+                stack = &heapStack[0];
+            }
+
+            size_t top = 0;
+            stack[top++] = mRoot;
+            while (top)
+            {
+                const int index = stack[--top];
+                const TreeNode& node = mNodes[index];
+                if (!test(node))
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    if (!callback(index))
+                        return false;
+                }
+                else
+                {
+                    stack[top++] = node.child1;
+                    stack[top++] = node.child2;
+                }
+            }
+            return true;
+        }
+
+        template <typename Callback>
+        bool queryInfinite(Callback& callback) const
+        {
+            for (size_t i = 0; i < mInfiniteProxies.size(); ++i)
+            {
+                if (!callback(mInfiniteProxies[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        template <typename Callback>
+        bool queryAll(Callback& callback) const
+        {
+            for (size_t i = 0; i < mNodes.size(); ++i)
+            {
+                if (mNodes[i].height == 0 && !callback(static_cast<int>(i)))
+                    return false;
+            }
+            return true;
+        }
+
+        int allocateNode(void);
+        void freeNode(int index);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int index);
+        void refit(int index);
+        /// Sets the fat box of a leaf from the box given
+        void setFatBox(TreeNode& node, const AxisAlignedBox& box) const;
+
+        static Real surfaceArea(const Vector3& minimum, const Vector3& maximum);
+
+        typedef vector<TreeNode>::type TreeNodeList;
+        TreeNodeList mNodes;
+        vector<int>::type mInfiniteProxies;
+        int mRoot;
+        int mFreeList;
+        size_t mProxyCount;
+        Real mFatness;
+        Real mMinMargin;
+    };
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
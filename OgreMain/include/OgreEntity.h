@@ -82,6 +82,8 @@ namespace Ogre {
         // Allow EntityFactory full access
         friend class EntityFactory;
         friend class SubEntity;
+        friend class SkeletonAnimationBatch;
+        friend class SoftwareSkinningBatch;
     public:
         
         typedef set<Entity*>::type EntitySet;
@@ -179,9 +181,17 @@ namespace Ogre {
         unsigned short mNumBoneMatrices;
         /// Records the last frame in which animation was updated.
         unsigned long mFrameAnimationLastUpdated;
+        /// Records the last frame in which SkeletonAnimationBatch updated the bones
+        /// for the animation state, which updateAnimation doesn't see.
+        unsigned long mFrameAnimationLastBatched;
+        /// Records the last frame in which the entity was added to a render queue.
+        unsigned long mFrameLastQueued;
 
-        /// Perform all the updates required for an animated entity.
-        void updateAnimation(void);
+        /** Perform all the updates required for an animated entity.
+        @param batch If given, software vertex blends are recorded in it to
+            run later, unless the entity has vertex animation.
+        */
+        void updateAnimation(SoftwareSkinningBatch* batch = 0);
 
         /// Records the last frame in which the bones was updated.
         /// It's a pointer because it can be shared between different entities with
@@ -753,6 +763,17 @@ namespace Ogre {
         */
         bool _isSkeletonAnimated(void) const;
 
+        /** Tests if the entity was added to a render queue in this or the previous frame.
+        @remarks
+            Used to skip the entities out of view when animating them before
+            culling, see SceneManager::setSkeletalAnimationBatching.
+        */
+        bool _isRecentlyQueued(void) const;
+
+        /** Tests if a manual LOD entity was last displayed instead of this one.
+        */
+        bool _isManualLodDisplayed(void) const;
+
         /** Advanced method to get the temporarily blended skeletal vertex information
             for entities which are software skinned.
         @remarks
@@ -120,7 +120,36 @@ namespace Ogre {
             return msIgnoreHidden;
         }
 
+        /// Set whether files opened read-only are memory mapped, see
+        /// MemoryMappedDataStream. Loaders can then parse the data in place
+        /// rather than copying it to the heap. The default is false.
+        static void setUseMemoryMapping(bool useMapping)
+        {
+            msUseMemoryMapping = useMapping;
+        }
+
+        /// Get whether files opened read-only are memory mapped.
+        static bool getUseMemoryMapping()
+        {
+            return msUseMemoryMapping;
+        }
+
+        /// Set the size in bytes from which files are memory mapped, smaller
+        /// files are cheaper to read through a file stream. The default is 64KB.
+        static void setMemoryMappingThreshold(size_t threshold)
+        {
+            msMemoryMappingThreshold = threshold;
+        }
+
+        /// Get the size in bytes from which files are memory mapped.
+        static size_t getMemoryMappingThreshold()
+        {
+            return msMemoryMappingThreshold;
+        }
+
         static bool msIgnoreHidden;
+        static bool msUseMemoryMapping;
+        static size_t msMemoryMappingThreshold;
     };
 
     /** Specialisation of ArchiveFactory for FileSystem files. */
@@ -568,6 +568,20 @@ namespace Ogre {
         : physicalIndex(bufIdx), currentSize(curSz), variability(v) {}
     };
     typedef map<size_t, GpuLogicalIndexUse>::type GpuLogicalIndexUseMap;
+
+    /** A range of one of the physical constant buffers of GpuProgramParameters.
+    @see GpuProgramParameters::_getRangesModifiedSince
+    */
+    struct GpuConstantRange
+    {
+        /// Physical index of the first constant
+        size_t physicalIndex;
+        /// Number of constants, not of 4 element registers
+        size_t count;
+
+        GpuConstantRange(size_t index, size_t cnt) : physicalIndex(index), count(cnt) {}
+    };
+    typedef vector<GpuConstantRange>::type GpuConstantRangeList;
     /// Container struct to allow params to safely & update shared list of logical buffer assignments
     struct _OgreExport GpuLogicalBufferStruct : public GpuParamsAlloc
     {
@@ -1564,6 +1578,30 @@ namespace Ogre {
         /// Return the variability for an auto constant
         uint16 deriveVariability(AutoConstantType act);
 
+        /// Number of constants sharing a modified version
+        static const size_t CONSTANT_BLOCK_SIZE = 4;
+        /// Version constants modified from now on are recorded at
+        unsigned long mConstantsVersion;
+        /** Version each block of the float, double, int and uint buffers was last
+            modified at, updated lazily to the size of its buffer. */
+        mutable vector<unsigned long>::type mModifiedVersions[4];
+        /// Buffer sizes mModifiedVersions was last updated to
+        mutable size_t mModifiedBufferSizes[4];
+        /// Returns the mModifiedVersions of a buffer, after checking its size
+        vector<unsigned long>::type& getModifiedVersions(BaseConstantType type) const;
+        /// Records the modification of a range of a buffer
+        void markModified(BaseConstantType type, size_t physicalIndex, size_t count)
+        {
+            if (!count)
+                return;
+            vector<unsigned long>::type& versions = getModifiedVersions(type);
+            size_t end = (physicalIndex + count - 1) / CONSTANT_BLOCK_SIZE + 1;
+            for (size_t b = physicalIndex / CONSTANT_BLOCK_SIZE; b < end; ++b)
+                versions[b] = mConstantsVersion;
+        }
+        /// Records the modification of all constants, for when buffers are replaced
+        void markAllModified(void);
+
         void copySharedParamSetUsage(const GpuSharedParamUsageList& srcList);
 
         GpuSharedParamUsageList mSharedParamSets;
@@ -2105,6 +2143,49 @@ namespace Ogre {
         */
         void _updateAutoParams(const AutoParamDataSource* source, uint16 variabilityMask);
 
+        /** Notes that the constants were uploaded, for render systems which only upload
+            what was modified since their last upload.
+        @remarks
+            Constants are only recorded as modified when a write changes their value,
+            so an unchanged auto constant is not uploaded again. Render systems keep
+            the version returned here and pass it to _isRangeModifiedSince or
+            _getRangesModifiedSince on their next upload of the same parameters. The
+            versions of several render systems or programs using the same parameters
+            do not interfere with each other.
+        @par
+            Any writes through the pointers of getFloatPointer and the like must be
+            recorded with _markRangeModified.
+        @return The version of the constants as of this upload
+        */
+        unsigned long _markConstantsUploaded(void);
+
+        /** Returns whether any of a range of constants was modified since an upload.
+        @param type BCT_FLOAT, BCT_DOUBLE, BCT_INT or BCT_UINT, for the buffer
+        @param physicalIndex, count The range of the buffer, in constants
+        @param version What _markConstantsUploaded returned at the upload, 0 for
+            any time
+        */
+        bool _isRangeModifiedSince(BaseConstantType type, size_t physicalIndex, size_t count,
+            unsigned long version) const;
+
+        /** Gets the ranges of a buffer modified since an upload.
+        @remarks
+            Adjacent modified constants are merged into a single range, so that
+            render systems uploading by physical index can do so with as few
+            calls as possible. Ranges are aligned to 4 constants, clipped to the
+            size of the buffer.
+        @param type BCT_FLOAT, BCT_DOUBLE, BCT_INT or BCT_UINT, for the buffer
+        @param version What _markConstantsUploaded returned at the upload, 0 for
+            any time
+        @param ranges Replaced with the modified ranges, in ascending order
+        */
+        void _getRangesModifiedSince(BaseConstantType type, unsigned long version,
+            GpuConstantRangeList& ranges) const;
+
+        /** Records that constants were modified other than through the methods of this class. */
+        void _markRangeModified(BaseConstantType type, size_t physicalIndex, size_t count)
+        { markModified(type, physicalIndex, count); }
+
         /** Tells the program whether to ignore missing parameters or not.
          */
         void setIgnoreMissingParams(bool state) { mIgnoreMissingParams = state; }
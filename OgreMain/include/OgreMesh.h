@@ -51,6 +51,7 @@ namespace Ogre {
 
     struct MeshLodUsage;
     class LodStrategy;
+    class HardwareBufferManagerBase;
 
     /** Resource holding data about 3D mesh.
     @remarks
@@ -172,6 +173,10 @@ namespace Ogre {
         HardwareBuffer::Usage mIndexBufferUsage;
         bool mVertexBufferShadowBuffer;
         bool mIndexBufferShadowBuffer;
+        /// Creates the buffers when the mesh is loaded, the HardwareBufferManager if null
+        HardwareBufferManagerBase* mBufferManager;
+        /// Holds the buffers of a mesh parsed by prepareImpl until loadImpl uploads them
+        HardwareBufferManagerBase* mParsedBufferManager;
 
 
         bool mPreparedForShadowVolumes;
@@ -210,6 +215,11 @@ namespace Ogre {
         void unloadImpl(void);
         /// @copydoc Resource::calculateSize
         size_t calculateSize(void) const;
+        /** Replaces the system memory buffers of a mesh parsed by prepareImpl with
+            ones from getHardwareBufferManager, writing each of them once. */
+        void uploadParsedBuffers(void);
+        /// Loads the skeleton named by mSkeletonName, logging if it can't be loaded
+        void loadSkeleton(void);
 
         void mergeAdjacentTexcoords( unsigned short finalTexCoordSet,
                                      unsigned short texCoordSetToDestroy, VertexData *vertexData );
@@ -591,6 +601,16 @@ namespace Ogre {
         bool isVertexBufferShadowed(void) const { return mVertexBufferShadowBuffer; }
         /** Gets whether or not this meshes index buffers are shadowed. */
         bool isIndexBufferShadowed(void) const { return mIndexBufferShadowBuffer; }
+        /** Sets the manager which creates the buffers of this mesh when it is loaded.
+        @remarks
+            By default the buffers come from the HardwareBufferManager. Another
+            manager, such as a DefaultHardwareBufferManagerBase, lets the mesh be
+            loaded without a render system. Set it before loading the mesh, and
+            keep it until the mesh is unloaded.
+        */
+        void setHardwareBufferManager(HardwareBufferManagerBase* bufferManager) { mBufferManager = bufferManager; }
+        /** Gets the manager which creates the buffers of this mesh when it is loaded. */
+        HardwareBufferManagerBase* getHardwareBufferManager(void) const;
        
 
         /** Rationalises the passed in bone assignment list.
@@ -69,6 +69,9 @@ namespace Ogre {
                 // unsigned int* faceVertexIndices (indexCount)
                 // OR
                 // unsigned short* faceVertexIndices (indexCount)
+                // OR, in the compact version of the format
+                // unsigned int encodedSize
+                // unsigned char* encodedIndices (encodedSize) : zigzag varint deltas
                 // M_GEOMETRY chunk (Optional: present only if useSharedVertices = false)
                 M_SUBMESH_OPERATION = 0x4010, // optional, trilist assumed if missing
                     // unsigned short operationType
@@ -98,6 +101,15 @@ namespace Ogre {
                     // unsigned short vertexSize;   // Per-vertex size, must agree with declaration at this index
                     M_GEOMETRY_VERTEX_BUFFER_DATA = 0x5210,
                         // raw buffer data
+                M_GEOMETRY_COMPACT_VERTEX_BUFFER = 0x5300, // Repeating section, instead of M_GEOMETRY_VERTEX_BUFFER
+                    // unsigned short bindIndex;    // Index to bind this buffer to
+                    // unsigned short vertexSize;   // Per-vertex size, must agree with declaration at this index
+                    // Then for each element of the declaration at this index, in declaration order:
+                    // unsigned short encoding;     // MeshSerializerImpl::CompactVertexEncoding
+                    // CVE_RAW: the element of each vertex in turn
+                    // CVE_QUANTISED_POSITION: float base[3], float step[3], unsigned short[3] per vertex
+                    // CVE_OCTAHEDRAL: short[2] per vertex
+                    // CVE_HALF: unsigned short per component per vertex
             M_MESH_SKELETON_LINK = 0x6000,
                 // Optional link to skeleton
                 // char* skeletonName           : name of .skeleton to use
@@ -127,6 +139,7 @@ namespace Ogre {
                     // unsigned short* faceIndexes;  (indexCount)
                     // OR
                     // unsigned int* faceIndexes;  (indexCount)
+                    // OR, in the compact version of the format, encoded as for M_SUBMESH
             M_MESH_BOUNDS = 0x9000,
                 // float minx, miny, minz
                 // float maxx, maxy, maxz
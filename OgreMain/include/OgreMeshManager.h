@@ -387,6 +387,18 @@ namespace Ogre {
         /** Retrieves whether all Meshes should prepare themselves for shadow volumes. */
         bool getPrepareAllMeshesForShadowVolumes(void);
 
+        /** Sets whether meshes are parsed when prepared rather than when loaded.
+        @remarks
+            Preparing a mesh then reads its file into buffers in system memory,
+            which can be done in a background thread, and loading it only creates
+            the hardware buffers and uploads each of them with a single write.
+            Any MeshSerializerListener is called by the preparing thread. Off by
+            default.
+        */
+        void setParseMeshesOnPrepare(bool enable);
+        /** Retrieves whether meshes are parsed when prepared. */
+        bool getParseMeshesOnPrepare(void) const;
+
         /// @copydoc Singleton::getSingleton()
         static MeshManager& getSingleton(void);
         /// @copydoc Singleton::getSingleton()
@@ -470,6 +482,7 @@ namespace Ogre {
         void loadManualCurvedIllusionPlane(Mesh* pMesh, MeshBuildParams& params);
 
         bool mPrepAllMeshesForShadowVolumes;
+        bool mParseMeshesOnPrepare;
     
         //the factor by which the bounding box of an entity is padded   
         Real mBoundsPaddingFactor;
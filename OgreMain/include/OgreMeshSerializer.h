@@ -56,7 +56,11 @@ namespace Ogre {
         MESH_VERSION_1_0,
         
         /// Legacy versions, DO NOT USE for writing
-        MESH_VERSION_LEGACY
+        MESH_VERSION_LEGACY,
+
+        /// OGRE version v1.10+ with compact, lossy vertex and index data.
+        /// Last so the values of the versions above are kept.
+        MESH_VERSION_1_10_COMPACT
     };
 
     /** \addtogroup Core
@@ -91,6 +91,9 @@ namespace Ogre {
         virtual void writeSubMeshOperation(const SubMesh* s);
         virtual void writeSubMeshTextureAliases(const SubMesh* s);
         virtual void writeGeometry(const VertexData* pGeom);
+        virtual void writeGeometryVertexBuffer(const VertexData* pGeom, unsigned short bindIndex,
+            const HardwareVertexBufferSharedPtr& vbuf);
+        virtual void writeIndexes(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount);
         virtual void writeSkeletonLink(const String& skelName);
         virtual void writeMeshBoneAssignment(const VertexBoneAssignment& assign);
         virtual void writeSubMeshBoneAssignment(const VertexBoneAssignment& assign);
@@ -116,6 +119,9 @@ namespace Ogre {
         virtual size_t calcMeshSize(const Mesh* pMesh);
         virtual size_t calcSubMeshSize(const SubMesh* pSub);
         virtual size_t calcGeometrySize(const VertexData* pGeom);
+        virtual size_t calcGeometryVertexBufferSize(const VertexData* pGeom, unsigned short bindIndex,
+            const HardwareVertexBufferSharedPtr& vbuf);
+        virtual size_t calcIndexesSize(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount);
         virtual size_t calcSkeletonLinkSize(const String& skelName);
         virtual size_t calcBoneAssignmentSize(void);
         virtual size_t calcSubMeshOperationSize(const SubMesh* pSub);
@@ -151,6 +157,7 @@ namespace Ogre {
         virtual void readGeometryVertexDeclaration(DataStreamPtr& stream, Mesh* pMesh, VertexData* dest);
         virtual void readGeometryVertexElement(DataStreamPtr& stream, Mesh* pMesh, VertexData* dest);
         virtual void readGeometryVertexBuffer(DataStreamPtr& stream, Mesh* pMesh, VertexData* dest);
+        virtual void readGeometryCompactVertexBuffer(DataStreamPtr& stream, Mesh* pMesh, VertexData* dest);
 
         virtual void readSkeletonLink(DataStreamPtr& stream, Mesh* pMesh, MeshSerializerListener *listener);
         virtual void readMeshBoneAssignment(DataStreamPtr& stream, Mesh* pMesh);
@@ -170,10 +177,20 @@ namespace Ogre {
         virtual void readAnimation(DataStreamPtr& stream, Mesh* pMesh);
         virtual void readAnimationTrack(DataStreamPtr& stream, Animation* anim, 
             Mesh* pMesh);
-        virtual void readMorphKeyFrame(DataStreamPtr& stream, VertexAnimationTrack* track);
+        virtual void readMorphKeyFrame(DataStreamPtr& stream, Mesh* pMesh, VertexAnimationTrack* track);
         virtual void readPoseKeyFrame(DataStreamPtr& stream, VertexAnimationTrack* track);
         virtual void readExtremes(DataStreamPtr& stream, Mesh *pMesh);
+        /// Reads the whole of an index buffer
+        virtual void readIndexes(DataStreamPtr& stream, const HardwareIndexBufferSharedPtr& ibuf);
+        /// Skips the indexes written by writeIndexes
+        virtual void skipIndexes(DataStreamPtr& stream, size_t indexCount, bool idx32Bit);
 
+        /** Fills a whole buffer straight from the memory of the stream, without
+            locking it, when the data needs no endian conversion.
+        @return false if the stream is not in memory or the data must be
+            converted, in which case nothing is read
+        */
+        bool readBufferInPlace(DataStreamPtr& stream, HardwareBuffer* buf);
 
         /// Flip an entire vertex buffer from little endian
         virtual void flipFromLittleEndian(void* pData, size_t vertexCount, size_t vertexSize, const VertexDeclaration::VertexElementList& elems);
@@ -187,6 +204,56 @@ namespace Ogre {
         virtual void enableValidation();
 
         ushort exportedLodCount; // Needed to limit exported Edge data, when exporting
+
+        /// How an element of an M_GEOMETRY_COMPACT_VERTEX_BUFFER is stored
+        enum CompactVertexEncoding
+        {
+            /// As in the vertex buffer
+            CVE_RAW = 0,
+            /// 16 bits per component within the range of the buffer, for VET_FLOAT3 positions
+            CVE_QUANTISED_POSITION = 1,
+            /// 2 16 bit components, for unit length VET_FLOAT3 normals, tangents and binormals
+            CVE_OCTAHEDRAL = 2,
+            /// Half floats, for VET_FLOAT1 to VET_FLOAT3 texture coordinates
+            CVE_HALF = 3
+        };
+    };
+
+    /** Class for writing the latest version of the .mesh format with compact
+        vertex and index data.
+    @remarks
+        Positions are quantised to 16 bits per component within the bounds of
+        their buffer, unit normals, tangents and binormals are stored as 2
+        octahedral 16 bit components, and texture coordinates as half floats
+        where that is accurate to 1/4096. Other elements are stored as they are.
+        Indexes are stored as the zigzag encoded difference from the previous
+        index, 7 bits per byte. The data is decoded to the original vertex
+        element types when the mesh is loaded.
+    */
+    class _OgrePrivate MeshSerializerImpl_Compact : public MeshSerializerImpl
+    {
+    public:
+        MeshSerializerImpl_Compact();
+        ~MeshSerializerImpl_Compact();
+    protected:
+        virtual void writeGeometryVertexBuffer(const VertexData* pGeom, unsigned short bindIndex,
+            const HardwareVertexBufferSharedPtr& vbuf);
+        virtual size_t calcGeometryVertexBufferSize(const VertexData* pGeom, unsigned short bindIndex,
+            const HardwareVertexBufferSharedPtr& vbuf);
+        virtual void writeIndexes(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount);
+        virtual size_t calcIndexesSize(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount);
+        virtual void readIndexes(DataStreamPtr& stream, const HardwareIndexBufferSharedPtr& ibuf);
+        virtual void skipIndexes(DataStreamPtr& stream, size_t indexCount, bool idx32Bit);
+
+        /// Picks the CompactVertexEncoding of each element at a binding
+        void getCompactEncodings(const VertexData* pGeom, const VertexDeclaration::VertexElementList& elems,
+            const uchar* pBuf, size_t vertexSize, vector<uint16>::type& encodings);
+        /// Size of the elements of an M_GEOMETRY_COMPACT_VERTEX_BUFFER
+        static size_t calcCompactElementsSize(const VertexDeclaration::VertexElementList& elems,
+            const vector<uint16>::type& encodings, size_t vertexCount);
+        /// Encodes the first indexCount indexes of a buffer
+        void encodeIndexes(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount,
+            vector<uchar>::type& encoded);
     };
 
 
@@ -231,7 +298,7 @@ namespace Ogre {
         ~MeshSerializerImpl_v1_41();
     protected:
         void writeMorphKeyframe(const VertexMorphKeyFrame* kf, size_t vertexCount);
-        void readMorphKeyFrame(DataStreamPtr& stream, VertexAnimationTrack* track);
+        void readMorphKeyFrame(DataStreamPtr& stream, Mesh* pMesh, VertexAnimationTrack* track);
         void writePose(const Pose* pose);
         void readPose(DataStreamPtr& stream, Mesh* pMesh);
         size_t calcMorphKeyframeSize(const VertexMorphKeyFrame* kf, size_t vertexCount);
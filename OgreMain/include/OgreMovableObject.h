@@ -136,6 +136,8 @@ namespace Ogre {
         uint32 mQueryFlags;
         /// Flags determining whether this object is visible (compared to SceneManager mask)
         uint32 mVisibilityFlags;
+        /// Proxy in the scene query tree of the SceneManager, if it has one
+        int mQueryProxy;
         /// Cached world AABB of this object
         mutable AxisAlignedBox mWorldAABB;
         // Cached world bounding sphere
@@ -154,6 +156,8 @@ namespace Ogre {
         mutable LightList mLightList;
         /// The last frame that this light list was updated in
         mutable ulong mLightListUpdated;
+        /// SceneManager::_getLightListSignature when the light list was updated, 0 if unknown
+        mutable uint64 mLightListSignature;
 
         /// the light mask defined for this movable. This will be taken into consideration when deciding which light should affect this movable
         uint32 mLightMask;
@@ -184,6 +188,10 @@ namespace Ogre {
         virtual void _notifyManager(SceneManager* man) { mManager = man; }
         /** Get the manager of this object, if any (internal use only) */
         SceneManager* _getManager(void) const { return mManager; }
+        /** Sets the proxy of this object in the scene query tree (internal use only) */
+        void _setQueryProxy(int proxy) { mQueryProxy = proxy; }
+        /** Gets the proxy of this object in the scene query tree, -1 if none (internal use only) */
+        int _getQueryProxy(void) const { return mQueryProxy; }
 
         /** Notifies the movable object that hardware resources were lost
             @remarks
@@ -96,6 +96,33 @@ namespace Ogre {
             virtual void nodeDetached(const Node*) {}
         };
 
+        /** One depth level of a flattened scene graph transform update.
+        @remarks
+            Nodes are gathered breadth first so that every node in a level only
+            depends on nodes of the level above it. The derived transforms are
+            kept in separate contiguous arrays, so a level can be split into
+            ranges and processed concurrently without touching the parents.
+        @see SceneManager::setParallelTransformUpdate
+        */
+        struct UpdateLevel
+        {
+            /// Nodes whose derived transform must be recomputed at this depth
+            vector<Node*>::type nodes;
+            /// Slot of each node's parent in the level above, or NO_PARENT_SLOT
+            vector<uint32>::type parentSlots;
+            vector<Vector3>::type derivedPositions;
+            vector<Quaternion>::type derivedOrientations;
+            vector<Vector3>::type derivedScales;
+            /// All nodes reached at this depth, whether their transform changed or not
+            vector<Node*>::type visited;
+
+            void clear(void);
+        };
+        typedef vector<UpdateLevel>::type UpdateLevelList;
+
+        /// Parent slot used when the parent's derived transform is already up to date
+        static const uint32 NO_PARENT_SLOT = 0xFFFFFFFF;
+
         /** Inner class for displaying debug renderable for Node. */
         class DebugRenderable : public Renderable, public NodeAlloc
         {
@@ -201,6 +228,15 @@ namespace Ogre {
         */
         virtual void updateFromParentImpl(void) const;
 
+        /** Class-specific work to do once the derived transform has changed.
+        @remarks
+            Called after the derived transform was computed by _updateLevelTransforms
+            rather than by updateFromParentImpl. Subclasses which do more than
+            combine transforms in updateFromParentImpl (e.g. notifying attached
+            objects) should do that work here too.
+        */
+        virtual void derivedTransformUpdatedImpl(void) const {}
+
 
         /** Internal method for creating a new child node - must be overridden per subclass. */
         virtual Node* createChildImpl(void) = 0;
@@ -573,6 +609,42 @@ namespace Ogre {
         */
         virtual void _update(bool updateChildren, bool parentHasChanged);
 
+        /** Internal method to gather the pending updates of this node and its children.
+        @remarks
+            Follows exactly the same dirty flags as _update(true, parentHasChanged), but
+            instead of updating the nodes it appends them to levels, starting at depth.
+            The derived transforms are then computed with _updateLevelTransforms and
+            the update finished with _notifyDerivedUpdated.
+        @note
+            Overrides of _update are not invoked when updating this way.
+        @param levels
+            The levels to append to; grown as needed.
+        @param depth
+            Depth of this node in the update.
+        @param parentSlot
+            Slot of the parent in levels[depth - 1], or NO_PARENT_SLOT.
+        @param parentHasChanged
+            As for _update.
+        */
+        void _collectUpdates(UpdateLevelList& levels, size_t depth, uint32 parentSlot,
+            bool parentHasChanged);
+
+        /** Internal method to compute the derived transforms of a range of a level.
+        @remarks
+            Only reads the level above and writes the given range, so disjoint ranges
+            of the same level may be processed on different threads. The nodes
+            themselves are updated too, but no listener or subclass is notified.
+        */
+        static void _updateLevelTransforms(UpdateLevelList& levels, size_t depth,
+            size_t begin, size_t end);
+
+        /** Internal method to complete an update done by _updateLevelTransforms.
+        @remarks
+            Performs the class-specific work and raises Listener::nodeUpdated, as
+            _updateFromParent does. Must be called from the thread owning the scene.
+        */
+        void _notifyDerivedUpdated(void) const;
+
         /** Sets a listener for this Node.
         @remarks
             Note for size and performance reasons only one listener per node is
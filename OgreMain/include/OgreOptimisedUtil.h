@@ -59,6 +59,9 @@ namespace Ogre {
         /// Detect best implementation based on run-time environment
         static OptimisedUtil* _detectImplementation(void);
 
+        /// See setParallelVertexThreshold
+        static size_t msParallelVertexThreshold;
+
     public:
         // Default constructor
         OptimisedUtil(void) {}
@@ -72,6 +75,24 @@ namespace Ogre {
         */
         static OptimisedUtil* getImplementation(void) { return msImplementation; }
 
+        /** Sets the number of vertices from which software vertex animation is
+            split across threads.
+        @remarks
+            Calls of softwareVertexSkinning and softwareVertexMorph with at least
+            this many vertices then split the vertices into chunks, run on the
+            worker threads of Root's TaskScheduler with the calling thread taking
+            part. This pays off for a few meshes with many vertices, see
+            SoftwareSkinningBatch for many smaller ones.
+        @param minVertices The smallest number of vertices to split, or 0 to
+            always animate on the calling thread, the default.
+        */
+        static void setParallelVertexThreshold(size_t minVertices);
+
+        /** Gets the number of vertices from which software vertex animation is
+            split across threads, 0 if it never is.
+        */
+        static size_t getParallelVertexThreshold(void);
+
         /** Performs software vertex skinning.
         @param srcPosPtr Pointer to source position buffer.
         @param destPosPtr Pointer to destination position buffer.
@@ -203,6 +224,31 @@ namespace Ogre {
             const float* srcPositions,
             float* destPositions,
             size_t numVertices) = 0;
+
+        /** Tests axis aligned boxes against a convex set of planes, e.g. a frustum.
+        @remarks
+            A box is culled when it is entirely on the negative side of one of the
+            planes, which is the test done by Frustum::isVisible, and gives the same
+            results for the same planes. Infinite boxes can be passed with infinite
+            half sizes and any centre, they are never culled.
+        @param planes An array of planes packed as (normal.x, normal.y, normal.z, d).
+            No alignment requirement.
+        @param numPlanes Number of planes.
+        @param centres An array of box centres, the w component is ignored. No
+            alignment requirement.
+        @param halfSizes An array of box half sizes, the w component is ignored. No
+            alignment requirement.
+        @param visibilities An array of flags, one per box. Boxes whose flag is zero
+            are not tested, the flag of the boxes which are culled is set to zero.
+        @param numBoxes Number of boxes to test.
+        */
+        virtual void cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes) = 0;
     };
 
     /** Returns raw offseted of the given pointer.
@@ -110,6 +110,30 @@ namespace Ogre {
         */
         virtual void _affectParticles(ParticleSystem* pSystem, Real timeElapsed) = 0;
 
+        /** Returns whether the affector implements _affectParticleArrays.
+        @remarks
+            Affectors which do not are still applied to systems using contiguous
+            storage, but the particles have to be copied to Particle instances
+            and back for _affectParticles each time.
+        */
+        virtual bool _supportsParticleArrays(void) const { return false; }
+
+        /** Method called instead of _affectParticles for systems which keep their
+            particles in contiguous storage, if _supportsParticleArrays.
+        @remarks
+            The affector may change any of the attributes of the active particles,
+            but must not add or remove any.
+        @param
+            particles The particles of the system being affected.
+        @param
+            timeElapsed The number of seconds which have elapsed since the last call.
+        */
+        virtual void _affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+        {
+            (void)particles;
+            (void)timeElapsed;
+        }
+
         /** Returns the name of the type of affector. 
         @remarks
             This property is useful for determining the type of affector procedurally so another
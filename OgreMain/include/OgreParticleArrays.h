@@ -0,0 +1,134 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ParticleArrays_H__
+#define __ParticleArrays_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre {
+
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup Effects
+    *  @{
+    */
+    /** Contiguous storage of the particles of a ParticleSystem, one array per attribute.
+    @remarks
+        This is used instead of Particle instances when contiguous storage is
+        enabled on the system, see ParticleSystem::setContiguousStorage. The
+        first mCount entries of each array are the active particles, in no
+        particular order; removing a particle moves the last one into its place,
+        so the arrays never have gaps. The arrays are SIMD aligned and their
+        capacity is a multiple of 4, so affectors can process them 4 particles
+        at a time as long as they leave the values past mCount alone.
+    */
+    class _OgreExport ParticleArrays : public FXAlloc
+    {
+    public:
+        // Note the intentional public access, as for Particle
+        /// Number of active particles
+        size_t mCount;
+        /// Position, in world or local space as for Particle::mPosition
+        Real* mPositionX;
+        Real* mPositionY;
+        Real* mPositionZ;
+        /// Direction (and speed)
+        Real* mDirectionX;
+        Real* mDirectionY;
+        Real* mDirectionZ;
+        /// Colour components
+        Real* mColourR;
+        Real* mColourG;
+        Real* mColourB;
+        Real* mColourA;
+        /// Seconds left of the life of each particle
+        Real* mTimeToLive;
+        /// Total seconds of the life of each particle
+        Real* mTotalTimeToLive;
+        /// Rotation in radians
+        Real* mRotation;
+        /// Speed of rotation in radians/sec
+        Real* mRotationSpeed;
+        /// Own dimensions, used where mOwnDimensions is set
+        Real* mWidth;
+        Real* mHeight;
+        /// Non zero for particles with dimensions of their own
+        uint8* mOwnDimensions;
+
+        ParticleArrays();
+        ~ParticleArrays();
+
+        /** Returns the number of particles there is room for. */
+        size_t getCapacity(void) const { return mCapacity; }
+        /** Makes room for at least the given number of particles, keeping the active ones. */
+        void reserve(size_t capacity);
+
+        /** Adds a copy of a particle; there must be room for it. */
+        void append(const Particle& particle);
+        /** Removes a particle by moving the last one into its place. */
+        void remove(size_t index);
+        /** Removes all the particles. */
+        void clear(void) { mCount = 0; }
+
+        /** Copies a particle into the given Particle instance. */
+        void getParticle(size_t index, Particle& particle) const;
+        /** Copies the given Particle instance over a particle. */
+        void setParticle(size_t index, const Particle& particle);
+
+        /** Reorders the particles.
+        @param order The index of the particle to put at each position, a
+            permutation of the mCount active particles
+        */
+        void reorder(const uint32* order);
+
+    protected:
+        /// Number of Real arrays
+        static const size_t NUM_REAL_ARRAYS = 16;
+        /// The Real arrays, in allocation order
+        static Real* ParticleArrays::* const msRealArrays[NUM_REAL_ARRAYS];
+
+        size_t mCapacity;
+        /// Single allocation holding all the arrays
+        void* mData;
+        /// Scratch space for reorder
+        Real* mScratch;
+
+    private:
+        ParticleArrays(const ParticleArrays&);
+        ParticleArrays& operator=(const ParticleArrays&);
+    };
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
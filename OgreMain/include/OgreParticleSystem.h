@@ -64,6 +64,7 @@ namespace Ogre {
     */
     class _OgreExport ParticleSystem : public StringInterface, public MovableObject
     {
+        friend class ParticleSystemManager;
     public:
 
         /** Command object for quota (see ParamCommand).*/
@@ -144,6 +145,13 @@ namespace Ogre {
             void doSet(void* target, const String& val);
         };
 
+        class CmdContiguousStorage : public ParamCommand
+        {
+        public:
+            String doGet(const void* target) const;
+            void doSet(void* target, const String& val);
+        };
+
         /// Default constructor required for STL creation in manager
         ParticleSystem();
         /** Creates a particle system with no emitters or affectors.
@@ -341,7 +349,8 @@ namespace Ogre {
 
         /** Updates the particles in the system based on time elapsed.
         @remarks
-            This is called automatically every frame by OGRE.
+            This is called automatically every frame by OGRE, see also
+            ParticleSystemManager::setParallelUpdate.
         @param
             timeElapsed The amount of time, in seconds, since the last frame.
         */
@@ -645,6 +654,31 @@ namespace Ogre {
         */
         bool getEmitting() const;
 
+        /** Sets whether the particles are kept in contiguous arrays rather than Particle instances.
+        @remarks
+            With contiguous storage each attribute of the particles is kept in an
+            array of its own (see ParticleArrays), expired particles are replaced
+            by the last one rather than unlinked from a list, and expiry, motion
+            and the bounds are updated in as few passes over the arrays as the
+            affectors allow. Affectors implementing _affectParticleArrays work on
+            whole arrays at once; the others still work, at the cost of copying
+            the particles to Particle instances and back.
+        @par
+            This only takes effect if the renderer supports it (the billboard
+            renderer does) and no emitter emits other emitters; otherwise the
+            particles stay in Particle instances. Methods returning Particle
+            instances, such as getParticle, _getIterator and createParticle, also
+            still work, and the changes made through them are copied back in the
+            next update.
+        */
+        void setContiguousStorage(bool contiguous);
+        /** Gets whether the particles are to be kept in contiguous arrays. */
+        bool getContiguousStorage(void) const { return mContiguousStorage; }
+        /** Returns whether the particles are currently kept in contiguous arrays.
+        @see ParticleSystem::setContiguousStorage
+        */
+        bool isUsingContiguousStorage(void) const { return mUsingParticleArrays; }
+
         /// Override to return specific type flag
         uint32 getTypeFlags(void) const;
     protected:
@@ -661,6 +695,7 @@ namespace Ogre {
         static CmdLocalSpace msLocalSpaceCmd;
         static CmdIterationInterval msIterationIntervalCmd;
         static CmdNonvisibleTimeout msNonvisibleTimeoutCmd;
+        static CmdContiguousStorage msContiguousStorageCmd;
 
 
         AxisAlignedBox mAABB;
@@ -703,6 +738,19 @@ namespace Ogre {
         bool mEmittedEmitterPoolInitialised;
         /// Used to control if the particle system should emit particles or not.
         bool mIsEmitting;
+        /// Keep the particles in contiguous arrays if possible?
+        bool mContiguousStorage;
+        /// Are the particles kept in mParticleArrays?
+        bool mUsingParticleArrays;
+        /** Have the particles in mParticleArrays been copied to mActiveParticles
+            for methods working on Particle instances, and not copied back yet?
+        */
+        bool mParticleArraysInList;
+        /// Padded bounds of the particles in mParticleArrays, found while moving them
+        Vector3 mParticleArraysMin;
+        Vector3 mParticleArraysMax;
+        /// Have mParticleArraysMin and mParticleArraysMax been found this update?
+        bool mParticleArraysBoundsValid;
 
         typedef list<Particle*>::type ActiveParticleList;
         typedef list<Particle*>::type FreeParticleList;
@@ -730,6 +778,28 @@ namespace Ogre {
 
         static RadixSort<ActiveParticleList, Particle*, float> mRadixSorter;
 
+        typedef vector<uint32>::type ParticleIndexList;
+
+        /** Sort key of each particle functor, for contiguous storage */
+        struct SortByKeyFunctor
+        {
+            /// Key of each particle
+            const float* keys;
+
+            SortByKeyFunctor(const float* k) : keys(k) {}
+            float operator()(uint32 i) const { return keys[i]; }
+        };
+
+        static RadixSort<ParticleIndexList, uint32, float> mIndexRadixSorter;
+
+        /** Contiguous storage of the particles, if used.
+            @see ParticleSystem::setContiguousStorage
+        */
+        ParticleArrays* mParticleArrays;
+        /// Particle order and sort keys, for sorting contiguous storage
+        ParticleIndexList mSortOrder;
+        vector<float>::type mSortKeys;
+
         /** Active particle list.
             @remarks
                 This is a linked list of pointers to particles in the particle pool.
@@ -824,6 +894,32 @@ namespace Ogre {
         /** Spawn new particles based on free quota and emitter requirements. */
         void _triggerEmitters(Real timeElapsed);
 
+        /** First part of _update, checking visibility and preparing the renderer
+            and particle storage.
+        @param timeElapsed The time since the last update, scaled by the speed
+            factor on return
+        @return Whether the system is to be updated, with _endUpdate
+        */
+        bool _beginUpdate(Real& timeElapsed);
+
+        /** Returns whether _updateParticles may run concurrently with the
+            updates of other systems, after _beginUpdate.
+        @remarks
+            That is the case when the particles are in contiguous storage, all
+            the affectors work on it and there is no iteration interval.
+        */
+        bool _canUpdateParticlesConcurrently(void) const;
+
+        /** Expires, affects and moves the existing particles. */
+        void _updateParticles(Real timeElapsed);
+
+        /** Last part of _update, updating the particles, emitting new ones and
+            updating the bounds.
+        @param particlesUpdated Whether _updateParticles was already called
+            with timeElapsed, rather than iteration intervals
+        */
+        void _endUpdate(Real timeElapsed, bool particlesUpdated);
+
         /** Helper function that actually performs the emission of particles
         */
         void _executeTriggerEmitters(ParticleEmitter* emitter, unsigned requested, Real timeElapsed);
@@ -834,9 +930,39 @@ namespace Ogre {
         /** Applies the effects of affectors. */
         void _triggerAffectors(Real timeElapsed);
 
+        /** Expires, affects and moves the particles in contiguous storage.
+        @remarks
+            Does the work of _expire, _triggerAffectors and _applyMotion with
+            as few passes over the arrays as the affectors allow, and finds the
+            bounds of the particles as it goes if updateBounds is set.
+        */
+        void _updateParticleArrays(Real timeElapsed, bool updateBounds);
+
+        /** Moves the particles to or from contiguous storage, as required. */
+        void _updateStorage(void);
+
+        /** Copies the particles in contiguous storage to Particle instances in
+            mActiveParticles, if not done already.
+        */
+        void _copyParticleArraysToList(void);
+
+        /** Copies the Particle instances in mActiveParticles back to contiguous
+            storage, if they were copied there.
+        */
+        void _copyListToParticleArrays(void);
+
+        /** Extends the bounds found for contiguous storage with those of a particle. */
+        void _addToParticleArraysBounds(const Particle& p);
+
         /** Sort the particles in the system **/
         void _sortParticles(Camera* cam);
 
+        /** Sorts the particles in contiguous storage by direction or distance.
+        @param v The direction to sort in, or the position to sort by distance from
+        @param byDistance Sort by distance rather than direction?
+        */
+        void _sortParticleArrays(const Vector3& v, bool byDistance);
+
         /** Resize the internal pool of particles. */
         void increasePool(size_t size);
 
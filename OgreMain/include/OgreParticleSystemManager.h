@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 #include "OgreSingleton.h"
 #include "OgreScriptLoader.h"
+#include "OgreFrameListener.h"
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre {
@@ -71,7 +72,7 @@ namespace Ogre {
         then be created easily through the createParticleSystem method.
     */
     class _OgreExport ParticleSystemManager: 
-        public Singleton<ParticleSystemManager>, public ScriptLoader, public FXAlloc
+        public Singleton<ParticleSystemManager>, public ScriptLoader, public FrameListener, public FXAlloc
     {
         friend class ParticleSystemFactory;
     public:
@@ -99,6 +100,26 @@ namespace Ogre {
         // Factory instance
         ParticleSystemFactory* mFactory;
 
+        /// Systems attached to a node, which are updated every frame, in attachment order
+        vector<ParticleSystem*>::type mAttachedSystems;
+        /// Are the attached systems updated together, see setParallelUpdate
+        bool mParallelUpdate;
+
+        /// A system being updated by _updateSystems
+        struct SystemUpdate
+        {
+            ParticleSystem* system;
+            /// Time since the last update, scaled by the speed of the system
+            Real timeElapsed;
+            /// Are the particles updated concurrently with those of other systems
+            bool concurrent;
+        };
+        typedef vector<SystemUpdate>::type SystemUpdateList;
+        /// Systems updated this frame, kept to save allocating the list each frame
+        SystemUpdateList mSystemUpdates;
+        /// Functor updating the particles of a range of mSystemUpdates
+        struct UpdateParticles;
+
         /** Internal script parsing method. */
         void parseNewEmitter(const String& type, DataStreamPtr& chunk, ParticleSystem* sys);
         /** Internal script parsing method. */
@@ -343,6 +364,40 @@ namespace Ogre {
 
         /** Get an instance of ParticleSystemFactory (internal use). */
         ParticleSystemFactory* _getFactory(void) { return mFactory; }
+
+        /** Sets whether the particle systems are updated together, using the
+            worker threads of the TaskScheduler.
+        @remarks
+            By default each system is updated on its own by a frame time
+            controller, while rendering the scene. With this set, all the
+            systems attached to a node are updated by this manager in the frame
+            started event instead, see _updateSystems. The results are the same
+            from run to run regardless of the number of threads, as only work
+            which uses no random numbers or shared state is done concurrently.
+        */
+        void setParallelUpdate(bool enabled);
+        /** Gets whether the particle systems are updated together. */
+        bool getParallelUpdate(void) const { return mParallelUpdate; }
+
+        /** Updates all the particle systems attached to a node.
+        @remarks
+            The systems are prepared and emit their new particles one at a time
+            in the order they were attached, while the existing particles of
+            those for which ParticleSystem::_canUpdateParticlesConcurrently
+            holds are updated concurrently in between. This is called in the
+            frame started event if parallel update is enabled.
+        @param timeElapsed The time in seconds since the last update.
+        */
+        void _updateSystems(Real timeElapsed);
+
+        /** Internal method called by ParticleSystem when attached to a node. */
+        void _notifySystemAttached(ParticleSystem* sys);
+        /** Internal method called by ParticleSystem when detached from a node
+            or destroyed while attached. */
+        void _notifySystemDetached(ParticleSystem* sys);
+
+        /// @copydoc FrameListener::frameStarted
+        bool frameStarted(const FrameEvent& evt);
         
         /// @copydoc Singleton::getSingleton()
         static ParticleSystemManager& getSingleton(void);
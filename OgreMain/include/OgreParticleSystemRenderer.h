@@ -65,6 +65,21 @@ namespace Ogre {
         virtual void _updateRenderQueue(RenderQueue* queue, 
             list<Particle*>::type& currentParticles, bool cullIndividually) = 0;
 
+        /** Returns whether the renderer can draw particles from ParticleArrays.
+        @remarks
+            Only systems with such a renderer use contiguous storage, see
+            ParticleSystem::setContiguousStorage. Renderers drawing from
+            ParticleArrays are not sent the per particle notifications, and
+            their visual data is not attached to any particle.
+        */
+        virtual bool _supportsParticleArrays(void) const { return false; }
+
+        /** Delegated to by ParticleSystem::_updateRenderQueue when the particles
+            are in contiguous storage, which requires _supportsParticleArrays.
+        */
+        virtual void _updateRenderQueueFromArrays(RenderQueue* queue,
+            const ParticleArrays& particles, bool cullIndividually) {}
+
         /** Sets the material this renderer must use; called by ParticleSystem. */
         virtual void _setMaterial(MaterialPtr& mat) = 0;
         /** Delegated to by ParticleSystem::_notifyCurrentCamera */
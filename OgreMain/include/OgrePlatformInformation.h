@@ -116,10 +116,22 @@ namespace Ogre {
 #   define __OGRE_HAVE_MSA  1
 #endif
 
+/* Define whether or not Ogre compiled with AVX2 supports. The AVX2 code is
+   compiled for those functions only and picked at run-time, see OptimisedUtil.
+*/
+#if __OGRE_HAVE_SSE && (OGRE_COMPILER_MIN_VERSION(OGRE_COMPILER_MSVC, 1700) || \
+    OGRE_COMPILER_MIN_VERSION(OGRE_COMPILER_GNUC, 490) || OGRE_COMPILER_MIN_VERSION(OGRE_COMPILER_CLANG, 380))
+#   define __OGRE_HAVE_AVX2  1
+#endif
+
 #ifndef __OGRE_HAVE_SSE
 #   define __OGRE_HAVE_SSE  0
 #endif
 
+#ifndef __OGRE_HAVE_AVX2
+#   define __OGRE_HAVE_AVX2  0
+#endif
+
 #ifndef __OGRE_HAVE_VFP
 #   define __OGRE_HAVE_VFP  0
 #endif
@@ -176,6 +188,9 @@ namespace Ogre {
             CPU_FEATURE_FPU             = 1 << 12,
             CPU_FEATURE_PRO             = 1 << 13,
             CPU_FEATURE_HTT             = 1 << 14,
+            CPU_FEATURE_AVX             = 1 << 18,
+            CPU_FEATURE_AVX2            = 1 << 19,
+            CPU_FEATURE_FMA             = 1 << 20,
 #elif OGRE_CPU == OGRE_CPU_ARM          
             CPU_FEATURE_VFP             = 1 << 15,
             CPU_FEATURE_NEON            = 1 << 16,
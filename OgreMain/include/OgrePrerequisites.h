@@ -152,6 +152,7 @@ namespace Ogre {
     class Camera;
     class Codec;
     class ColourValue;
+    class CompressedTransformKeyFrames;
     class ConfigDialog;
     template <typename T> class Controller;
     template <typename T> class ControllerFunction;
@@ -227,6 +228,7 @@ namespace Ogre {
     class Particle;
     class ParticleAffector;
     class ParticleAffectorFactory;
+    class ParticleArrays;
     class ParticleEmitter;
     class ParticleEmitterFactory;
     class ParticleSystem;
@@ -289,8 +291,10 @@ namespace Ogre {
     class SimpleRenderable;
     class SimpleSpline;
     class Skeleton;
+    class SkeletonAnimationBatch;
     class SkeletonInstance;
     class SkeletonManager;
+    class SoftwareSkinningBatch;
     class Sphere;
     class SphereSceneQuery;
     class StaticGeometry;
@@ -300,6 +304,9 @@ namespace Ogre {
     class SubEntity;
     class SubMesh;
     class TagPoint;
+    class Task;
+    class TaskGroup;
+    class TaskScheduler;
     class Technique;
     class TempBlendedBufferInfo;
     class ExternalTextureSource;
@@ -31,7 +31,6 @@ THE SOFTWARE.
 // Precompiler options
 #include "OgrePrerequisites.h"
 #include "OgrePass.h"
-#include "OgreRadixSort.h"
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre {
@@ -132,110 +131,45 @@ namespace Ogre {
         };
 
     protected:
-        /// Comparator to order pass groups
-        struct PassGroupLess
-        {
-            bool operator()(const Pass* a, const Pass* b) const
-            {
-                // Sort by passHash, which is pass, then texture unit changes
-                uint32 hasha = a->getHash();
-                uint32 hashb = b->getHash();
-                if (hasha == hashb)
-                {
-                    // Must differentTransparentQueueItemLessiate by pointer incase 2 passes end up with the same hash
-                    return a < b;
-                }
-                else
-                {
-                    return hasha < hashb;
-                }
-            }
-        };
-        /// Comparator to order objects by descending camera distance
-        struct DepthSortDescendingLess
+        /** A RenderablePass with the 64 bit key it is sorted by.
+        @remarks
+            Pass groups are keyed by the hash of the pass, depth sorted items by
+            the descending squared view depth in the upper 32 bits and the hash
+            of the pass below, so that both organisations sort the same way.
+        */
+        struct SortedRenderablePass
         {
-            const Camera* camera;
-
-            DepthSortDescendingLess(const Camera* cam)
-                : camera(cam)
-            {
-            }
-
-            bool operator()(const RenderablePass& a, const RenderablePass& b) const
-            {
-                if (a.renderable == b.renderable)
-                {
-                    // Same renderable, sort by pass hash
-                    return a.pass->getHash() < b.pass->getHash();
-                }
-                else
-                {
-                    // Different renderables, sort by depth
-                    Real adepth = a.renderable->getSquaredViewDepth(camera);
-                    Real bdepth = b.renderable->getSquaredViewDepth(camera);
-                    if (Math::RealEqual(adepth, bdepth))
-                    {
-                        // Must return deterministic result, doesn't matter what
-                        return a.pass < b.pass;
-                    }
-                    else
-                    {
-                        // Sort DESCENDING by depth (i.e. far objects first)
-                        return (adepth > bdepth);
-                    }
-                }
+            uint64 key;
+            RenderablePass rp;
 
-            }
+            SortedRenderablePass(Pass* pass, Renderable* rend) : key(0), rp(rend, pass) {}
         };
-
-        /** Vector of RenderablePass objects, this is built on the assumption that
+        /** Vector of SortedRenderablePass objects, this is built on the assumption that
          vectors only ever increase in size, so even if we do clear() the memory stays
          allocated, ie fast */
-        typedef vector<RenderablePass>::type RenderablePassList;
-        typedef vector<Renderable*>::type RenderableList;
-        /** Map of pass to renderable lists, this is a grouping by pass. */
-        typedef map<Pass*, RenderableList*, PassGroupLess>::type PassGroupRenderableMap;
-
-        /// Functor for accessing sort value 1 for radix sort (Pass)
-        struct RadixSortFunctorPass
-        {
-            uint32 operator()(const RenderablePass& p) const
-            {
-                return p.pass->getHash();
-            }
-        };
-
-        /// Radix sorter for accessing sort value 1 (Pass)
-        static RadixSort<RenderablePassList, RenderablePass, uint32> msRadixSorter1;
-
-        /// Functor for descending sort value 2 for radix sort (distance)
-        struct RadixSortFunctorDistance
-        {
-            const Camera* camera;
-
-            RadixSortFunctorDistance(const Camera* cam)
-                : camera(cam)
-            {
-            }
-
-            float operator()(const RenderablePass& p) const
-            {
-                // Sort DESCENDING by depth (ie far objects first), use negative distance
-                // here because radix sorter always dealing with accessing sort
-                return static_cast<float>(- p.renderable->getSquaredViewDepth(camera));
-            }
-        };
+        typedef vector<SortedRenderablePass>::type SortedRenderablePassList;
 
-        /// Radix sorter for sort value 2 (distance)
-        static RadixSort<RenderablePassList, RenderablePass, float> msRadixSorter2;
+        /// See setParallelSortThreshold
+        static size_t msParallelSortThreshold;
 
         /// Bitmask of the organisation modes requested
         uint8 mOrganisationMode;
 
-        /// Grouped 
-        PassGroupRenderableMap mGrouped;
+        /// Grouped by pass once sorted, in the order added before
+        mutable SortedRenderablePassList mGrouped;
+        /// Whether mGrouped has been added to since it was last sorted
+        mutable bool mGroupedDirty;
         /// Sorted descending (can iterate backwards to get ascending)
-        RenderablePassList mSortedDescending;
+        SortedRenderablePassList mSortedDescending;
+        /// Space for the radix sort to work in
+        mutable SortedRenderablePassList mSortScratch;
+        /// Digit counts of the radix sort, for each chunk sorted
+        mutable vector<size_t>::type mSortCounts;
+
+        /// Sorts mGrouped by pass
+        void sortGrouped(void) const;
+        /// Sorts items in ascending order of their keys, keeping the order of equal keys
+        void sortByKey(SortedRenderablePassList& items) const;
 
         /// Internal visitor implementation
         void acceptVisitorGrouped(QueuedRenderableVisitor* visitor) const;
@@ -297,6 +231,21 @@ namespace Ogre {
         /** Merge renderable collection. 
         */
         void merge( const QueuedRenderableCollection& rhs );
+
+        /** Sets the number of renderables from which collections are radix
+            sorted on the worker threads of the TaskScheduler.
+        @remarks
+            The keys are always worked out on the calling thread, since not
+            every Renderable can tell its view depth from several threads.
+        @param minRenderables The smallest number of renderables to split, or 0
+            to always sort on the calling thread, the default.
+        */
+        static void setParallelSortThreshold(size_t minRenderables);
+
+        /** Gets the number of renderables from which collections are sorted
+            on worker threads, 0 if they never are.
+        */
+        static size_t getParallelSortThreshold(void);
     };
 
     /** Collection of renderables by priority.
@@ -0,0 +1,243 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __RenderStateCache_H__
+#define __RenderStateCache_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreCommon.h"
+#include "OgreBlendMode.h"
+#include "OgreColourValue.h"
+#include "OgreGpuProgram.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre {
+
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup RenderSystem
+    *  @{
+    */
+    /** Shadow copy of the render states a SceneManager sets for each pass.
+    @remarks
+        Passes which follow each other often share most of their states, yet
+        the render system used to be told about every one of them on each pass
+        change. This class remembers the last value passed on for each state
+        and drops calls which would set it again, counting both so the
+        filtering can be measured.
+    @par
+        The cache cannot see states changed by calling the RenderSystem
+        directly, so it has to be invalidated whenever that may have happened.
+        The SceneManager does so when it sets a viewport, renders manually and
+        after calling its render queue and render object listeners.
+    @par
+        Without a RenderSystem the states and counts are still tracked, which
+        allows measuring the filtering of a sequence of passes headless.
+    */
+    class _OgreExport RenderStateCache : public RenderSysAlloc
+    {
+    public:
+        /// Counts of the state changes requested from the cache
+        struct Statistics
+        {
+            /// State changes passed on to the render system
+            size_t appliedChanges;
+            /// State changes dropped because the state was already set
+            size_t redundantChanges;
+
+            Statistics() : appliedChanges(0), redundantChanges(0) {}
+        };
+
+        RenderStateCache(RenderSystem* rs = 0);
+
+        /** Sets the render system states are passed on to, which invalidates the cache. */
+        void setRenderSystem(RenderSystem* rs);
+        /** Returns the render system states are passed on to, may be null. */
+        RenderSystem* getRenderSystem(void) const { return mRenderSystem; }
+
+        /** Sets whether redundant state changes are dropped.
+        @remarks
+            When disabled every state change is passed on, as without the cache.
+            Enabled by default.
+        */
+        void setEnabled(bool enabled);
+        /** Returns whether redundant state changes are dropped. */
+        bool getEnabled(void) const { return mEnabled; }
+
+        /** Forgets all states, so that each is passed on the next time it is set.
+        @remarks
+            Call this after changing states on the render system directly.
+        */
+        void invalidate(void);
+        /** Forgets the depth bias, for when the render system derives it itself.
+        @see RenderSystem::setDeriveDepthBias
+        */
+        void invalidateDepthBias(void);
+
+        /** Returns the counts of state changes since resetStatistics. */
+        const Statistics& getStatistics(void) const { return mStatistics; }
+        /** Resets the counts of state changes. */
+        void resetStatistics(void);
+
+        /// @see RenderSystem::bindGpuProgram
+        void bindGpuProgram(GpuProgram* prg);
+        /// @see RenderSystem::unbindGpuProgram, nothing is done if no program is bound
+        void unbindGpuProgram(GpuProgramType gptype);
+        /// @see RenderSystem::_setSurfaceParams
+        void setSurfaceParams(const ColourValue& ambient, const ColourValue& diffuse,
+            const ColourValue& specular, const ColourValue& emissive, Real shininess,
+            TrackVertexColourType tracking);
+        /// @see RenderSystem::setLightingEnabled
+        void setLightingEnabled(bool enabled);
+        /// @see RenderSystem::_setFog
+        void setFog(FogMode mode, const ColourValue& colour, Real expDensity,
+            Real linearStart, Real linearEnd);
+        /// @see RenderSystem::_setSceneBlending
+        void setSceneBlending(SceneBlendFactor sourceFactor, SceneBlendFactor destFactor,
+            SceneBlendOperation op);
+        /// @see RenderSystem::_setSeparateSceneBlending
+        void setSeparateSceneBlending(SceneBlendFactor sourceFactor, SceneBlendFactor destFactor,
+            SceneBlendFactor sourceFactorAlpha, SceneBlendFactor destFactorAlpha,
+            SceneBlendOperation op, SceneBlendOperation alphaOp);
+        /// @see RenderSystem::_setPointParameters
+        void setPointParameters(Real size, bool attenuationEnabled, Real constant,
+            Real linear, Real quadratic, Real minSize, Real maxSize);
+        /// @see RenderSystem::_setPointSpritesEnabled
+        void setPointSpritesEnabled(bool enabled);
+        /** Sets up a texture unit.
+        @remarks
+            Always passed on, since the contents of a TextureUnitState change without
+            notice (animated textures, shadow textures...).
+        @see RenderSystem::_setTextureUnitSettings
+        */
+        void setTextureUnitSettings(size_t texUnit, TextureUnitState& tl);
+        /** Disables texture units from the given one upwards.
+        @remarks
+            Always passed on, the render system already skips units it disabled before.
+        @see RenderSystem::_disableTextureUnitsFrom
+        */
+        void disableTextureUnitsFrom(size_t texUnit);
+        /// @see RenderSystem::_setDepthBufferParams
+        void setDepthBufferParams(bool depthTest = true, bool depthWrite = true,
+            CompareFunction depthFunction = CMPF_LESS_EQUAL);
+        /// @see RenderSystem::_setDepthBufferCheckEnabled
+        void setDepthBufferCheckEnabled(bool enabled);
+        /// @see RenderSystem::_setDepthBufferWriteEnabled
+        void setDepthBufferWriteEnabled(bool enabled);
+        /// @see RenderSystem::_setDepthBufferFunction
+        void setDepthBufferFunction(CompareFunction func);
+        /// @see RenderSystem::_setDepthBias
+        void setDepthBias(float constantBias, float slopeScaleBias);
+        /// @see RenderSystem::_setAlphaRejectSettings
+        void setAlphaRejectSettings(CompareFunction func, unsigned char value, bool alphaToCoverage);
+        /// @see RenderSystem::_setColourBufferWriteEnabled
+        void setColourBufferWriteEnabled(bool red, bool green, bool blue, bool alpha);
+        /// @see RenderSystem::_setCullingMode
+        void setCullingMode(CullingMode mode);
+        /// @see RenderSystem::setShadingType
+        void setShadingType(ShadeOptions so);
+        /// @see RenderSystem::_setPolygonMode
+        void setPolygonMode(PolygonMode level);
+
+    protected:
+        /// Bits of mValid, one per cached state
+        enum State
+        {
+            STATE_PROGRAMS = 0,
+            STATE_SURFACE = STATE_PROGRAMS + GPT_COMPUTE_PROGRAM + 1,
+            STATE_LIGHTING,
+            STATE_FOG,
+            STATE_BLENDING,
+            STATE_POINT_PARAMS,
+            STATE_POINT_SPRITES,
+            STATE_DEPTH_CHECK,
+            STATE_DEPTH_WRITE,
+            STATE_DEPTH_FUNCTION,
+            STATE_DEPTH_BIAS,
+            STATE_ALPHA_REJECT,
+            STATE_COLOUR_WRITE,
+            STATE_CULLING,
+            STATE_SHADING,
+            STATE_POLYGON_MODE
+        };
+
+        RenderSystem* mRenderSystem;
+        bool mEnabled;
+        /// Which states hold the value last passed on
+        uint32 mValid;
+        Statistics mStatistics;
+
+        GpuProgram* mPrograms[GPT_COMPUTE_PROGRAM + 1];
+        ColourValue mAmbient, mDiffuse, mSpecular, mEmissive;
+        Real mShininess;
+        TrackVertexColourType mTracking;
+        bool mLightingEnabled;
+        FogMode mFogMode;
+        ColourValue mFogColour;
+        Real mFogDensity, mFogStart, mFogEnd;
+        SceneBlendFactor mSourceBlend, mDestBlend, mSourceBlendAlpha, mDestBlendAlpha;
+        SceneBlendOperation mBlendOperation, mBlendOperationAlpha;
+        Real mPointParams[6];
+        bool mPointAttenuation;
+        bool mPointSprites;
+        bool mDepthCheck, mDepthWrite;
+        CompareFunction mDepthFunction;
+        float mDepthBiasConstant, mDepthBiasSlopeScale;
+        CompareFunction mAlphaRejectFunction;
+        unsigned char mAlphaRejectValue;
+        bool mAlphaToCoverage;
+        bool mColourWrite[4];
+        CullingMode mCullingMode;
+        ShadeOptions mShading;
+        PolygonMode mPolygonMode;
+
+        /** Returns whether a state needs passing on, counting the change.
+        @param state The State being set
+        @param same Whether the cached value equals the one being set
+        */
+        bool needsChange(State state, bool same)
+        {
+            uint32 bit = 1u << state;
+            if (mEnabled && (mValid & bit) && same)
+            {
+                ++mStatistics.redundantChanges;
+                return false;
+            }
+            mValid |= bit;
+            ++mStatistics.appliedChanges;
+            return true;
+        }
+    };
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
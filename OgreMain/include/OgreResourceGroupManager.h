@@ -308,8 +308,13 @@ namespace Ogre {
 
         ResourceLoadingListener *mLoadingListener;
 
+        /// Whether resources are prepared on the worker threads, see setParallelPrepare
+        bool mParallelPrepare;
+        /// Whether scripts are parsed on the worker threads, see setParallelScriptParsing
+        bool mParallelScriptParsing;
+
         /// Resource index entry, resourcename->location 
-        typedef map<String, Archive*>::type ResourceLocationIndex;
+        typedef OGRE_HashMap<String, Archive*> ResourceLocationIndex;
 
         /// List of resources which can be loaded / unloaded
         typedef list<ResourcePtr>::type LoadUnloadResourceList;
@@ -354,15 +359,29 @@ namespace Ogre {
             // in global pool flag - if true the resource will be loaded even a different   group was requested in the load method as a parameter.
             bool inGlobalPool;
 
-            void addToIndex(const String& filename, Archive* arch);
-            void removeFromIndex(const String& filename, Archive* arch);
-            void removeFromIndex(Archive* arch);
-
         };
         /// Map from resource group names to groups
         typedef map<String, ResourceGroup*>::type ResourceGroupMap;
         ResourceGroupMap mResourceGroupMap;
 
+        typedef vector<ResourceGroup*>::type ResourceGroupList;
+        /// Resource index entry, resourcename->groups indexing it
+        typedef OGRE_HashMap<String, ResourceGroupList> ResourceGroupIndex;
+        /** Groups indexing each resource, so the group containing a resource
+            is found without searching every group (case sensitive archives)
+        */
+        ResourceGroupIndex mGroupIndexCaseSensitive;
+#if !OGRE_RESOURCEMANAGER_STRICT
+        /// Groups indexing each resource (case insensitive archives)
+        ResourceGroupIndex mGroupIndexCaseInsensitive;
+#endif
+        /// Mutex for the group indexes, which are updated with only the group locked
+        OGRE_MUTEX(mGroupIndexMutex);
+
+        /// Prebuilt file lists of resource locations, see loadResourceLocationIndex
+        typedef OGRE_HashMap<String, StringVectorPtr> LocationFileListMap;
+        LocationFileListMap mPrebuiltLocationIndex;
+
         /// Group name for world resources
         String mWorldGroupName;
 
@@ -372,6 +391,8 @@ namespace Ogre {
             Called as part of initialiseResourceGroup
         */
         void parseResourceGroupScripts(ResourceGroup* grp) const;
+        /// Opens a script found by parseResourceGroupScripts, null if it can't be opened
+        DataStreamPtr openScript(const FileInfo& fileInfo, ResourceGroup* grp) const;
         /** Create all the pre-declared resources.
         @remarks
             Called as part of initialiseResourceGroup
@@ -381,6 +402,20 @@ namespace Ogre {
         void addCreatedResource(ResourcePtr& res, ResourceGroup& group) const;
         /** Get resource group */
         ResourceGroup* getResourceGroup(const String& name) const;
+        /** Adds a file of a location to the index of a group.
+        @note Assumes the group mutex has already been obtained.
+        */
+        void addToIndex(ResourceGroup* grp, const String& filename, Archive* arch);
+        /** Removes a file of a location from the index of a group.
+        @note Assumes the group mutex has already been obtained.
+        */
+        void removeFromIndex(ResourceGroup* grp, const String& filename, Archive* arch);
+        /** Removes all the files of a location from the index of a group.
+        @note Assumes the group mutex has already been obtained.
+        */
+        void removeFromIndex(ResourceGroup* grp, Archive* arch);
+        /// Gets the key of a resource location in the prebuilt index
+        static String getLocationIndexKey(const String& name, const String& locType, bool recursive);
         /** Drops contents of a group, leave group there, notify ResourceManagers. */
         void dropGroupContents(ResourceGroup* grp);
         /** Delete a group for shutdown - don't notify ResourceManagers. */
@@ -388,6 +423,19 @@ namespace Ogre {
         /// Internal find method for auto groups
         std::pair<Archive*, ResourceGroup*>
         resourceExistsInAnyGroupImpl(const String& filename) const;
+        /** Prepares the resources of a group on the worker threads.
+        @remarks
+            Called by prepareResourceGroup and loadResourceGroup in parallel mode.
+        @param fireEvents Whether to call resourcePrepareStarted / Ended on the
+            listeners for each resource
+        */
+        void prepareResourcesParallel(ResourceGroup* grp, bool fireEvents);
+        /** Prepares resources on the worker threads, a batch at a time.
+        @remarks
+            The group ownership of the resources only changes on the calling
+            thread, or under the lock when a resource is found in another group.
+        */
+        void prepareResourcesParallel(const vector<ResourcePtr>::type& resources, bool fireEvents);
         /// Internal event firing method
         void fireResourceGroupScriptingStarted(const String& groupName, size_t scriptCount) const;
         /// Internal event firing method
@@ -563,6 +611,55 @@ namespace Ogre {
         void loadResourceGroup(const String& name, bool loadMainResources = true, 
             bool loadWorldGeom = true);
 
+        /** Sets whether prepareResourceGroup and loadResourceGroup prepare the
+            resources of a group in parallel.
+        @remarks
+            Preparing is the disk I/O and decoding part of loading, such as
+            reading images or parsing meshes, which usually dominates loading a
+            group. When enabled, the resources of the group are prepared
+            concurrently on the worker threads of Root's TaskScheduler, a batch
+            at a time. loadResourceGroup then loads the prepared resources on the
+            calling thread in the usual loading order, so for example textures
+            are still loaded before the materials using them.
+        @par
+            The listeners are still called from the calling thread, for each
+            resource in order once its batch was prepared. A resource which
+            failed to prepare is prepared again on the calling thread, so the
+            exception is thrown from there as usual. The resources need to
+            support being prepared in the background, as with
+            ResourceBackgroundQueue.
+        @note Without worker threads, the resources are prepared in turn on the
+            calling thread.
+        */
+        void setParallelPrepare(bool enabled) { mParallelPrepare = enabled; }
+
+        /// Gets whether resource groups are prepared in parallel, see setParallelPrepare
+        bool getParallelPrepare(void) const { return mParallelPrepare; }
+
+        /** Sets whether the scripts of a group are parsed in parallel when it is
+            initialised.
+        @remarks
+            Tokenizing and parsing script files has no dependencies between files.
+            When enabled, the scripts of a group are opened on the calling thread a
+            batch at a time, then ScriptLoader::preParseScript is called for them
+            concurrently on the worker threads of Root's TaskScheduler. Each parsed
+            script is then finished by ScriptLoader::finishParseScript on the
+            calling thread in the usual order, so imports are resolved and objects
+            created in the same order as when parsing serially.
+        @par
+            The listeners are called from the calling thread: scriptParseStarted
+            for each script of a batch before it is parsed, and scriptParseEnded
+            for each once it was finished. A script which failed to pre-parse is
+            parsed again by ScriptLoader::parseScript, so errors are reported from
+            the calling thread as usual.
+        @note Without worker threads, the scripts are pre-parsed in turn on the
+            calling thread.
+        */
+        void setParallelScriptParsing(bool enabled) { mParallelScriptParsing = enabled; }
+
+        /// Gets whether scripts are parsed in parallel, see setParallelScriptParsing
+        bool getParallelScriptParsing(void) const { return mParallelScriptParsing; }
+
         /** Unloads a resource group.
         @remarks
             This method unloads all the resources that have been declared as
@@ -658,6 +755,28 @@ namespace Ogre {
         */
         void addResourceLocation(const String& name, const String& locType, 
             const String& resGroup = DEFAULT_RESOURCE_GROUP_NAME, bool recursive = false, bool readOnly = true);
+
+        /** Loads prebuilt lists of the files of resource locations.
+        @remarks
+            addResourceLocation indexes all the files of the location, which
+            means scanning whole directory trees for the FileSystem archive.
+            With many files this dominates startup, so for locations whose
+            content doesn't change, such as shipped data, the lists can be
+            saved once with saveResourceLocationIndex and loaded before adding
+            the locations. Locations which are not in the index are still
+            scanned.
+        @note The lists are trusted, files added to a location afterwards
+            won't be found until the index is saved again.
+        @param stream Stream of the data written by saveResourceLocationIndex
+        */
+        void loadResourceLocationIndex(const DataStreamPtr& stream);
+
+        /** Saves the lists of the files of all the resource locations of all
+            the groups, for loadResourceLocationIndex.
+        @param filename The file to write to
+        */
+        void saveResourceLocationIndex(const String& filename) const;
+
         /** Removes a resource location from the search path. */ 
         void removeResourceLocation(const String& name, 
             const String& resGroup = DEFAULT_RESOURCE_GROUP_NAME);
@@ -92,6 +92,7 @@ namespace Ogre
         SkeletonManager* mSkeletonManager;
         
         ArchiveFactory *mZipArchiveFactory;
+        ArchiveFactory *mMappedZipArchiveFactory;
         ArchiveFactory *mEmbeddedZipArchiveFactory;
         ArchiveFactory *mFileSystemArchiveFactory;
         
@@ -145,6 +146,7 @@ namespace Ogre
         bool mIsInitialised;
 
         WorkQueue* mWorkQueue;
+        TaskScheduler* mTaskScheduler;
 
         ///Tells whether blend indices information needs to be passed to the GPU
         bool mIsBlendIndicesGpuRedundant;
@@ -1034,6 +1036,11 @@ namespace Ogre
             at shutdown, so do not destroy it yourself.
         */
         void setWorkQueue(WorkQueue* queue);
+
+        /** Get the TaskScheduler running parallel tasks on the worker threads
+            of the WorkQueue, see TaskGroup and parallelFor.
+        */
+        TaskScheduler* getTaskScheduler() const { return mTaskScheduler; }
             
         /** Sets whether blend indices information needs to be passed to the GPU.
             When entities use software animation they remove blend information such as
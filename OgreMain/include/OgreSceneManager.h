@@ -46,7 +46,11 @@ Torus Knot Software Ltd.
 #include "OgreShadowTextureManager.h"
 #include "OgreInstanceManager.h"
 #include "OgreRenderSystem.h"
+#include "OgreRenderStateCache.h"
 #include "OgreLodListener.h"
+#include "OgreNode.h"
+#include "OgreDynamicAABBTree.h"
+#include "Threading/OgreThreads.h"
 #include "OgreHeaderPrefix.h"
 #include "OgreNameGenerator.h"
 
@@ -66,6 +70,7 @@ namespace Ogre {
     };
 
     // Forward declarations
+    class Barrier;
     class CompositorChain;
     class InstancedGeometry;
     class Rectangle2D;
@@ -530,6 +535,63 @@ namespace Ogre {
         ulong mLightsDirtyCounter;
         LightList mShadowTextureCurrentCasterLightList;
 
+        /// Cell of the light grid, see buildLightGrid
+        struct LightGridCell
+        {
+            int x, y, z;
+            /// First light of the cell in mLightGridIndices
+            uint32 start;
+            /// Number of lights, 0 for the free slots of the table
+            uint32 count;
+            /// Hash of the lights of the cell, see _getLightListSignature
+            uint64 signature;
+        };
+        /// Light of mLightsAffectingFrustum overlapping a cell, used to build the grid
+        struct LightGridEntry
+        {
+            int x, y, z;
+            uint32 light;
+            bool operator<(const LightGridEntry& rhs) const
+            {
+                if (x != rhs.x) return x < rhs.x;
+                if (y != rhs.y) return y < rhs.y;
+                if (z != rhs.z) return z < rhs.z;
+                return light < rhs.light;
+            }
+        };
+        typedef vector<LightGridCell>::type LightGridCellList;
+        typedef vector<LightGridEntry>::type LightGridEntryList;
+
+        bool mLightGridEnabled;
+        /// Whether the grid matches mLightsAffectingFrustum and is used by _populateLightList
+        bool mLightGridValid;
+        Real mLightGridCellSize;
+        /// Non empty cells, hashed on their coordinates with open addressing
+        LightGridCellList mLightGridCells;
+        /// Indices in mLightsAffectingFrustum of the lights of each cell
+        vector<uint32>::type mLightGridIndices;
+        /// Indices of the lights tested for every position, directional or too large for the grid
+        vector<uint32>::type mLightGridGlobalIndices;
+        uint64 mLightGridGlobalSignature;
+        LightGridEntryList mLightGridEntries;
+        /// Last query each light was gathered for, to skip duplicates
+        vector<uint32>::type mLightGridStamps;
+        uint32 mLightGridStamp;
+        vector<uint32>::type mLightGridCandidates;
+
+        /// Builds the light grid from mLightsAffectingFrustum
+        void buildLightGrid(void);
+        /// Finds a non empty cell of the light grid, null if there is none
+        const LightGridCell* findLightGridCell(int x, int y, int z) const;
+        /** Gets the cells of the light grid overlapped by a sphere.
+        @return
+            false if the sphere overlaps too many cells for the grid to be worth using.
+        */
+        bool getLightGridCellRange(const Vector3& position, Real radius,
+            int minCell[3], int maxCell[3]) const;
+        /// Fills mLightGridCandidates with the sorted indices of the lights which may reach a sphere
+        void gatherLightGridCandidates(const Vector3& position, Real radius);
+
         typedef map<String, MovableObject*>::type MovableObjectMap;
         /// Simple structure to hold MovableObject map and a mutex to go with it.
         struct MovableObjectCollection
@@ -1022,6 +1084,93 @@ namespace Ogre {
         typedef vector<EntityMaterialLodChangedEvent>::type EntityMaterialLodChangedEventList;
         EntityMaterialLodChangedEventList mEntityMaterialLodChangedEvents;
 
+        /// Kinds of work the worker threads can be asked to do, see fireWorkerThreadsAndWait
+        enum WorkerRequestType
+        {
+            /// Compute the derived transforms of mUpdateLevels[mUpdateLevelIndex]
+            WR_UPDATE_TRANSFORMS,
+            /// Test the world boxes of mCullNodes against mCullPlanes
+            WR_CULL_NODES
+        };
+
+        /// Number of worker threads, 0 means parallel work runs on the calling thread
+        size_t mNumWorkerThreads;
+        ThreadHandleVec mWorkerThreads;
+        Barrier* mWorkerThreadsBarrier;
+        volatile bool mExitWorkerThreads;
+        WorkerRequestType mWorkerRequest;
+
+        /// Whether _updateSceneGraph uses updateSceneGraphParallel
+        bool mParallelTransformUpdate;
+        /// Depth ordered nodes pending a transform update, reused between frames
+        Node::UpdateLevelList mUpdateLevels;
+        /// Level of mUpdateLevels currently processed by WR_UPDATE_TRANSFORMS
+        size_t mUpdateLevelIndex;
+
+        void startWorkerThreads(void);
+        void stopWorkerThreads(void);
+        /** Has every worker thread process its share of mWorkerRequest, and blocks until all
+            of them are done. Processes the whole request on the calling thread if there are
+            no worker threads.
+        */
+        void fireWorkerThreadsAndWait(void);
+        /** Processes the share of mWorkerRequest belonging to thread threadIdx of numThreads.
+        @remarks
+            Subclasses adding their own request types should handle them here and call
+            the base class for the others.
+        */
+        virtual void processWorkerRequest(size_t threadIdx, size_t numThreads);
+        /// Updates the scene graph level by level, see setParallelTransformUpdate
+        virtual void updateSceneGraphParallel(void);
+
+        /// Bounds of the attached objects used by the default scene queries, null if disabled
+        DynamicAABBTree* mQueryTree;
+
+        /// Whether _findVisibleObjects uses findVisibleObjectsParallel
+        bool mParallelCulling;
+        /// Scene graph flattened in depth first order, rebuilt when mCullNodesDirty
+        vector<SceneNode*>::type mCullNodes;
+        /// Index in mCullNodes following the last descendant of each node
+        vector<size_t>::type mCullSubtreeEnds;
+        bool mCullNodesDirty;
+        /// World box centres and half sizes of mCullNodes, filled by WR_CULL_NODES
+        vector<Vector4>::type mCullCentres;
+        vector<Vector4>::type mCullHalfSizes;
+        /// Non zero for the nodes of mCullNodes inside the frustum, output of WR_CULL_NODES
+        vector<char>::type mCullVisibilities;
+        /// Frustum planes packed as (normal, d) for WR_CULL_NODES
+        Vector4 mCullPlanes[6];
+        size_t mNumCullPlanes;
+        /// Visible nodes whose subtree is being processed, see findVisibleObjectsParallel
+        vector<size_t>::type mCullOpenNodes;
+
+        /// Appends node and its descendants to mCullNodes
+        void buildCullNodes(SceneNode* node);
+        /** Culls the nodes from begin to end of mCullNodes.
+        @remarks
+            Called from the worker threads, with disjoint ranges.
+        */
+        void cullNodes(size_t begin, size_t end);
+        /// Finds the visible objects with batched culling, see setParallelCulling
+        virtual void findVisibleObjectsParallel(Camera* cam,
+            VisibleObjectsBoundsInfo* visibleBounds, bool onlyShadowCasters);
+
+        /// Evaluates the skeletons of the entities together, null if disabled
+        SkeletonAnimationBatch* mSkeletonAnimationBatch;
+        /// Entities handed to mSkeletonAnimationBatch or mSoftwareSkinningBatch, reused between frames
+        vector<Entity*>::type mAnimatedEntities;
+        /// Updates the bone matrices of the entities in the scene, see setSkeletalAnimationBatching
+        virtual void updateSkeletalAnimations(void);
+        /// Blends the vertices of the entities together, null if disabled
+        SoftwareSkinningBatch* mSoftwareSkinningBatch;
+        /// Updates the animation of the entities in the scene, see setSoftwareSkinningBatching
+        virtual void updateSoftwareAnimations(void);
+
+        /// Filters the render state changes made by _setPass and renderSingleObject
+        RenderStateCache mRenderStateCache;
+        /// Frame whose state changes mRenderStateCache is counting
+        unsigned long mRenderStateFrameNumber;
+
     public:
         /** Constructor.
         */
@@ -1194,6 +1343,35 @@ namespace Ogre {
         */
         ulong _getLightsDirtyCounter(void) const { return mLightsDirtyCounter; }
 
+        /** Sets whether the lights affecting the frustum are indexed in a grid.
+        @remarks
+            When there are many point and spot lights affecting the frustum, they are
+            put into a uniform grid of cells sized after their average range, rebuilt
+            whenever the lights change. _populateLightList then only tests the lights
+            of the cells overlapped by the sphere given instead of every light, and
+            returns the same lists as without the grid. It also allows objects which
+            did not move to keep their light list when only lights out of their reach
+            changed, see _getLightListSignature. Disabled by default.
+        */
+        void setLightGridEnabled(bool enabled);
+
+        /** Gets whether the lights affecting the frustum are indexed in a grid. */
+        bool getLightGridEnabled(void) const { return mLightGridEnabled; }
+
+        /** Gets a value identifying the lights _populateLightList may return for a sphere.
+        @remarks
+            As long as the lights dirty counter changes but this value does not, the light
+            list populated for the sphere stays the same, and a cached one can be reused.
+            Returns 0 when unknown, in which case the list has to be populated again.
+            The value is a 64 bit hash of the sphere, of the lights which may be in
+            reach including their ranges, and of their number, so different lists
+            practically never share a signature.
+            Subclasses populating light lists from other information than the lights
+            affecting the frustum should override this to return 0.
+        */
+        virtual uint64 _getLightListSignature(const Vector3& position, Real radius,
+            uint32 lightMask = 0xFFFFFFFF) const;
+
         /** Get the list of lights which could be affecting the frustum.
         @remarks
             Note that default implementation of this method returns a cached light list,
@@ -1762,6 +1940,166 @@ namespace Ogre {
         */
         virtual void _updateSceneGraph(Camera* cam);
 
+        /** Sets the number of worker threads used for parallel scene updates.
+        @remarks
+            The threads are created immediately and sleep until the scene manager has
+            parallel work to do, e.g. a transform update when setParallelTransformUpdate
+            is enabled. The calling thread waits for them, so use at most one thread
+            less than the number of cores. 0 (the default) performs that work on the
+            calling thread.
+        @note
+            Must not be called while the scene is being updated or rendered.
+        */
+        void setNumWorkerThreads(size_t numThreads);
+
+        /** Gets the number of worker threads used for parallel scene updates. */
+        size_t getNumWorkerThreads(void) const { return mNumWorkerThreads; }
+
+        /** Internal method, main loop of a worker thread started by setNumWorkerThreads. */
+        unsigned long _updateWorkerThread(ThreadHandle* threadHandle);
+
+        /** Sets whether the scene graph transforms are updated level by level.
+        @remarks
+            By default _updateSceneGraph recurses through Node::_update from the root. When
+            this is enabled the nodes needing an update are instead flattened into depth
+            ordered arrays (see Node::UpdateLevel), and the derived transforms of each level
+            are computed in parallel on the worker threads. Attached objects, listeners and
+            bounds are then updated on the calling thread, deepest level first.
+        @par
+            This pays off for scenes with many moving nodes; for mostly static scenes the
+            recursive update does less work.
+        @note
+            Overrides of Node::_update are not called in this mode, so scene managers whose
+            nodes rely on them (e.g. BSP and PCZ) must leave it disabled. It is also
+            ignored when OGRE_NODE_INHERIT_TRANSFORM is enabled.
+        */
+        void setParallelTransformUpdate(bool enabled) { mParallelTransformUpdate = enabled; }
+
+        /** Gets whether the scene graph transforms are updated level by level. */
+        bool getParallelTransformUpdate(void) const { return mParallelTransformUpdate; }
+
+        /** Sets whether the default scene queries use a bounding volume hierarchy.
+        @remarks
+            By default the ray, axis aligned box, plane bounded volume and intersection
+            queries created by this class test every movable object of the scene. When
+            this is enabled the world bounds of the attached objects are kept in a
+            DynamicAABBTree, updated from SceneNode::_updateBounds, and those queries only
+            test the objects whose bounds are close to the query. Results are the same,
+            but they are no longer reported grouped by movable object type.
+        @par
+            Objects attached to bones are always tested. Sphere queries, which test bounding
+            radii rather than boxes, are not accelerated. Objects whose bounds change must
+            call needUpdate on their node as they already have to for culling.
+        */
+        void setSceneQueryAcceleration(bool enabled);
+
+        /** Gets whether the default scene queries use a bounding volume hierarchy. */
+        bool getSceneQueryAcceleration(void) const { return mQueryTree != 0; }
+
+        /** Internal method, gets the tree used by the default scene queries, null if disabled. */
+        const DynamicAABBTree* _getQueryTree(void) const { return mQueryTree; }
+
+        /** Internal method, sets the bounds of an object in the scene query tree.
+        @remarks
+            The object is inserted if it wasn't in the tree yet, and removed if the box is null.
+        */
+        void _updateQueryProxy(MovableObject* obj, const AxisAlignedBox& worldBox);
+
+        /** Internal method, removes an object from the scene query tree. */
+        void _removeQueryProxy(MovableObject* obj);
+
+        /** Sets whether the scene nodes are culled in batches.
+        @remarks
+            By default _findVisibleObjects recurses through SceneNode::_findVisibleObjects,
+            testing the nodes against the camera one at a time. When this is enabled the
+            scene graph is flattened in depth first order (and kept until nodes are added
+            or removed), the world boxes of the nodes are tested against the frustum
+            planes in chunks by the worker threads (see setNumWorkerThreads) using
+            OptimisedUtil::cullBoxes, and the visible nodes are then added to the render
+            queue on the calling thread, in the same order as the recursive version.
+        @par
+            The results are the same as the recursive version, provided the camera does not
+            override Camera::isVisible.
+        */
+        void setParallelCulling(bool enabled) { mParallelCulling = enabled; }
+
+        /** Gets whether the scene nodes are culled in batches. */
+        bool getParallelCulling(void) const { return mParallelCulling; }
+
+        /** Sets whether the skeletons of the entities are animated together.
+        @remarks
+            By default each entity computes its bone matrices when it is added to the
+            render queue. When this is enabled, the skeletons of the visible entities
+            in the scene are instead evaluated once per frame before the scene graph
+            update, see SkeletonAnimationBatch, spread over the worker threads of
+            Root's TaskScheduler. Entities the batch does not support are still
+            animated the usual way.
+        @par
+            As this happens before culling, only the entities rendered in the previous
+            frame are batched. Entities coming into view are animated the usual way,
+            and those which just left it are animated for one more frame.
+        */
+        void setSkeletalAnimationBatching(bool enabled);
+
+        /** Gets whether the skeletons of the entities are animated together. */
+        bool getSkeletalAnimationBatching(void) const { return mSkeletonAnimationBatch != 0; }
+
+        /** Sets whether the vertices of software skinned entities are blended together.
+        @remarks
+            When this is enabled, the animation of the visible animated entities
+            in the scene is updated once per frame before the scene graph update, and
+            their vertex blends are spread over the worker threads of Root's
+            TaskScheduler, see SoftwareSkinningBatch. This helps when skinning runs
+            on the CPU, for stencil shadows or without skinning shaders.
+        @par
+            Like setSkeletalAnimationBatching, only the entities rendered in the
+            previous frame are updated this way.
+        */
+        void setSoftwareSkinningBatching(bool enabled);
+
+        /** Gets whether the vertices of software skinned entities are blended together. */
+        bool getSoftwareSkinningBatching(void) const { return mSoftwareSkinningBatch != 0; }
+
+        /** Sets whether render state changes which would not change anything are dropped.
+        @remarks
+            When enabled, which is the default, the states set for each pass are
+            compared against a shadow copy of the last ones given to the render
+            system, see RenderStateCache. Call _invalidateRenderStateCache after
+            changing those states on the RenderSystem directly during rendering,
+            outside of the listener callbacks of this class.
+        */
+        void setRenderStateCaching(bool enabled) { mRenderStateCache.setEnabled(enabled); }
+
+        /** Gets whether render state changes which would not change anything are dropped. */
+        bool getRenderStateCaching(void) const { return mRenderStateCache.getEnabled(); }
+
+        /** Gets the counts of render state changes made in the current frame.
+        @remarks
+            The counts are reset when the first viewport of a frame is rendered, so
+            after Root::renderOneFrame they cover the whole frame.
+        */
+        const RenderStateCache::Statistics& getRenderStateStatistics(void) const
+        { return mRenderStateCache.getStatistics(); }
+
+        /** Makes the next pass set all of its render states. */
+        void _invalidateRenderStateCache(void) { mRenderStateCache.invalidate(); }
+
+        /** Sets whether the automatic constants common to all programs are kept in shared blocks.
+        @remarks
+            When enabled, the camera and pass dependent automatic constants are
+            evaluated into the OgreFrameParams and OgrePassParams shared parameter
+            sets once per camera and pass, see AutoParamDataSource::setSharedBlocksEnabled.
+            Programs pick them up with shared_params_ref instead of declaring the
+            automatic constants themselves. Disabled by default.
+        */
+        void setSharedAutoParamBlocks(bool enabled);
+
+        /** Gets whether the automatic constants common to all programs are kept in shared blocks. */
+        bool getSharedAutoParamBlocks(void) const;
+
+        /** Internal method, called by SceneNode when a node is added to or removed from a parent. */
+        void _notifySceneGraphChanged(void) { mCullNodesDirty = true; }
+
         /** Internal method which parses the scene to find visible objects to render.
             @remarks
                 If you're implementing a custom scene manager, this is the most important method to
@@ -78,6 +78,9 @@ namespace Ogre {
 
         void updateFromParentImpl(void) const;
 
+        /** See Node. Notifies the attached objects that they have moved. */
+        void derivedTransformUpdatedImpl(void) const;
+
         /** See Node. */
         Node* createChildImpl(void);
 
@@ -208,6 +211,21 @@ namespace Ogre {
             VisibleObjectsBoundsInfo* visibleBounds, 
             bool includeChildren = true, bool displayNodes = false, bool onlyShadowCasters = false);
 
+        /** Internal method which adds the objects attached to this node to the queue, without
+            testing the visibility of the node or cascading to its children.
+        @remarks
+            Used by scene managers which cull the nodes themselves, see _findVisibleObjects.
+        */
+        void _addVisibleObjects(Camera* cam, RenderQueue* queue,
+            VisibleObjectsBoundsInfo* visibleBounds, bool onlyShadowCasters = false);
+
+        /** Internal method which adds the axes and bounding box of this node to the queue, when
+            they should be displayed.
+        @remarks
+            _findVisibleObjects calls this once the children of the node have been processed.
+        */
+        void _addDebugRenderables(RenderQueue* queue, bool displayNodes);
+
         /** Gets the axis-aligned bounding box of this node (and hence all subnodes).
         @remarks
             Recommended only if you are extending a SceneManager, because the bounding box returned
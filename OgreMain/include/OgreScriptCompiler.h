@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgreSharedPtr.h"
 #include "OgreSingleton.h"
 #include "OgreScriptLoader.h"
+#include "OgreScriptLexer.h"
 #include "OgreGpuProgram.h"
 #include "OgreAny.h"
 #include "Threading/OgreThreadHeaders.h"
@@ -72,6 +73,26 @@ namespace Ogre
         ConcreteNode *parent;
     };
 
+    /** A ConcreteNode parsed into a ScriptArena by ScriptParser.
+    @remarks
+        The token refers to the script source or the arena and is not null
+        terminated, and the children form an intrusive list, so a tree of these
+        needs no allocations beyond the blocks of the arena. It lives as long as
+        the arena and the script it was parsed from.
+    */
+    struct ScriptNodeView
+    {
+        const char *token;
+        uint32 length;
+        uint32 line;
+        const String *file;
+        ConcreteNodeType type;
+        ScriptNodeView *parent;
+        ScriptNodeView *firstChild, *lastChild;
+        ScriptNodeView *prev, *next;
+        size_t numChildren;
+    };
+
     /** This enum holds the types of the possible abstract nodes */
     enum AbstractNodeType
     {
@@ -218,6 +239,20 @@ namespace Ogre
             CE_REFERENCETOANONEXISTINGOBJECT
         };
         static String formatErrorCode(uint32 code);
+
+        /// Content hash of a script file, to tell whether a cached compilation is out of date
+        struct SourceHash
+        {
+            String name;
+            uint32 hash;
+            /// Length of the file, MISSING if it was not found
+            uint32 length;
+
+            static const uint32 MISSING = 0xFFFFFFFF;
+        };
+        typedef vector<SourceHash>::type SourceHashList;
+        /// Returns the content hash of the given script code
+        static SourceHash hashSource(const String &name, const String &str);
     public:
         ScriptCompiler();
         virtual ~ScriptCompiler() {}
@@ -231,10 +266,34 @@ namespace Ogre
         bool compile(const String &str, const String &source, const String &group);
         /// Compiles resources from the given concrete node list
         bool compile(const ConcreteNodeListPtr &nodes, const String &group);
+        /// Compiles resources from the given tree parsed into a ScriptArena
+        bool compile(const ScriptNodeView *nodes, const String &group);
         /// Generates the AST from the given string script
         AbstractNodeListPtr _generateAST(const String &str, const String &source, bool doImports = false, bool doObjects = false, bool doVariables = false);
         /// Compiles the given abstract syntax tree
         bool _compile(AbstractNodeListPtr nodes, const String &group, bool doImports = true, bool doObjects = true, bool doVariables = true);
+        /** Compiles the script code like compile, and also writes its abstract syntax tree
+            to binary, with imports, inheritance and variables already resolved.
+        @param binary Receives the tree, to be translated later by _compileFromBinary
+        @param imports Receives the content hashes of the files the script imported
+        @return True if the script compiled without errors
+        */
+        bool _compileToBinary(const String &str, const String &source, const String &group,
+            String &binary, SourceHashList &imports);
+        /// @copydoc _compileToBinary
+        bool _compileToBinary(const ConcreteNodeListPtr &nodes, const String &group,
+            String &binary, SourceHashList &imports);
+        /// @copydoc _compileToBinary
+        bool _compileToBinary(const ScriptNodeView *nodes, const String &group,
+            String &binary, SourceHashList &imports);
+        /** Translates an abstract syntax tree written by _compileToBinary into resources,
+            without lexing, parsing or processing the script again.
+        @remarks
+            The whole binary is read before anything is translated.
+        @param translated Receives whether the binary was well formed, and so translated
+        @return True if the binary was translated without errors
+        */
+        bool _compileFromBinary(const String &binary, const String &group, bool &translated);
         /// Adds the given error to the compiler's list of errors
         void addError(uint32 code, const String &file, int line, const String &msg = "");
         /// Sets the listener used by the compiler
@@ -243,6 +302,17 @@ namespace Ogre
         ScriptCompilerListener *getListener();
         /// Returns the resource group currently set for this compiler
         const String &getResourceGroup() const;
+        /** Sets whether scripts compiled from source are tokenized into views of
+            the source and parsed into an arena owned by the compiler.
+        @remarks
+            This avoids allocating every token and concrete node separately. The
+            tree is the same either way, but while a listener is set scripts are
+            parsed into a ConcreteNodeList as before, since the listener may
+            inspect or replace it. Off by default.
+        */
+        void setArenaParsing(bool val);
+        /// Returns whether scripts are parsed into an arena
+        bool getArenaParsing() const;
         /// Adds a name exclusion to the map
         /**
          * Name exclusions identify object types which cannot accept
@@ -269,7 +339,13 @@ namespace Ogre
 		uint32 registerCustomWordId(const String &word);
 
     private: // Tree processing
+        /// Compiles the given concrete node list, writing the processed tree to binary if given
+        bool compileImpl(const ConcreteNodeListPtr &nodes, const ScriptNodeView *viewNodes,
+            const String &group, String *binary);
         AbstractNodeListPtr convertToAST(const ConcreteNodeListPtr &nodes);
+        AbstractNodeListPtr convertToAST(const ScriptNodeView *nodes);
+        /// Tokenizes and parses the script into mArena, which is left for the caller to clear
+        const ScriptNodeView *parseToArena(const String &str, const String &source);
         /// This built-in function processes import nodes
         void processImports(AbstractNodeListPtr &nodes);
         /// Loads the requested script and converts it to an AST
@@ -286,6 +362,10 @@ namespace Ogre
         bool isNameExcluded(const String &cls, AbstractNode *parent);
         /// This function sets up the initial values in word id map
         void initWordMap();
+        /// Writes the given tree to binary
+        void writeBinaryAST(const AbstractNodeList &nodes, String &binary) const;
+        /// Reads a tree written by writeBinaryAST, returning null if the binary is malformed
+        AbstractNodeListPtr readBinaryAST(const String &binary) const;
     private:
         // Resource group
         String mGroup;
@@ -312,6 +392,14 @@ namespace Ogre
 
         // The listener
         ScriptCompilerListener *mListener;
+
+        // Receives the content hashes of the imported files while compiling to binary
+        SourceHashList *mImportHashes;
+
+        // Holds the tokens and concrete nodes of the script being compiled when arena parsing
+        bool mArenaParsing;
+        ScriptArena mArena;
+        ScriptTokenViewList mTokenViews;
     private: // Internal helper classes and processors
         class AbstractTreeBuilder
         {
@@ -324,6 +412,11 @@ namespace Ogre
             const AbstractNodeListPtr &getResult() const;
             void visit(ConcreteNode *node);
             static void visit(AbstractTreeBuilder *visitor, const ConcreteNodeList &nodes);
+            void visit(const ScriptNodeView *node);
+            static void visit(AbstractTreeBuilder *visitor, const ScriptNodeView *first);
+        private:
+            /// Builds the nodes for either kind of concrete node, described by Traits
+            template<class Traits> void visitNode(const typename Traits::NodeType *node);
         };
         friend class AbstractTreeBuilder;
     public: // Public translator definitions
@@ -418,6 +511,25 @@ namespace Ogre
 
         // A pointer to the specific compiler instance used
         OGRE_THREAD_POINTER(ScriptCompiler, mScriptCompiler);
+
+        // A script compiled to binary, with the content hashes it was compiled from
+        struct CompiledScript
+        {
+            // The script itself first, then the files it imported
+            ScriptCompiler::SourceHashList sources;
+            String binary;
+        };
+        // Compiled scripts by resource group and name
+        typedef map<std::pair<String, String>, CompiledScript>::type CompiledScriptMap;
+        CompiledScriptMap mCompiledScripts;
+        bool mSaveCompiledScriptsToCache;
+        bool mCompiledScriptCacheDirty; // When this is true the cache is 'dirty' and should be resaved to disk.
+        bool mArenaScriptParsing;
+
+        /// Returns whether the files a cached script imported are unchanged
+        bool isCompiledScriptCurrent(const CompiledScript &script, const String &groupName) const;
+        /// Returns the compiler for this thread, set up with the current listener
+        ScriptCompiler *getThreadCompiler(void);
     public:
         ScriptCompilerManager();
         virtual ~ScriptCompilerManager();
@@ -455,9 +567,54 @@ namespace Ogre
         const StringVector& getScriptPatterns(void) const;
         /// @copydoc ScriptLoader::parseScript
         void parseScript(DataStreamPtr& stream, const String& groupName);
+        /** @copydoc ScriptLoader::preParseScript
+        @remarks
+            Tokenizes and parses the script into a ConcreteNodeList, or into an
+            arena of its own with arena parsing on. Imports are resolved and the
+            objects translated by finishParseScript. Scripts are
+            left to parseScript while a compiled script cache is loaded, as parsing
+            may not be needed at all then.
+        */
+        ParsedScriptPtr preParseScript(DataStreamPtr& stream, const String& groupName);
+        /// @copydoc ScriptLoader::finishParseScript
+        void finishParseScript(DataStreamPtr& stream, const String& groupName, const ParsedScriptPtr& parsed);
         /// @copydoc ScriptLoader::getLoadingOrder
         Real getLoadingOrder(void) const;
 
+        /** Sets whether the compilers parse scripts into an arena.
+        @see ScriptCompiler::setArenaParsing
+        */
+        void setArenaScriptParsing(bool val);
+        /// Returns whether the compilers parse scripts into an arena
+        bool getArenaScriptParsing(void) const;
+
+        /** Sets whether scripts parsed from now on are added to the compiled script cache.
+        @remarks
+            The cache keeps the abstract syntax tree of each script that compiled without
+            errors, with imports, inheritance and variables already resolved, along with
+            content hashes of the script and the files it imported. While the script and its
+            imports are unchanged, parseScript translates the cached tree directly instead of
+            lexing, parsing and processing the script again. Save the cache with
+            saveCompiledScriptCache after parsing the scripts, and load it with
+            loadCompiledScriptCache before parsing them on later runs. Scripts are always
+            compiled from source while a listener is set, since it may change the tree.
+        */
+        void setSaveCompiledScriptsToCache(bool val);
+        /// Returns whether parsed scripts are added to the compiled script cache
+        bool getSaveCompiledScriptsToCache(void) const;
+        /// Returns whether the compiled script cache changed since it was loaded
+        bool isCompiledScriptCacheDirty(void) const;
+        /// Removes all the scripts from the compiled script cache
+        void clearCompiledScriptCache(void);
+        /** Writes the compiled script cache to a stream, if it changed since it was loaded. */
+        void saveCompiledScriptCache(DataStreamPtr stream) const;
+        /** Replaces the compiled script cache with one written by saveCompiledScriptCache.
+        @remarks
+            A cache written by a different version of the format, or a truncated or
+            damaged one, is ignored.
+        */
+        void loadCompiledScriptCache(DataStreamPtr stream);
+
         /// @copydoc Singleton::getSingleton()
         static ScriptCompilerManager& getSingleton(void);
         /// @copydoc Singleton::getSingleton()
@@ -72,13 +72,74 @@ namespace Ogre {
     typedef vector<ScriptTokenPtr>::type ScriptTokenList;
     typedef SharedPtr<ScriptTokenList> ScriptTokenListPtr;
 
+    /** A token which refers to its lexeme rather than holding a copy of it.
+    @remarks
+        The lexeme points into the tokenized script, or into the ScriptArena
+        for quotes with escaped characters, and is not null terminated.
+    */
+    struct ScriptTokenView
+    {
+        const char *lexeme;
+        uint32 length;
+        /// This is the id associated with the lexeme, which comes from a lexeme-token id mapping
+        uint32 type;
+        /// This holds the line number of the input stream where the token was found.
+        uint32 line;
+    };
+    typedef vector<ScriptTokenView>::type ScriptTokenViewList;
+
+    /** Allocates the tokens and nodes of a script compilation from a few large
+        blocks, and releases them all at once.
+    @remarks
+        Only types which need no destructor can be placed in the arena. Clearing
+        it keeps the blocks, so once they are large enough, compiling one script
+        after another with the same arena allocates nothing more.
+    */
+    class _OgreExport ScriptArena : public ScriptCompilerAlloc
+    {
+    public:
+        explicit ScriptArena(size_t blockSize = 64 * 1024);
+        ~ScriptArena();
+
+        /// Returns size bytes, aligned for any of the types placed in the arena
+        void *allocate(size_t size);
+        /// Makes all the memory of the arena available again
+        void clear(void);
+        /// Returns the size of all the blocks of the arena
+        size_t getCapacity(void) const;
+    private:
+        struct Block
+        {
+            char *data;
+            size_t size;
+        };
+        vector<Block>::type mBlocks;
+        /// Block being allocated from and the bytes used in it
+        size_t mCurrent, mUsed;
+        size_t mBlockSize;
+
+        ScriptArena(const ScriptArena&);
+        ScriptArena &operator=(const ScriptArena&);
+    };
+
     class _OgreExport ScriptLexer : public ScriptCompilerAlloc
     {
     public:
         /** Tokenizes the given input and returns the list of tokens found */
         static ScriptTokenListPtr tokenize(const String &str, const String &source);
+        /** Tokenizes the given input into views of it, which stay valid as long
+            as the input and the arena do.
+        @remarks
+            Finds the same tokens as the other overload without copying their
+            lexemes, only quotes with escaped characters are copied to the arena.
+        @param tokens Cleared, then receives the tokens found
+        */
+        static void tokenize(const String &str, ScriptArena &arena, ScriptTokenViewList &tokens);
     private: // Private utility operations
         static void setToken(const String &lexeme, uint32 line, const String &source, ScriptTokenList *tokens);
+        static void setToken(const char *lexeme, size_t length, uint32 line, ScriptTokenViewList &tokens);
+        /// Removes the escaping backslashes of a quote the way tokenize does
+        static const char *unescapeQuote(const char *begin, const char *end, ScriptArena &arena, size_t &length);
         static bool isWhitespace(Ogre::String::value_type c);
         static bool isNewline(Ogre::String::value_type c);
     };
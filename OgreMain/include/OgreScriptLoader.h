@@ -59,6 +59,16 @@ namespace Ogre {
     class _OgreExport ScriptLoader
     {
     public:
+        /** What a script was parsed into by preParseScript, for the loader to
+            create its contents from later. Loaders derive their own.
+        */
+        class ParsedScript : public GeneralAllocatedObject
+        {
+        public:
+            virtual ~ParsedScript() {}
+        };
+        typedef SharedPtr<ParsedScript> ParsedScriptPtr;
+
         virtual ~ScriptLoader() {}
         /** Gets the file patterns which should be used to find scripts for this
             class.
@@ -77,6 +87,28 @@ namespace Ogre {
         */
         virtual void parseScript(DataStreamPtr& stream, const String& groupName) = 0;
 
+        /** Parses a script file without creating anything from it yet.
+        @remarks
+            When ResourceGroupManager::setParallelScriptParsing is enabled, this is
+            called for several scripts of a group at once from the worker threads,
+            so it must not change any shared state. Each result is then passed to
+            finishParseScript from the calling thread, in the usual order.
+        @param stream The source of the script, which is read from the start
+            again if this returns null or throws
+        @return The parsed script, or null to parse it all in parseScript as
+            usual, which is what the default implementation does
+        */
+        virtual ParsedScriptPtr preParseScript(DataStreamPtr& stream, const String& groupName)
+        { (void)stream; (void)groupName; return ParsedScriptPtr(); }
+
+        /** Creates the contents of a script parsed by preParseScript.
+        @param parsed The result of preParseScript, if null the default
+            implementation calls parseScript
+        */
+        virtual void finishParseScript(DataStreamPtr& stream, const String& groupName,
+            const ParsedScriptPtr& parsed)
+        { (void)parsed; parseScript(stream, groupName); }
+
         /** Gets the relative loading order of scripts of this type.
         @remarks
             There are dependencies between some kinds of scripts, and to enforce
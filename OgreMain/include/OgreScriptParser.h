@@ -48,9 +48,22 @@ namespace Ogre {
     public:
         static ConcreteNodeListPtr parse(const ScriptTokenListPtr &tokens);
         static ConcreteNodeListPtr parseChunk(const ScriptTokenListPtr &tokens);
+        /** Parses the tokens into the same tree as the other overload, allocating
+            its nodes from the arena.
+        @param source The name of the script, which the nodes refer to
+        @return The first top-level node, or null if there are none
+        */
+        static ScriptNodeView *parse(const ScriptTokenViewList &tokens, const String &source, ScriptArena &arena);
     private:
         static ScriptToken *getToken(ScriptTokenList::iterator i, ScriptTokenList::iterator end, int offset);
         static ScriptTokenList::iterator skipNewlines(ScriptTokenList::iterator i, ScriptTokenList::iterator end);
+        static ScriptTokenViewList::const_iterator skipNewlines(ScriptTokenViewList::const_iterator i,
+            ScriptTokenViewList::const_iterator end);
+        /// Creates a node from the token, dropping the quotes around its lexeme if asked
+        static ScriptNodeView *createNode(const ScriptTokenView &token, ConcreteNodeType type, bool unquote,
+            const String &source, ScriptArena &arena);
+        /// Appends the node to the children of parent, or to the top-level nodes if there is no parent
+        static void addNode(ScriptNodeView *parent, ScriptNodeView *node, ScriptNodeView *&first, ScriptNodeView *&last);
     };
     
     /** @} */
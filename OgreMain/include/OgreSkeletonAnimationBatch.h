@@ -0,0 +1,205 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __SkeletonAnimationBatch_H__
+#define __SkeletonAnimationBatch_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreAnimationState.h"
+#include "OgreAnimationTrack.h"
+#include "OgreResource.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre {
+
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup Animation
+    *  @{
+    */
+    /** Computes the bone matrices of many skeletally animated entities at once.
+    @remarks
+        Entity::updateAnimation evaluates each skeleton on its own while the
+        render queue is filled, walking the bones through the Node hierarchy.
+        This class instead lays the bones of each skeleton out as structure of
+        arrays, grouped by depth so that 4 bones with their parents already
+        derived can be processed together with SSE. Keyframes are sampled and
+        blended, derived transforms and bone offset matrices computed this way,
+        and the matrices written straight into the matrix buffer of the entity.
+        The entities are spread over the worker threads of Root's TaskScheduler.
+    @par
+        The local transforms are written back to the bones, so tag points and
+        Skeleton::getBone still see the animated pose. The entity then finds its
+        bone matrices up to date for the frame and skips the per entity path.
+    @par
+        The layouts of the skeletons are kept from frame to frame, and only
+        built again once a skeleton was reloaded or replaced.
+    @par
+        Entities whose animation can't be evaluated this way are left to
+        Entity::updateAnimation, see isSupported.
+    */
+    class _OgreExport SkeletonAnimationBatch : public AnimationAlloc
+    {
+    public:
+        SkeletonAnimationBatch();
+        ~SkeletonAnimationBatch();
+
+        /** Updates the bone matrices of those entities which need it this frame.
+        @remarks
+            Entities which are not supported, or whose bone matrices are
+            already up to date, are skipped. Entities sharing a skeleton
+            instance are evaluated once.
+        @return The number of skeletons evaluated.
+        */
+        size_t update(Entity* const* entities, size_t count);
+
+        /** Gets whether the skeletal animation of an entity can be batched.
+        @remarks
+            Requires an initialised entity with a skeleton without manually
+            controlled bones, whose enabled animations use linear interpolation
+            and have no track listeners, and for which animation state updates
+            are not skipped. Always false when OGRE_NODE_INHERIT_TRANSFORM is
+            enabled.
+        */
+        static bool isSupported(const Entity* entity);
+
+    protected:
+        /// Components of a bone transform, each stored as an array over the bones
+        enum PoseComponent
+        {
+            PC_POSITION_X, PC_POSITION_Y, PC_POSITION_Z,
+            PC_ORIENTATION_W, PC_ORIENTATION_X, PC_ORIENTATION_Y, PC_ORIENTATION_Z,
+            PC_SCALE_X, PC_SCALE_Y, PC_SCALE_Z,
+            PC_COUNT
+        };
+
+        /** The bones of a skeleton in depth order.
+        @remarks
+            Slots are handed out in blocks of 4 which only hold bones of the same
+            depth, padded with unused slots, so a block only depends on earlier
+            ones. The first block is an identity parent the root bones refer to.
+        */
+        struct Layout
+        {
+            /// Handle and state count of the skeleton when the layout was built
+            ResourceHandle mSkeletonHandle;
+            size_t mSkeletonStateCount;
+            /// Number of slots, a multiple of 4
+            size_t mNumSlots;
+            /// Bone handle of each slot, NO_BONE for padding
+            vector<unsigned short>::type mHandles;
+            /// Slot of each bone handle
+            vector<unsigned short>::type mSlots;
+            /// Slot of the parent of each slot
+            vector<unsigned short>::type mParents;
+            /** Initial pose, bind pose inverse (both PC_COUNT arrays of mNumSlots)
+                and 1 or 0 for the orientation and scale inheritance of each slot.
+            */
+            Real* mData;
+
+            Real* getInitialPose() const { return mData; }
+            Real* getBindPoseInverse() const { return mData + PC_COUNT * mNumSlots; }
+            Real* getInheritOrientation() const { return mData + 2 * PC_COUNT * mNumSlots; }
+            Real* getInheritScale() const { return getInheritOrientation() + mNumSlots; }
+        };
+
+        /// Node tracks of an animation used this frame
+        struct AnimationInfo
+        {
+            Animation* mAnimation;
+            /// Range of the tracks in mTracks
+            size_t mTrackBegin, mTrackEnd;
+            bool mSpherical;
+            /// Whether the animation can be batched, see isSupported
+            bool mSupported;
+        };
+
+        /// Animation applied to a skeleton, see Skeleton::setAnimationState
+        struct Layer
+        {
+            size_t mAnimationIndex;
+            TimeIndex mTimeIndex;
+            Real mWeight;
+            Real mScale;
+            const AnimationState::BoneBlendMask* mBlendMask;
+
+            Layer(const TimeIndex& timeIndex) : mTimeIndex(timeIndex) {}
+        };
+
+        /// A skeleton to evaluate
+        struct Job
+        {
+            Entity* mEntity;
+            size_t mLayoutIndex;
+            /// Range of the layers in mLayers
+            size_t mLayerBegin, mLayerEnd;
+        };
+
+        struct EvaluateJobs;
+
+        static const unsigned short NO_BONE = 0xFFFF;
+
+        vector<Layout>::type mLayouts;
+        map<const Skeleton*, size_t>::type mLayoutIndices;
+        vector<AnimationInfo>::type mAnimations;
+        map<const Animation*, size_t>::type mAnimationIndices;
+        vector<const NodeAnimationTrack*>::type mTracks;
+        vector<Layer>::type mLayers;
+        vector<Job>::type mJobs;
+        /// Largest number of slots of the layouts
+        size_t mMaxSlots;
+
+        /// Checks the entity related conditions of isSupported
+        static bool isEntitySupported(const Entity* entity);
+        /// Checks the animation related conditions of isSupported
+        static bool isAnimationSupported(const Animation* anim);
+        /// Gets the layout of the skeleton of an entity, building it if needed
+        size_t getLayout(Entity* entity);
+        /// Fills a layout with the bones of a skeleton
+        void buildLayout(Layout& layout, const Skeleton* master, SkeletonInstance* skel);
+        /// Gets the tracks of an animation, collecting them if needed
+        size_t getAnimation(Animation* anim);
+        /// Adds the job of an entity, returns false if it can't be batched
+        bool addJob(Entity* entity);
+        /// Clears what is only valid for the frame, keeping the layouts
+        void clearFrame(void);
+
+        /// Evaluates a skeleton, scratch holds 2 * PC_COUNT * mMaxSlots Reals
+        void evaluate(const Job& job, Real* scratch) const;
+        /// Applies the tracks [begin, end) of a layer, at most 4, to a pose
+        void applyTracks(const Layer& layer, const Layout& layout, size_t begin, size_t end,
+            Real* pose) const;
+    };
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
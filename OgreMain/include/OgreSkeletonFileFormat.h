@@ -101,6 +101,21 @@ namespace Ogre {
                     // Quaternion rotate            : Rotation to apply at this keyframe
                     // Vector3 translate            : Translation to apply at this keyframe
                     // Vector3 scale                : Scale to apply at this keyframe
+
+                SKELETON_ANIMATION_TRACK_COMPRESSED = 0x4120,
+                // [Optional, v1.100+] all the keyframes of a compressed track, in
+                // place of SKELETON_ANIMATION_TRACK_KEYFRAME
+                    // unsigned short numKeyFrames
+                    // unsigned short modes[3]      : CompressedTransformKeyFrames::ChannelMode of
+                    //                                the translation, rotation and scale
+                    // float times[numKeyFrames]
+                    // translation, then rotation, then scale, each depending on its mode:
+                    //   CM_IDENTITY                : nothing
+                    //   CM_CONSTANT                : Vector3 value, or Quaternion rotation
+                    //   CM_QUANTISED               : Vector3 base, Vector3 step and unsigned short
+                    //                                values[3 * numKeyFrames], only the values
+                    //                                for the rotation
+                    //   CM_FULL                    : float values[3 * numKeyFrames]
         SKELETON_ANIMATION_LINK         = 0x5000
         // Link to another skeleton, to re-use its animations
 
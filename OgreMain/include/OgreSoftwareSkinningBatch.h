@@ -0,0 +1,132 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __SoftwareSkinningBatch_H__
+#define __SoftwareSkinningBatch_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreHardwareBuffer.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre {
+
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup Animation
+    *  @{
+    */
+    /** Blends the vertices of many software skinned entities together.
+    @remarks
+        Entity::updateAnimation skins the vertices of each entity on its own
+        while the render queue is filled. This class runs the animation of a
+        set of entities instead, but only records the vertex blends while the
+        buffers are locked on the calling thread, then splits the vertices of
+        all of them into chunks which are skinned on the worker threads of
+        Root's TaskScheduler. The buffers are unlocked on the calling thread
+        once all chunks are done, so render systems which can only access
+        their buffers from one thread are fine.
+    @par
+        The entities then find their animation up to date for the frame. Those
+        with vertex animation are skinned straight away as usual, since their
+        vertex blend depends on the morph or pose results, see
+        OptimisedUtil::setParallelVertexThreshold to split those.
+    */
+    class _OgreExport SoftwareSkinningBatch : public AnimationAlloc
+    {
+    public:
+        SoftwareSkinningBatch();
+        ~SoftwareSkinningBatch();
+
+        /** Updates the animation of the entities, blending their vertices together.
+        @return The number of vertex blends run in parallel.
+        */
+        size_t update(Entity* const* entities, size_t count);
+
+        /** Records a vertex blend to run later, see Mesh::softwareVertexBlend.
+        @remarks
+            Called by Entity::updateAnimation. The buffers are locked until
+            run, a buffer used by several blends only once.
+        @param blendMatrices The matrices are referenced rather than copied, so
+            they must not change until run.
+        */
+        void addVertexBlend(const VertexData* sourceVertexData, const VertexData* targetVertexData,
+            const Matrix4* const* blendMatrices, size_t numMatrices, bool blendNormals);
+
+        /** Runs the vertex blends recorded, then unlocks their buffers. */
+        void run(void);
+
+    protected:
+        /// Vertices per chunk, a multiple of 16 to keep the SIMD blocks whole and aligned
+        static const size_t CHUNK_VERTICES = 1024;
+
+        /// A recorded vertex blend, see OptimisedUtil::softwareVertexSkinning
+        struct Job
+        {
+            const float* mSrcPos;
+            float* mDestPos;
+            const float* mSrcNorm;
+            float* mDestNorm;
+            const float* mBlendWeight;
+            const unsigned char* mBlendIndex;
+            /// Start of the blend matrices in mBlendMatrices
+            size_t mFirstMatrix;
+            size_t mSrcPosStride, mDestPosStride;
+            size_t mSrcNormStride, mDestNormStride;
+            size_t mBlendWeightStride, mBlendIndexStride;
+            size_t mNumWeightsPerVertex;
+            size_t mNumVertices;
+        };
+
+        /// Vertices [mBegin, mEnd) of a job
+        struct Chunk
+        {
+            size_t mJob;
+            size_t mBegin, mEnd;
+        };
+
+        struct SkinChunks;
+
+        vector<Job>::type mJobs;
+        vector<Chunk>::type mChunks;
+        vector<const Matrix4*>::type mBlendMatrices;
+        /// Locked buffers and the pointers they were locked at
+        map<HardwareBuffer*, void*>::type mLockedBuffers;
+
+        /// Locks a buffer, or returns the pointer it was locked at before
+        void* lock(HardwareBuffer* buffer, HardwareBuffer::LockOptions options);
+        /// Unlocks the buffers and forgets the jobs
+        void clear(void);
+    };
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -0,0 +1,256 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __TaskScheduler_H__
+#define __TaskScheduler_H__
+
+#include "OgrePrerequisites.h"
+#include "OgreWorkQueue.h"
+#include "OgreAtomicScalar.h"
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup General
+    *  @{
+    */
+
+    /** Data parallel work run by a TaskGroup.
+    @remarks
+        The range given to TaskGroup::run is split into chunks which are passed
+        to execute, concurrently from the worker threads and the thread waiting
+        on the group. Chunks never overlap, so a task only needs to synchronise
+        the state shared between items.
+    */
+    class _OgreExport Task
+    {
+    public:
+        virtual ~Task() {}
+        /** Processes the items [begin, end) of the task.
+        @note Exceptions must not escape from here, they can't be reported
+            back from the worker threads.
+        */
+        virtual void execute(size_t begin, size_t end) = 0;
+    };
+
+    /** Task calling a functor with each chunk.
+    @remarks
+        The functor is called as func(begin, end), see parallelFor.
+    */
+    template<class Func> class FunctorTask : public Task
+    {
+    protected:
+        Func mFunc;
+    public:
+        FunctorTask(const Func& func) : mFunc(func) {}
+        void execute(size_t begin, size_t end) { mFunc(begin, end); }
+    };
+
+    /** Runs the tasks of TaskGroup instances on the worker threads of a WorkQueue.
+    @remarks
+        WorkQueue requests are answered on the main thread, which suits
+        background loading but not work the caller needs back in the same frame.
+        The scheduler registers a request handler on its own channel of the
+        queue, and TaskGroup posts one request per worker thread to pull
+        chunks of its tasks, while the waiting thread pulls chunks too. Work
+        is thus shared with the other users of the queue rather than needing
+        threads of its own.
+    @par
+        Root creates one for its WorkQueue, see Root::getTaskScheduler.
+    */
+    class _OgreExport TaskScheduler : public WorkQueue::RequestHandler, public UtilityAlloc
+    {
+    public:
+        /** Constructor.
+        @param queue The queue whose worker threads run the tasks, or 0 to
+            run them on the waiting thread only.
+        */
+        TaskScheduler(WorkQueue* queue);
+        virtual ~TaskScheduler();
+
+        /// Get the queue running the tasks
+        WorkQueue* getWorkQueue() const { return mQueue; }
+        /// Get the channel of the requests running tasks
+        uint16 getChannel() const { return mChannel; }
+
+        /** Get the number of threads that can run the chunks of a task, the
+            worker threads of the queue and the waiting thread, or 1 when the
+            queue is not running.
+        */
+        size_t getConcurrency() const;
+
+        /** Gets whether the calling thread created the scheduler.
+        @remarks
+            The Profiler can only be used from the main thread, so this is
+            where TaskGroup records the time spent on it.
+        */
+        bool isMainThread() const;
+
+        /// WorkQueue::RequestHandler override
+        bool canHandleRequest(const WorkQueue::Request* req, const WorkQueue* srcQ);
+        /// WorkQueue::RequestHandler override
+        WorkQueue::Response* handleRequest(const WorkQueue::Request* req, const WorkQueue* srcQ);
+
+    protected:
+        WorkQueue* mQueue;
+        uint16 mChannel;
+#if OGRE_THREAD_SUPPORT
+        OGRE_THREAD_ID_TYPE mMainThreadID;
+#endif
+    };
+
+    /** Fork / join group of tasks.
+    @remarks
+        Tasks added with run start on the worker threads straight away, and wait
+        blocks until all of them completed. By default the waiting thread
+        processes chunks too, so the group finishes even when the workers are
+        busy with other requests, and nested groups run from inside a task
+        can't deadlock.
+    @par
+        The group waits for its tasks on destruction, so tasks and the data
+        they use can live on the caller's stack.
+    */
+    class _OgreExport TaskGroup
+    {
+    public:
+        /** Constructor.
+        @param name Name the time spent waiting is profiled under.
+        @param scheduler The scheduler to use, by default the one of Root. If
+            there is none, the tasks run on the waiting thread.
+        */
+        TaskGroup(const String& name = "TaskGroup", TaskScheduler* scheduler = 0);
+        ~TaskGroup();
+
+        /** Starts running a task on the items [begin, end).
+        @param task The task, which must live until wait returned.
+        @param begin, end The range of items to process.
+        @param grainSize Number of items per chunk, so the overhead of claiming
+            a chunk is amortised. Chunks are claimed dynamically, so a few
+            chunks per thread balance uneven work.
+        */
+        void run(Task* task, size_t begin, size_t end, size_t grainSize = 1);
+
+        /** Waits for all the tasks run so far.
+        @param participate Whether the calling thread processes chunks while
+            waiting, rather than only blocking until the workers are done.
+        */
+        void wait(bool participate = true);
+
+        /// Get the name the group is profiled under
+        const String& getName() const { return mName; }
+
+    protected:
+        friend class TaskScheduler;
+
+        /** The chunks of a task, shared by the group and the requests it
+            posted to pull them, and deleted by the last one done with it.
+        */
+        struct Batch : public UtilityAlloc
+        {
+            Task* mTask;
+            size_t mBegin;
+            size_t mEnd;
+            size_t mGrainSize;
+            size_t mNumChunks;
+            /// Whether requests were posted to process chunks
+            bool mQueued;
+            AtomicScalar<size_t> mNextChunk;
+            AtomicScalar<size_t> mNumChunksLeft;
+            AtomicScalar<uint32> mRefCount;
+            OGRE_MUTEX(mMutex);
+            OGRE_THREAD_SYNCHRONISER(mDoneSync);
+
+            Batch(Task* task, size_t begin, size_t end, size_t grainSize, bool queued);
+            /// Processes chunks until none are left to claim
+            void work();
+            /// Blocks until all the chunks were processed
+            void waitDone();
+            void addRef() { ++mRefCount; }
+            void release();
+        };
+
+        /** The data of the requests posted for a batch, holding a reference to it.
+        @remarks
+            The reference goes with the request however the queue disposes of
+            it, even when it is never processed.
+        */
+        struct BatchRef
+        {
+            Batch* mBatch;
+
+            explicit BatchRef(Batch* batch) : mBatch(batch) { mBatch->addRef(); }
+            BatchRef(const BatchRef& other) : mBatch(other.mBatch) { mBatch->addRef(); }
+            ~BatchRef() { mBatch->release(); }
+
+            /// Needed to be held by Any
+            friend std::ostream& operator<<(std::ostream& o, const BatchRef& ref)
+            {
+                return o << "TaskGroup::Batch " << ref.mBatch;
+            }
+
+        private:
+            BatchRef& operator=(const BatchRef&);
+        };
+        typedef vector<Batch*>::type BatchList;
+
+        String mName;
+        TaskScheduler* mScheduler;
+        BatchList mBatches;
+
+    private:
+        TaskGroup(const TaskGroup&);
+        TaskGroup& operator=(const TaskGroup&);
+    };
+
+    /** Calls func(chunkBegin, chunkEnd) over chunks of [begin, end) in
+        parallel, and returns once all of them were processed.
+    @remarks
+        Runs on Root's TaskScheduler, with the calling thread taking part.
+    @param begin, end The range of items to process
+    @param grainSize Number of items per chunk, see TaskGroup::run
+    @param func Functor called with each chunk, concurrently
+    @param name Name the call is profiled under
+    */
+    template<class Func> void parallelFor(size_t begin, size_t end, size_t grainSize,
+        const Func& func, const String& name = "parallelFor")
+    {
+        FunctorTask<Func> task(func);
+        TaskGroup group(name);
+        group.run(&task, begin, end, grainSize);
+        group.wait();
+    }
+    /** @} */
+    /** @} */
+
+}
+
+#include "OgreHeaderSuffix.h"
+
+#endif
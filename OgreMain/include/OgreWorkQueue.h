@@ -84,6 +84,7 @@ namespace Ogre
         class _OgreExport Request : public UtilityAlloc
         {
             friend class WorkQueue;
+            friend class StealingWorkQueue;
         protected:
             /// The request channel, as an integer 
             uint16 mChannel;
@@ -97,6 +98,8 @@ namespace Ogre
             RequestID mID;
             /// Abort Flag
             mutable bool mAborted;
+            /// Next request in the lock-free queues of StealingWorkQueue
+            Request* mNextQueued;
 
         public:
             /// Constructor 
@@ -130,6 +133,8 @@ namespace Ogre
             String mMessages;
             /// Data associated with the result of the process
             Any mData;
+            /// Next response in the lock-free queue of StealingWorkQueue
+            Response* mNextQueued;
 
         public:
             Response(const Request* rq, bool success, const Any& data, const String& msg = BLANKSTRING);
@@ -227,7 +232,19 @@ namespace Ogre
             down and restart.
         */
         virtual void startup(bool forceRestart = true) = 0;
-        /** Add a request handler instance to the queue. 
+        /** Get the number of worker threads processing requests concurrently.
+        @remarks
+            Used to decide how many requests to split parallel work into (see
+            TaskGroup), the default assumes a single worker.
+        */
+        virtual size_t getWorkerThreadCount() const { return 1; }
+        /** Returns whether worker threads are processing requests.
+        @remarks
+            False before startup() and once shutdown() was called, when requests
+            added would wait in the queue. TaskGroup then does the work itself.
+        */
+        virtual bool isRunning() const { return true; }
+        /** Add a request handler instance to the queue.
         @remarks
             Every queue must have at least one request handler instance for each 
             channel in which requests are raised. If you 
@@ -273,6 +290,22 @@ namespace Ogre
         virtual RequestID addRequest(uint16 channel, uint16 requestType, const Any& rData, uint8 retryCount = 0, 
             bool forceSynchronous = false, bool idleThread = false) = 0;
 
+        /** Add many requests of the same channel and type to the queue at once.
+        @remarks
+            The default implementation calls addRequest for each of them; implementations
+            may queue them at a lower cost per request.
+        @param channel The channel these requests will go into
+        @param requestType The type of these requests within the channel
+        @param rData Array of count items, the data of each request
+        @param count The number of requests to add
+        @param retryCount The number of times each request should be retried
+            if it fails.
+        @param outIDs Optional array of count items receiving the IDs of the requests,
+            0 for those which were not added.
+        */
+        virtual void addRequests(uint16 channel, uint16 requestType, const Any* rData, size_t count,
+            uint8 retryCount = 0, RequestID* outIDs = 0);
+
         /** Abort a previously issued request.
         If the request is still waiting to be processed, it will be 
         removed from the queue.
@@ -422,6 +455,9 @@ namespace Ogre
         /** Returns whether the queue is trying to shut down. */
         virtual bool isShuttingDown() const { return mShuttingDown; }
 
+        /// @copydoc WorkQueue::isRunning
+        virtual bool isRunning() const { return mIsRunning && !mShuttingDown; }
+
         /// @copydoc WorkQueue::addRequestHandler
         virtual void addRequestHandler(uint16 channel, RequestHandler* rh);
         /// @copydoc WorkQueue::removeRequestHandler
@@ -492,18 +528,38 @@ namespace Ogre
         class _OgreExport RequestHandlerHolder : public UtilityAlloc
         {
         protected:
-            OGRE_RW_MUTEX(mRWMutex);
+            // Only guards the handler pointer and active threads, not the calls to the
+            // handler, as a read lock is exclusive with some thread providers
+            OGRE_MUTEX(mMutex);
+            OGRE_THREAD_SYNCHRONISER(mIdleSync);
             RequestHandler* mHandler;
+#if OGRE_THREAD_SUPPORT
+            /// Threads processing a request with the handler, once per request
+            vector<OGRE_THREAD_ID_TYPE>::type mActiveThreads;
+#endif
         public:
             RequestHandlerHolder(RequestHandler* handler)
                 : mHandler(handler) {}
 
-            // Disconnect the handler to allow it to be destroyed
+            /** Disconnect the handler to allow it to be destroyed
+            @remarks
+                Waits for the requests other threads are processing with the handler.
+                A handler may remove itself while processing a request, in which case
+                it must not be destroyed before that request returns.
+            */
             void disconnectHandler()
             {
-                // write lock - must wait for all requests to finish
-                OGRE_LOCK_RW_MUTEX_WRITE(mRWMutex);
+                OGRE_LOCK_MUTEX_NAMED(mMutex, lock);
                 mHandler = 0;
+#if OGRE_THREAD_SUPPORT
+                // The requests of this thread are further up its stack
+                OGRE_THREAD_ID_TYPE self = OGRE_THREAD_CURRENT_ID;
+                while (static_cast<size_t>(std::count(mActiveThreads.begin(), mActiveThreads.end(), self))
+                    != mActiveThreads.size())
+                {
+                    OGRE_THREAD_WAIT(mIdleSync, mMutex, lock);
+                }
+#endif
             }
 
             /** Get handler pointer - note, only use this for == comparison or similar,
@@ -516,20 +572,48 @@ namespace Ogre
             */
             Response* handleRequest(const Request* req, const WorkQueue* srcQ)
             {
-                // Read mutex so that multiple requests can be processed by the
-                // same handler in parallel if required
-                OGRE_LOCK_RW_MUTEX_READ(mRWMutex);
+                // Track the request rather than holding the lock, so that multiple
+                // requests can be processed by the same handler in parallel if required
+                RequestHandler* handler;
+                {
+                    OGRE_LOCK_MUTEX(mMutex);
+                    handler = mHandler;
+                    if (!handler)
+                        return 0;
+#if OGRE_THREAD_SUPPORT
+                    mActiveThreads.push_back(OGRE_THREAD_CURRENT_ID);
+#endif
+                }
                 Response* response = 0;
-                if (mHandler)
+                try
                 {
-                    if (mHandler->canHandleRequest(req, srcQ))
+                    if (handler->canHandleRequest(req, srcQ))
                     {
-                        response = mHandler->handleRequest(req, srcQ);
+                        response = handler->handleRequest(req, srcQ);
                     }
                 }
+                catch (...)
+                {
+                    finishRequest();
+                    throw;
+                }
+                finishRequest();
                 return response;
             }
 
+        protected:
+            void finishRequest()
+            {
+#if OGRE_THREAD_SUPPORT
+                OGRE_LOCK_MUTEX(mMutex);
+                mActiveThreads.erase(std::find(mActiveThreads.begin(), mActiveThreads.end(),
+                    OGRE_THREAD_CURRENT_ID));
+                // Only waited on once disconnected
+                if (!mHandler)
+                    OGRE_THREAD_NOTIFY_ALL(mIdleSync);
+#endif
+            }
+
         };
         // Hold these by shared pointer so they can be copied keeping same instance
         typedef SharedPtr<RequestHandlerHolder> RequestHandlerHolderPtr;
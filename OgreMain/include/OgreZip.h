@@ -193,6 +193,151 @@ namespace Ogre {
 
     };
 
+    class ZipBufferPool;
+
+    /** Specialisation of the Archive class reading zip files through a
+        memory mapping, rather than through zziplib.
+    @remarks
+        The central directory is parsed once on load into a hash index, so
+        opening a file is a lookup rather than a scan of the directory.
+        Stored (uncompressed) files are returned as streams viewing the mapping
+        directly, without any copy, and deflated files are inflated in one go
+        into a buffer recycled from a pool, so serializers can seek freely in
+        either. Archives over 4GB are supported through the zip64 extensions.
+    @par
+        The index is never modified once read, unloading the archive only drops
+        it. Opening a file holds the lock just long enough to take a reference
+        to the index, so several threads can inflate files concurrently, see
+        openMultiple. The streams keep the mapping alive and remain valid after
+        the archive was unloaded.
+    @note
+        Encrypted files and compression methods other than deflate are not
+        supported.
+    */
+    class _OgreExport MappedZipArchive : public Archive
+    {
+    protected:
+        /// Where the data of a file is in the archive
+        struct Entry
+        {
+            /// Offset of the local file header
+            uint64 headerOffset;
+            uint64 compressedSize;
+            uint64 uncompressedSize;
+            uint16 method;
+            uint16 flags;
+        };
+        typedef vector<Entry>::type EntryList;
+        /// Maps the lookup key of a name to the index of its entry, or -1 if ambiguous
+        typedef OGRE_HashMap<String, size_t> EntryIndex;
+
+        /// The contents of a loaded archive, left untouched once read
+        struct Directory : public ArchiveAlloc
+        {
+            /// The mapping of the whole zip file
+            MemoryDataStreamPtr mMapping;
+            /// Buffers deflated files are inflated to, shared with the streams
+            SharedPtr<ZipBufferPool> mBufferPool;
+            /// File list, in the order of the central directory
+            FileInfoList mFileList;
+            /// Location of the data of each file, by index in the file list
+            EntryList mEntries;
+            /// Index of the files by full name
+            EntryIndex mIndex;
+#if !OGRE_RESOURCEMANAGER_STRICT
+            /// Index of the files by base name, to find them without their path
+            EntryIndex mBaseNameIndex;
+#endif
+        };
+        typedef SharedPtr<Directory> DirectoryPtr;
+
+        /// The contents, replaced rather than modified by load and unload
+        DirectoryPtr mDirectory;
+
+        OGRE_AUTO_MUTEX;
+
+        /** Gets the contents, which stay valid while referenced even if the
+            archive is unloaded meanwhile. Empty if the archive is not loaded.
+        */
+        DirectoryPtr getDirectory() const;
+        /// Reads the central directory into the file list and index
+        void readCentralDirectory(Directory& dir);
+        /// Gets the key a name is indexed by
+        String getLookupKey(const String& filename) const;
+        /// Finds the index of the entry of a file, or -1 if there is none
+        size_t findEntry(const Directory& dir, const String& filename) const;
+        /// Gets the data of an entry in the mapping, checking it lies within the file
+        const uchar* getEntryData(const Directory& dir, const Entry& entry, const String& filename) const;
+        /// Creates a stream for an entry, inflating it if needed
+        DataStreamPtr openEntry(const Directory& dir, size_t index, const String& filename) const;
+
+    public:
+        MappedZipArchive(const String& name, const String& archType);
+        ~MappedZipArchive();
+        /// @copydoc Archive::isCaseSensitive
+        bool isCaseSensitive(void) const { return OGRE_RESOURCEMANAGER_STRICT; }
+
+        /// @copydoc Archive::load
+        void load();
+        /// @copydoc Archive::unload
+        void unload();
+
+        /// @copydoc Archive::open
+        DataStreamPtr open(const String& filename, bool readOnly = true) const;
+
+        /** Opens several files at once, inflating them in parallel.
+        @remarks
+            The files are inflated on the worker threads of Root's TaskScheduler,
+            which pays off for big packs of compressed files.
+        @param filenames The files to open
+        @param streams Receives a stream for each file, in the same order
+        @note Throws an exception if one of the files can't be opened.
+        */
+        void openMultiple(const StringVector& filenames, vector<DataStreamPtr>::type& streams) const;
+
+        /// @copydoc Archive::create
+        DataStreamPtr create(const String& filename);
+
+        /// @copydoc Archive::remove
+        void remove(const String& filename);
+
+        /// @copydoc Archive::list
+        StringVectorPtr list(bool recursive = true, bool dirs = false) const;
+
+        /// @copydoc Archive::listFileInfo
+        FileInfoListPtr listFileInfo(bool recursive = true, bool dirs = false) const;
+
+        /// @copydoc Archive::find
+        StringVectorPtr find(const String& pattern, bool recursive = true,
+            bool dirs = false) const;
+
+        /// @copydoc Archive::findFileInfo
+        FileInfoListPtr findFileInfo(const String& pattern, bool recursive = true,
+            bool dirs = false) const;
+
+        /// @copydoc Archive::exists
+        bool exists(const String& filename) const;
+
+        /// @copydoc Archive::getModifiedTime
+        time_t getModifiedTime(const String& filename) const;
+    };
+
+    /** Specialisation of ZipArchiveFactory creating MappedZipArchive instances
+        where files can be memory mapped, and ZipArchive ones elsewhere.
+    @remarks
+        Registered as the "MappedZip" archive type, so that resource locations
+        opt in to it; "Zip" remains handled by ZipArchive.
+    */
+    class _OgrePrivate MappedZipArchiveFactory : public ZipArchiveFactory
+    {
+    public:
+        virtual ~MappedZipArchiveFactory() {}
+        /// @copydoc FactoryObj::getType
+        const String& getType(void) const;
+        /// @copydoc FactoryObj::createInstance
+        Archive *createInstance( const String& name, bool readOnly );
+    };
+
     /** @} */
     /** @} */
 
@@ -0,0 +1,352 @@
+/*-------------------------------------------------------------------------
+This source file is a part of OGRE
+(Object-oriented Graphics Rendering Engine)
+
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+-------------------------------------------------------------------------*/
+#ifndef __OgreStealingWorkQueue_H__
+#define __OgreStealingWorkQueue_H__
+
+#include "../OgreWorkQueue.h"
+
+#include <atomic>
+
+namespace Ogre
+{
+    /** \addtogroup Core
+    *  @{
+    */
+    /** \addtogroup General
+    *  @{
+    */
+    /** Work queue where each worker thread has its own queue of requests, and
+        steals from the others when it runs out.
+    @remarks
+        DefaultWorkQueue keeps every request in a single queue guarded by mutexes
+        which all worker threads and submitters contend on. Here requests added from
+        outside the worker threads are spread over per worker inboxes, which are
+        lock-free stacks, and moved by their worker into a lock-free deque the other
+        workers can steal from. Requests added from a worker thread (e.g. by a request
+        handler) go straight into its deque. Responses are pushed onto a lock-free
+        stack drained by processResponses. The mutexes left are only taken by idle
+        workers going to sleep, by changes to the handlers and by aborts.
+    @par
+        Each worker takes its requests in the order they were added; as with
+        DefaultWorkQueue, requests processed by different workers may complete in
+        any order. Use addRequests to queue many small requests at once.
+    @par
+        Aborting a request which is already being processed does not set its abort
+        flag until its response is processed, so request handlers can't poll for it.
+        Requests are not logged individually, as that would serialise them on the log.
+    */
+    class _OgreExport StealingWorkQueue : public WorkQueue
+    {
+    public:
+        /** Constructor.
+            Call startup() to initialise.
+        @param name Optional name, just helps to identify logging output
+        */
+        StealingWorkQueue(const String& name = BLANKSTRING);
+        virtual ~StealingWorkQueue();
+
+        /// Get the name of the work queue
+        const String& getName() const { return mName; }
+
+        /** Get the number of worker threads that this queue will start when
+            startup() is called.
+        */
+        virtual size_t getWorkerThreadCount() const { return mWorkerThreadCount; }
+
+        /** Set the number of worker threads that this queue will start
+            when startup() is called (default 1).
+            Calling this will have no effect unless the queue is shut down and
+            restarted.
+        */
+        void setWorkerThreadCount(size_t c) { mWorkerThreadCount = c; }
+
+        /** Get whether worker threads will be allowed to access render system
+            resources, see DefaultWorkQueueBase::setWorkersCanAccessRenderSystem.
+        */
+        bool getWorkersCanAccessRenderSystem() const { return mWorkerRenderSystemAccess; }
+
+        /** Set whether worker threads will be allowed to access render system
+            resources, see DefaultWorkQueueBase::setWorkersCanAccessRenderSystem.
+            Calling this will have no effect unless the queue is shut down and
+            restarted.
+        */
+        void setWorkersCanAccessRenderSystem(bool access) { mWorkerRenderSystemAccess = access; }
+
+        /** Process the next request on the queue, if any.
+        @remarks
+            Only intended for advanced users driving the processing from their own
+            threads. The calling thread steals the request from the workers' queues.
+        @return
+            Whether a request was processed.
+        */
+        bool _processNextRequest();
+
+        /// Main function of the worker thread workerIndex.
+        void _threadMain(size_t workerIndex);
+
+        /** Returns whether the queue is trying to shut down. */
+        bool isShuttingDown() const { return mShuttingDown.load(std::memory_order_relaxed); }
+
+        /// @copydoc WorkQueue::isRunning
+        virtual bool isRunning() const { return mIsRunning && !isShuttingDown(); }
+
+        /// @copydoc WorkQueue::startup
+        virtual void startup(bool forceRestart = true);
+        /// @copydoc WorkQueue::shutdown
+        virtual void shutdown();
+        /// @copydoc WorkQueue::addRequestHandler
+        virtual void addRequestHandler(uint16 channel, RequestHandler* rh);
+        /// @copydoc WorkQueue::removeRequestHandler
+        virtual void removeRequestHandler(uint16 channel, RequestHandler* rh);
+        /// @copydoc WorkQueue::addResponseHandler
+        virtual void addResponseHandler(uint16 channel, ResponseHandler* rh);
+        /// @copydoc WorkQueue::removeResponseHandler
+        virtual void removeResponseHandler(uint16 channel, ResponseHandler* rh);
+        /// @copydoc WorkQueue::addRequest
+        virtual RequestID addRequest(uint16 channel, uint16 requestType, const Any& rData, uint8 retryCount = 0,
+            bool forceSynchronous = false, bool idleThread = false);
+        /** Add many requests of the same channel and type to the queue at once.
+        @remarks
+            The requests get consecutive IDs and are split into one batch per worker,
+            each queued with a single atomic operation.
+        @see WorkQueue::addRequests
+        */
+        virtual void addRequests(uint16 channel, uint16 requestType, const Any* rData, size_t count,
+            uint8 retryCount = 0, RequestID* outIDs = 0);
+        /// @copydoc WorkQueue::abortRequest
+        virtual void abortRequest(RequestID id);
+        /// @copydoc WorkQueue::abortRequestsByChannel
+        virtual void abortRequestsByChannel(uint16 channel);
+        /// @copydoc WorkQueue::abortPendingRequestsByChannel
+        virtual void abortPendingRequestsByChannel(uint16 channel);
+        /// @copydoc WorkQueue::abortAllRequests
+        virtual void abortAllRequests();
+        /// @copydoc WorkQueue::setPaused
+        virtual void setPaused(bool pause);
+        /// @copydoc WorkQueue::isPaused
+        virtual bool isPaused() const { return mPaused.load(std::memory_order_relaxed); }
+        /// @copydoc WorkQueue::setRequestsAccepted
+        virtual void setRequestsAccepted(bool accept) { mAcceptRequests.store(accept); }
+        /// @copydoc WorkQueue::getRequestsAccepted
+        virtual bool getRequestsAccepted() const { return mAcceptRequests.load(std::memory_order_relaxed); }
+        /// @copydoc WorkQueue::processResponses
+        virtual void processResponses();
+        /// @copydoc WorkQueue::getResponseProcessingTimeLimit
+        virtual unsigned long getResponseProcessingTimeLimit() const { return mResponseTimeLimitMS; }
+        /// @copydoc WorkQueue::setResponseProcessingTimeLimit
+        virtual void setResponseProcessingTimeLimit(unsigned long ms) { mResponseTimeLimitMS = ms; }
+
+    protected:
+        /// Queues of a worker thread, defined in the source file
+        struct Worker;
+        typedef vector<Worker*>::type WorkerList;
+
+        /// Thread function
+        struct _OgreExport WorkerFunc OGRE_THREAD_WORKER_INHERIT
+        {
+            StealingWorkQueue* mQueue;
+            size_t mIndex;
+
+            WorkerFunc(StealingWorkQueue* q, size_t index)
+                : mQueue(q), mIndex(index) {}
+
+            void operator()();
+
+            void operator()() const;
+
+            void run();
+        };
+        typedef vector<WorkerFunc*>::type WorkerFuncList;
+
+        /** Request handler which can be disconnected while other threads may be
+            using it, without them taking a lock to call it.
+        */
+        struct RequestHandlerHolder
+        {
+            std::atomic<RequestHandler*> mHandler;
+            /// Number of threads currently calling mHandler
+            std::atomic<size_t> mActiveCount;
+
+            RequestHandlerHolder(RequestHandler* handler)
+                : mHandler(handler), mActiveCount(0) {}
+            /** Waits for the other threads calling the handler to be done with it
+            @remarks
+                The handler may remove itself while handling a request, it must then
+                stay alive until that request returns.
+            */
+            void disconnectHandler();
+            /** Process a request if possible.
+            @return Valid response if processed, null otherwise
+            */
+            Response* handleRequest(const Request* req, const WorkQueue* srcQ);
+        };
+        typedef vector<RequestHandlerHolder*>::type RequestHandlerList;
+        /// Never modified once published, so it can be read without locking
+        typedef map<uint16, RequestHandlerList>::type RequestHandlerListByChannel;
+        typedef list<ResponseHandler*>::type ResponseHandlerList;
+        typedef map<uint16, ResponseHandlerList>::type ResponseHandlerListByChannel;
+
+        /// Requests matched by an abort, see isAborted
+        struct AbortRecord
+        {
+            /// Requests up to this ID, those added later are not aborted
+            RequestID maxID;
+            /// Only this request if not 0
+            RequestID id;
+            /// Only requests of this channel if any
+            bool anyChannel;
+            uint16 channel;
+            /// Only requests which are not processed yet
+            bool pendingOnly;
+        };
+        typedef vector<AbortRecord>::type AbortRecordList;
+
+        /// Handler map or holder nothing refers to anymore, see reclaimRequestHandlers
+        struct RetiredRequestHandlers
+        {
+            /// Value of mHandlerEpoch when it was retired
+            size_t epoch;
+            RequestHandlerListByChannel* handlers;
+            RequestHandlerHolder* holder;
+        };
+        typedef vector<RetiredRequestHandlers>::type RetiredRequestHandlersList;
+
+        /// Requests are counted per channel modulo this, see processResponses
+        static const size_t NUM_CHANNEL_BUCKETS = 64;
+
+        String mName;
+        size_t mWorkerThreadCount;
+        bool mWorkerRenderSystemAccess;
+        bool mIsRunning;
+        unsigned long mResponseTimeLimitMS;
+
+        std::atomic<bool> mPaused;
+        std::atomic<bool> mAcceptRequests;
+        std::atomic<bool> mShuttingDown;
+        std::atomic<RequestID> mRequestCount;
+
+        /// Queues of the workers, at least one even without threads
+        WorkerList mWorkers;
+        /// Worker the next request from outside the workers goes to
+        std::atomic<size_t> mNextWorker;
+        /// Upper bound of the requests in the workers' queues and mIdleRequests
+        std::atomic<size_t> mNumQueuedRequests;
+        /// Requests added but whose response is not processed yet
+        std::atomic<size_t> mNumOutstandingRequests;
+        /// The same, of the channels falling into each bucket
+        std::atomic<size_t> mNumOutstandingByChannel[NUM_CHANNEL_BUCKETS];
+
+        /// Stack of requests to process one at a time in order, see addRequest
+        std::atomic<Request*> mIdleRequests;
+        /// Whether a thread is processing the idle requests
+        std::atomic<bool> mIdleThreadRunning;
+
+        /// Stack of responses pushed by the workers
+        std::atomic<Response*> mResponses;
+        /// Responses taken from mResponses and left to process, main thread only
+        typedef deque<Response*>::type ResponseQueue;
+        ResponseQueue mPendingResponses;
+
+        std::atomic<RequestHandlerListByChannel*> mRequestHandlers;
+        /// Threads reading mRequestHandlers, by the parity of the epoch they started in
+        std::atomic<size_t> mHandlerReaders[2];
+        /// Advanced once the readers of the previous epoch are done, see reclaimRequestHandlers
+        std::atomic<size_t> mHandlerEpoch;
+        /// Number of entries of mRetiredRequestHandlers, read without locking
+        std::atomic<size_t> mNumRetiredRequestHandlers;
+        /// Previously published handler maps and disconnected holders, deleted when unused
+        RetiredRequestHandlersList mRetiredRequestHandlers;
+        OGRE_MUTEX(mRequestHandlerMutex);
+        ResponseHandlerListByChannel mResponseHandlers;
+
+        AbortRecordList mAbortRecords;
+        /// Highest AbortRecord::maxID, requests with a higher ID need no checking
+        std::atomic<RequestID> mMaxAbortedID;
+        OGRE_MUTEX(mAbortMutex);
+
+        /// Number of workers sleeping in waitForRequests
+        std::atomic<size_t> mNumWaitingWorkers;
+        OGRE_MUTEX(mWaitMutex);
+        OGRE_THREAD_SYNCHRONISER(mWaitCondition);
+
+        size_t mNumThreadsRegisteredWithRS;
+        OGRE_MUTEX(mInitMutex);
+        OGRE_THREAD_SYNCHRONISER(mInitSync);
+
+        WorkerFuncList mWorkerFuncs;
+#if OGRE_THREAD_SUPPORT
+        typedef vector<OGRE_THREAD_TYPE*>::type WorkerThreadList;
+        WorkerThreadList mWorkerThreads;
+#endif
+
+        /// Sets the number of worker queues, moving the requests they hold over
+        void resizeWorkers(size_t numWorkers);
+        /// Gets the worker run by the calling thread, null if it is not one of ours
+        Worker* getCurrentWorker() const;
+        /** Queues numRequests requests chained through Request::mNextQueued from the
+            newest to the oldest.
+        */
+        void queueRequests(Request* newest, Request* oldest, size_t numRequests);
+        /// Pushes a chain of requests, newest first, onto a lock-free stack
+        static void pushRequests(std::atomic<Request*>& stack, Request* newest, Request* oldest);
+        /// Reverses a chain of requests, returning its new first request
+        static Request* reverseRequests(Request* first);
+        /// Pushes a chain of requests, newest first, into the deque of a worker
+        void pushToDeque(Worker* worker, Request* newest);
+        /// Takes the next request from the worker or steals one, null if there is none
+        Request* takeRequest(Worker* self);
+        /// Whether a sleeping worker should wake up
+        bool hasRequests() const;
+        /// Processes the idle requests if no other thread is, returns whether there were any
+        bool processIdleRequests();
+        /// Suspends a worker thread until there may be requests to process
+        void waitForRequests();
+        /// Wakes up sleeping workers after requests were queued
+        void notifyWorkers(bool all);
+        /// Whether the request is aborted, setting its abort flag if so
+        bool isAborted(const Request* r, bool processed);
+        void addAbortRecord(RequestID id, bool anyChannel, uint16 channel, bool pendingOnly);
+        void processRequestResponse(Request* r, bool synchronous);
+        Response* processRequest(Request* r);
+        void processResponse(Response* r);
+        /// Publishes a new map of request handlers, retiring holder if given
+        void setRequestHandlers(RequestHandlerListByChannel* handlers, RequestHandlerHolder* holder = 0);
+        /** Deletes the retired handler maps and holders no thread can refer to anymore.
+            Must be called with mRequestHandlerMutex locked.
+        */
+        void reclaimRequestHandlers();
+        /// Index of mNumOutstandingByChannel for a channel
+        static size_t getChannelBucket(uint16 channel) { return channel % NUM_CHANNEL_BUCKETS; }
+        /// Counts numRequests requests of a channel as outstanding, before they get IDs
+        void addOutstandingRequests(uint16 channel, size_t numRequests);
+        /// Counts a request of a channel as done
+        void removeOutstandingRequest(uint16 channel);
+    };
+    /** @} */
+    /** @} */
+}
+
+#endif
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgreNode.h"
 #include "OgreMesh.h"
 #include "OgreException.h"
+#include "OgreCompressedTransformKeyFrames.h"
 
 namespace Ogre {
 
@@ -44,6 +45,35 @@ namespace Ogre {
                 return kf->getTime() < kf2->getTime();
             }
         };
+
+        /** Whether interpolating linearly between the keyframes first and last
+            reproduces the ones between them within tolerance. */
+        bool interpolatesWithinTolerance(const vector<KeyFrame*>::type& keyFrames, size_t first,
+            size_t last, bool spherical, bool shortestPath, Real translateTolerance,
+            const Radian& rotationTolerance, Real scaleTolerance)
+        {
+            const TransformKeyFrame* k1 = static_cast<const TransformKeyFrame*>(keyFrames[first]);
+            const TransformKeyFrame* k2 = static_cast<const TransformKeyFrame*>(keyFrames[last]);
+            for (size_t i = first + 1; i < last; ++i)
+            {
+                const TransformKeyFrame* kf = static_cast<const TransformKeyFrame*>(keyFrames[i]);
+                Real t = (kf->getTime() - k1->getTime()) / (k2->getTime() - k1->getTime());
+
+                Vector3 translate = k1->getTranslate() + (k2->getTranslate() - k1->getTranslate()) * t;
+                Vector3 scale = k1->getScale() + (k2->getScale() - k1->getScale()) * t;
+                Quaternion rotation = spherical ?
+                    Quaternion::Slerp(t, k1->getRotation(), k2->getRotation(), shortestPath) :
+                    Quaternion::nlerp(t, k1->getRotation(), k2->getRotation(), shortestPath);
+
+                if (!translate.positionEquals(kf->getTranslate(), translateTolerance) ||
+                    !scale.positionEquals(kf->getScale(), scaleTolerance) ||
+                    CompressedTransformKeyFrames::getRotationError(rotation, kf->getRotation()) > rotationTolerance)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
     }
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
@@ -357,7 +387,7 @@ namespace Ogre {
     NodeAnimationTrack::NodeAnimationTrack(Animation* parent, unsigned short handle)
         : AnimationTrack(parent, handle), mTargetNode(0)
         , mSplines(0), mSplineBuildNeeded(false)
-        , mUseShortestRotationPath(true)
+        , mUseShortestRotationPath(true), mCompressed(0)
     {
     }
     //---------------------------------------------------------------------
@@ -365,13 +395,14 @@ namespace Ogre {
         Node* targetNode)
         : AnimationTrack(parent, handle), mTargetNode(targetNode)
         , mSplines(0), mSplineBuildNeeded(false)
-        , mUseShortestRotationPath(true)
+        , mUseShortestRotationPath(true), mCompressed(0)
     {
     }
     //---------------------------------------------------------------------
     NodeAnimationTrack::~NodeAnimationTrack()
     {
         OGRE_DELETE_T(mSplines, Splines, MEMCATEGORY_ANIMATION);
+        OGRE_DELETE mCompressed;
     }
     //---------------------------------------------------------------------
     void NodeAnimationTrack::getInterpolatedKeyFrame(const TimeIndex& timeIndex, KeyFrame* kf) const
@@ -385,13 +416,25 @@ namespace Ogre {
         TransformKeyFrame* kret = static_cast<TransformKeyFrame*>(kf);
 
         // Keyframe pointers
-        KeyFrame *kBase1, *kBase2;
         TransformKeyFrame *k1, *k2;
         unsigned short firstKeyIndex;
+        Real t;
 
-        Real t = this->getKeyFramesAtTime(timeIndex, &kBase1, &kBase2, &firstKeyIndex);
-        k1 = static_cast<TransformKeyFrame*>(kBase1);
-        k2 = static_cast<TransformKeyFrame*>(kBase2);
+        // Compressed keyframes are decoded into these
+        TransformKeyFrame decoded1(0, 0), decoded2(0, 0);
+        if (mCompressed)
+        {
+            t = getKeyFrameTransformsAtTime(timeIndex, &decoded1, &decoded2, &firstKeyIndex);
+            k1 = &decoded1;
+            k2 = &decoded2;
+        }
+        else
+        {
+            KeyFrame *kBase1, *kBase2;
+            t = this->getKeyFramesAtTime(timeIndex, &kBase1, &kBase2, &firstKeyIndex);
+            k1 = static_cast<TransformKeyFrame*>(kBase1);
+            k2 = static_cast<TransformKeyFrame*>(kBase2);
+        }
 
         if (t == 0.0)
         {
@@ -478,7 +521,7 @@ namespace Ogre {
         Real scl)
     {
         // Nothing to do if no keyframes or zero weight or no node
-        if (mKeyFrames.empty() || !weight || !node)
+        if (!getNumKeyFrames() || !weight || !node)
             return;
 
         TransformKeyFrame kf(0, timeIndex.getTimePos());
@@ -536,14 +579,14 @@ namespace Ogre {
         splines->rotationSpline.clear();
         splines->scaleSpline.clear();
 
-        KeyFrameList::const_iterator i, iend;
-        iend = mKeyFrames.end(); // precall to avoid overhead
-        for (i = mKeyFrames.begin(); i != iend; ++i)
+        TransformKeyFrame kf(0, 0);
+        unsigned short numKeyFrames = getNumKeyFrames(); // precall to avoid overhead
+        for (unsigned short i = 0; i < numKeyFrames; ++i)
         {
-            TransformKeyFrame* kf = static_cast<TransformKeyFrame*>(*i);
-            splines->positionSpline.addPoint(kf->getTranslate());
-            splines->rotationSpline.addPoint(kf->getRotation());
-            splines->scaleSpline.addPoint(kf->getScale());
+            getNodeKeyFrameTransform(i, &kf);
+            splines->positionSpline.addPoint(kf.getTranslate());
+            splines->rotationSpline.addPoint(kf.getRotation());
+            splines->scaleSpline.addPoint(kf.getScale());
         }
 
         splines->positionSpline.recalcTangents();
@@ -573,18 +616,19 @@ namespace Ogre {
     //---------------------------------------------------------------------
     bool NodeAnimationTrack::hasNonZeroKeyFrames(void) const
     {
-        KeyFrameList::const_iterator i = mKeyFrames.begin();
-        for (; i != mKeyFrames.end(); ++i)
+        TransformKeyFrame kf(0, 0);
+        unsigned short numKeyFrames = getNumKeyFrames();
+        for (unsigned short i = 0; i < numKeyFrames; ++i)
         {
             // look for keyframes which have any component which is non-zero
             // Since exporters can be a little inaccurate sometimes we use a
             // tolerance value rather than looking for nothing
-            TransformKeyFrame* kf = static_cast<TransformKeyFrame*>(*i);
-            Vector3 trans = kf->getTranslate();
-            Vector3 scale = kf->getScale();
+            getNodeKeyFrameTransform(i, &kf);
+            Vector3 trans = kf.getTranslate();
+            Vector3 scale = kf.getScale();
             Vector3 axis;
             Radian angle;
-            kf->getRotation().ToAngleAxis(angle, axis);
+            kf.getRotation().ToAngleAxis(angle, axis);
             Real tolerance = 1e-3f;
             if (!trans.positionEquals(Vector3::ZERO, tolerance) ||
                 !scale.positionEquals(Vector3::UNIT_SCALE, tolerance) ||
@@ -600,6 +644,10 @@ namespace Ogre {
     //---------------------------------------------------------------------
     void NodeAnimationTrack::optimise(void)
     {
+        // Compression already dropped the keyframes interpolation reproduces
+        if (mCompressed)
+            return;
+
         // Eliminate duplicate keyframes from 2nd to penultimate keyframe
         // NB only eliminate middle keys from sequences of 5+ identical keyframes
         // since we need to preserve the boundary keys in place, and we need
@@ -657,6 +705,12 @@ namespace Ogre {
     //--------------------------------------------------------------------------
     KeyFrame* NodeAnimationTrack::createKeyFrameImpl(Real time)
     {
+        if (mCompressed)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALID_STATE,
+                "Compressed tracks can't be edited, decompress the track first",
+                "NodeAnimationTrack::createKeyFrameImpl");
+        }
         return OGRE_NEW TransformKeyFrame(this, time);
     }
     //--------------------------------------------------------------------------
@@ -669,19 +723,315 @@ namespace Ogre {
     {
         return static_cast<TransformKeyFrame*>(getKeyFrame(index));
     }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::getNodeKeyFrameTransform(unsigned short index, TransformKeyFrame* kf) const
+    {
+        if (mCompressed)
+        {
+            mCompressed->getKeyFrame(index, kf);
+        }
+        else
+        {
+            const TransformKeyFrame* src = static_cast<const TransformKeyFrame*>(getKeyFrame(index));
+            kf->setTranslate(src->getTranslate());
+            kf->setRotation(src->getRotation());
+            kf->setScale(src->getScale());
+        }
+    }
+    //--------------------------------------------------------------------------
+    Real NodeAnimationTrack::getNodeKeyFrameTime(unsigned short index) const
+    {
+        if (mCompressed)
+        {
+            assert(index < mCompressed->getNumKeyFrames());
+            return mCompressed->getTimes()[index];
+        }
+        return getKeyFrame(index)->getTime();
+    }
+    //--------------------------------------------------------------------------
+    Real NodeAnimationTrack::getKeyFrameTransformsAtTime(const TimeIndex& timeIndex,
+        TransformKeyFrame* keyFrame1, TransformKeyFrame* keyFrame2, unsigned short* firstKeyIndex) const
+    {
+        if (!mCompressed)
+        {
+            KeyFrame *k1, *k2;
+            Real t = getKeyFramesAtTime(timeIndex, &k1, &k2, firstKeyIndex);
+            const TransformKeyFrame* src1 = static_cast<const TransformKeyFrame*>(k1);
+            const TransformKeyFrame* src2 = static_cast<const TransformKeyFrame*>(k2);
+            keyFrame1->setTranslate(src1->getTranslate());
+            keyFrame1->setRotation(src1->getRotation());
+            keyFrame1->setScale(src1->getScale());
+            keyFrame2->setTranslate(src2->getTranslate());
+            keyFrame2->setRotation(src2->getRotation());
+            keyFrame2->setScale(src2->getScale());
+            return t;
+        }
+
+        unsigned short keyIndex1, keyIndex2;
+        Real t = getCompressedKeyFramesAtTime(timeIndex, &keyIndex1, &keyIndex2);
+        mCompressed->getKeyFrame(keyIndex1, keyFrame1);
+        mCompressed->getKeyFrame(keyIndex2, keyFrame2);
+        if (firstKeyIndex)
+            *firstKeyIndex = keyIndex1;
+        return t;
+    }
+    //--------------------------------------------------------------------------
+    Real NodeAnimationTrack::getCompressedKeyFramesAtTime(const TimeIndex& timeIndex,
+        unsigned short* keyIndex1, unsigned short* keyIndex2) const
+    {
+        const Real* times = mCompressed->getTimes();
+        const unsigned short numKeyFrames = mCompressed->getNumKeyFrames();
+        Real timePos = timeIndex.getTimePos();
+
+        // Find first keyframe after or on current time, as getKeyFramesAtTime
+        unsigned short i;
+        if (timeIndex.hasKeyIndex())
+        {
+            // Global keyframe index available, map to local keyframe index directly.
+            assert(timeIndex.getKeyIndex() < mKeyFrameIndexMap.size());
+            i = mKeyFrameIndexMap[timeIndex.getKeyIndex()];
+        }
+        else
+        {
+            // Wrap time
+            Real totalAnimationLength = mParent->getLength();
+            assert(totalAnimationLength > 0.0f && "Invalid animation length!");
+
+            if( timePos > totalAnimationLength && totalAnimationLength > 0.0f )
+                timePos = fmod( timePos, totalAnimationLength );
+
+            i = static_cast<unsigned short>(std::lower_bound(times, times + numKeyFrames, timePos) - times);
+        }
+
+        Real t2;
+        if (i == numKeyFrames)
+        {
+            // There is no keyframe after this time, wrap back to first
+            *keyIndex2 = 0;
+            t2 = mParent->getLength() + times[0];
+
+            // Use last keyframe as previous keyframe
+            --i;
+        }
+        else
+        {
+            *keyIndex2 = i;
+            t2 = times[i];
+
+            // Find last keyframe before or on current time
+            if (i != 0 && timePos < times[i])
+                --i;
+        }
+        *keyIndex1 = i;
+
+        Real t1 = times[i];
+        if (t1 == t2)
+        {
+            // Same KeyFrame (only one)
+            return 0.0;
+        }
+        else
+        {
+            return (timePos - t1) / (t2 - t1);
+        }
+    }
+    //--------------------------------------------------------------------------
+    unsigned short NodeAnimationTrack::getNumKeyFrames(void) const
+    {
+        return mCompressed ? mCompressed->getNumKeyFrames() : AnimationTrack::getNumKeyFrames();
+    }
+    //--------------------------------------------------------------------------
+    KeyFrame* NodeAnimationTrack::getKeyFrame(unsigned short index) const
+    {
+        if (mCompressed)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALID_STATE,
+                "Compressed tracks have no keyframe objects, use getNodeKeyFrameTransform",
+                "NodeAnimationTrack::getKeyFrame");
+        }
+        return AnimationTrack::getKeyFrame(index);
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::removeKeyFrame(unsigned short index)
+    {
+        if (mCompressed)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALID_STATE,
+                "Compressed tracks can't be edited, decompress the track first",
+                "NodeAnimationTrack::removeKeyFrame");
+        }
+        AnimationTrack::removeKeyFrame(index);
+    }
+    //--------------------------------------------------------------------------
+    Real NodeAnimationTrack::getKeyFramesAtTime(const TimeIndex& timeIndex, KeyFrame** keyFrame1,
+        KeyFrame** keyFrame2, unsigned short* firstKeyIndex) const
+    {
+        if (mCompressed)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALID_STATE,
+                "Compressed tracks have no keyframe objects, use getKeyFrameTransformsAtTime",
+                "NodeAnimationTrack::getKeyFramesAtTime");
+        }
+        return AnimationTrack::getKeyFramesAtTime(timeIndex, keyFrame1, keyFrame2, firstKeyIndex);
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::removeAllKeyFrames(void)
+    {
+        OGRE_DELETE mCompressed;
+        mCompressed = 0;
+        AnimationTrack::removeAllKeyFrames();
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::compress(Real translateTolerance, const Radian& rotationTolerance,
+        Real scaleTolerance)
+    {
+        if (mCompressed || mKeyFrames.empty())
+            return;
+
+        // Half of each tolerance for dropping keyframes and half for quantising
+        // the rest, interpolation doesn't add to the quantisation error
+        translateTolerance *= 0.5f;
+        Radian halfRotationTolerance = rotationTolerance * 0.5f;
+        scaleTolerance *= 0.5f;
+
+        // Splines pass through every keyframe, so they can only be quantised
+        const bool linear = mParent->getInterpolationMode() == Animation::IM_LINEAR;
+        const bool spherical = mParent->getRotationInterpolationMode() == Animation::RIM_SPHERICAL;
+
+        vector<Real>::type times;
+        vector<Vector3>::type translates, scales;
+        vector<Quaternion>::type rotations;
+        times.reserve(mKeyFrames.size());
+        translates.reserve(mKeyFrames.size());
+        rotations.reserve(mKeyFrames.size());
+        scales.reserve(mKeyFrames.size());
+
+        // Always keep the first and last keyframes, and any other which
+        // interpolating from the last one kept to the next can't replace
+        size_t lastKept = 0;
+        for (size_t i = 0; i < mKeyFrames.size(); ++i)
+        {
+            if (linear && i > 0 && i + 1 < mKeyFrames.size() &&
+                interpolatesWithinTolerance(mKeyFrames, lastKept, i + 1, spherical,
+                    mUseShortestRotationPath, translateTolerance, halfRotationTolerance, scaleTolerance))
+            {
+                continue;
+            }
+
+            const TransformKeyFrame* kf = static_cast<const TransformKeyFrame*>(mKeyFrames[i]);
+            times.push_back(kf->getTime());
+            translates.push_back(kf->getTranslate());
+            rotations.push_back(kf->getRotation());
+            scales.push_back(kf->getScale());
+            lastKept = i;
+        }
+
+        CompressedTransformKeyFrames* compressed = OGRE_NEW CompressedTransformKeyFrames();
+        compressed->encode(static_cast<unsigned short>(times.size()), &times[0], &translates[0],
+            &rotations[0], &scales[0], translateTolerance, halfRotationTolerance, scaleTolerance);
+        _setCompressedKeyFrames(compressed);
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::decompress(void)
+    {
+        if (!mCompressed)
+            return;
+
+        CompressedTransformKeyFrames* compressed = mCompressed;
+        mCompressed = 0;
+        AnimationTrack::removeAllKeyFrames();
+
+        for (unsigned short i = 0; i < compressed->getNumKeyFrames(); ++i)
+        {
+            compressed->getKeyFrame(i, createNodeKeyFrame(compressed->getTimes()[i]));
+        }
+        OGRE_DELETE compressed;
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::_setCompressedKeyFrames(CompressedTransformKeyFrames* keyFrames)
+    {
+        removeAllKeyFrames();
+        mCompressed = keyFrames;
+
+        _keyFrameDataChanged();
+        mParent->_keyFrameListChanged();
+    }
+    //--------------------------------------------------------------------------
+    size_t NodeAnimationTrack::calculateSize(void) const
+    {
+        size_t memSize = sizeof(*this);
+        memSize += mKeyFrames.capacity() * sizeof(KeyFrame*);
+        memSize += mKeyFrames.size() * sizeof(TransformKeyFrame);
+        memSize += mKeyFrameIndexMap.capacity() * sizeof(ushort);
+        if (mCompressed)
+            memSize += mCompressed->calculateSize();
+        return memSize;
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::_collectKeyFrameTimes(vector<Real>::type& keyFrameTimes)
+    {
+        if (!mCompressed)
+        {
+            AnimationTrack::_collectKeyFrameTimes(keyFrameTimes);
+            return;
+        }
+
+        const Real* times = mCompressed->getTimes();
+        for (unsigned short i = 0; i < mCompressed->getNumKeyFrames(); ++i)
+        {
+            vector<Real>::type::iterator it =
+                std::lower_bound(keyFrameTimes.begin(), keyFrameTimes.end(), times[i]);
+            if (it == keyFrameTimes.end() || *it != times[i])
+            {
+                keyFrameTimes.insert(it, times[i]);
+            }
+        }
+    }
+    //--------------------------------------------------------------------------
+    void NodeAnimationTrack::_buildKeyFrameIndexMap(const vector<Real>::type& keyFrameTimes)
+    {
+        if (!mCompressed)
+        {
+            AnimationTrack::_buildKeyFrameIndexMap(keyFrameTimes);
+            return;
+        }
+
+        // Pre-allocate memory
+        mKeyFrameIndexMap.resize(keyFrameTimes.size() + 1);
+
+        const Real* times = mCompressed->getTimes();
+        size_t i = 0, j = 0;
+        while (j <= keyFrameTimes.size())
+        {
+            mKeyFrameIndexMap[j] = static_cast<ushort>(i);
+            while (i < mCompressed->getNumKeyFrames() && times[i] <= keyFrameTimes[j])
+                ++i;
+            ++j;
+        }
+    }
     //---------------------------------------------------------------------
     NodeAnimationTrack* NodeAnimationTrack::_clone(Animation* newParent) const
     {
         NodeAnimationTrack* newTrack = 
             newParent->createNodeTrack(mHandle, mTargetNode);
         newTrack->mUseShortestRotationPath = mUseShortestRotationPath;
-        populateClone(newTrack);
+        if (mCompressed)
+            newTrack->_setCompressedKeyFrames(OGRE_NEW CompressedTransformKeyFrames(*mCompressed));
+        else
+            populateClone(newTrack);
         return newTrack;
     }
     //--------------------------------------------------------------------------
     void NodeAnimationTrack::_applyBaseKeyFrame(const KeyFrame* b)
     {
         const TransformKeyFrame* base = static_cast<const TransformKeyFrame*>(b);
+
+        if (mCompressed)
+        {
+            mCompressed->applyBaseKeyFrame(base);
+            _keyFrameDataChanged();
+            return;
+        }
         
         for (KeyFrameList::iterator i = mKeyFrames.begin(); i != mKeyFrames.end(); ++i)
         {
@@ -40,6 +40,7 @@ THE SOFTWARE.
 #include "OgreColourValue.h"
 #include "OgreSceneNode.h"
 #include "OgreViewport.h"
+#include "OgreGpuProgramManager.h"
 
 namespace Ogre {
     const Matrix4 PROJECTIONCLIPSPACE2DTOIMAGESPACE_PERSPECTIVE(
@@ -77,7 +78,8 @@ namespace Ogre {
          mCurrentViewport(0), 
          mCurrentSceneManager(0),
          mMainCamBoundsInfo(0),
-         mCurrentPass(0)
+         mCurrentPass(0),
+         mSharedBlocksEnabled(false)
     {
         mBlankLight.setDiffuseColour(ColourValue::Black);
         mBlankLight.setSpecularColour(ColourValue::Black);
@@ -91,6 +93,8 @@ namespace Ogre {
             mCurrentTextureProjector[i] = 0;
             mShadowCamDepthRangesDirty[i] = false;
         }
+        for (size_t i = 0; i < SB_COUNT; ++i)
+            mSharedBlockVersions[i] = 0;
 
     }
     //-----------------------------------------------------------------------------
@@ -1143,6 +1147,158 @@ namespace Ogre {
             light._updateCustomGpuParameter(paramIndex, constantEntry, params);
         }
     }
+    //-------------------------------------------------------------------------
+    namespace
+    {
+        /// Automatic constants of each shared block, terminated by ACT_UNKNOWN
+        const GpuProgramParameters::AutoConstantType SHARED_BLOCK_CONSTANTS[AutoParamDataSource::SB_COUNT][16] =
+        {
+            {
+                GpuProgramParameters::ACT_VIEW_MATRIX,
+                GpuProgramParameters::ACT_INVERSE_VIEW_MATRIX,
+                GpuProgramParameters::ACT_PROJECTION_MATRIX,
+                GpuProgramParameters::ACT_VIEWPROJ_MATRIX,
+                GpuProgramParameters::ACT_INVERSE_VIEWPROJ_MATRIX,
+                GpuProgramParameters::ACT_CAMERA_POSITION,
+                GpuProgramParameters::ACT_VIEW_DIRECTION,
+                GpuProgramParameters::ACT_VIEWPORT_SIZE,
+                GpuProgramParameters::ACT_NEAR_CLIP_DISTANCE,
+                GpuProgramParameters::ACT_FAR_CLIP_DISTANCE,
+                GpuProgramParameters::ACT_TIME,
+                GpuProgramParameters::ACT_FRAME_TIME,
+                GpuProgramParameters::ACT_UNKNOWN
+            },
+            {
+                GpuProgramParameters::ACT_AMBIENT_LIGHT_COLOUR,
+                GpuProgramParameters::ACT_DERIVED_AMBIENT_LIGHT_COLOUR,
+                GpuProgramParameters::ACT_SURFACE_AMBIENT_COLOUR,
+                GpuProgramParameters::ACT_SURFACE_DIFFUSE_COLOUR,
+                GpuProgramParameters::ACT_SURFACE_SPECULAR_COLOUR,
+                GpuProgramParameters::ACT_SURFACE_EMISSIVE_COLOUR,
+                GpuProgramParameters::ACT_SURFACE_SHININESS,
+                GpuProgramParameters::ACT_FOG_COLOUR,
+                GpuProgramParameters::ACT_FOG_PARAMS,
+                GpuProgramParameters::ACT_PASS_NUMBER,
+                GpuProgramParameters::ACT_UNKNOWN
+            }
+        };
+    }
+    const String AutoParamDataSource::SHARED_BLOCK_NAMES[SB_COUNT] =
+    {
+        "OgreFrameParams",
+        "OgrePassParams"
+    };
+    //-------------------------------------------------------------------------
+    void AutoParamDataSource::setSharedBlocksEnabled(bool enabled)
+    {
+        if (enabled == mSharedBlocksEnabled)
+            return;
 
-}
+        mSharedBlocksEnabled = enabled;
+        for (size_t b = 0; b < SB_COUNT; ++b)
+        {
+            mSharedBlockSources[b].reset();
+            mSharedBlockVersions[b] = 0;
+            if (!enabled)
+            {
+                // The sets stay with GpuProgramManager for the programs using them
+                mSharedBlocks[b].reset();
+                continue;
+            }
+
+            // Another scene manager or a script may have created the set already
+            GpuProgramManager& gpuMgr = GpuProgramManager::getSingleton();
+            const GpuProgramManager::SharedParametersMap& sets = gpuMgr.getAvailableSharedParameters();
+            GpuProgramManager::SharedParametersMap::const_iterator i = sets.find(SHARED_BLOCK_NAMES[b]);
+            mSharedBlocks[b] = i != sets.end() ? i->second : gpuMgr.createSharedParameters(SHARED_BLOCK_NAMES[b]);
+
+            const GpuConstantDefinitionMap& defs = mSharedBlocks[b]->getConstantDefinitions().map;
+            for (const GpuProgramParameters::AutoConstantType* t = SHARED_BLOCK_CONSTANTS[b];
+                 *t != GpuProgramParameters::ACT_UNKNOWN; ++t)
+            {
+                const GpuProgramParameters::AutoConstantDefinition* autoDef =
+                    GpuProgramParameters::getAutoConstantDefinition(*t);
+                if (defs.find(autoDef->name) != defs.end())
+                    continue;
 
+                GpuConstantType constType;
+                switch (autoDef->elementCount)
+                {
+                case 1: constType = GCT_FLOAT1; break;
+                case 3: constType = GCT_FLOAT3; break;
+                case 4: constType = GCT_FLOAT4; break;
+                default: constType = GCT_MATRIX_4X4; break;
+                }
+                mSharedBlocks[b]->addConstantDefinition(autoDef->name, constType);
+            }
+        }
+    }
+    //-------------------------------------------------------------------------
+    const GpuSharedParametersPtr& AutoParamDataSource::getSharedBlock(SharedBlock block) const
+    {
+        return mSharedBlocks[block];
+    }
+    //-------------------------------------------------------------------------
+    void AutoParamDataSource::createSharedBlockSource(SharedBlock block)
+    {
+        // Give the source the layout of the shared set, so values are at the same indexes
+        const GpuSharedParameters* shared = mSharedBlocks[block].get();
+        GpuNamedConstantsPtr namedConstants(OGRE_NEW GpuNamedConstants());
+        namedConstants->map = shared->getConstantDefinitions().map;
+        namedConstants->floatBufferSize = shared->getFloatConstantList().size();
+
+        GpuProgramParametersSharedPtr source(OGRE_NEW GpuProgramParameters());
+        source->_setNamedConstants(namedConstants);
+        for (const GpuProgramParameters::AutoConstantType* t = SHARED_BLOCK_CONSTANTS[block];
+             *t != GpuProgramParameters::ACT_UNKNOWN; ++t)
+        {
+            const GpuProgramParameters::AutoConstantDefinition* autoDef =
+                GpuProgramParameters::getAutoConstantDefinition(*t);
+            GpuConstantDefinitionMap::const_iterator def = namedConstants->map.find(autoDef->name);
+            // Constants may have been removed, or created differently by the user
+            if (def == namedConstants->map.end() || !def->second.isFloat() ||
+                def->second.elementSize * def->second.arraySize < autoDef->elementCount)
+                continue;
+
+            if (autoDef->dataType == GpuProgramParameters::ACDT_REAL)
+                source->setNamedAutoConstantReal(autoDef->name, *t, 1);
+            else
+                source->setNamedAutoConstant(autoDef->name, *t);
+        }
+
+        mSharedBlockSources[block] = source;
+        mSharedBlockVersions[block] = shared->getVersion();
+    }
+    //-------------------------------------------------------------------------
+    void AutoParamDataSource::updateSharedBlock(SharedBlock block)
+    {
+        if (!mSharedBlocksEnabled)
+            return;
+        if (block == SB_FRAME ? !mCurrentCamera || !mCurrentViewport : !mCurrentPass)
+            return;
+        // Shared by all renderables, so not evaluated for the last one, which may
+        // use an identity view or projection, or may even have been destroyed
+        setCurrentRenderable(0);
+
+        GpuSharedParameters* shared = mSharedBlocks[block].get();
+        if (!mSharedBlockSources[block] || mSharedBlockVersions[block] != shared->getVersion())
+            createSharedBlockSource(block);
+
+        GpuProgramParameters* source = mSharedBlockSources[block].get();
+        source->_updateAutoParams(this, GPV_ALL);
+
+        // Only copy changes, so the set is only marked dirty, and so copied to the
+        // programs and uploaded, when something changed
+        const GpuSharedParameters* constShared = shared;
+        const GpuProgramParameters::AutoConstantList& autos = source->getAutoConstantList();
+        for (GpuProgramParameters::AutoConstantList::const_iterator i = autos.begin();
+             i != autos.end(); ++i)
+        {
+            const float* value = source->getFloatPointer(i->physicalIndex);
+            size_t size = sizeof(float) * i->elementCount;
+            if (memcmp(constShared->getFloatPointer(i->physicalIndex), value, size) != 0)
+                memcpy(shared->getFloatPointer(i->physicalIndex), value, size);
+        }
+    }
+
+}
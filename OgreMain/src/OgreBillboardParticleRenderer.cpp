@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include "OgreBillboardParticleRenderer.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
 #include "OgreBillboard.h"
 #include "OgreStringConverter.h"
 #include "OgreSceneNode.h"
@@ -183,6 +184,73 @@ namespace Ogre {
         // Update the queue
         mBillboardSet->_updateRenderQueue(queue);
     }
+    //-----------------------------------------------------------------------
+    void BillboardParticleRenderer::_updateRenderQueueFromArrays(RenderQueue* queue,
+        const ParticleArrays& particles, bool cullIndividually)
+    {
+        mBillboardSet->setCullIndividually(cullIndividually);
+
+        // Update billboard set geometry
+        Vector3 bboxMin = Math::POS_INFINITY * Vector3::UNIT_SCALE;
+        Vector3 bboxMax = Math::NEG_INFINITY * Vector3::UNIT_SCALE;
+        Real radiusSquared = 0.0f;
+        mBillboardSet->beginBillboards(particles.mCount);
+        Billboard bb;
+
+        bool toLocal = mBillboardSet->getBillboardsInWorldSpace() && mBillboardSet->getParentSceneNode();
+        Matrix4 invWorld;
+        if (toLocal)
+            invWorld = mBillboardSet->getParentSceneNode()->_getFullTransform().inverse();
+        bool ownDirection = mBillboardSet->getBillboardType() == BBT_ORIENTED_SELF ||
+            mBillboardSet->getBillboardType() == BBT_PERPENDICULAR_SELF;
+
+        // Let the set generate the vertices on worker threads if it would
+        size_t threshold = mBillboardSet->getParallelBillboardThreshold();
+        bool batch = threshold && particles.mCount >= threshold && !cullIndividually;
+        if (batch)
+            mBillboards.resize(particles.mCount);
+
+        for (size_t i = 0; i < particles.mCount; ++i)
+        {
+            bb.mPosition = Vector3(particles.mPositionX[i], particles.mPositionY[i], particles.mPositionZ[i]);
+            Vector3 pos = toLocal ? invWorld * bb.mPosition : bb.mPosition;
+
+            bboxMin.makeFloor( pos );
+            bboxMax.makeCeil( pos );
+            radiusSquared = std::max( radiusSquared, bb.mPosition.squaredLength() );
+
+            if (ownDirection)
+            {
+                // Normalise direction vector
+                bb.mDirection = Vector3(particles.mDirectionX[i], particles.mDirectionY[i], particles.mDirectionZ[i]);
+                bb.mDirection.normalise();
+            }
+            bb.mColour = ColourValue(particles.mColourR[i], particles.mColourG[i],
+                particles.mColourB[i], particles.mColourA[i]);
+            bb.mRotation = Radian(particles.mRotation[i]);
+            // Assign and compare at the same time
+            if ((bb.mOwnDimensions = particles.mOwnDimensions[i] != 0) == true)
+            {
+                bb.mWidth = particles.mWidth[i];
+                bb.mHeight = particles.mHeight[i];
+            }
+            if (batch)
+                mBillboards[i] = bb;
+            else
+                mBillboardSet->injectBillboard(bb);
+        }
+        if (batch)
+            mBillboardSet->injectBillboards(&mBillboards[0], particles.mCount);
+
+        // Only set bounds if there are any active particles
+        if (particles.mCount)
+            mBillboardSet->setBounds( AxisAlignedBox( bboxMin, bboxMax ), Math::Sqrt(radiusSquared) );
+
+        mBillboardSet->endBillboards();
+
+        // Update the queue
+        mBillboardSet->_updateRenderQueue(queue);
+    }
     //---------------------------------------------------------------------
     void BillboardParticleRenderer::visitRenderables(Renderable::Visitor* visitor, 
         bool debugRenderables)
@@ -40,11 +40,19 @@ THE SOFTWARE.
 #include "OgreException.h"
 #include "OgreSceneNode.h"
 #include "OgreLogManager.h"
+#include "OgreTaskScheduler.h"
+#include "OgrePlatformInformation.h"
 #include <algorithm>
 
+#if __OGRE_HAVE_SSE
+// Keep this last, see OgreOptimisedUtilSSE.cpp
+#include "OgreSIMDHelper.h"
+#endif
+
 namespace Ogre {
     // Init statics
     RadixSort<BillboardSet::ActiveBillboardList, Billboard*, float> BillboardSet::mRadixSorter;
+    const size_t BillboardSet::MIN_PARALLEL_CHUNK_BILLBOARDS;
 
     //-----------------------------------------------------------------------
     BillboardSet::BillboardSet() :
@@ -68,7 +76,12 @@ namespace Ogre {
         mPoolSize(0),
         mExternalData(false),
         mAutoUpdate(true),
-        mBillboardDataChanged(true)
+        mBillboardDataChanged(true),
+        mStreamingFrames(0),
+        mStreamVertexStart(0),
+        mStreamNextVertex(0),
+        mParallelBillboardThreshold(0),
+        mColourType(VET_COLOUR_ABGR)
     {
         setDefaultDimensions( 100, 100 );
         mMaterial = MaterialManager::getSingleton().getDefaultMaterial();
@@ -103,7 +116,12 @@ namespace Ogre {
         mPoolSize(poolSize),
         mExternalData(externalData),
         mAutoUpdate(true),
-        mBillboardDataChanged(true)
+        mBillboardDataChanged(true),
+        mStreamingFrames(0),
+        mStreamVertexStart(0),
+        mStreamNextVertex(0),
+        mParallelBillboardThreshold(0),
+        mColourType(VET_COLOUR_ABGR)
     {
         setDefaultDimensions( 100, 100 );
         mMaterial = MaterialManager::getSingleton().getDefaultMaterial();
@@ -443,8 +461,34 @@ namespace Ogre {
         // Init num visible
         mNumVisibleBillboards = 0;
 
+        // Colour format of the buffer, as the render system would convert to
+        mColourType = mVertexData->vertexDeclaration->findElementBySemantic(VES_DIFFUSE)->getType();
+
         // Lock the buffer
-        if (numBillboards) // optimal lock
+        mStreamVertexStart = 0;
+        if (mStreamingFrames > 1 && mAutoUpdate)
+        {
+            // Write after what the previous updates wrote, which the GPU may
+            // still be reading, and only discard the buffer once it is full
+            size_t numVertices = numBillboards ? std::min(mPoolSize, numBillboards) : mPoolSize;
+            if (!mPointRendering)
+                numVertices *= 4;
+
+            HardwareBuffer::LockOptions options = HardwareBuffer::HBL_NO_OVERWRITE;
+            if (mStreamNextVertex == 0 || mStreamNextVertex + numVertices > mMainBuf->getNumVertices())
+            {
+                mStreamNextVertex = 0;
+                options = HardwareBuffer::HBL_DISCARD;
+            }
+            mStreamVertexStart = mStreamNextVertex;
+            mStreamNextVertex += numVertices;
+
+            mLockPtr = static_cast<float*>(
+                mMainBuf->lock(mStreamVertexStart * mMainBuf->getVertexSize(),
+                numVertices * mMainBuf->getVertexSize(), options,
+                Root::getSingleton().getFreqUpdatedBuffersUploadOption()) );
+        }
+        else if (numBillboards) // optimal lock
         {
             // clamp to max
             numBillboards = std::min(mPoolSize, numBillboards);
@@ -484,13 +528,97 @@ namespace Ogre {
         // Skip if not visible (NB always true if not bounds checking individual billboards)
         if (!billboardVisible(mCurrentCamera, bb)) return;
 
-        if (!mPointRendering &&
+        mLockPtr = genBillboardVertices(mLockPtr, bb);
+        // Increment visibles
+        mNumVisibleBillboards++;
+    }
+    //-----------------------------------------------------------------------
+    void BillboardSet::injectBillboards(const Billboard* billboards, size_t count)
+    {
+        BillboardSource source = { billboards, 0 };
+        injectBillboards(source, count);
+    }
+    //-----------------------------------------------------------------------
+    const Billboard& BillboardSet::BillboardSource::operator[](size_t i) const
+    {
+        return pointers ? *pointers[i] : values[i];
+    }
+    //-----------------------------------------------------------------------
+    struct BillboardSet::GenVerticesTask
+    {
+        const BillboardSet* set;
+        BillboardSource source;
+        float* pDest;
+        size_t floatsPerBillboard;
+        size_t chunkSize;
+        size_t count;
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                size_t first = c * chunkSize;
+                size_t last = std::min(first + chunkSize, count);
+                float* pChunk = pDest + first * floatsPerBillboard;
+                for (size_t i = first; i < last; ++i)
+                    pChunk = set->genBillboardVertices(pChunk, source[i]);
+            }
+        }
+    };
+    //-----------------------------------------------------------------------
+    void BillboardSet::injectBillboards(const BillboardSource& source, size_t count)
+    {
+        // Individually culled billboards leave gaps, so only the whole lot
+        // can be split up front
+        size_t chunkSize = 0;
+        if (!mCullIndividual && mParallelBillboardThreshold &&
+            count >= mParallelBillboardThreshold && Root::getSingletonPtr())
+        {
+            TaskScheduler* scheduler = Root::getSingleton().getTaskScheduler();
+            if (scheduler && scheduler->getConcurrency() > 1)
+            {
+                // A few chunks per thread balance the load
+                chunkSize = std::max(MIN_PARALLEL_CHUNK_BILLBOARDS,
+                    count / (scheduler->getConcurrency() * 4));
+            }
+        }
+
+        if (!chunkSize)
+        {
+            for (size_t i = 0; i < count; ++i)
+                injectBillboard(source[i]);
+            return;
+        }
+
+        // Don't accept injections beyond pool size
+        count = std::min(count, mPoolSize - mNumVisibleBillboards);
+        size_t floatsPerBillboard = mMainBuf->getVertexSize() / sizeof(float);
+        if (!mPointRendering)
+            floatsPerBillboard *= 4;
+
+        GenVerticesTask task = { this, source, mLockPtr, floatsPerBillboard, chunkSize, count };
+        parallelFor(0, (count + chunkSize - 1) / chunkSize, 1, task, "BillboardSet::injectBillboards");
+
+        mLockPtr += count * floatsPerBillboard;
+        mNumVisibleBillboards = static_cast<unsigned short>(mNumVisibleBillboards + count);
+    }
+    //-----------------------------------------------------------------------
+    bool BillboardSet::hasPerBillboardAxes(void) const
+    {
+        return !mPointRendering &&
             (mBillboardType == BBT_ORIENTED_SELF ||
             mBillboardType == BBT_PERPENDICULAR_SELF ||
-            (mAccurateFacing && mBillboardType != BBT_PERPENDICULAR_COMMON)))
+            (mAccurateFacing && mBillboardType != BBT_PERPENDICULAR_COMMON));
+    }
+    //-----------------------------------------------------------------------
+    float* BillboardSet::genBillboardVertices(float* pDest, const Billboard& bb) const
+    {
+        bool perBillboardAxes = hasPerBillboardAxes();
+        Vector3 camX, camY;
+        if (perBillboardAxes)
         {
             // Have to generate axes & offsets per billboard
-            genBillboardAxes(&mCamX, &mCamY, &bb);
+            genBillboardAxes(&camX, &camY, &bb);
         }
 
         // If they're all the same size or we're point rendering
@@ -501,38 +629,35 @@ namespace Ogre {
             make a difference.
             */
 
-            if (!mPointRendering &&
-                (mBillboardType == BBT_ORIENTED_SELF ||
-                mBillboardType == BBT_PERPENDICULAR_SELF ||
-                (mAccurateFacing && mBillboardType != BBT_PERPENDICULAR_COMMON)))
+            if (perBillboardAxes)
             {
+                Vector3 vOwnOffset[4];
                 genVertOffsets(mLeftOff, mRightOff, mTopOff, mBottomOff,
-                    mDefaultWidth, mDefaultHeight, mCamX, mCamY, mVOffset);
+                    mDefaultWidth, mDefaultHeight, camX, camY, vOwnOffset);
+                return genVertices(pDest, vOwnOffset, bb);
             }
-            genVertices(mVOffset, bb);
+            return genVertices(pDest, mVOffset, bb);
         }
         else // not all default size and not point rendering
         {
-            Vector3 vOwnOffset[4];
             // If it has own dimensions, or self-oriented, gen offsets
-            if (mBillboardType == BBT_ORIENTED_SELF ||
-                mBillboardType == BBT_PERPENDICULAR_SELF ||
-                bb.mOwnDimensions ||
-                (mAccurateFacing && mBillboardType != BBT_PERPENDICULAR_COMMON))
+            if (perBillboardAxes || bb.mOwnDimensions)
             {
-                // Generate using own dimensions
+                Vector3 vOwnOffset[4];
+                // Generate using own dimensions, self-oriented billboards
+                // without any use the defaults
                 genVertOffsets(mLeftOff, mRightOff, mTopOff, mBottomOff,
-                    bb.mWidth, bb.mHeight, mCamX, mCamY, vOwnOffset);
+                    bb.mOwnDimensions ? bb.mWidth : mDefaultWidth,
+                    bb.mOwnDimensions ? bb.mHeight : mDefaultHeight,
+                    perBillboardAxes ? camX : mCamX, perBillboardAxes ? camY : mCamY, vOwnOffset);
                 // Create vertex data
-                genVertices(vOwnOffset, bb);
+                return genVertices(pDest, vOwnOffset, bb);
             }
             else // Use default dimension, already computed before the loop, for faster creation
             {
-                genVertices(mVOffset, bb);
+                return genVertices(pDest, mVOffset, bb);
             }
         }
-        // Increment visibles
-        mNumVisibleBillboards++;
     }
     //-----------------------------------------------------------------------
     void BillboardSet::endBillboards(void)
@@ -611,12 +736,23 @@ namespace Ogre {
             }
 
             beginBillboards(mActiveBillboards.size());
-            ActiveBillboardList::iterator it;
-            for(it = mActiveBillboards.begin();
-                it != mActiveBillboards.end();
-                ++it )
+            if (mParallelBillboardThreshold && !mCullIndividual &&
+                mActiveBillboards.size() >= mParallelBillboardThreshold)
             {
-                injectBillboard(*(*it));
+                // Gathered for random access by the worker threads
+                mInjectBillboards.assign(mActiveBillboards.begin(), mActiveBillboards.end());
+                BillboardSource source = { 0, &mInjectBillboards[0] };
+                injectBillboards(source, mInjectBillboards.size());
+            }
+            else
+            {
+                ActiveBillboardList::iterator it;
+                for(it = mActiveBillboards.begin();
+                    it != mActiveBillboards.end();
+                    ++it )
+                {
+                    injectBillboard(*(*it));
+                }
             }
             endBillboards();
             mBillboardDataChanged = false;
@@ -665,7 +801,7 @@ namespace Ogre {
     void BillboardSet::getRenderOperation(RenderOperation& op)
     {
         op.vertexData = mVertexData;
-        op.vertexData->vertexStart = 0;
+        op.vertexData->vertexStart = mStreamVertexStart;
 
         if (mPointRendering)
         {
@@ -782,6 +918,8 @@ namespace Ogre {
             mVertexData->vertexCount = mPoolSize * 4;
 
         mVertexData->vertexStart = 0;
+        mStreamVertexStart = 0;
+        mStreamNextVertex = 0;
 
         // Vertex declaration
         VertexDeclaration* decl = mVertexData->vertexDeclaration;
@@ -799,10 +937,15 @@ namespace Ogre {
             decl->addElement(0, offset, VET_FLOAT2, VES_TEXTURE_COORDINATES, 0);
         }
 
+        // Room for the vertices of several updates when streaming
+        size_t numBufferVertices = mVertexData->vertexCount;
+        if (mStreamingFrames > 1 && mAutoUpdate)
+            numBufferVertices *= mStreamingFrames;
+
         mMainBuf =
             HardwareBufferManager::getSingleton().createVertexBuffer(
                 decl->getVertexSize(0),
-                mVertexData->vertexCount,
+                numBufferVertices,
                 mAutoUpdate ? HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY_DISCARDABLE : 
                 HardwareBuffer::HBU_STATIC_WRITE_ONLY);
         // bind position and diffuses
@@ -1016,17 +1159,18 @@ namespace Ogre {
 
     }
     //-----------------------------------------------------------------------
-    void BillboardSet::genBillboardAxes(Vector3* pX, Vector3 *pY, const Billboard* bb)
+    void BillboardSet::genBillboardAxes(Vector3* pX, Vector3 *pY, const Billboard* bb) const
     {
         // If we're using accurate facing, recalculate camera direction per BB
+        Vector3 camDir = mCamDir;
         if (mAccurateFacing && 
             (mBillboardType == BBT_POINT || 
             mBillboardType == BBT_ORIENTED_COMMON ||
             mBillboardType == BBT_ORIENTED_SELF))
         {
             // cam -> bb direction
-            mCamDir = bb->mPosition - mCamPos;
-            mCamDir.normalise();
+            camDir = bb->mPosition - mCamPos;
+            camDir.normalise();
         }
 
 
@@ -1038,9 +1182,9 @@ namespace Ogre {
                 // Point billboards will have 'up' based on but not equal to cameras
                 // Use pY temporarily to avoid allocation
                 *pY = mCamQ * Vector3::UNIT_Y;
-                *pX = mCamDir.crossProduct(*pY);
+                *pX = camDir.crossProduct(*pY);
                 pX->normalise();
-                *pY = pX->crossProduct(mCamDir); // both normalised already
+                *pY = pX->crossProduct(camDir); // both normalised already
             }
             else
             {
@@ -1054,7 +1198,7 @@ namespace Ogre {
             // Y-axis is common direction
             // X-axis is cross with camera direction
             *pY = mCommonDirection;
-            *pX = mCamDir.crossProduct(*pY);
+            *pX = camDir.crossProduct(*pY);
             pX->normalise();
             break;
 
@@ -1063,7 +1207,7 @@ namespace Ogre {
             // X-axis is cross with camera direction
             // Scale direction first
             *pY = bb->mDirection;
-            *pX = mCamDir.crossProduct(*pY);
+            *pX = camDir.crossProduct(*pY);
             pX->normalise();
             break;
 
@@ -1123,8 +1267,13 @@ namespace Ogre {
     void BillboardSet::genVertices(
         const Vector3* const offsets, const Billboard& bb)
     {
-        RGBA colour;
-        Root::getSingleton().convertColourValue(bb.mColour, &colour);
+        mLockPtr = genVertices(mLockPtr, offsets, bb);
+    }
+    //-----------------------------------------------------------------------
+    float* BillboardSet::genVertices(float* pDest,
+        const Vector3* const offsets, const Billboard& bb) const
+    {
+        RGBA colour = VertexElement::convertColourValue(bb.mColour, mColourType);
         RGBA* pCol;
 
         // Texcoords
@@ -1136,78 +1285,104 @@ namespace Ogre {
         {
             // Single vertex per billboard, ignore offsets
             // position
-            *mLockPtr++ = bb.mPosition.x;
-            *mLockPtr++ = bb.mPosition.y;
-            *mLockPtr++ = bb.mPosition.z;
+            *pDest++ = bb.mPosition.x;
+            *pDest++ = bb.mPosition.y;
+            *pDest++ = bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // No texture coords in point rendering
         }
         else if (mAllDefaultRotation || bb.mRotation == Radian(0))
         {
+#if __OGRE_HAVE_SSE
+            // The 4 vertices of 6 floats are written as 6 blocks of 4, the
+            // colour is or'ed into the zero fourth lane of the positions
+            __m128 pos = _mm_setr_ps(bb.mPosition.x, bb.mPosition.y, bb.mPosition.z, 0);
+            __m128 col = _mm_load_ss(reinterpret_cast<const float*>(&colour));
+            col = _mm_shuffle_ps(col, col, _MM_SHUFFLE(0, 1, 1, 1));
+            __m128 v0 = _mm_or_ps(_mm_add_ps(pos,
+                _mm_setr_ps(offsets[0].x, offsets[0].y, offsets[0].z, 0)), col);
+            __m128 v1 = _mm_or_ps(_mm_add_ps(pos,
+                _mm_setr_ps(offsets[1].x, offsets[1].y, offsets[1].z, 0)), col);
+            __m128 v2 = _mm_or_ps(_mm_add_ps(pos,
+                _mm_setr_ps(offsets[2].x, offsets[2].y, offsets[2].z, 0)), col);
+            __m128 v3 = _mm_or_ps(_mm_add_ps(pos,
+                _mm_setr_ps(offsets[3].x, offsets[3].y, offsets[3].z, 0)), col);
+            __m128 uvTop = _mm_setr_ps(r.left, r.top, r.right, r.top);
+            __m128 uvBottom = _mm_setr_ps(r.left, r.bottom, r.right, r.bottom);
+
+            _mm_storeu_ps(pDest, v0);
+            _mm_storeu_ps(pDest + 4, _mm_movelh_ps(uvTop, v1));
+            _mm_storeu_ps(pDest + 8, _mm_movehl_ps(uvTop, v1));
+            _mm_storeu_ps(pDest + 12, v2);
+            _mm_storeu_ps(pDest + 16, _mm_movelh_ps(uvBottom, v3));
+            _mm_storeu_ps(pDest + 20, _mm_movehl_ps(uvBottom, v3));
+            pDest += 24;
+#else
             // Left-top
             // Positions
-            *mLockPtr++ = offsets[0].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[0].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[0].z + bb.mPosition.z;
+            *pDest++ = offsets[0].x + bb.mPosition.x;
+            *pDest++ = offsets[0].y + bb.mPosition.y;
+            *pDest++ = offsets[0].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.left;
-            *mLockPtr++ = r.top;
+            *pDest++ = r.left;
+            *pDest++ = r.top;
 
             // Right-top
             // Positions
-            *mLockPtr++ = offsets[1].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[1].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[1].z + bb.mPosition.z;
+            *pDest++ = offsets[1].x + bb.mPosition.x;
+            *pDest++ = offsets[1].y + bb.mPosition.y;
+            *pDest++ = offsets[1].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.right;
-            *mLockPtr++ = r.top;
+            *pDest++ = r.right;
+            *pDest++ = r.top;
 
             // Left-bottom
             // Positions
-            *mLockPtr++ = offsets[2].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[2].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[2].z + bb.mPosition.z;
+            *pDest++ = offsets[2].x + bb.mPosition.x;
+            *pDest++ = offsets[2].y + bb.mPosition.y;
+            *pDest++ = offsets[2].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.left;
-            *mLockPtr++ = r.bottom;
+            *pDest++ = r.left;
+            *pDest++ = r.bottom;
 
             // Right-bottom
             // Positions
-            *mLockPtr++ = offsets[3].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[3].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[3].z + bb.mPosition.z;
+            *pDest++ = offsets[3].x + bb.mPosition.x;
+            *pDest++ = offsets[3].y + bb.mPosition.y;
+            *pDest++ = offsets[3].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.right;
-            *mLockPtr++ = r.bottom;
+            *pDest++ = r.right;
+            *pDest++ = r.bottom;
+#endif
         }
         else if (mRotationType == BBR_VERTEX)
         {
@@ -1222,66 +1397,66 @@ namespace Ogre {
             // Left-top
             // Positions
             pt = rotation * offsets[0];
-            *mLockPtr++ = pt.x + bb.mPosition.x;
-            *mLockPtr++ = pt.y + bb.mPosition.y;
-            *mLockPtr++ = pt.z + bb.mPosition.z;
+            *pDest++ = pt.x + bb.mPosition.x;
+            *pDest++ = pt.y + bb.mPosition.y;
+            *pDest++ = pt.z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.left;
-            *mLockPtr++ = r.top;
+            *pDest++ = r.left;
+            *pDest++ = r.top;
 
             // Right-top
             // Positions
             pt = rotation * offsets[1];
-            *mLockPtr++ = pt.x + bb.mPosition.x;
-            *mLockPtr++ = pt.y + bb.mPosition.y;
-            *mLockPtr++ = pt.z + bb.mPosition.z;
+            *pDest++ = pt.x + bb.mPosition.x;
+            *pDest++ = pt.y + bb.mPosition.y;
+            *pDest++ = pt.z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.right;
-            *mLockPtr++ = r.top;
+            *pDest++ = r.right;
+            *pDest++ = r.top;
 
             // Left-bottom
             // Positions
             pt = rotation * offsets[2];
-            *mLockPtr++ = pt.x + bb.mPosition.x;
-            *mLockPtr++ = pt.y + bb.mPosition.y;
-            *mLockPtr++ = pt.z + bb.mPosition.z;
+            *pDest++ = pt.x + bb.mPosition.x;
+            *pDest++ = pt.y + bb.mPosition.y;
+            *pDest++ = pt.z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.left;
-            *mLockPtr++ = r.bottom;
+            *pDest++ = r.left;
+            *pDest++ = r.bottom;
 
             // Right-bottom
             // Positions
             pt = rotation * offsets[3];
-            *mLockPtr++ = pt.x + bb.mPosition.x;
-            *mLockPtr++ = pt.y + bb.mPosition.y;
-            *mLockPtr++ = pt.z + bb.mPosition.z;
+            *pDest++ = pt.x + bb.mPosition.x;
+            *pDest++ = pt.y + bb.mPosition.y;
+            *pDest++ = pt.z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = r.right;
-            *mLockPtr++ = r.bottom;
+            *pDest++ = r.right;
+            *pDest++ = r.bottom;
         }
         else
         {
@@ -1300,69 +1475,70 @@ namespace Ogre {
 
             // Left-top
             // Positions
-            *mLockPtr++ = offsets[0].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[0].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[0].z + bb.mPosition.z;
+            *pDest++ = offsets[0].x + bb.mPosition.x;
+            *pDest++ = offsets[0].y + bb.mPosition.y;
+            *pDest++ = offsets[0].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = mid_u - cos_rot_w + sin_rot_h;
-            *mLockPtr++ = mid_v - sin_rot_w - cos_rot_h;
+            *pDest++ = mid_u - cos_rot_w + sin_rot_h;
+            *pDest++ = mid_v - sin_rot_w - cos_rot_h;
 
             // Right-top
             // Positions
-            *mLockPtr++ = offsets[1].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[1].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[1].z + bb.mPosition.z;
+            *pDest++ = offsets[1].x + bb.mPosition.x;
+            *pDest++ = offsets[1].y + bb.mPosition.y;
+            *pDest++ = offsets[1].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = mid_u + cos_rot_w + sin_rot_h;
-            *mLockPtr++ = mid_v + sin_rot_w - cos_rot_h;
+            *pDest++ = mid_u + cos_rot_w + sin_rot_h;
+            *pDest++ = mid_v + sin_rot_w - cos_rot_h;
 
             // Left-bottom
             // Positions
-            *mLockPtr++ = offsets[2].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[2].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[2].z + bb.mPosition.z;
+            *pDest++ = offsets[2].x + bb.mPosition.x;
+            *pDest++ = offsets[2].y + bb.mPosition.y;
+            *pDest++ = offsets[2].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = mid_u - cos_rot_w - sin_rot_h;
-            *mLockPtr++ = mid_v - sin_rot_w + cos_rot_h;
+            *pDest++ = mid_u - cos_rot_w - sin_rot_h;
+            *pDest++ = mid_v - sin_rot_w + cos_rot_h;
 
             // Right-bottom
             // Positions
-            *mLockPtr++ = offsets[3].x + bb.mPosition.x;
-            *mLockPtr++ = offsets[3].y + bb.mPosition.y;
-            *mLockPtr++ = offsets[3].z + bb.mPosition.z;
+            *pDest++ = offsets[3].x + bb.mPosition.x;
+            *pDest++ = offsets[3].y + bb.mPosition.y;
+            *pDest++ = offsets[3].z + bb.mPosition.z;
             // Colour
             // Convert float* to RGBA*
-            pCol = static_cast<RGBA*>(static_cast<void*>(mLockPtr));
+            pCol = static_cast<RGBA*>(static_cast<void*>(pDest));
             *pCol++ = colour;
             // Update lock pointer
-            mLockPtr = static_cast<float*>(static_cast<void*>(pCol));
+            pDest = static_cast<float*>(static_cast<void*>(pCol));
             // Texture coords
-            *mLockPtr++ = mid_u + cos_rot_w - sin_rot_h;
-            *mLockPtr++ = mid_v + sin_rot_w + cos_rot_h;
+            *pDest++ = mid_u + cos_rot_w - sin_rot_h;
+            *pDest++ = mid_v + sin_rot_w + cos_rot_h;
         }
 
+        return pDest;
     }
     //-----------------------------------------------------------------------
     void BillboardSet::genVertOffsets(Real inleft, Real inright, Real intop, Real inbottom,
-        Real width, Real height, const Vector3& x, const Vector3& y, Vector3* pDestVec)
+        Real width, Real height, const Vector3& x, const Vector3& y, Vector3* pDestVec) const
     {
         Vector3 vLeftOff, vRightOff, vTopOff, vBottomOff;
         /* Calculate default offsets. Scale the axes by
@@ -1489,6 +1665,21 @@ namespace Ogre {
             _destroyBuffers();
         }
     }
+    //-----------------------------------------------------------------------
+    void BillboardSet::setStreamingFrames(size_t numFrames)
+    {
+        if (numFrames != mStreamingFrames)
+        {
+            mStreamingFrames = numFrames;
+            // Different buffer size
+            _destroyBuffers();
+        }
+    }
+    //-----------------------------------------------------------------------
+    void BillboardSet::setParallelBillboardThreshold(size_t minBillboards)
+    {
+        mParallelBillboardThreshold = minBillboards;
+    }
 
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
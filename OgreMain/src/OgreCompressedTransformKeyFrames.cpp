@@ -0,0 +1,387 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "OgreCompressedTransformKeyFrames.h"
+#include "OgreKeyFrame.h"
+
+namespace Ogre {
+
+    namespace
+    {
+        /// Largest value of the 3 smallest components of a unit quaternion, 1 / sqrt(2)
+        const Real SMALLEST_COMPONENT_RANGE = 0.707106781f;
+        const Real QUATERNION_SCALE = 32767;
+        const Real VECTOR_SCALE = 65535;
+
+        /** Stores a rotation in 48 bits: the index and sign of the largest component,
+            and the other 3 components quantised to 15 bits each.
+        */
+        void encodeRotation(const Quaternion& rotation, uint16* dest)
+        {
+            Quaternion q = rotation;
+            q.normalise();
+
+            size_t largest = 0;
+            for (size_t i = 1; i < 4; ++i)
+            {
+                if (Math::Abs(q[i]) > Math::Abs(q[largest]))
+                    largest = i;
+            }
+
+            uint64 packed = (static_cast<uint64>(largest) << 46) |
+                (static_cast<uint64>(q[largest] < 0) << 45);
+            int shift = 30;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                if (i == largest)
+                    continue;
+                Real v = Math::Clamp(q[i] / (2 * SMALLEST_COMPONENT_RANGE) + 0.5f, Real(0), Real(1));
+                packed |= static_cast<uint64>(v * QUATERNION_SCALE + 0.5f) << shift;
+                shift -= 15;
+            }
+
+            dest[0] = static_cast<uint16>(packed >> 32);
+            dest[1] = static_cast<uint16>(packed >> 16);
+            dest[2] = static_cast<uint16>(packed);
+        }
+        //---------------------------------------------------------------------
+        Quaternion decodeRotation(const uint16* src)
+        {
+            uint64 packed = (static_cast<uint64>(src[0]) << 32) |
+                (static_cast<uint64>(src[1]) << 16) | src[2];
+            size_t largest = static_cast<size_t>(packed >> 46);
+
+            Quaternion q;
+            Real sum = 0;
+            int shift = 30;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                if (i == largest)
+                    continue;
+                Real v = static_cast<Real>((packed >> shift) & 0x7FFF) / QUATERNION_SCALE;
+                q[i] = (v - 0.5f) * 2 * SMALLEST_COMPONENT_RANGE;
+                sum += q[i] * q[i];
+                shift -= 15;
+            }
+            q[largest] = Math::Sqrt(std::max(Real(0), 1 - sum));
+            if ((packed >> 45) & 1)
+                q[largest] = -q[largest];
+            return q;
+        }
+    }
+    //---------------------------------------------------------------------
+    CompressedTransformKeyFrames::CompressedTransformKeyFrames()
+        : mNumKeyFrames(0)
+        , mTranslateBase(Vector3::ZERO)
+        , mScaleBase(Vector3::UNIT_SCALE)
+        , mTranslateStep(Vector3::ZERO)
+        , mScaleStep(Vector3::ZERO)
+        , mRotation(Quaternion::IDENTITY)
+        , mTimes(0)
+    {
+        for (size_t c = 0; c < CH_COUNT; ++c)
+        {
+            mModes[c] = CM_IDENTITY;
+            mFull[c] = 0;
+            mQuantised[c] = 0;
+        }
+    }
+    //---------------------------------------------------------------------
+    CompressedTransformKeyFrames::CompressedTransformKeyFrames(const CompressedTransformKeyFrames& rhs)
+        : mNumKeyFrames(0)
+        , mTranslateBase(rhs.mTranslateBase)
+        , mScaleBase(rhs.mScaleBase)
+        , mTranslateStep(rhs.mTranslateStep)
+        , mScaleStep(rhs.mScaleStep)
+        , mRotation(rhs.mRotation)
+        , mTimes(0)
+    {
+        for (size_t c = 0; c < CH_COUNT; ++c)
+            mModes[c] = rhs.mModes[c];
+        allocate(rhs.mNumKeyFrames);
+        memcpy(mTimes, rhs.mTimes, getDataSize());
+    }
+    //---------------------------------------------------------------------
+    CompressedTransformKeyFrames::~CompressedTransformKeyFrames()
+    {
+        deallocate();
+    }
+    //---------------------------------------------------------------------
+    void CompressedTransformKeyFrames::allocate(unsigned short numKeyFrames)
+    {
+        deallocate();
+        mNumKeyFrames = numKeyFrames;
+
+        // Times and full precision values first to keep them aligned
+        uint8* data = static_cast<uint8*>(OGRE_MALLOC(getDataSize(), MEMCATEGORY_ANIMATION));
+        mTimes = reinterpret_cast<Real*>(data);
+        data += numKeyFrames * sizeof(Real);
+        for (size_t c = 0; c < CH_COUNT; ++c)
+        {
+            if (mModes[c] == CM_FULL)
+            {
+                mFull[c] = reinterpret_cast<Real*>(data);
+                data += 3 * numKeyFrames * sizeof(Real);
+            }
+        }
+        for (size_t c = 0; c < CH_COUNT; ++c)
+        {
+            if (mModes[c] == CM_QUANTISED)
+            {
+                mQuantised[c] = reinterpret_cast<uint16*>(data);
+                data += 3 * numKeyFrames * sizeof(uint16);
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void CompressedTransformKeyFrames::deallocate(void)
+    {
+        if (mTimes)
+        {
+            OGRE_FREE(mTimes, MEMCATEGORY_ANIMATION);
+            mTimes = 0;
+        }
+        for (size_t c = 0; c < CH_COUNT; ++c)
+        {
+            mFull[c] = 0;
+            mQuantised[c] = 0;
+        }
+        mNumKeyFrames = 0;
+    }
+    //---------------------------------------------------------------------
+    size_t CompressedTransformKeyFrames::getDataSize(void) const
+    {
+        size_t size = mNumKeyFrames * sizeof(Real);
+        for (size_t c = 0; c < CH_COUNT; ++c)
+        {
+            if (mModes[c] == CM_FULL)
+                size += 3 * mNumKeyFrames * sizeof(Real);
+            else if (mModes[c] == CM_QUANTISED)
+                size += 3 * mNumKeyFrames * sizeof(uint16);
+        }
+        return size;
+    }
+    //---------------------------------------------------------------------
+    size_t CompressedTransformKeyFrames::calculateSize(void) const
+    {
+        return sizeof(*this) + getDataSize();
+    }
+    //---------------------------------------------------------------------
+    Radian CompressedTransformKeyFrames::getRotationError(const Quaternion& a, const Quaternion& b)
+    {
+        // The chord between unit quaternions is 2 sin(angle / 4), where q and -q
+        // are the same orientation
+        Quaternion chord = a.Dot(b) < 0 ? a + b : a - b;
+        Real halfLength = std::min(Real(1), chord.Norm() / 2);
+        return Math::ASin(halfLength) * 4;
+    }
+    //---------------------------------------------------------------------
+    void CompressedTransformKeyFrames::encode(unsigned short numKeyFrames, const Real* times,
+        const Vector3* translates, const Quaternion* rotations, const Vector3* scales,
+        Real translateTolerance, const Radian& rotationTolerance, Real scaleTolerance)
+    {
+        deallocate();
+        if (!numKeyFrames)
+            return;
+
+        mModes[CH_TRANSLATE] = static_cast<uint8>(analyseVectors(numKeyFrames, translates,
+            Vector3::ZERO, translateTolerance, mTranslateBase, mTranslateStep));
+        mModes[CH_SCALE] = static_cast<uint8>(analyseVectors(numKeyFrames, scales,
+            Vector3::UNIT_SCALE, scaleTolerance, mScaleBase, mScaleStep));
+
+        // Rotations must match including the sign, since that changes the
+        // interpolation when the shortest rotation path is not used
+        mModes[CH_ROTATION] = CM_CONSTANT;
+        mRotation = rotations[0];
+        for (unsigned short i = 1; i < numKeyFrames; ++i)
+        {
+            if (rotations[i].Dot(mRotation) <= 0 ||
+                getRotationError(rotations[i], mRotation) > rotationTolerance)
+            {
+                mModes[CH_ROTATION] = CM_QUANTISED;
+                break;
+            }
+        }
+        if (mModes[CH_ROTATION] == CM_CONSTANT && mRotation.w > 0 &&
+            getRotationError(mRotation, Quaternion::IDENTITY) <= rotationTolerance)
+        {
+            mModes[CH_ROTATION] = CM_IDENTITY;
+            mRotation = Quaternion::IDENTITY;
+        }
+
+        allocate(numKeyFrames);
+        memcpy(mTimes, times, numKeyFrames * sizeof(Real));
+        storeVectors(CH_TRANSLATE, translates, mTranslateBase, mTranslateStep);
+        storeVectors(CH_SCALE, scales, mScaleBase, mScaleStep);
+        if (mQuantised[CH_ROTATION])
+        {
+            for (unsigned short i = 0; i < numKeyFrames; ++i)
+                encodeRotation(rotations[i], mQuantised[CH_ROTATION] + 3 * i);
+        }
+    }
+    //---------------------------------------------------------------------
+    void CompressedTransformKeyFrames::applyBaseKeyFrame(const TransformKeyFrame* base)
+    {
+        if (!mNumKeyFrames)
+            return;
+
+        vector<Real>::type times(mTimes, mTimes + mNumKeyFrames);
+        vector<Vector3>::type translates(mNumKeyFrames), scales(mNumKeyFrames);
+        vector<Quaternion>::type rotations(mNumKeyFrames);
+        const Quaternion baseInverse = base->getRotation().Inverse();
+        const Vector3 baseScaleInverse = Vector3::UNIT_SCALE / base->getScale();
+        for (unsigned short i = 0; i < mNumKeyFrames; ++i)
+        {
+            translates[i] = getTranslate(i) - base->getTranslate();
+            rotations[i] = baseInverse * getRotation(i);
+            scales[i] = getScale(i) * baseScaleInverse;
+        }
+
+        // A tolerance of one step keeps quantised channels quantised without
+        // adding more than the rounding already done, and the others exact
+        Real translateTolerance = mTranslateStep.x;
+        translateTolerance = std::max(translateTolerance, std::max(mTranslateStep.y, mTranslateStep.z));
+        Vector3 scaleStep = mScaleStep * baseScaleInverse;
+        Real scaleTolerance = std::max(Math::Abs(scaleStep.x),
+            std::max(Math::Abs(scaleStep.y), Math::Abs(scaleStep.z)));
+        encode(static_cast<unsigned short>(times.size()), &times[0], &translates[0], &rotations[0],
+            &scales[0], translateTolerance, Radian(0), scaleTolerance);
+    }
+    //---------------------------------------------------------------------
+    CompressedTransformKeyFrames::ChannelMode CompressedTransformKeyFrames::analyseVectors(
+        unsigned short numKeyFrames, const Vector3* values, const Vector3& identity, Real tolerance,
+        Vector3& base, Vector3& step)
+    {
+        Vector3 minimum = values[0], maximum = values[0];
+        for (unsigned short i = 1; i < numKeyFrames; ++i)
+        {
+            minimum.makeFloor(values[i]);
+            maximum.makeCeil(values[i]);
+        }
+        Vector3 range = maximum - minimum;
+
+        base = identity;
+        step = Vector3::ZERO;
+        bool identityWithinTolerance = true, constant = true, quantisable = true;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            identityWithinTolerance &= maximum[c] - identity[c] <= tolerance &&
+                identity[c] - minimum[c] <= tolerance;
+            constant &= range[c] <= 2 * tolerance;
+            // Rounding is off by at most half a step
+            quantisable &= range[c] <= 2 * tolerance * VECTOR_SCALE;
+        }
+
+        if (identityWithinTolerance)
+            return CM_IDENTITY;
+        if (constant)
+        {
+            // The middle of the range is within tolerance of every value
+            base = minimum.midPoint(maximum);
+            return CM_CONSTANT;
+        }
+        if (!quantisable)
+            return CM_FULL;
+
+        base = minimum;
+        step = range / VECTOR_SCALE;
+        return CM_QUANTISED;
+    }
+    //---------------------------------------------------------------------
+    void CompressedTransformKeyFrames::storeVectors(Channel channel, const Vector3* values,
+        const Vector3& base, const Vector3& step)
+    {
+        if (Real* full = mFull[channel])
+        {
+            for (unsigned short i = 0; i < mNumKeyFrames; ++i, full += 3)
+            {
+                full[0] = values[i].x;
+                full[1] = values[i].y;
+                full[2] = values[i].z;
+            }
+        }
+        else if (uint16* quantised = mQuantised[channel])
+        {
+            for (unsigned short i = 0; i < mNumKeyFrames; ++i)
+            {
+                for (size_t c = 0; c < 3; ++c, ++quantised)
+                {
+                    Real v = step[c] > 0 ? (values[i][c] - base[c]) / step[c] : 0;
+                    *quantised = static_cast<uint16>(Math::Clamp(v + 0.5f, Real(0), VECTOR_SCALE));
+                }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    Vector3 CompressedTransformKeyFrames::decodeVector(Channel channel, unsigned short index,
+        const Vector3& identity, const Vector3& base, const Vector3& step) const
+    {
+        assert(index < mNumKeyFrames);
+        switch (mModes[channel])
+        {
+        case CM_CONSTANT:
+            return base;
+        case CM_QUANTISED:
+        {
+            const uint16* quantised = mQuantised[channel] + 3 * index;
+            return Vector3(base.x + quantised[0] * step.x, base.y + quantised[1] * step.y,
+                base.z + quantised[2] * step.z);
+        }
+        case CM_FULL:
+            return Vector3(mFull[channel] + 3 * index);
+        default:
+            return identity;
+        }
+    }
+    //---------------------------------------------------------------------
+    Vector3 CompressedTransformKeyFrames::getTranslate(unsigned short index) const
+    {
+        return decodeVector(CH_TRANSLATE, index, Vector3::ZERO, mTranslateBase, mTranslateStep);
+    }
+    //---------------------------------------------------------------------
+    Quaternion CompressedTransformKeyFrames::getRotation(unsigned short index) const
+    {
+        assert(index < mNumKeyFrames);
+        if (mModes[CH_ROTATION] == CM_QUANTISED)
+            return decodeRotation(mQuantised[CH_ROTATION] + 3 * index);
+        return mRotation;
+    }
+    //---------------------------------------------------------------------
+    Vector3 CompressedTransformKeyFrames::getScale(unsigned short index) const
+    {
+        return decodeVector(CH_SCALE, index, Vector3::UNIT_SCALE, mScaleBase, mScaleStep);
+    }
+    //---------------------------------------------------------------------
+    void CompressedTransformKeyFrames::getKeyFrame(unsigned short index, TransformKeyFrame* kf) const
+    {
+        kf->setTranslate(getTranslate(index));
+        kf->setRotation(getRotation(index));
+        kf->setScale(getScale(index));
+    }
+
+}
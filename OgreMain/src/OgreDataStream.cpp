@@ -30,6 +30,19 @@ THE SOFTWARE.
 #include "OgreLogManager.h"
 #include "OgreException.h"
 
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  if !defined(NOMINMAX) && defined(_MSC_VER)
+#   define NOMINMAX // required to stop windows.h messing up std::min
+#  endif
+#  include <windows.h>
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
 namespace Ogre {
 
     //-----------------------------------------------------------------------
@@ -761,4 +774,95 @@ namespace Ogre {
     }
     //-----------------------------------------------------------------------
 
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    MemoryMappedDataStream::MemoryMappedDataStream(const String& name, const String& path)
+        : MemoryDataStream(name, 0, 0, false, true)
+    {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            OGRE_EXCEPT(Exception::ERR_FILE_NOT_FOUND,
+                "Cannot open file: " + path, "MemoryMappedDataStream::MemoryMappedDataStream");
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        mSize = static_cast<size_t>(fileSize.QuadPart);
+        if (mSize)
+        {
+            // The view keeps the mapping and file alive, so the handles can be closed now
+            HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+            if (mapping)
+            {
+                mData = static_cast<uchar*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#elif OGRE_PLATFORM == OGRE_PLATFORM_WINRT
+        OGRE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED,
+            "Memory mapping files is not supported on this platform",
+            "MemoryMappedDataStream::MemoryMappedDataStream");
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            OGRE_EXCEPT(Exception::ERR_FILE_NOT_FOUND,
+                "Cannot open file: " + path, "MemoryMappedDataStream::MemoryMappedDataStream");
+        }
+        struct stat tagStat;
+        if (fstat(fd, &tagStat) == 0)
+            mSize = static_cast<size_t>(tagStat.st_size);
+        if (mSize)
+        {
+            // The mapping keeps the file alive, so it can be closed now
+            void* data = mmap(0, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                mData = static_cast<uchar*>(data);
+#   ifdef MADV_SEQUENTIAL
+                // Loaders mostly parse front to back, so read ahead aggressively
+                madvise(data, mSize, MADV_SEQUENTIAL);
+#   endif
+            }
+        }
+        ::close(fd);
+#endif
+        if (mSize && !mData)
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                "Cannot map file: " + path, "MemoryMappedDataStream::MemoryMappedDataStream");
+        }
+        mPos = mData;
+        mEnd = mData + mSize;
+    }
+    //-----------------------------------------------------------------------
+    MemoryMappedDataStream::~MemoryMappedDataStream()
+    {
+        close();
+    }
+    //-----------------------------------------------------------------------
+    void MemoryMappedDataStream::close(void)
+    {
+        if (mData)
+        {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+            UnmapViewOfFile(mData);
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+            munmap(mData, mSize);
+#endif
+            mData = mPos = mEnd = 0;
+        }
+    }
+    //-----------------------------------------------------------------------
+    bool MemoryMappedDataStream::isSupported(void)
+    {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WINRT
+        return false;
+#else
+        return true;
+#endif
+    }
 }
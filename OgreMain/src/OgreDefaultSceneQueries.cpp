@@ -30,6 +30,92 @@ THE SOFTWARE.
 #include "OgreRoot.h"
 
 namespace Ogre {
+    namespace
+    {
+        /// Whether an object found in the scene query tree passes the filters of a query
+        inline bool passesQuery(const MovableObject* obj, uint32 typeMask, uint32 queryMask)
+        {
+            return (obj->getTypeFlags() & typeMask) &&
+                (obj->getQueryFlags() & queryMask) &&
+                obj->isInScene();
+        }
+
+        /// Collects the proxies reported by a DynamicAABBTree query
+        struct ProxyCollector
+        {
+            vector<int>::type& proxies;
+            explicit ProxyCollector(vector<int>::type& p) : proxies(p) {}
+            bool operator()(int proxy) { proxies.push_back(proxy); return true; }
+        };
+
+        /// Reports the pairs of an object with the objects of a tree query it intersects
+        struct IntersectionPairCallback
+        {
+            const DynamicAABBTree* tree;
+            int proxyA;
+            MovableObject* a;
+            uint32 typeMask;
+            uint32 queryMask;
+            IntersectionSceneQueryListener* listener;
+
+            bool operator()(int proxyB)
+            {
+                // Each pair is found from both sides, report it from the lower proxy
+                if (proxyB <= proxyA)
+                    return true;
+                MovableObject* b = static_cast<MovableObject*>(tree->getUserData(proxyB));
+                if (passesQuery(b, typeMask, queryMask) &&
+                    a->getWorldBoundingBox().intersects(b->getWorldBoundingBox()))
+                {
+                    return listener->queryResult(a, b);
+                }
+                return true;
+            }
+        };
+
+        /// Reports the objects of a tree query whose world box intersects a box
+        struct BoxQueryCallback
+        {
+            const DynamicAABBTree* tree;
+            const AxisAlignedBox& box;
+            uint32 typeMask;
+            uint32 queryMask;
+            SceneQueryListener* listener;
+
+            bool operator()(int proxy)
+            {
+                MovableObject* a = static_cast<MovableObject*>(tree->getUserData(proxy));
+                if (passesQuery(a, typeMask, queryMask) &&
+                    box.intersects(a->getWorldBoundingBox()))
+                {
+                    return listener->queryResult(a);
+                }
+                return true;
+            }
+        };
+
+        /// Reports the objects of a tree query whose world box is hit by a ray
+        struct RayQueryCallback
+        {
+            const DynamicAABBTree* tree;
+            const Ray& ray;
+            uint32 typeMask;
+            uint32 queryMask;
+            RaySceneQueryListener* listener;
+
+            bool operator()(int proxy)
+            {
+                MovableObject* a = static_cast<MovableObject*>(tree->getUserData(proxy));
+                if (passesQuery(a, typeMask, queryMask))
+                {
+                    std::pair<bool, Real> result = ray.intersects(a->getWorldBoundingBox());
+                    if (result.first)
+                        return listener->queryResult(a, result.second);
+                }
+                return true;
+            }
+        };
+    }
     //---------------------------------------------------------------------
     DefaultIntersectionSceneQuery::DefaultIntersectionSceneQuery(SceneManager* creator)
     : IntersectionSceneQuery(creator)
@@ -44,6 +130,26 @@ namespace Ogre {
     //---------------------------------------------------------------------
     void DefaultIntersectionSceneQuery::execute(IntersectionSceneQueryListener* listener)
     {
+        if (const DynamicAABBTree* tree = mParentSceneMgr->_getQueryTree())
+        {
+            // Query the tree with the box of each object in turn
+            vector<int>::type proxies;
+            ProxyCollector collector(proxies);
+            tree->query(AxisAlignedBox::BOX_INFINITE, collector);
+
+            IntersectionPairCallback callback = { tree, 0, 0, mQueryTypeMask, mQueryMask, listener };
+            for (size_t i = 0; i < proxies.size(); ++i)
+            {
+                callback.proxyA = proxies[i];
+                callback.a = static_cast<MovableObject*>(tree->getUserData(proxies[i]));
+                if (!passesQuery(callback.a, mQueryTypeMask, mQueryMask))
+                    continue;
+                if (!tree->query(callback.a->getWorldBoundingBox(), callback))
+                    return;
+            }
+            return;
+        }
+
         // Iterate over all movable types
         Root::MovableObjectFactoryIterator factIt = 
             Root::getSingleton().getMovableObjectFactoryIterator();
@@ -134,6 +240,13 @@ namespace Ogre {
     //---------------------------------------------------------------------
     void DefaultAxisAlignedBoxSceneQuery::execute(SceneQueryListener* listener)
     {
+        if (const DynamicAABBTree* tree = mParentSceneMgr->_getQueryTree())
+        {
+            BoxQueryCallback callback = { tree, mAABB, mQueryTypeMask, mQueryMask, listener };
+            tree->query(mAABB, callback);
+            return;
+        }
+
         // Iterate over all movable types
         Root::MovableObjectFactoryIterator factIt = 
             Root::getSingleton().getMovableObjectFactoryIterator();
@@ -172,6 +285,13 @@ namespace Ogre {
     //---------------------------------------------------------------------
     void DefaultRaySceneQuery::execute(RaySceneQueryListener* listener)
     {
+        if (const DynamicAABBTree* tree = mParentSceneMgr->_getQueryTree())
+        {
+            RayQueryCallback callback = { tree, mRay, mQueryTypeMask, mQueryMask, listener };
+            tree->raycast(mRay, callback);
+            return;
+        }
+
         // Note that because we have no scene partitioning, we actually
         // perform a complete scene search even if restricted results are
         // requested; smarter scene manager queries can utilise the paritioning 
@@ -269,6 +389,35 @@ namespace Ogre {
     //---------------------------------------------------------------------
     void DefaultPlaneBoundedVolumeListSceneQuery::execute(SceneQueryListener* listener)
     {
+        if (const DynamicAABBTree* tree = mParentSceneMgr->_getQueryTree())
+        {
+            // An object may be near several volumes, report it once
+            vector<int>::type proxies;
+            ProxyCollector collector(proxies);
+            PlaneBoundedVolumeList::iterator pi, piend;
+            piend = mVolumes.end();
+            for (pi = mVolumes.begin(); pi != piend; ++pi)
+                tree->queryVolume(*pi, collector);
+            std::sort(proxies.begin(), proxies.end());
+            proxies.erase(std::unique(proxies.begin(), proxies.end()), proxies.end());
+
+            for (size_t i = 0; i < proxies.size(); ++i)
+            {
+                MovableObject* a = static_cast<MovableObject*>(tree->getUserData(proxies[i]));
+                if (!passesQuery(a, mQueryTypeMask, mQueryMask))
+                    continue;
+                for (pi = mVolumes.begin(); pi != piend; ++pi)
+                {
+                    if (pi->intersects(a->getWorldBoundingBox()))
+                    {
+                        if (!listener->queryResult(a)) return;
+                        break;
+                    }
+                }
+            }
+            return;
+        }
+
         // Iterate over all movable types
         Root::MovableObjectFactoryIterator factIt = 
             Root::getSingleton().getMovableObjectFactoryIterator();
@@ -0,0 +1,479 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "OgreDynamicAABBTree.h"
+
+namespace Ogre {
+    namespace
+    {
+        inline Vector3 floorCopy(const Vector3& a, const Vector3& b)
+        {
+            Vector3 result(a);
+            result.makeFloor(b);
+            return result;
+        }
+
+        inline Vector3 ceilCopy(const Vector3& a, const Vector3& b)
+        {
+            Vector3 result(a);
+            result.makeCeil(b);
+            return result;
+        }
+    }
+
+
+    const int DynamicAABBTree::NULL_PROXY;
+    const int DynamicAABBTree::STACK_SIZE;
+    //-----------------------------------------------------------------------
+    DynamicAABBTree::DynamicAABBTree(Real fatness, Real minMargin)
+        : mRoot(NULL_PROXY)
+        , mFreeList(NULL_PROXY)
+        , mProxyCount(0)
+        , mFatness(fatness)
+        , mMinMargin(minMargin)
+    {
+    }
+    //-----------------------------------------------------------------------
+    DynamicAABBTree::~DynamicAABBTree()
+    {
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::clear(void)
+    {
+        mNodes.clear();
+        mInfiniteProxies.clear();
+        mRoot = NULL_PROXY;
+        mFreeList = NULL_PROXY;
+        mProxyCount = 0;
+    }
+    //-----------------------------------------------------------------------
+    int DynamicAABBTree::allocateNode(void)
+    {
+        int index;
+        if (mFreeList != NULL_PROXY)
+        {
+            index = mFreeList;
+            mFreeList = mNodes[index].parent;
+        }
+        else
+        {
+            index = static_cast<int>(mNodes.size());
+            mNodes.push_back(TreeNode());
+        }
+
+        TreeNode& node = mNodes[index];
+        node.userData = 0;
+        node.parent = NULL_PROXY;
+        node.child1 = NULL_PROXY;
+        node.child2 = NULL_PROXY;
+        node.height = 0;
+        return index;
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::freeNode(int index)
+    {
+        TreeNode& node = mNodes[index];
+        node.parent = mFreeList;
+        node.height = -1;
+        mFreeList = index;
+    }
+    //-----------------------------------------------------------------------
+    int DynamicAABBTree::createProxy(const AxisAlignedBox& box, void* userData)
+    {
+        assert(!box.isNull() && "Can't insert a null box");
+
+        const int proxy = allocateNode();
+        TreeNode& node = mNodes[proxy];
+        node.userData = userData;
+        ++mProxyCount;
+
+        if (box.isInfinite())
+        {
+            // Reported by every query, outside of the hierarchy
+            node.height = -1;
+            mInfiniteProxies.push_back(proxy);
+            return proxy;
+        }
+
+        setFatBox(node, box);
+        insertLeaf(proxy);
+        return proxy;
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::destroyProxy(int proxy)
+    {
+        assert(proxy >= 0 && proxy < static_cast<int>(mNodes.size()));
+
+        if (mNodes[proxy].height == 0)
+        {
+            removeLeaf(proxy);
+        }
+        else
+        {
+            vector<int>::type::iterator i =
+                std::find(mInfiniteProxies.begin(), mInfiniteProxies.end(), proxy);
+            assert(i != mInfiniteProxies.end());
+            mInfiniteProxies.erase(i);
+        }
+
+        freeNode(proxy);
+        --mProxyCount;
+    }
+    //-----------------------------------------------------------------------
+    bool DynamicAABBTree::moveProxy(int proxy, const AxisAlignedBox& box)
+    {
+        assert(!box.isNull() && "Can't move to a null box");
+
+        TreeNode& node = mNodes[proxy];
+        const bool wasInfinite = node.height != 0;
+        if (box.isInfinite())
+        {
+            if (wasInfinite)
+                return false;
+            removeLeaf(proxy);
+            node.height = -1;
+            mInfiniteProxies.push_back(proxy);
+            return true;
+        }
+
+        if (wasInfinite)
+        {
+            mInfiniteProxies.erase(
+                std::find(mInfiniteProxies.begin(), mInfiniteProxies.end(), proxy));
+        }
+        else
+        {
+            const Vector3& boxMin = box.getMinimum();
+            const Vector3& boxMax = box.getMaximum();
+            if (node.minimum.x <= boxMin.x && node.minimum.y <= boxMin.y && node.minimum.z <= boxMin.z &&
+                node.maximum.x >= boxMax.x && node.maximum.y >= boxMax.y && node.maximum.z >= boxMax.z)
+            {
+                // Still inside the fat box
+                return false;
+            }
+            removeLeaf(proxy);
+        }
+
+        setFatBox(node, box);
+        node.height = 0;
+        insertLeaf(proxy);
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::setFatBox(TreeNode& node, const AxisAlignedBox& box) const
+    {
+        Vector3 margin = box.getSize() * mFatness;
+        margin.makeCeil(Vector3(mMinMargin, mMinMargin, mMinMargin));
+        node.minimum = box.getMinimum() - margin;
+        node.maximum = box.getMaximum() + margin;
+    }
+    //-----------------------------------------------------------------------
+    Real DynamicAABBTree::surfaceArea(const Vector3& minimum, const Vector3& maximum)
+    {
+        const Vector3 d = maximum - minimum;
+        return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::insertLeaf(int leaf)
+    {
+        if (mRoot == NULL_PROXY)
+        {
+            mRoot = leaf;
+            mNodes[leaf].parent = NULL_PROXY;
+            return;
+        }
+
+        // Find the best sibling, descending towards the child whose cost of
+        // enlargement is lowest (surface area heuristic)
+        const Vector3 leafMin = mNodes[leaf].minimum;
+        const Vector3 leafMax = mNodes[leaf].maximum;
+        int index = mRoot;
+        while (!mNodes[index].isLeaf())
+        {
+            const TreeNode& node = mNodes[index];
+            const int child1 = node.child1;
+            const int child2 = node.child2;
+
+            const Real area = surfaceArea(node.minimum, node.maximum);
+            const Real combinedArea = surfaceArea(
+                floorCopy(node.minimum, leafMin), ceilCopy(node.maximum, leafMax));
+
+            // Cost of creating a new parent for this node and the leaf
+            const Real cost = 2 * combinedArea;
+            // Minimum cost of pushing the leaf further down the tree
+            const Real inheritanceCost = 2 * (combinedArea - area);
+
+            Real childCost[2];
+            const int children[2] = { child1, child2 };
+            for (int c = 0; c < 2; ++c)
+            {
+                const TreeNode& child = mNodes[children[c]];
+                const Real enlargedArea = surfaceArea(
+                    floorCopy(child.minimum, leafMin), ceilCopy(child.maximum, leafMax));
+                childCost[c] = child.isLeaf() ? enlargedArea + inheritanceCost :
+                    enlargedArea - surfaceArea(child.minimum, child.maximum) + inheritanceCost;
+            }
+
+            if (cost < childCost[0] && cost < childCost[1])
+                break;
+
+            index = childCost[0] < childCost[1] ? child1 : child2;
+        }
+
+        // Create a new parent for the sibling and the leaf
+        const int sibling = index;
+        const int oldParent = mNodes[sibling].parent;
+        const int newParent = allocateNode();
+        {
+            TreeNode& parent = mNodes[newParent];
+            parent.parent = oldParent;
+            parent.minimum = floorCopy(leafMin, mNodes[sibling].minimum);
+            parent.maximum = ceilCopy(leafMax, mNodes[sibling].maximum);
+            parent.height = mNodes[sibling].height + 1;
+            parent.child1 = sibling;
+            parent.child2 = leaf;
+        }
+
+        if (oldParent != NULL_PROXY)
+        {
+            if (mNodes[oldParent].child1 == sibling)
+                mNodes[oldParent].child1 = newParent;
+            else
+                mNodes[oldParent].child2 = newParent;
+        }
+        else
+        {
+            mRoot = newParent;
+        }
+        mNodes[sibling].parent = newParent;
+        mNodes[leaf].parent = newParent;
+
+        refit(newParent);
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::removeLeaf(int leaf)
+    {
+        if (leaf == mRoot)
+        {
+            mRoot = NULL_PROXY;
+            return;
+        }
+
+        const int parent = mNodes[leaf].parent;
+        const int grandParent = mNodes[parent].parent;
+        const int sibling = mNodes[parent].child1 == leaf ?
+            mNodes[parent].child2 : mNodes[parent].child1;
+
+        if (grandParent != NULL_PROXY)
+        {
+            // Replace the parent by the sibling
+            if (mNodes[grandParent].child1 == parent)
+                mNodes[grandParent].child1 = sibling;
+            else
+                mNodes[grandParent].child2 = sibling;
+            mNodes[sibling].parent = grandParent;
+            freeNode(parent);
+
+            refit(grandParent);
+        }
+        else
+        {
+            mRoot = sibling;
+            mNodes[sibling].parent = NULL_PROXY;
+            freeNode(parent);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void DynamicAABBTree::refit(int index)
+    {
+        // Walk back up, rebalancing and fixing the bounds and heights
+        while (index != NULL_PROXY)
+        {
+            index = balance(index);
+
+            TreeNode& node = mNodes[index];
+            const TreeNode& child1 = mNodes[node.child1];
+            const TreeNode& child2 = mNodes[node.child2];
+            node.height = 1 + std::max(child1.height, child2.height);
+            node.minimum = floorCopy(child1.minimum, child2.minimum);
+            node.maximum = ceilCopy(child1.maximum, child2.maximum);
+
+            index = node.parent;
+        }
+    }
+    //-----------------------------------------------------------------------
+    int DynamicAABBTree::balance(int iA)
+    {
+        // Performs a left or right rotation if node A is imbalanced, returns the
+        // index of the node now at A's place
+        TreeNode* A = &mNodes[iA];
+        if (A->isLeaf() || A->height < 2)
+            return iA;
+
+        const int iB = A->child1;
+        const int iC = A->child2;
+        TreeNode* B = &mNodes[iB];
+        TreeNode* C = &mNodes[iC];
+        const int balanceFactor = C->height - B->height;
+
+        if (balanceFactor > 1)
+        {
+            // Rotate C up
+            const int iF = C->child1;
+            const int iG = C->child2;
+            TreeNode* F = &mNodes[iF];
+            TreeNode* G = &mNodes[iG];
+
+            C->child1 = iA;
+            C->parent = A->parent;
+            A->parent = iC;
+            if (C->parent != NULL_PROXY)
+            {
+                if (mNodes[C->parent].child1 == iA)
+                    mNodes[C->parent].child1 = iC;
+                else
+                    mNodes[C->parent].child2 = iC;
+            }
+            else
+            {
+                mRoot = iC;
+            }
+
+            // Keep the taller of F and G under C
+            if (F->height > G->height)
+            {
+                C->child2 = iF;
+                A->child2 = iG;
+                G->parent = iA;
+                A->minimum = floorCopy(B->minimum, G->minimum);
+                A->maximum = ceilCopy(B->maximum, G->maximum);
+                C->minimum = floorCopy(A->minimum, F->minimum);
+                C->maximum = ceilCopy(A->maximum, F->maximum);
+                A->height = 1 + std::max(B->height, G->height);
+                C->height = 1 + std::max(A->height, F->height);
+            }
+            else
+            {
+                C->child2 = iG;
+                A->child2 = iF;
+                F->parent = iA;
+                A->minimum = floorCopy(B->minimum, F->minimum);
+                A->maximum = ceilCopy(B->maximum, F->maximum);
+                C->minimum = floorCopy(A->minimum, G->minimum);
+                C->maximum = ceilCopy(A->maximum, G->maximum);
+                A->height = 1 + std::max(B->height, F->height);
+                C->height = 1 + std::max(A->height, G->height);
+            }
+            return iC;
+        }
+
+        if (balanceFactor < -1)
+        {
+            // Rotate B up
+            const int iD = B->child1;
+            const int iE = B->child2;
+            TreeNode* D = &mNodes[iD];
+            TreeNode* E = &mNodes[iE];
+
+            B->child1 = iA;
+            B->parent = A->parent;
+            A->parent = iB;
+            if (B->parent != NULL_PROXY)
+            {
+                if (mNodes[B->parent].child1 == iA)
+                    mNodes[B->parent].child1 = iB;
+                else
+                    mNodes[B->parent].child2 = iB;
+            }
+            else
+            {
+                mRoot = iB;
+            }
+
+            // Keep the taller of D and E under B
+            if (D->height > E->height)
+            {
+                B->child2 = iD;
+                A->child1 = iE;
+                E->parent = iA;
+                A->minimum = floorCopy(C->minimum, E->minimum);
+                A->maximum = ceilCopy(C->maximum, E->maximum);
+                B->minimum = floorCopy(A->minimum, D->minimum);
+                B->maximum = ceilCopy(A->maximum, D->maximum);
+                A->height = 1 + std::max(C->height, E->height);
+                B->height = 1 + std::max(A->height, D->height);
+            }
+            else
+            {
+                B->child2 = iE;
+                A->child1 = iD;
+                D->parent = iA;
+                A->minimum = floorCopy(C->minimum, D->minimum);
+                A->maximum = ceilCopy(C->maximum, D->maximum);
+                B->minimum = floorCopy(A->minimum, E->minimum);
+                B->maximum = ceilCopy(A->maximum, E->maximum);
+                A->height = 1 + std::max(C->height, D->height);
+                B->height = 1 + std::max(A->height, E->height);
+            }
+            return iB;
+        }
+
+        return iA;
+    }
+    //-----------------------------------------------------------------------
+    DynamicAABBTree::RayTest::RayTest(const Ray& ray)
+        : mOrigin(ray.getOrigin())
+    {
+        const Vector3& dir = ray.getDirection();
+        // Division by zero gives infinities, which the slab test handles
+        mInvDir.x = 1 / dir.x;
+        mInvDir.y = 1 / dir.y;
+        mInvDir.z = 1 / dir.z;
+    }
+    //-----------------------------------------------------------------------
+    bool DynamicAABBTree::RayTest::operator()(const TreeNode& node) const
+    {
+        Real tmin = 0;
+        Real tmax = std::numeric_limits<Real>::max();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            Real t1 = (node.minimum[axis] - mOrigin[axis]) * mInvDir[axis];
+            Real t2 = (node.maximum[axis] - mOrigin[axis]) * mInvDir[axis];
+            // Parallel to the slab and starting inside it
+            if (t1 != t1 || t2 != t2)
+                continue;
+            if (t1 > t2)
+                std::swap(t1, t2);
+            tmin = std::max(tmin, t1);
+            tmax = std::min(tmax, t2);
+            if (tmin > tmax)
+                return false;
+        }
+        return true;
+    }
+}
@@ -46,6 +46,7 @@ Copyright (c) 2000-2014 Torus Knot Software Ltd
 #include "OgrePass.h"
 #include "OgreSkeletonInstance.h"
 #include "OgreOptimisedUtil.h"
+#include "OgreSoftwareSkinningBatch.h"
 #include "OgreSceneNode.h"
 #include "OgreLodStrategy.h"
 #include "OgreLodListener.h"
@@ -66,6 +67,8 @@ namespace Ogre {
           mBoneMatrices(NULL),
           mNumBoneMatrices(0),
           mFrameAnimationLastUpdated(std::numeric_limits<unsigned long>::max()),
+          mFrameAnimationLastBatched(std::numeric_limits<unsigned long>::max()),
+          mFrameLastQueued(std::numeric_limits<unsigned long>::max()),
           mFrameBonesLastUpdated(NULL),
           mSharedSkeletonEntities(NULL),
           mDisplaySkeleton(false),
@@ -106,6 +109,8 @@ namespace Ogre {
         mBoneMatrices(NULL),
         mNumBoneMatrices(0),
         mFrameAnimationLastUpdated(std::numeric_limits<unsigned long>::max()),
+        mFrameAnimationLastBatched(std::numeric_limits<unsigned long>::max()),
+        mFrameLastQueued(std::numeric_limits<unsigned long>::max()),
         mFrameBonesLastUpdated(NULL),
         mSharedSkeletonEntities(NULL),
         mDisplaySkeleton(false),
@@ -673,6 +678,8 @@ namespace Ogre {
             _initialise(true);
         }
 
+        mFrameLastQueued = Root::getSingleton().getNextFrameNumber();
+
         Entity* displayEntity = this;
 #if !OGRE_NO_MESHLOD
         // Check we're not using a manual LOD
@@ -874,7 +881,7 @@ namespace Ogre {
         return true;
     }
     //-----------------------------------------------------------------------
-    void Entity::updateAnimation(void)
+    void Entity::updateAnimation(SoftwareSkinningBatch* batch)
     {
         // Do nothing if not initialised yet
         if (!mInitialised)
@@ -951,6 +958,9 @@ namespace Ogre {
                 if (softwareAnimation)
                 {
                     const Matrix4* blendMatrices[256];
+                    // Vertex animation results are blended straight away, see SoftwareSkinningBatch
+                    if (hasVertexAnimation())
+                        batch = 0;
 
                     // Ok, we need to do a software blend
                     // Firstly, check out working vertex buffers
@@ -967,12 +977,21 @@ namespace Ogre {
                         Mesh::prepareMatricesForVertexBlend(blendMatrices,
                                                             mBoneMatrices, mMesh->sharedBlendIndexToBoneIndexMap);
                         // Blend, taking source from either mesh data or morph data
-                        Mesh::softwareVertexBlend(
-                            (mMesh->getSharedVertexDataAnimationType() != VAT_NONE) ?
-                            mSoftwareVertexAnimVertexData : mMesh->sharedVertexData,
-                            mSkelAnimVertexData,
-                            blendMatrices, mMesh->sharedBlendIndexToBoneIndexMap.size(),
-                            blendNormals);
+                        if (batch)
+                        {
+                            batch->addVertexBlend(mMesh->sharedVertexData, mSkelAnimVertexData,
+                                blendMatrices, mMesh->sharedBlendIndexToBoneIndexMap.size(),
+                                blendNormals);
+                        }
+                        else
+                        {
+                            Mesh::softwareVertexBlend(
+                                (mMesh->getSharedVertexDataAnimationType() != VAT_NONE) ?
+                                mSoftwareVertexAnimVertexData : mMesh->sharedVertexData,
+                                mSkelAnimVertexData,
+                                blendMatrices, mMesh->sharedBlendIndexToBoneIndexMap.size(),
+                                blendNormals);
+                        }
                     }
                     SubEntityList::iterator i, iend;
                     iend = mSubEntityList.end();
@@ -989,12 +1008,21 @@ namespace Ogre {
                             Mesh::prepareMatricesForVertexBlend(blendMatrices,
                                                                 mBoneMatrices, se->mSubMesh->blendIndexToBoneIndexMap);
                             // Blend, taking source from either mesh data or morph data
-                            Mesh::softwareVertexBlend(
-                                (se->getSubMesh()->getVertexAnimationType() != VAT_NONE)?
-                                se->mSoftwareVertexAnimVertexData : se->mSubMesh->vertexData,
-                                se->mSkelAnimVertexData,
-                                blendMatrices, se->mSubMesh->blendIndexToBoneIndexMap.size(),
-                                blendNormals);
+                            if (batch)
+                            {
+                                batch->addVertexBlend(se->mSubMesh->vertexData, se->mSkelAnimVertexData,
+                                    blendMatrices, se->mSubMesh->blendIndexToBoneIndexMap.size(),
+                                    blendNormals);
+                            }
+                            else
+                            {
+                                Mesh::softwareVertexBlend(
+                                    (se->getSubMesh()->getVertexAnimationType() != VAT_NONE)?
+                                    se->mSoftwareVertexAnimVertexData : se->mSubMesh->vertexData,
+                                    se->mSkelAnimVertexData,
+                                    blendMatrices, se->mSubMesh->blendIndexToBoneIndexMap.size(),
+                                    blendNormals);
+                            }
                         }
 
                     }
@@ -1428,6 +1456,22 @@ namespace Ogre {
             (mAnimationState->hasEnabledAnimationState() || getSkeleton()->hasManualBones());
     }
     //-----------------------------------------------------------------------
+    bool Entity::_isRecentlyQueued(void) const
+    {
+        unsigned long frameNumber = Root::getSingleton().getNextFrameNumber();
+        return mFrameLastQueued != std::numeric_limits<unsigned long>::max() &&
+            frameNumber - mFrameLastQueued <= 1;
+    }
+    //-----------------------------------------------------------------------
+    bool Entity::_isManualLodDisplayed(void) const
+    {
+#if !OGRE_NO_MESHLOD
+        return mMeshLodIndex > 0 && mMesh->hasManualLodLevel();
+#else
+        return false;
+#endif
+    }
+    //-----------------------------------------------------------------------
     VertexData* Entity::_getSkelAnimVertexData(void) const
     {
         assert (mSkelAnimVertexData && "Not software skinned or has no shared vertex data!");
@@ -1595,6 +1639,10 @@ namespace Ogre {
         assert(mChildObjectList.find(pObject->getName()) == mChildObjectList.end());
         mChildObjectList[pObject->getName()] = pObject;
         pObject->_notifyAttached(pAttachingPoint, true);
+
+        // Bones don't update the scene query tree, so the object is always tested
+        if (mManager && mManager->getSceneQueryAcceleration())
+            mManager->_updateQueryProxy(pObject, AxisAlignedBox::BOX_INFINITE);
     }
 
     //-----------------------------------------------------------------------
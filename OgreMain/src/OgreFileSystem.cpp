@@ -54,6 +54,8 @@ THE SOFTWARE.
 namespace Ogre {
 
     bool FileSystemArchive::msIgnoreHidden = true;
+    bool FileSystemArchive::msUseMemoryMapping = false;
+    size_t FileSystemArchive::msMemoryMappingThreshold = 64 * 1024;
 
     //-----------------------------------------------------------------------
     FileSystemArchive::FileSystemArchive(const String& name, const String& archType, bool readOnly )
@@ -210,6 +212,19 @@ namespace Ogre {
         assert(ret == 0 && "Problem getting file size" );
         (void)ret;  // Silence warning
 
+        if (readOnly && msUseMemoryMapping && (size_t)tagStat.st_size >= msMemoryMappingThreshold &&
+            MemoryMappedDataStream::isSupported())
+        {
+            try
+            {
+                return DataStreamPtr(OGRE_NEW MemoryMappedDataStream(filename, full_path));
+            }
+            catch (Exception&)
+            {
+                // fall back to streaming the file
+            }
+        }
+
         // Always open in binary mode
         // Also, always include reading
         std::ios::openmode mode = std::ios::in | std::ios::binary;
@@ -398,11 +398,18 @@ namespace Ogre {
     //---------------------------------------------------------------------
     Codec::DecodeResult FreeImageCodec::decode(DataStreamPtr& input) const
     {
-        // Buffer stream into memory (TODO: override IO functions instead?)
-        MemoryDataStream memStream(input, true);
+        // Decode in place if the stream is already in memory (e.g. memory mapped),
+        // otherwise buffer it into memory (TODO: override IO functions instead?)
+        MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(input.get());
+        MemoryDataStreamPtr buffered;
+        if (!memStream)
+        {
+            buffered.reset(OGRE_NEW MemoryDataStream(input, true));
+            memStream = buffered.get();
+        }
 
-        FIMEMORY* fiMem = 
-            FreeImage_OpenMemory(memStream.getPtr(), static_cast<DWORD>(memStream.size()));
+        FIMEMORY* fiMem = FreeImage_OpenMemory(memStream->getCurrentPtr(),
+            static_cast<DWORD>(memStream->size() - memStream->tell()));
 
         FIBITMAP* fiBitmap = FreeImage_LoadFromMemory(
             (FREE_IMAGE_FORMAT)mFreeImageType, fiMem);
@@ -768,8 +768,11 @@ namespace Ogre
                 {
                     if (e.dstDefinition->elementSize == e.srcDefinition->elementSize)
                     {
-                        // simple copy
-                        memcpy(pDst, pSrc, sizeof(float) * e.dstDefinition->elementSize * e.dstDefinition->arraySize);
+                        // simple copy, nothing to record when unchanged
+                        size_t size = sizeof(float) * e.dstDefinition->elementSize * e.dstDefinition->arraySize;
+                        if (memcmp(pDst, pSrc, size) == 0)
+                            continue;
+                        memcpy(pDst, pSrc, size);
                     }
                     else
                     {
@@ -811,8 +814,11 @@ namespace Ogre
                 {
                     if (e.dstDefinition->elementSize == e.srcDefinition->elementSize)
                     {
-                        // simple copy
-                        memcpy(pDst, pSrc, sizeof(double) * e.dstDefinition->elementSize * e.dstDefinition->arraySize);
+                        // simple copy, nothing to record when unchanged
+                        size_t size = sizeof(double) * e.dstDefinition->elementSize * e.dstDefinition->arraySize;
+                        if (memcmp(pDst, pSrc, size) == 0)
+                            continue;
+                        memcpy(pDst, pSrc, size);
                     }
                     else
                     {
@@ -840,8 +846,11 @@ namespace Ogre
 
                 if (e.dstDefinition->elementSize == e.srcDefinition->elementSize)
                 {
-                    // simple copy
-                    memcpy(pDst, pSrc, sizeof(int) * e.dstDefinition->elementSize * e.dstDefinition->arraySize);
+                    // simple copy, nothing to record when unchanged
+                    size_t size = sizeof(int) * e.dstDefinition->elementSize * e.dstDefinition->arraySize;
+                    if (memcmp(pDst, pSrc, size) == 0)
+                        continue;
+                    memcpy(pDst, pSrc, size);
                 }
                 else
                 {
@@ -866,8 +875,11 @@ namespace Ogre
 
                 if (e.dstDefinition->elementSize == e.srcDefinition->elementSize)
                 {
-                    // simple copy
-                    memcpy(pDst, pSrc, sizeof(uint) * e.dstDefinition->elementSize * e.dstDefinition->arraySize);
+                    // simple copy, nothing to record when unchanged
+                    size_t size = sizeof(uint) * e.dstDefinition->elementSize * e.dstDefinition->arraySize;
+                    if (memcmp(pDst, pSrc, size) == 0)
+                        continue;
+                    memcpy(pDst, pSrc, size);
                 }
                 else
                 {
@@ -913,7 +925,13 @@ namespace Ogre
             // }
             else {
                 //TODO add error
+                continue;
             }
+
+            mParams->_markRangeModified(
+                GpuConstantDefinition::getBaseType(e.dstDefinition->constType),
+                e.dstDefinition->physicalIndex,
+                e.dstDefinition->elementSize * e.dstDefinition->arraySize);
         }
     }
 
@@ -922,16 +940,21 @@ namespace Ogre
     //-----------------------------------------------------------------------------
     //      GpuProgramParameters Methods
     //-----------------------------------------------------------------------------
+    const size_t GpuProgramParameters::CONSTANT_BLOCK_SIZE;
+    //-----------------------------------------------------------------------------
     GpuProgramParameters::GpuProgramParameters() :
         mCombinedVariability(GPV_GLOBAL)
         , mTransposeMatrices(false)
         , mIgnoreMissingParams(false)
         , mActivePassIterationIndex(std::numeric_limits<size_t>::max())
+        , mConstantsVersion(1)
     {
+        markAllModified();
     }
     //-----------------------------------------------------------------------------
 
     GpuProgramParameters::GpuProgramParameters(const GpuProgramParameters& oth)
+        : mConstantsVersion(1)
     {
         *this = oth;
     }
@@ -959,10 +982,118 @@ namespace Ogre
         mTransposeMatrices = oth.mTransposeMatrices;
         mIgnoreMissingParams  = oth.mIgnoreMissingParams;
         mActivePassIterationIndex = oth.mActivePassIterationIndex;
+        markAllModified();
 
         return *this;
     }
     //---------------------------------------------------------------------
+    vector<unsigned long>::type& GpuProgramParameters::getModifiedVersions(BaseConstantType type) const
+    {
+        size_t slot, size;
+        switch (type)
+        {
+        case BCT_FLOAT:
+            slot = 0;
+            size = mFloatConstants.size();
+            break;
+        case BCT_DOUBLE:
+            slot = 1;
+            size = mDoubleConstants.size();
+            break;
+        case BCT_INT:
+        case BCT_SAMPLER:
+        case BCT_SUBROUTINE:
+            slot = 2;
+            size = mIntConstants.size();
+            break;
+        case BCT_UINT:
+        case BCT_BOOL:
+            slot = 3;
+            size = mUnsignedIntConstants.size();
+            break;
+        default:
+            OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS, "Constants of this type are not buffered",
+                "GpuProgramParameters::getModifiedVersions");
+        }
+
+        // Constants may have moved when the buffer was resized, so all count as modified
+        if (mModifiedBufferSizes[slot] != size)
+        {
+            mModifiedVersions[slot].assign((size + CONSTANT_BLOCK_SIZE - 1) / CONSTANT_BLOCK_SIZE,
+                mConstantsVersion);
+            mModifiedBufferSizes[slot] = size;
+        }
+        return mModifiedVersions[slot];
+    }
+    //---------------------------------------------------------------------
+    void GpuProgramParameters::markAllModified(void)
+    {
+        for (size_t i = 0; i < 4; ++i)
+            mModifiedBufferSizes[i] = std::numeric_limits<size_t>::max();
+    }
+    //---------------------------------------------------------------------
+    unsigned long GpuProgramParameters::_markConstantsUploaded(void)
+    {
+        // Buffers resized since are modified before this upload, not after
+        getModifiedVersions(BCT_FLOAT);
+        getModifiedVersions(BCT_DOUBLE);
+        getModifiedVersions(BCT_INT);
+        getModifiedVersions(BCT_UINT);
+        return ++mConstantsVersion;
+    }
+    //---------------------------------------------------------------------
+    bool GpuProgramParameters::_isRangeModifiedSince(BaseConstantType type, size_t physicalIndex,
+        size_t count, unsigned long version) const
+    {
+        if (!count)
+            return false;
+        const vector<unsigned long>::type& versions = getModifiedVersions(type);
+        size_t end = (physicalIndex + count - 1) / CONSTANT_BLOCK_SIZE + 1;
+        assert(end <= versions.size());
+        for (size_t b = physicalIndex / CONSTANT_BLOCK_SIZE; b < end; ++b)
+        {
+            if (versions[b] >= version)
+                return true;
+        }
+        return false;
+    }
+    //---------------------------------------------------------------------
+    void GpuProgramParameters::_getRangesModifiedSince(BaseConstantType type, unsigned long version,
+        GpuConstantRangeList& ranges) const
+    {
+        ranges.clear();
+        const vector<unsigned long>::type& versions = getModifiedVersions(type);
+        size_t numBlocks = versions.size();
+        for (size_t b = 0; b < numBlocks; )
+        {
+            if (versions[b] < version)
+            {
+                ++b;
+                continue;
+            }
+            size_t first = b;
+            while (b < numBlocks && versions[b] >= version)
+                ++b;
+            ranges.push_back(GpuConstantRange(first * CONSTANT_BLOCK_SIZE,
+                (b - first) * CONSTANT_BLOCK_SIZE));
+        }
+
+        // The last block may be partly outside of the buffer
+        if (!ranges.empty())
+        {
+            size_t size = numBlocks * CONSTANT_BLOCK_SIZE;
+            switch (type)
+            {
+            case BCT_FLOAT: size = mFloatConstants.size(); break;
+            case BCT_DOUBLE: size = mDoubleConstants.size(); break;
+            case BCT_UINT: case BCT_BOOL: size = mUnsignedIntConstants.size(); break;
+            default: size = mIntConstants.size(); break;
+            }
+            GpuConstantRange& last = ranges.back();
+            last.count = std::min(last.count, size - last.physicalIndex);
+        }
+    }
+    //---------------------------------------------------------------------
     void GpuProgramParameters::copySharedParamSetUsage(const GpuSharedParamUsageList& srcList)
     {
         mSharedParamSets.clear();
@@ -1170,13 +1301,7 @@ namespace Ogre
         assert(mFloatLogicalToPhysical && "GpuProgram hasn't set up the logical -> physical map!");
 
         size_t physicalIndex = _getFloatConstantPhysicalIndex(index, rawCount, GPV_GLOBAL);
-        assert(physicalIndex + rawCount <= mFloatConstants.size());
-        // Copy manually since cast required
-        for (size_t i = 0; i < rawCount; ++i)
-        {
-            mFloatConstants[physicalIndex + i] =
-                static_cast<float>(val[i]);
-        }
+        _writeRawConstants(physicalIndex, val, rawCount);
 
     }
     //-----------------------------------------------------------------------------
@@ -1305,28 +1430,46 @@ namespace Ogre
     void GpuProgramParameters::_writeRawConstants(size_t physicalIndex, const double* val, size_t count)
     {
         assert(physicalIndex + count <= mFloatConstants.size());
+        bool modified = false;
         for (size_t i = 0; i < count; ++i)
         {
-            mFloatConstants[physicalIndex+i] = static_cast<float>(val[i]);
+            float f = static_cast<float>(val[i]);
+            modified |= mFloatConstants[physicalIndex+i] != f;
+            mFloatConstants[physicalIndex+i] = f;
         }
+        if (modified)
+            markModified(BCT_FLOAT, physicalIndex, count);
     }
     //-----------------------------------------------------------------------------
     void GpuProgramParameters::_writeRawConstants(size_t physicalIndex, const float* val, size_t count)
     {
         assert(physicalIndex + count <= mFloatConstants.size());
-        memcpy(&mFloatConstants[physicalIndex], val, sizeof(float) * count);
+        // Only changed values need uploading again
+        if (memcmp(&mFloatConstants[physicalIndex], val, sizeof(float) * count) != 0)
+        {
+            memcpy(&mFloatConstants[physicalIndex], val, sizeof(float) * count);
+            markModified(BCT_FLOAT, physicalIndex, count);
+        }
     }
     //-----------------------------------------------------------------------------
     void GpuProgramParameters::_writeRawConstants(size_t physicalIndex, const int* val, size_t count)
     {
         assert(physicalIndex + count <= mIntConstants.size());
-        memcpy(&mIntConstants[physicalIndex], val, sizeof(int) * count);
+        if (memcmp(&mIntConstants[physicalIndex], val, sizeof(int) * count) != 0)
+        {
+            memcpy(&mIntConstants[physicalIndex], val, sizeof(int) * count);
+            markModified(BCT_INT, physicalIndex, count);
+        }
     }
     //-----------------------------------------------------------------------------
     void GpuProgramParameters::_writeRawConstants(size_t physicalIndex, const uint* val, size_t count)
     {
         assert(physicalIndex + count <= mUnsignedIntConstants.size());
-        memcpy(&mUnsignedIntConstants[physicalIndex], val, sizeof(uint) * count);
+        if (memcmp(&mUnsignedIntConstants[physicalIndex], val, sizeof(uint) * count) != 0)
+        {
+            memcpy(&mUnsignedIntConstants[physicalIndex], val, sizeof(uint) * count);
+            markModified(BCT_UINT, physicalIndex, count);
+        }
     }
     //-----------------------------------------------------------------------------
     // void GpuProgramParameters::_writeRawConstants(size_t physicalIndex, const bool* val, size_t count)
@@ -3432,6 +3575,7 @@ namespace Ogre
         mAutoConstants = source.getAutoConstantList();
         mCombinedVariability = source.mCombinedVariability;
         copySharedParamSetUsage(source.mSharedParamSets);
+        markAllModified();
     }
     //---------------------------------------------------------------------
     void GpuProgramParameters::copyMatchingNamedConstantsFrom(const GpuProgramParameters& source)
@@ -3457,6 +3601,7 @@ namespace Ogre
                         memcpy(getFloatPointer(newdef->physicalIndex),
                                source.getFloatPointer(olddef.physicalIndex),
                                sz * sizeof(float));
+                        markModified(BCT_FLOAT, newdef->physicalIndex, sz);
                     }
                     else if (newdef->isDouble())
                     {
@@ -3464,6 +3609,7 @@ namespace Ogre
                         memcpy(getDoublePointer(newdef->physicalIndex),
                                source.getDoublePointer(olddef.physicalIndex),
                                sz * sizeof(double));
+                        markModified(BCT_DOUBLE, newdef->physicalIndex, sz);
                     }
                     else if (newdef->isInt() || 
                              newdef->isSampler() || 
@@ -3472,12 +3618,14 @@ namespace Ogre
                         memcpy(getIntPointer(newdef->physicalIndex),
                                source.getIntPointer(olddef.physicalIndex),
                                sz * sizeof(int));
+                        markModified(BCT_INT, newdef->physicalIndex, sz);
                     }
                     else if (newdef->isUnsignedInt() || newdef->isBool())
                     {
                         memcpy(getUnsignedIntPointer(newdef->physicalIndex),
                                source.getUnsignedIntPointer(olddef.physicalIndex),
                                sz * sizeof(uint));
+                        markModified(BCT_UINT, newdef->physicalIndex, sz);
                     }
                     // else // bool
                     // {
@@ -3579,6 +3727,7 @@ namespace Ogre
         {
             // This is a physical index
             ++mFloatConstants[mActivePassIterationIndex];
+            markModified(BCT_FLOAT, mActivePassIterationIndex, 1);
         }
     }
     //---------------------------------------------------------------------
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "OgreMeshSerializer.h"
 #include "OgreSkeletonManager.h"
 #include "OgreHardwareBufferManager.h"
+#include "OgreDefaultHardwareBufferManager.h"
 #include "OgreIteratorWrappers.h"
 #include "OgreException.h"
 #include "OgreMeshManager.h"
@@ -48,6 +49,127 @@ THE SOFTWARE.
 #include "OgrePixelCountLodStrategy.h"
 
 namespace Ogre {
+    namespace
+    {
+        /** Creates the buffers of a mesh parsed by Mesh::prepareImpl. A buffer
+            written whole from the memory of the mesh file refers to it instead
+            of copying it, so Mesh::loadImpl copies the data from the file to the
+            real buffer once, as when parsing on load.
+        */
+        class ParsedBufferManager : public DefaultHardwareBufferManagerBase
+        {
+        public:
+            explicit ParsedBufferManager(const DataStreamPtr& source)
+                : mSource(source), mBegin(0), mEnd(0)
+            {
+                MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(source.get());
+                if (memStream)
+                {
+                    mBegin = memStream->getPtr();
+                    mEnd = mBegin + memStream->size();
+                }
+            }
+
+            /// Is the given data part of the mesh file?
+            bool holds(const void* data, size_t length) const
+            {
+                const uchar* begin = static_cast<const uchar*>(data);
+                return mBegin && begin >= mBegin && begin + length <= mEnd;
+            }
+
+            HardwareVertexBufferSharedPtr createVertexBuffer(size_t vertexSize, size_t numVerts,
+                HardwareBuffer::Usage usage, bool useShadowBuffer = false);
+            HardwareIndexBufferSharedPtr createIndexBuffer(HardwareIndexBuffer::IndexType itype,
+                size_t numIndexes, HardwareBuffer::Usage usage, bool useShadowBuffer = false);
+
+        private:
+            /// Keeps the memory of the file while buffers refer to it
+            DataStreamPtr mSource;
+            const uchar* mBegin;
+            const uchar* mEnd;
+        };
+
+        /// A vertex or index buffer created by ParsedBufferManager
+        template <class Base> class ParsedBuffer : public Base
+        {
+        public:
+            template <class Type>
+            ParsedBuffer(ParsedBufferManager* mgr, Type type, size_t count, HardwareBuffer::Usage usage)
+                : Base(mgr, type, count, usage, true, false), mParsedMgr(mgr), mFileData(0), mData(0)
+            {
+            }
+
+            ~ParsedBuffer()
+            {
+                OGRE_FREE_SIMD(mData, MEMCATEGORY_GEOMETRY);
+            }
+
+            void readData(size_t offset, size_t length, void* pDest)
+            {
+                assert((offset + length) <= this->mSizeInBytes);
+                memcpy(pDest, mFileData ? mFileData + offset : getData(true) + offset, length);
+            }
+
+            void writeData(size_t offset, size_t length, const void* pSource, bool discardWholeBuffer = false)
+            {
+                assert((offset + length) <= this->mSizeInBytes);
+                if (offset == 0 && length == this->mSizeInBytes && mParsedMgr->holds(pSource, length))
+                {
+                    OGRE_FREE_SIMD(mData, MEMCATEGORY_GEOMETRY);
+                    mData = 0;
+                    mFileData = static_cast<const uchar*>(pSource);
+                }
+                else
+                {
+                    memcpy(getData(!discardWholeBuffer) + offset, pSource, length);
+                }
+            }
+
+        protected:
+            void* lockImpl(size_t offset, size_t length, HardwareBuffer::LockOptions options)
+            {
+                if (options == HardwareBuffer::HBL_READ_ONLY && mFileData)
+                    return const_cast<uchar*>(mFileData) + offset;
+                return getData(options != HardwareBuffer::HBL_DISCARD) + offset;
+            }
+
+            void unlockImpl(void)
+            {
+            }
+
+            /// Returns memory of the buffer's own, which the data from the file is copied to if kept
+            uchar* getData(bool keepContents)
+            {
+                if (!mData)
+                {
+                    mData = static_cast<uchar*>(OGRE_MALLOC_SIMD(this->mSizeInBytes, MEMCATEGORY_GEOMETRY));
+                    if (mFileData && keepContents)
+                        memcpy(mData, mFileData, this->mSizeInBytes);
+                    mFileData = 0;
+                }
+                return mData;
+            }
+
+            ParsedBufferManager* mParsedMgr;
+            /// Part of the mesh file holding the contents, if not in mData
+            const uchar* mFileData;
+            uchar* mData;
+        };
+        //-----------------------------------------------------------------------
+        HardwareVertexBufferSharedPtr ParsedBufferManager::createVertexBuffer(size_t vertexSize,
+            size_t numVerts, HardwareBuffer::Usage usage, bool useShadowBuffer)
+        {
+            return HardwareVertexBufferSharedPtr(
+                OGRE_NEW ParsedBuffer<HardwareVertexBuffer>(this, vertexSize, numVerts, usage));
+        }
+        //-----------------------------------------------------------------------
+        HardwareIndexBufferSharedPtr ParsedBufferManager::createIndexBuffer(HardwareIndexBuffer::IndexType itype,
+            size_t numIndexes, HardwareBuffer::Usage usage, bool useShadowBuffer)
+        {
+            return HardwareIndexBufferSharedPtr(
+                OGRE_NEW ParsedBuffer<HardwareIndexBuffer>(this, itype, numIndexes, usage));
+        }
+    }
     //-----------------------------------------------------------------------
     Mesh::Mesh(ResourceManager* creator, const String& name, ResourceHandle handle,
         const String& group, bool isManual, ManualResourceLoader* loader)
@@ -63,6 +185,8 @@ namespace Ogre {
         mIndexBufferUsage(HardwareBuffer::HBU_STATIC_WRITE_ONLY),
         mVertexBufferShadowBuffer(true),
         mIndexBufferShadowBuffer(true),
+        mBufferManager(0),
+        mParsedBufferManager(0),
         mPreparedForShadowVolumes(false),
         mEdgeListsBuilt(false),
         mAutoBuildEdgeLists(true), // will be set to false by serializers of 1.30 and above
@@ -212,31 +336,78 @@ namespace Ogre {
             ResourceGroupManager::getSingleton().openResource(
                 mName, mGroup, this);
  
-        // fully prebuffer into host RAM
-        mFreshFromDisk = DataStreamPtr(OGRE_NEW MemoryDataStream(mName,mFreshFromDisk));
+        // fully prebuffer into host RAM, unless it already is (e.g. memory mapped)
+        if (!dynamic_cast<MemoryDataStream*>(mFreshFromDisk.get()))
+            mFreshFromDisk = DataStreamPtr(OGRE_NEW MemoryDataStream(mName,mFreshFromDisk));
+
+        if (!MeshManager::getSingleton().getParseMeshesOnPrepare())
+            return;
+
+        // Parse now into buffers mostly referring to the file, so all loadImpl
+        // has left to do is to create the real buffers and write each of them
+        // once. The skeleton is only named, its loading is left to loadImpl.
+        DataStreamPtr data(mFreshFromDisk);
+        mFreshFromDisk.reset();
+
+        HardwareBufferManagerBase* bufferManager = mBufferManager;
+        mParsedBufferManager = OGRE_NEW ParsedBufferManager(data);
+        mBufferManager = mParsedBufferManager;
+        try
+        {
+            MeshSerializer serializer;
+            serializer.setListener(MeshManager::getSingleton().getListener());
+            serializer.importMesh(data, this);
+        }
+        catch (...)
+        {
+            mBufferManager = bufferManager;
+            unloadImpl();
+            OGRE_DELETE mParsedBufferManager;
+            mParsedBufferManager = 0;
+            throw;
+        }
+        mBufferManager = bufferManager;
     }
     //-----------------------------------------------------------------------
     void Mesh::unprepareImpl()
     {
         mFreshFromDisk.reset();
+
+        if (mParsedBufferManager)
+        {
+            // Parsed but never uploaded
+            unloadImpl();
+            OGRE_DELETE mParsedBufferManager;
+            mParsedBufferManager = 0;
+        }
     }
     void Mesh::loadImpl()
     {
-        MeshSerializer serializer;
-        serializer.setListener(MeshManager::getSingleton().getListener());
+        if (mParsedBufferManager)
+        {
+            uploadParsedBuffers();
+            // Only named while parsing
+            if (hasSkeleton())
+                loadSkeleton();
+        }
+        else
+        {
+            MeshSerializer serializer;
+            serializer.setListener(MeshManager::getSingleton().getListener());
 
-        // If the only copy is local on the stack, it will be cleaned
-        // up reliably in case of exceptions, etc
-        DataStreamPtr data(mFreshFromDisk);
-        mFreshFromDisk.reset();
+            // If the only copy is local on the stack, it will be cleaned
+            // up reliably in case of exceptions, etc
+            DataStreamPtr data(mFreshFromDisk);
+            mFreshFromDisk.reset();
 
-        if (!data) {
-            OGRE_EXCEPT(Exception::ERR_INVALID_STATE,
-                        "Data doesn't appear to have been prepared in " + mName,
-                        "Mesh::loadImpl()");
-        }
+            if (!data) {
+                OGRE_EXCEPT(Exception::ERR_INVALID_STATE,
+                            "Data doesn't appear to have been prepared in " + mName,
+                            "Mesh::loadImpl()");
+            }
 
-        serializer.importMesh(data, this);
+            serializer.importMesh(data, this);
+        }
 
         /* check all submeshes to see if their materials should be
            updated.  If the submesh has texture aliases that match those
@@ -246,6 +417,110 @@ namespace Ogre {
         updateMaterialForAllSubMeshes();
     }
 
+    //-----------------------------------------------------------------------
+    void Mesh::uploadParsedBuffers(void)
+    {
+        HardwareBufferManagerBase* bufferManager = getHardwareBufferManager();
+
+        // Copies of the vertex data, with buffers from the real manager
+        typedef map<const VertexData*, VertexData*>::type VertexDataMap;
+        VertexDataMap vertexDataMap;
+        if (sharedVertexData)
+            vertexDataMap[sharedVertexData] = 0;
+        for (SubMeshList::iterator i = mSubMeshList.begin(); i != mSubMeshList.end(); ++i)
+        {
+            if (!(*i)->useSharedVertices && (*i)->vertexData)
+                vertexDataMap[(*i)->vertexData] = 0;
+        }
+        for (VertexDataMap::iterator i = vertexDataMap.begin(); i != vertexDataMap.end(); ++i)
+        {
+            // Shares the parsed buffers, which are replaced below
+            VertexData* dest = i->first->clone(false, bufferManager);
+            const VertexBufferBinding::VertexBufferBindingMap& bindings =
+                i->first->vertexBufferBinding->getBindings();
+            for (VertexBufferBinding::VertexBufferBindingMap::const_iterator b = bindings.begin();
+                b != bindings.end(); ++b)
+            {
+                HardwareVertexBufferSharedPtr vbuf = bufferManager->createVertexBuffer(
+                    b->second->getVertexSize(), b->second->getNumVertices(),
+                    mVertexBufferUsage, mVertexBufferShadowBuffer);
+                vbuf->copyData(*b->second, 0, 0, vbuf->getSizeInBytes(), true);
+                dest->vertexBufferBinding->setBinding(b->first, vbuf);
+            }
+            i->second = dest;
+        }
+
+        // Index buffers, which LOD levels may share
+        typedef map<HardwareIndexBuffer*, HardwareIndexBufferSharedPtr>::type IndexBufferMap;
+        IndexBufferMap indexBufferMap;
+        for (SubMeshList::iterator i = mSubMeshList.begin(); i != mSubMeshList.end(); ++i)
+        {
+            SubMesh* sm = *i;
+            if (!sm->useSharedVertices && sm->vertexData)
+                sm->vertexData = vertexDataMap[sm->vertexData];
+
+            for (size_t l = 0; l <= sm->mLodFaceList.size(); ++l)
+            {
+                IndexData* indexData = l ? sm->mLodFaceList[l - 1] : sm->indexData;
+                if (!indexData || !indexData->indexBuffer)
+                    continue;
+                HardwareIndexBufferSharedPtr& ibuf = indexBufferMap[indexData->indexBuffer.get()];
+                if (!ibuf)
+                {
+                    const HardwareIndexBufferSharedPtr& src = indexData->indexBuffer;
+                    ibuf = bufferManager->createIndexBuffer(src->getType(), src->getNumIndexes(),
+                        mIndexBufferUsage, mIndexBufferShadowBuffer);
+                    ibuf->copyData(*src, 0, 0, ibuf->getSizeInBytes(), true);
+                }
+                indexData->indexBuffer = ibuf;
+            }
+        }
+        indexBufferMap.clear();
+        if (sharedVertexData)
+            sharedVertexData = vertexDataMap[sharedVertexData];
+
+        // Morph keyframes, and the vertex data the tracks animate
+        for (AnimationList::iterator a = mAnimationsList.begin(); a != mAnimationsList.end(); ++a)
+        {
+            Animation::VertexTrackIterator t = a->second->getVertexTrackIterator();
+            while (t.hasMoreElements())
+            {
+                VertexAnimationTrack* track = t.getNext();
+                track->setAssociatedVertexData(getVertexDataByTrackHandle(track->getHandle()));
+                if (track->getAnimationType() != VAT_MORPH)
+                    continue;
+                for (unsigned short k = 0; k < track->getNumKeyFrames(); ++k)
+                {
+                    VertexMorphKeyFrame* kf = track->getVertexMorphKeyFrame(k);
+                    const HardwareVertexBufferSharedPtr& src = kf->getVertexBuffer();
+                    HardwareVertexBufferSharedPtr vbuf = bufferManager->createVertexBuffer(
+                        src->getVertexSize(), src->getNumVertices(), HardwareBuffer::HBU_STATIC, true);
+                    vbuf->copyData(*src, 0, 0, vbuf->getSizeInBytes(), true);
+                    kf->setVertexBuffer(vbuf);
+                }
+            }
+        }
+
+        // Edge lists read from the file refer to the vertex data
+        for (MeshLodUsageList::iterator u = mMeshLodUsageList.begin(); u != mMeshLodUsageList.end(); ++u)
+        {
+            if (!u->edgeData)
+                continue;
+            for (EdgeData::EdgeGroupList::iterator g = u->edgeData->edgeGroups.begin();
+                g != u->edgeData->edgeGroups.end(); ++g)
+            {
+                VertexDataMap::iterator v = vertexDataMap.find(g->vertexData);
+                if (v != vertexDataMap.end())
+                    g->vertexData = v->second;
+            }
+        }
+
+        // The parsed buffers go with the last references to them
+        for (VertexDataMap::iterator i = vertexDataMap.begin(); i != vertexDataMap.end(); ++i)
+            OGRE_DELETE i->first;
+        OGRE_DELETE mParsedBufferManager;
+        mParsedBufferManager = 0;
+    }
     //-----------------------------------------------------------------------
     void Mesh::unloadImpl()
     {
@@ -503,36 +778,39 @@ namespace Ogre {
         {
             mSkeletonName = skelName;
 
-            if (skelName.empty())
+            if (skelName.empty() || mParsedBufferManager)
             {
-                // No skeleton
+                // No skeleton, or parsed by prepareImpl, which may run in a
+                // background thread, and loadImpl loads it
                 mSkeleton.reset();
             }
             else
             {
-                // Load skeleton
-                try {
-                    mSkeleton = static_pointer_cast<Skeleton>(SkeletonManager::getSingleton().load(skelName, mGroup));
-                }
-                catch (...)
-                {
-                    mSkeleton.reset();
-                    // Log this error
-                    String msg = "Unable to load skeleton ";
-                    msg += skelName + " for Mesh " + mName
-                        + ". This Mesh will not be animated. "
-                        + "You can ignore this message if you are using an offline tool.";
-                    LogManager::getSingleton().logMessage(msg);
-
-                }
-
-
+                loadSkeleton();
             }
             if (isLoaded())
                 _dirtyState();
         }
     }
     //-----------------------------------------------------------------------
+    void Mesh::loadSkeleton(void)
+    {
+        try {
+            mSkeleton = static_pointer_cast<Skeleton>(SkeletonManager::getSingleton().load(mSkeletonName, mGroup));
+        }
+        catch (...)
+        {
+            mSkeleton.reset();
+            // Log this error
+            String msg = "Unable to load skeleton ";
+            msg += mSkeletonName + " for Mesh " + mName
+                + ". This Mesh will not be animated. "
+                + "You can ignore this message if you are using an offline tool.";
+            LogManager::getSingleton().logMessage(msg);
+
+        }
+    }
+    //-----------------------------------------------------------------------
     bool Mesh::hasSkeleton(void) const
     {
         return !(mSkeletonName.empty());
@@ -817,7 +1095,7 @@ namespace Ogre {
         }
 
         HardwareVertexBufferSharedPtr vbuf =
-            HardwareBufferManager::getSingleton().createVertexBuffer(
+            getHardwareBufferManager()->createVertexBuffer(
                 sizeof(unsigned char)*4 + sizeof(float)*numBlendWeightsPerVertex,
                 targetVertexData->vertexCount,
                 HardwareBuffer::HBU_STATIC_WRITE_ONLY,
@@ -1227,6 +1505,11 @@ namespace Ogre {
         mIndexBufferShadowBuffer = shadowBuffer;
     }
     //---------------------------------------------------------------------
+    HardwareBufferManagerBase* Mesh::getHardwareBufferManager(void) const
+    {
+        return mBufferManager ? mBufferManager : HardwareBufferManager::getSingletonPtr();
+    }
+    //---------------------------------------------------------------------
     void Mesh::mergeAdjacentTexcoords( unsigned short finalTexCoordSet,
                                         unsigned short texCoordSetToDestroy )
     {
@@ -1336,7 +1619,7 @@ namespace Ogre {
                     prevTexCoordElem->getSource());
             // Now create a new buffer, which includes the previous contents
             // plus extra space for the 3D coords
-            newBuffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+            newBuffer = getHardwareBufferManager()->createVertexBuffer(
                 origBuffer->getVertexSize() + 3*sizeof(float),
                 vertexData->vertexCount,
                 origBuffer->getUsage(),
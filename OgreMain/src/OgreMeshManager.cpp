@@ -55,6 +55,7 @@ namespace Ogre
     mBoundsPaddingFactor(0.01), mListener(0)
     {
         mPrepAllMeshesForShadowVolumes = false;
+        mParseMeshesOnPrepare = false;
 
         mLoadOrder = 350.0f;
         mResourceType = "Mesh";
@@ -965,6 +966,16 @@ namespace Ogre
         return mPrepAllMeshesForShadowVolumes;
     }
     //-----------------------------------------------------------------------
+    void MeshManager::setParseMeshesOnPrepare(bool enable)
+    {
+        mParseMeshesOnPrepare = enable;
+    }
+    //-----------------------------------------------------------------------
+    bool MeshManager::getParseMeshesOnPrepare(void) const
+    {
+        return mParseMeshesOnPrepare;
+    }
+    //-----------------------------------------------------------------------
     Real MeshManager::getBoundsPaddingFactor(void)
     {
         return mBoundsPaddingFactor;
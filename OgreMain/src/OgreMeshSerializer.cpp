@@ -51,6 +51,11 @@ namespace Ogre {
             MESH_VERSION_1_10, "[MeshSerializer_v1.100]", 
             OGRE_NEW MeshSerializerImpl()));
 
+        // Not a newer format, the same data stored smaller, at the cost of precision
+        mVersionData.push_back(OGRE_NEW MeshVersionData(
+            MESH_VERSION_1_10_COMPACT, "[MeshSerializer_v1.100_compact]", 
+            OGRE_NEW MeshSerializerImpl_Compact()));
+
         mVersionData.push_back(OGRE_NEW MeshVersionData(
             MESH_VERSION_1_8, "[MeshSerializer_v1.8]", 
             OGRE_NEW MeshSerializerImpl_v1_8()));
@@ -172,12 +177,14 @@ namespace Ogre {
 
         // Find the implementation to use
         MeshSerializerImpl* impl = 0;
+        MeshVersion version = MESH_VERSION_LEGACY;
         for (MeshVersionDataList::iterator i = mVersionData.begin(); 
              i != mVersionData.end(); ++i)
         {
             if ((*i)->versionString == ver)
             {
                 impl = (*i)->impl;
+                version = (*i)->version;
                 break;
             }
         }           
@@ -188,7 +195,7 @@ namespace Ogre {
         // Call implementation
         impl->importMesh(stream, pDest, mListener);
         // Warn on old version of mesh
-        if (ver != mVersionData[0]->versionString)
+        if (version != mVersionData[0]->version && version != MESH_VERSION_1_10_COMPACT)
         {
             LogManager::getSingleton().logMessage("WARNING: " + pDest->getName() + 
                 " is an older format (" + ver + "); you should upgrade it as soon as possible" +
@@ -264,19 +264,7 @@ namespace Ogre {
         if (indexCount > 0)
         {
             // unsigned short* faceVertexIndices ((indexCount)
-            HardwareIndexBufferSharedPtr ibuf = s->indexData->indexBuffer;
-            void* pIdx = ibuf->lock(HardwareBuffer::HBL_READ_ONLY);
-            if (idx32bit)
-            {
-                unsigned int* pIdx32 = static_cast<unsigned int*>(pIdx);
-                writeInts(pIdx32, s->indexData->indexCount);
-            }
-            else
-            {
-                unsigned short* pIdx16 = static_cast<unsigned short*>(pIdx);
-                writeShorts(pIdx16, s->indexData->indexCount);
-            }
-            ibuf->unlock();
+            writeIndexes(s->indexData->indexBuffer, indexCount);
         }
 
         pushInnerChunk(mStream);
@@ -458,20 +446,27 @@ namespace Ogre {
         vbiend = bindings.end();
         for (vbi = bindings.begin(); vbi != vbiend; ++vbi)
         {
-            const HardwareVertexBufferSharedPtr& vbuf = vbi->second;
-            size_t vbufSizeInBytes = vbuf->getVertexSize() * vertexData->vertexCount; // vbuf->getSizeInBytes() is too large for meshes prepared for shadow volumes
-            size = (MSTREAM_OVERHEAD_SIZE * 2) + (sizeof(unsigned short) * 2) + vbufSizeInBytes;
-            writeChunkHeader(M_GEOMETRY_VERTEX_BUFFER,  size);
-            // unsigned short bindIndex;    // Index to bind this buffer to
-                unsigned short tmp = vbi->first;
-            writeShorts(&tmp, 1);
-            // unsigned short vertexSize;   // Per-vertex size, must agree with declaration at this index
-            tmp = (unsigned short)vbuf->getVertexSize();
-            writeShorts(&tmp, 1);
-                pushInnerChunk(mStream);
-                {
+            writeGeometryVertexBuffer(vertexData, vbi->first, vbi->second);
+        }
+        }
+        popInnerChunk(mStream);
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::writeGeometryVertexBuffer(const VertexData* vertexData,
+        unsigned short bindIndex, const HardwareVertexBufferSharedPtr& vbuf)
+    {
+        size_t vbufSizeInBytes = vbuf->getVertexSize() * vertexData->vertexCount; // vbuf->getSizeInBytes() is too large for meshes prepared for shadow volumes
+        writeChunkHeader(M_GEOMETRY_VERTEX_BUFFER,
+            calcGeometryVertexBufferSize(vertexData, bindIndex, vbuf));
+        // unsigned short bindIndex;    // Index to bind this buffer to
+        writeShorts(&bindIndex, 1);
+        // unsigned short vertexSize;   // Per-vertex size, must agree with declaration at this index
+        unsigned short tmp = (unsigned short)vbuf->getVertexSize();
+        writeShorts(&tmp, 1);
+        pushInnerChunk(mStream);
+        {
             // Data
-            size = MSTREAM_OVERHEAD_SIZE + vbufSizeInBytes;
+            size_t size = MSTREAM_OVERHEAD_SIZE + vbufSizeInBytes;
             writeChunkHeader(M_GEOMETRY_VERTEX_BUFFER_DATA, size);
             void* pBuf = vbuf->lock(HardwareBuffer::HBL_READ_ONLY);
 
@@ -485,7 +480,7 @@ namespace Ogre {
                     tempData,
                     vertexData->vertexCount,
                     vbuf->getVertexSize(),
-                    vertexData->vertexDeclaration->findElementsBySource(vbi->first));
+                    vertexData->vertexDeclaration->findElementsBySource(bindIndex));
                 writeData(tempData, vbuf->getVertexSize(), vertexData->vertexCount);
                 OGRE_FREE(tempData, MEMCATEGORY_GEOMETRY);
             }
@@ -494,13 +489,24 @@ namespace Ogre {
                 writeData(pBuf, vbuf->getVertexSize(), vertexData->vertexCount);
             }
             vbuf->unlock();
-        }
-                popInnerChunk(mStream);
-            }
         }
         popInnerChunk(mStream);
     }
     //---------------------------------------------------------------------
+    void MeshSerializerImpl::writeIndexes(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount)
+    {
+        void* pIdx = ibuf->lock(HardwareBuffer::HBL_READ_ONLY);
+        if (ibuf->getType() == HardwareIndexBuffer::IT_32BIT)
+        {
+            writeInts(static_cast<uint32*>(pIdx), indexCount);
+        }
+        else
+        {
+            writeShorts(static_cast<uint16*>(pIdx), indexCount);
+        }
+        ibuf->unlock();
+    }
+    //---------------------------------------------------------------------
     size_t MeshSerializerImpl::calcSubMeshNameTableSize(const Mesh* pMesh)
     {
         size_t size = MSTREAM_OVERHEAD_SIZE;
@@ -595,13 +601,9 @@ namespace Ogre {
         // bool indexes32bit
         size += sizeof(bool);
 
-        bool idx32bit = (pSub->indexData->indexBuffer &&
-            pSub->indexData->indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT);
         // unsigned int* / unsigned short* faceVertexIndices
-        if (idx32bit)
-            size += sizeof(unsigned int) * pSub->indexData->indexCount;
-        else
-            size += sizeof(unsigned short) * pSub->indexData->indexCount;
+        if (pSub->indexData->indexCount > 0)
+            size += calcIndexesSize(pSub->indexData->indexBuffer, pSub->indexData->indexCount);
 
         // Geometry
         if (!pSub->useSharedVertices)
@@ -661,19 +663,28 @@ namespace Ogre {
         size += MSTREAM_OVERHEAD_SIZE + elemList.size() * (MSTREAM_OVERHEAD_SIZE + sizeof(unsigned short)* 5);
         
         // Buffers and bindings
-        size += bindings.size() * ((MSTREAM_OVERHEAD_SIZE * 2) + (sizeof(unsigned short)* 2));
-
-        // Buffer data
         VertexBufferBinding::VertexBufferBindingMap::const_iterator vbi, vbiend;
         vbiend = bindings.end();
         for (vbi = bindings.begin(); vbi != vbiend; ++vbi)
         {
-            const HardwareVertexBufferSharedPtr& vbuf = vbi->second;
-            size += vbuf->getVertexSize() * vertexData->vertexCount; // vbuf->getSizeInBytes() is too large for meshes prepared for shadow volumes
+            size += calcGeometryVertexBufferSize(vertexData, vbi->first, vbi->second);
         }
         return size;
     }
     //---------------------------------------------------------------------
+    size_t MeshSerializerImpl::calcGeometryVertexBufferSize(const VertexData* vertexData,
+        unsigned short bindIndex, const HardwareVertexBufferSharedPtr& vbuf)
+    {
+        // Header, bind index and vertex size, and data chunk
+        return (MSTREAM_OVERHEAD_SIZE * 2) + (sizeof(unsigned short) * 2) +
+            vbuf->getVertexSize() * vertexData->vertexCount; // vbuf->getSizeInBytes() is too large for meshes prepared for shadow volumes
+    }
+    //---------------------------------------------------------------------
+    size_t MeshSerializerImpl::calcIndexesSize(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount)
+    {
+        return ibuf->getIndexSize() * indexCount;
+    }
+    //---------------------------------------------------------------------
     void MeshSerializerImpl::readGeometry(DataStreamPtr& stream, Mesh* pMesh,
         VertexData* dest)
     {
@@ -690,7 +701,8 @@ namespace Ogre {
             unsigned short streamID = readChunk(stream);
             while(!stream->eof() &&
                 (streamID == M_GEOMETRY_VERTEX_DECLARATION ||
-                 streamID == M_GEOMETRY_VERTEX_BUFFER ))
+                 streamID == M_GEOMETRY_VERTEX_BUFFER ||
+                 streamID == M_GEOMETRY_COMPACT_VERTEX_BUFFER))
             {
                 switch (streamID)
                 {
@@ -700,6 +712,9 @@ namespace Ogre {
                 case M_GEOMETRY_VERTEX_BUFFER:
                     readGeometryVertexBuffer(stream, pMesh, dest);
                     break;
+                case M_GEOMETRY_COMPACT_VERTEX_BUFFER:
+                    readGeometryCompactVertexBuffer(stream, pMesh, dest);
+                    break;
                 }
                 // Get next stream
                 if (!stream->eof())
@@ -817,21 +832,24 @@ namespace Ogre {
 
         // Create / populate vertex buffer
         HardwareVertexBufferSharedPtr vbuf;
-        vbuf = HardwareBufferManager::getSingleton().createVertexBuffer(
+        vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
             vertexSize,
             dest->vertexCount,
             pMesh->mVertexBufferUsage,
             pMesh->mVertexBufferShadowBuffer);
-        void* pBuf = vbuf->lock(HardwareBuffer::HBL_DISCARD);
-        stream->read(pBuf, dest->vertexCount * vertexSize);
-
-        // endian conversion for OSX
-        flipFromLittleEndian(
-            pBuf,
-            dest->vertexCount,
-            vertexSize,
-            dest->vertexDeclaration->findElementsBySource(bindIndex));
-        vbuf->unlock();
+        if (!readBufferInPlace(stream, vbuf.get()))
+        {
+            void* pBuf = vbuf->lock(HardwareBuffer::HBL_DISCARD);
+            stream->read(pBuf, dest->vertexCount * vertexSize);
+
+            // endian conversion for OSX
+            flipFromLittleEndian(
+                pBuf,
+                dest->vertexCount,
+                vertexSize,
+                dest->vertexDeclaration->findElementsBySource(bindIndex));
+            vbuf->unlock();
+        }
 
         // Set binding
         dest->vertexBufferBinding->setBinding(bindIndex, vbuf);
@@ -924,7 +942,7 @@ namespace Ogre {
                 switch(streamID)
                 {
                 case M_GEOMETRY:
-                    pMesh->sharedVertexData = OGRE_NEW VertexData();
+                    pMesh->sharedVertexData = OGRE_NEW VertexData(pMesh->getHardwareBufferManager());
                     try {
                         readGeometry(stream, pMesh, pMesh->sharedVertexData);
                     }
@@ -1011,37 +1029,14 @@ namespace Ogre {
         readBools(stream, &idx32bit, 1);
         if (indexCount > 0)
         {
-            if (idx32bit)
-            {
-                ibuf = HardwareBufferManager::getSingleton().
-                    createIndexBuffer(
-                        HardwareIndexBuffer::IT_32BIT,
-                        sm->indexData->indexCount,
-                        pMesh->mIndexBufferUsage,
-                        pMesh->mIndexBufferShadowBuffer);
-                // unsigned int* faceVertexIndices
-                unsigned int* pIdx = static_cast<unsigned int*>(
-                    ibuf->lock(HardwareBuffer::HBL_DISCARD)
-                    );
-                readInts(stream, pIdx, sm->indexData->indexCount);
-                ibuf->unlock();
-
-            }
-            else // 16-bit
-            {
-                ibuf = HardwareBufferManager::getSingleton().
-                    createIndexBuffer(
-                        HardwareIndexBuffer::IT_16BIT,
-                        sm->indexData->indexCount,
-                        pMesh->mIndexBufferUsage,
-                        pMesh->mIndexBufferShadowBuffer);
-                // unsigned short* faceVertexIndices
-                unsigned short* pIdx = static_cast<unsigned short*>(
-                    ibuf->lock(HardwareBuffer::HBL_DISCARD)
-                    );
-                readShorts(stream, pIdx, sm->indexData->indexCount);
-                ibuf->unlock();
-            }
+            ibuf = pMesh->getHardwareBufferManager()->
+                createIndexBuffer(
+                    idx32bit ? HardwareIndexBuffer::IT_32BIT : HardwareIndexBuffer::IT_16BIT,
+                    sm->indexData->indexCount,
+                    pMesh->mIndexBufferUsage,
+                    pMesh->mIndexBufferShadowBuffer);
+            // unsigned int* / unsigned short* faceVertexIndices
+            readIndexes(stream, ibuf);
         }
         sm->indexData->indexBuffer = ibuf;
 
@@ -1056,7 +1051,7 @@ namespace Ogre {
                 OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR, "Missing geometry data in mesh file",
                     "MeshSerializerImpl::readSubMesh");
             }
-            sm->vertexData = OGRE_NEW VertexData();
+            sm->vertexData = OGRE_NEW VertexData(pMesh->getHardwareBufferManager());
             readGeometry(stream, pMesh, sm->vertexData);
         }
 
@@ -1284,20 +1279,7 @@ namespace Ogre {
 
             if (bufIndexCount > 0)
             {
-                if (is32BitIndices)
-                {
-                    unsigned int* pIdx = static_cast<unsigned int*>(
-                        ibuf->lock(HardwareBuffer::HBL_READ_ONLY));
-                    writeInts(pIdx, bufIndexCount);
-                    ibuf->unlock();
-                }
-                else
-                {
-                    unsigned short* pIdx = static_cast<unsigned short*>(
-                        ibuf->lock(HardwareBuffer::HBL_READ_ONLY));
-                    writeShorts(pIdx, bufIndexCount);
-                    ibuf->unlock();
-                }
+                writeIndexes(ibuf, bufIndexCount);
             }
         }
     }
@@ -1379,7 +1361,8 @@ namespace Ogre {
         if(bufferIndex == (unsigned int)-1) {
             size += sizeof(bool); // bool indexes32Bit
             size += sizeof(unsigned int); // unsigned int ibuf->getNumIndexes()
-            size += !ibuf ? 0 : static_cast<unsigned long>(ibuf->getIndexSize() * ibuf->getNumIndexes()); // faces
+            if (ibuf && ibuf->getNumIndexes() > 0)
+                size += calcIndexesSize(ibuf, ibuf->getNumIndexes()); // faces
         }
         return size;
     }
@@ -1479,8 +1462,8 @@ namespace Ogre {
                         unsigned int buffIndexCount;
                         readInts(stream, &buffIndexCount, 1);
 
-                        size_t buffSize = buffIndexCount * (idx32Bit ? 4 : 2);
-                        stream->skip(buffSize);
+                        if (buffIndexCount > 0)
+                            skipIndexes(stream, buffIndexCount, idx32Bit);
                     }
                 }
                 break;
@@ -1596,26 +1579,53 @@ namespace Ogre {
                 unsigned int buffIndexCount;
                 readInts(stream, &buffIndexCount, 1);
 
-                indexData->indexBuffer = HardwareBufferManager::getSingleton().
+                indexData->indexBuffer = pMesh->getHardwareBufferManager()->
                     createIndexBuffer(idx32Bit ? HardwareIndexBuffer::IT_32BIT : HardwareIndexBuffer::IT_16BIT,
                     buffIndexCount, pMesh->mIndexBufferUsage, pMesh->mIndexBufferShadowBuffer);
-                void* pIdx = static_cast<unsigned int*>(indexData->indexBuffer->lock(
-                    0, indexData->indexBuffer->getSizeInBytes(), HardwareBuffer::HBL_DISCARD));
 
                 // unsigned short*/int* faceIndexes;  ((v1, v2, v3) * numFaces)
-                if (idx32Bit)
-                {
-                    readInts(stream, (uint32*)pIdx, buffIndexCount);
-                }
-                else
-                {
-                    readShorts(stream, (uint16*)pIdx, buffIndexCount);
-                }
-                indexData->indexBuffer->unlock();
+                if (buffIndexCount > 0)
+                    readIndexes(stream, indexData->indexBuffer);
             }
         }
     }
 #endif
+    //---------------------------------------------------------------------
+    bool MeshSerializerImpl::readBufferInPlace(DataStreamPtr& stream, HardwareBuffer* buf)
+    {
+        MemoryDataStream* memStream = mFlipEndian ? 0 : dynamic_cast<MemoryDataStream*>(stream.get());
+        size_t size = buf->getSizeInBytes();
+        if (!memStream || memStream->size() - memStream->tell() < size)
+            return false;
+
+        // A single discarding write, so no lock and no copy through a
+        // locked scratch area or shadow buffer per element
+        buf->writeData(0, size, memStream->getCurrentPtr(), true);
+        memStream->skip(static_cast<long>(size));
+        return true;
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::readIndexes(DataStreamPtr& stream, const HardwareIndexBufferSharedPtr& ibuf)
+    {
+        if (readBufferInPlace(stream, ibuf.get()))
+            return;
+
+        void* pIdx = ibuf->lock(HardwareBuffer::HBL_DISCARD);
+        if (ibuf->getType() == HardwareIndexBuffer::IT_32BIT)
+        {
+            readInts(stream, static_cast<uint32*>(pIdx), ibuf->getNumIndexes());
+        }
+        else
+        {
+            readShorts(stream, static_cast<uint16*>(pIdx), ibuf->getNumIndexes());
+        }
+        ibuf->unlock();
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::skipIndexes(DataStreamPtr& stream, size_t indexCount, bool idx32Bit)
+    {
+        stream->skip(static_cast<long>(indexCount * (idx32Bit ? sizeof(uint32) : sizeof(uint16))));
+    }
     //---------------------------------------------------------------------
     void MeshSerializerImpl::flipFromLittleEndian(void* pData, size_t vertexCount,
         size_t vertexSize, const VertexDeclaration::VertexElementList& elems)
@@ -2632,7 +2642,7 @@ namespace Ogre {
                 switch(streamID)
                 {
                 case M_ANIMATION_MORPH_KEYFRAME:
-                    readMorphKeyFrame(stream, track);
+                    readMorphKeyFrame(stream, pMesh, track);
                     break;
                 case M_ANIMATION_POSE_KEYFRAME:
                     readPoseKeyFrame(stream, track);
@@ -2654,7 +2664,7 @@ namespace Ogre {
 
     }
     //---------------------------------------------------------------------
-    void MeshSerializerImpl::readMorphKeyFrame(DataStreamPtr& stream, VertexAnimationTrack* track)
+    void MeshSerializerImpl::readMorphKeyFrame(DataStreamPtr& stream, Mesh* pMesh, VertexAnimationTrack* track)
     {
         // float time
         float timePos;
@@ -2670,14 +2680,17 @@ namespace Ogre {
         size_t vertexCount = track->getAssociatedVertexData()->vertexCount;
         size_t vertexSize = sizeof(float) * (includesNormals ? 6 : 3);
         HardwareVertexBufferSharedPtr vbuf =
-            HardwareBufferManager::getSingleton().createVertexBuffer(
+            pMesh->getHardwareBufferManager()->createVertexBuffer(
                 vertexSize, vertexCount,
                 HardwareBuffer::HBU_STATIC, true);
-        // float x,y,z          // repeat by number of vertices in original geometry
-        float* pDst = static_cast<float*>(
-            vbuf->lock(HardwareBuffer::HBL_DISCARD));
-        readFloats(stream, pDst, vertexCount * (includesNormals ? 6 : 3));
-        vbuf->unlock();
+        if (!readBufferInPlace(stream, vbuf.get()))
+        {
+            // float x,y,z          // repeat by number of vertices in original geometry
+            float* pDst = static_cast<float*>(
+                vbuf->lock(HardwareBuffer::HBL_DISCARD));
+            readFloats(stream, pDst, vertexCount * (includesNormals ? 6 : 3));
+            vbuf->unlock();
+        }
         kf->setVertexBuffer(vbuf);
 
     }
@@ -2756,6 +2769,482 @@ namespace Ogre {
     }
 
 
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    namespace
+    {
+        /// Largest error of texture coordinates stored as half floats
+        const float HALF_TEXCOORD_TOLERANCE = 1.0f / 4096;
+        /// Largest difference from unit length of vectors stored octahedrally
+        const float OCTAHEDRAL_LENGTH_TOLERANCE = 1e-3f;
+
+        float signNotZero(float value)
+        {
+            return value < 0 ? -1.0f : 1.0f;
+        }
+
+        int16 toSnorm16(float value)
+        {
+            return static_cast<int16>(Math::Floor(Math::Clamp(value, -1.0f, 1.0f) * 32767 + 0.5f));
+        }
+
+        /// Projects a unit vector onto the octahedron, and folds the lower half over
+        void encodeOctahedral(const float* v, int16* oct)
+        {
+            float l1 = Math::Abs(v[0]) + Math::Abs(v[1]) + Math::Abs(v[2]);
+            float x = v[0] / l1, y = v[1] / l1;
+            if (v[2] < 0)
+            {
+                float fx = (1 - Math::Abs(y)) * signNotZero(x);
+                y = (1 - Math::Abs(x)) * signNotZero(y);
+                x = fx;
+            }
+            oct[0] = toSnorm16(x);
+            oct[1] = toSnorm16(y);
+        }
+
+        void decodeOctahedral(int16 a, int16 b, float* v)
+        {
+            float x = std::max(a / 32767.0f, -1.0f), y = std::max(b / 32767.0f, -1.0f);
+            float z = 1 - Math::Abs(x) - Math::Abs(y);
+            if (z < 0)
+            {
+                float fx = (1 - Math::Abs(y)) * signNotZero(x);
+                y = (1 - Math::Abs(x)) * signNotZero(y);
+                x = fx;
+            }
+            float invLength = Math::InvSqrt(x * x + y * y + z * z);
+            v[0] = x * invLength;
+            v[1] = y * invLength;
+            v[2] = z * invLength;
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::readGeometryCompactVertexBuffer(DataStreamPtr& stream,
+        Mesh* pMesh, VertexData* dest)
+    {
+        unsigned short bindIndex, vertexSize;
+        // unsigned short bindIndex;    // Index to bind this buffer to
+        readShorts(stream, &bindIndex, 1);
+        // unsigned short vertexSize;   // Per-vertex size, must agree with declaration at this index
+        readShorts(stream, &vertexSize, 1);
+        if (dest->vertexDeclaration->getVertexSize(bindIndex) != vertexSize)
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR, "Buffer vertex size does not agree with vertex declaration",
+                "MeshSerializerImpl::readGeometryCompactVertexBuffer");
+        }
+
+        // Empty buffers are written uncompressed, so only a corrupt file gets here
+        size_t vertexCount = dest->vertexCount;
+        if (!vertexCount)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS,
+                "Compact vertex buffer without vertices in " + pMesh->getName(),
+                "MeshSerializerImpl::readGeometryCompactVertexBuffer");
+        }
+
+        // Decoded in system memory, so the buffer is written once
+        vector<uchar>::type vertices(vertexSize * vertexCount);
+        vector<uint16>::type values;
+        const VertexDeclaration::VertexElementList elems =
+            dest->vertexDeclaration->findElementsBySource(bindIndex);
+        for (VertexDeclaration::VertexElementList::const_iterator e = elems.begin(); e != elems.end(); ++e)
+        {
+            uint16 encoding;
+            readShorts(stream, &encoding, 1);
+            uchar* pElem = &vertices[0] + e->getOffset();
+            unsigned short numComponents = VertexElement::getTypeCount(e->getType());
+            bool validType;
+            switch (encoding)
+            {
+            case CVE_RAW:
+                validType = true;
+                break;
+            case CVE_QUANTISED_POSITION:
+            case CVE_OCTAHEDRAL:
+                validType = e->getType() == VET_FLOAT3;
+                break;
+            case CVE_HALF:
+                validType = VertexElement::getBaseType(e->getType()) == VET_FLOAT1;
+                break;
+            default:
+                // Corrupt or from a newer version, the data that follows can't be skipped
+                validType = false;
+                break;
+            }
+            if (!validType)
+            {
+                OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS,
+                    "Invalid compact vertex encoding in " + pMesh->getName(),
+                    "MeshSerializerImpl::readGeometryCompactVertexBuffer");
+            }
+
+            switch (encoding)
+            {
+            case CVE_RAW:
+            {
+                size_t elemSize = e->getSize();
+                vector<uchar>::type raw(elemSize * vertexCount);
+                stream->read(&raw[0], raw.size());
+                VertexDeclaration::VertexElementList rawElems(1,
+                    VertexElement(0, 0, e->getType(), e->getSemantic(), e->getIndex()));
+                flipFromLittleEndian(&raw[0], vertexCount, elemSize, rawElems);
+                for (size_t v = 0; v < vertexCount; ++v)
+                    memcpy(pElem + v * vertexSize, &raw[v * elemSize], elemSize);
+                break;
+            }
+            case CVE_QUANTISED_POSITION:
+            {
+                float base[3], step[3];
+                readFloats(stream, base, 3);
+                readFloats(stream, step, 3);
+                values.resize(vertexCount * 3);
+                readShorts(stream, &values[0], values.size());
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    float* pFloat = reinterpret_cast<float*>(pElem + v * vertexSize);
+                    for (size_t c = 0; c < 3; ++c)
+                        pFloat[c] = base[c] + values[v * 3 + c] * step[c];
+                }
+                break;
+            }
+            case CVE_OCTAHEDRAL:
+                values.resize(vertexCount * 2);
+                readShorts(stream, &values[0], values.size());
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    decodeOctahedral(static_cast<int16>(values[v * 2]), static_cast<int16>(values[v * 2 + 1]),
+                        reinterpret_cast<float*>(pElem + v * vertexSize));
+                }
+                break;
+            case CVE_HALF:
+                values.resize(vertexCount * numComponents);
+                readShorts(stream, &values[0], values.size());
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    float* pFloat = reinterpret_cast<float*>(pElem + v * vertexSize);
+                    for (size_t c = 0; c < numComponents; ++c)
+                        pFloat[c] = Bitwise::halfToFloat(values[v * numComponents + c]);
+                }
+                break;
+            }
+        }
+
+        HardwareVertexBufferSharedPtr vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
+            vertexSize,
+            vertexCount,
+            pMesh->mVertexBufferUsage,
+            pMesh->mVertexBufferShadowBuffer);
+        vbuf->writeData(0, vertices.size(), &vertices[0], true);
+        dest->vertexBufferBinding->setBinding(bindIndex, vbuf);
+    }
+    //---------------------------------------------------------------------
+    MeshSerializerImpl_Compact::MeshSerializerImpl_Compact()
+    {
+        // Version number
+        mVersion = "[MeshSerializer_v1.100_compact]";
+    }
+    //---------------------------------------------------------------------
+    MeshSerializerImpl_Compact::~MeshSerializerImpl_Compact()
+    {
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl_Compact::getCompactEncodings(const VertexData* vertexData,
+        const VertexDeclaration::VertexElementList& elems, const uchar* pBuf, size_t vertexSize,
+        vector<uint16>::type& encodings)
+    {
+        encodings.clear();
+        for (VertexDeclaration::VertexElementList::const_iterator e = elems.begin(); e != elems.end(); ++e)
+        {
+            VertexElementSemantic semantic = e->getSemantic();
+            uint16 encoding = CVE_RAW;
+            if (e->getType() == VET_FLOAT3 && semantic == VES_POSITION)
+            {
+                encoding = CVE_QUANTISED_POSITION;
+            }
+            else if (e->getType() == VET_FLOAT3 &&
+                (semantic == VES_NORMAL || semantic == VES_TANGENT || semantic == VES_BINORMAL))
+            {
+                // Only directions survive the encoding
+                encoding = CVE_OCTAHEDRAL;
+                for (size_t v = 0; v < vertexData->vertexCount && encoding != CVE_RAW; ++v)
+                {
+                    const float* pFloat = reinterpret_cast<const float*>(pBuf + v * vertexSize + e->getOffset());
+                    Real length = Vector3(pFloat).length();
+                    if (Math::Abs(length - 1) > OCTAHEDRAL_LENGTH_TOLERANCE)
+                        encoding = CVE_RAW;
+                }
+            }
+            else if (semantic == VES_TEXTURE_COORDINATES && VertexElement::getBaseType(e->getType()) == VET_FLOAT1)
+            {
+                encoding = CVE_HALF;
+                unsigned short numComponents = VertexElement::getTypeCount(e->getType());
+                for (size_t v = 0; v < vertexData->vertexCount && encoding != CVE_RAW; ++v)
+                {
+                    const float* pFloat = reinterpret_cast<const float*>(pBuf + v * vertexSize + e->getOffset());
+                    for (size_t c = 0; c < numComponents; ++c)
+                    {
+                        float error = Bitwise::halfToFloat(Bitwise::floatToHalf(pFloat[c])) - pFloat[c];
+                        if (!(Math::Abs(error) <= HALF_TEXCOORD_TOLERANCE))
+                            encoding = CVE_RAW;
+                    }
+                }
+            }
+            encodings.push_back(encoding);
+        }
+    }
+    //---------------------------------------------------------------------
+    size_t MeshSerializerImpl_Compact::calcCompactElementsSize(
+        const VertexDeclaration::VertexElementList& elems, const vector<uint16>::type& encodings,
+        size_t vertexCount)
+    {
+        size_t size = 0;
+        VertexDeclaration::VertexElementList::const_iterator e = elems.begin();
+        for (size_t i = 0; i < encodings.size(); ++i, ++e)
+        {
+            // unsigned short encoding
+            size += sizeof(uint16);
+            switch (encodings[i])
+            {
+            case CVE_RAW:
+                size += e->getSize() * vertexCount;
+                break;
+            case CVE_QUANTISED_POSITION:
+                size += sizeof(float) * 6 + sizeof(uint16) * 3 * vertexCount;
+                break;
+            case CVE_OCTAHEDRAL:
+                size += sizeof(int16) * 2 * vertexCount;
+                break;
+            case CVE_HALF:
+                size += sizeof(uint16) * VertexElement::getTypeCount(e->getType()) * vertexCount;
+                break;
+            }
+        }
+        return size;
+    }
+    //---------------------------------------------------------------------
+    size_t MeshSerializerImpl_Compact::calcGeometryVertexBufferSize(const VertexData* vertexData,
+        unsigned short bindIndex, const HardwareVertexBufferSharedPtr& vbuf)
+    {
+        if (!vertexData->vertexCount)
+            return MeshSerializerImpl::calcGeometryVertexBufferSize(vertexData, bindIndex, vbuf);
+
+        const VertexDeclaration::VertexElementList elems =
+            vertexData->vertexDeclaration->findElementsBySource(bindIndex);
+        vector<uint16>::type encodings;
+        const uchar* pBuf = static_cast<const uchar*>(vbuf->lock(HardwareBuffer::HBL_READ_ONLY));
+        getCompactEncodings(vertexData, elems, pBuf, vbuf->getVertexSize(), encodings);
+        vbuf->unlock();
+
+        // Header, bind index and vertex size, then the elements
+        return MSTREAM_OVERHEAD_SIZE + sizeof(unsigned short) * 2 +
+            calcCompactElementsSize(elems, encodings, vertexData->vertexCount);
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl_Compact::writeGeometryVertexBuffer(const VertexData* vertexData,
+        unsigned short bindIndex, const HardwareVertexBufferSharedPtr& vbuf)
+    {
+        if (!vertexData->vertexCount)
+        {
+            MeshSerializerImpl::writeGeometryVertexBuffer(vertexData, bindIndex, vbuf);
+            return;
+        }
+
+        size_t vertexCount = vertexData->vertexCount;
+        size_t vertexSize = vbuf->getVertexSize();
+        const VertexDeclaration::VertexElementList elems =
+            vertexData->vertexDeclaration->findElementsBySource(bindIndex);
+        vector<uint16>::type encodings;
+        const uchar* pBuf = static_cast<const uchar*>(vbuf->lock(HardwareBuffer::HBL_READ_ONLY));
+        getCompactEncodings(vertexData, elems, pBuf, vertexSize, encodings);
+
+        writeChunkHeader(M_GEOMETRY_COMPACT_VERTEX_BUFFER, MSTREAM_OVERHEAD_SIZE +
+            sizeof(unsigned short) * 2 + calcCompactElementsSize(elems, encodings, vertexCount));
+        // unsigned short bindIndex;    // Index to bind this buffer to
+        writeShorts(&bindIndex, 1);
+        // unsigned short vertexSize;   // Per-vertex size, must agree with declaration at this index
+        uint16 tmp = static_cast<uint16>(vertexSize);
+        writeShorts(&tmp, 1);
+
+        vector<uint16>::type values;
+        VertexDeclaration::VertexElementList::const_iterator e = elems.begin();
+        for (size_t i = 0; i < encodings.size(); ++i, ++e)
+        {
+            writeShorts(&encodings[i], 1);
+            const uchar* pElem = pBuf + e->getOffset();
+            unsigned short numComponents = VertexElement::getTypeCount(e->getType());
+            switch (encodings[i])
+            {
+            case CVE_RAW:
+            {
+                size_t elemSize = e->getSize();
+                vector<uchar>::type raw(elemSize * vertexCount);
+                for (size_t v = 0; v < vertexCount; ++v)
+                    memcpy(&raw[v * elemSize], pElem + v * vertexSize, elemSize);
+                VertexDeclaration::VertexElementList rawElems(1,
+                    VertexElement(0, 0, e->getType(), e->getSemantic(), e->getIndex()));
+                flipToLittleEndian(&raw[0], vertexCount, elemSize, rawElems);
+                writeData(&raw[0], elemSize, vertexCount);
+                break;
+            }
+            case CVE_QUANTISED_POSITION:
+            {
+                // Quantised within the bounds of this buffer
+                AxisAlignedBox bounds;
+                for (size_t v = 0; v < vertexCount; ++v)
+                    bounds.merge(Vector3(reinterpret_cast<const float*>(pElem + v * vertexSize)));
+                float base[3], step[3];
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    base[c] = bounds.getMinimum()[c];
+                    step[c] = (bounds.getMaximum()[c] - base[c]) / 65535;
+                }
+                writeFloats(base, 3);
+                writeFloats(step, 3);
+
+                values.resize(vertexCount * 3);
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    const float* pFloat = reinterpret_cast<const float*>(pElem + v * vertexSize);
+                    for (size_t c = 0; c < 3; ++c)
+                    {
+                        float q = step[c] > 0 ? Math::Floor((pFloat[c] - base[c]) / step[c] + 0.5f) : 0;
+                        values[v * 3 + c] = static_cast<uint16>(Math::Clamp(q, 0.0f, 65535.0f));
+                    }
+                }
+                writeShorts(&values[0], values.size());
+                break;
+            }
+            case CVE_OCTAHEDRAL:
+                values.resize(vertexCount * 2);
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    int16 oct[2];
+                    encodeOctahedral(reinterpret_cast<const float*>(pElem + v * vertexSize), oct);
+                    values[v * 2] = static_cast<uint16>(oct[0]);
+                    values[v * 2 + 1] = static_cast<uint16>(oct[1]);
+                }
+                writeShorts(&values[0], values.size());
+                break;
+            case CVE_HALF:
+                values.resize(vertexCount * numComponents);
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    const float* pFloat = reinterpret_cast<const float*>(pElem + v * vertexSize);
+                    for (size_t c = 0; c < numComponents; ++c)
+                        values[v * numComponents + c] = Bitwise::floatToHalf(pFloat[c]);
+                }
+                writeShorts(&values[0], values.size());
+                break;
+            }
+        }
+        vbuf->unlock();
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl_Compact::encodeIndexes(const HardwareIndexBufferSharedPtr& ibuf,
+        size_t indexCount, vector<uchar>::type& encoded)
+    {
+        encoded.clear();
+        const void* pIdx = ibuf->lock(HardwareBuffer::HBL_READ_ONLY);
+        bool idx32Bit = ibuf->getType() == HardwareIndexBuffer::IT_32BIT;
+        uint32 previous = 0;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            uint32 index = idx32Bit ? static_cast<const uint32*>(pIdx)[i] : static_cast<const uint16*>(pIdx)[i];
+            // Zigzag, so small steps back are small numbers too, then 7 bits per byte
+            int32 delta = static_cast<int32>(index - previous);
+            uint32 value = (static_cast<uint32>(delta) << 1) ^ static_cast<uint32>(delta >> 31);
+            while (value >= 0x80)
+            {
+                encoded.push_back(static_cast<uchar>(value | 0x80));
+                value >>= 7;
+            }
+            encoded.push_back(static_cast<uchar>(value));
+            previous = index;
+        }
+        ibuf->unlock();
+    }
+    //---------------------------------------------------------------------
+    size_t MeshSerializerImpl_Compact::calcIndexesSize(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount)
+    {
+        vector<uchar>::type encoded;
+        encodeIndexes(ibuf, indexCount, encoded);
+        // unsigned int encodedSize, unsigned char* encodedIndices
+        return sizeof(uint32) + encoded.size();
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl_Compact::writeIndexes(const HardwareIndexBufferSharedPtr& ibuf, size_t indexCount)
+    {
+        vector<uchar>::type encoded;
+        encodeIndexes(ibuf, indexCount, encoded);
+        uint32 encodedSize = static_cast<uint32>(encoded.size());
+        writeInts(&encodedSize, 1);
+        if (!encoded.empty())
+            writeData(&encoded[0], 1, encoded.size());
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl_Compact::readIndexes(DataStreamPtr& stream, const HardwareIndexBufferSharedPtr& ibuf)
+    {
+        uint32 encodedSize;
+        readInts(stream, &encodedSize, 1);
+
+        // Decoded straight from the stream when it is in memory
+        vector<uchar>::type buffer;
+        const uchar* pEncoded;
+        MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(stream.get());
+        if (memStream && memStream->size() - memStream->tell() >= encodedSize)
+        {
+            pEncoded = memStream->getCurrentPtr();
+            memStream->skip(static_cast<long>(encodedSize));
+        }
+        else
+        {
+            buffer.resize(encodedSize + 1);
+            encodedSize = static_cast<uint32>(stream->read(&buffer[0], encodedSize));
+            pEncoded = &buffer[0];
+        }
+        const uchar* pEnd = pEncoded + encodedSize;
+
+        void* pIdx = ibuf->lock(HardwareBuffer::HBL_DISCARD);
+        bool idx32Bit = ibuf->getType() == HardwareIndexBuffer::IT_32BIT;
+        size_t indexCount = ibuf->getNumIndexes();
+        uint32 index = 0;
+        size_t i = 0;
+        for (; i < indexCount; ++i)
+        {
+            uint32 value = 0;
+            uchar byte = 0x80;
+            for (uint32 shift = 0; (byte & 0x80) && pEncoded != pEnd && shift < 32; shift += 7)
+            {
+                byte = *pEncoded++;
+                value |= static_cast<uint32>(byte & 0x7F) << shift;
+            }
+            if (byte & 0x80)
+                break;
+            index += (value >> 1) ^ (0u - (value & 1));
+            if (idx32Bit)
+                static_cast<uint32*>(pIdx)[i] = index;
+            else
+                static_cast<uint16*>(pIdx)[i] = static_cast<uint16>(index);
+        }
+        ibuf->unlock();
+
+        if (i != indexCount)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS, "Truncated compact index data in " + stream->getName(),
+                "MeshSerializerImpl_Compact::readIndexes");
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl_Compact::skipIndexes(DataStreamPtr& stream, size_t indexCount, bool idx32Bit)
+    {
+        uint32 encodedSize;
+        readInts(stream, &encodedSize, 1);
+        stream->skip(static_cast<long>(encodedSize));
+    }
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
@@ -3029,7 +3518,7 @@ namespace Ogre {
                 // unsigned short*/int* faceIndexes;  ((v1, v2, v3) * numFaces)
                 if (idx32Bit)
                 {
-                    indexData->indexBuffer = HardwareBufferManager::getSingleton().
+                    indexData->indexBuffer = pMesh->getHardwareBufferManager()->
                         createIndexBuffer(HardwareIndexBuffer::IT_32BIT, indexData->indexCount,
                         pMesh->mIndexBufferUsage, pMesh->mIndexBufferShadowBuffer);
                     unsigned int* pIdx = static_cast<unsigned int*>(
@@ -3044,7 +3533,7 @@ namespace Ogre {
                 }
                 else
                 {
-                    indexData->indexBuffer = HardwareBufferManager::getSingleton().
+                    indexData->indexBuffer = pMesh->getHardwareBufferManager()->
                         createIndexBuffer(HardwareIndexBuffer::IT_16BIT, indexData->indexCount,
                         pMesh->mIndexBufferUsage, pMesh->mIndexBufferShadowBuffer);
                     unsigned short* pIdx = static_cast<unsigned short*>(
@@ -3248,7 +3737,7 @@ namespace Ogre {
         kf->getVertexBuffer()->unlock();
     }
     //---------------------------------------------------------------------
-    void MeshSerializerImpl_v1_41::readMorphKeyFrame(DataStreamPtr& stream, VertexAnimationTrack* track)
+    void MeshSerializerImpl_v1_41::readMorphKeyFrame(DataStreamPtr& stream, Mesh* pMesh, VertexAnimationTrack* track)
     {
         // float time
         float timePos;
@@ -3259,14 +3748,17 @@ namespace Ogre {
         // Create buffer, allow read and use shadow buffer
         size_t vertexCount = track->getAssociatedVertexData()->vertexCount;
         HardwareVertexBufferSharedPtr vbuf =
-            HardwareBufferManager::getSingleton().createVertexBuffer(
+            pMesh->getHardwareBufferManager()->createVertexBuffer(
                 VertexElement::getTypeSize(VET_FLOAT3), vertexCount,
                 HardwareBuffer::HBU_STATIC, true);
-        // float x,y,z          // repeat by number of vertices in original geometry
-        float* pDst = static_cast<float*>(
-            vbuf->lock(HardwareBuffer::HBL_DISCARD));
-        readFloats(stream, pDst, vertexCount * 3);
-        vbuf->unlock();
+        if (!readBufferInPlace(stream, vbuf.get()))
+        {
+            // float x,y,z          // repeat by number of vertices in original geometry
+            float* pDst = static_cast<float*>(
+                vbuf->lock(HardwareBuffer::HBL_DISCARD));
+            readFloats(stream, pDst, vertexCount * 3);
+            vbuf->unlock();
+        }
         kf->setVertexBuffer(vbuf);
     }
     //---------------------------------------------------------------------
@@ -4125,7 +4617,7 @@ namespace Ogre {
         HardwareVertexBufferSharedPtr vbuf;
         // float* pVertices (x, y, z order x numVertices)
         dest->vertexDeclaration->addElement(bindIdx, 0, VET_FLOAT3, VES_POSITION);
-        vbuf = HardwareBufferManager::getSingleton().createVertexBuffer(
+        vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
             dest->vertexDeclaration->getVertexSize(bindIdx),
             dest->vertexCount,
             pMesh->mVertexBufferUsage,
@@ -4144,7 +4636,7 @@ namespace Ogre {
         HardwareVertexBufferSharedPtr vbuf;
         // float* pNormals (x, y, z order x numVertices)
         dest->vertexDeclaration->addElement(bindIdx, 0, VET_FLOAT3, VES_NORMAL);
-        vbuf = HardwareBufferManager::getSingleton().createVertexBuffer(
+        vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
             dest->vertexDeclaration->getVertexSize(bindIdx),
             dest->vertexCount,
             pMesh->mVertexBufferUsage,
@@ -4163,7 +4655,7 @@ namespace Ogre {
         HardwareVertexBufferSharedPtr vbuf;
         // unsigned long* pColours (RGBA 8888 format x numVertices)
         dest->vertexDeclaration->addElement(bindIdx, 0, VET_COLOUR, VES_DIFFUSE);
-        vbuf = HardwareBufferManager::getSingleton().createVertexBuffer(
+        vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
             dest->vertexDeclaration->getVertexSize(bindIdx),
             dest->vertexCount,
             pMesh->mVertexBufferUsage,
@@ -4190,7 +4682,7 @@ namespace Ogre {
             VertexElement::multiplyTypeCount(VET_FLOAT1, dim),
             VES_TEXTURE_COORDINATES,
             texCoordSet);
-        vbuf = HardwareBufferManager::getSingleton().createVertexBuffer(
+        vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
             dest->vertexDeclaration->getVertexSize(bindIdx),
             dest->vertexCount,
             pMesh->mVertexBufferUsage,
@@ -4229,7 +4721,7 @@ namespace Ogre {
             VertexElement::multiplyTypeCount(VET_FLOAT1, dim),
             VES_TEXTURE_COORDINATES,
             texCoordSet);
-        vbuf = HardwareBufferManager::getSingleton().createVertexBuffer(
+        vbuf = pMesh->getHardwareBufferManager()->createVertexBuffer(
             dest->vertexDeclaration->getVertexSize(bindIdx),
             dest->vertexCount,
             pMesh->getVertexBufferUsage(),
@@ -61,10 +61,12 @@ namespace Ogre {
         , mRenderQueuePrioritySet(false)
         , mQueryFlags(msDefaultQueryFlags)
         , mVisibilityFlags(msDefaultVisibilityFlags)
+        , mQueryProxy(DynamicAABBTree::NULL_PROXY)
         , mCastShadows(true)
         , mRenderingDisabled(false)
         , mListener(0)
         , mLightListUpdated(0)
+        , mLightListSignature(0)
         , mLightMask(0xFFFFFFFF)
     {
         if (Root::getSingletonPtr())
@@ -89,10 +91,12 @@ namespace Ogre {
         , mRenderQueuePrioritySet(false)
         , mQueryFlags(msDefaultQueryFlags)
         , mVisibilityFlags(msDefaultVisibilityFlags)
+        , mQueryProxy(DynamicAABBTree::NULL_PROXY)
         , mCastShadows(true)
         , mRenderingDisabled(false)
         , mListener(0)
         , mLightListUpdated(0)
+        , mLightListSignature(0)
         , mLightMask(0xFFFFFFFF)
     {
         if (Root::getSingletonPtr())
@@ -131,12 +135,23 @@ namespace Ogre {
 
         bool different = (parent != mParentNode);
 
+        if (mQueryProxy != DynamicAABBTree::NULL_PROXY && mParentNode)
+        {
+            // Leave the query tree of the scene we were attached in
+            SceneManager* sceneMgr = mParentIsTagPoint ?
+                static_cast<TagPoint*>(mParentNode)->getParentEntity()->_getManager() :
+                static_cast<SceneNode*>(mParentNode)->getCreator();
+            if (sceneMgr)
+                sceneMgr->_removeQueryProxy(this);
+        }
+
         mParentNode = parent;
         mParentIsTagPoint = isTagPoint;
 
         // Mark light list being dirty, simply decrease
         // counter by one for minimise overhead
         --mLightListUpdated;
+        mLightListSignature = 0;
 
         // Call listener (note, only called if there's something to do)
         if (mListener && different)
@@ -204,6 +219,7 @@ namespace Ogre {
         // Mark light list being dirty, simply decrease
         // counter by one for minimise overhead
         --mLightListUpdated;
+        mLightListSignature = 0;
 
         // Notify listener if exists
         if (mListener)
@@ -380,8 +396,17 @@ namespace Ogre {
 
                 const Vector3& scl = mParentNode->_getDerivedScale();
                 Real factor = std::max(std::max(scl.x, scl.y), scl.z);
+                const Real radius = this->getBoundingRadius() * factor;
 
-                sn->findLights(mLightList, this->getBoundingRadius() * factor, this->getLightMask());
+                // Lights may only have changed out of reach, in which case the list
+                // would be the same
+                const uint64 signature = sn->getCreator()->_getLightListSignature(
+                    sn->_getDerivedPosition(), radius, this->getLightMask());
+                if (!signature || signature != mLightListSignature)
+                {
+                    mLightListSignature = signature;
+                    sn->findLights(mLightList, radius, this->getLightMask());
+                }
             }
         }
         else
@@ -446,6 +471,7 @@ namespace Ogre {
         this->mLightMask = lightMask;
         //make sure to request a new light list from the scene manager if mask changed
         mLightListUpdated = 0;
+        mLightListSignature = 0;
     }
     //---------------------------------------------------------------------
     class MORecvShadVisitor : public Renderable::Visitor
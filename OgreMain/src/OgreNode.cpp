@@ -45,6 +45,7 @@ namespace Ogre {
 
     NameGenerator Node::msNameGenerator("Unnamed_");
     Node::QueuedUpdates Node::msQueuedUpdates;
+    const uint32 Node::NO_PARENT_SLOT;
     //-----------------------------------------------------------------------
     Node::Node()
         :mParent(0),
@@ -251,6 +252,128 @@ namespace Ogre {
         }
     }
     //-----------------------------------------------------------------------
+    void Node::UpdateLevel::clear(void)
+    {
+        nodes.clear();
+        parentSlots.clear();
+        derivedPositions.clear();
+        derivedOrientations.clear();
+        derivedScales.clear();
+        visited.clear();
+    }
+    //-----------------------------------------------------------------------
+    void Node::_collectUpdates(UpdateLevelList& levels, size_t depth, uint32 parentSlot,
+        bool parentHasChanged)
+    {
+        // always clear information about parent notification
+        mParentNotified = false;
+
+        if (levels.size() <= depth)
+            levels.resize(depth + 1);
+
+        UpdateLevel& level = levels[depth];
+        level.visited.push_back(this);
+
+        uint32 slot = NO_PARENT_SLOT;
+        if (mNeedParentUpdate || parentHasChanged)
+        {
+            slot = static_cast<uint32>(level.nodes.size());
+            level.nodes.push_back(this);
+            level.parentSlots.push_back(parentSlot);
+        }
+
+        if (mNeedChildUpdate || parentHasChanged)
+        {
+            ChildNodeMap::iterator it, itend;
+            itend = mChildren.end();
+            for (it = mChildren.begin(); it != itend; ++it)
+            {
+                it->second->_collectUpdates(levels, depth + 1, slot, true);
+            }
+        }
+        else
+        {
+            // Just update selected children
+            ChildUpdateSet::iterator it, itend;
+            itend = mChildrenToUpdate.end();
+            for (it = mChildrenToUpdate.begin(); it != itend; ++it)
+            {
+                (*it)->_collectUpdates(levels, depth + 1, slot, false);
+            }
+        }
+
+        mChildrenToUpdate.clear();
+        mNeedChildUpdate = false;
+    }
+    //-----------------------------------------------------------------------
+    void Node::_updateLevelTransforms(UpdateLevelList& levels, size_t depth,
+        size_t begin, size_t end)
+    {
+        UpdateLevel& level = levels[depth];
+        const UpdateLevel* parentLevel = depth > 0 ? &levels[depth - 1] : 0;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const Node* node = level.nodes[i];
+            Quaternion& derivedOrientation = level.derivedOrientations[i];
+            Vector3& derivedPosition = level.derivedPositions[i];
+            Vector3& derivedScale = level.derivedScales[i];
+
+            if (node->mParent)
+            {
+                // Read the parent from the level above if it was updated in this
+                // pass, otherwise its cached transform is already valid
+                const uint32 parentSlot = level.parentSlots[i];
+                const Quaternion* parentOrientation;
+                const Vector3* parentPosition;
+                const Vector3* parentScale;
+                if (parentSlot != NO_PARENT_SLOT)
+                {
+                    parentOrientation = &parentLevel->derivedOrientations[parentSlot];
+                    parentPosition = &parentLevel->derivedPositions[parentSlot];
+                    parentScale = &parentLevel->derivedScales[parentSlot];
+                }
+                else
+                {
+                    parentOrientation = &node->mParent->mDerivedOrientation;
+                    parentPosition = &node->mParent->mDerivedPosition;
+                    parentScale = &node->mParent->mDerivedScale;
+                }
+
+                // Same combination as updateFromParentImpl
+                derivedOrientation = node->mInheritOrientation ?
+                    *parentOrientation * node->mOrientation : node->mOrientation;
+                derivedScale = node->mInheritScale ?
+                    *parentScale * node->mScale : node->mScale;
+                derivedPosition = *parentOrientation * (*parentScale * node->mPosition);
+                derivedPosition += *parentPosition;
+            }
+            else
+            {
+                // Root node, no parent
+                derivedOrientation = node->mOrientation;
+                derivedPosition = node->mPosition;
+                derivedScale = node->mScale;
+            }
+
+            node->mDerivedOrientation = derivedOrientation;
+            node->mDerivedPosition = derivedPosition;
+            node->mDerivedScale = derivedScale;
+            node->mCachedTransformOutOfDate = true;
+            node->mNeedParentUpdate = false;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void Node::_notifyDerivedUpdated(void) const
+    {
+        derivedTransformUpdatedImpl();
+
+        if (mListener)
+        {
+            mListener->nodeUpdated(this);
+        }
+    }
+    //-----------------------------------------------------------------------
     void Node::_updateFromParent(void) const
     {
         updateFromParentImpl();
@@ -30,11 +30,10 @@ THE SOFTWARE.
 #include "OgreOptimisedUtil.h"
 
 #include "OgrePlatformInformation.h"
+#include "OgreRoot.h"
+#include "OgreTaskScheduler.h"
 
 //#define __DO_PROFILE__
-#ifdef __DO_PROFILE__
-#include "OgreRoot.h"
-#endif
 
 namespace Ogre {
 
@@ -43,6 +42,9 @@ namespace Ogre {
     extern OptimisedUtil* _getOptimisedUtilGeneral(void);
 #if __OGRE_HAVE_SSE
     extern OptimisedUtil* _getOptimisedUtilSSE(void);
+#if __OGRE_HAVE_AVX2
+    extern OptimisedUtil* _getOptimisedUtilAVX2(void);
+#endif
 //#elif __OGRE_HAVE_NEON
 //    extern OptimisedUtil* _getOptimisedUtilNEON(void);
 //#elif __OGRE_HAVE_VFP
@@ -86,6 +88,9 @@ namespace Ogre {
             IMPL_DEFAULT,
 #if __OGRE_HAVE_SSE
             IMPL_SSE,
+#if __OGRE_HAVE_AVX2
+            IMPL_AVX2,
+#endif
 //#elif __OGRE_HAVE_NEON
 //            IMPL_NEON,
 //#elif __OGRE_HAVE_VFP
@@ -137,6 +142,13 @@ namespace Ogre {
             {
                 mOptimisedUtils.push_back(_getOptimisedUtilSSE());
             }
+#if __OGRE_HAVE_AVX2
+            if (PlatformInformation::hasCpuFeature(PlatformInformation::CPU_FEATURE_AVX2) &&
+                PlatformInformation::hasCpuFeature(PlatformInformation::CPU_FEATURE_FMA))
+            {
+                mOptimisedUtils.push_back(_getOptimisedUtilAVX2());
+            }
+#endif
 //#elif __OGRE_HAVE_VFP
 //            if (PlatformInformation::getCpuFeatures() & PlatformInformation::CPU_FEATURE_VFP)
 //            {
@@ -348,11 +360,266 @@ namespace Ogre {
             ++index;    // So we can put break point here even if in release build
         }
 
+        virtual void cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes)
+        {
+            static ProfileItems results;
+            static size_t index;
+            index = Root::getSingleton().getNextFrameNumber() % mOptimisedUtils.size();
+            OptimisedUtil* impl = mOptimisedUtils[index];
+            ProfileItem& profile = results[index];
+
+            profile.begin();
+            impl->cullBoxes(
+                planes,
+                numPlanes,
+                centres,
+                halfSizes,
+                visibilities,
+                numBoxes);
+            profile.end();
+
+            // You can put break point here while running test application, to
+            // watch profile results.
+            ++index;    // So we can put break point here even if in release build
+        }
+
     };
 #endif // __DO_PROFILE__
 
+    //---------------------------------------------------------------------
+    /** Splits software vertex animation into chunks run in parallel.
+    @see OptimisedUtil::setParallelVertexThreshold
+    */
+    class _OgrePrivate OptimisedUtilParallel : public OptimisedUtil
+    {
+    protected:
+        /// Fewest vertices worth handing to another thread
+        static const size_t MIN_CHUNK_VERTICES = 512;
+
+        /// Implementation running the chunks
+        OptimisedUtil* mImpl;
+
+        /// Gets the number of vertices per chunk, or 0 to animate them on the calling thread
+        static size_t getChunkSize(size_t numVertices)
+        {
+            if (numVertices < msParallelVertexThreshold || !Root::getSingletonPtr())
+                return 0;
+            TaskScheduler* scheduler = Root::getSingleton().getTaskScheduler();
+            if (!scheduler || scheduler->getConcurrency() < 2)
+                return 0;
+
+            // A few chunks per thread balance the load, and multiples of 16
+            // vertices keep the SIMD blocks whole and aligned
+            size_t chunkSize = numVertices / (scheduler->getConcurrency() * 4);
+            chunkSize = std::max(MIN_CHUNK_VERTICES, (chunkSize + 15) & ~size_t(15));
+            return chunkSize < numVertices ? chunkSize : 0;
+        }
+
+        struct SkinVertices
+        {
+            OptimisedUtil* impl;
+            size_t chunkSize;
+            size_t numVertices;
+            const float *pSrcPos;
+            float *pDestPos;
+            const float *pSrcNorm;
+            float *pDestNorm;
+            const float *pBlendWeight;
+            const unsigned char* pBlendIndex;
+            const Matrix4* const* blendMatrices;
+            size_t srcPosStride, destPosStride;
+            size_t srcNormStride, destNormStride;
+            size_t blendWeightStride, blendIndexStride;
+            size_t numWeightsPerVertex;
+
+            void operator()(size_t begin, size_t end) const
+            {
+                for (size_t chunk = begin; chunk < end; ++chunk)
+                {
+                    size_t first = chunk * chunkSize;
+                    size_t count = std::min(chunkSize, numVertices - first);
+                    impl->softwareVertexSkinning(
+                        rawOffsetPointer(pSrcPos, first * srcPosStride),
+                        rawOffsetPointer(pDestPos, first * destPosStride),
+                        pSrcNorm ? rawOffsetPointer(pSrcNorm, first * srcNormStride) : 0,
+                        pSrcNorm ? rawOffsetPointer(pDestNorm, first * destNormStride) : 0,
+                        rawOffsetPointer(pBlendWeight, first * blendWeightStride),
+                        rawOffsetPointer(pBlendIndex, first * blendIndexStride),
+                        blendMatrices,
+                        srcPosStride, destPosStride,
+                        srcNormStride, destNormStride,
+                        blendWeightStride, blendIndexStride,
+                        numWeightsPerVertex,
+                        count);
+                }
+            }
+        };
+
+        struct MorphVertices
+        {
+            OptimisedUtil* impl;
+            size_t chunkSize;
+            size_t numVertices;
+            Real t;
+            const float *pSrc1, *pSrc2;
+            float *pDst;
+            size_t pos1VSize, pos2VSize, dstVSize;
+            bool morphNormals;
+
+            void operator()(size_t begin, size_t end) const
+            {
+                for (size_t chunk = begin; chunk < end; ++chunk)
+                {
+                    size_t first = chunk * chunkSize;
+                    size_t count = std::min(chunkSize, numVertices - first);
+                    impl->softwareVertexMorph(
+                        t,
+                        rawOffsetPointer(pSrc1, first * pos1VSize),
+                        rawOffsetPointer(pSrc2, first * pos2VSize),
+                        rawOffsetPointer(pDst, first * dstVSize),
+                        pos1VSize, pos2VSize, dstVSize,
+                        count,
+                        morphNormals);
+                }
+            }
+        };
+
+    public:
+        OptimisedUtilParallel(OptimisedUtil* impl) : mImpl(impl) {}
+
+        virtual void softwareVertexSkinning(
+            const float *srcPosPtr, float *destPosPtr,
+            const float *srcNormPtr, float *destNormPtr,
+            const float *blendWeightPtr, const unsigned char* blendIndexPtr,
+            const Matrix4* const* blendMatrices,
+            size_t srcPosStride, size_t destPosStride,
+            size_t srcNormStride, size_t destNormStride,
+            size_t blendWeightStride, size_t blendIndexStride,
+            size_t numWeightsPerVertex,
+            size_t numVertices)
+        {
+            size_t chunkSize = getChunkSize(numVertices);
+            if (!chunkSize)
+            {
+                mImpl->softwareVertexSkinning(
+                    srcPosPtr, destPosPtr,
+                    srcNormPtr, destNormPtr,
+                    blendWeightPtr, blendIndexPtr,
+                    blendMatrices,
+                    srcPosStride, destPosStride,
+                    srcNormStride, destNormStride,
+                    blendWeightStride, blendIndexStride,
+                    numWeightsPerVertex,
+                    numVertices);
+                return;
+            }
+
+            SkinVertices skin = { mImpl, chunkSize, numVertices,
+                srcPosPtr, destPosPtr, srcNormPtr, destNormPtr,
+                blendWeightPtr, blendIndexPtr, blendMatrices,
+                srcPosStride, destPosStride, srcNormStride, destNormStride,
+                blendWeightStride, blendIndexStride, numWeightsPerVertex };
+            parallelFor(0, (numVertices + chunkSize - 1) / chunkSize, 1, skin, "softwareVertexSkinning");
+        }
+
+        virtual void softwareVertexMorph(
+            Real t,
+            const float *srcPos1, const float *srcPos2,
+            float *dstPos,
+            size_t pos1VSize, size_t pos2VSize, size_t dstVSize, 
+            size_t numVertices,
+            bool morphNormals)
+        {
+            size_t chunkSize = getChunkSize(numVertices);
+            if (!chunkSize)
+            {
+                mImpl->softwareVertexMorph(
+                    t, srcPos1, srcPos2, dstPos,
+                    pos1VSize, pos2VSize, dstVSize,
+                    numVertices, morphNormals);
+                return;
+            }
+
+            MorphVertices morph = { mImpl, chunkSize, numVertices, t,
+                srcPos1, srcPos2, dstPos, pos1VSize, pos2VSize, dstVSize, morphNormals };
+            parallelFor(0, (numVertices + chunkSize - 1) / chunkSize, 1, morph, "softwareVertexMorph");
+        }
+
+        virtual void concatenateAffineMatrices(
+            const Matrix4& baseMatrix,
+            const Matrix4* srcMatrices,
+            Matrix4* dstMatrices,
+            size_t numMatrices)
+        {
+            mImpl->concatenateAffineMatrices(baseMatrix, srcMatrices, dstMatrices, numMatrices);
+        }
+
+        virtual void calculateFaceNormals(
+            const float *positions,
+            const EdgeData::Triangle *triangles,
+            Vector4 *faceNormals,
+            size_t numTriangles)
+        {
+            mImpl->calculateFaceNormals(positions, triangles, faceNormals, numTriangles);
+        }
+
+        virtual void calculateLightFacing(
+            const Vector4& lightPos,
+            const Vector4* faceNormals,
+            char* lightFacings,
+            size_t numFaces)
+        {
+            mImpl->calculateLightFacing(lightPos, faceNormals, lightFacings, numFaces);
+        }
+
+        virtual void extrudeVertices(
+            const Vector4& lightPos,
+            Real extrudeDist,
+            const float* srcPositions,
+            float* destPositions,
+            size_t numVertices)
+        {
+            mImpl->extrudeVertices(lightPos, extrudeDist, srcPositions, destPositions, numVertices);
+        }
+
+        virtual void cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes)
+        {
+            mImpl->cullBoxes(planes, numPlanes, centres, halfSizes, visibilities, numBoxes);
+        }
+    };
+    const size_t OptimisedUtilParallel::MIN_CHUNK_VERTICES;
+
     //---------------------------------------------------------------------
     OptimisedUtil* OptimisedUtil::msImplementation = OptimisedUtil::_detectImplementation();
+    size_t OptimisedUtil::msParallelVertexThreshold = 0;
+
+    //---------------------------------------------------------------------
+    void OptimisedUtil::setParallelVertexThreshold(size_t minVertices)
+    {
+        // The implementation detected, which the parallel one runs the chunks with
+        static OptimisedUtil* msSerialImplementation = msImplementation;
+        static OptimisedUtilParallel msOptimisedUtilParallel(msSerialImplementation);
+
+        msParallelVertexThreshold = minVertices;
+        msImplementation = minVertices ? &msOptimisedUtilParallel : msSerialImplementation;
+    }
+    //---------------------------------------------------------------------
+    size_t OptimisedUtil::getParallelVertexThreshold(void)
+    {
+        return msParallelVertexThreshold;
+    }
 
     //---------------------------------------------------------------------
     OptimisedUtil* OptimisedUtil::_detectImplementation(void)
@@ -402,6 +669,15 @@ namespace Ogre {
 #else   // !__DO_PROFILE__
 
 #if __OGRE_HAVE_SSE
+#if __OGRE_HAVE_AVX2
+        // Skinning and morphing 8 vertices at a time, the rest is the same as SSE
+        if (PlatformInformation::hasCpuFeature(PlatformInformation::CPU_FEATURE_AVX2) &&
+            PlatformInformation::hasCpuFeature(PlatformInformation::CPU_FEATURE_FMA))
+        {
+            return _getOptimisedUtilAVX2();
+        }
+        else
+#endif
         if (PlatformInformation::getCpuFeatures() & PlatformInformation::CPU_FEATURE_SSE)
         {
             return _getOptimisedUtilSSE();
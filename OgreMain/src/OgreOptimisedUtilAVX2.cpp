@@ -0,0 +1,418 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreOptimisedUtil.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_AVX2
+
+#include "OgreMatrix4.h"
+
+#include <immintrin.h>
+
+// Unlike OgreOptimisedUtilSSE.cpp, this file is compiled with the same flags
+// as the rest of the engine. The AVX2 instructions are enabled per function
+// instead, so the binary still runs on CPUs without them as long as
+// _detectImplementation doesn't pick this implementation.
+#if OGRE_COMPILER == OGRE_COMPILER_MSVC
+#   define __OGRE_AVX2_TARGET
+#else
+#   define __OGRE_AVX2_TARGET   __attribute__((target("avx2,fma")))
+#endif
+
+namespace Ogre {
+
+    extern OptimisedUtil* _getOptimisedUtilGeneral(void);
+    extern OptimisedUtil* _getOptimisedUtilSSE(void);
+
+//-------------------------------------------------------------------------
+// Local classes
+//-------------------------------------------------------------------------
+
+    /** AVX2 and FMA implementation of OptimisedUtil.
+    @remarks
+        Vertices are processed 8 at a time as structure of arrays, so the
+        blended matrices and the transformed vertices take no horizontal
+        operations. The functions without an AVX2 version, and the vertices
+        left over once the blocks of 8 are done, are passed on to the SSE
+        implementation.
+    @note
+        Don't use this class directly, use OptimisedUtil instead.
+    */
+    class _OgrePrivate OptimisedUtilAVX2 : public OptimisedUtil
+    {
+    protected:
+        /// Implementation used for everything without an AVX2 version
+        OptimisedUtil* mFallback;
+
+    public:
+        /// Constructor
+        OptimisedUtilAVX2(OptimisedUtil* fallback) : mFallback(fallback) {}
+
+        /// @copydoc OptimisedUtil::softwareVertexSkinning
+        virtual void __OGRE_AVX2_TARGET softwareVertexSkinning(
+            const float *srcPosPtr, float *destPosPtr,
+            const float *srcNormPtr, float *destNormPtr,
+            const float *blendWeightPtr, const unsigned char* blendIndexPtr,
+            const Matrix4* const* blendMatrices,
+            size_t srcPosStride, size_t destPosStride,
+            size_t srcNormStride, size_t destNormStride,
+            size_t blendWeightStride, size_t blendIndexStride,
+            size_t numWeightsPerVertex,
+            size_t numVertices);
+
+        /// @copydoc OptimisedUtil::softwareVertexMorph
+        virtual void __OGRE_AVX2_TARGET softwareVertexMorph(
+            Real t,
+            const float *srcPos1, const float *srcPos2,
+            float *dstPos,
+            size_t pos1VSize, size_t pos2VSize, size_t dstVSize, 
+            size_t numVertices,
+            bool morphNormals);
+
+        /// @copydoc OptimisedUtil::concatenateAffineMatrices
+        virtual void concatenateAffineMatrices(
+            const Matrix4& baseMatrix,
+            const Matrix4* srcMatrices,
+            Matrix4* dstMatrices,
+            size_t numMatrices)
+        {
+            mFallback->concatenateAffineMatrices(baseMatrix, srcMatrices, dstMatrices, numMatrices);
+        }
+
+        /// @copydoc OptimisedUtil::calculateFaceNormals
+        virtual void calculateFaceNormals(
+            const float *positions,
+            const EdgeData::Triangle *triangles,
+            Vector4 *faceNormals,
+            size_t numTriangles)
+        {
+            mFallback->calculateFaceNormals(positions, triangles, faceNormals, numTriangles);
+        }
+
+        /// @copydoc OptimisedUtil::calculateLightFacing
+        virtual void calculateLightFacing(
+            const Vector4& lightPos,
+            const Vector4* faceNormals,
+            char* lightFacings,
+            size_t numFaces)
+        {
+            mFallback->calculateLightFacing(lightPos, faceNormals, lightFacings, numFaces);
+        }
+
+        /// @copydoc OptimisedUtil::extrudeVertices
+        virtual void extrudeVertices(
+            const Vector4& lightPos,
+            Real extrudeDist,
+            const float* srcPositions,
+            float* destPositions,
+            size_t numVertices)
+        {
+            mFallback->extrudeVertices(lightPos, extrudeDist, srcPositions, destPositions, numVertices);
+        }
+
+        /// @copydoc OptimisedUtil::cullBoxes
+        virtual void cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes)
+        {
+            mFallback->cullBoxes(planes, numPlanes, centres, halfSizes, visibilities, numBoxes);
+        }
+    };
+
+//-------------------------------------------------------------------------
+// Helpers
+//-------------------------------------------------------------------------
+
+    /** Transposes the 4x4 matrix in each 128-bit lane of the 4 registers.
+    @remarks
+        With 4 rows of vertices 0-3 in the low lanes and of vertices 4-7 in the
+        high lanes, this gives 4 columns holding one element of vertices 0-7.
+    */
+    static OGRE_FORCE_INLINE __OGRE_AVX2_TARGET void _transposeLanes(
+        __m256& r0, __m256& r1, __m256& r2, __m256& r3)
+    {
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    //---------------------------------------------------------------------
+    /// Loads two 4 float rows into the low and high lanes
+    static OGRE_FORCE_INLINE __OGRE_AVX2_TARGET __m256 _loadLanes(const float* low, const float* high)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(low)), _mm_load_ps(high), 1);
+    }
+    //---------------------------------------------------------------------
+    /// Byte offsets of 8 consecutive vertices, for the gathers
+    static OGRE_FORCE_INLINE __OGRE_AVX2_TARGET __m256i _vertexOffsets(size_t stride)
+    {
+        return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+            _mm256_set1_epi32(static_cast<int>(stride)));
+    }
+    //---------------------------------------------------------------------
+    /// Loads one component of 8 vertices
+    static OGRE_FORCE_INLINE __OGRE_AVX2_TARGET __m256 _gatherComponent(const float* p, __m256i offsets)
+    {
+        return _mm256_i32gather_ps(p, offsets, 1);
+    }
+    //---------------------------------------------------------------------
+    /** Stores 3 components each of 8 vertices.
+    @remarks
+        Only 3 floats are written per vertex, since elements the caller
+        doesn't own may follow them in the buffer.
+    */
+    static OGRE_FORCE_INLINE __OGRE_AVX2_TARGET void _scatterVector3(
+        float* p, size_t stride, __m256 x, __m256 y, __m256 z)
+    {
+        __m256 w = z;
+        _transposeLanes(x, y, z, w);
+        const __m256 vertices[4] = { x, y, z, w };
+        for (size_t i = 0; i < 4; ++i)
+        {
+            __m128 v = _mm256_castps256_ps128(vertices[i]);
+            _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+            _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+            float* high = rawOffsetPointer(p, 4 * stride);
+            v = _mm256_extractf128_ps(vertices[i], 1);
+            _mm_storel_pi(reinterpret_cast<__m64*>(high), v);
+            _mm_store_ss(high + 2, _mm_movehl_ps(v, v));
+            advanceRawPointer(p, stride);
+        }
+    }
+    //---------------------------------------------------------------------
+    /// Normalises 8 vectors
+    static OGRE_FORCE_INLINE __OGRE_AVX2_TARGET void _normalise(__m256& x, __m256& y, __m256& z)
+    {
+        __m256 sqLength = _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)));
+        __m256 invLength = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(sqLength));
+        x = _mm256_mul_ps(x, invLength);
+        y = _mm256_mul_ps(y, invLength);
+        z = _mm256_mul_ps(z, invLength);
+    }
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    void OptimisedUtilAVX2::softwareVertexSkinning(
+        const float *pSrcPos, float *pDestPos,
+        const float *pSrcNorm, float *pDestNorm,
+        const float *pBlendWeight, const unsigned char* pBlendIndex,
+        const Matrix4* const* blendMatrices,
+        size_t srcPosStride, size_t destPosStride,
+        size_t srcNormStride, size_t destNormStride,
+        size_t blendWeightStride, size_t blendIndexStride,
+        size_t numWeightsPerVertex,
+        size_t numVertices)
+    {
+        const __m256i srcPosOffsets = _vertexOffsets(srcPosStride);
+        const __m256i srcNormOffsets = _vertexOffsets(srcNormStride);
+        const __m256i blendWeightOffsets = _vertexOffsets(blendWeightStride);
+
+        const size_t numBlocks = numVertices / 8;
+        for (size_t block = 0; block < numBlocks; ++block)
+        {
+            // Blended 3x4 matrix of each vertex, element [row * 4 + column]
+            // holding that element for the 8 vertices
+            __m256 m[12];
+            for (size_t w = 0; w < numWeightsPerVertex; ++w)
+            {
+                const float* mat[8];
+                const unsigned char* pIndex = pBlendIndex + w;
+                for (size_t i = 0; i < 8; ++i)
+                {
+                    mat[i] = (*blendMatrices[*pIndex])[0];
+                    advanceRawPointer(pIndex, blendIndexStride);
+                }
+                const __m256 weight = _gatherComponent(pBlendWeight + w, blendWeightOffsets);
+
+                for (size_t row = 0; row < 3; ++row)
+                {
+                    __m256 c0 = _loadLanes(mat[0] + row * 4, mat[4] + row * 4);
+                    __m256 c1 = _loadLanes(mat[1] + row * 4, mat[5] + row * 4);
+                    __m256 c2 = _loadLanes(mat[2] + row * 4, mat[6] + row * 4);
+                    __m256 c3 = _loadLanes(mat[3] + row * 4, mat[7] + row * 4);
+                    _transposeLanes(c0, c1, c2, c3);
+
+                    __m256* dst = m + row * 4;
+                    if (w == 0)
+                    {
+                        dst[0] = _mm256_mul_ps(weight, c0);
+                        dst[1] = _mm256_mul_ps(weight, c1);
+                        dst[2] = _mm256_mul_ps(weight, c2);
+                        dst[3] = _mm256_mul_ps(weight, c3);
+                    }
+                    else
+                    {
+                        dst[0] = _mm256_fmadd_ps(weight, c0, dst[0]);
+                        dst[1] = _mm256_fmadd_ps(weight, c1, dst[1]);
+                        dst[2] = _mm256_fmadd_ps(weight, c2, dst[2]);
+                        dst[3] = _mm256_fmadd_ps(weight, c3, dst[3]);
+                    }
+                }
+            }
+
+            // Positions, use the 3x4 matrix
+            __m256 x = _gatherComponent(pSrcPos + 0, srcPosOffsets);
+            __m256 y = _gatherComponent(pSrcPos + 1, srcPosOffsets);
+            __m256 z = _gatherComponent(pSrcPos + 2, srcPosOffsets);
+            _scatterVector3(pDestPos, destPosStride,
+                _mm256_fmadd_ps(m[0], x, _mm256_fmadd_ps(m[1], y, _mm256_fmadd_ps(m[2], z, m[3]))),
+                _mm256_fmadd_ps(m[4], x, _mm256_fmadd_ps(m[5], y, _mm256_fmadd_ps(m[6], z, m[7]))),
+                _mm256_fmadd_ps(m[8], x, _mm256_fmadd_ps(m[9], y, _mm256_fmadd_ps(m[10], z, m[11]))));
+
+            if (pSrcNorm)
+            {
+                // Normals, use the 3x3 part and renormalise, see OptimisedUtilGeneral
+                x = _gatherComponent(pSrcNorm + 0, srcNormOffsets);
+                y = _gatherComponent(pSrcNorm + 1, srcNormOffsets);
+                z = _gatherComponent(pSrcNorm + 2, srcNormOffsets);
+                __m256 nx = _mm256_fmadd_ps(m[0], x, _mm256_fmadd_ps(m[1], y, _mm256_mul_ps(m[2], z)));
+                __m256 ny = _mm256_fmadd_ps(m[4], x, _mm256_fmadd_ps(m[5], y, _mm256_mul_ps(m[6], z)));
+                __m256 nz = _mm256_fmadd_ps(m[8], x, _mm256_fmadd_ps(m[9], y, _mm256_mul_ps(m[10], z)));
+                _normalise(nx, ny, nz);
+                _scatterVector3(pDestNorm, destNormStride, nx, ny, nz);
+
+                advanceRawPointer(pSrcNorm, 8 * srcNormStride);
+                advanceRawPointer(pDestNorm, 8 * destNormStride);
+            }
+
+            advanceRawPointer(pSrcPos, 8 * srcPosStride);
+            advanceRawPointer(pDestPos, 8 * destPosStride);
+            advanceRawPointer(pBlendWeight, 8 * blendWeightStride);
+            advanceRawPointer(pBlendIndex, 8 * blendIndexStride);
+        }
+
+        if (numVertices & 7)
+        {
+            mFallback->softwareVertexSkinning(
+                pSrcPos, pDestPos,
+                pSrcNorm, pDestNorm,
+                pBlendWeight, pBlendIndex,
+                blendMatrices,
+                srcPosStride, destPosStride,
+                srcNormStride, destNormStride,
+                blendWeightStride, blendIndexStride,
+                numWeightsPerVertex,
+                numVertices & 7);
+        }
+    }
+    //---------------------------------------------------------------------
+    void OptimisedUtilAVX2::softwareVertexMorph(
+        Real t,
+        const float *pSrc1, const float *pSrc2,
+        float *pDst,
+        size_t pos1VSize, size_t pos2VSize, size_t dstVSize, 
+        size_t numVertices,
+        bool morphNormals)
+    {
+        const size_t vertexSize = sizeof(float) * (morphNormals ? 6 : 3);
+        if (pos1VSize != vertexSize || pos2VSize != vertexSize || dstVSize != vertexSize)
+        {
+            // Interleaved with other elements, which are left alone
+            _getOptimisedUtilGeneral()->softwareVertexMorph(
+                t, pSrc1, pSrc2, pDst, pos1VSize, pos2VSize, dstVSize, numVertices, morphNormals);
+            return;
+        }
+
+        // The buffers are packed, so lerp them as plain arrays of floats first
+        const __m256 t8 = _mm256_set1_ps(t);
+        const size_t numFloats = numVertices * vertexSize / sizeof(float);
+        size_t i = 0;
+        for (; i + 32 <= numFloats; i += 32)
+        {
+            __m256 a0 = _mm256_loadu_ps(pSrc1 + i);
+            __m256 a1 = _mm256_loadu_ps(pSrc1 + i + 8);
+            __m256 a2 = _mm256_loadu_ps(pSrc1 + i + 16);
+            __m256 a3 = _mm256_loadu_ps(pSrc1 + i + 24);
+            __m256 b0 = _mm256_loadu_ps(pSrc2 + i);
+            __m256 b1 = _mm256_loadu_ps(pSrc2 + i + 8);
+            __m256 b2 = _mm256_loadu_ps(pSrc2 + i + 16);
+            __m256 b3 = _mm256_loadu_ps(pSrc2 + i + 24);
+            _mm256_storeu_ps(pDst + i, _mm256_fmadd_ps(t8, _mm256_sub_ps(b0, a0), a0));
+            _mm256_storeu_ps(pDst + i + 8, _mm256_fmadd_ps(t8, _mm256_sub_ps(b1, a1), a1));
+            _mm256_storeu_ps(pDst + i + 16, _mm256_fmadd_ps(t8, _mm256_sub_ps(b2, a2), a2));
+            _mm256_storeu_ps(pDst + i + 24, _mm256_fmadd_ps(t8, _mm256_sub_ps(b3, a3), a3));
+        }
+        for (; i < numFloats; i += 8)
+        {
+            // Masked off floats are neither read nor written
+            const __m256i mask = _mm256_cmpgt_epi32(
+                _mm256_set1_epi32(static_cast<int>(numFloats - i)),
+                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            __m256 a = _mm256_maskload_ps(pSrc1 + i, mask);
+            __m256 b = _mm256_maskload_ps(pSrc2 + i, mask);
+            _mm256_maskstore_ps(pDst + i, mask, _mm256_fmadd_ps(t8, _mm256_sub_ps(b, a), a));
+        }
+
+        if (morphNormals)
+        {
+            // The lerped normals follow each position, renormalise them in place
+            const __m256i offsets = _vertexOffsets(vertexSize);
+            float* pNorm = pDst + 3;
+            const size_t numBlocks = numVertices / 8;
+            for (size_t block = 0; block < numBlocks; ++block)
+            {
+                __m256 x = _gatherComponent(pNorm + 0, offsets);
+                __m256 y = _gatherComponent(pNorm + 1, offsets);
+                __m256 z = _gatherComponent(pNorm + 2, offsets);
+                _normalise(x, y, z);
+                _scatterVector3(pNorm, vertexSize, x, y, z);
+                pNorm += 8 * 6;
+            }
+            for (size_t n = numBlocks * 8; n < numVertices; ++n)
+            {
+                __m128 v = _mm_loadh_pi(_mm_load_ss(pNorm + 2), reinterpret_cast<const __m64*>(pNorm));
+                __m128 sqLength = _mm_dp_ps(v, v, 0xFF);
+                v = _mm_div_ps(v, _mm_sqrt_ps(sqLength));
+                _mm_storeh_pi(reinterpret_cast<__m64*>(pNorm), v);
+                _mm_store_ss(pNorm + 2, v);
+                pNorm += 6;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    extern OptimisedUtil* _getOptimisedUtilAVX2(void)
+    {
+        static OptimisedUtilAVX2 msOptimisedUtilAVX2(_getOptimisedUtilSSE());
+        return &msOptimisedUtilAVX2;
+    }
+
+}
+
+#endif // __OGRE_HAVE_AVX2
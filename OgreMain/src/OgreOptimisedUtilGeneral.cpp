@@ -94,6 +94,15 @@ namespace Ogre {
             const float* srcPositions,
             float* destPositions,
             size_t numVertices);
+
+        /// @copydoc OptimisedUtil::cullBoxes
+        virtual void cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes);
     };
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
@@ -392,6 +401,37 @@ namespace Ogre {
         }
     }
     //---------------------------------------------------------------------
+    void OptimisedUtilGeneral::cullBoxes(
+        const Vector4* planes,
+        size_t numPlanes,
+        const Vector4* centres,
+        const Vector4* halfSizes,
+        char* visibilities,
+        size_t numBoxes)
+    {
+        for (size_t i = 0; i < numBoxes; ++i)
+        {
+            if (!visibilities[i])
+                continue;
+
+            // Same as Plane::getSide(centre, halfSize)
+            const Vector4& c = centres[i];
+            const Vector4& h = halfSizes[i];
+            for (size_t p = 0; p < numPlanes; ++p)
+            {
+                const Vector4& plane = planes[p];
+                Real dist = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+                Real maxAbsDist = Math::Abs(plane.x * h.x) + Math::Abs(plane.y * h.y) +
+                    Math::Abs(plane.z * h.z);
+                if (dist < -maxAbsDist)
+                {
+                    visibilities[i] = 0;
+                    break;
+                }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     extern OptimisedUtil* _getOptimisedUtilGeneral(void)
@@ -132,6 +132,15 @@ namespace Ogre {
             const float* srcPositions,
             float* destPositions,
             size_t numVertices);
+
+        /// @copydoc OptimisedUtil::cullBoxes
+        virtual void __OGRE_SIMD_ALIGN_ATTRIBUTE cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes);
     };
 
 #if defined(__OGRE_SIMD_ALIGN_STACK)
@@ -271,6 +280,26 @@ namespace Ogre {
                 destPositions,
                 numVertices);
         }
+
+        /// @copydoc OptimisedUtil::cullBoxes
+        virtual void cullBoxes(
+            const Vector4* planes,
+            size_t numPlanes,
+            const Vector4* centres,
+            const Vector4* halfSizes,
+            char* visibilities,
+            size_t numBoxes)
+        {
+            __OGRE_SIMD_ALIGN_STACK();
+
+            mImpl->cullBoxes(
+                planes,
+                numPlanes,
+                centres,
+                halfSizes,
+                visibilities,
+                numBoxes);
+        }
     };
 #endif  // !defined(__OGRE_SIMD_ALIGN_STACK)
 
@@ -2136,6 +2165,66 @@ namespace Ogre {
         }
     }
     //---------------------------------------------------------------------
+    void OptimisedUtilSSE::cullBoxes(
+        const Vector4* planes,
+        size_t numPlanes,
+        const Vector4* centres,
+        const Vector4* halfSizes,
+        char* visibilities,
+        size_t numBoxes)
+    {
+        __OGRE_CHECK_STACK_ALIGNED_FOR_SSE();
+
+        const __m128 zero = _mm_setzero_ps();
+
+        // Test each box against four planes at a time, missing planes are
+        // zero which never culls anything
+        for (size_t p = 0; p < numPlanes; p += 4)
+        {
+            const size_t count = std::min(numPlanes - p, (size_t)4);
+            OGRE_SIMD_ALIGNED_DECL(Vector4, group[4]);
+            for (size_t j = 0; j < 4; ++j)
+                group[j] = j < count ? planes[p + j] : Vector4::ZERO;
+
+            // Transpose to one register per plane component
+            __m128 nx = __MM_LOAD_PS(&group[0].x);
+            __m128 ny = __MM_LOAD_PS(&group[1].x);
+            __m128 nz = __MM_LOAD_PS(&group[2].x);
+            __m128 d = __MM_LOAD_PS(&group[3].x);
+            _MM_TRANSPOSE4_PS(nx, ny, nz, d);
+            // |n| * h is exactly |n * h| as half sizes are positive
+            const __m128 ax = _mm_max_ps(nx, _mm_sub_ps(zero, nx));
+            const __m128 ay = _mm_max_ps(ny, _mm_sub_ps(zero, ny));
+            const __m128 az = _mm_max_ps(nz, _mm_sub_ps(zero, nz));
+
+            for (size_t i = 0; i < numBoxes; ++i)
+            {
+                if (!visibilities[i])
+                    continue;
+
+                const __m128 c = _mm_loadu_ps(&centres[i].x);
+                const __m128 h = _mm_loadu_ps(&halfSizes[i].x);
+
+                // Same operations in the same order as Plane::getSide(centre, halfSize)
+                __m128 dist = _mm_add_ps(
+                    _mm_add_ps(
+                        _mm_add_ps(
+                            _mm_mul_ps(nx, _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0))),
+                            _mm_mul_ps(ny, _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1)))),
+                        _mm_mul_ps(nz, _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 2, 2)))),
+                    d);
+                __m128 maxAbsDist = _mm_add_ps(
+                    _mm_add_ps(
+                        _mm_mul_ps(ax, _mm_shuffle_ps(h, h, _MM_SHUFFLE(0, 0, 0, 0))),
+                        _mm_mul_ps(ay, _mm_shuffle_ps(h, h, _MM_SHUFFLE(1, 1, 1, 1)))),
+                    _mm_mul_ps(az, _mm_shuffle_ps(h, h, _MM_SHUFFLE(2, 2, 2, 2))));
+
+                if (_mm_movemask_ps(_mm_cmplt_ps(dist, _mm_sub_ps(zero, maxAbsDist))))
+                    visibilities[i] = 0;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     extern OptimisedUtil* _getOptimisedUtilSSE(void)
@@ -0,0 +1,160 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreParticleArrays.h"
+#include "OgreParticle.h"
+
+namespace Ogre {
+    const size_t ParticleArrays::NUM_REAL_ARRAYS;
+    Real* ParticleArrays::* const ParticleArrays::msRealArrays[NUM_REAL_ARRAYS] =
+    {
+        &ParticleArrays::mPositionX, &ParticleArrays::mPositionY, &ParticleArrays::mPositionZ,
+        &ParticleArrays::mDirectionX, &ParticleArrays::mDirectionY, &ParticleArrays::mDirectionZ,
+        &ParticleArrays::mColourR, &ParticleArrays::mColourG, &ParticleArrays::mColourB,
+        &ParticleArrays::mColourA, &ParticleArrays::mTimeToLive, &ParticleArrays::mTotalTimeToLive,
+        &ParticleArrays::mRotation, &ParticleArrays::mRotationSpeed,
+        &ParticleArrays::mWidth, &ParticleArrays::mHeight
+    };
+    //-----------------------------------------------------------------------
+    ParticleArrays::ParticleArrays()
+        : mCount(0), mOwnDimensions(0), mCapacity(0), mData(0), mScratch(0)
+    {
+        for (size_t a = 0; a < NUM_REAL_ARRAYS; ++a)
+            this->*msRealArrays[a] = 0;
+    }
+    //-----------------------------------------------------------------------
+    ParticleArrays::~ParticleArrays()
+    {
+        OGRE_FREE_SIMD(mData, MEMCATEGORY_SCENE_OBJECTS);
+        OGRE_FREE_SIMD(mScratch, MEMCATEGORY_SCENE_OBJECTS);
+    }
+    //-----------------------------------------------------------------------
+    void ParticleArrays::reserve(size_t capacity)
+    {
+        if (capacity <= mCapacity)
+            return;
+
+        // Whole SIMD registers of every array
+        capacity = (capacity + 3) & ~size_t(3);
+        void* data = OGRE_MALLOC_SIMD(
+            capacity * (NUM_REAL_ARRAYS * sizeof(Real) + sizeof(uint8)), MEMCATEGORY_SCENE_OBJECTS);
+
+        Real* dest = static_cast<Real*>(data);
+        for (size_t a = 0; a < NUM_REAL_ARRAYS; ++a, dest += capacity)
+        {
+            Real*& array = this->*msRealArrays[a];
+            if (mCount)
+                memcpy(dest, array, mCount * sizeof(Real));
+            array = dest;
+        }
+        uint8* ownDimensions = reinterpret_cast<uint8*>(dest);
+        if (mCount)
+            memcpy(ownDimensions, mOwnDimensions, mCount);
+        mOwnDimensions = ownDimensions;
+
+        OGRE_FREE_SIMD(mData, MEMCATEGORY_SCENE_OBJECTS);
+        OGRE_FREE_SIMD(mScratch, MEMCATEGORY_SCENE_OBJECTS);
+        mData = data;
+        mScratch = static_cast<Real*>(OGRE_MALLOC_SIMD(capacity * sizeof(Real), MEMCATEGORY_SCENE_OBJECTS));
+        mCapacity = capacity;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleArrays::append(const Particle& particle)
+    {
+        assert(mCount < mCapacity && "No room for another particle");
+        setParticle(mCount++, particle);
+    }
+    //-----------------------------------------------------------------------
+    void ParticleArrays::remove(size_t index)
+    {
+        assert(index < mCount && "Particle index out of bounds!");
+        size_t last = --mCount;
+        if (index == last)
+            return;
+        for (size_t a = 0; a < NUM_REAL_ARRAYS; ++a)
+        {
+            Real* array = this->*msRealArrays[a];
+            array[index] = array[last];
+        }
+        mOwnDimensions[index] = mOwnDimensions[last];
+    }
+    //-----------------------------------------------------------------------
+    void ParticleArrays::getParticle(size_t index, Particle& particle) const
+    {
+        assert(index < mCount && "Particle index out of bounds!");
+        particle.mPosition = Vector3(mPositionX[index], mPositionY[index], mPositionZ[index]);
+        particle.mDirection = Vector3(mDirectionX[index], mDirectionY[index], mDirectionZ[index]);
+        particle.mColour = ColourValue(mColourR[index], mColourG[index], mColourB[index], mColourA[index]);
+        particle.mTimeToLive = mTimeToLive[index];
+        particle.mTotalTimeToLive = mTotalTimeToLive[index];
+        particle.mRotation = Radian(mRotation[index]);
+        particle.mRotationSpeed = Radian(mRotationSpeed[index]);
+        particle.mWidth = mWidth[index];
+        particle.mHeight = mHeight[index];
+        particle.mOwnDimensions = mOwnDimensions[index] != 0;
+        particle.mParticleType = Particle::Visual;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleArrays::setParticle(size_t index, const Particle& particle)
+    {
+        assert(index < mCount && "Particle index out of bounds!");
+        mPositionX[index] = particle.mPosition.x;
+        mPositionY[index] = particle.mPosition.y;
+        mPositionZ[index] = particle.mPosition.z;
+        mDirectionX[index] = particle.mDirection.x;
+        mDirectionY[index] = particle.mDirection.y;
+        mDirectionZ[index] = particle.mDirection.z;
+        mColourR[index] = particle.mColour.r;
+        mColourG[index] = particle.mColour.g;
+        mColourB[index] = particle.mColour.b;
+        mColourA[index] = particle.mColour.a;
+        mTimeToLive[index] = particle.mTimeToLive;
+        mTotalTimeToLive[index] = particle.mTotalTimeToLive;
+        mRotation[index] = particle.mRotation.valueRadians();
+        mRotationSpeed[index] = particle.mRotationSpeed.valueRadians();
+        mWidth[index] = particle.mWidth;
+        mHeight[index] = particle.mHeight;
+        mOwnDimensions[index] = particle.mOwnDimensions;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleArrays::reorder(const uint32* order)
+    {
+        for (size_t a = 0; a < NUM_REAL_ARRAYS; ++a)
+        {
+            Real* array = this->*msRealArrays[a];
+            for (size_t i = 0; i < mCount; ++i)
+                mScratch[i] = array[order[i]];
+            memcpy(array, mScratch, mCount * sizeof(Real));
+        }
+        uint8* ownDimensions = reinterpret_cast<uint8*>(mScratch);
+        for (size_t i = 0; i < mCount; ++i)
+            ownDimensions[i] = mOwnDimensions[order[i]];
+        memcpy(mOwnDimensions, ownDimensions, mCount);
+    }
+}
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgreParticleEmitter.h"
 #include "OgreParticleAffector.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
 #include "OgreIteratorWrappers.h"
 #include "OgreCamera.h"
 #include "OgreStringConverter.h"
@@ -55,8 +56,10 @@ namespace Ogre {
     ParticleSystem::CmdLocalSpace ParticleSystem::msLocalSpaceCmd;
     ParticleSystem::CmdIterationInterval ParticleSystem::msIterationIntervalCmd;
     ParticleSystem::CmdNonvisibleTimeout ParticleSystem::msNonvisibleTimeoutCmd;
+    ParticleSystem::CmdContiguousStorage ParticleSystem::msContiguousStorageCmd;
 
     RadixSort<ParticleSystem::ActiveParticleList, Particle*, float> ParticleSystem::mRadixSorter;
+    RadixSort<ParticleSystem::ParticleIndexList, uint32, float> ParticleSystem::mIndexRadixSorter;
 
     Real ParticleSystem::msDefaultIterationInterval = 0;
     Real ParticleSystem::msDefaultNonvisibleTimeout = 0;
@@ -72,7 +75,12 @@ namespace Ogre {
 
         Real getValue(void) const { return 0; } // N/A
 
-        void setValue(Real value) { mTarget->_update(value); }
+        void setValue(Real value)
+        {
+            // Otherwise ParticleSystemManager updates all the systems together
+            if (!ParticleSystemManager::getSingleton().getParallelUpdate())
+                mTarget->_update(value);
+        }
 
     };
     //-----------------------------------------------------------------------
@@ -96,6 +104,11 @@ namespace Ogre {
         mTimeController(0),
         mEmittedEmitterPoolInitialised(false),
         mIsEmitting(true),
+        mContiguousStorage(false),
+        mUsingParticleArrays(false),
+        mParticleArraysInList(false),
+        mParticleArraysBoundsValid(false),
+        mParticleArrays(0),
         mRenderer(0),
         mCullIndividual(false),
         mPoolSize(0),
@@ -129,6 +142,11 @@ namespace Ogre {
         mTimeController(0),
         mEmittedEmitterPoolInitialised(false),
         mIsEmitting(true),
+        mContiguousStorage(false),
+        mUsingParticleArrays(false),
+        mParticleArraysInList(false),
+        mParticleArraysBoundsValid(false),
+        mParticleArrays(0),
         mRenderer(0), 
         mCullIndividual(false),
         mPoolSize(0),
@@ -152,6 +170,7 @@ namespace Ogre {
             // Destroy controller
             ControllerManager::getSingleton().destroyController(mTimeController);
             mTimeController = 0;
+            ParticleSystemManager::getSingleton()._notifySystemDetached(this);
         }
 
         // Arrange for the deletion of emitters & affectors
@@ -167,6 +186,7 @@ namespace Ogre {
         {
             OGRE_DELETE *i;
         }
+        OGRE_DELETE mParticleArrays;
 
         if (mRenderer)
         {
@@ -295,6 +315,7 @@ namespace Ogre {
         mIterationIntervalSet = rhs.mIterationIntervalSet;
         mNonvisibleTimeout = rhs.mNonvisibleTimeout;
         mNonvisibleTimeoutSet = rhs.mNonvisibleTimeoutSet;
+        mContiguousStorage = rhs.mContiguousStorage;
         // last frame visible and time since last visible should be left default
 
         setRenderer(rhs.getRendererName());
@@ -310,6 +331,8 @@ namespace Ogre {
     //-----------------------------------------------------------------------
     size_t ParticleSystem::getNumParticles(void) const
     {
+        if (mUsingParticleArrays && !mParticleArraysInList)
+            return mParticleArrays->mCount;
         return mActiveParticles.size();
     }
     //-----------------------------------------------------------------------
@@ -366,10 +389,16 @@ namespace Ogre {
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::_update(Real timeElapsed)
+    {
+        if (_beginUpdate(timeElapsed))
+            _endUpdate(timeElapsed, false);
+    }
+    //-----------------------------------------------------------------------
+    bool ParticleSystem::_beginUpdate(Real& timeElapsed)
     {
         // Only update if attached to a node
         if (!mParentNode)
-            return;
+            return false;
 
         Real nonvisibleTimeout = mNonvisibleTimeoutSet ?
             mNonvisibleTimeout : msDefaultNonvisibleTimeout;
@@ -385,7 +414,7 @@ namespace Ogre {
                 if (mTimeSinceLastVisible >= nonvisibleTimeout)
                 {
                     // No update
-                    return;
+                    return false;
                 }
             }
         }
@@ -399,6 +428,43 @@ namespace Ogre {
         // Initialise emitted emitters list if not done already
         initialiseEmittedEmitters();
 
+        // Move the particles to the storage now required
+        _updateStorage();
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    bool ParticleSystem::_canUpdateParticlesConcurrently(void) const
+    {
+        // Affectors working on Particle instances go through the renderer and
+        // the shared pools, and an iteration interval interleaves emission
+        if (!mUsingParticleArrays || (mIterationIntervalSet ? mIterationInterval : msDefaultIterationInterval) > 0)
+            return false;
+
+        ParticleAffectorList::const_iterator i, itEnd = mAffectors.end();
+        for (i = mAffectors.begin(); i != itEnd; ++i)
+        {
+            if (!(*i)->_supportsParticleArrays())
+                return false;
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_updateParticles(Real timeElapsed)
+    {
+        if (mUsingParticleArrays)
+        {
+            _updateParticleArrays(timeElapsed, mBoundsAutoUpdate || mBoundsUpdateTime > 0.0f);
+        }
+        else
+        {
+            _expire(timeElapsed);
+            _triggerAffectors(timeElapsed);
+            _applyMotion(timeElapsed);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_endUpdate(Real timeElapsed, bool particlesUpdated)
+    {
         Real iterationInterval = mIterationIntervalSet ? 
             mIterationInterval : msDefaultIterationInterval;
         if (iterationInterval > 0)
@@ -408,9 +474,7 @@ namespace Ogre {
             while (mUpdateRemainTime >= iterationInterval)
             {
                 // Update existing particles
-                _expire(iterationInterval);
-                _triggerAffectors(iterationInterval);
-                _applyMotion(iterationInterval);
+                _updateParticles(iterationInterval);
 
                 if(mIsEmitting)
                 {
@@ -424,9 +488,8 @@ namespace Ogre {
         else
         {
             // Update existing particles
-            _expire(timeElapsed);
-            _triggerAffectors(timeElapsed);
-            _applyMotion(timeElapsed);
+            if (!particlesUpdated)
+                _updateParticles(timeElapsed);
 
             if(mIsEmitting)
             {
@@ -438,6 +501,7 @@ namespace Ogre {
         if (!mBoundsAutoUpdate && mBoundsUpdateTime > 0.0f)
             mBoundsUpdateTime -= timeElapsed; // count down 
         _updateBounds();
+        mParticleArraysBoundsValid = false;
 
     }
     //-----------------------------------------------------------------------
@@ -506,7 +570,10 @@ namespace Ogre {
         emitterCount = mEmitters.size();
         emittedEmitterCount=mActiveEmittedEmitters.size();
         itActiveEnd=mActiveEmittedEmitters.end();
-        emissionAllowed = mFreeParticles.size();
+        if (mUsingParticleArrays)
+            emissionAllowed = mParticlePool.size() - mParticleArrays->mCount;
+        else
+            emissionAllowed = mFreeParticles.size();
         totalRequested = 0;
 
         // Count up total requested emissions for regular emitters (and exclude the ones that are used as
@@ -571,14 +638,24 @@ namespace Ogre {
             return;
 
         Real timeInc = timeElapsed / requested;
+        const String& emitterName = emitter->getEmittedEmitter();
+        // Initialised here then copied, for contiguous storage
+        Particle emitted;
 
         for (unsigned int j = 0; j < requested; ++j)
         {
             // Create a new particle & init using emitter
             // The particle is a visual particle if the emit_emitter property of the emitter isn't set 
             Particle* p = 0;
-            String  emitterName = emitter->getEmittedEmitter();
-            if (emitterName == BLANKSTRING)
+            if (mUsingParticleArrays)
+            {
+                if (mParticleArrays->mCount == mParticlePool.size())
+                    return;
+                emitted = Particle();
+                emitted._notifyOwner(this);
+                p = &emitted;
+            }
+            else if (emitterName == BLANKSTRING)
                 p = createParticle();
             else
                 p = createEmitterParticle(emitterName);
@@ -607,6 +684,14 @@ namespace Ogre {
             // Increment time fragment
             timePoint += timeInc;
 
+            if (mUsingParticleArrays)
+            {
+                mParticleArrays->append(*p);
+                if (mParticleArraysBoundsValid)
+                    _addToParticleArraysBounds(*p);
+                continue;
+            }
+
             if (p->mParticleType == Particle::Emitter)
             {
                 // If the particle is an emitter, the position on the emitter side must also be initialised
@@ -659,6 +744,190 @@ namespace Ogre {
 
     }
     //-----------------------------------------------------------------------
+    /// Removes the particles which expire within timeElapsed, and ages the others
+    static void expireParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        Real* timeToLive = particles.mTimeToLive;
+        for (size_t i = 0; i < particles.mCount; )
+        {
+            if (timeToLive[i] < timeElapsed)
+            {
+                // The last particle takes its place, and has yet to be checked
+                particles.remove(i);
+            }
+            else
+            {
+                timeToLive[i] -= timeElapsed;
+                ++i;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    /** Moves the particles, expiring them first if EXPIRE is set and finding
+        their bounds padded by their size as well if BOUNDS is set.
+    */
+    template <bool EXPIRE, bool BOUNDS>
+    static void moveParticleArrays(ParticleArrays& particles, Real timeElapsed,
+        Real defaultPadding, Vector3& min, Vector3& max)
+    {
+        Real minX = min.x, minY = min.y, minZ = min.z;
+        Real maxX = max.x, maxY = max.y, maxZ = max.z;
+        for (size_t i = 0; i < particles.mCount; )
+        {
+            if (EXPIRE)
+            {
+                if (particles.mTimeToLive[i] < timeElapsed)
+                {
+                    particles.remove(i);
+                    continue;
+                }
+                particles.mTimeToLive[i] -= timeElapsed;
+            }
+
+            Real x = particles.mPositionX[i] += particles.mDirectionX[i] * timeElapsed;
+            Real y = particles.mPositionY[i] += particles.mDirectionY[i] * timeElapsed;
+            Real z = particles.mPositionZ[i] += particles.mDirectionZ[i] * timeElapsed;
+
+            if (BOUNDS)
+            {
+                Real padding = particles.mOwnDimensions[i] ?
+                    0.5f * std::max(particles.mWidth[i], particles.mHeight[i]) : defaultPadding;
+                minX = std::min(minX, x - padding);
+                minY = std::min(minY, y - padding);
+                minZ = std::min(minZ, z - padding);
+                maxX = std::max(maxX, x + padding);
+                maxY = std::max(maxY, y + padding);
+                maxZ = std::max(maxZ, z + padding);
+            }
+            ++i;
+        }
+        min = Vector3(minX, minY, minZ);
+        max = Vector3(maxX, maxY, maxZ);
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_updateParticleArrays(Real timeElapsed, bool updateBounds)
+    {
+        _copyListToParticleArrays();
+        ParticleArrays& particles = *mParticleArrays;
+
+        bool expired = false;
+        if (!mAffectors.empty())
+        {
+            // Affectors see the particles between expiry and motion
+            expireParticleArrays(particles, timeElapsed);
+            expired = true;
+
+            ParticleAffectorList::iterator i, itEnd = mAffectors.end();
+            for (i = mAffectors.begin(); i != itEnd; ++i)
+            {
+                if ((*i)->_supportsParticleArrays())
+                {
+                    _copyListToParticleArrays();
+                    (*i)->_affectParticleArrays(particles, timeElapsed);
+                }
+                else
+                {
+                    _copyParticleArraysToList();
+                    (*i)->_affectParticles(this, timeElapsed);
+                }
+            }
+            _copyListToParticleArrays();
+        }
+
+        Real defaultPadding = 0.5f * std::max(mDefaultHeight, mDefaultWidth);
+        mParticleArraysMin = Vector3(Math::POS_INFINITY, Math::POS_INFINITY, Math::POS_INFINITY);
+        mParticleArraysMax = Vector3(Math::NEG_INFINITY, Math::NEG_INFINITY, Math::NEG_INFINITY);
+        if (expired)
+        {
+            if (updateBounds)
+                moveParticleArrays<false, true>(particles, timeElapsed, defaultPadding, mParticleArraysMin, mParticleArraysMax);
+            else
+                moveParticleArrays<false, false>(particles, timeElapsed, defaultPadding, mParticleArraysMin, mParticleArraysMax);
+        }
+        else
+        {
+            // Expire, move and bound in one pass
+            if (updateBounds)
+                moveParticleArrays<true, true>(particles, timeElapsed, defaultPadding, mParticleArraysMin, mParticleArraysMax);
+            else
+                moveParticleArrays<true, false>(particles, timeElapsed, defaultPadding, mParticleArraysMin, mParticleArraysMax);
+        }
+        mParticleArraysBoundsValid = updateBounds;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_addToParticleArraysBounds(const Particle& p)
+    {
+        Real padding = 0.5f * (p.mOwnDimensions ?
+            std::max(p.mWidth, p.mHeight) : std::max(mDefaultHeight, mDefaultWidth));
+        mParticleArraysMin.makeFloor(p.mPosition - padding);
+        mParticleArraysMax.makeCeil(p.mPosition + padding);
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_updateStorage(void)
+    {
+        bool useArrays = mContiguousStorage && mRenderer && mRenderer->_supportsParticleArrays() &&
+            mEmittedEmitterPool.empty();
+        if (useArrays == mUsingParticleArrays)
+        {
+            _copyListToParticleArrays();
+        }
+        else if (useArrays)
+        {
+            if (!mParticleArrays)
+                mParticleArrays = OGRE_NEW ParticleArrays();
+            mParticleArrays->reserve(mParticlePool.size());
+            mParticleArrays->clear();
+
+            // The particles are where they would be if copied from the arrays
+            mUsingParticleArrays = true;
+            mParticleArraysInList = true;
+            _copyListToParticleArrays();
+        }
+        else
+        {
+            _copyParticleArraysToList();
+            mUsingParticleArrays = false;
+            mParticleArraysInList = false;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_copyParticleArraysToList(void)
+    {
+        if (!mUsingParticleArrays || mParticleArraysInList)
+            return;
+
+        for (size_t i = 0; i < mParticleArrays->mCount; ++i)
+        {
+            Particle* p = mFreeParticles.front();
+            mActiveParticles.splice(mActiveParticles.end(), mFreeParticles, mFreeParticles.begin());
+            p->_notifyOwner(this);
+            mParticleArrays->getParticle(i, *p);
+        }
+        mParticleArraysInList = true;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_copyListToParticleArrays(void)
+    {
+        if (!mUsingParticleArrays || !mParticleArraysInList)
+            return;
+
+        mParticleArrays->clear();
+        ActiveParticleList::iterator i, itEnd = mActiveParticles.end();
+        for (i = mActiveParticles.begin(); i != itEnd; ++i)
+        {
+            if ((*i)->mParticleType == Particle::Visual)
+                mParticleArrays->append(**i);
+        }
+        mFreeParticles.splice(mFreeParticles.end(), mActiveParticles);
+        mParticleArraysInList = false;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::setContiguousStorage(bool contiguous)
+    {
+        // The particles move at the next update
+        mContiguousStorage = contiguous;
+    }
+    //-----------------------------------------------------------------------
     void ParticleSystem::increasePool(size_t size)
     {
         size_t oldSize = mParticlePool.size();
@@ -683,11 +952,13 @@ namespace Ogre {
     //-----------------------------------------------------------------------
     ParticleIterator ParticleSystem::_getIterator(void)
     {
+        _copyParticleArraysToList();
         return ParticleIterator(mActiveParticles.begin(), mActiveParticles.end());
     }
     //-----------------------------------------------------------------------
     Particle* ParticleSystem::getParticle(size_t index) 
     {
+        _copyParticleArraysToList();
         assert (index < mActiveParticles.size() && "Index out of bounds!");
         ActiveParticleList::iterator i = mActiveParticles.begin();
         std::advance(i, index);
@@ -696,6 +967,7 @@ namespace Ogre {
     //-----------------------------------------------------------------------
     Particle* ParticleSystem::createParticle(void)
     {
+        _copyParticleArraysToList();
         Particle* p = 0;
         if (!mFreeParticles.empty())
         {
@@ -737,7 +1009,15 @@ namespace Ogre {
     {
         if (mRenderer)
         {
-            mRenderer->_updateRenderQueue(queue, mActiveParticles, mCullIndividual);
+            if (mUsingParticleArrays)
+            {
+                _copyListToParticleArrays();
+                mRenderer->_updateRenderQueueFromArrays(queue, *mParticleArrays, mCullIndividual);
+            }
+            else
+            {
+                mRenderer->_updateRenderQueue(queue, mActiveParticles, mCullIndividual);
+            }
         }
     }
     //---------------------------------------------------------------------
@@ -813,6 +1093,12 @@ namespace Ogre {
                 PT_REAL),
                 &msNonvisibleTimeoutCmd);
 
+            dict->addParameter(ParameterDef("contiguous_storage", 
+                "Sets whether the particles are kept in contiguous arrays, "
+                "where the renderer and emitters allow it.",
+                PT_BOOL),
+                &msContiguousStorageCmd);
+
         }
     }
     //-----------------------------------------------------------------------
@@ -821,7 +1107,8 @@ namespace Ogre {
 
         if (mParentNode && (mBoundsAutoUpdate || mBoundsUpdateTime > 0.0f))
         {
-            if (mActiveParticles.empty())
+            _copyListToParticleArrays();
+            if (getNumParticles() == 0)
             {
                 // No particles, reset to null if auto update bounds
                 if (mBoundsAutoUpdate)
@@ -849,6 +1136,20 @@ namespace Ogre {
                 Vector3 halfScale = Vector3::UNIT_SCALE * 0.5;
                 Vector3 defaultPadding = 
                     halfScale * std::max(mDefaultHeight, mDefaultWidth);
+                if (mUsingParticleArrays)
+                {
+                    if (!mParticleArraysBoundsValid)
+                    {
+                        // Not found while moving the particles, so move them by nothing
+                        mParticleArraysMin = Vector3(Math::POS_INFINITY, Math::POS_INFINITY, Math::POS_INFINITY);
+                        mParticleArraysMax = Vector3(Math::NEG_INFINITY, Math::NEG_INFINITY, Math::NEG_INFINITY);
+                        moveParticleArrays<false, true>(*mParticleArrays, 0, defaultPadding.x,
+                            mParticleArraysMin, mParticleArraysMax);
+                        mParticleArraysBoundsValid = true;
+                    }
+                    min.makeFloor(mParticleArraysMin);
+                    max.makeCeil(mParticleArraysMax);
+                }
                 for (p = mActiveParticles.begin(); p != mActiveParticles.end(); ++p)
                 {
                     if ((*p)->mOwnDimensions)
@@ -1014,12 +1315,14 @@ namespace Ogre {
             ControllerManager& mgr = ControllerManager::getSingleton(); 
             ControllerValueRealPtr updValue(OGRE_NEW ParticleSystemUpdateValue(this));
             mTimeController = mgr.createFrameTimePassthroughController(updValue);
+            ParticleSystemManager::getSingleton()._notifySystemAttached(this);
         }
         else if (!parent && mTimeController)
         {
             // Destroy controller
             ControllerManager::getSingleton().destroyController(mTimeController);
             mTimeController = 0;
+            ParticleSystemManager::getSingleton()._notifySystemDetached(this);
         }
     }
     //-----------------------------------------------------------------------
@@ -1048,6 +1351,11 @@ namespace Ogre {
 
         // Move actives to free list
         mFreeParticles.splice(mFreeParticles.end(), mActiveParticles);
+        if (mUsingParticleArrays)
+        {
+            mParticleArrays->clear();
+            mParticleArraysInList = false;
+        }
 
         // Add active emitted emitters to free list
         addActiveEmittedEmittersToFreeList();
@@ -1074,6 +1382,9 @@ namespace Ogre {
             mRenderer = ParticleSystemManager::getSingleton()._createRenderer(rendererName);
             mIsRendererConfigured = false;
         }
+
+        // The new renderer may not draw from contiguous storage
+        _updateStorage();
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::configureRenderer(void)
@@ -1084,6 +1395,8 @@ namespace Ogre {
         if( currSize < size )
         {
             this->increasePool(size);
+            if (mParticleArrays)
+                mParticleArrays->reserve(size);
 
             for( size_t i = currSize; i < size; ++i )
             {
@@ -1210,6 +1523,7 @@ namespace Ogre {
     {
         if (mRenderer)
         {
+            _copyListToParticleArrays();
             SortMode sortMode = mRenderer->_getSortMode();
             if (sortMode == SM_DIRECTION)
             {
@@ -1219,7 +1533,10 @@ namespace Ogre {
                     // transform the camera direction into local space
                     camDir = mParentNode->convertWorldToLocalDirection(camDir, false);
                 }
-                mRadixSorter.sort(mActiveParticles, SortByDirectionFunctor(- camDir));
+                if (mUsingParticleArrays)
+                    _sortParticleArrays(- camDir, false);
+                else
+                    mRadixSorter.sort(mActiveParticles, SortByDirectionFunctor(- camDir));
             }
             else if (sortMode == SM_DISTANCE)
             {
@@ -1229,9 +1546,42 @@ namespace Ogre {
                     // transform the camera position into local space
                     camPos = mParentNode->convertWorldToLocalPosition(camPos);
                 }
-                mRadixSorter.sort(mActiveParticles, SortByDistanceFunctor(camPos));
+                if (mUsingParticleArrays)
+                    _sortParticleArrays(camPos, true);
+                else
+                    mRadixSorter.sort(mActiveParticles, SortByDistanceFunctor(camPos));
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_sortParticleArrays(const Vector3& v, bool byDistance)
+    {
+        ParticleArrays& particles = *mParticleArrays;
+        if (particles.mCount < 2)
+            return;
+
+        // Same keys as SortByDirectionFunctor and SortByDistanceFunctor
+        mSortKeys.resize(particles.mCount);
+        mSortOrder.resize(particles.mCount);
+        for (size_t i = 0; i < particles.mCount; ++i)
+        {
+            Real x = particles.mPositionX[i], y = particles.mPositionY[i], z = particles.mPositionZ[i];
+            if (byDistance)
+            {
+                x -= v.x;
+                y -= v.y;
+                z -= v.z;
+                mSortKeys[i] = - (x * x + y * y + z * z);
             }
+            else
+            {
+                mSortKeys[i] = v.x * x + v.y * y + v.z * z;
+            }
+            mSortOrder[i] = static_cast<uint32>(i);
         }
+
+        mIndexRadixSorter.sort(mSortOrder, SortByKeyFunctor(&mSortKeys[0]));
+        particles.reorder(&mSortOrder[0]);
     }
     ParticleSystem::SortByDirectionFunctor::SortByDirectionFunctor(const Vector3& dir)
         : sortDir(dir)
@@ -1606,6 +1956,17 @@ namespace Ogre {
         static_cast<ParticleSystem*>(target)->setNonVisibleUpdateTimeout(
             StringConverter::parseReal(val));
     }
+    //-----------------------------------------------------------------------
+    String ParticleSystem::CmdContiguousStorage::doGet(const void* target) const
+    {
+        return StringConverter::toString(
+            static_cast<const ParticleSystem*>(target)->getContiguousStorage());
+    }
+    void ParticleSystem::CmdContiguousStorage::doSet(void* target, const String& val)
+    {
+        static_cast<ParticleSystem*>(target)->setContiguousStorage(
+            StringConverter::parseBool(val));
+    }
    //-----------------------------------------------------------------------
     ParticleAffector::~ParticleAffector() 
     {
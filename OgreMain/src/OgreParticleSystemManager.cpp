@@ -37,6 +37,8 @@ THE SOFTWARE.
 #include "OgreBillboardParticleRenderer.h"
 #include "OgreScriptCompiler.h"
 #include "OgreParticleSystem.h"
+#include "OgreControllerManager.h"
+#include "OgreTaskScheduler.h"
 
 namespace Ogre {
     //-----------------------------------------------------------------------
@@ -54,6 +56,7 @@ namespace Ogre {
     }
     //-----------------------------------------------------------------------
     ParticleSystemManager::ParticleSystemManager()
+        : mParallelUpdate(false)
     {
         OGRE_LOCK_AUTO_MUTEX;
         mFactory = OGRE_NEW ParticleSystemFactory();
@@ -63,6 +66,7 @@ namespace Ogre {
     ParticleSystemManager::~ParticleSystemManager()
     {
         OGRE_LOCK_AUTO_MUTEX;
+        setParallelUpdate(false);
 
         // Destroy all templates
         ParticleTemplateMap::iterator t;
@@ -89,6 +93,93 @@ namespace Ogre {
 
     }
     //-----------------------------------------------------------------------
+    struct ParticleSystemManager::UpdateParticles
+    {
+        SystemUpdate* mUpdates;
+
+        UpdateParticles(SystemUpdate* updates) : mUpdates(updates) {}
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (mUpdates[i].concurrent)
+                    mUpdates[i].system->_updateParticles(mUpdates[i].timeElapsed);
+            }
+        }
+    };
+    //-----------------------------------------------------------------------
+    void ParticleSystemManager::setParallelUpdate(bool enabled)
+    {
+        if (enabled == mParallelUpdate)
+            return;
+
+        mParallelUpdate = enabled;
+        if (enabled)
+            Root::getSingleton().addFrameListener(this);
+        else
+            Root::getSingleton().removeFrameListener(this);
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystemManager::_updateSystems(Real timeElapsed)
+    {
+        // Prepare the systems, which may create renderers and move particles
+        mSystemUpdates.clear();
+        bool anyConcurrent = false;
+        for (size_t i = 0; i < mAttachedSystems.size(); ++i)
+        {
+            SystemUpdate update;
+            update.system = mAttachedSystems[i];
+            update.timeElapsed = timeElapsed;
+            if (!update.system->_beginUpdate(update.timeElapsed))
+                continue;
+            update.concurrent = update.system->_canUpdateParticlesConcurrently();
+            anyConcurrent |= update.concurrent;
+            mSystemUpdates.push_back(update);
+        }
+
+        if (mSystemUpdates.empty())
+            return;
+
+        // Update the particles which don't depend on anything outside their own system
+        if (anyConcurrent)
+        {
+            parallelFor(0, mSystemUpdates.size(), 1, UpdateParticles(&mSystemUpdates[0]),
+                "ParticleSystemManager::_updateSystems");
+        }
+
+        // Then emit, and update the other systems, in a fixed order so that
+        // the random numbers go to the same particles every time
+        SystemUpdateList::iterator i, iend = mSystemUpdates.end();
+        for (i = mSystemUpdates.begin(); i != iend; ++i)
+        {
+            i->system->_endUpdate(i->timeElapsed, i->concurrent);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystemManager::_notifySystemAttached(ParticleSystem* sys)
+    {
+        mAttachedSystems.push_back(sys);
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystemManager::_notifySystemDetached(ParticleSystem* sys)
+    {
+        vector<ParticleSystem*>::type::iterator i =
+            std::find(mAttachedSystems.begin(), mAttachedSystems.end(), sys);
+        if (i != mAttachedSystems.end())
+            mAttachedSystems.erase(i);
+    }
+    //-----------------------------------------------------------------------
+    bool ParticleSystemManager::frameStarted(const FrameEvent& evt)
+    {
+        // The time the frame time controllers would pass on. The time source
+        // is a frame listener too, and may not have seen this frame yet.
+        ControllerManager& controllerMgr = ControllerManager::getSingleton();
+        Real frameDelay = controllerMgr.getFrameDelay();
+        _updateSystems(frameDelay ? frameDelay : controllerMgr.getTimeFactor() * evt.timeSinceLastFrame);
+        return true;
+    }
+    //-----------------------------------------------------------------------
     const StringVector& ParticleSystemManager::getScriptPatterns(void) const
     {
         return mScriptPatterns;
@@ -29,13 +29,97 @@ THE SOFTWARE.
 #include "OgreRenderQueueSortingGrouping.h"
 #include "OgreException.h"
 #include "OgreTechnique.h"
+#include "OgreRoot.h"
+#include "OgreTaskScheduler.h"
 
 namespace Ogre {
     // Init statics
-    RadixSort<QueuedRenderableCollection::RenderablePassList,
-        RenderablePass, uint32> QueuedRenderableCollection::msRadixSorter1;
-    RadixSort<QueuedRenderableCollection::RenderablePassList,
-        RenderablePass, float> QueuedRenderableCollection::msRadixSorter2;
+    size_t QueuedRenderableCollection::msParallelSortThreshold = 0;
+
+namespace {
+    /// Below this many items a comparison sort beats the radix sort
+    const size_t MAX_COMPARISON_SORT = 256;
+    /// Smallest number of items a worker thread sorts at once
+    const size_t MIN_PARALLEL_SORT_CHUNK = 4096;
+    const size_t RADIX_BUCKETS = 256;
+
+    /// Maps floats to unsigned integers in the same order
+    inline uint32 orderedFloatBits(float f)
+    {
+        uint32 bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    }
+
+    struct KeyLess
+    {
+        template <typename Item> bool operator()(const Item& a, const Item& b) const
+        {
+            return a.key < b.key;
+        }
+    };
+
+    struct PassLess
+    {
+        template <typename Item> bool operator()(const Item& a, const Item& b) const
+        {
+            return a.rp.pass < b.rp.pass;
+        }
+    };
+
+    struct PassEqual
+    {
+        Pass* pass;
+        template <typename Item> bool operator()(const Item& item) const
+        {
+            return item.rp.pass == pass;
+        }
+    };
+
+    /// Counts the digits of each chunk of the items, for one radix sort pass
+    template <typename Item> struct CountDigits
+    {
+        const Item* src;
+        size_t count;
+        size_t chunkSize;
+        size_t shift;
+        size_t* counts;
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                size_t* chunkCounts = counts + c * RADIX_BUCKETS;
+                memset(chunkCounts, 0, RADIX_BUCKETS * sizeof(size_t));
+                size_t last = std::min(count, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < last; ++i)
+                    ++chunkCounts[(src[i].key >> shift) & (RADIX_BUCKETS - 1)];
+            }
+        }
+    };
+
+    /// Moves each chunk of the items to where its digits start, for one radix sort pass
+    template <typename Item> struct ScatterDigits
+    {
+        const Item* src;
+        Item* dest;
+        size_t count;
+        size_t chunkSize;
+        size_t shift;
+        size_t* offsets;
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                size_t* chunkOffsets = offsets + c * RADIX_BUCKETS;
+                size_t last = std::min(count, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < last; ++i)
+                    dest[chunkOffsets[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+            }
+        }
+    };
+}
 
 
     //-----------------------------------------------------------------------
@@ -207,43 +291,9 @@ namespace Ogre {
     //-----------------------------------------------------------------------
     void RenderPriorityGroup::clear(void)
     {
-        // Delete queue groups which are using passes which are to be
-        // deleted, we won't need these any more and they clutter up 
-        // the list and can cause problems with future clones
-        {
-            // Hmm, a bit hacky but least obtrusive for now
-                    OGRE_LOCK_MUTEX(Pass::msPassGraveyardMutex);
-            const Pass::PassSet& graveyardList = Pass::getPassGraveyard();
-            Pass::PassSet::const_iterator gi, giend;
-            giend = graveyardList.end();
-            for (gi = graveyardList.begin(); gi != giend; ++gi)
-            {
-                removePassEntry(*gi);
-            }
-        }
-
-        // Now remove any dirty passes, these will have their hashes recalculated
-        // by the parent queue after all groups have been processed
-        // If we don't do this, the std::map will become inconsistent for new insterts
-        {
-            // Hmm, a bit hacky but least obtrusive for now
-                    OGRE_LOCK_MUTEX(Pass::msDirtyHashListMutex);
-            const Pass::PassSet& dirtyList = Pass::getDirtyHashList();
-            Pass::PassSet::const_iterator di, diend;
-            diend = dirtyList.end();
-            for (di = dirtyList.begin(); di != diend; ++di)
-            {
-                removePassEntry(*di);
-            }
-        }
-        // NB we do NOT clear the graveyard or the dirty list here, because 
-        // it needs to be acted on for all groups, the parent queue takes 
-        // care of this afterwards
-
-        // Now empty the remaining collections
-        // Note that groups don't get deleted, just emptied hence the difference
-        // between the pass groups which are removed above, and clearing done
-        // here
+        // Passes which are to be deleted or have their hashes recalculated
+        // need no special treatment, the collections only hold on to them
+        // until they are emptied here, and are grouped by pass when sorted
         mSolidsBasic.clear();
         mSolidsDecal.clear();
         mSolidsDiffuseSpecular.clear();
@@ -274,87 +324,156 @@ namespace Ogre {
     }
     //-----------------------------------------------------------------------
     QueuedRenderableCollection::QueuedRenderableCollection(void)
-        :mOrganisationMode(0)
+        :mOrganisationMode(0), mGroupedDirty(false)
     {
     }
     //-----------------------------------------------------------------------
     QueuedRenderableCollection::~QueuedRenderableCollection(void)
     {
-        // destroy all the pass map entries (rather than clearing)
-        PassGroupRenderableMap::iterator i, iend;
-        iend = mGrouped.end();
-        for (i = mGrouped.begin(); i != iend; ++i)
-        {
-            // Free the list associated with this pass
-            OGRE_DELETE_T(i->second, RenderableList, MEMCATEGORY_SCENE_CONTROL);
-        }
-        
     }
     //-----------------------------------------------------------------------
     void QueuedRenderableCollection::clear(void)
     {
-        PassGroupRenderableMap::iterator i, iend;
-        iend = mGrouped.end();
-        for (i = mGrouped.begin(); i != iend; ++i)
-        {
-            // Clear the list associated with this pass, but leave the pass entry
-            i->second->clear();
-        }
-
-        // Clear sorted list
+        // Clear the lists, leaving their memory allocated
+        mGrouped.clear();
+        mGroupedDirty = false;
         mSortedDescending.clear();
     }
     //-----------------------------------------------------------------------
     void QueuedRenderableCollection::removePassGroup(Pass* p)
     {
-        PassGroupRenderableMap::iterator i;
-
-        i = mGrouped.find(p);
-        if (i != mGrouped.end())
-        {
-            // free memory
-            OGRE_DELETE_T(i->second, RenderableList, MEMCATEGORY_SCENE_CONTROL);
-            // erase from map
-            mGrouped.erase(i);
-        }
+        PassEqual equal = { p };
+        mGrouped.erase(std::remove_if(mGrouped.begin(), mGrouped.end(), equal), mGrouped.end());
+        mSortedDescending.erase(std::remove_if(mSortedDescending.begin(), mSortedDescending.end(), equal),
+            mSortedDescending.end());
     }
     //-----------------------------------------------------------------------
     void QueuedRenderableCollection::sort(const Camera* cam)
     {
+        if (mOrganisationMode & OM_PASS_GROUP)
+        {
+            sortGrouped();
+        }
+
         // ascending and descending sort both set bit 1
         // We always sort descending, because the only difference is in the
         // acceptVisitor method, where we iterate in reverse in ascending mode
         if (mOrganisationMode & OM_SORT_DESCENDING)
         {
-            
-            // We can either use a stable_sort and the 'less' implementation,
-            // or a 2-pass radix sort (once by pass, then by distance, since
-            // radix sorting is inherently stable this will work)
-            // We use stable_sort if the number of items is 512 or less, since
-            // the complexity of the radix sort is approximately O(10N), since 
-            // each sort is O(5N) (1 pass histograms, 4 passes sort)
-            // Since stable_sort has a worst-case performance of O(N(logN)^2)
-            // the performance tipping point is from about 1500 items, but in
-            // stable_sorts best-case scenario O(NlogN) it would be much higher.
-            // Take a stab at 2000 items.
-            
-            if (mSortedDescending.size() > 2000)
+            // Descending depth first, then the pass hash, by sorting ascending
+            // on the negative distance
+            SortedRenderablePassList::iterator i, iend = mSortedDescending.end();
+            for (i = mSortedDescending.begin(); i != iend; ++i)
             {
-                // sort by pass
-                msRadixSorter1.sort(mSortedDescending, RadixSortFunctorPass());
-                // sort by depth
-                msRadixSorter2.sort(mSortedDescending, RadixSortFunctorDistance(cam));
+                float depth = static_cast<float>(- i->rp.renderable->getSquaredViewDepth(cam));
+                i->key = (static_cast<uint64>(orderedFloatBits(depth)) << 32) | i->rp.pass->getHash();
             }
-            else
+            sortByKey(mSortedDescending);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableCollection::sortGrouped(void) const
+    {
+        if (!mGroupedDirty)
+            return;
+        mGroupedDirty = false;
+
+        // Sort by passHash, which is pass, then texture unit changes
+        SortedRenderablePassList::iterator i, iend = mGrouped.end();
+        for (i = mGrouped.begin(); i != iend; ++i)
+            i->key = static_cast<uint64>(i->rp.pass->getHash()) << 32;
+        sortByKey(mGrouped);
+
+        // Must differentiate by pass in case 2 passes end up with the same hash
+        iend = mGrouped.end();
+        for (i = mGrouped.begin(); i != iend; )
+        {
+            SortedRenderablePassList::iterator runEnd = i + 1;
+            bool mixed = false;
+            for (; runEnd != iend && runEnd->key == i->key; ++runEnd)
+                mixed |= runEnd->rp.pass != i->rp.pass;
+            if (mixed)
+                std::stable_sort(i, runEnd, PassLess());
+            i = runEnd;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableCollection::sortByKey(SortedRenderablePassList& items) const
+    {
+        size_t count = items.size();
+        if (count < 2)
+            return;
+
+        // Only the bytes which differ between keys need a radix pass
+        uint64 firstKey = items[0].key;
+        uint64 differentBits = 0;
+        for (size_t i = 1; i < count; ++i)
+            differentBits |= items[i].key ^ firstKey;
+        if (!differentBits)
+            return;
+
+        if (count <= MAX_COMPARISON_SORT)
+        {
+            std::stable_sort(items.begin(), items.end(), KeyLess());
+            return;
+        }
+
+        size_t numChunks = 1;
+        if (msParallelSortThreshold && count >= msParallelSortThreshold && Root::getSingletonPtr())
+        {
+            TaskScheduler* scheduler = Root::getSingleton().getTaskScheduler();
+            if (scheduler && scheduler->getConcurrency() > 1)
             {
-                std::stable_sort(
-                    mSortedDescending.begin(), mSortedDescending.end(), 
-                    DepthSortDescendingLess(cam));
+                numChunks = std::max(size_t(1), std::min(scheduler->getConcurrency() * 2,
+                    count / MIN_PARALLEL_SORT_CHUNK));
             }
         }
+        size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+        mSortScratch.resize(count, items[0]);
+        mSortCounts.resize(numChunks * RADIX_BUCKETS);
+        SortedRenderablePass* src = &items[0];
+        SortedRenderablePass* dest = &mSortScratch[0];
+        bool sortedInScratch = false;
+
+        for (size_t shift = 0; shift < 64; shift += 8)
+        {
+            if (((differentBits >> shift) & (RADIX_BUCKETS - 1)) == 0)
+                continue;
 
-        // Nothing needs to be done for pass groups, they auto-organise
+            CountDigits<SortedRenderablePass> countDigits =
+                { src, count, chunkSize, shift, &mSortCounts[0] };
+            if (numChunks > 1)
+                parallelFor(0, numChunks, 1, countDigits, "QueuedRenderableCollection::sort");
+            else
+                countDigits(0, 1);
 
+            // Each chunk starts its digits after those of the smaller digits,
+            // and of the same digit in the chunks before, which keeps it stable
+            size_t offset = 0;
+            for (size_t d = 0; d < RADIX_BUCKETS; ++d)
+            {
+                for (size_t c = 0; c < numChunks; ++c)
+                {
+                    size_t digitCount = mSortCounts[c * RADIX_BUCKETS + d];
+                    mSortCounts[c * RADIX_BUCKETS + d] = offset;
+                    offset += digitCount;
+                }
+            }
+
+            ScatterDigits<SortedRenderablePass> scatterDigits =
+                { src, dest, count, chunkSize, shift, &mSortCounts[0] };
+            if (numChunks > 1)
+                parallelFor(0, numChunks, 1, scatterDigits, "QueuedRenderableCollection::sort");
+            else
+                scatterDigits(0, 1);
+
+            std::swap(src, dest);
+            sortedInScratch = !sortedInScratch;
+        }
+
+        if (sortedInScratch)
+            items.swap(mSortScratch);
     }
     //-----------------------------------------------------------------------
     void QueuedRenderableCollection::addRenderable(Pass* pass, Renderable* rend)
@@ -362,29 +481,14 @@ namespace Ogre {
         // ascending and descending sort both set bit 1
         if (mOrganisationMode & OM_SORT_DESCENDING)
         {
-            mSortedDescending.push_back(RenderablePass(rend, pass));
+            mSortedDescending.push_back(SortedRenderablePass(pass, rend));
         }
 
         if (mOrganisationMode & OM_PASS_GROUP)
         {
-            PassGroupRenderableMap::iterator i = mGrouped.find(pass);
-            if (i == mGrouped.end())
-            {
-                std::pair<PassGroupRenderableMap::iterator, bool> retPair;
-                // Create new pass entry, build a new list
-                // Note that this pass and list are never destroyed until the 
-                // engine shuts down, or a pass is destroyed or has it's hash
-                // recalculated, although the lists will be cleared
-                retPair = mGrouped.insert(
-                    PassGroupRenderableMap::value_type(
-                        pass, OGRE_NEW_T(RenderableList, MEMCATEGORY_SCENE_CONTROL)() ));
-                assert(retPair.second && 
-                    "Error inserting new pass entry into PassGroupRenderableMap");
-                i = retPair.first;
-            }
-            // Insert renderable
-            i->second->push_back(rend);
-            
+            // Grouped when sorted
+            mGrouped.push_back(SortedRenderablePass(pass, rend));
+            mGroupedDirty = true;
         }
         
     }
@@ -426,24 +530,27 @@ namespace Ogre {
     void QueuedRenderableCollection::acceptVisitorGrouped(
         QueuedRenderableVisitor* visitor) const
     {
-        PassGroupRenderableMap::const_iterator ipass, ipassend;
-        ipassend = mGrouped.end();
-        for (ipass = mGrouped.begin(); ipass != ipassend; ++ipass)
+        // In case renderables were added since the last sort
+        sortGrouped();
+
+        SortedRenderablePassList::const_iterator i, iend;
+        iend = mGrouped.end();
+        for (i = mGrouped.begin(); i != iend; )
         {
-            // Fast bypass if this group is now empty
-            if (ipass->second->empty()) continue;
+            Pass* pass = i->rp.pass;
 
             // Visit Pass - allow skip
-            if (!visitor->visit(ipass->first))
+            if (!visitor->visit(pass))
+            {
+                while (i != iend && i->rp.pass == pass)
+                    ++i;
                 continue;
+            }
 
-            RenderableList* rendList = ipass->second;
-            RenderableList::const_iterator irend, irendend;
-            irendend = rendList->end();
-            for (irend = rendList->begin(); irend != irendend; ++irend)
+            for (; i != iend && i->rp.pass == pass; ++i)
             {
                 // Visit Renderable
-                visitor->visit(const_cast<Renderable*>(*irend));
+                visitor->visit(i->rp.renderable);
             }
         } 
 
@@ -453,12 +560,12 @@ namespace Ogre {
         QueuedRenderableVisitor* visitor) const
     {
         // List is already in descending order, so iterate forward
-        RenderablePassList::const_iterator i, iend;
+        SortedRenderablePassList::const_iterator i, iend;
 
         iend = mSortedDescending.end();
         for (i = mSortedDescending.begin(); i != iend; ++i)
         {
-            visitor->visit(const_cast<RenderablePass*>(&(*i)));
+            visitor->visit(const_cast<RenderablePass*>(&i->rp));
         }
     }
     //-----------------------------------------------------------------------
@@ -466,12 +573,12 @@ namespace Ogre {
         QueuedRenderableVisitor* visitor) const
     {
         // List is in descending order, so iterate in reverse
-        RenderablePassList::const_reverse_iterator i, iend;
+        SortedRenderablePassList::const_reverse_iterator i, iend;
 
         iend = mSortedDescending.rend();
         for (i = mSortedDescending.rbegin(); i != iend; ++i)
         {
-            visitor->visit(const_cast<RenderablePass*>(&(*i)));
+            visitor->visit(const_cast<RenderablePass*>(&i->rp));
         }
 
     }
@@ -480,30 +587,23 @@ namespace Ogre {
     {
         mSortedDescending.insert( mSortedDescending.end(), rhs.mSortedDescending.begin(), rhs.mSortedDescending.end() );
 
-        PassGroupRenderableMap::const_iterator srcGroup;
-        for( srcGroup = rhs.mGrouped.begin(); srcGroup != rhs.mGrouped.end(); ++srcGroup )
+        if (!rhs.mGrouped.empty())
         {
-            PassGroupRenderableMap::iterator dstGroup = mGrouped.find( srcGroup->first );
-            if (dstGroup == mGrouped.end())
-            {
-                std::pair<PassGroupRenderableMap::iterator, bool> retPair;
-                // Create new pass entry, build a new list
-                // Note that this pass and list are never destroyed until the 
-                // engine shuts down, or a pass is destroyed or has it's hash
-                // recalculated, although the lists will be cleared
-                retPair = mGrouped.insert(
-                    PassGroupRenderableMap::value_type(
-                        srcGroup->first, OGRE_NEW_T(RenderableList, MEMCATEGORY_SCENE_CONTROL)() ));
-                assert(retPair.second && 
-                    "Error inserting new pass entry into PassGroupRenderableMap");
-                dstGroup = retPair.first;
-            }
-
-            // Insert renderable
-            dstGroup->second->insert( dstGroup->second->end(), srcGroup->second->begin(), srcGroup->second->end() );
+            // Grouped when next sorted
+            mGrouped.insert( mGrouped.end(), rhs.mGrouped.begin(), rhs.mGrouped.end() );
+            mGroupedDirty = true;
         }
     }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableCollection::setParallelSortThreshold(size_t minRenderables)
+    {
+        msParallelSortThreshold = minRenderables;
+    }
+    //-----------------------------------------------------------------------
+    size_t QueuedRenderableCollection::getParallelSortThreshold(void)
+    {
+        return msParallelSortThreshold;
+    }
 
 
 }
-
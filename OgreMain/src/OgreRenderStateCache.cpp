@@ -0,0 +1,377 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "OgreRenderStateCache.h"
+#include "OgreRenderSystem.h"
+
+namespace Ogre {
+
+    //-----------------------------------------------------------------------
+    RenderStateCache::RenderStateCache(RenderSystem* rs)
+        : mRenderSystem(rs)
+        , mEnabled(true)
+        , mValid(0)
+        , mShininess(0)
+        , mTracking(TVC_NONE)
+        , mLightingEnabled(false)
+        , mFogMode(FOG_NONE)
+        , mFogDensity(0)
+        , mFogStart(0)
+        , mFogEnd(0)
+        , mSourceBlend(SBF_ONE)
+        , mDestBlend(SBF_ZERO)
+        , mSourceBlendAlpha(SBF_ONE)
+        , mDestBlendAlpha(SBF_ZERO)
+        , mBlendOperation(SBO_ADD)
+        , mBlendOperationAlpha(SBO_ADD)
+        , mPointAttenuation(false)
+        , mPointSprites(false)
+        , mDepthCheck(false)
+        , mDepthWrite(false)
+        , mDepthFunction(CMPF_LESS_EQUAL)
+        , mDepthBiasConstant(0)
+        , mDepthBiasSlopeScale(0)
+        , mAlphaRejectFunction(CMPF_ALWAYS_PASS)
+        , mAlphaRejectValue(0)
+        , mAlphaToCoverage(false)
+        , mCullingMode(CULL_NONE)
+        , mShading(SO_GOURAUD)
+        , mPolygonMode(PM_SOLID)
+    {
+        for (size_t i = 0; i <= GPT_COMPUTE_PROGRAM; ++i)
+            mPrograms[i] = 0;
+        for (size_t i = 0; i < 6; ++i)
+            mPointParams[i] = 0;
+        for (size_t i = 0; i < 4; ++i)
+            mColourWrite[i] = false;
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setRenderSystem(RenderSystem* rs)
+    {
+        mRenderSystem = rs;
+        invalidate();
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setEnabled(bool enabled)
+    {
+        mEnabled = enabled;
+        invalidate();
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::invalidate(void)
+    {
+        mValid = 0;
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::invalidateDepthBias(void)
+    {
+        mValid &= ~(1u << STATE_DEPTH_BIAS);
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::resetStatistics(void)
+    {
+        mStatistics = Statistics();
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::bindGpuProgram(GpuProgram* prg)
+    {
+        GpuProgramType gptype = prg->getType();
+        if (needsChange(State(STATE_PROGRAMS + gptype), mPrograms[gptype] == prg))
+        {
+            mPrograms[gptype] = prg;
+            if (mRenderSystem)
+                mRenderSystem->bindGpuProgram(prg);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::unbindGpuProgram(GpuProgramType gptype)
+    {
+        State state = State(STATE_PROGRAMS + gptype);
+        if (!(mEnabled && (mValid & (1u << state))) && mRenderSystem &&
+            !mRenderSystem->isGpuProgramBound(gptype))
+        {
+            // The render system knows there is nothing to unbind
+            mPrograms[gptype] = 0;
+            mValid |= 1u << state;
+            ++mStatistics.redundantChanges;
+            return;
+        }
+        if (needsChange(state, mPrograms[gptype] == 0))
+        {
+            mPrograms[gptype] = 0;
+            if (mRenderSystem)
+                mRenderSystem->unbindGpuProgram(gptype);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setSurfaceParams(const ColourValue& ambient, const ColourValue& diffuse,
+        const ColourValue& specular, const ColourValue& emissive, Real shininess,
+        TrackVertexColourType tracking)
+    {
+        if (needsChange(STATE_SURFACE, mAmbient == ambient && mDiffuse == diffuse &&
+            mSpecular == specular && mEmissive == emissive && mShininess == shininess &&
+            mTracking == tracking))
+        {
+            mAmbient = ambient;
+            mDiffuse = diffuse;
+            mSpecular = specular;
+            mEmissive = emissive;
+            mShininess = shininess;
+            mTracking = tracking;
+            if (mRenderSystem)
+                mRenderSystem->_setSurfaceParams(ambient, diffuse, specular, emissive, shininess, tracking);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setLightingEnabled(bool enabled)
+    {
+        if (needsChange(STATE_LIGHTING, mLightingEnabled == enabled))
+        {
+            mLightingEnabled = enabled;
+            if (mRenderSystem)
+                mRenderSystem->setLightingEnabled(enabled);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setFog(FogMode mode, const ColourValue& colour, Real expDensity,
+        Real linearStart, Real linearEnd)
+    {
+        if (needsChange(STATE_FOG, mFogMode == mode && mFogColour == colour &&
+            mFogDensity == expDensity && mFogStart == linearStart && mFogEnd == linearEnd))
+        {
+            mFogMode = mode;
+            mFogColour = colour;
+            mFogDensity = expDensity;
+            mFogStart = linearStart;
+            mFogEnd = linearEnd;
+            if (mRenderSystem)
+                mRenderSystem->_setFog(mode, colour, expDensity, linearStart, linearEnd);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setSceneBlending(SceneBlendFactor sourceFactor, SceneBlendFactor destFactor,
+        SceneBlendOperation op)
+    {
+        // Non-separate blending is separate blending with the same alpha settings
+        if (needsChange(STATE_BLENDING, mSourceBlend == sourceFactor && mDestBlend == destFactor &&
+            mSourceBlendAlpha == sourceFactor && mDestBlendAlpha == destFactor &&
+            mBlendOperation == op && mBlendOperationAlpha == op))
+        {
+            mSourceBlend = mSourceBlendAlpha = sourceFactor;
+            mDestBlend = mDestBlendAlpha = destFactor;
+            mBlendOperation = mBlendOperationAlpha = op;
+            if (mRenderSystem)
+                mRenderSystem->_setSceneBlending(sourceFactor, destFactor, op);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setSeparateSceneBlending(SceneBlendFactor sourceFactor,
+        SceneBlendFactor destFactor, SceneBlendFactor sourceFactorAlpha,
+        SceneBlendFactor destFactorAlpha, SceneBlendOperation op, SceneBlendOperation alphaOp)
+    {
+        if (needsChange(STATE_BLENDING, mSourceBlend == sourceFactor && mDestBlend == destFactor &&
+            mSourceBlendAlpha == sourceFactorAlpha && mDestBlendAlpha == destFactorAlpha &&
+            mBlendOperation == op && mBlendOperationAlpha == alphaOp))
+        {
+            mSourceBlend = sourceFactor;
+            mDestBlend = destFactor;
+            mSourceBlendAlpha = sourceFactorAlpha;
+            mDestBlendAlpha = destFactorAlpha;
+            mBlendOperation = op;
+            mBlendOperationAlpha = alphaOp;
+            if (mRenderSystem)
+            {
+                mRenderSystem->_setSeparateSceneBlending(sourceFactor, destFactor,
+                    sourceFactorAlpha, destFactorAlpha, op, alphaOp);
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setPointParameters(Real size, bool attenuationEnabled, Real constant,
+        Real linear, Real quadratic, Real minSize, Real maxSize)
+    {
+        Real params[6] = { size, constant, linear, quadratic, minSize, maxSize };
+        bool same = mPointAttenuation == attenuationEnabled;
+        for (size_t i = 0; i < 6; ++i)
+            same &= mPointParams[i] == params[i];
+        if (needsChange(STATE_POINT_PARAMS, same))
+        {
+            mPointAttenuation = attenuationEnabled;
+            for (size_t i = 0; i < 6; ++i)
+                mPointParams[i] = params[i];
+            if (mRenderSystem)
+            {
+                mRenderSystem->_setPointParameters(size, attenuationEnabled, constant,
+                    linear, quadratic, minSize, maxSize);
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setPointSpritesEnabled(bool enabled)
+    {
+        if (needsChange(STATE_POINT_SPRITES, mPointSprites == enabled))
+        {
+            mPointSprites = enabled;
+            if (mRenderSystem)
+                mRenderSystem->_setPointSpritesEnabled(enabled);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setTextureUnitSettings(size_t texUnit, TextureUnitState& tl)
+    {
+        ++mStatistics.appliedChanges;
+        if (mRenderSystem)
+            mRenderSystem->_setTextureUnitSettings(texUnit, tl);
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::disableTextureUnitsFrom(size_t texUnit)
+    {
+        ++mStatistics.appliedChanges;
+        if (mRenderSystem)
+            mRenderSystem->_disableTextureUnitsFrom(texUnit);
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setDepthBufferParams(bool depthTest, bool depthWrite,
+        CompareFunction depthFunction)
+    {
+        uint32 bits = (1u << STATE_DEPTH_CHECK) | (1u << STATE_DEPTH_WRITE) | (1u << STATE_DEPTH_FUNCTION);
+        if (mEnabled && (mValid & bits) == bits && mDepthCheck == depthTest &&
+            mDepthWrite == depthWrite && mDepthFunction == depthFunction)
+        {
+            ++mStatistics.redundantChanges;
+            return;
+        }
+        mValid |= bits;
+        ++mStatistics.appliedChanges;
+        mDepthCheck = depthTest;
+        mDepthWrite = depthWrite;
+        mDepthFunction = depthFunction;
+        if (mRenderSystem)
+            mRenderSystem->_setDepthBufferParams(depthTest, depthWrite, depthFunction);
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setDepthBufferCheckEnabled(bool enabled)
+    {
+        if (needsChange(STATE_DEPTH_CHECK, mDepthCheck == enabled))
+        {
+            mDepthCheck = enabled;
+            if (mRenderSystem)
+                mRenderSystem->_setDepthBufferCheckEnabled(enabled);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setDepthBufferWriteEnabled(bool enabled)
+    {
+        if (needsChange(STATE_DEPTH_WRITE, mDepthWrite == enabled))
+        {
+            mDepthWrite = enabled;
+            if (mRenderSystem)
+                mRenderSystem->_setDepthBufferWriteEnabled(enabled);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setDepthBufferFunction(CompareFunction func)
+    {
+        if (needsChange(STATE_DEPTH_FUNCTION, mDepthFunction == func))
+        {
+            mDepthFunction = func;
+            if (mRenderSystem)
+                mRenderSystem->_setDepthBufferFunction(func);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setDepthBias(float constantBias, float slopeScaleBias)
+    {
+        if (needsChange(STATE_DEPTH_BIAS, mDepthBiasConstant == constantBias &&
+            mDepthBiasSlopeScale == slopeScaleBias))
+        {
+            mDepthBiasConstant = constantBias;
+            mDepthBiasSlopeScale = slopeScaleBias;
+            if (mRenderSystem)
+                mRenderSystem->_setDepthBias(constantBias, slopeScaleBias);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setAlphaRejectSettings(CompareFunction func, unsigned char value,
+        bool alphaToCoverage)
+    {
+        if (needsChange(STATE_ALPHA_REJECT, mAlphaRejectFunction == func &&
+            mAlphaRejectValue == value && mAlphaToCoverage == alphaToCoverage))
+        {
+            mAlphaRejectFunction = func;
+            mAlphaRejectValue = value;
+            mAlphaToCoverage = alphaToCoverage;
+            if (mRenderSystem)
+                mRenderSystem->_setAlphaRejectSettings(func, value, alphaToCoverage);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setColourBufferWriteEnabled(bool red, bool green, bool blue, bool alpha)
+    {
+        if (needsChange(STATE_COLOUR_WRITE, mColourWrite[0] == red && mColourWrite[1] == green &&
+            mColourWrite[2] == blue && mColourWrite[3] == alpha))
+        {
+            mColourWrite[0] = red;
+            mColourWrite[1] = green;
+            mColourWrite[2] = blue;
+            mColourWrite[3] = alpha;
+            if (mRenderSystem)
+                mRenderSystem->_setColourBufferWriteEnabled(red, green, blue, alpha);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setCullingMode(CullingMode mode)
+    {
+        if (needsChange(STATE_CULLING, mCullingMode == mode))
+        {
+            mCullingMode = mode;
+            if (mRenderSystem)
+                mRenderSystem->_setCullingMode(mode);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setShadingType(ShadeOptions so)
+    {
+        if (needsChange(STATE_SHADING, mShading == so))
+        {
+            mShading = so;
+            if (mRenderSystem)
+                mRenderSystem->setShadingType(so);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderStateCache::setPolygonMode(PolygonMode level)
+    {
+        if (needsChange(STATE_POLYGON_MODE, mPolygonMode == level))
+        {
+            mPolygonMode = level;
+            if (mRenderSystem)
+                mRenderSystem->_setPolygonMode(level);
+        }
+    }
+}
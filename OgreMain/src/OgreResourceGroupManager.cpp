@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "OgreScriptLoader.h"
 #include "OgreSceneManager.h"
 #include "OgreResourceManager.h"
+#include "OgreRoot.h"
+#include "OgreTaskScheduler.h"
 
 namespace Ogre {
 
@@ -61,7 +63,7 @@ namespace Ogre {
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     ResourceGroupManager::ResourceGroupManager()
-        : mLoadingListener(0), mCurrentGroup(0)
+        : mLoadingListener(0), mParallelPrepare(false), mParallelScriptParsing(false), mCurrentGroup(0)
     {
         // Create the 'General' group
         createResourceGroup(DEFAULT_RESOURCE_GROUP_NAME, true); // the "General" group is synonymous to global pool
@@ -176,6 +178,43 @@ namespace Ogre {
                 "ResourceGroupManager::prepareResourceGroup");
         }
 
+        if (mParallelPrepare && prepareMainResources)
+        {
+            // Preparing opens files through this class, so it can't stay
+            // locked while the worker threads do that
+            size_t resourceCount = 0;
+            {
+                OGRE_LOCK_AUTO_MUTEX;
+                OGRE_LOCK_MUTEX(grp->OGRE_AUTO_MUTEX_NAME); // lock group mutex
+                ResourceGroup::LoadResourceOrderMap::iterator oi;
+                for (oi = grp->loadResourceOrderMap.begin(); oi != grp->loadResourceOrderMap.end(); ++oi)
+                {
+                    resourceCount += oi->second.size();
+                }
+                if (grp->worldGeometrySceneManager && prepareWorldGeom)
+                {
+                    resourceCount +=
+                        grp->worldGeometrySceneManager->estimateWorldGeometry(
+                            grp->worldGeometry);
+                }
+            }
+
+            fireResourceGroupPrepareStarted(name, resourceCount);
+
+            prepareResourcesParallel(grp, true);
+
+            if (grp->worldGeometrySceneManager && prepareWorldGeom)
+            {
+                OGRE_LOCK_AUTO_MUTEX;
+                grp->worldGeometrySceneManager->prepareWorldGeometry(
+                    grp->worldGeometry);
+            }
+            fireResourceGroupPrepareEnded(name);
+
+            LogManager::getSingleton().logMessage("Finished preparing resource group " + name);
+            return;
+        }
+
         OGRE_LOCK_AUTO_MUTEX;
         OGRE_LOCK_MUTEX(grp->OGRE_AUTO_MUTEX_NAME); // lock group mutex 
         // Set current group
@@ -271,6 +310,13 @@ namespace Ogre {
                 "ResourceGroupManager::loadResourceGroup");
         }
 
+        if (mParallelPrepare && loadMainResources)
+        {
+            // Do the I/O and decoding on the worker threads first, so only
+            // the loading itself is left for the ordered pass below
+            prepareResourcesParallel(grp, false);
+        }
+
         OGRE_LOCK_AUTO_MUTEX;
         OGRE_LOCK_MUTEX(grp->OGRE_AUTO_MUTEX_NAME); // lock group mutex 
         // Set current group
@@ -354,6 +400,109 @@ namespace Ogre {
         LogManager::getSingleton().logMessage("Finished loading resource group " + name);
     }
     //-----------------------------------------------------------------------
+    /// Prepares a range of resources, see ResourceGroupManager::setParallelPrepare
+    struct PrepareResources
+    {
+        const ResourcePtr* mResources;
+
+        PrepareResources(const ResourcePtr* resources) : mResources(resources) {}
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                // Deriving the group changes the group ownership, which is
+                // left to the calling thread
+                if (mResources[i]->getGroup() == ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME)
+                    continue;
+                try
+                {
+                    mResources[i]->prepare(true);
+                }
+                catch (...)
+                {
+                    // Exceptions can't cross threads, failed resources are
+                    // prepared again by the calling thread which reports them
+                }
+            }
+        }
+    };
+    //-----------------------------------------------------------------------
+    void ResourceGroupManager::prepareResourcesParallel(ResourceGroup* grp, bool fireEvents)
+    {
+        typedef vector<ResourcePtr>::type ResourceList;
+        ResourceList resources;
+        ResourceGroup* previousGroup;
+        {
+            OGRE_LOCK_AUTO_MUTEX;
+            OGRE_LOCK_MUTEX(grp->OGRE_AUTO_MUTEX_NAME); // lock group mutex
+            // Set current group, the locks can't be held while the workers run
+            previousGroup = mCurrentGroup;
+            mCurrentGroup = grp;
+            ResourceGroup::LoadResourceOrderMap::iterator oi;
+            for (oi = grp->loadResourceOrderMap.begin(); oi != grp->loadResourceOrderMap.end(); ++oi)
+            {
+                resources.insert(resources.end(), oi->second.begin(), oi->second.end());
+            }
+        }
+
+        try
+        {
+            prepareResourcesParallel(resources, fireEvents);
+        }
+        catch (...)
+        {
+            OGRE_LOCK_AUTO_MUTEX;
+            mCurrentGroup = previousGroup;
+            throw;
+        }
+
+        // reset current group
+        OGRE_LOCK_AUTO_MUTEX;
+        mCurrentGroup = previousGroup;
+    }
+    //-----------------------------------------------------------------------
+    void ResourceGroupManager::prepareResourcesParallel(const vector<ResourcePtr>::type& resources,
+        bool fireEvents)
+    {
+        if (resources.empty())
+            return;
+
+        // A few resources per thread at a time, so progress is still reported
+        size_t batchSize = 4;
+        if (Root::getSingletonPtr() && Root::getSingleton().getTaskScheduler())
+            batchSize *= Root::getSingleton().getTaskScheduler()->getConcurrency();
+
+        vector<bool>::type wasUnloaded(batchSize);
+        for (size_t begin = 0; begin < resources.size(); begin += batchSize)
+        {
+            size_t end = std::min(begin + batchSize, resources.size());
+            for (size_t i = begin; i < end; ++i)
+            {
+                wasUnloaded[i - begin] = resources[i]->getLoadingState() == Resource::LOADSTATE_UNLOADED;
+            }
+
+            parallelFor(begin, end, 1, PrepareResources(&resources[0]),
+                "ResourceGroupManager::prepareResourcesParallel");
+
+            // Listeners are called from this thread only
+            for (size_t i = begin; i < end; ++i)
+            {
+                const ResourcePtr& res = resources[i];
+                if (fireEvents)
+                    fireResourcePrepareStarted(res);
+
+                if (wasUnloaded[i - begin] && res->getLoadingState() == Resource::LOADSTATE_PREPARED)
+                    res->_firePreparingComplete(false);
+                else
+                    res->prepare(); // skips prepared resources, throws for failed ones
+
+                if (fireEvents)
+                    fireResourcePrepareEnded();
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::unloadResourceGroup(const String& name, bool reloadableOnly)
     {
         LogManager::getSingleton().logMessage("Unloading resource group " + name);
@@ -542,7 +691,18 @@ namespace Ogre {
         ResourceLocation* loc = OGRE_NEW_T(ResourceLocation, MEMCATEGORY_RESOURCE);
         loc->archive = pArch;
         loc->recursive = recursive;
-        StringVectorPtr vec = pArch->find("*", recursive);
+
+        // Listing big locations is slow, use the prebuilt list if there is one
+        StringVectorPtr vec;
+        {
+            OGRE_LOCK_AUTO_MUTEX;
+            LocationFileListMap::iterator i =
+                mPrebuiltLocationIndex.find(getLocationIndexKey(name, locType, recursive));
+            if (i != mPrebuiltLocationIndex.end())
+                vec = i->second;
+        }
+        if (!vec)
+            vec = pArch->find("*", recursive);
 
         ResourceGroup* grp = getResourceGroup(resGroup);
         if (!grp)
@@ -556,7 +716,7 @@ namespace Ogre {
 
         // Index resources
         for( StringVector::iterator it = vec->begin(); it != vec->end(); ++it )
-            grp->addToIndex(*it, pArch);
+            addToIndex(grp, *it, pArch);
         
         StringStream msg;
         msg << "Added resource location '" << name << "' of type '" << locType
@@ -588,7 +748,7 @@ namespace Ogre {
             Archive* pArch = (*li)->archive;
             if (pArch->getName() == name)
             {
-                grp->removeFromIndex(pArch);
+                removeFromIndex(grp, pArch);
                 // Erase list entry
                 OGRE_DELETE_T(*li, ResourceLocation, MEMCATEGORY_RESOURCE);
                 grp->locationList.erase(li);
@@ -778,7 +938,7 @@ namespace Ogre {
                 
                 // create it
                 DataStreamPtr ret = arch->create(filename);
-                grp->addToIndex(filename, arch);
+                addToIndex(grp, filename, arch);
 
 
                 return ret;
@@ -816,7 +976,7 @@ namespace Ogre {
                 if (arch->exists(filename))
                 {
                     arch->remove(filename);
-                    grp->removeFromIndex(filename, arch);
+                    removeFromIndex(grp, filename, arch);
 
                     // only remove one file
                     break;
@@ -852,7 +1012,7 @@ namespace Ogre {
                 for (StringVector::iterator f = matchingFiles->begin(); f != matchingFiles->end(); ++f)
                 {
                     arch->remove(*f);
-                    grp->removeFromIndex(*f, arch);
+                    removeFromIndex(grp, *f, arch);
 
                 }
             }
@@ -959,6 +1119,51 @@ namespace Ogre {
         return 0; // No loader was found
     }
     //-----------------------------------------------------------------------
+    namespace
+    {
+        /// A script of a group, see ResourceGroupManager::parseResourceGroupScripts
+        struct ParsedScriptFile
+        {
+            ScriptLoader* loader;
+            const FileInfo* fileInfo;
+            bool skipped;
+            DataStreamPtr stream;
+            ScriptLoader::ParsedScriptPtr parsed;
+
+            ParsedScriptFile(ScriptLoader* l, const FileInfo* fi) : loader(l), fileInfo(fi), skipped(false) {}
+        };
+
+        /// Pre-parses a range of scripts, see ResourceGroupManager::setParallelScriptParsing
+        struct PreParseScripts
+        {
+            ParsedScriptFile* mScripts;
+            const String& mGroupName;
+
+            PreParseScripts(ParsedScriptFile* scripts, const String& groupName)
+                : mScripts(scripts), mGroupName(groupName) {}
+
+            void operator()(size_t begin, size_t end) const
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    ParsedScriptFile& script = mScripts[i];
+                    if (!script.stream)
+                        continue;
+                    try
+                    {
+                        script.parsed = script.loader->preParseScript(script.stream, mGroupName);
+                    }
+                    catch (...)
+                    {
+                        // Exceptions can't cross threads, failed scripts are
+                        // parsed again by the calling thread which reports them
+                        script.parsed.reset();
+                    }
+                }
+            }
+        };
+    }
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::parseResourceGroupScripts(ResourceGroup* grp) const
     {
 
@@ -995,46 +1200,79 @@ namespace Ogre {
         // Fire scripting event
         fireResourceGroupScriptingStarted(grp->name, scriptCount);
 
-        // Iterate over scripts and parse
         // Note we respect original ordering
+        vector<ParsedScriptFile>::type scripts;
+        scripts.reserve(scriptCount);
         for (ScriptLoaderFileList::iterator slfli = scriptLoaderFileList.begin();
             slfli != scriptLoaderFileList.end(); ++slfli)
         {
-            ScriptLoader* su = slfli->first;
             // Iterate over each list
             for (FileListList::iterator flli = slfli->second->begin(); flli != slfli->second->end(); ++flli)
             {
                 // Iterate over each item in the list
                 for (FileInfoList::iterator fii = (*flli)->begin(); fii != (*flli)->end(); ++fii)
                 {
-                    bool skipScript = false;
-                    fireScriptStarted(fii->filename, skipScript);
-                    if(skipScript)
+                    scripts.push_back(ParsedScriptFile(slfli->first, &*fii));
+                }
+            }
+        }
+
+        // A few scripts per thread at a time, so progress is still reported
+        size_t batchSize = 1;
+        if (mParallelScriptParsing)
+        {
+            batchSize = 16;
+            if (Root::getSingletonPtr() && Root::getSingleton().getTaskScheduler())
+                batchSize *= Root::getSingleton().getTaskScheduler()->getConcurrency();
+        }
+
+        // Iterate over scripts and parse
+        for (size_t begin = 0; begin < scripts.size(); begin += batchSize)
+        {
+            size_t end = std::min(begin + batchSize, scripts.size());
+            for (size_t i = begin; i < end; ++i)
+            {
+                ParsedScriptFile& script = scripts[i];
+                fireScriptStarted(script.fileInfo->filename, script.skipped);
+                if(script.skipped)
+                {
+                    LogManager::getSingleton().logMessage(
+                        "Skipping script " + script.fileInfo->filename);
+                }
+                else
+                {
+                    LogManager::getSingleton().logMessage(
+                        "Parsing script " + script.fileInfo->filename);
+                    script.stream = openScript(*script.fileInfo, grp);
+                }
+            }
+
+            if (mParallelScriptParsing)
+            {
+                parallelFor(begin, end, 1, PreParseScripts(&scripts[0], grp->name),
+                    "ResourceGroupManager::parseResourceGroupScripts");
+            }
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                ParsedScriptFile& script = scripts[i];
+                if (script.stream)
+                {
+                    if (!mParallelScriptParsing)
                     {
-                        LogManager::getSingleton().logMessage(
-                            "Skipping script " + fii->filename);
+                        script.loader->parseScript(script.stream, grp->name);
                     }
                     else
                     {
-                        LogManager::getSingleton().logMessage(
-                            "Parsing script " + fii->filename);
-                        DataStreamPtr stream = fii->archive->open(fii->filename);
-                        if (stream)
-                        {
-                            if (mLoadingListener)
-                                mLoadingListener->resourceStreamOpened(fii->filename, grp->name, 0, stream);
-
-                            if(fii->archive->getType() == "FileSystem" && stream->size() <= 1024 * 1024)
-                            {
-                                DataStreamPtr cachedCopy(OGRE_NEW MemoryDataStream(stream->getName(), stream));
-                                su->parseScript(cachedCopy, grp->name);
-                            }
-                            else
-                                su->parseScript(stream, grp->name);
-                        }
+                        // Parse it from the start again, in case pre-parsing gave up half way
+                        if (!script.parsed)
+                            script.stream->seek(0);
+                        script.loader->finishParseScript(script.stream, grp->name, script.parsed);
                     }
-                    fireScriptEnded(fii->filename, skipScript);
+                    script.parsed.reset();
+                    script.stream.reset();
                 }
+                fireScriptEnded(script.fileInfo->filename, script.skipped);
             }
         }
 
@@ -1043,6 +1281,24 @@ namespace Ogre {
             "Finished parsing scripts for resource group " + grp->name);
     }
     //-----------------------------------------------------------------------
+    DataStreamPtr ResourceGroupManager::openScript(const FileInfo& fileInfo, ResourceGroup* grp) const
+    {
+        DataStreamPtr stream = fileInfo.archive->open(fileInfo.filename);
+        if (stream)
+        {
+            if (mLoadingListener)
+                mLoadingListener->resourceStreamOpened(fileInfo.filename, grp->name, 0, stream);
+
+            if(fileInfo.archive->getType() == "FileSystem" && stream->size() <= 1024 * 1024 &&
+               !dynamic_cast<MemoryDataStream*>(stream.get()))
+            {
+                DataStreamPtr cachedCopy(OGRE_NEW MemoryDataStream(stream->getName(), stream));
+                return cachedCopy;
+            }
+        }
+        return stream;
+    }
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::createDeclaredResources(ResourceGroup* grp)
     {
 
@@ -1127,6 +1383,8 @@ namespace Ogre {
     void ResourceGroupManager::_notifyResourceGroupChanged(const String& oldGroup, 
         Resource* res) const
     {
+        // Also called from the worker threads preparing resources in parallel
+        OGRE_LOCK_AUTO_MUTEX;
         ResourcePtr resPtr;
     
         // find old entry
@@ -1267,6 +1525,13 @@ namespace Ogre {
             // delete all the load list entries
             grp->loadResourceOrderMap.clear();
 
+            // Drop the group from the index of its files
+            for (LocationList::iterator ll = grp->locationList.begin();
+                ll != grp->locationList.end(); ++ll)
+            {
+                removeFromIndex(grp, (*ll)->archive);
+            }
+
             // Drop location list
             for (LocationList::iterator ll = grp->locationList.begin();
                 ll != grp->locationList.end(); ++ll)
@@ -1655,18 +1920,49 @@ namespace Ogre {
     std::pair<Archive*, ResourceGroupManager::ResourceGroup*>
     ResourceGroupManager::resourceExistsInAnyGroupImpl(const String& filename) const
     {
-            OGRE_LOCK_AUTO_MUTEX;
+        OGRE_LOCK_AUTO_MUTEX;
 
-            // Iterate over resource groups and find
-        for (ResourceGroupMap::const_iterator i = mResourceGroupMap.begin();
-            i != mResourceGroupMap.end(); ++i)
+        // Get the groups indexing the file rather than trying them all
+        ResourceGroupList candidates;
+        {
+            OGRE_LOCK_MUTEX(mGroupIndexMutex);
+            ResourceGroupIndex::const_iterator i = mGroupIndexCaseSensitive.find(filename);
+            if (i != mGroupIndexCaseSensitive.end())
+                candidates = i->second;
+#if !OGRE_RESOURCEMANAGER_STRICT
+            String lcFilename = filename;
+            StringUtil::toLowerCase(lcFilename);
+            i = mGroupIndexCaseInsensitive.find(lcFilename);
+            if (i != mGroupIndexCaseInsensitive.end())
+                candidates.insert(candidates.end(), i->second.begin(), i->second.end());
+#endif
+        }
+
+        // The first group by name wins, as when searching the groups in turn
+        std::pair<Archive*, ResourceGroup*> ret;
+        for (ResourceGroupList::iterator i = candidates.begin(); i != candidates.end(); ++i)
         {
-            Archive* arch = resourceExists(i->second, filename);
+            if (ret.second && ret.second->name < (*i)->name)
+                continue;
+            Archive* arch = resourceExists(*i, filename);
             if (arch)
-                return std::make_pair(arch, i->second);
+                ret = std::make_pair(arch, *i);
+        }
+
+#if !OGRE_RESOURCEMANAGER_STRICT
+        if (!ret.first)
+        {
+            // Not indexed, search the hard way
+            for (ResourceGroupMap::const_iterator i = mResourceGroupMap.begin();
+                i != mResourceGroupMap.end(); ++i)
+            {
+                Archive* arch = resourceExists(i->second, filename);
+                if (arch)
+                    return std::make_pair(arch, i->second);
+            }
         }
-        // Not found
-        return std::pair<Archive*, ResourceGroup*>();
+#endif
+        return ret;
     }
     //-----------------------------------------------------------------------
     bool ResourceGroupManager::resourceExistsInAnyGroup(const String& filename) const
@@ -1840,52 +2136,86 @@ namespace Ogre {
     }
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
-    void ResourceGroupManager::ResourceGroup::addToIndex(const String& filename, Archive* arch)
+    /// Adds a group to the groups indexing a file
+    template<class Index, class Group>
+    static void addToGroupIndex(Index& index, const String& filename, Group* grp)
+    {
+        typename Index::mapped_type& groups = index[filename];
+        if (std::find(groups.begin(), groups.end(), grp) == groups.end())
+            groups.push_back(grp);
+    }
+    //---------------------------------------------------------------------
+    /// Removes a group from the groups indexing a file
+    template<class Index, class Group>
+    static void removeFromGroupIndex(Index& index, const String& filename, Group* grp)
+    {
+        typename Index::iterator i = index.find(filename);
+        if (i != index.end())
+        {
+            i->second.erase(std::remove(i->second.begin(), i->second.end(), grp), i->second.end());
+            if (i->second.empty())
+                index.erase(i);
+        }
+    }
+    //---------------------------------------------------------------------
+    void ResourceGroupManager::addToIndex(ResourceGroup* grp, const String& filename, Archive* arch)
     {
         // internal, assumes mutex lock has already been obtained
-        this->resourceIndexCaseSensitive[filename] = arch;
+        OGRE_LOCK_MUTEX(mGroupIndexMutex);
+        grp->resourceIndexCaseSensitive[filename] = arch;
+        addToGroupIndex(mGroupIndexCaseSensitive, filename, grp);
 
 #if !OGRE_RESOURCEMANAGER_STRICT
         if (!arch->isCaseSensitive())
         {
             String lcase = filename;
             StringUtil::toLowerCase(lcase);
-            this->resourceIndexCaseInsensitive[lcase] = arch;
+            grp->resourceIndexCaseInsensitive[lcase] = arch;
+            addToGroupIndex(mGroupIndexCaseInsensitive, lcase, grp);
         }
 #endif
     }
     //---------------------------------------------------------------------
-    void ResourceGroupManager::ResourceGroup::removeFromIndex(const String& filename, Archive* arch)
+    void ResourceGroupManager::removeFromIndex(ResourceGroup* grp, const String& filename, Archive* arch)
     {
         // internal, assumes mutex lock has already been obtained
-        ResourceLocationIndex::iterator i = this->resourceIndexCaseSensitive.find(filename);
-        if (i != this->resourceIndexCaseSensitive.end() && i->second == arch)
-            this->resourceIndexCaseSensitive.erase(i);
+        OGRE_LOCK_MUTEX(mGroupIndexMutex);
+        ResourceLocationIndex::iterator i = grp->resourceIndexCaseSensitive.find(filename);
+        if (i != grp->resourceIndexCaseSensitive.end() && i->second == arch)
+        {
+            grp->resourceIndexCaseSensitive.erase(i);
+            removeFromGroupIndex(mGroupIndexCaseSensitive, filename, grp);
+        }
 
 #if !OGRE_RESOURCEMANAGER_STRICT
         if (!arch->isCaseSensitive())
         {
             String lcase = filename;
             StringUtil::toLowerCase(lcase);
-            i = this->resourceIndexCaseInsensitive.find(lcase);
-            if (i != this->resourceIndexCaseInsensitive.end() && i->second == arch)
-                this->resourceIndexCaseInsensitive.erase(i);
+            i = grp->resourceIndexCaseInsensitive.find(lcase);
+            if (i != grp->resourceIndexCaseInsensitive.end() && i->second == arch)
+            {
+                grp->resourceIndexCaseInsensitive.erase(i);
+                removeFromGroupIndex(mGroupIndexCaseInsensitive, lcase, grp);
+            }
         }
 #endif
     }
     //---------------------------------------------------------------------
-    void ResourceGroupManager::ResourceGroup::removeFromIndex(Archive* arch)
+    void ResourceGroupManager::removeFromIndex(ResourceGroup* grp, Archive* arch)
     {
         // Delete indexes
+        OGRE_LOCK_MUTEX(mGroupIndexMutex);
         ResourceLocationIndex::iterator rit, ritend;
 #if !OGRE_RESOURCEMANAGER_STRICT
-        ritend = this->resourceIndexCaseInsensitive.end();
-        for (rit = this->resourceIndexCaseInsensitive.begin(); rit != ritend;)
+        ritend = grp->resourceIndexCaseInsensitive.end();
+        for (rit = grp->resourceIndexCaseInsensitive.begin(); rit != ritend;)
         {
             if (rit->second == arch)
             {
+                removeFromGroupIndex(mGroupIndexCaseInsensitive, rit->first, grp);
                 ResourceLocationIndex::iterator del = rit++;
-                this->resourceIndexCaseInsensitive.erase(del);
+                grp->resourceIndexCaseInsensitive.erase(del);
             }
             else
             {
@@ -1893,13 +2223,14 @@ namespace Ogre {
             }
         }
 #endif
-        ritend = this->resourceIndexCaseSensitive.end();
-        for (rit = this->resourceIndexCaseSensitive.begin(); rit != ritend;)
+        ritend = grp->resourceIndexCaseSensitive.end();
+        for (rit = grp->resourceIndexCaseSensitive.begin(); rit != ritend;)
         {
             if (rit->second == arch)
             {
+                removeFromGroupIndex(mGroupIndexCaseSensitive, rit->first, grp);
                 ResourceLocationIndex::iterator del = rit++;
-                this->resourceIndexCaseSensitive.erase(del);
+                grp->resourceIndexCaseSensitive.erase(del);
             }
             else
             {
@@ -1908,4 +2239,95 @@ namespace Ogre {
         }
 
     }
+    //---------------------------------------------------------------------
+    String ResourceGroupManager::getLocationIndexKey(const String& name,
+        const String& locType, bool recursive)
+    {
+        return locType + (recursive ? "\t1\t" : "\t0\t") + name;
+    }
+    //---------------------------------------------------------------------
+    void ResourceGroupManager::loadResourceLocationIndex(const DataStreamPtr& stream)
+    {
+        // Each location is a line "L<tab>type<tab>recursive<tab>name", followed
+        // by a line "F<tab>file" for each of its files
+        LocationFileListMap locations;
+        StringVectorPtr files;
+        while (!stream->eof())
+        {
+            String line = stream->getLine(false);
+            if (line.size() < 2 || line[1] != '\t')
+                continue;
+
+            if (line[0] == 'L')
+            {
+                StringVector fields = StringUtil::split(line, "\t", 3);
+                if (fields.size() != 4)
+                {
+                    OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS,
+                        "Invalid resource location index line: " + line,
+                        "ResourceGroupManager::loadResourceLocationIndex");
+                }
+                files = StringVectorPtr(OGRE_NEW_T(StringVector, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
+                locations[getLocationIndexKey(fields[3], fields[1], fields[2] == "1")] = files;
+            }
+            else if (line[0] == 'F' && files)
+            {
+                files->push_back(line.substr(2));
+            }
+        }
+
+        OGRE_LOCK_AUTO_MUTEX;
+        for (LocationFileListMap::iterator i = locations.begin(); i != locations.end(); ++i)
+            mPrebuiltLocationIndex[i->first] = i->second;
+
+        LogManager::getSingleton().stream() << "Loaded the file lists of "
+            << locations.size() << " resource locations from '" << stream->getName() << "'";
+    }
+    //---------------------------------------------------------------------
+    void ResourceGroupManager::saveResourceLocationIndex(const String& filename) const
+    {
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+        if (!file)
+        {
+            OGRE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE,
+                "Cannot open file '" + filename + "' for writing",
+                "ResourceGroupManager::saveResourceLocationIndex");
+        }
+
+        OGRE_LOCK_AUTO_MUTEX;
+        for (ResourceGroupMap::const_iterator g = mResourceGroupMap.begin();
+            g != mResourceGroupMap.end(); ++g)
+        {
+            ResourceGroup* grp = g->second;
+            OGRE_LOCK_MUTEX(grp->OGRE_AUTO_MUTEX_NAME); // lock group mutex
+
+            // Sort the indexed files back by location
+            typedef map<Archive*, StringVector>::type ArchiveFileMap;
+            ArchiveFileMap archiveFiles;
+            for (ResourceLocationIndex::const_iterator i = grp->resourceIndexCaseSensitive.begin();
+                i != grp->resourceIndexCaseSensitive.end(); ++i)
+            {
+                archiveFiles[i->second].push_back(i->first);
+            }
+
+            for (LocationList::const_iterator li = grp->locationList.begin();
+                li != grp->locationList.end(); ++li)
+            {
+                Archive* arch = (*li)->archive;
+                file << "L\t" << arch->getType() << '\t' << ((*li)->recursive ? '1' : '0')
+                    << '\t' << arch->getName() << '\n';
+
+                const StringVector& files = archiveFiles[arch];
+                for (StringVector::const_iterator f = files.begin(); f != files.end(); ++f)
+                    file << "F\t" << *f << '\n';
+            }
+        }
+
+        if (!file)
+        {
+            OGRE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE,
+                "Error writing file '" + filename + "'",
+                "ResourceGroupManager::saveResourceLocationIndex");
+        }
+    }
 }
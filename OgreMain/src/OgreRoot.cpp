@@ -64,6 +64,7 @@ THE SOFTWARE.
 #include "OgreFrameListener.h"
 #include "OgreLodStrategyManager.h"
 #include "Threading/OgreDefaultWorkQueue.h"
+#include "OgreTaskScheduler.h"
 #include "OgreFileSystemLayer.h"
 
 #if OGRE_NO_FREEIMAGE == 0
@@ -182,6 +183,7 @@ namespace Ogre {
         defaultQ->setWorkersCanAccessRenderSystem(false);
 #endif
         mWorkQueue = defaultQ;
+        mTaskScheduler = OGRE_NEW TaskScheduler(mWorkQueue);
 
         // ResourceBackgroundQueue
         mResourceBackgroundQueue = OGRE_NEW ResourceBackgroundQueue();
@@ -225,6 +227,8 @@ namespace Ogre {
 #   if OGRE_NO_ZIP_ARCHIVE == 0
         mZipArchiveFactory = OGRE_NEW ZipArchiveFactory();
         ArchiveManager::getSingleton().addArchiveFactory( mZipArchiveFactory );
+        mMappedZipArchiveFactory = OGRE_NEW MappedZipArchiveFactory();
+        ArchiveManager::getSingleton().addArchiveFactory( mMappedZipArchiveFactory );
         mEmbeddedZipArchiveFactory = OGRE_NEW EmbeddedZipArchiveFactory();
         ArchiveManager::getSingleton().addArchiveFactory( mEmbeddedZipArchiveFactory );
 #   endif
@@ -320,6 +324,7 @@ namespace Ogre {
 
 #   if OGRE_NO_ZIP_ARCHIVE == 0
         OGRE_DELETE mZipArchiveFactory;
+        OGRE_DELETE mMappedZipArchiveFactory;
         OGRE_DELETE mEmbeddedZipArchiveFactory;
 #   endif
         OGRE_DELETE mFileSystemArchiveFactory;
@@ -344,6 +349,7 @@ namespace Ogre {
         OGRE_DELETE mBillboardChainFactory;
         OGRE_DELETE mRibbonTrailFactory;
 
+        OGRE_DELETE mTaskScheduler;
         OGRE_DELETE mWorkQueue;
 
         OGRE_DELETE mTimer;
@@ -1629,9 +1635,11 @@ namespace Ogre {
         if (mWorkQueue != queue)
         {
             // delete old one (will shut down)
+            OGRE_DELETE mTaskScheduler;
             OGRE_DELETE mWorkQueue;
 
             mWorkQueue = queue;
+            mTaskScheduler = OGRE_NEW TaskScheduler(mWorkQueue);
             if (mIsInitialised)
                 mWorkQueue->startup();
 
@@ -131,12 +131,19 @@ namespace Ogre {
     //---------------------------------------------------------------------
     Codec::DecodeResult STBIImageCodec::decode(DataStreamPtr& input) const
     {
-        // Buffer stream into memory (TODO: override IO functions instead?)
-        MemoryDataStream memStream(input, true);
+        // Decode in place if the stream is already in memory (e.g. memory mapped),
+        // otherwise buffer it into memory (TODO: override IO functions instead?)
+        MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(input.get());
+        MemoryDataStreamPtr buffered;
+        if (!memStream)
+        {
+            buffered.reset(OGRE_NEW MemoryDataStream(input, true));
+            memStream = buffered.get();
+        }
 
         int width, height, components;
-        stbi_uc* pixelData = stbi_load_from_memory(memStream.getPtr(),
-                static_cast<int>(memStream.size()), &width, &height, &components, 0);
+        stbi_uc* pixelData = stbi_load_from_memory(memStream->getCurrentPtr(),
+                static_cast<int>(memStream->size() - memStream->tell()), &width, &height, &components, 0);
 
         if (!pixelData)
         {
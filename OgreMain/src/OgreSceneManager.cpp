@@ -64,6 +64,10 @@ THE SOFTWARE.
 #include "OgreLodListener.h"
 #include "OgreInstancedGeometry.h"
 #include "OgreUnifiedHighLevelGpuProgram.h"
+#include "OgreOptimisedUtil.h"
+#include "OgreSkeletonAnimationBatch.h"
+#include "OgreSoftwareSkinningBatch.h"
+#include "Threading/OgreBarrier.h"
 
 // This class implements the most basic scene manager
 
@@ -109,6 +113,11 @@ mResetIdentityProj(false),
 mNormaliseNormalsOnScale(true),
 mFlipCullingOnNegativeScale(true),
 mLightsDirtyCounter(0),
+mLightGridEnabled(false),
+mLightGridValid(false),
+mLightGridCellSize(1),
+mLightGridGlobalSignature(0),
+mLightGridStamp(0),
 mMovableNameGenerator("Ogre/MO"),
 mShadowCasterPlainBlackPass(0),
 mShadowReceiverPass(0),
@@ -151,7 +160,20 @@ mCameraRelativeRendering(false),
 mLastLightHash(0),
 mLastLightLimit(0),
 mLastLightHashGpuProgram(0),
-mGpuParamsDirty((uint16)GPV_ALL)
+mGpuParamsDirty((uint16)GPV_ALL),
+mNumWorkerThreads(0),
+mWorkerThreadsBarrier(0),
+mExitWorkerThreads(false),
+mWorkerRequest(WR_UPDATE_TRANSFORMS),
+mParallelTransformUpdate(false),
+mUpdateLevelIndex(0),
+mQueryTree(0),
+mParallelCulling(false),
+mCullNodesDirty(true),
+mNumCullPlanes(0),
+mSkeletonAnimationBatch(0),
+mSoftwareSkinningBatch(0),
+mRenderStateFrameNumber(0)
 {
 
     // init sky
@@ -187,6 +209,7 @@ mGpuParamsDirty((uint16)GPV_ALL)
 //-----------------------------------------------------------------------
 SceneManager::~SceneManager()
 {
+    stopWorkerThreads();
     fireSceneManagerDestroyed();
     destroyShadowTextures();
     clearScene();
@@ -212,6 +235,9 @@ SceneManager::~SceneManager()
     OGRE_DELETE mShadowCasterAABBQuery;
     OGRE_DELETE mRenderQueue;
     OGRE_DELETE mAutoParamDataSource;
+    OGRE_DELETE mQueryTree;
+    OGRE_DELETE mSkeletonAnimationBatch;
+    OGRE_DELETE mSoftwareSkinningBatch;
 }
 //-----------------------------------------------------------------------
 RenderQueue* SceneManager::getRenderQueue(void)
@@ -427,24 +453,301 @@ bool SceneManager::lightLess::operator()(const Light* a, const Light* b) const
     return a->tempSquareDist < b->tempSquareDist;
 }
 //-----------------------------------------------------------------------
+namespace
+{
+    /// With fewer point and spot lights than this, they are simply tested one by one
+    const size_t LIGHT_GRID_MIN_LIGHTS = 8;
+    /// Lights and spheres overlapping more cells than this are not looked up in the grid
+    const int LIGHT_GRID_MAX_CELLS = 64;
+
+    uint32 hashLightGridCell(int x, int y, int z)
+    {
+        return (static_cast<uint32>(x) * 73856093u) ^ (static_cast<uint32>(y) * 19349663u) ^
+            (static_cast<uint32>(z) * 83492791u);
+    }
+
+    /// Starting value of the light list signatures
+    const uint64 LIGHT_SIGNATURE_SEED = 14695981039346656037ULL;
+
+    /// 64 bit FNV-1a, so that unrelated light lists practically never share a signature
+    template <typename T>
+    uint64 hashCombine64(uint64 hashSoFar, const T& data)
+    {
+        const uchar* bytes = reinterpret_cast<const uchar*>(&data);
+        for (size_t i = 0; i < sizeof(T); ++i)
+            hashSoFar = (hashSoFar ^ bytes[i]) * 1099511628211ULL;
+        return hashSoFar;
+    }
+
+    /// What Light::isInLightRange depends on
+    uint64 hashLight(uint64 hashSoFar, Light* light)
+    {
+        hashSoFar = hashCombine64(hashSoFar, light);
+        hashSoFar = hashCombine64(hashSoFar, light->getType());
+        hashSoFar = hashCombine64(hashSoFar, light->getLightMask());
+        if (light->getType() != Light::LT_DIRECTIONAL)
+        {
+            hashSoFar = hashCombine64(hashSoFar, light->getAttenuationRange());
+            hashSoFar = hashCombine64(hashSoFar, light->getDerivedPosition());
+        }
+        // Spot lights are also tested against their cone
+        if (light->getType() == Light::LT_SPOTLIGHT)
+        {
+            hashSoFar = hashCombine64(hashSoFar, light->getDerivedDirection());
+            hashSoFar = hashCombine64(hashSoFar, light->getSpotlightOuterAngle());
+        }
+        return hashSoFar;
+    }
+}
+//-----------------------------------------------------------------------
+void SceneManager::setLightGridEnabled(bool enabled)
+{
+    mLightGridEnabled = enabled;
+    mLightGridValid = false;
+    // Have the next findLightsAffectingFrustum see a change, and rebuild the grid
+    mCachedLightInfos.clear();
+}
+//-----------------------------------------------------------------------
+bool SceneManager::getLightGridCellRange(const Vector3& position, Real radius,
+    int minCell[3], int maxCell[3]) const
+{
+    const Real invCellSize = 1 / mLightGridCellSize;
+    int numCells = 1;
+    for (int i = 0; i < 3; ++i)
+    {
+        const Real low = Math::Floor((position[i] - radius) * invCellSize);
+        const Real high = Math::Floor((position[i] + radius) * invCellSize);
+        // Also rejects NaNs and coordinates out of the range of int
+        if (!(high - low < LIGHT_GRID_MAX_CELLS) || !(Math::Abs(low) < 1e9f))
+            return false;
+        minCell[i] = static_cast<int>(low);
+        maxCell[i] = static_cast<int>(high);
+        numCells *= maxCell[i] - minCell[i] + 1;
+    }
+    return numCells <= LIGHT_GRID_MAX_CELLS;
+}
+//-----------------------------------------------------------------------
+const SceneManager::LightGridCell* SceneManager::findLightGridCell(int x, int y, int z) const
+{
+    const size_t mask = mLightGridCells.size() - 1;
+    for (size_t slot = hashLightGridCell(x, y, z) & mask; ; slot = (slot + 1) & mask)
+    {
+        const LightGridCell& cell = mLightGridCells[slot];
+        if (!cell.count)
+            return 0;
+        if (cell.x == x && cell.y == y && cell.z == z)
+            return &cell;
+    }
+}
+//-----------------------------------------------------------------------
+void SceneManager::buildLightGrid(void)
+{
+    mLightGridValid = false;
+    mLightGridCells.clear();
+    mLightGridIndices.clear();
+    mLightGridGlobalIndices.clear();
+    mLightGridEntries.clear();
+    if (!mLightGridEnabled)
+        return;
+
+    const LightList& lights = mLightsAffectingFrustum;
+    Real rangeSum = 0;
+    size_t numLocalLights = 0;
+    for (LightList::const_iterator i = lights.begin(); i != lights.end(); ++i)
+    {
+        if ((*i)->getType() != Light::LT_DIRECTIONAL)
+        {
+            rangeSum += (*i)->getAttenuationRange();
+            ++numLocalLights;
+        }
+    }
+    if (numLocalLights < LIGHT_GRID_MIN_LIGHTS)
+        return;
+
+    // Cells as large as an average light, rounded to a power of two so that the size
+    // does not change every time a light does
+    mLightGridCellSize = Math::Pow(2, Math::Ceil(Math::Log2(2 * rangeSum / numLocalLights)));
+    if (!(mLightGridCellSize > 0) || !(mLightGridCellSize < std::numeric_limits<Real>::max()))
+        return;
+
+    mLightGridGlobalSignature = hashCombine64(LIGHT_SIGNATURE_SEED, mLightGridCellSize);
+    for (uint32 index = 0; index < lights.size(); ++index)
+    {
+        Light* light = lights[index];
+        int minCell[3], maxCell[3];
+        // Slightly enlarged, the exact test is left to Light::isInLightRange
+        if (light->getType() == Light::LT_DIRECTIONAL ||
+            !getLightGridCellRange(light->getDerivedPosition(),
+                light->getAttenuationRange() * 1.01f, minCell, maxCell))
+        {
+            mLightGridGlobalIndices.push_back(index);
+            mLightGridGlobalSignature = hashLight(mLightGridGlobalSignature, light);
+            continue;
+        }
+
+        LightGridEntry entry;
+        entry.light = index;
+        for (entry.x = minCell[0]; entry.x <= maxCell[0]; ++entry.x)
+            for (entry.y = minCell[1]; entry.y <= maxCell[1]; ++entry.y)
+                for (entry.z = minCell[2]; entry.z <= maxCell[2]; ++entry.z)
+                    mLightGridEntries.push_back(entry);
+    }
+    std::sort(mLightGridEntries.begin(), mLightGridEntries.end());
+
+    size_t numCells = 0;
+    for (size_t i = 0; i < mLightGridEntries.size(); ++i)
+    {
+        const LightGridEntry& entry = mLightGridEntries[i];
+        if (i == 0 || entry.x != mLightGridEntries[i - 1].x ||
+            entry.y != mLightGridEntries[i - 1].y || entry.z != mLightGridEntries[i - 1].z)
+        {
+            ++numCells;
+        }
+    }
+
+    // At most half full, for short probe sequences
+    size_t tableSize = 16;
+    while (tableSize < numCells * 2)
+        tableSize *= 2;
+    LightGridCell freeCell;
+    freeCell.x = freeCell.y = freeCell.z = 0;
+    freeCell.start = freeCell.count = freeCell.signature = 0;
+    mLightGridCells.assign(tableSize, freeCell);
+    mLightGridIndices.reserve(mLightGridEntries.size());
+
+    size_t i = 0;
+    while (i < mLightGridEntries.size())
+    {
+        LightGridCell cell;
+        cell.x = mLightGridEntries[i].x;
+        cell.y = mLightGridEntries[i].y;
+        cell.z = mLightGridEntries[i].z;
+        cell.start = static_cast<uint32>(mLightGridIndices.size());
+        cell.signature = hashCombine64(LIGHT_SIGNATURE_SEED, hashLightGridCell(cell.x, cell.y, cell.z));
+        for (; i < mLightGridEntries.size() && mLightGridEntries[i].x == cell.x &&
+            mLightGridEntries[i].y == cell.y && mLightGridEntries[i].z == cell.z; ++i)
+        {
+            mLightGridIndices.push_back(mLightGridEntries[i].light);
+            cell.signature = hashLight(cell.signature, lights[mLightGridEntries[i].light]);
+        }
+        cell.count = static_cast<uint32>(mLightGridIndices.size()) - cell.start;
+
+        size_t slot = hashLightGridCell(cell.x, cell.y, cell.z) & (tableSize - 1);
+        while (mLightGridCells[slot].count)
+            slot = (slot + 1) & (tableSize - 1);
+        mLightGridCells[slot] = cell;
+    }
+
+    mLightGridStamps.assign(lights.size(), 0);
+    mLightGridStamp = 0;
+    mLightGridValid = true;
+}
+//-----------------------------------------------------------------------
+void SceneManager::gatherLightGridCandidates(const Vector3& position, Real radius)
+{
+    mLightGridCandidates.clear();
+
+    int minCell[3], maxCell[3];
+    if (!getLightGridCellRange(position, radius, minCell, maxCell))
+    {
+        // Too large, test every light
+        for (uint32 index = 0; index < mLightGridStamps.size(); ++index)
+            mLightGridCandidates.push_back(index);
+        return;
+    }
+
+    if (++mLightGridStamp == 0)
+    {
+        std::fill(mLightGridStamps.begin(), mLightGridStamps.end(), 0);
+        mLightGridStamp = 1;
+    }
+
+    mLightGridCandidates.insert(mLightGridCandidates.end(),
+        mLightGridGlobalIndices.begin(), mLightGridGlobalIndices.end());
+    for (int x = minCell[0]; x <= maxCell[0]; ++x)
+    {
+        for (int y = minCell[1]; y <= maxCell[1]; ++y)
+        {
+            for (int z = minCell[2]; z <= maxCell[2]; ++z)
+            {
+                const LightGridCell* cell = findLightGridCell(x, y, z);
+                if (!cell)
+                    continue;
+                for (uint32 i = cell->start; i < cell->start + cell->count; ++i)
+                {
+                    const uint32 index = mLightGridIndices[i];
+                    if (mLightGridStamps[index] != mLightGridStamp)
+                    {
+                        mLightGridStamps[index] = mLightGridStamp;
+                        mLightGridCandidates.push_back(index);
+                    }
+                }
+            }
+        }
+    }
+
+    // Same order as the lights affecting the frustum, so the sort below gives the
+    // same result as without the grid
+    std::sort(mLightGridCandidates.begin(), mLightGridCandidates.end());
+}
+//-----------------------------------------------------------------------
+uint64 SceneManager::_getLightListSignature(const Vector3& position, Real radius,
+    uint32 lightMask) const
+{
+    // The lists depend on the order of the lights affecting the frustum, which
+    // is sorted by distance to the camera with texture shadows
+    if (!mLightGridValid || isShadowTechniqueTextureBased())
+        return 0;
+
+    int minCell[3], maxCell[3];
+    if (!getLightGridCellRange(position, radius, minCell, maxCell))
+        return 0;
+
+    // The exact range tests depend on the sphere, not only on the cells it overlaps
+    uint64 signature = hashCombine64(mLightGridGlobalSignature, lightMask);
+    signature = hashCombine64(signature, position);
+    signature = hashCombine64(signature, radius);
+    size_t numLights = mLightGridGlobalIndices.size();
+    for (int x = minCell[0]; x <= maxCell[0]; ++x)
+    {
+        for (int y = minCell[1]; y <= maxCell[1]; ++y)
+        {
+            for (int z = minCell[2]; z <= maxCell[2]; ++z)
+            {
+                const LightGridCell* cell = findLightGridCell(x, y, z);
+                if (cell)
+                {
+                    signature = hashCombine64(signature, cell->signature);
+                    numLights += cell->count;
+                }
+            }
+        }
+    }
+    signature = hashCombine64(signature, numLights);
+    // 0 is reserved for unknown
+    return signature ? signature : 1;
+}
+//-----------------------------------------------------------------------
 void SceneManager::_populateLightList(const Vector3& position, Real radius, 
                                       LightList& destList, uint32 lightMask)
 {
-    // Really basic trawl of the lights, then sort
-    // Subclasses could do something smarter
-
     // Pick up the lights that affecting frustum only, which should has been
     // cached, so better than take all lights in the scene into account.
     const LightList& candidateLights = _getLightsAffectingFrustum();
 
+    // Only the lights of the grid cells overlapping the sphere, if there are many
+    const bool useGrid = mLightGridValid && mLightGridStamps.size() == candidateLights.size();
+    if (useGrid)
+        gatherLightGridCandidates(position, radius);
+    const size_t numCandidates = useGrid ? mLightGridCandidates.size() : candidateLights.size();
+
     // Pre-allocate memory
     destList.clear();
-    destList.reserve(candidateLights.size());
+    destList.reserve(numCandidates);
 
-    LightList::const_iterator it;
-    for (it = candidateLights.begin(); it != candidateLights.end(); ++it)
+    for (size_t c = 0; c < numCandidates; ++c)
     {
-        Light* lt = *it;
+        Light* lt = candidateLights[useGrid ? mLightGridCandidates[c] : c];
         // check whether or not this light is suppose to be taken into consideration for the current light mask set for this operation
         if(!(lt->getLightMask() & lightMask))
             continue; //skip this light
@@ -808,8 +1111,10 @@ void SceneManager::clearScene(void)
         mRenderQueue->clear(true);
 
     // Reset ParamDataSource, when a resource is removed the mAutoParamDataSource keep bad references
+    bool sharedBlocks = mAutoParamDataSource->getSharedBlocksEnabled();
     OGRE_DELETE mAutoParamDataSource;
     mAutoParamDataSource = createAutoParamDataSource();
+    mAutoParamDataSource->setSharedBlocksEnabled(sharedBlocks);
 }
 //-----------------------------------------------------------------------
 SceneNode* SceneManager::createSceneNodeImpl(void)
@@ -981,10 +1286,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         else
         {
             // Unbind program?
-            if (mDestRenderSystem->isGpuProgramBound(GPT_VERTEX_PROGRAM))
-            {
-                mDestRenderSystem->unbindGpuProgram(GPT_VERTEX_PROGRAM);
-            }
+            mRenderStateCache.unbindGpuProgram(GPT_VERTEX_PROGRAM);
             // Set fixed-function vertex parameters
         }
 
@@ -996,10 +1298,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         else
         {
             // Unbind program?
-            if (mDestRenderSystem->isGpuProgramBound(GPT_GEOMETRY_PROGRAM))
-            {
-                mDestRenderSystem->unbindGpuProgram(GPT_GEOMETRY_PROGRAM);
-            }
+            mRenderStateCache.unbindGpuProgram(GPT_GEOMETRY_PROGRAM);
             // Set fixed-function vertex parameters
         }
         if (pass->hasTessellationHullProgram())
@@ -1010,10 +1309,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         else
         {
             // Unbind program?
-            if (mDestRenderSystem->isGpuProgramBound(GPT_HULL_PROGRAM))
-            {
-                mDestRenderSystem->unbindGpuProgram(GPT_HULL_PROGRAM);
-            }
+            mRenderStateCache.unbindGpuProgram(GPT_HULL_PROGRAM);
             // Set fixed-function tessellation control parameters
         }
 
@@ -1025,10 +1321,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         else
         {
             // Unbind program?
-            if (mDestRenderSystem->isGpuProgramBound(GPT_DOMAIN_PROGRAM))
-            {
-                mDestRenderSystem->unbindGpuProgram(GPT_DOMAIN_PROGRAM);
-            }
+            mRenderStateCache.unbindGpuProgram(GPT_DOMAIN_PROGRAM);
             // Set fixed-function tessellation evaluation parameters
         }
 
@@ -1040,10 +1333,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         else
         {
                     // Unbind program?
-                    if (mDestRenderSystem->isGpuProgramBound(GPT_COMPUTE_PROGRAM))
-                    {
-                        mDestRenderSystem->unbindGpuProgram(GPT_COMPUTE_PROGRAM);
-                    }
+                    mRenderStateCache.unbindGpuProgram(GPT_COMPUTE_PROGRAM);
                     // Set fixed-function compute parameters
         }
 
@@ -1052,7 +1342,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
             // Set surface reflectance properties, only valid if lighting is enabled
             if (pass->getLightingEnabled())
             {
-                mDestRenderSystem->_setSurfaceParams( 
+                mRenderStateCache.setSurfaceParams( 
                     pass->getAmbient(), 
                     pass->getDiffuse(), 
                     pass->getSpecular(), 
@@ -1062,7 +1352,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
             }
 
             // Dynamic lighting enabled?
-            mDestRenderSystem->setLightingEnabled(pass->getLightingEnabled());
+            mRenderStateCache.setLightingEnabled(pass->getLightingEnabled());
         }
 
         // Using a fragment program?
@@ -1084,10 +1374,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         else
         {
             // Unbind program?
-            if (mDestRenderSystem->isGpuProgramBound(GPT_FRAGMENT_PROGRAM))
-            {
-                mDestRenderSystem->unbindGpuProgram(GPT_FRAGMENT_PROGRAM);
-            }
+            mRenderStateCache.unbindGpuProgram(GPT_FRAGMENT_PROGRAM);
 
             // Set fixed-function fragment settings
         }
@@ -1122,7 +1409,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
             fragment program, and in other ways, them maybe access by gpu program via
             "state.fog.XXX".
             */
-            mDestRenderSystem->_setFog(
+            mRenderStateCache.setFog(
                 newFogMode, newFogColour, newFogDensity, newFogStart, newFogEnd);
         }
         // Tell params about ORIGINAL fog
@@ -1136,7 +1423,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         // Set scene blending
         if ( pass->hasSeparateSceneBlending( ) )
         {
-            mDestRenderSystem->_setSeparateSceneBlending(
+            mRenderStateCache.setSeparateSceneBlending(
                 pass->getSourceBlendFactor(), pass->getDestBlendFactor(),
                 pass->getSourceBlendFactorAlpha(), pass->getDestBlendFactorAlpha(),
                 pass->getSceneBlendingOperation(), 
@@ -1146,20 +1433,20 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         {
             if(pass->hasSeparateSceneBlendingOperations( ) )
             {
-                mDestRenderSystem->_setSeparateSceneBlending(
+                mRenderStateCache.setSeparateSceneBlending(
                     pass->getSourceBlendFactor(), pass->getDestBlendFactor(),
                     pass->getSourceBlendFactor(), pass->getDestBlendFactor(),
                     pass->getSceneBlendingOperation(), pass->getSceneBlendingOperationAlpha() );
             }
             else
             {
-                mDestRenderSystem->_setSceneBlending(
+                mRenderStateCache.setSceneBlending(
                     pass->getSourceBlendFactor(), pass->getDestBlendFactor(), pass->getSceneBlendingOperation() );
             }
         }
 
         // Set point parameters
-        mDestRenderSystem->_setPointParameters(
+        mRenderStateCache.setPointParameters(
             pass->getPointSize(),
             pass->isPointAttenuationEnabled(), 
             pass->getPointAttenuationConstant(), 
@@ -1169,7 +1456,7 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
             pass->getPointMaxSize());
 
         if (mDestRenderSystem->getCapabilities()->hasCapability(RSC_POINT_SPRITES))
-            mDestRenderSystem->_setPointSpritesEnabled(pass->getPointSpritesEnabled());
+            mRenderStateCache.setPointSpritesEnabled(pass->getPointSpritesEnabled());
 
         // Texture unit settings
         size_t unit = 0;
@@ -1261,26 +1548,26 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
                 }
                 pTex->_setTexturePtr(refTex);
             }
-            mDestRenderSystem->_setTextureUnitSettings(unit, *pTex);
+            mRenderStateCache.setTextureUnitSettings(unit, *pTex);
             ++unit;
         }
         // Disable remaining texture units
-        mDestRenderSystem->_disableTextureUnitsFrom(pass->getNumTextureUnitStates());
+        mRenderStateCache.disableTextureUnitsFrom(pass->getNumTextureUnitStates());
 
         // Set up non-texture related material settings
         // Depth buffer settings
-        mDestRenderSystem->_setDepthBufferFunction(pass->getDepthFunction());
-        mDestRenderSystem->_setDepthBufferCheckEnabled(pass->getDepthCheckEnabled());
-        mDestRenderSystem->_setDepthBufferWriteEnabled(pass->getDepthWriteEnabled());
-        mDestRenderSystem->_setDepthBias(pass->getDepthBiasConstant(), 
+        mRenderStateCache.setDepthBufferFunction(pass->getDepthFunction());
+        mRenderStateCache.setDepthBufferCheckEnabled(pass->getDepthCheckEnabled());
+        mRenderStateCache.setDepthBufferWriteEnabled(pass->getDepthWriteEnabled());
+        mRenderStateCache.setDepthBias(pass->getDepthBiasConstant(), 
             pass->getDepthBiasSlopeScale());
         // Alpha-reject settings
-        mDestRenderSystem->_setAlphaRejectSettings(
+        mRenderStateCache.setAlphaRejectSettings(
             pass->getAlphaRejectFunction(), pass->getAlphaRejectValue(), pass->isAlphaToCoverageEnabled());
         // Set colour write mode
         // Right now we only use on/off, not per-channel
         bool colWrite = pass->getColourWriteEnabled();
-        mDestRenderSystem->_setColourBufferWriteEnabled(colWrite, colWrite, colWrite, colWrite);
+        mRenderStateCache.setColourBufferWriteEnabled(colWrite, colWrite, colWrite, colWrite);
         // Culling mode
         if (isShadowTechniqueTextureBased() 
             && mIlluminationStage == IRS_RENDER_TO_TEXTURE
@@ -1294,15 +1581,16 @@ const Pass* SceneManager::_setPass(const Pass* pass, bool evenIfSuppressed,
         {
             mPassCullingMode = pass->getCullingMode();
         }
-        mDestRenderSystem->_setCullingMode(mPassCullingMode);
+        mRenderStateCache.setCullingMode(mPassCullingMode);
         
         // Shading
-        mDestRenderSystem->setShadingType(pass->getShadingMode());
+        mRenderStateCache.setShadingType(pass->getShadingMode());
         // Polygon mode
-        mDestRenderSystem->_setPolygonMode(pass->getPolygonMode());
+        mRenderStateCache.setPolygonMode(pass->getPolygonMode());
 
         // set pass number
         mAutoParamDataSource->setPassNumber( pass->getIndex() );
+        mAutoParamDataSource->updateSharedBlock(AutoParamDataSource::SB_PASS);
 
         // mark global params as dirty
         mGpuParamsDirty |= (uint16)GPV_GLOBAL;
@@ -1384,6 +1672,13 @@ void SceneManager::_renderScene(Camera* camera, Viewport* vp, bool includeOverla
     mActiveQueuedRenderableVisitor->targetSceneMgr = this;
     mAutoParamDataSource->setCurrentSceneManager(this);
 
+    // Count the render state changes of each frame
+    if (mRenderStateFrameNumber != Root::getSingleton().getNextFrameNumber())
+    {
+        mRenderStateFrameNumber = Root::getSingleton().getNextFrameNumber();
+        mRenderStateCache.resetStatistics();
+    }
+
     // Also set the internal viewport pointer at this point, for calls that need it
     // However don't call setViewport just yet (see below)
     mCurrentViewport = vp;
@@ -1427,6 +1722,10 @@ void SceneManager::_renderScene(Camera* camera, Viewport* vp, bool includeOverla
         // Update animations
         _applySceneAnimations();
         updateDirtyInstanceManagers();
+        if (mSkeletonAnimationBatch)
+            updateSkeletalAnimations();
+        if (mSoftwareSkinningBatch)
+            updateSoftwareAnimations();
         mLastFrameNumber = thisFrameNumber;
     }
 
@@ -1507,6 +1806,7 @@ void SceneManager::_renderScene(Camera* camera, Viewport* vp, bool includeOverla
 
         // Tell params about render target
         mAutoParamDataSource->setCurrentRenderTarget(vp->getTarget());
+        mAutoParamDataSource->updateSharedBlock(AutoParamDataSource::SB_FRAME);
 
 
         // Set camera window clipping planes (if any)
@@ -1566,9 +1866,11 @@ void SceneManager::_renderScene(Camera* camera, Viewport* vp, bool includeOverla
     }        
     // Begin the frame
     mDestRenderSystem->_beginFrame();
+    // Other scene managers, or anything else, may have changed states since
+    mRenderStateCache.invalidate();
 
     // Set rasterisation mode
-    mDestRenderSystem->_setPolygonMode(camera->getPolygonMode());
+    mRenderStateCache.setPolygonMode(camera->getPolygonMode());
 
     // Set initial camera state
     mDestRenderSystem->_setProjectionMatrix(mCameraInProgress->getProjectionMatrixRS());
@@ -1606,6 +1908,7 @@ void SceneManager::_renderScene(Camera* camera, Viewport* vp, bool includeOverla
 void SceneManager::_setDestinationRenderSystem(RenderSystem* sys)
 {
     mDestRenderSystem = sys;
+    mRenderStateCache.setRenderSystem(sys);
 
     if(sys)
     {
@@ -2306,20 +2609,383 @@ void SceneManager::_updateSceneGraph(Camera* cam)
     // In this implementation, just update from the root
     // Smarter SceneManager subclasses may choose to update only
     //   certain scene graph branches
-    getRootSceneNode()->_update(true, false);
+#if !OGRE_NODE_INHERIT_TRANSFORM
+    if (mParallelTransformUpdate)
+        updateSceneGraphParallel();
+    else
+#endif
+        getRootSceneNode()->_update(true, false);
 
     firePostUpdateSceneGraph(cam);
 }
 //-----------------------------------------------------------------------
+void SceneManager::updateSceneGraphParallel(void)
+{
+    // Below this many nodes per thread waking the workers costs more than it saves
+    static const size_t MIN_NODES_PER_THREAD = 64;
+
+    Node::UpdateLevelList::iterator lit, litend;
+    litend = mUpdateLevels.end();
+    for (lit = mUpdateLevels.begin(); lit != litend; ++lit)
+    {
+        lit->clear();
+    }
+
+    getRootSceneNode()->_collectUpdates(mUpdateLevels, 0, Node::NO_PARENT_SLOT, false);
+
+    // Top down, each level only reads the one above it
+    const size_t numLevels = mUpdateLevels.size();
+    for (size_t depth = 0; depth < numLevels; ++depth)
+    {
+        Node::UpdateLevel& level = mUpdateLevels[depth];
+        const size_t count = level.nodes.size();
+        if (count == 0)
+            continue;
+
+        level.derivedPositions.resize(count);
+        level.derivedOrientations.resize(count);
+        level.derivedScales.resize(count);
+
+        if (count < (mNumWorkerThreads + 1) * MIN_NODES_PER_THREAD)
+        {
+            Node::_updateLevelTransforms(mUpdateLevels, depth, 0, count);
+        }
+        else
+        {
+            mUpdateLevelIndex = depth;
+            mWorkerRequest = WR_UPDATE_TRANSFORMS;
+            fireWorkerThreadsAndWait();
+        }
+    }
+
+    // Bottom up, so children bounds are final before their parents merge them
+    for (size_t depth = numLevels; depth-- > 0; )
+    {
+        const Node::UpdateLevel& level = mUpdateLevels[depth];
+
+        vector<Node*>::type::const_iterator it, itend;
+        itend = level.nodes.end();
+        for (it = level.nodes.begin(); it != itend; ++it)
+        {
+            (*it)->_notifyDerivedUpdated();
+        }
+
+        itend = level.visited.end();
+        for (it = level.visited.begin(); it != itend; ++it)
+        {
+            static_cast<SceneNode*>(*it)->_updateBounds();
+        }
+    }
+}
+//-----------------------------------------------------------------------
+unsigned long updateWorkerThread(ThreadHandle* threadHandle)
+{
+    SceneManager* sceneManager = reinterpret_cast<SceneManager*>(threadHandle->getUserParam());
+    return sceneManager->_updateWorkerThread(threadHandle);
+}
+THREAD_DECLARE(updateWorkerThread);
+//-----------------------------------------------------------------------
+void SceneManager::setNumWorkerThreads(size_t numThreads)
+{
+    if (numThreads == mNumWorkerThreads)
+        return;
+
+    stopWorkerThreads();
+    mNumWorkerThreads = numThreads;
+    startWorkerThreads();
+}
+//-----------------------------------------------------------------------
+void SceneManager::startWorkerThreads(void)
+{
+    if (mNumWorkerThreads == 0)
+        return;
+
+    mWorkerThreadsBarrier = new Barrier(mNumWorkerThreads + 1);
+    mWorkerThreads.reserve(mNumWorkerThreads);
+    for (size_t i = 0; i < mNumWorkerThreads; ++i)
+    {
+        mWorkerThreads.push_back(Threads::CreateThread(THREAD_GET(updateWorkerThread), i, this));
+    }
+}
+//-----------------------------------------------------------------------
+void SceneManager::stopWorkerThreads(void)
+{
+    if (mWorkerThreads.empty())
+        return;
+
+    // Release the threads waiting for work, they will see the flag and return
+    mExitWorkerThreads = true;
+    mWorkerThreadsBarrier->sync();
+    Threads::WaitForThreads(mWorkerThreads);
+    mWorkerThreads.clear();
+
+    delete mWorkerThreadsBarrier;
+    mWorkerThreadsBarrier = 0;
+    mExitWorkerThreads = false;
+}
+//-----------------------------------------------------------------------
+void SceneManager::fireWorkerThreadsAndWait(void)
+{
+    if (mWorkerThreads.empty())
+    {
+        processWorkerRequest(0, 1);
+        return;
+    }
+
+    mWorkerThreadsBarrier->sync(); // Fire threads
+    mWorkerThreadsBarrier->sync(); // Wait for them to complete
+}
+//-----------------------------------------------------------------------
+unsigned long SceneManager::_updateWorkerThread(ThreadHandle* threadHandle)
+{
+    const size_t threadIdx = threadHandle->getThreadIdx();
+    for (;;)
+    {
+        // Only look at the flag once released, stopWorkerThreads may set it at any time
+        // before that and still expects every thread on the barrier
+        mWorkerThreadsBarrier->sync();
+        if (mExitWorkerThreads)
+            break;
+        processWorkerRequest(threadIdx, mNumWorkerThreads);
+        mWorkerThreadsBarrier->sync();
+    }
+
+    return 0;
+}
+//-----------------------------------------------------------------------
+void SceneManager::processWorkerRequest(size_t threadIdx, size_t numThreads)
+{
+    switch (mWorkerRequest)
+    {
+    case WR_UPDATE_TRANSFORMS:
+        {
+            const size_t count = mUpdateLevels[mUpdateLevelIndex].nodes.size();
+            const size_t perThread = (count + numThreads - 1) / numThreads;
+            const size_t begin = std::min(count, threadIdx * perThread);
+            const size_t end = std::min(count, begin + perThread);
+            Node::_updateLevelTransforms(mUpdateLevels, mUpdateLevelIndex, begin, end);
+        }
+        break;
+    case WR_CULL_NODES:
+        {
+            const size_t count = mCullNodes.size();
+            const size_t perThread = (count + numThreads - 1) / numThreads;
+            const size_t begin = std::min(count, threadIdx * perThread);
+            const size_t end = std::min(count, begin + perThread);
+            cullNodes(begin, end);
+        }
+        break;
+    }
+}
+//-----------------------------------------------------------------------
+namespace
+{
+    /// Forgets the proxies of all the objects of a query tree
+    struct ResetQueryProxies
+    {
+        const DynamicAABBTree* tree;
+        bool operator()(int proxy)
+        {
+            static_cast<MovableObject*>(tree->getUserData(proxy))->_setQueryProxy(
+                DynamicAABBTree::NULL_PROXY);
+            return true;
+        }
+    };
+}
+//-----------------------------------------------------------------------
+void SceneManager::setSceneQueryAcceleration(bool enabled)
+{
+    if (enabled == (mQueryTree != 0))
+        return;
+
+    if (!enabled)
+    {
+        ResetQueryProxies reset = { mQueryTree };
+        mQueryTree->query(AxisAlignedBox::BOX_INFINITE, reset);
+        OGRE_DELETE mQueryTree;
+        mQueryTree = 0;
+        return;
+    }
+
+    mQueryTree = OGRE_NEW DynamicAABBTree();
+
+    // Insert what is already attached, later changes come through _updateBounds
+    if (mSceneRoot)
+        mSceneRoot->_updateBounds();
+    for (SceneNodeList::iterator i = mSceneNodes.begin(); i != mSceneNodes.end(); ++i)
+    {
+        i->second->_updateBounds();
+    }
+
+    // Objects attached to bones are not updated by the scene graph, they are always tested
+    OGRE_LOCK_MUTEX(mMovableObjectCollectionMapMutex);
+    for (MovableObjectCollectionMap::iterator ci = mMovableObjectCollectionMap.begin();
+        ci != mMovableObjectCollectionMap.end(); ++ci)
+    {
+        MovableObjectCollection* coll = ci->second;
+        OGRE_LOCK_MUTEX(coll->mutex);
+        for (MovableObjectMap::iterator i = coll->map.begin(); i != coll->map.end(); ++i)
+        {
+            if (i->second->isParentTagPoint())
+                _updateQueryProxy(i->second, AxisAlignedBox::BOX_INFINITE);
+        }
+    }
+}
+//-----------------------------------------------------------------------
+void SceneManager::_updateQueryProxy(MovableObject* obj, const AxisAlignedBox& worldBox)
+{
+    int proxy = obj->_getQueryProxy();
+    if (worldBox.isNull())
+    {
+        // Null boxes never intersect anything
+        if (proxy != DynamicAABBTree::NULL_PROXY)
+            _removeQueryProxy(obj);
+    }
+    else if (proxy == DynamicAABBTree::NULL_PROXY)
+    {
+        obj->_setQueryProxy(mQueryTree->createProxy(worldBox, obj));
+    }
+    else
+    {
+        mQueryTree->moveProxy(proxy, worldBox);
+    }
+}
+//-----------------------------------------------------------------------
+void SceneManager::_removeQueryProxy(MovableObject* obj)
+{
+    if (mQueryTree && obj->_getQueryProxy() != DynamicAABBTree::NULL_PROXY)
+        mQueryTree->destroyProxy(obj->_getQueryProxy());
+    obj->_setQueryProxy(DynamicAABBTree::NULL_PROXY);
+}
+//-----------------------------------------------------------------------
 void SceneManager::_findVisibleObjects(
     Camera* cam, VisibleObjectsBoundsInfo* visibleBounds, bool onlyShadowCasters)
 {
+    if (mParallelCulling)
+    {
+        findVisibleObjectsParallel(cam, visibleBounds, onlyShadowCasters);
+        return;
+    }
+
     // Tell nodes to find, cascade down all nodes
     getRootSceneNode()->_findVisibleObjects(cam, getRenderQueue(), visibleBounds, true, 
         mDisplayNodes, onlyShadowCasters);
 
 }
 //-----------------------------------------------------------------------
+void SceneManager::buildCullNodes(SceneNode* node)
+{
+    const size_t index = mCullNodes.size();
+    mCullNodes.push_back(node);
+    mCullSubtreeEnds.push_back(0);
+
+    SceneNode::ChildNodeIterator it = node->getChildIterator();
+    while (it.hasMoreElements())
+    {
+        buildCullNodes(static_cast<SceneNode*>(it.getNext()));
+    }
+    mCullSubtreeEnds[index] = mCullNodes.size();
+}
+//-----------------------------------------------------------------------
+void SceneManager::cullNodes(size_t begin, size_t end)
+{
+    if (begin >= end)
+        return;
+
+    const Real infinity = std::numeric_limits<Real>::infinity();
+    for (size_t i = begin; i < end; ++i)
+    {
+        const AxisAlignedBox& box = mCullNodes[i]->_getWorldAABB();
+        if (box.isFinite())
+        {
+            const Vector3 centre = box.getCenter();
+            const Vector3 halfSize = box.getHalfSize();
+            mCullCentres[i] = Vector4(centre.x, centre.y, centre.z, 0);
+            mCullHalfSizes[i] = Vector4(halfSize.x, halfSize.y, halfSize.z, 0);
+            mCullVisibilities[i] = 1;
+        }
+        else
+        {
+            // Null boxes are never visible, infinite ones always are
+            mCullCentres[i] = Vector4::ZERO;
+            mCullHalfSizes[i] = Vector4(infinity, infinity, infinity, 0);
+            mCullVisibilities[i] = box.isInfinite();
+        }
+    }
+
+    OptimisedUtil::getImplementation()->cullBoxes(mCullPlanes, mNumCullPlanes,
+        &mCullCentres[begin], &mCullHalfSizes[begin], &mCullVisibilities[begin], end - begin);
+}
+//-----------------------------------------------------------------------
+void SceneManager::findVisibleObjectsParallel(
+    Camera* cam, VisibleObjectsBoundsInfo* visibleBounds, bool onlyShadowCasters)
+{
+    // Below this, the cost of waking up the threads isn't worth it
+    const size_t MIN_NODES_PER_THREAD = 256;
+
+    if (mCullNodesDirty)
+    {
+        mCullNodes.clear();
+        mCullSubtreeEnds.clear();
+        buildCullNodes(getRootSceneNode());
+        mCullCentres.resize(mCullNodes.size());
+        mCullHalfSizes.resize(mCullNodes.size());
+        mCullVisibilities.resize(mCullNodes.size());
+        mCullNodesDirty = false;
+    }
+
+    // Same planes as Camera::isVisible
+    const Frustum* frustum = cam->getCullingFrustum() ?
+        cam->getCullingFrustum() : static_cast<const Frustum*>(cam);
+    const Plane* planes = frustum->getFrustumPlanes();
+    mNumCullPlanes = 0;
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        // Skip far plane if infinite view frustum
+        if (plane == FRUSTUM_PLANE_FAR && frustum->getFarClipDistance() == 0)
+            continue;
+        const Vector3& normal = planes[plane].normal;
+        mCullPlanes[mNumCullPlanes++] = Vector4(normal.x, normal.y, normal.z, planes[plane].d);
+    }
+
+    const size_t count = mCullNodes.size();
+    if (count < MIN_NODES_PER_THREAD * 2)
+    {
+        cullNodes(0, count);
+    }
+    else
+    {
+        mWorkerRequest = WR_CULL_NODES;
+        fireWorkerThreadsAndWait();
+    }
+
+    // Add the visible nodes in depth first order, skipping the subtrees of the culled
+    // ones. The debug renderables of a node are added once its subtree is done, as
+    // SceneNode::_findVisibleObjects does.
+    RenderQueue* queue = getRenderQueue();
+    mCullOpenNodes.clear();
+    size_t i = 0;
+    while (i < count || !mCullOpenNodes.empty())
+    {
+        if (!mCullOpenNodes.empty() && (i == count || mCullSubtreeEnds[mCullOpenNodes.back()] <= i))
+        {
+            mCullNodes[mCullOpenNodes.back()]->_addDebugRenderables(queue, mDisplayNodes);
+            mCullOpenNodes.pop_back();
+            continue;
+        }
+
+        if (!mCullVisibilities[i])
+        {
+            i = mCullSubtreeEnds[i];
+            continue;
+        }
+
+        mCullNodes[i]->_addVisibleObjects(cam, queue, visibleBounds, onlyShadowCasters);
+        mCullOpenNodes.push_back(i);
+        ++i;
+    }
+}
+//-----------------------------------------------------------------------
 void SceneManager::_renderVisibleObjects(void)
 {
     RenderQueueInvocationSequence* invocationSequence = 
@@ -2504,7 +3170,7 @@ void SceneManager::renderAdditiveStencilShadowedQueueGroupObjects(
             // Reset stencil params
             mDestRenderSystem->setStencilBufferParams();
             mDestRenderSystem->setStencilCheckEnabled(false);
-            mDestRenderSystem->_setDepthBufferParams();
+            mRenderStateCache.setDepthBufferParams();
 
             if (scissored == CLIPPED_SOME)
                 resetScissor();
@@ -2588,7 +3254,7 @@ void SceneManager::renderModulativeStencilShadowedQueueGroupObjects(
             // Reset stencil params
             mDestRenderSystem->setStencilBufferParams();
             mDestRenderSystem->setStencilCheckEnabled(false);
-            mDestRenderSystem->_setDepthBufferParams();
+            mRenderStateCache.setDepthBufferParams();
         }
 
     }// for each light
@@ -3266,7 +3932,7 @@ void SceneManager::renderSingleObject(Renderable* rend, const Pass* pass,
             TextureUnitState* pTex = *it;
             if (pTex->hasViewRelativeTextureCoordinateGeneration())
             {
-                mDestRenderSystem->_setTextureUnitSettings(unit, *pTex);
+                mRenderStateCache.setTextureUnitSettings(unit, *pTex);
             }
             ++unit;
         }
@@ -3304,7 +3970,7 @@ void SceneManager::renderSingleObject(Renderable* rend, const Pass* pass,
             // this also copes with returning from negative scale in previous render op
             // for same pass
             if (cullMode != mDestRenderSystem->_getCullingMode())
-                mDestRenderSystem->_setCullingMode(cullMode);
+                mRenderStateCache.setCullingMode(cullMode);
         }
 
         // Set up the solid / wireframe override
@@ -3321,7 +3987,7 @@ void SceneManager::renderSingleObject(Renderable* rend, const Pass* pass,
                 reqMode = camPolyMode;
             }
         }
-        mDestRenderSystem->_setPolygonMode(reqMode);
+        mRenderStateCache.setPolygonMode(reqMode);
 
         if (doLightIteration)
         {
@@ -3418,7 +4084,7 @@ void SceneManager::renderSingleObject(Renderable* rend, const Pass* pass,
                                 ++shadowTexIndex;
                                 // Have to set TU on rendersystem right now, although
                                 // autoparams will be set later
-                                mDestRenderSystem->_setTextureUnitSettings(tuindex, *tu);
+                                mRenderStateCache.setTextureUnitSettings(tuindex, *tu);
                             }
                         }
 
@@ -3536,12 +4202,14 @@ void SceneManager::renderSingleObject(Renderable* rend, const Pass* pass,
                     // because of Pass state grouping. So set it always
 
                     // Set modified depth bias right away
-                    mDestRenderSystem->_setDepthBias(depthBiasBase, pass->getDepthBiasSlopeScale());
+                    mRenderStateCache.setDepthBias(depthBiasBase, pass->getDepthBiasSlopeScale());
 
                     // Set to increment internally too if rendersystem iterates
                     mDestRenderSystem->setDeriveDepthBias(true, 
                         depthBiasBase, pass->getIterationDepthBias(), 
                         pass->getDepthBiasSlopeScale());
+                    // which leaves the bias of the last iteration set
+                    mRenderStateCache.invalidateDepthBias();
                 }
                 else
                 {
@@ -3874,6 +4542,93 @@ void SceneManager::_applySceneAnimations(void)
     }
 }
 //---------------------------------------------------------------------
+void SceneManager::setSkeletalAnimationBatching(bool enabled)
+{
+    if (enabled && !mSkeletonAnimationBatch)
+    {
+        mSkeletonAnimationBatch = OGRE_NEW SkeletonAnimationBatch();
+    }
+    else if (!enabled)
+    {
+        OGRE_DELETE mSkeletonAnimationBatch;
+        mSkeletonAnimationBatch = 0;
+    }
+}
+//---------------------------------------------------------------------
+void SceneManager::setSharedAutoParamBlocks(bool enabled)
+{
+    mAutoParamDataSource->setSharedBlocksEnabled(enabled);
+}
+//---------------------------------------------------------------------
+bool SceneManager::getSharedAutoParamBlocks(void) const
+{
+    return mAutoParamDataSource->getSharedBlocksEnabled();
+}
+//---------------------------------------------------------------------
+void SceneManager::updateSkeletalAnimations(void)
+{
+    OgreProfileGroup("updateSkeletalAnimations", OGREPROF_GENERAL);
+
+    mAnimatedEntities.clear();
+    {
+        MovableObjectCollection* objects = getMovableObjectCollection(EntityFactory::FACTORY_TYPE_NAME);
+        OGRE_LOCK_MUTEX(objects->mutex);
+        for (MovableObjectMap::iterator i = objects->map.begin(); i != objects->map.end(); ++i)
+        {
+            // Collected before culling, so only those rendered last frame. The skeleton
+            // of an entity showing a manual LOD is not used unless it is always updated.
+            Entity* entity = static_cast<Entity*>(i->second);
+            if (entity->hasSkeleton() && entity->isInScene() && entity->getVisible() &&
+                entity->_isRecentlyQueued() &&
+                (!entity->_isManualLodDisplayed() || entity->getAlwaysUpdateMainSkeleton()))
+            {
+                mAnimatedEntities.push_back(entity);
+            }
+        }
+    }
+
+    if (!mAnimatedEntities.empty())
+        mSkeletonAnimationBatch->update(&mAnimatedEntities[0], mAnimatedEntities.size());
+}
+//---------------------------------------------------------------------
+void SceneManager::setSoftwareSkinningBatching(bool enabled)
+{
+    if (enabled && !mSoftwareSkinningBatch)
+    {
+        mSoftwareSkinningBatch = OGRE_NEW SoftwareSkinningBatch();
+    }
+    else if (!enabled)
+    {
+        OGRE_DELETE mSoftwareSkinningBatch;
+        mSoftwareSkinningBatch = 0;
+    }
+}
+//---------------------------------------------------------------------
+void SceneManager::updateSoftwareAnimations(void)
+{
+    OgreProfileGroup("updateSoftwareAnimations", OGREPROF_GENERAL);
+
+    mAnimatedEntities.clear();
+    {
+        MovableObjectCollection* objects = getMovableObjectCollection(EntityFactory::FACTORY_TYPE_NAME);
+        OGRE_LOCK_MUTEX(objects->mutex);
+        for (MovableObjectMap::iterator i = objects->map.begin(); i != objects->map.end(); ++i)
+        {
+            // Like updateSkeletalAnimations, but a manual LOD entity is animated instead
+            Entity* entity = static_cast<Entity*>(i->second);
+            if ((entity->hasSkeleton() || entity->hasVertexAnimation()) &&
+                entity->isInScene() && entity->getVisible() &&
+                entity->_isRecentlyQueued() && !entity->_isManualLodDisplayed())
+            {
+                mAnimatedEntities.push_back(entity);
+            }
+        }
+    }
+
+    if (!mAnimatedEntities.empty())
+        mSoftwareSkinningBatch->update(&mAnimatedEntities[0], mAnimatedEntities.size());
+}
+//---------------------------------------------------------------------
 void SceneManager::manualRender(RenderOperation* rend, 
                                 Pass* pass, Viewport* vp, const Matrix4& worldMatrix, 
                                 const Matrix4& viewMatrix, const Matrix4& projMatrix, 
@@ -3885,6 +4640,9 @@ void SceneManager::manualRender(RenderOperation* rend,
     if (doBeginEndFrame)
         mDestRenderSystem->_beginFrame();
 
+    // Called from anywhere, so the render states may have changed since the last pass
+    mRenderStateCache.invalidate();
+
     mDestRenderSystem->_setWorldMatrix(worldMatrix);
     setViewMatrix(viewMatrix);
     mDestRenderSystem->_setProjectionMatrix(projMatrix);
@@ -3905,6 +4663,7 @@ void SceneManager::manualRender(RenderOperation* rend,
         dummyCam.setCustomViewMatrix(true, viewMatrix);
         dummyCam.setCustomProjectionMatrix(true, projMatrix);
         mAutoParamDataSource->setCurrentCamera(&dummyCam, false);
+        mAutoParamDataSource->updateSharedBlock(AutoParamDataSource::SB_FRAME);
         updateGpuProgramParameters(pass);
     }
     mDestRenderSystem->_render(*rend);
@@ -3925,6 +4684,9 @@ void SceneManager::manualRender(Renderable* rend, const Pass* pass, Viewport* vp
     if (doBeginEndFrame)
         mDestRenderSystem->_beginFrame();
 
+    // Called from anywhere, so the render states may have changed since the last pass
+    mRenderStateCache.invalidate();
+
     setViewMatrix(viewMatrix);
     mDestRenderSystem->_setProjectionMatrix(projMatrix);
 
@@ -3945,9 +4707,11 @@ void SceneManager::manualRender(Renderable* rend, const Pass* pass, Viewport* vp
 
 		mAutoParamDataSource->setCurrentSceneManager(this);
         mAutoParamDataSource->setCurrentCamera(&dummyCam, false);
+        mAutoParamDataSource->updateSharedBlock(AutoParamDataSource::SB_FRAME);
         updateGpuProgramParameters(pass);
 
 		mAutoParamDataSource->setCurrentCamera(oldCam, false);
+        mAutoParamDataSource->updateSharedBlock(AutoParamDataSource::SB_FRAME);
     }
     if (vp)
         mCurrentViewport = vp;
@@ -4141,6 +4905,9 @@ bool SceneManager::fireRenderQueueStarted(uint8 id, const String& invocation)
     {
         (*i)->renderQueueStarted(id, invocation, skip);
     }
+    // Listeners may render or change states on the render system directly
+    if (!mRenderQueueListeners.empty())
+        mRenderStateCache.invalidate();
     return skip;
 }
 //---------------------------------------------------------------------
@@ -4154,6 +4921,8 @@ bool SceneManager::fireRenderQueueEnded(uint8 id, const String& invocation)
     {
         (*i)->renderQueueEnded(id, invocation, repeat);
     }
+    if (!mRenderQueueListeners.empty())
+        mRenderStateCache.invalidate();
     return repeat;
 }
 //---------------------------------------------------------------------
@@ -4168,6 +4937,8 @@ void SceneManager::fireRenderSingleObject(Renderable* rend, const Pass* pass,
     {
         (*i)->notifyRenderSingleObject(rend, pass, source, pLightList, suppressRenderStateChanges);
     }
+    if (!mRenderObjectListeners.empty())
+        mRenderStateCache.invalidate();
 }
 //---------------------------------------------------------------------
 void SceneManager::fireShadowTexturesUpdated(size_t numberOfShadowTextures)
@@ -4554,6 +5325,8 @@ void SceneManager::findLightsAffectingFrustum(const Camera* camera)
         // Use swap instead of copy operator for efficiently
         mCachedLightInfos.swap(mTestLightInfos);
 
+        buildLightGrid();
+
         // notify light dirty, so all movable objects will re-populate
         // their light list next time
         _notifyLightsDirty();
@@ -5579,7 +6352,7 @@ void SceneManager::renderShadowVolumesToStencil(const Light* light,
             return; // nothing to do
     }
 
-    mDestRenderSystem->unbindGpuProgram(GPT_FRAGMENT_PROGRAM);
+    mRenderStateCache.unbindGpuProgram(GPT_FRAGMENT_PROGRAM);
 
     // Can we do a 2-sided stencil?
     bool stencil2sided = false;
@@ -5640,20 +6413,20 @@ void SceneManager::renderShadowVolumesToStencil(const Light* light,
     }
     else
     {
-        mDestRenderSystem->unbindGpuProgram(GPT_VERTEX_PROGRAM);
+        mRenderStateCache.unbindGpuProgram(GPT_VERTEX_PROGRAM);
     }
     if (mDestRenderSystem->getCapabilities()->hasCapability(RSC_GEOMETRY_PROGRAM))
     {
-        mDestRenderSystem->unbindGpuProgram(GPT_GEOMETRY_PROGRAM);
+        mRenderStateCache.unbindGpuProgram(GPT_GEOMETRY_PROGRAM);
     }
 
-    mDestRenderSystem->_setAlphaRejectSettings(mShadowStencilPass->getAlphaRejectFunction(),
+    mRenderStateCache.setAlphaRejectSettings(mShadowStencilPass->getAlphaRejectFunction(),
         mShadowStencilPass->getAlphaRejectValue(), mShadowStencilPass->isAlphaToCoverageEnabled());
 
     // Turn off colour writing and depth writing
-    mDestRenderSystem->_setColourBufferWriteEnabled(false, false, false, false);
-    mDestRenderSystem->_disableTextureUnitsFrom(0);
-    mDestRenderSystem->_setDepthBufferParams(true, false, CMPF_LESS);
+    mRenderStateCache.setColourBufferWriteEnabled(false, false, false, false);
+    mRenderStateCache.disableTextureUnitsFrom(0);
+    mRenderStateCache.setDepthBufferParams(true, false, CMPF_LESS);
     mDestRenderSystem->setStencilCheckEnabled(true);
 
     // Calculate extrusion distance
@@ -5766,19 +6539,19 @@ void SceneManager::renderShadowVolumesToStencil(const Light* light,
             _setPass(mShadowDebugPass);
             renderShadowVolumeObjects(iShadowRenderables, mShadowDebugPass, &lightList, flags,
                 true, false, false);
-            mDestRenderSystem->_setColourBufferWriteEnabled(false, false, false, false);
-            mDestRenderSystem->_setDepthBufferFunction(CMPF_LESS);
+            mRenderStateCache.setColourBufferWriteEnabled(false, false, false, false);
+            mRenderStateCache.setDepthBufferFunction(CMPF_LESS);
         }
     }
 
     // revert colour write state
-    mDestRenderSystem->_setColourBufferWriteEnabled(true, true, true, true);
+    mRenderStateCache.setColourBufferWriteEnabled(true, true, true, true);
     // revert depth state
-    mDestRenderSystem->_setDepthBufferParams();
+    mRenderStateCache.setDepthBufferParams();
 
     mDestRenderSystem->setStencilCheckEnabled(false);
 
-    mDestRenderSystem->unbindGpuProgram(GPT_VERTEX_PROGRAM);
+    mRenderStateCache.unbindGpuProgram(GPT_VERTEX_PROGRAM);
 
     if (scissored == CLIPPED_SOME)
     {
@@ -5834,22 +6607,22 @@ void SceneManager::renderShadowVolumeObjects(ShadowCaster::ShadowRenderableListI
                 if (twosided)
                 {
                     // select back facing light caps to render
-                    mDestRenderSystem->_setCullingMode(CULL_ANTICLOCKWISE);
+                    mRenderStateCache.setCullingMode(CULL_ANTICLOCKWISE);
                     mPassCullingMode = CULL_ANTICLOCKWISE;
                     // use normal depth function for back facing light caps
                     renderSingleObject(lightCap, pass, false, false, manualLightList);
 
                     // select front facing light caps to render
-                    mDestRenderSystem->_setCullingMode(CULL_CLOCKWISE);
+                    mRenderStateCache.setCullingMode(CULL_CLOCKWISE);
                     mPassCullingMode = CULL_CLOCKWISE;
                     // must always fail depth check for front facing light caps
-                    mDestRenderSystem->_setDepthBufferFunction(CMPF_ALWAYS_FAIL);
+                    mRenderStateCache.setDepthBufferFunction(CMPF_ALWAYS_FAIL);
                     renderSingleObject(lightCap, pass, false, false, manualLightList);
 
                     // reset depth function
-                    mDestRenderSystem->_setDepthBufferFunction(CMPF_LESS);
+                    mRenderStateCache.setDepthBufferFunction(CMPF_LESS);
                     // reset culling mode
-                    mDestRenderSystem->_setCullingMode(CULL_NONE);
+                    mRenderStateCache.setCullingMode(CULL_NONE);
                     mPassCullingMode = CULL_NONE;
                 }
                 else if ((secondpass || zfail) && !(secondpass && zfail))
@@ -5860,11 +6633,11 @@ void SceneManager::renderShadowVolumeObjects(ShadowCaster::ShadowRenderableListI
                 else
                 {
                     // must always fail depth check for front facing light caps
-                    mDestRenderSystem->_setDepthBufferFunction(CMPF_ALWAYS_FAIL);
+                    mRenderStateCache.setDepthBufferFunction(CMPF_ALWAYS_FAIL);
                     renderSingleObject(lightCap, pass, false, false, manualLightList);
 
                     // reset depth function
-                    mDestRenderSystem->_setDepthBufferFunction(CMPF_LESS);
+                    mRenderStateCache.setDepthBufferFunction(CMPF_LESS);
                 }
             }
         }
@@ -5923,7 +6696,7 @@ void SceneManager::setShadowVolumeStencilState(bool secondpass, bool zfail, bool
             false
             );
     }
-    mDestRenderSystem->_setCullingMode(mPassCullingMode);
+    mRenderStateCache.setCullingMode(mPassCullingMode);
 
 }
 //---------------------------------------------------------------------
@@ -6532,6 +7305,7 @@ void SceneManager::_resumeRendering(SceneManager::RenderContext* context)
 
     // Tell params about render target
     mAutoParamDataSource->setCurrentRenderTarget(vp->getTarget());
+    mAutoParamDataSource->updateSharedBlock(AutoParamDataSource::SB_FRAME);
 
 
     // Set camera window clipping planes (if any)
@@ -6545,9 +7319,10 @@ void SceneManager::_resumeRendering(SceneManager::RenderContext* context)
     }
     mCameraInProgress = context->camera;
     mDestRenderSystem->_resumeFrame(context->rsContext);
+    mRenderStateCache.invalidate();
 
     // Set rasterisation mode
-    mDestRenderSystem->_setPolygonMode(mCameraInProgress->getPolygonMode());
+    mRenderStateCache.setPolygonMode(mCameraInProgress->getPolygonMode());
 
     // Set initial camera state
     mDestRenderSystem->_setProjectionMatrix(mCameraInProgress->getProjectionMatrixRS());
@@ -7342,7 +8117,7 @@ void SceneManager::bindGpuProgram(GpuProgram* prog)
     // Hash == 1 is almost impossible to achieve otherwise
     mLastLightHashGpuProgram = 1;
     mGpuParamsDirty = (uint16)GPV_ALL;
-    mDestRenderSystem->bindGpuProgram(prog);
+    mRenderStateCache.bindGpuProgram(prog);
 }
 //---------------------------------------------------------------------
 void SceneManager::_markGpuParamsDirty(uint16 mask)
@@ -88,6 +88,9 @@ namespace Ogre {
     {
         Node::setParent(parent);
 
+        if (mCreator)
+            mCreator->_notifySceneGraphChanged();
+
         if (parent)
         {
             SceneNode* sceneParent = static_cast<SceneNode*>(parent);
@@ -253,11 +256,15 @@ namespace Ogre {
         mWorldAABB.setNull();
 
         // Update bounds from own attached objects
+        const bool updateQueryTree = mCreator && mCreator->getSceneQueryAcceleration();
         ObjectMap::iterator i;
         for (i = mObjectsByName.begin(); i != mObjectsByName.end(); ++i)
         {
             // Merge world bounds of each object
-            mWorldAABB.merge(i->second->getWorldBoundingBox(true));
+            const AxisAlignedBox& objectBox = i->second->getWorldBoundingBox(true);
+            mWorldAABB.merge(objectBox);
+            if (updateQueryTree)
+                mCreator->_updateQueryProxy(i->second, objectBox);
         }
 
         // Merge with children
@@ -279,14 +286,7 @@ namespace Ogre {
             return;
 
         // Add all entities
-        ObjectMap::iterator iobj;
-        ObjectMap::iterator iobjend = mObjectsByName.end();
-        for (iobj = mObjectsByName.begin(); iobj != iobjend; ++iobj)
-        {
-            MovableObject* mo = iobj->second;
-
-            queue->processVisibleObject(mo, cam, onlyShadowCasters, visibleBounds);
-        }
+        _addVisibleObjects(cam, queue, visibleBounds, onlyShadowCasters);
 
         if (includeChildren)
         {
@@ -300,6 +300,24 @@ namespace Ogre {
             }
         }
 
+        _addDebugRenderables(queue, displayNodes);
+    }
+    //-----------------------------------------------------------------------
+    void SceneNode::_addVisibleObjects(Camera* cam, RenderQueue* queue,
+        VisibleObjectsBoundsInfo* visibleBounds, bool onlyShadowCasters)
+    {
+        ObjectMap::iterator iobj;
+        ObjectMap::iterator iobjend = mObjectsByName.end();
+        for (iobj = mObjectsByName.begin(); iobj != iobjend; ++iobj)
+        {
+            MovableObject* mo = iobj->second;
+
+            queue->processVisibleObject(mo, cam, onlyShadowCasters, visibleBounds);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneNode::_addDebugRenderables(RenderQueue* queue, bool displayNodes)
+    {
         if (displayNodes)
         {
             // Include self in the render queue
@@ -313,8 +331,6 @@ namespace Ogre {
         { 
             _addBoundingBoxToQueue(queue);
         }
-
-
     }
 
     Node::DebugRenderable* SceneNode::getDebugRenderable()
@@ -340,7 +356,11 @@ namespace Ogre {
     void SceneNode::updateFromParentImpl(void) const
     {
         Node::updateFromParentImpl();
-
+        derivedTransformUpdatedImpl();
+    }
+    //-----------------------------------------------------------------------
+    void SceneNode::derivedTransformUpdatedImpl(void) const
+    {
         // Notify objects that it has been moved
         ObjectMap::const_iterator i;
         for (i = mObjectsByName.begin(); i != mObjectsByName.end(); ++i)
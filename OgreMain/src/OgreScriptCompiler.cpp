@@ -274,18 +274,77 @@ namespace Ogre
         }
     }
 
+    const uint32 ScriptCompiler::SourceHash::MISSING;
+
+    ScriptCompiler::SourceHash ScriptCompiler::hashSource(const String &name, const String &str)
+    {
+        SourceHash hash;
+        hash.name = name;
+        hash.hash = FastHash(str.c_str(), static_cast<int>(str.size()));
+        hash.length = static_cast<uint32>(str.size());
+        return hash;
+    }
+
     ScriptCompiler::ScriptCompiler()
-        :mListener(0)
+        :mListener(0), mImportHashes(0), mArenaParsing(false)
     {
         initWordMap();
     }
 
     bool ScriptCompiler::compile(const String &str, const String &source, const String &group)
     {
+        if(mArenaParsing && !mListener)
+            return compile(parseToArena(str, source), group);
+
         ConcreteNodeListPtr nodes = ScriptParser::parse(ScriptLexer::tokenize(str, source));
         return compile(nodes, group);
     }
 
+    bool ScriptCompiler::_compileToBinary(const String &str, const String &source, const String &group,
+        String &binary, SourceHashList &imports)
+    {
+        if(mArenaParsing && !mListener)
+            return _compileToBinary(parseToArena(str, source), group, binary, imports);
+
+        ConcreteNodeListPtr nodes = ScriptParser::parse(ScriptLexer::tokenize(str, source));
+        return _compileToBinary(nodes, group, binary, imports);
+    }
+
+    bool ScriptCompiler::_compileToBinary(const ConcreteNodeListPtr &nodes, const String &group,
+        String &binary, SourceHashList &imports)
+    {
+        mImportHashes = &imports;
+        bool result = compileImpl(nodes, 0, group, &binary);
+        mImportHashes = 0;
+        return result;
+    }
+
+    bool ScriptCompiler::_compileToBinary(const ScriptNodeView *nodes, const String &group,
+        String &binary, SourceHashList &imports)
+    {
+        mImportHashes = &imports;
+        bool result = compileImpl(ConcreteNodeListPtr(), nodes, group, &binary);
+        mImportHashes = 0;
+        return result;
+    }
+
+    const ScriptNodeView *ScriptCompiler::parseToArena(const String &str, const String &source)
+    {
+        ScriptLexer::tokenize(str, mArena, mTokenViews);
+        return ScriptParser::parse(mTokenViews, source, mArena);
+    }
+
+    bool ScriptCompiler::_compileFromBinary(const String &binary, const String &group, bool &translated)
+    {
+        AbstractNodeListPtr ast = readBinaryAST(binary);
+        translated = false;
+        if(!ast)
+            return false;
+
+        translated = true;
+        return _compile(ast, group, false, false, false);
+    }
+
 //  static void logAST(int tabs, const AbstractNodePtr &node)
 //  {
 //      String msg = "";
@@ -339,6 +398,19 @@ namespace Ogre
 //  }
 
     bool ScriptCompiler::compile(const ConcreteNodeListPtr &nodes, const String &group)
+    {
+        mImportHashes = 0;
+        return compileImpl(nodes, 0, group, 0);
+    }
+
+    bool ScriptCompiler::compile(const ScriptNodeView *nodes, const String &group)
+    {
+        mImportHashes = 0;
+        return compileImpl(ConcreteNodeListPtr(), nodes, group, 0);
+    }
+
+    bool ScriptCompiler::compileImpl(const ConcreteNodeListPtr &nodes, const ScriptNodeView *viewNodes,
+        const String &group, String *binary)
     {
         // Set up the compilation context
         mGroup = group;
@@ -349,13 +421,22 @@ namespace Ogre
         // Clear the environment
         mEnv.clear();
 
-        if(mListener)
-            mListener->preConversion(this, nodes);
-
         // Convert our nodes to an AST
-        AbstractNodeListPtr ast = convertToAST(nodes);
+        AbstractNodeListPtr ast;
+        if(nodes)
+        {
+            if(mListener)
+                mListener->preConversion(this, nodes);
+            ast = convertToAST(nodes);
+        }
+        else
+        {
+            ast = convertToAST(viewNodes);
+        }
         // Processes the imports for this script
         processImports(ast);
+        // All the trees parsed into the arena have been converted by now
+        mArena.clear();
         // Process object inheritance
         processObjects(ast.get(), ast);
         // Process variable expansion
@@ -364,6 +445,9 @@ namespace Ogre
         // Allows early bail-out through the listener
         if(mListener && !mListener->postConversion(this, ast))
             return mErrors.empty();
+
+        if(binary)
+            writeBinaryAST(*ast, *binary);
         
         // Translate the nodes
         for(AbstractNodeList::iterator i = ast->begin(); i != ast->end(); ++i)
@@ -483,6 +567,16 @@ namespace Ogre
         return mGroup;
     }
 
+    void ScriptCompiler::setArenaParsing(bool val)
+    {
+        mArenaParsing = val;
+    }
+
+    bool ScriptCompiler::getArenaParsing() const
+    {
+        return mArenaParsing;
+    }
+
     bool ScriptCompiler::_fireEvent(ScriptCompilerEvent *evt, void *retval)
     {
         if(mListener)
@@ -497,6 +591,13 @@ namespace Ogre
         return builder.getResult();
     }
 
+    AbstractNodeListPtr ScriptCompiler::convertToAST(const ScriptNodeView *nodes)
+    {
+        AbstractTreeBuilder builder(this);
+        AbstractTreeBuilder::visit(&builder, nodes);
+        return builder.getResult();
+    }
+
     void ScriptCompiler::processImports(Ogre::AbstractNodeListPtr &nodes)
     {
         // We only need to iterate over the top-level of nodes
@@ -594,10 +695,24 @@ namespace Ogre
             }
             catch (FileNotFoundException&)
             {
+                // The script changes if the import shows up later
+                if(mImportHashes)
+                {
+                    SourceHash missing = hashSource(name, BLANKSTRING);
+                    missing.length = SourceHash::MISSING;
+                    mImportHashes->push_back(missing);
+                }
                 return retval;
             }
 
-            nodes = ScriptParser::parse(ScriptLexer::tokenize(stream->getAsString(), name));
+            String str = stream->getAsString();
+            // Compiling to binary records what the tree depends on
+            if(mImportHashes)
+                mImportHashes->push_back(hashSource(name, str));
+            // The tree is converted right away, so the arena can hold it alongside the importing script's
+            if(mArenaParsing)
+                return convertToAST(parseToArena(str, name));
+            nodes = ScriptParser::parse(ScriptLexer::tokenize(str, name));
         }
 
         if(nodes)
@@ -1298,7 +1413,334 @@ namespace Ogre
 		return mLargestRegisteredWordId;
     }
 
+    namespace
+    {
+        /** Writes abstract syntax trees to binary. Node lists end with an ANT_UNKNOWN type,
+            and each file name is written once, where it is first used.
+        */
+        class BinaryASTWriter
+        {
+        private:
+            String &mOut;
+            map<String,uint32>::type mFiles;
+        public:
+            BinaryASTWriter(String &out)
+                :mOut(out)
+            {
+            }
+
+            template<typename T> void write(const T &val)
+            {
+                mOut.append(reinterpret_cast<const char*>(&val), sizeof(T));
+            }
+
+            void writeString(const String &str)
+            {
+                write(static_cast<uint32>(str.size()));
+                mOut.append(str);
+            }
+
+            void writeNodes(const AbstractNodeList &nodes)
+            {
+                for(AbstractNodeList::const_iterator i = nodes.begin(); i != nodes.end(); ++i)
+                    writeNode(**i);
+                write(static_cast<uint8>(ANT_UNKNOWN));
+            }
+
+            void writeNode(const AbstractNode &node)
+            {
+                switch(node.type)
+                {
+                case ANT_ATOM:
+                case ANT_OBJECT:
+                case ANT_PROPERTY:
+                case ANT_IMPORT:
+                case ANT_VARIABLE_ACCESS:
+                    break;
+                default:
+                    return;
+                }
+
+                write(static_cast<uint8>(node.type));
+                map<String,uint32>::type::iterator file = mFiles.find(node.file);
+                if(file != mFiles.end())
+                {
+                    write(file->second);
+                }
+                else
+                {
+                    uint32 index = static_cast<uint32>(mFiles.size());
+                    mFiles.insert(std::make_pair(node.file, index));
+                    write(index);
+                    writeString(node.file);
+                }
+                write(static_cast<uint32>(node.line));
+
+                switch(node.type)
+                {
+                case ANT_ATOM:
+                    writeString(static_cast<const AtomAbstractNode&>(node).value);
+                    break;
+                case ANT_OBJECT:
+                    {
+                        const ObjectAbstractNode &obj = static_cast<const ObjectAbstractNode&>(node);
+                        writeString(obj.name);
+                        writeString(obj.cls);
+                        write(static_cast<uint32>(obj.bases.size()));
+                        for(vector<String>::type::const_iterator i = obj.bases.begin(); i != obj.bases.end(); ++i)
+                            writeString(*i);
+                        write(static_cast<uint8>(obj.abstract));
+                        const map<String,String>::type &vars = obj.getVariables();
+                        write(static_cast<uint32>(vars.size()));
+                        for(map<String,String>::type::const_iterator i = vars.begin(); i != vars.end(); ++i)
+                        {
+                            writeString(i->first);
+                            writeString(i->second);
+                        }
+                        // The overrides were merged into the children by processObjects
+                        writeNodes(obj.values);
+                        writeNodes(obj.children);
+                    }
+                    break;
+                case ANT_PROPERTY:
+                    {
+                        const PropertyAbstractNode &prop = static_cast<const PropertyAbstractNode&>(node);
+                        writeString(prop.name);
+                        writeNodes(prop.values);
+                    }
+                    break;
+                case ANT_IMPORT:
+                    writeString(static_cast<const ImportAbstractNode&>(node).target);
+                    writeString(static_cast<const ImportAbstractNode&>(node).source);
+                    break;
+                case ANT_VARIABLE_ACCESS:
+                    writeString(static_cast<const VariableAccessAbstractNode&>(node).name);
+                    break;
+                default:
+                    break;
+                }
+            }
+        };
+
+        /// Reads abstract syntax trees written by BinaryASTWriter
+        class BinaryASTReader
+        {
+        private:
+            const char *mPos, *mEnd;
+            const ScriptCompiler::IdMap &mIds;
+            StringVector mFiles;
+            bool mFailed;
+        public:
+            BinaryASTReader(const String &in, const ScriptCompiler::IdMap &ids)
+                :mPos(in.data()), mEnd(in.data() + in.size()), mIds(ids), mFailed(false)
+            {
+            }
+
+            bool hasFailed() const { return mFailed; }
+
+            template<typename T> T read()
+            {
+                T val = T();
+                if(mFailed || static_cast<size_t>(mEnd - mPos) < sizeof(T))
+                {
+                    mFailed = true;
+                    return val;
+                }
+                memcpy(&val, mPos, sizeof(T));
+                mPos += sizeof(T);
+                return val;
+            }
+
+            String readString()
+            {
+                uint32 length = read<uint32>();
+                if(mFailed || static_cast<size_t>(mEnd - mPos) < length)
+                {
+                    mFailed = true;
+                    return BLANKSTRING;
+                }
+                String str(mPos, length);
+                mPos += length;
+                return str;
+            }
+
+            uint32 findId(const String &word) const
+            {
+                ScriptCompiler::IdMap::const_iterator i = mIds.find(word);
+                return i != mIds.end() ? i->second : 0;
+            }
+
+            void readNodes(AbstractNodeList &nodes, AbstractNode *parent)
+            {
+                while(!mFailed)
+                {
+                    uint8 type = read<uint8>();
+                    if(mFailed || type == ANT_UNKNOWN)
+                        return;
+
+                    uint32 fileIndex = read<uint32>();
+                    String file;
+                    if(fileIndex < mFiles.size())
+                    {
+                        file = mFiles[fileIndex];
+                    }
+                    else if(fileIndex == mFiles.size())
+                    {
+                        file = readString();
+                        mFiles.push_back(file);
+                    }
+                    else
+                    {
+                        mFailed = true;
+                        return;
+                    }
+                    uint32 line = read<uint32>();
+
+                    AbstractNode *node;
+                    switch(type)
+                    {
+                    case ANT_ATOM:
+                        {
+                            AtomAbstractNode *atom = OGRE_NEW AtomAbstractNode(parent);
+                            node = atom;
+                            atom->value = readString();
+                            atom->id = findId(atom->value);
+                        }
+                        break;
+                    case ANT_OBJECT:
+                        {
+                            ObjectAbstractNode *obj = OGRE_NEW ObjectAbstractNode(parent);
+                            node = obj;
+                            obj->name = readString();
+                            obj->cls = readString();
+                            obj->id = findId(obj->cls);
+                            uint32 numBases = read<uint32>();
+                            for(uint32 i = 0; i < numBases && !mFailed; ++i)
+                                obj->bases.push_back(readString());
+                            obj->abstract = read<uint8>() != 0;
+                            uint32 numVars = read<uint32>();
+                            for(uint32 i = 0; i < numVars && !mFailed; ++i)
+                            {
+                                String name = readString();
+                                obj->setVariable(name, readString());
+                            }
+                            readNodes(obj->values, obj);
+                            readNodes(obj->children, obj);
+                        }
+                        break;
+                    case ANT_PROPERTY:
+                        {
+                            PropertyAbstractNode *prop = OGRE_NEW PropertyAbstractNode(parent);
+                            node = prop;
+                            prop->name = readString();
+                            prop->id = findId(prop->name);
+                            readNodes(prop->values, prop);
+                        }
+                        break;
+                    case ANT_IMPORT:
+                        {
+                            ImportAbstractNode *import = OGRE_NEW ImportAbstractNode();
+                            node = import;
+                            import->parent = parent;
+                            import->target = readString();
+                            import->source = readString();
+                        }
+                        break;
+                    case ANT_VARIABLE_ACCESS:
+                        {
+                            VariableAccessAbstractNode *var = OGRE_NEW VariableAccessAbstractNode(parent);
+                            node = var;
+                            var->name = readString();
+                        }
+                        break;
+                    default:
+                        mFailed = true;
+                        return;
+                    }
+                    node->file = file;
+                    node->line = line;
+                    nodes.push_back(AbstractNodePtr(node));
+                }
+            }
+        };
+    }
+
+    void ScriptCompiler::writeBinaryAST(const AbstractNodeList &nodes, String &binary) const
+    {
+        BinaryASTWriter writer(binary);
+        for(AbstractNodeList::const_iterator i = nodes.begin(); i != nodes.end(); ++i)
+        {
+            // Abstract objects are only there to be inherited from, which is done already
+            if((*i)->type == ANT_OBJECT && static_cast<ObjectAbstractNode*>((*i).get())->abstract)
+                continue;
+            writer.writeNode(**i);
+        }
+        writer.write(static_cast<uint8>(ANT_UNKNOWN));
+    }
+
+    AbstractNodeListPtr ScriptCompiler::readBinaryAST(const String &binary) const
+    {
+        AbstractNodeListPtr nodes(OGRE_NEW_T(AbstractNodeList, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
+        BinaryASTReader reader(binary, mIds);
+        reader.readNodes(*nodes, 0);
+        if(reader.hasFailed())
+            nodes.reset();
+        return nodes;
+    }
+
     // AbstractTreeeBuilder
+    namespace
+    {
+        /// How AbstractTreeBuilder reads a ConcreteNode
+        struct ConcreteNodeTraits
+        {
+            typedef ConcreteNode NodeType;
+            typedef ConcreteNodeList::const_iterator Iterator;
+
+            static const String &getToken(const NodeType *node) { return node->token; }
+            static bool isToken(const NodeType *node, const char *token) { return node->token == token; }
+            static const String &getFile(const NodeType *node) { return node->file; }
+            static size_t getNumChildren(const NodeType *node) { return node->children.size(); }
+            static Iterator begin(const NodeType *node) { return node->children.begin(); }
+            static bool isEnd(const NodeType *node, Iterator i) { return i == node->children.end(); }
+            static void next(Iterator &i) { ++i; }
+            static const NodeType *get(Iterator i) { return i->get(); }
+            static void getLastChildren(const NodeType *node, const NodeType *&last, const NodeType *&previous)
+            {
+                ConcreteNodeList::const_reverse_iterator i = node->children.rbegin();
+                if(i != node->children.rend())
+                    last = (i++)->get();
+                if(i != node->children.rend())
+                    previous = i->get();
+            }
+        };
+
+        /// How AbstractTreeBuilder reads a ScriptNodeView
+        struct ScriptNodeViewTraits
+        {
+            typedef ScriptNodeView NodeType;
+            typedef const ScriptNodeView *Iterator;
+
+            static String getToken(const NodeType *node) { return String(node->token, node->length); }
+            static bool isToken(const NodeType *node, const char *token)
+            {
+                return strlen(token) == node->length && memcmp(node->token, token, node->length) == 0;
+            }
+            static const String &getFile(const NodeType *node) { return *node->file; }
+            static size_t getNumChildren(const NodeType *node) { return node->numChildren; }
+            static Iterator begin(const NodeType *node) { return node->firstChild; }
+            static bool isEnd(const NodeType *, Iterator i) { return i == 0; }
+            static void next(Iterator &i) { i = i->next; }
+            static const NodeType *get(Iterator i) { return i; }
+            static void getLastChildren(const NodeType *node, const NodeType *&last, const NodeType *&previous)
+            {
+                last = node->lastChild;
+                if(last)
+                    previous = last->prev;
+            }
+        };
+    }
+
     ScriptCompiler::AbstractTreeBuilder::AbstractTreeBuilder(ScriptCompiler *compiler)
         :mNodes(OGRE_NEW_T(AbstractNodeList, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T), mCurrent(0), mCompiler(compiler)
     {
@@ -1311,58 +1753,72 @@ namespace Ogre
 
     void ScriptCompiler::AbstractTreeBuilder::visit(ConcreteNode *node)
     {
+        visitNode<ConcreteNodeTraits>(node);
+    }
+
+    void ScriptCompiler::AbstractTreeBuilder::visit(const ScriptNodeView *node)
+    {
+        visitNode<ScriptNodeViewTraits>(node);
+    }
+
+    template<class Traits>
+    void ScriptCompiler::AbstractTreeBuilder::visitNode(const typename Traits::NodeType *node)
+    {
+        typedef typename Traits::NodeType NodeType;
+        typedef typename Traits::Iterator Iterator;
         AbstractNodePtr asn;
 
         // Import = "import" >> 2 children, mCurrent == null
         if(node->type == CNT_IMPORT && mCurrent == 0)
         {
-            if(node->children.size() > 2)
+            if(Traits::getNumChildren(node) > 2)
             {
-                mCompiler->addError(CE_FEWERPARAMETERSEXPECTED, node->file, node->line);
+                mCompiler->addError(CE_FEWERPARAMETERSEXPECTED, Traits::getFile(node), node->line);
                 return;
             }
-            if(node->children.size() < 2)
+            if(Traits::getNumChildren(node) < 2)
             {
-                mCompiler->addError(CE_STRINGEXPECTED, node->file, node->line);
+                mCompiler->addError(CE_STRINGEXPECTED, Traits::getFile(node), node->line);
                 return;
             }
 
             ImportAbstractNode *impl = OGRE_NEW ImportAbstractNode();
             impl->line = node->line;
-            impl->file = node->file;
+            impl->file = Traits::getFile(node);
             
-            ConcreteNodeList::iterator iter = node->children.begin();
-            impl->target = (*iter)->token;
+            Iterator iter = Traits::begin(node);
+            impl->target = Traits::getToken(Traits::get(iter));
 
-            iter++;
-            impl->source = (*iter)->token;
+            Traits::next(iter);
+            impl->source = Traits::getToken(Traits::get(iter));
 
             asn = AbstractNodePtr(impl);
         }
         // variable set = "set" >> 2 children, children[0] == variable
         else if(node->type == CNT_VARIABLE_ASSIGN)
         {
-            if(node->children.size() > 2)
+            if(Traits::getNumChildren(node) > 2)
             {
-                mCompiler->addError(CE_FEWERPARAMETERSEXPECTED, node->file, node->line);
+                mCompiler->addError(CE_FEWERPARAMETERSEXPECTED, Traits::getFile(node), node->line);
                 return;
             }
-            if(node->children.size() < 2)
+            if(Traits::getNumChildren(node) < 2)
             {
-                mCompiler->addError(CE_STRINGEXPECTED, node->file, node->line);
+                mCompiler->addError(CE_STRINGEXPECTED, Traits::getFile(node), node->line);
                 return;
             }
-            if(node->children.front()->type != CNT_VARIABLE)
+            Iterator i = Traits::begin(node);
+            const NodeType *variable = Traits::get(i);
+            if(variable->type != CNT_VARIABLE)
             {
-                mCompiler->addError(CE_VARIABLEEXPECTED, node->children.front()->file, node->children.front()->line);
+                mCompiler->addError(CE_VARIABLEEXPECTED, Traits::getFile(variable), variable->line);
                 return;
             }
 
-            ConcreteNodeList::iterator i = node->children.begin();
-            String name = (*i)->token;
+            String name = Traits::getToken(variable);
 
-            ++i;
-            String value = (*i)->token;
+            Traits::next(i);
+            String value = Traits::getToken(Traits::get(i));
 
             if(mCurrent && mCurrent->type == ANT_OBJECT)
             {
@@ -1377,108 +1833,97 @@ namespace Ogre
         // variable = $*, no children
         else if(node->type == CNT_VARIABLE)
         {
-            if(!node->children.empty())
+            if(Traits::getNumChildren(node) != 0)
             {
-                mCompiler->addError(CE_FEWERPARAMETERSEXPECTED, node->file, node->line);
+                mCompiler->addError(CE_FEWERPARAMETERSEXPECTED, Traits::getFile(node), node->line);
                 return;
             }
 
             VariableAccessAbstractNode *impl = OGRE_NEW VariableAccessAbstractNode(mCurrent);
             impl->line = node->line;
-            impl->file = node->file;
-            impl->name = node->token;
+            impl->file = Traits::getFile(node);
+            impl->name = Traits::getToken(node);
 
             asn = AbstractNodePtr(impl);
         }
         // Handle properties and objects here
-        else if(!node->children.empty())
+        else if(Traits::getNumChildren(node) != 0)
         {
             // Grab the last two nodes
-            ConcreteNodePtr temp1, temp2;
-            ConcreteNodeList::reverse_iterator riter = node->children.rbegin();
-            if(riter != node->children.rend())
-            {
-                temp1 = *riter;
-                riter++;
-            }
-            if(riter != node->children.rend())
-                temp2 = *riter;
+            const NodeType *temp1 = 0, *temp2 = 0;
+            Traits::getLastChildren(node, temp1, temp2);
 
             // object = last 2 children == { and }
             if(temp1 && temp2 &&
                 temp1->type == CNT_RBRACE && temp2->type == CNT_LBRACE)
             {
-                if(node->children.size() < 2)
+                if(Traits::getNumChildren(node) < 2)
                 {
-                    mCompiler->addError(CE_STRINGEXPECTED, node->file, node->line);
+                    mCompiler->addError(CE_STRINGEXPECTED, Traits::getFile(node), node->line);
                     return;
                 }
 
                 ObjectAbstractNode *impl = OGRE_NEW ObjectAbstractNode(mCurrent);
                 impl->line = node->line;
-                impl->file = node->file;
+                impl->file = Traits::getFile(node);
                 impl->abstract = false;
 
-                // Create a temporary detail list
-                list<ConcreteNode*>::type temp;
-                if(node->token == "abstract")
+                // The details are the node followed by its children, or only the
+                // children of an abstract object
+                Iterator iter = Traits::begin(node);
+                const NodeType *detail = node;
+                if(Traits::isToken(node, "abstract"))
                 {
                     impl->abstract = true;
-                    for(ConcreteNodeList::const_iterator i = node->children.begin(); i != node->children.end(); ++i)
-                        temp.push_back((*i).get());
-                }
-                else
-                {
-                    temp.push_back(node);
-                    for(ConcreteNodeList::const_iterator i = node->children.begin(); i != node->children.end(); ++i)
-                        temp.push_back((*i).get());
+                    detail = Traits::get(iter);
+                    Traits::next(iter);
                 }
 
                 // Get the type of object
-                list<ConcreteNode*>::type::const_iterator iter = temp.begin();
-                impl->cls = (*iter)->token;
-                ++iter;
+                impl->cls = Traits::getToken(detail);
+                detail = Traits::isEnd(node, iter) ? 0 : Traits::get(iter);
 
                 // Get the name
                 // Unless the type is in the exclusion list
-                if(iter != temp.end() && ((*iter)->type == CNT_WORD || (*iter)->type == CNT_QUOTE) &&
+                if(detail && (detail->type == CNT_WORD || detail->type == CNT_QUOTE) &&
                     !mCompiler->isNameExcluded(impl->cls, mCurrent))
                 {
-                    impl->name = (*iter)->token;
-                    ++iter;
+                    impl->name = Traits::getToken(detail);
+                    Traits::next(iter);
+                    detail = Traits::isEnd(node, iter) ? 0 : Traits::get(iter);
                 }
 
                 // Everything up until the colon is a "value" of this object
-                while(iter != temp.end() && (*iter)->type != CNT_COLON && (*iter)->type != CNT_LBRACE)
+                while(detail && detail->type != CNT_COLON && detail->type != CNT_LBRACE)
                 {
-                    if((*iter)->type == CNT_VARIABLE)
+                    if(detail->type == CNT_VARIABLE)
                     {
                         VariableAccessAbstractNode *var = OGRE_NEW VariableAccessAbstractNode(impl);
-                        var->file = (*iter)->file;
-                        var->line = (*iter)->line;
+                        var->file = Traits::getFile(detail);
+                        var->line = detail->line;
                         var->type = ANT_VARIABLE_ACCESS;
-                        var->name = (*iter)->token;
+                        var->name = Traits::getToken(detail);
                         impl->values.push_back(AbstractNodePtr(var));
                     }
                     else
                     {
                         AtomAbstractNode *atom = OGRE_NEW AtomAbstractNode(impl);
-                        atom->file = (*iter)->file;
-                        atom->line = (*iter)->line;
+                        atom->file = Traits::getFile(detail);
+                        atom->line = detail->line;
                         atom->type = ANT_ATOM;
-                        atom->value = (*iter)->token;
+                        atom->value = Traits::getToken(detail);
                         impl->values.push_back(AbstractNodePtr(atom));
                     }
-                    ++iter;
+                    Traits::next(iter);
+                    detail = Traits::isEnd(node, iter) ? 0 : Traits::get(iter);
                 }
 
                 // Find the bases
-                if(iter != temp.end() && (*iter)->type == CNT_COLON)
+                if(detail && detail->type == CNT_COLON)
                 {
                     // Children of the ':' are bases
-                    for(ConcreteNodeList::iterator j = (*iter)->children.begin(); j != (*iter)->children.end(); ++j)
-                        impl->bases.push_back((*j)->token);
-                    ++iter;
+                    for(Iterator j = Traits::begin(detail); !Traits::isEnd(detail, j); Traits::next(j))
+                        impl->bases.push_back(Traits::getToken(Traits::get(j)));
                 }
 
                 // Finally try to map the cls to an id
@@ -1496,7 +1941,8 @@ namespace Ogre
                 mCurrent = impl;
 
                 // Visit the children of the {
-                AbstractTreeBuilder::visit(this, temp2->children);
+                for(Iterator i = Traits::begin(temp2); !Traits::isEnd(temp2, i); Traits::next(i))
+                    visitNode<Traits>(Traits::get(i));
 
                 // Go back up the stack
                 mCurrent = impl->parent;
@@ -1506,8 +1952,8 @@ namespace Ogre
             {
                 PropertyAbstractNode *impl = OGRE_NEW PropertyAbstractNode(mCurrent);
                 impl->line = node->line;
-                impl->file = node->file;
-                impl->name = node->token;
+                impl->file = Traits::getFile(node);
+                impl->name = Traits::getToken(node);
 
                 ScriptCompiler::IdMap::const_iterator iter2 = mCompiler->mIds.find(impl->name);
                 if(iter2 != mCompiler->mIds.end())
@@ -1517,7 +1963,8 @@ namespace Ogre
                 mCurrent = impl;
 
                 // Visit the children of the {
-                AbstractTreeBuilder::visit(this, node->children);
+                for(Iterator i = Traits::begin(node); !Traits::isEnd(node, i); Traits::next(i))
+                    visitNode<Traits>(Traits::get(i));
 
                 // Go back up the stack
                 mCurrent = impl->parent;
@@ -1528,8 +1975,8 @@ namespace Ogre
         {
             AtomAbstractNode *impl = OGRE_NEW AtomAbstractNode(mCurrent);
             impl->line = node->line;
-            impl->file = node->file;
-            impl->value = node->token;
+            impl->file = Traits::getFile(node);
+            impl->value = Traits::getToken(node);
 
             ScriptCompiler::IdMap::const_iterator iter2 = mCompiler->mIds.find(impl->value);
             if(iter2 != mCompiler->mIds.end())
@@ -1566,6 +2013,12 @@ namespace Ogre
         for(ConcreteNodeList::const_iterator i = nodes.begin(); i != nodes.end(); ++i)
             visitor->visit((*i).get());
     }
+
+    void ScriptCompiler::AbstractTreeBuilder::visit(AbstractTreeBuilder *visitor, const ScriptNodeView *first)
+    {
+        for(const ScriptNodeView *i = first; i; i = i->next)
+            visitor->visit(i);
+    }
     
 
     // ScriptCompilerManager
@@ -1582,7 +2035,8 @@ namespace Ogre
     }
     //-----------------------------------------------------------------------
     ScriptCompilerManager::ScriptCompilerManager()
-        :mListener(0), OGRE_THREAD_POINTER_INIT(mScriptCompiler)
+        :mListener(0), OGRE_THREAD_POINTER_INIT(mScriptCompiler), mSaveCompiledScriptsToCache(false),
+        mCompiledScriptCacheDirty(false), mArenaScriptParsing(false)
     {
             OGRE_LOCK_AUTO_MUTEX;
         mScriptPatterns.push_back("*.program");
@@ -1678,7 +2132,7 @@ namespace Ogre
         return 90.0f;
     }
     //-----------------------------------------------------------------------
-    void ScriptCompilerManager::parseScript(DataStreamPtr& stream, const String& groupName)
+    ScriptCompiler *ScriptCompilerManager::getThreadCompiler(void)
     {
 #if OGRE_THREAD_SUPPORT
         // check we have an instance for this thread (should always have one for main thread)
@@ -1690,11 +2144,326 @@ namespace Ogre
         }
 #endif
         // Set the listener on the compiler before we continue
+        ScriptCompiler *compiler = OGRE_THREAD_POINTER_GET(mScriptCompiler);
+        {
+                    OGRE_LOCK_AUTO_MUTEX;
+            compiler->setListener(mListener);
+            compiler->setArenaParsing(mArenaScriptParsing);
+        }
+        return compiler;
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::parseScript(DataStreamPtr& stream, const String& groupName)
+    {
+        ScriptCompiler *compiler = getThreadCompiler();
+        bool useCache, saveToCache;
+        {
+                    OGRE_LOCK_AUTO_MUTEX;
+            // A listener may change the tree, so the cached one can't stand in for it
+            saveToCache = !mListener && mSaveCompiledScriptsToCache;
+            useCache = !mListener && !mCompiledScripts.empty();
+        }
+        if (!useCache && !saveToCache)
+        {
+            compiler->compile(stream->getAsString(), stream->getName(), groupName);
+            return;
+        }
+
+        String str = stream->getAsString();
+        CompiledScript script;
+        script.sources.push_back(ScriptCompiler::hashSource(stream->getName(), str));
+        std::pair<String, String> key(groupName, stream->getName());
+
+        if (useCache)
+        {
+            CompiledScript cached;
+            {
+                        OGRE_LOCK_AUTO_MUTEX;
+                CompiledScriptMap::const_iterator i = mCompiledScripts.find(key);
+                if (i != mCompiledScripts.end())
+                    cached = i->second;
+            }
+            const ScriptCompiler::SourceHash& hash = script.sources.front();
+            if (!cached.sources.empty() && cached.sources.front().hash == hash.hash &&
+                cached.sources.front().length == hash.length && isCompiledScriptCurrent(cached, groupName))
+            {
+                bool translated;
+                if (compiler->_compileFromBinary(cached.binary, groupName, translated))
+                    return;
+
+                if (translated)
+                {
+                    // Compiling the source now would only add errors about the resources
+                    // already created, so keep the errors and compile it on the next run
+                    LogManager::getSingleton().logMessage("Compiled script " + stream->getName() +
+                        " reported errors, removing it from the cache", LML_CRITICAL);
+                            OGRE_LOCK_AUTO_MUTEX;
+                    mCompiledScripts.erase(key);
+                    mCompiledScriptCacheDirty = true;
+                    return;
+                }
+            }
+        }
+
+        if (!saveToCache)
+        {
+            compiler->compile(str, stream->getName(), groupName);
+            return;
+        }
+
+        if (compiler->_compileToBinary(str, stream->getName(), groupName, script.binary, script.sources))
         {
                     OGRE_LOCK_AUTO_MUTEX;
-            OGRE_THREAD_POINTER_GET(mScriptCompiler)->setListener(mListener);
+            mCompiledScripts[key] = script;
+            mCompiledScriptCacheDirty = true;
+        }
+    }
+    //-----------------------------------------------------------------------
+    namespace
+    {
+        /// A script tokenized and parsed by ScriptCompilerManager::preParseScript
+        class ParsedCompilerScript : public ScriptLoader::ParsedScript
+        {
+        public:
+            ParsedCompilerScript() : views(0) {}
+
+            ConcreteNodeListPtr nodes;
+            ScriptCompiler::SourceHash hash;
+            /// The tree when parsed into an arena, which refers to the source and the name in hash
+            String source;
+            ScriptArena arena;
+            const ScriptNodeView *views;
+        };
+    }
+    //-----------------------------------------------------------------------
+    ScriptLoader::ParsedScriptPtr ScriptCompilerManager::preParseScript(DataStreamPtr& stream, const String& groupName)
+    {
+        bool arenaParsing;
+        {
+                    OGRE_LOCK_AUTO_MUTEX;
+            if (!mListener && !mCompiledScripts.empty())
+                return ParsedScriptPtr();
+            arenaParsing = mArenaScriptParsing && !mListener;
+        }
+
+        String str = stream->getAsString();
+        ParsedCompilerScript *parsed = OGRE_NEW ParsedCompilerScript();
+        ParsedScriptPtr result(parsed);
+        parsed->hash = ScriptCompiler::hashSource(stream->getName(), str);
+        if (arenaParsing)
+        {
+            parsed->source.swap(str);
+            ScriptTokenViewList tokens;
+            ScriptLexer::tokenize(parsed->source, parsed->arena, tokens);
+            parsed->views = ScriptParser::parse(tokens, parsed->hash.name, parsed->arena);
         }
-        OGRE_THREAD_POINTER_GET(mScriptCompiler)->compile(stream->getAsString(), stream->getName(), groupName);
+        else
+        {
+            parsed->nodes = ScriptParser::parse(ScriptLexer::tokenize(str, stream->getName()));
+        }
+        return result;
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::finishParseScript(DataStreamPtr& stream, const String& groupName,
+        const ParsedScriptPtr& parsed)
+    {
+        if (!parsed)
+        {
+            parseScript(stream, groupName);
+            return;
+        }
+
+        const ParsedCompilerScript *script = static_cast<const ParsedCompilerScript*>(parsed.get());
+        ScriptCompiler *compiler = getThreadCompiler();
+        bool saveToCache;
+        {
+                    OGRE_LOCK_AUTO_MUTEX;
+            saveToCache = !mListener && mSaveCompiledScriptsToCache;
+        }
+        if (!saveToCache)
+        {
+            if (script->nodes)
+                compiler->compile(script->nodes, groupName);
+            else
+                compiler->compile(script->views, groupName);
+            return;
+        }
+
+        CompiledScript compiled;
+        compiled.sources.push_back(script->hash);
+        bool compiledToBinary = script->nodes ?
+            compiler->_compileToBinary(script->nodes, groupName, compiled.binary, compiled.sources) :
+            compiler->_compileToBinary(script->views, groupName, compiled.binary, compiled.sources);
+        if (compiledToBinary)
+        {
+                    OGRE_LOCK_AUTO_MUTEX;
+            mCompiledScripts[std::make_pair(groupName, stream->getName())] = compiled;
+            mCompiledScriptCacheDirty = true;
+        }
+    }
+    //-----------------------------------------------------------------------
+    bool ScriptCompilerManager::isCompiledScriptCurrent(const CompiledScript &script, const String &groupName) const
+    {
+        for (size_t i = 1; i < script.sources.size(); ++i)
+        {
+            const ScriptCompiler::SourceHash& import = script.sources[i];
+            DataStreamPtr stream;
+            try
+            {
+                stream = ResourceGroupManager::getSingleton().openResource(import.name, groupName);
+            }
+            catch (FileNotFoundException&)
+            {
+                // Still current if the import was missing before as well
+                if (import.length == ScriptCompiler::SourceHash::MISSING)
+                    continue;
+                return false;
+            }
+
+            ScriptCompiler::SourceHash hash = ScriptCompiler::hashSource(import.name, stream->getAsString());
+            if (hash.hash != import.hash || hash.length != import.length)
+                return false;
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::setSaveCompiledScriptsToCache(bool val)
+    {
+            OGRE_LOCK_AUTO_MUTEX;
+        mSaveCompiledScriptsToCache = val;
+    }
+    //-----------------------------------------------------------------------
+    bool ScriptCompilerManager::getSaveCompiledScriptsToCache(void) const
+    {
+        return mSaveCompiledScriptsToCache;
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::setArenaScriptParsing(bool val)
+    {
+            OGRE_LOCK_AUTO_MUTEX;
+        mArenaScriptParsing = val;
+    }
+    //-----------------------------------------------------------------------
+    bool ScriptCompilerManager::getArenaScriptParsing(void) const
+    {
+        return mArenaScriptParsing;
+    }
+    //-----------------------------------------------------------------------
+    bool ScriptCompilerManager::isCompiledScriptCacheDirty(void) const
+    {
+        return mCompiledScriptCacheDirty;
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::clearCompiledScriptCache(void)
+    {
+            OGRE_LOCK_AUTO_MUTEX;
+        mCompiledScriptCacheDirty = mCompiledScriptCacheDirty || !mCompiledScripts.empty();
+        mCompiledScripts.clear();
+    }
+    //-----------------------------------------------------------------------
+    namespace
+    {
+        // Changes whenever the layout of the compiled script cache or the binary trees does
+        const uint32 COMPILED_SCRIPT_CACHE_VERSION = 1;
+
+        void writeCacheString(const DataStreamPtr &stream, const String &str)
+        {
+            uint32 length = static_cast<uint32>(str.size());
+            stream->write(&length, sizeof(uint32));
+            stream->write(str.data(), length);
+        }
+
+        bool readCacheValue(const DataStreamPtr &stream, uint32 &value)
+        {
+            return stream->read(&value, sizeof(uint32)) == sizeof(uint32);
+        }
+
+        bool readCacheString(const DataStreamPtr &stream, String &str)
+        {
+            uint32 length = 0;
+            if (!readCacheValue(stream, length))
+                return false;
+            // A length past the end of the stream means the cache is truncated or corrupt
+            if (length > stream->size() - stream->tell())
+                return false;
+            str.resize(length);
+            return !length || stream->read(&str[0], length) == length;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::saveCompiledScriptCache(DataStreamPtr stream) const
+    {
+        if (!mCompiledScriptCacheDirty)
+            return;
+
+        if (!stream->isWriteable())
+        {
+            OGRE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE,
+                "Unable to write to stream " + stream->getName(),
+                "ScriptCompilerManager::saveCompiledScriptCache");
+        }
+
+            OGRE_LOCK_AUTO_MUTEX;
+        stream->write(&COMPILED_SCRIPT_CACHE_VERSION, sizeof(uint32));
+        uint32 numScripts = static_cast<uint32>(mCompiledScripts.size());
+        stream->write(&numScripts, sizeof(uint32));
+
+        for (CompiledScriptMap::const_iterator i = mCompiledScripts.begin(); i != mCompiledScripts.end(); ++i)
+        {
+            writeCacheString(stream, i->first.first);
+            writeCacheString(stream, i->first.second);
+
+            const ScriptCompiler::SourceHashList& sources = i->second.sources;
+            uint32 numSources = static_cast<uint32>(sources.size());
+            stream->write(&numSources, sizeof(uint32));
+            for (ScriptCompiler::SourceHashList::const_iterator j = sources.begin(); j != sources.end(); ++j)
+            {
+                writeCacheString(stream, j->name);
+                stream->write(&j->hash, sizeof(uint32));
+                stream->write(&j->length, sizeof(uint32));
+            }
+
+            writeCacheString(stream, i->second.binary);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::loadCompiledScriptCache(DataStreamPtr stream)
+    {
+            OGRE_LOCK_AUTO_MUTEX;
+        mCompiledScripts.clear();
+
+        uint32 version = 0;
+        uint32 numScripts = 0;
+        if (readCacheValue(stream, version) && version == COMPILED_SCRIPT_CACHE_VERSION &&
+            readCacheValue(stream, numScripts))
+        {
+            for (uint32 i = 0; i < numScripts; ++i)
+            {
+                std::pair<String, String> key;
+                CompiledScript script;
+                uint32 numSources = 0;
+                bool valid = readCacheString(stream, key.first) && readCacheString(stream, key.second) &&
+                    readCacheValue(stream, numSources);
+                for (uint32 j = 0; valid && j < numSources; ++j)
+                {
+                    ScriptCompiler::SourceHash hash;
+                    valid = readCacheString(stream, hash.name) && readCacheValue(stream, hash.hash) &&
+                        readCacheValue(stream, hash.length);
+                    script.sources.push_back(hash);
+                }
+                if (!valid || !readCacheString(stream, script.binary))
+                {
+                    // Nothing read from a damaged cache can be trusted, all of it misses
+                    mCompiledScripts.clear();
+                    break;
+                }
+
+                mCompiledScripts.insert(std::make_pair(key, script));
+            }
+        }
+
+        // if cache is not modified, mark it as clean.
+        mCompiledScriptCacheDirty = false;
     }
 
     //-------------------------------------------------------------------------
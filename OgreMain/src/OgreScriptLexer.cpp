@@ -122,6 +122,7 @@ namespace Ogre{
                 {
                     state = WORD;
                 }
+                // fall through
             case WORD:
                 if(isNewline(c))
                 {
@@ -225,6 +226,198 @@ namespace Ogre{
         return tokens;
     }
 
+    void ScriptLexer::tokenize(const String &str, ScriptArena &arena, ScriptTokenViewList &tokens)
+    {
+        // The same state machine as above, marking where each lexeme starts instead of copying it
+        enum{ READY = 0, COMMENT, MULTICOMMENT, WORD, QUOTE, VAR, POSSIBLECOMMENT };
+
+        const char varopener = '$', quote = '\"', slash = '/', backslash = '\\', openbrace = '{', closebrace = '}', colon = ':', star = '*', cr = '\r', lf = '\n';
+        char c = 0, lastc = 0;
+
+        const char *begin = str.c_str(), *end = begin + str.size(), *lexeme = begin;
+        uint32 line = 1, state = READY, lastQuote = 0;
+        bool escaped = false;
+        tokens.clear();
+
+        for(const char *i = begin; i != end; ++i)
+        {
+            lastc = c;
+            c = *i;
+
+            if(c == quote)
+                lastQuote = line;
+
+            switch(state)
+            {
+            case READY:
+                if(c == slash && lastc == slash)
+                {
+                    state = COMMENT;
+                }
+                else if(c == star && lastc == slash)
+                {
+                    state = MULTICOMMENT;
+                }
+                else if(c == quote)
+                {
+                    lexeme = i;
+                    escaped = false;
+                    state = QUOTE;
+                }
+                else if(c == varopener)
+                {
+                    lexeme = i;
+                    state = VAR;
+                }
+                else if(isNewline(c))
+                {
+                    setToken(i, 1, line, tokens);
+                }
+                else if(!isWhitespace(c))
+                {
+                    lexeme = i;
+                    if(c == slash)
+                        state = POSSIBLECOMMENT;
+                    else
+                        state = WORD;
+                }
+                break;
+            case COMMENT:
+                if(isNewline(c))
+                {
+                    setToken(i, 1, line, tokens);
+                    state = READY;
+                }
+                break;
+            case MULTICOMMENT:
+                if(c == slash && lastc == star)
+                    state = READY;
+                break;
+            case POSSIBLECOMMENT:
+                if(c == slash && lastc == slash)
+                {
+                    state = COMMENT;
+                    break;
+                }
+                else if(c == star && lastc == slash)
+                {
+                    state = MULTICOMMENT;
+                    break;
+                }
+                else
+                {
+                    state = WORD;
+                }
+                // fall through
+            case WORD:
+            case VAR:
+                if(isNewline(c) || c == openbrace || c == closebrace || c == colon)
+                {
+                    setToken(lexeme, i - lexeme, line, tokens);
+                    setToken(i, 1, line, tokens);
+                    state = READY;
+                }
+                else if(isWhitespace(c))
+                {
+                    setToken(lexeme, i - lexeme, line, tokens);
+                    state = READY;
+                }
+                break;
+            case QUOTE:
+                if(c == backslash)
+                {
+                    escaped = true;
+                }
+                else if(c == quote && lastc != backslash)
+                {
+                    if(escaped)
+                    {
+                        size_t length;
+                        const char *unescaped = unescapeQuote(lexeme, i + 1, arena, length);
+                        setToken(unescaped, length, line, tokens);
+                    }
+                    else
+                    {
+                        setToken(lexeme, i + 1 - lexeme, line, tokens);
+                    }
+                    state = READY;
+                }
+                break;
+            }
+
+            // Separate check for newlines just to track line numbers
+            if(c == cr || (c == lf && lastc != cr))
+                line++;
+        }
+
+        // Check for valid exit states
+        if(state == WORD || state == VAR)
+        {
+            setToken(lexeme, end - lexeme, line, tokens);
+        }
+        else if(state == QUOTE)
+        {
+            OGRE_EXCEPT(Exception::ERR_INVALID_STATE, 
+                Ogre::String("no matching \" found for \" at line ") + 
+                Ogre::StringConverter::toString(lastQuote),
+                "ScriptLexer::tokenize");
+        }
+    }
+
+    const char *ScriptLexer::unescapeQuote(const char *begin, const char *end, ScriptArena &arena, size_t &length)
+    {
+        const char quote = '\"', backslash = '\\';
+
+        // Backslashes are dropped, and put back before anything but a quote
+        char *result = static_cast<char*>(arena.allocate(end - begin)), *out = result;
+        char lastc = *begin;
+        *out++ = *begin;
+        for(const char *i = begin + 1; i != end; ++i)
+        {
+            if(*i != backslash)
+            {
+                if(lastc == backslash && *i != quote)
+                    *out++ = backslash;
+                *out++ = *i;
+            }
+            lastc = *i;
+        }
+        length = out - result;
+        return result;
+    }
+
+    void ScriptLexer::setToken(const char *lexeme, size_t length, uint32 line, ScriptTokenViewList &tokens)
+    {
+        const char openBracket = '{', closeBracket = '}', colon = ':',
+            quote = '\"', var = '$';
+
+        ScriptTokenView token;
+        token.lexeme = lexeme;
+        token.length = static_cast<uint32>(length);
+        token.line = line;
+
+        if(length == 1 && isNewline(lexeme[0]))
+        {
+            token.type = TID_NEWLINE;
+            if(!tokens.empty() && tokens.back().type == TID_NEWLINE)
+                return;
+        }
+        else if(length == 1 && lexeme[0] == openBracket)
+            token.type = TID_LBRACKET;
+        else if(length == 1 && lexeme[0] == closeBracket)
+            token.type = TID_RBRACKET;
+        else if(length == 1 && lexeme[0] == colon)
+            token.type = TID_COLON;
+        else if(lexeme[0] == var)
+            token.type = TID_VARIABLE;
+        else if(length >= 2 && lexeme[0] == quote && lexeme[length - 1] == quote)
+            token.type = TID_QUOTE;
+        else
+            token.type = TID_WORD;
+
+        tokens.push_back(token);
+    }
+
     void ScriptLexer::setToken(const Ogre::String &lexeme, Ogre::uint32 line, const String &source, Ogre::ScriptTokenList *tokens)
     {
         const char openBracket = '{', closeBracket = '}', colon = ':',
@@ -278,5 +471,56 @@ namespace Ogre{
         return c == '\n' || c == '\r';
     }
 
+
+    ScriptArena::ScriptArena(size_t blockSize)
+        :mCurrent(0), mUsed(0), mBlockSize(blockSize)
+    {
+    }
+
+    ScriptArena::~ScriptArena()
+    {
+        for(vector<Block>::type::iterator i = mBlocks.begin(); i != mBlocks.end(); ++i)
+            OGRE_FREE(i->data, MEMCATEGORY_SCRIPTING);
+    }
+
+    void *ScriptArena::allocate(size_t size)
+    {
+        const size_t alignment = 16;
+        size = (size + alignment - 1) & ~(alignment - 1);
+
+        // Move on through the blocks kept by clear until one has room
+        for(; mCurrent < mBlocks.size(); ++mCurrent, mUsed = 0)
+        {
+            if(mUsed + size <= mBlocks[mCurrent].size)
+            {
+                void *result = mBlocks[mCurrent].data + mUsed;
+                mUsed += size;
+                return result;
+            }
+        }
+
+        Block block;
+        block.size = std::max(size, mBlockSize);
+        block.data = static_cast<char*>(OGRE_MALLOC(block.size, MEMCATEGORY_SCRIPTING));
+        mBlocks.push_back(block);
+        mCurrent = mBlocks.size() - 1;
+        mUsed = size;
+        return block.data;
+    }
+
+    void ScriptArena::clear(void)
+    {
+        mCurrent = 0;
+        mUsed = 0;
+    }
+
+    size_t ScriptArena::getCapacity(void) const
+    {
+        size_t capacity = 0;
+        for(vector<Block>::type::const_iterator i = mBlocks.begin(); i != mBlocks.end(); ++i)
+            capacity += i->size;
+        return capacity;
+    }
+
 }
 
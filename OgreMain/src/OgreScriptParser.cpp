@@ -73,7 +73,7 @@ namespace Ogre
                         temp->line = (*i)->line;
                         temp->type = (*i)->type == TID_WORD ? CNT_WORD : CNT_QUOTE;
                         if(temp->type == CNT_QUOTE)
-                            temp->token = (*i)->lexeme.substr(1, token->lexeme.size() - 2);
+                            temp->token = (*i)->lexeme.substr(1, (*i)->lexeme.size() - 2);
                         else
                             temp->token = (*i)->lexeme;
                         node->children.push_back(temp);
@@ -488,6 +488,242 @@ namespace Ogre
         return nodes;
     }
 
+    ScriptNodeView *ScriptParser::parse(const ScriptTokenViewList &tokens, const String &source, ScriptArena &arena)
+    {
+        // The same as parsing a ScriptTokenList, see there for the details
+        enum{READY, OBJECT};
+        uint32 state = READY;
+
+        ScriptNodeView *first = 0, *last = 0, *parent = 0, *node = 0;
+        ScriptTokenViewList::const_iterator i = tokens.begin(), end = tokens.end();
+        while(i != end)
+        {
+            const ScriptTokenView &token = *i;
+
+            switch(state)
+            {
+            case READY:
+                if(token.type == TID_WORD)
+                {
+                    if(token.length == 6 && memcmp(token.lexeme, "import", 6) == 0)
+                    {
+                        node = createNode(token, CNT_IMPORT, false, source, arena);
+
+                        // The next token is the target
+                        ++i;
+                        if(i == end || (i->type != TID_WORD && i->type != TID_QUOTE))
+                            OGRE_EXCEPT(Exception::ERR_INVALID_STATE, 
+                                Ogre::String("expected import target at line ") + 
+                                    Ogre::StringConverter::toString(node->line),
+                                "ScriptParser::parse");
+                        addNode(node, createNode(*i, i->type == TID_WORD ? CNT_WORD : CNT_QUOTE, true, source, arena), first, last);
+
+                        // The second-next token is the source
+                        ++i;
+                        ++i;
+                        if(i == end || (i->type != TID_WORD && i->type != TID_QUOTE))
+                            OGRE_EXCEPT(Exception::ERR_INVALID_STATE, 
+                                Ogre::String("expected import source at line ") + 
+                                    Ogre::StringConverter::toString(node->line),
+                                "ScriptParser::parse");
+                        addNode(node, createNode(*i, i->type == TID_WORD ? CNT_WORD : CNT_QUOTE, true, source, arena), first, last);
+
+                        // Consume all the newlines
+                        i = skipNewlines(i, end);
+
+                        addNode(parent, node, first, last);
+                    }
+                    else if(token.length == 3 && memcmp(token.lexeme, "set", 3) == 0)
+                    {
+                        node = createNode(token, CNT_VARIABLE_ASSIGN, false, source, arena);
+
+                        // The next token is the variable
+                        ++i;
+                        if(i == end || i->type != TID_VARIABLE)
+                            OGRE_EXCEPT(Exception::ERR_INVALID_STATE, 
+                                Ogre::String("expected variable name at line ") + 
+                                    Ogre::StringConverter::toString(node->line),
+                                "ScriptParser::parse");
+                        addNode(node, createNode(*i, CNT_VARIABLE, false, source, arena), first, last);
+
+                        // The next token is the assignment
+                        ++i;
+                        if(i == end || (i->type != TID_WORD && i->type != TID_QUOTE))
+                            OGRE_EXCEPT(Exception::ERR_INVALID_STATE, 
+                                Ogre::String("expected variable value at line ") + 
+                                    Ogre::StringConverter::toString(node->line),
+                                "ScriptParser::parse");
+                        addNode(node, createNode(*i, i->type == TID_WORD ? CNT_WORD : CNT_QUOTE, true, source, arena), first, last);
+
+                        // Consume all the newlines
+                        i = skipNewlines(i, end);
+
+                        addNode(parent, node, first, last);
+                    }
+                    else
+                    {
+                        node = createNode(token, CNT_WORD, false, source, arena);
+                        addNode(parent, node, first, last);
+
+                        // Set the parent
+                        parent = node;
+
+                        // Switch states
+                        state = OBJECT;
+                    }
+                }
+                else if(token.type == TID_RBRACKET)
+                {
+                    // Go up one level if we can
+                    if(parent)
+                        parent = parent->parent;
+
+                    node = createNode(token, CNT_RBRACE, false, source, arena);
+
+                    // Consume all the newlines
+                    i = skipNewlines(i, end);
+
+                    addNode(parent, node, first, last);
+
+                    // Move up another level
+                    if(parent)
+                        parent = parent->parent;
+                }
+                break;
+            case OBJECT:
+                if(token.type == TID_NEWLINE)
+                {
+                    // Look ahead to the next non-newline token and if it isn't an {, this was a property
+                    ScriptTokenViewList::const_iterator next = skipNewlines(i, end);
+                    if(next == end || next->type != TID_LBRACKET)
+                    {
+                        // Ended a property here
+                        if(parent)
+                            parent = parent->parent;
+                        state = READY;
+                    }
+                }
+                else if(token.type == TID_COLON)
+                {
+                    node = createNode(token, CNT_COLON, false, source, arena);
+
+                    // The following token are the parent objects (base classes).
+                    // Require at least one of them.
+                    ScriptTokenViewList::const_iterator j = skipNewlines(i + 1, end);
+                    if(j == end || (j->type != TID_WORD && j->type != TID_QUOTE)) {
+                        OGRE_EXCEPT(Exception::ERR_INVALID_STATE, 
+                            Ogre::String("expected object identifier at line ") + 
+                                    Ogre::StringConverter::toString(node->line),
+                            "ScriptParser::parse");
+                    }
+
+                    while(j != end && (j->type == TID_WORD || j->type == TID_QUOTE))
+                    {
+                        addNode(node, createNode(*j, j->type == TID_WORD ? CNT_WORD : CNT_QUOTE, false, source, arena), first, last);
+                        ++j;
+                    }
+
+                    // Move it backwards once, since the end of the loop moves it forwards again anyway
+                    i = --j;
+
+                    addNode(parent, node, first, last);
+                }
+                else if(token.type == TID_LBRACKET)
+                {
+                    node = createNode(token, CNT_LBRACE, false, source, arena);
+
+                    // Consume all the newlines
+                    i = skipNewlines(i, end);
+
+                    addNode(parent, node, first, last);
+
+                    // Set the parent
+                    parent = node;
+
+                    // Change the state
+                    state = READY;
+                }
+                else if(token.type == TID_RBRACKET)
+                {
+                    // Go up one level if we can
+                    if(parent)
+                        parent = parent->parent;
+
+                    // If the parent is currently a { then go up again
+                    if(parent && parent->type == CNT_LBRACE && parent->parent)
+                        parent = parent->parent;
+
+                    node = createNode(token, CNT_RBRACE, false, source, arena);
+
+                    // Consume all the newlines
+                    i = skipNewlines(i, end);
+
+                    addNode(parent, node, first, last);
+
+                    // Move up another level
+                    if(parent)
+                        parent = parent->parent;
+
+                    state = READY;
+                }
+                else if(token.type == TID_VARIABLE)
+                {
+                    addNode(parent, createNode(token, CNT_VARIABLE, false, source, arena), first, last);
+                }
+                else if(token.type == TID_QUOTE)
+                {
+                    addNode(parent, createNode(token, CNT_QUOTE, true, source, arena), first, last);
+                }
+                else if(token.type == TID_WORD)
+                {
+                    addNode(parent, createNode(token, CNT_WORD, false, source, arena), first, last);
+                }
+                break;
+            }
+
+            ++i;
+        }
+
+        return first;
+    }
+
+    ScriptNodeView *ScriptParser::createNode(const ScriptTokenView &token, ConcreteNodeType type, bool unquote,
+        const String &source, ScriptArena &arena)
+    {
+        ScriptNodeView *node = static_cast<ScriptNodeView*>(arena.allocate(sizeof(ScriptNodeView)));
+        node->token = token.lexeme;
+        node->length = token.length;
+        if(unquote && type == CNT_QUOTE)
+        {
+            node->token += 1;
+            node->length -= 2;
+        }
+        node->line = token.line;
+        node->file = &source;
+        node->type = type;
+        node->parent = 0;
+        node->firstChild = node->lastChild = 0;
+        node->prev = node->next = 0;
+        node->numChildren = 0;
+        return node;
+    }
+
+    void ScriptParser::addNode(ScriptNodeView *parent, ScriptNodeView *node, ScriptNodeView *&first, ScriptNodeView *&last)
+    {
+        ScriptNodeView *&head = parent ? parent->firstChild : first;
+        ScriptNodeView *&tail = parent ? parent->lastChild : last;
+
+        node->parent = parent;
+        node->prev = tail;
+        if(tail)
+            tail->next = node;
+        else
+            head = node;
+        tail = node;
+        if(parent)
+            ++parent->numChildren;
+    }
+
     ScriptToken *ScriptParser::getToken(ScriptTokenList::iterator i, ScriptTokenList::iterator end, int offset)
     {
         ScriptToken *token = 0;
@@ -504,4 +740,12 @@ namespace Ogre
         return i;
     }
 
+    ScriptTokenViewList::const_iterator ScriptParser::skipNewlines(ScriptTokenViewList::const_iterator i,
+        ScriptTokenViewList::const_iterator end)
+    {
+        while(i != end && i->type == TID_NEWLINE)
+            ++i;
+        return i;
+    }
+
 }
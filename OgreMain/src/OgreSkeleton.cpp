@@ -592,13 +592,14 @@ namespace Ogre {
                 of << "  Affects bone: " << static_cast<Bone*>(track->getAssociatedNode())->getHandle() << std::endl;
                 of << "  Number of keyframes: " << track->getNumKeyFrames() << std::endl;
 
+                TransformKeyFrame key(0, 0);
                 for (unsigned short ki = 0; ki < track->getNumKeyFrames(); ++ki)
                 {
-                    TransformKeyFrame* key = track->getNodeKeyFrame(ki);
+                    track->getNodeKeyFrameTransform(ki, &key);
                     of << "    -- KeyFrame " << ki << " --" << std::endl;
-                    of << "    Time index: " << key->getTime(); 
-                    of << "    Translation: " << key->getTranslate() << std::endl;
-                    q = key->getRotation();
+                    of << "    Time index: " << track->getNodeKeyFrameTime(ki); 
+                    of << "    Translation: " << key.getTranslate() << std::endl;
+                    q = key.getRotation();
                     of << "    Rotation: " << q;
                     q.ToAngleAxis(angle, axis);
                     of << " = " << angle.valueRadians() << " radians around axis " << axis << std::endl;
@@ -946,24 +947,19 @@ namespace Ogre {
                     NodeAnimationTrack* dstTrack = dstAnimation->createNodeTrack(dstHandle, this->getBone(dstHandle));
                     dstTrack->setUseShortestRotationPath(srcTrack->getUseShortestRotationPath());
 
+                    // Compressed source tracks are copied decompressed
                     ushort numKeyFrames = srcTrack->getNumKeyFrames();
                     for (ushort k = 0; k < numKeyFrames; ++k)
                     {
-                        const TransformKeyFrame* srcKeyFrame = srcTrack->getNodeKeyFrame(k);
-                        TransformKeyFrame* dstKeyFrame = dstTrack->createNodeKeyFrame(srcKeyFrame->getTime());
+                        TransformKeyFrame* dstKeyFrame = dstTrack->createNodeKeyFrame(srcTrack->getNodeKeyFrameTime(k));
+                        srcTrack->getNodeKeyFrameTransform(k, dstKeyFrame);
 
                         // Adjust keyframes to match target binding pose
-                        if (deltaTransform.isIdentity)
+                        if (!deltaTransform.isIdentity)
                         {
-                            dstKeyFrame->setTranslate(srcKeyFrame->getTranslate());
-                            dstKeyFrame->setRotation(srcKeyFrame->getRotation());
-                            dstKeyFrame->setScale(srcKeyFrame->getScale());
-                        }
-                        else
-                        {
-                            dstKeyFrame->setTranslate(deltaTransform.translate + srcKeyFrame->getTranslate());
-                            dstKeyFrame->setRotation(deltaTransform.rotate * srcKeyFrame->getRotation());
-                            dstKeyFrame->setScale(deltaTransform.scale * srcKeyFrame->getScale());
+                            dstKeyFrame->setTranslate(deltaTransform.translate + dstKeyFrame->getTranslate());
+                            dstKeyFrame->setRotation(deltaTransform.rotate * dstKeyFrame->getRotation());
+                            dstKeyFrame->setScale(deltaTransform.scale * dstKeyFrame->getScale());
                         }
                     }
                 }
@@ -1030,6 +1026,14 @@ namespace Ogre {
         memSize += mLinkedSkeletonAnimSourceList.size() * sizeof(LinkedSkeletonAnimationSource);
         memSize += sizeof(bool);
 
+        // Keyframes, which compression shrinks
+        for (AnimationList::const_iterator i = mAnimationsList.begin(); i != mAnimationsList.end(); ++i)
+        {
+            Animation::NodeTrackIterator it = i->second->getNodeTrackIterator();
+            while (it.hasMoreElements())
+                memSize += it.getNext()->calculateSize();
+        }
+
         return memSize;
     }
 }
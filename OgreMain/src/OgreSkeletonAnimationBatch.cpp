@@ -0,0 +1,810 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "OgreSkeletonAnimationBatch.h"
+#include "OgreEntity.h"
+#include "OgreMesh.h"
+#include "OgreSkeletonInstance.h"
+#include "OgreBone.h"
+#include "OgreAnimation.h"
+#include "OgreKeyFrame.h"
+#include "OgreRoot.h"
+#include "OgreTaskScheduler.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+// Keep this last, see OgreOptimisedUtilSSE.cpp
+#include "OgreSIMDHelper.h"
+#endif
+
+namespace Ogre {
+
+namespace {
+    // Four lanes of Reals, with SSE when available. Masks returned by the
+    // comparisons are only meant for soaSelect and soaAnd.
+#if __OGRE_HAVE_SSE
+    typedef __m128 SoAReal;
+
+    OGRE_FORCE_INLINE SoAReal soaLoad(const Real* p) { return __MM_LOAD_PS(p); }
+    OGRE_FORCE_INLINE void soaStore(Real* p, const SoAReal& v) { __MM_STORE_PS(p, v); }
+    OGRE_FORCE_INLINE SoAReal soaSet(Real r) { return _mm_set_ps1(r); }
+    OGRE_FORCE_INLINE SoAReal soaAdd(const SoAReal& a, const SoAReal& b) { return _mm_add_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaSub(const SoAReal& a, const SoAReal& b) { return _mm_sub_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaMul(const SoAReal& a, const SoAReal& b) { return _mm_mul_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaDiv(const SoAReal& a, const SoAReal& b) { return _mm_div_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaSqrt(const SoAReal& a) { return _mm_sqrt_ps(a); }
+    OGRE_FORCE_INLINE SoAReal soaLess(const SoAReal& a, const SoAReal& b) { return _mm_cmplt_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaEqual(const SoAReal& a, const SoAReal& b) { return _mm_cmpeq_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaNotEqual(const SoAReal& a, const SoAReal& b) { return _mm_cmpneq_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaAnd(const SoAReal& a, const SoAReal& b) { return _mm_and_ps(a, b); }
+    OGRE_FORCE_INLINE SoAReal soaSelect(const SoAReal& mask, const SoAReal& a, const SoAReal& b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+    /// Stores the rows of 4 affine matrices given as rows x columns of lanes
+    OGRE_FORCE_INLINE void soaStoreMatrices(Matrix4* const* dest, SoAReal (&m)[3][4])
+    {
+        for (size_t r = 0; r < 3; ++r)
+        {
+            __MM_TRANSPOSE4x4_PS(m[r][0], m[r][1], m[r][2], m[r][3]);
+            for (size_t l = 0; l < 4; ++l)
+            {
+                if (dest[l])
+                    _mm_storeu_ps((*dest[l])[r], m[r][l]);
+            }
+        }
+    }
+#else
+    struct SoAReal
+    {
+        Real v[4];
+    };
+
+#define OGRE_SOA_LANES(expr) \
+    SoAReal ret; for (size_t l = 0; l < 4; ++l) ret.v[l] = (expr); return ret
+
+    OGRE_FORCE_INLINE SoAReal soaLoad(const Real* p) { OGRE_SOA_LANES(p[l]); }
+    OGRE_FORCE_INLINE void soaStore(Real* p, const SoAReal& v) { for (size_t l = 0; l < 4; ++l) p[l] = v.v[l]; }
+    OGRE_FORCE_INLINE SoAReal soaSet(Real r) { OGRE_SOA_LANES(r); }
+    OGRE_FORCE_INLINE SoAReal soaAdd(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] + b.v[l]); }
+    OGRE_FORCE_INLINE SoAReal soaSub(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] - b.v[l]); }
+    OGRE_FORCE_INLINE SoAReal soaMul(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] * b.v[l]); }
+    OGRE_FORCE_INLINE SoAReal soaDiv(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] / b.v[l]); }
+    OGRE_FORCE_INLINE SoAReal soaSqrt(const SoAReal& a) { OGRE_SOA_LANES(Math::Sqrt(a.v[l])); }
+    OGRE_FORCE_INLINE SoAReal soaLess(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] < b.v[l] ? 1 : 0); }
+    OGRE_FORCE_INLINE SoAReal soaEqual(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] == b.v[l] ? 1 : 0); }
+    OGRE_FORCE_INLINE SoAReal soaNotEqual(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] != b.v[l] ? 1 : 0); }
+    OGRE_FORCE_INLINE SoAReal soaAnd(const SoAReal& a, const SoAReal& b) { OGRE_SOA_LANES(a.v[l] && b.v[l] ? 1 : 0); }
+    OGRE_FORCE_INLINE SoAReal soaSelect(const SoAReal& mask, const SoAReal& a, const SoAReal& b)
+    {
+        OGRE_SOA_LANES(mask.v[l] ? a.v[l] : b.v[l]);
+    }
+#undef OGRE_SOA_LANES
+
+    /// Stores the rows of 4 affine matrices given as rows x columns of lanes
+    OGRE_FORCE_INLINE void soaStoreMatrices(Matrix4* const* dest, SoAReal (&m)[3][4])
+    {
+        for (size_t l = 0; l < 4; ++l)
+        {
+            if (!dest[l])
+                continue;
+            for (size_t r = 0; r < 3; ++r)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                    (*dest[l])[r][c] = m[r][c].v[l];
+            }
+        }
+    }
+#endif
+
+    struct SoAVector3
+    {
+        SoAReal x, y, z;
+    };
+
+    struct SoAQuaternion
+    {
+        SoAReal w, x, y, z;
+    };
+
+    /// Loads 3 consecutive components of a pose, each stride Reals apart
+    OGRE_FORCE_INLINE SoAVector3 soaLoadVector3(const Real* p, size_t stride)
+    {
+        SoAVector3 v = { soaLoad(p), soaLoad(p + stride), soaLoad(p + 2 * stride) };
+        return v;
+    }
+
+    OGRE_FORCE_INLINE void soaStoreVector3(Real* p, size_t stride, const SoAVector3& v)
+    {
+        soaStore(p, v.x);
+        soaStore(p + stride, v.y);
+        soaStore(p + 2 * stride, v.z);
+    }
+
+    OGRE_FORCE_INLINE SoAQuaternion soaLoadQuaternion(const Real* p, size_t stride)
+    {
+        SoAQuaternion q = { soaLoad(p), soaLoad(p + stride), soaLoad(p + 2 * stride), soaLoad(p + 3 * stride) };
+        return q;
+    }
+
+    OGRE_FORCE_INLINE void soaStoreQuaternion(Real* p, size_t stride, const SoAQuaternion& q)
+    {
+        soaStore(p, q.w);
+        soaStore(p + stride, q.x);
+        soaStore(p + 2 * stride, q.y);
+        soaStore(p + 3 * stride, q.z);
+    }
+
+    OGRE_FORCE_INLINE SoAVector3 soaAdd(const SoAVector3& a, const SoAVector3& b)
+    {
+        SoAVector3 v = { soaAdd(a.x, b.x), soaAdd(a.y, b.y), soaAdd(a.z, b.z) };
+        return v;
+    }
+
+    OGRE_FORCE_INLINE SoAVector3 soaMul(const SoAVector3& a, const SoAVector3& b)
+    {
+        SoAVector3 v = { soaMul(a.x, b.x), soaMul(a.y, b.y), soaMul(a.z, b.z) };
+        return v;
+    }
+
+    OGRE_FORCE_INLINE SoAVector3 soaMul(const SoAVector3& a, const SoAReal& s)
+    {
+        SoAVector3 v = { soaMul(a.x, s), soaMul(a.y, s), soaMul(a.z, s) };
+        return v;
+    }
+
+    /// a + (b - a) * t
+    OGRE_FORCE_INLINE SoAVector3 soaLerp(const SoAVector3& a, const SoAVector3& b, const SoAReal& t)
+    {
+        SoAVector3 v = {
+            soaAdd(a.x, soaMul(soaSub(b.x, a.x), t)),
+            soaAdd(a.y, soaMul(soaSub(b.y, a.y), t)),
+            soaAdd(a.z, soaMul(soaSub(b.z, a.z), t)) };
+        return v;
+    }
+
+    OGRE_FORCE_INLINE SoAVector3 soaSelect(const SoAReal& mask, const SoAVector3& a, const SoAVector3& b)
+    {
+        SoAVector3 v = { soaSelect(mask, a.x, b.x), soaSelect(mask, a.y, b.y), soaSelect(mask, a.z, b.z) };
+        return v;
+    }
+
+    OGRE_FORCE_INLINE SoAQuaternion soaSelect(const SoAReal& mask, const SoAQuaternion& a, const SoAQuaternion& b)
+    {
+        SoAQuaternion q = { soaSelect(mask, a.w, b.w), soaSelect(mask, a.x, b.x),
+            soaSelect(mask, a.y, b.y), soaSelect(mask, a.z, b.z) };
+        return q;
+    }
+
+    OGRE_FORCE_INLINE SoAQuaternion soaNegate(const SoAQuaternion& a)
+    {
+        SoAReal zero = soaSet(0);
+        SoAQuaternion q = { soaSub(zero, a.w), soaSub(zero, a.x), soaSub(zero, a.y), soaSub(zero, a.z) };
+        return q;
+    }
+
+    OGRE_FORCE_INLINE SoAReal soaDot(const SoAQuaternion& a, const SoAQuaternion& b)
+    {
+        return soaAdd(soaAdd(soaMul(a.w, b.w), soaMul(a.x, b.x)),
+            soaAdd(soaMul(a.y, b.y), soaMul(a.z, b.z)));
+    }
+
+    /// Same as Quaternion::operator*
+    OGRE_FORCE_INLINE SoAQuaternion soaMul(const SoAQuaternion& a, const SoAQuaternion& b)
+    {
+        SoAQuaternion q = {
+            soaSub(soaSub(soaMul(a.w, b.w), soaMul(a.x, b.x)), soaAdd(soaMul(a.y, b.y), soaMul(a.z, b.z))),
+            soaAdd(soaAdd(soaMul(a.w, b.x), soaMul(a.x, b.w)), soaSub(soaMul(a.y, b.z), soaMul(a.z, b.y))),
+            soaAdd(soaAdd(soaMul(a.w, b.y), soaMul(a.y, b.w)), soaSub(soaMul(a.z, b.x), soaMul(a.x, b.z))),
+            soaAdd(soaAdd(soaMul(a.w, b.z), soaMul(a.z, b.w)), soaSub(soaMul(a.x, b.y), soaMul(a.y, b.x))) };
+        return q;
+    }
+
+    /// Same as Quaternion::normalise
+    OGRE_FORCE_INLINE SoAQuaternion soaNormalise(const SoAQuaternion& a)
+    {
+        SoAReal factor = soaDiv(soaSet(1), soaSqrt(soaDot(a, a)));
+        SoAQuaternion q = { soaMul(a.w, factor), soaMul(a.x, factor), soaMul(a.y, factor), soaMul(a.z, factor) };
+        return q;
+    }
+
+    /// Same as Quaternion::nlerp
+    OGRE_FORCE_INLINE SoAQuaternion soaNlerp(const SoAReal& t, const SoAQuaternion& p,
+        const SoAQuaternion& q, const SoAReal& shortestPath)
+    {
+        SoAReal flip = soaAnd(shortestPath, soaLess(soaDot(p, q), soaSet(0)));
+        SoAQuaternion target = soaSelect(flip, soaNegate(q), q);
+        SoAQuaternion r = {
+            soaAdd(p.w, soaMul(soaSub(target.w, p.w), t)),
+            soaAdd(p.x, soaMul(soaSub(target.x, p.x), t)),
+            soaAdd(p.y, soaMul(soaSub(target.y, p.y), t)),
+            soaAdd(p.z, soaMul(soaSub(target.z, p.z), t)) };
+        return soaNormalise(r);
+    }
+
+    /// Same as Quaternion::operator*(const Vector3&)
+    OGRE_FORCE_INLINE SoAVector3 soaRotate(const SoAQuaternion& q, const SoAVector3& v)
+    {
+        SoAVector3 uv = {
+            soaSub(soaMul(q.y, v.z), soaMul(q.z, v.y)),
+            soaSub(soaMul(q.z, v.x), soaMul(q.x, v.z)),
+            soaSub(soaMul(q.x, v.y), soaMul(q.y, v.x)) };
+        SoAVector3 uuv = {
+            soaSub(soaMul(q.y, uv.z), soaMul(q.z, uv.y)),
+            soaSub(soaMul(q.z, uv.x), soaMul(q.x, uv.z)),
+            soaSub(soaMul(q.x, uv.y), soaMul(q.y, uv.x)) };
+        SoAReal two = soaSet(2);
+        return soaAdd(v, soaAdd(soaMul(uv, soaMul(two, q.w)), soaMul(uuv, two)));
+    }
+
+    /// Writes the default transform to lane l of a pose of 4 lanes
+    void setIdentity(Real* pose, size_t l)
+    {
+        for (size_t c = 0; c < 10; ++c)
+            pose[c * 4 + l] = 0;
+        // PC_ORIENTATION_W and PC_SCALE_*
+        pose[3 * 4 + l] = 1;
+        pose[7 * 4 + l] = pose[8 * 4 + l] = pose[9 * 4 + l] = 1;
+    }
+}
+
+    //---------------------------------------------------------------------
+    /// Evaluates a range of the jobs, with scratch memory of its own
+    struct SkeletonAnimationBatch::EvaluateJobs
+    {
+        const SkeletonAnimationBatch* mBatch;
+
+        EvaluateJobs(const SkeletonAnimationBatch* batch) : mBatch(batch) {}
+
+        void operator()(size_t begin, size_t end) const
+        {
+            size_t size = 2 * PC_COUNT * mBatch->mMaxSlots * sizeof(Real);
+            Real* scratch = static_cast<Real*>(OGRE_MALLOC_SIMD(size, MEMCATEGORY_ANIMATION));
+            for (size_t i = begin; i < end; ++i)
+                mBatch->evaluate(mBatch->mJobs[i], scratch);
+            OGRE_FREE_SIMD(scratch, MEMCATEGORY_ANIMATION);
+        }
+    };
+    //---------------------------------------------------------------------
+    const unsigned short SkeletonAnimationBatch::NO_BONE;
+    //---------------------------------------------------------------------
+    SkeletonAnimationBatch::SkeletonAnimationBatch()
+        : mMaxSlots(0)
+    {
+    }
+    //---------------------------------------------------------------------
+    SkeletonAnimationBatch::~SkeletonAnimationBatch()
+    {
+        for (vector<Layout>::type::iterator i = mLayouts.begin(); i != mLayouts.end(); ++i)
+            OGRE_FREE_SIMD(i->mData, MEMCATEGORY_ANIMATION);
+    }
+    //---------------------------------------------------------------------
+    void SkeletonAnimationBatch::clearFrame(void)
+    {
+        // Animations may be removed from a skeleton between frames
+        mAnimations.clear();
+        mAnimationIndices.clear();
+        mTracks.clear();
+        mLayers.clear();
+        mJobs.clear();
+    }
+    //---------------------------------------------------------------------
+    bool SkeletonAnimationBatch::isEntitySupported(const Entity* entity)
+    {
+#if OGRE_NODE_INHERIT_TRANSFORM
+        return false;
+#else
+        return entity->mInitialised && entity->mSkeletonInstance &&
+            !entity->mSkipAnimStateUpdates && !entity->mSkeletonInstance->hasManualBones();
+#endif
+    }
+    //---------------------------------------------------------------------
+    bool SkeletonAnimationBatch::isAnimationSupported(const Animation* anim)
+    {
+        if (anim->getInterpolationMode() != Animation::IM_LINEAR)
+            return false;
+
+        const Animation::NodeTrackList& tracks = anim->_getNodeTrackList();
+        for (Animation::NodeTrackList::const_iterator i = tracks.begin(); i != tracks.end(); ++i)
+        {
+            if (i->second->getListener())
+                return false;
+        }
+        return true;
+    }
+    //---------------------------------------------------------------------
+    bool SkeletonAnimationBatch::isSupported(const Entity* entity)
+    {
+        if (!isEntitySupported(entity))
+            return false;
+
+        EnabledAnimationStateList::const_iterator i;
+        const EnabledAnimationStateList& states = entity->mAnimationState->getEnabledAnimationStates();
+        for (i = states.begin(); i != states.end(); ++i)
+        {
+            const Animation* anim = entity->mSkeletonInstance->_getAnimationImpl((*i)->getAnimationName());
+            if (anim && !isAnimationSupported(anim))
+                return false;
+        }
+        return true;
+    }
+    //---------------------------------------------------------------------
+    size_t SkeletonAnimationBatch::getLayout(Entity* entity)
+    {
+        // Instances of the same skeleton have the same bones
+        const Skeleton* master = entity->getMesh()->getSkeleton().get();
+        map<const Skeleton*, size_t>::type::iterator it = mLayoutIndices.find(master);
+        if (it != mLayoutIndices.end())
+        {
+            // Another skeleton may have been created at the same address, or
+            // this one reloaded, since the layout was built
+            Layout& layout = mLayouts[it->second];
+            if (layout.mSkeletonHandle != master->getHandle() ||
+                layout.mSkeletonStateCount != master->getStateCount() ||
+                layout.mSlots.size() != entity->mSkeletonInstance->getNumBones())
+            {
+                OGRE_FREE_SIMD(layout.mData, MEMCATEGORY_ANIMATION);
+                buildLayout(layout, master, entity->mSkeletonInstance);
+            }
+            return it->second;
+        }
+
+        mLayouts.push_back(Layout());
+        buildLayout(mLayouts.back(), master, entity->mSkeletonInstance);
+        mLayoutIndices[master] = mLayouts.size() - 1;
+        return mLayouts.size() - 1;
+    }
+    //---------------------------------------------------------------------
+    void SkeletonAnimationBatch::buildLayout(Layout& layout, const Skeleton* master,
+        SkeletonInstance* skel)
+    {
+        unsigned short numBones = skel->getNumBones();
+
+        // Sort the bones by depth, keeping the handle order within a depth
+        typedef std::pair<size_t, unsigned short> DepthHandle;
+        vector<DepthHandle>::type order;
+        order.reserve(numBones);
+        for (unsigned short h = 0; h < numBones; ++h)
+        {
+            size_t depth = 0;
+            for (Node* n = skel->getBone(h)->getParent(); n; n = n->getParent())
+                ++depth;
+            order.push_back(DepthHandle(depth, h));
+        }
+        std::sort(order.begin(), order.end());
+
+        layout.mSkeletonHandle = master->getHandle();
+        layout.mSkeletonStateCount = master->getStateCount();
+        layout.mSlots.assign(numBones, 0);
+        // The first block is the identity parent of the roots
+        layout.mHandles.assign(4, NO_BONE);
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            // Start each depth on a new block
+            if (i > 0 && order[i].first != order[i - 1].first)
+                layout.mHandles.resize((layout.mHandles.size() + 3) & ~size_t(3), NO_BONE);
+            layout.mSlots[order[i].second] = static_cast<unsigned short>(layout.mHandles.size());
+            layout.mHandles.push_back(order[i].second);
+        }
+        layout.mHandles.resize((layout.mHandles.size() + 3) & ~size_t(3), NO_BONE);
+        layout.mNumSlots = layout.mHandles.size();
+        layout.mParents.assign(layout.mNumSlots, 0);
+
+        size_t n = layout.mNumSlots;
+        layout.mData = static_cast<Real*>(OGRE_MALLOC_SIMD(
+            (2 * PC_COUNT + 2) * n * sizeof(Real), MEMCATEGORY_ANIMATION));
+        Real* initial = layout.getInitialPose();
+        Real* bindInverse = layout.getBindPoseInverse();
+        Real* inheritOrientation = layout.getInheritOrientation();
+        Real* inheritScale = layout.getInheritScale();
+        for (size_t s = 0; s < n; ++s)
+        {
+            Vector3 position = Vector3::ZERO, scale = Vector3::UNIT_SCALE;
+            Vector3 bindPosition = Vector3::ZERO, bindScale = Vector3::UNIT_SCALE;
+            Quaternion orientation = Quaternion::IDENTITY, bindOrientation = Quaternion::IDENTITY;
+            inheritOrientation[s] = inheritScale[s] = 0;
+
+            if (layout.mHandles[s] != NO_BONE)
+            {
+                Bone* bone = skel->getBone(layout.mHandles[s]);
+                position = bone->getInitialPosition();
+                orientation = bone->getInitialOrientation();
+                scale = bone->getInitialScale();
+                bindPosition = bone->_getBindingPoseInversePosition();
+                bindOrientation = bone->_getBindingPoseInverseOrientation();
+                bindScale = bone->_getBindingPoseInverseScale();
+                inheritOrientation[s] = bone->getInheritOrientation() ? 1 : 0;
+                inheritScale[s] = bone->getInheritScale() ? 1 : 0;
+                if (bone->getParent())
+                    layout.mParents[s] = layout.mSlots[static_cast<Bone*>(bone->getParent())->getHandle()];
+            }
+
+            initial[PC_POSITION_X * n + s] = position.x;
+            initial[PC_POSITION_Y * n + s] = position.y;
+            initial[PC_POSITION_Z * n + s] = position.z;
+            initial[PC_ORIENTATION_W * n + s] = orientation.w;
+            initial[PC_ORIENTATION_X * n + s] = orientation.x;
+            initial[PC_ORIENTATION_Y * n + s] = orientation.y;
+            initial[PC_ORIENTATION_Z * n + s] = orientation.z;
+            initial[PC_SCALE_X * n + s] = scale.x;
+            initial[PC_SCALE_Y * n + s] = scale.y;
+            initial[PC_SCALE_Z * n + s] = scale.z;
+
+            bindInverse[PC_POSITION_X * n + s] = bindPosition.x;
+            bindInverse[PC_POSITION_Y * n + s] = bindPosition.y;
+            bindInverse[PC_POSITION_Z * n + s] = bindPosition.z;
+            bindInverse[PC_ORIENTATION_W * n + s] = bindOrientation.w;
+            bindInverse[PC_ORIENTATION_X * n + s] = bindOrientation.x;
+            bindInverse[PC_ORIENTATION_Y * n + s] = bindOrientation.y;
+            bindInverse[PC_ORIENTATION_Z * n + s] = bindOrientation.z;
+            bindInverse[PC_SCALE_X * n + s] = bindScale.x;
+            bindInverse[PC_SCALE_Y * n + s] = bindScale.y;
+            bindInverse[PC_SCALE_Z * n + s] = bindScale.z;
+        }
+
+        mMaxSlots = std::max(mMaxSlots, n);
+    }
+    //---------------------------------------------------------------------
+    size_t SkeletonAnimationBatch::getAnimation(Animation* anim)
+    {
+        map<const Animation*, size_t>::type::iterator it = mAnimationIndices.find(anim);
+        if (it != mAnimationIndices.end())
+            return it->second;
+
+        AnimationInfo info;
+        info.mAnimation = anim;
+        info.mSupported = isAnimationSupported(anim);
+        info.mSpherical = anim->getRotationInterpolationMode() == Animation::RIM_SPHERICAL;
+        info.mTrackBegin = mTracks.size();
+        if (info.mSupported)
+        {
+            // Same as Animation::apply does, done here as it's not thread safe
+            anim->_applyBaseKeyFrame();
+
+            const Animation::NodeTrackList& tracks = anim->_getNodeTrackList();
+            for (Animation::NodeTrackList::const_iterator i = tracks.begin(); i != tracks.end(); ++i)
+            {
+                if (i->second->getNumKeyFrames())
+                    mTracks.push_back(i->second);
+            }
+        }
+        info.mTrackEnd = mTracks.size();
+
+        mAnimations.push_back(info);
+        mAnimationIndices[anim] = mAnimations.size() - 1;
+        return mAnimations.size() - 1;
+    }
+    //---------------------------------------------------------------------
+    bool SkeletonAnimationBatch::addJob(Entity* entity)
+    {
+        if (!isEntitySupported(entity))
+            return false;
+
+        // Same conditions as Entity::updateAnimation and Entity::cacheBoneMatrices,
+        // plus whether an earlier batch already did this animation state while the
+        // entity wasn't rendered, leaving mFrameAnimationLastUpdated behind
+        unsigned long frameNumber = Root::getSingleton().getNextFrameNumber();
+        unsigned long dirtyFrame = entity->mAnimationState->getDirtyFrameNumber();
+        if (*entity->mFrameBonesLastUpdated == frameNumber ||
+            entity->mFrameAnimationLastUpdated == dirtyFrame ||
+            entity->mFrameAnimationLastBatched == dirtyFrame)
+        {
+            return false;
+        }
+
+        // Same weights as Skeleton::setAnimationState
+        SkeletonInstance* skel = entity->mSkeletonInstance;
+        const EnabledAnimationStateList& states = entity->mAnimationState->getEnabledAnimationStates();
+        EnabledAnimationStateList::const_iterator i;
+        Real weightFactor = 1.0f;
+        if (skel->getBlendMode() == ANIMBLEND_AVERAGE)
+        {
+            Real totalWeights = 0.0f;
+            for (i = states.begin(); i != states.end(); ++i)
+            {
+                if (skel->_getAnimationImpl((*i)->getAnimationName()))
+                    totalWeights += (*i)->getWeight();
+            }
+            if (totalWeights > 1.0f)
+                weightFactor = 1.0f / totalWeights;
+        }
+
+        Job job;
+        job.mEntity = entity;
+        job.mLayerBegin = mLayers.size();
+        for (i = states.begin(); i != states.end(); ++i)
+        {
+            const AnimationState* state = *i;
+            const LinkedSkeletonAnimationSource* linked = 0;
+            Animation* anim = skel->_getAnimationImpl(state->getAnimationName(), &linked);
+            if (!anim)
+                continue;
+
+            size_t animIndex = getAnimation(anim);
+            if (!mAnimations[animIndex].mSupported)
+            {
+                mLayers.erase(mLayers.begin() + job.mLayerBegin, mLayers.end());
+                return false;
+            }
+
+            // Builds the keyframe time list on first use, so not thread safe either
+            Layer layer(anim->_getTimeIndex(state->getTimePosition()));
+            layer.mAnimationIndex = animIndex;
+            layer.mWeight = state->getWeight() * weightFactor;
+            layer.mScale = linked ? linked->scale : 1.0f;
+            layer.mBlendMask = state->hasBlendMask() ? state->getBlendMask() : 0;
+            if (layer.mWeight)
+                mLayers.push_back(layer);
+        }
+        job.mLayerEnd = mLayers.size();
+        job.mLayoutIndex = getLayout(entity);
+        mJobs.push_back(job);
+
+        // Also keeps entities sharing the skeleton instance from adding it again.
+        // mFrameAnimationLastUpdated is left to updateAnimation, which still has
+        // to blend the vertices and update the child objects.
+        *entity->mFrameBonesLastUpdated = frameNumber;
+        entity->mFrameAnimationLastBatched = dirtyFrame;
+        return true;
+    }
+    //---------------------------------------------------------------------
+    size_t SkeletonAnimationBatch::update(Entity* const* entities, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            addJob(entities[i]);
+
+        size_t numJobs = mJobs.size();
+        if (numJobs)
+            parallelFor(0, numJobs, 4, EvaluateJobs(this), "SkeletonAnimationBatch");
+
+        clearFrame();
+        return numJobs;
+    }
+    //---------------------------------------------------------------------
+    void SkeletonAnimationBatch::applyTracks(const Layer& layer, const Layout& layout,
+        size_t begin, size_t end, Real* pose) const
+    {
+        const AnimationInfo& info = mAnimations[layer.mAnimationIndex];
+        size_t n = layout.mNumSlots;
+
+        // Gather the keyframes and current transforms of the bones, 4 at a time
+        OGRE_SIMD_ALIGNED_DECL(Real, key1[PC_COUNT * 4]);
+        OGRE_SIMD_ALIGNED_DECL(Real, key2[PC_COUNT * 4]);
+        OGRE_SIMD_ALIGNED_DECL(Real, current[PC_COUNT * 4]);
+        // Keyframe interpolation factor, weight and shortest rotation path flag
+        OGRE_SIMD_ALIGNED_DECL(Real, params[3 * 4]);
+        size_t slots[4];
+        size_t numLanes = 0;
+        TransformKeyFrame k1(0, 0), k2(0, 0);
+        for (size_t i = begin; i < end; ++i)
+        {
+            const NodeAnimationTrack* track = mTracks[i];
+            unsigned short handle = track->getHandle();
+            if (handle >= layout.mSlots.size())
+                continue;
+            Real weight = layer.mWeight;
+            if (layer.mBlendMask)
+                weight *= (*layer.mBlendMask)[handle];
+            if (!weight)
+                continue;
+
+            size_t l = numLanes++;
+            // Copies, so that compressed tracks are decoded too
+            Real t = track->getKeyFrameTransformsAtTime(layer.mTimeIndex, &k1, &k2);
+            bool shortestPath = track->getUseShortestRotationPath();
+
+            const Vector3* vectors[4] = { &k1.getTranslate(), &k1.getScale(), &k2.getTranslate(), &k2.getScale() };
+            for (size_t c = 0; c < 3; ++c)
+            {
+                key1[(PC_POSITION_X + c) * 4 + l] = (*vectors[0])[c];
+                key1[(PC_SCALE_X + c) * 4 + l] = (*vectors[1])[c];
+                key2[(PC_POSITION_X + c) * 4 + l] = (*vectors[2])[c];
+                key2[(PC_SCALE_X + c) * 4 + l] = (*vectors[3])[c];
+            }
+            Quaternion q1 = k1.getRotation(), q2 = k2.getRotation();
+            if (info.mSpherical)
+            {
+                // No SIMD slerp, store the final rotation of the bone in key1
+                Quaternion key = t == 0 ? q1 : Quaternion::Slerp(t, q1, q2, shortestPath);
+                q1 = Quaternion::Slerp(weight, Quaternion::IDENTITY, key, shortestPath);
+            }
+            for (size_t c = 0; c < 4; ++c)
+            {
+                key1[(PC_ORIENTATION_W + c) * 4 + l] = q1[c];
+                key2[(PC_ORIENTATION_W + c) * 4 + l] = q2[c];
+            }
+
+            params[l] = t;
+            params[4 + l] = weight;
+            params[8 + l] = shortestPath ? 1 : 0;
+
+            slots[l] = layout.mSlots[handle];
+            for (size_t c = 0; c < PC_COUNT; ++c)
+                current[c * 4 + l] = pose[c * n + slots[l]];
+        }
+        if (!numLanes)
+            return;
+        for (size_t l = numLanes; l < 4; ++l)
+        {
+            setIdentity(key1, l);
+            setIdentity(key2, l);
+            setIdentity(current, l);
+            params[l] = params[4 + l] = params[8 + l] = 0;
+        }
+
+        // Same as NodeAnimationTrack::getInterpolatedKeyFrame and applyToNode
+        SoAReal t = soaLoad(params);
+        SoAReal weight = soaLoad(params + 4);
+        SoAReal shortestPath = soaNotEqual(soaLoad(params + 8), soaSet(0));
+        SoAReal one = soaSet(1);
+
+        SoAVector3 translate = soaLerp(soaLoadVector3(key1 + PC_POSITION_X * 4, 4),
+            soaLoadVector3(key2 + PC_POSITION_X * 4, 4), t);
+        SoAVector3 position = soaAdd(soaLoadVector3(current + PC_POSITION_X * 4, 4),
+            soaMul(translate, soaMul(weight, soaSet(layer.mScale))));
+        soaStoreVector3(current + PC_POSITION_X * 4, 4, position);
+
+        SoAQuaternion rotate = soaLoadQuaternion(key1 + PC_ORIENTATION_W * 4, 4);
+        if (!info.mSpherical)
+        {
+            SoAQuaternion key = soaNlerp(t, rotate, soaLoadQuaternion(key2 + PC_ORIENTATION_W * 4, 4), shortestPath);
+            key = soaSelect(soaEqual(t, soaSet(0)), rotate, key);
+            SoAQuaternion identity = { one, soaSet(0), soaSet(0), soaSet(0) };
+            rotate = soaNlerp(weight, identity, key, shortestPath);
+        }
+        SoAQuaternion orientation = soaNormalise(
+            soaMul(soaLoadQuaternion(current + PC_ORIENTATION_W * 4, 4), rotate));
+        soaStoreQuaternion(current + PC_ORIENTATION_W * 4, 4, orientation);
+
+        // Scale unit based, by the linked skeleton scale if any, else the weight
+        SoAVector3 keyScale = soaLerp(soaLoadVector3(key1 + PC_SCALE_X * 4, 4),
+            soaLoadVector3(key2 + PC_SCALE_X * 4, 4), t);
+        SoAReal factor = layer.mScale != 1.0f ? soaSet(layer.mScale) : weight;
+        SoAVector3 unit = { one, one, one };
+        SoAVector3 unitBased = {
+            soaSub(keyScale.x, one), soaSub(keyScale.y, one), soaSub(keyScale.z, one) };
+        SoAVector3 scale = soaMul(soaLoadVector3(current + PC_SCALE_X * 4, 4),
+            soaAdd(unit, soaMul(unitBased, factor)));
+        soaStoreVector3(current + PC_SCALE_X * 4, 4, scale);
+
+        // Each track animates a different bone, so the lanes never collide
+        for (size_t l = 0; l < numLanes; ++l)
+        {
+            for (size_t c = 0; c < PC_COUNT; ++c)
+                pose[c * n + slots[l]] = current[c * 4 + l];
+        }
+    }
+    //---------------------------------------------------------------------
+    void SkeletonAnimationBatch::evaluate(const Job& job, Real* scratch) const
+    {
+        const Layout& layout = mLayouts[job.mLayoutIndex];
+        size_t n = layout.mNumSlots;
+        Real* pose = scratch;
+        Real* derived = scratch + PC_COUNT * n;
+
+        // Reset, see Skeleton::reset
+        memcpy(pose, layout.getInitialPose(), PC_COUNT * n * sizeof(Real));
+
+        for (size_t i = job.mLayerBegin; i != job.mLayerEnd; ++i)
+        {
+            const Layer& layer = mLayers[i];
+            const AnimationInfo& info = mAnimations[layer.mAnimationIndex];
+            for (size_t t = info.mTrackBegin; t < info.mTrackEnd; t += 4)
+                applyTracks(layer, layout, t, std::min(t + 4, info.mTrackEnd), pose);
+        }
+
+        // Hand the pose to the bones, which derive their transforms again on demand
+        SkeletonInstance* skel = job.mEntity->mSkeletonInstance;
+        for (size_t s = 4; s < n; ++s)
+        {
+            if (layout.mHandles[s] == NO_BONE)
+                continue;
+            Bone* bone = skel->getBone(layout.mHandles[s]);
+            bone->setPosition(pose[PC_POSITION_X * n + s], pose[PC_POSITION_Y * n + s],
+                pose[PC_POSITION_Z * n + s]);
+            bone->setOrientation(pose[PC_ORIENTATION_W * n + s], pose[PC_ORIENTATION_X * n + s],
+                pose[PC_ORIENTATION_Y * n + s], pose[PC_ORIENTATION_Z * n + s]);
+            bone->setScale(pose[PC_SCALE_X * n + s], pose[PC_SCALE_Y * n + s],
+                pose[PC_SCALE_Z * n + s]);
+        }
+
+        // Derive the transforms block by block, see Node::updateFromParentImpl
+        for (size_t c = 0; c < PC_COUNT; ++c)
+            memcpy(derived + c * n, pose + c * n, 4 * sizeof(Real));
+        const Real* inheritOrientation = layout.getInheritOrientation();
+        const Real* inheritScale = layout.getInheritScale();
+        OGRE_SIMD_ALIGNED_DECL(Real, parent[PC_COUNT * 4]);
+        for (size_t b = 4; b < n; b += 4)
+        {
+            for (size_t l = 0; l < 4; ++l)
+            {
+                size_t p = layout.mParents[b + l];
+                for (size_t c = 0; c < PC_COUNT; ++c)
+                    parent[c * 4 + l] = derived[c * n + p];
+            }
+            SoAVector3 parentPosition = soaLoadVector3(parent + PC_POSITION_X * 4, 4);
+            SoAQuaternion parentOrientation = soaLoadQuaternion(parent + PC_ORIENTATION_W * 4, 4);
+            SoAVector3 parentScale = soaLoadVector3(parent + PC_SCALE_X * 4, 4);
+
+            SoAVector3 position = soaLoadVector3(pose + PC_POSITION_X * n + b, n);
+            SoAQuaternion orientation = soaLoadQuaternion(pose + PC_ORIENTATION_W * n + b, n);
+            SoAVector3 scale = soaLoadVector3(pose + PC_SCALE_X * n + b, n);
+
+            SoAReal zero = soaSet(0);
+            soaStoreQuaternion(derived + PC_ORIENTATION_W * n + b, n,
+                soaSelect(soaNotEqual(soaLoad(inheritOrientation + b), zero),
+                    soaMul(parentOrientation, orientation), orientation));
+            soaStoreVector3(derived + PC_SCALE_X * n + b, n,
+                soaSelect(soaNotEqual(soaLoad(inheritScale + b), zero),
+                    soaMul(parentScale, scale), scale));
+            soaStoreVector3(derived + PC_POSITION_X * n + b, n,
+                soaAdd(soaRotate(parentOrientation, soaMul(parentScale, position)), parentPosition));
+        }
+
+        // Offset matrices straight into the entity's buffer, see Bone::_getOffsetTransform
+        Matrix4* matrices = job.mEntity->mBoneMatrices;
+        const Real* bindInverse = layout.getBindPoseInverse();
+        for (size_t b = 4; b < n; b += 4)
+        {
+            SoAVector3 scale = soaMul(soaLoadVector3(derived + PC_SCALE_X * n + b, n),
+                soaLoadVector3(bindInverse + PC_SCALE_X * n + b, n));
+            SoAQuaternion rotate = soaMul(soaLoadQuaternion(derived + PC_ORIENTATION_W * n + b, n),
+                soaLoadQuaternion(bindInverse + PC_ORIENTATION_W * n + b, n));
+            SoAVector3 translate = soaAdd(soaLoadVector3(derived + PC_POSITION_X * n + b, n),
+                soaRotate(rotate, soaMul(scale, soaLoadVector3(bindInverse + PC_POSITION_X * n + b, n))));
+
+            // Same as Quaternion::ToRotationMatrix, then Matrix4::makeTransform
+            SoAReal two = soaSet(2), one = soaSet(1);
+            SoAReal tx = soaMul(rotate.x, two), ty = soaMul(rotate.y, two), tz = soaMul(rotate.z, two);
+            SoAReal twx = soaMul(tx, rotate.w), twy = soaMul(ty, rotate.w), twz = soaMul(tz, rotate.w);
+            SoAReal txx = soaMul(tx, rotate.x), txy = soaMul(ty, rotate.x), txz = soaMul(tz, rotate.x);
+            SoAReal tyy = soaMul(ty, rotate.y), tyz = soaMul(tz, rotate.y), tzz = soaMul(tz, rotate.z);
+
+            SoAReal m[3][4] = {
+                { soaMul(soaSub(one, soaAdd(tyy, tzz)), scale.x), soaMul(soaSub(txy, twz), scale.y),
+                  soaMul(soaAdd(txz, twy), scale.z), translate.x },
+                { soaMul(soaAdd(txy, twz), scale.x), soaMul(soaSub(one, soaAdd(txx, tzz)), scale.y),
+                  soaMul(soaSub(tyz, twx), scale.z), translate.y },
+                { soaMul(soaSub(txz, twy), scale.x), soaMul(soaAdd(tyz, twx), scale.y),
+                  soaMul(soaSub(one, soaAdd(txx, tyy)), scale.z), translate.z } };
+
+            Matrix4* dest[4];
+            for (size_t l = 0; l < 4; ++l)
+            {
+                unsigned short handle = layout.mHandles[b + l];
+                dest[l] = handle == NO_BONE ? 0 : matrices + handle;
+                if (dest[l])
+                {
+                    (*dest[l])[3][0] = (*dest[l])[3][1] = (*dest[l])[3][2] = 0;
+                    (*dest[l])[3][3] = 1;
+                }
+            }
+            soaStoreMatrices(dest, m);
+        }
+    }
+}
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "OgreAnimation.h"
 #include "OgreAnimationTrack.h"
 #include "OgreKeyFrame.h"
+#include "OgreCompressedTransformKeyFrames.h"
 #include "OgreBone.h"
 #include "OgreLogManager.h"
 
@@ -41,6 +42,21 @@ namespace Ogre {
     const long SSTREAM_OVERHEAD_SIZE = sizeof(uint16) + sizeof(uint32);
     const uint16 HEADER_STREAM_ID_EXT = 0x1000;
     //---------------------------------------------------------------------
+    /// Whether any node track of the skeleton's animations is compressed
+    static bool hasCompressedTracks(const Skeleton* pSkeleton)
+    {
+        for (unsigned short i = 0; i < pSkeleton->getNumAnimations(); ++i)
+        {
+            Animation::NodeTrackIterator trackIt = pSkeleton->getAnimation(i)->getNodeTrackIterator();
+            while (trackIt.hasMoreElements())
+            {
+                if (trackIt.getNext()->isCompressed())
+                    return true;
+            }
+        }
+        return false;
+    }
+    //---------------------------------------------------------------------
     SkeletonSerializer::SkeletonSerializer()
     {
         // Version number
@@ -64,6 +80,9 @@ namespace Ogre {
     void SkeletonSerializer::exportSkeleton(const Skeleton* pSkeleton, 
         DataStreamPtr stream, SkeletonVersion ver, Endian endianMode)
     {
+        // 1.10 only adds compressed tracks, without any older runtimes can still read the file
+        if ((int)ver >= (int)SKELETON_VERSION_1_10 && !hasCompressedTracks(pSkeleton))
+            ver = SKELETON_VERSION_1_8;
         setWorkingVersion(ver);
         // Decide on endian mode
         determineEndianness(endianMode);
@@ -161,7 +180,9 @@ namespace Ogre {
     {
         if (ver == SKELETON_VERSION_1_0)
             mVersion = "[Serializer_v1.10]";
-        else mVersion = "[Serializer_v1.80]";
+        else if (ver == SKELETON_VERSION_1_8)
+            mVersion = "[Serializer_v1.80]";
+        else mVersion = "[Serializer_v1.100]";
     }
     //---------------------------------------------------------------------
     void SkeletonSerializer::writeSkeleton(const Skeleton* pSkel, SkeletonVersion ver)
@@ -269,7 +290,7 @@ namespace Ogre {
         Animation::NodeTrackIterator trackIt = anim->getNodeTrackIterator();
         while(trackIt.hasMoreElements())
         {
-            writeAnimationTrack(pSkel, trackIt.getNext());
+            writeAnimationTrack(pSkel, trackIt.getNext(), ver);
         }
         }
         popInnerChunk(mStream);
@@ -277,19 +298,28 @@ namespace Ogre {
     }
     //---------------------------------------------------------------------
     void SkeletonSerializer::writeAnimationTrack(const Skeleton* pSkel, 
-        const NodeAnimationTrack* track)
+        const NodeAnimationTrack* track, SkeletonVersion ver)
     {
-        writeChunkHeader(SKELETON_ANIMATION_TRACK, calcAnimationTrackSize(pSkel, track));
+        writeChunkHeader(SKELETON_ANIMATION_TRACK, calcAnimationTrackSize(pSkel, track, ver));
 
         // unsigned short boneIndex     : Index of bone to apply to
         Bone* bone = static_cast<Bone*>(track->getAssociatedNode());
         unsigned short boneid = bone->getHandle();
         writeShorts(&boneid, 1);
         pushInnerChunk(mStream);
-        // Write all keyframes
-        for (unsigned short i = 0; i < track->getNumKeyFrames(); ++i)
+        if (track->isCompressed() && (int)ver >= (int)SKELETON_VERSION_1_10)
+        {
+            writeCompressedKeyFrames(track->getCompressedKeyFrames());
+        }
+        else
         {
-            writeKeyFrame(pSkel, track->getNodeKeyFrame(i));
+            // Write all keyframes, decoding compressed ones for older versions
+            for (unsigned short i = 0; i < track->getNumKeyFrames(); ++i)
+            {
+                TransformKeyFrame key(0, track->getNodeKeyFrameTime(i));
+                track->getNodeKeyFrameTransform(i, &key);
+                writeKeyFrame(pSkel, &key);
+            }
         }
         popInnerChunk(mStream);
     }
@@ -314,6 +344,48 @@ namespace Ogre {
         }
     }
     //---------------------------------------------------------------------
+    void SkeletonSerializer::writeCompressedKeyFrames(const CompressedTransformKeyFrames* keyFrames)
+    {
+        writeChunkHeader(SKELETON_ANIMATION_TRACK_COMPRESSED, calcCompressedKeyFramesSize(keyFrames));
+
+        // unsigned short numKeyFrames
+        uint16 numKeyFrames = keyFrames->mNumKeyFrames;
+        writeShorts(&numKeyFrames, 1);
+        // unsigned short modes[3]
+        uint16 modes[CompressedTransformKeyFrames::CH_COUNT];
+        for (size_t c = 0; c < CompressedTransformKeyFrames::CH_COUNT; ++c)
+            modes[c] = keyFrames->mModes[c];
+        writeShorts(modes, CompressedTransformKeyFrames::CH_COUNT);
+        // float times[numKeyFrames]
+        writeFloats(keyFrames->mTimes, numKeyFrames);
+
+        const Vector3* bases[] = { &keyFrames->mTranslateBase, 0, &keyFrames->mScaleBase };
+        const Vector3* steps[] = { &keyFrames->mTranslateStep, 0, &keyFrames->mScaleStep };
+        for (size_t c = 0; c < CompressedTransformKeyFrames::CH_COUNT; ++c)
+        {
+            switch (modes[c])
+            {
+            case CompressedTransformKeyFrames::CM_CONSTANT:
+                if (bases[c])
+                    writeObject(*bases[c]);
+                else
+                    writeObject(keyFrames->mRotation);
+                break;
+            case CompressedTransformKeyFrames::CM_QUANTISED:
+                if (bases[c])
+                {
+                    writeObject(*bases[c]);
+                    writeObject(*steps[c]);
+                }
+                writeShorts(keyFrames->mQuantised[c], 3 * numKeyFrames);
+                break;
+            case CompressedTransformKeyFrames::CM_FULL:
+                writeFloats(keyFrames->mFull[c], 3 * numKeyFrames);
+                break;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
     size_t SkeletonSerializer::calcBoneSize(const Skeleton* pSkel, 
         const Bone* pBone)
     {
@@ -387,24 +459,31 @@ namespace Ogre {
         Animation::NodeTrackIterator trackIt = pAnim->getNodeTrackIterator();
         while(trackIt.hasMoreElements())
         {
-            size += calcAnimationTrackSize(pSkel, trackIt.getNext());
+            size += calcAnimationTrackSize(pSkel, trackIt.getNext(), ver);
         }
 
         return size;
     }
     //---------------------------------------------------------------------
     size_t SkeletonSerializer::calcAnimationTrackSize(const Skeleton* pSkel, 
-        const NodeAnimationTrack* pTrack)
+        const NodeAnimationTrack* pTrack, SkeletonVersion ver)
     {
         size_t size = SSTREAM_OVERHEAD_SIZE;
 
         // unsigned short boneIndex     : Index of bone to apply to
         size += sizeof(unsigned short);
 
+        if (pTrack->isCompressed() && (int)ver >= (int)SKELETON_VERSION_1_10)
+        {
+            return size + calcCompressedKeyFramesSize(pTrack->getCompressedKeyFrames());
+        }
+
         // Nested keyframes
+        TransformKeyFrame key(0, 0);
         for (unsigned short i = 0; i < pTrack->getNumKeyFrames(); ++i)
         {
-            size += calcKeyFrameSize(pSkel, pTrack->getNodeKeyFrame(i));
+            pTrack->getNodeKeyFrameTransform(i, &key);
+            size += calcKeyFrameSize(pSkel, &key);
         }
 
         return size;
@@ -439,6 +518,42 @@ namespace Ogre {
         return size;
     }
     //---------------------------------------------------------------------
+    size_t SkeletonSerializer::calcCompressedKeyFramesSize(const CompressedTransformKeyFrames* pKeyFrames)
+    {
+        size_t size = SSTREAM_OVERHEAD_SIZE;
+        size_t numKeyFrames = pKeyFrames->getNumKeyFrames();
+
+        // unsigned short numKeyFrames
+        size += sizeof(uint16);
+        // unsigned short modes[3]
+        size += sizeof(uint16) * CompressedTransformKeyFrames::CH_COUNT;
+        // float times[numKeyFrames]
+        size += sizeof(float) * numKeyFrames;
+
+        for (size_t c = 0; c < CompressedTransformKeyFrames::CH_COUNT; ++c)
+        {
+            bool rotation = c == CompressedTransformKeyFrames::CH_ROTATION;
+            switch (pKeyFrames->getChannelMode(static_cast<CompressedTransformKeyFrames::Channel>(c)))
+            {
+            case CompressedTransformKeyFrames::CM_CONSTANT:
+                size += sizeof(float) * (rotation ? 4 : 3);
+                break;
+            case CompressedTransformKeyFrames::CM_QUANTISED:
+                if (!rotation)
+                    size += sizeof(float) * 6;
+                size += sizeof(uint16) * 3 * numKeyFrames;
+                break;
+            case CompressedTransformKeyFrames::CM_FULL:
+                size += sizeof(float) * 3 * numKeyFrames;
+                break;
+            default:
+                break;
+            }
+        }
+
+        return size;
+    }
+    //---------------------------------------------------------------------
     void SkeletonSerializer::readFileHeader(DataStreamPtr& stream)
     {
         unsigned short headerID;
@@ -451,7 +566,8 @@ namespace Ogre {
             // Read version
             String ver = readString(stream);
             if ((ver != "[Serializer_v1.10]") &&
-                (ver != "[Serializer_v1.80]"))
+                (ver != "[Serializer_v1.80]") &&
+                (ver != "[Serializer_v1.100]"))
             {
                 OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR, 
                     "Invalid file: version incompatible, file reports " + String(ver),
@@ -592,9 +708,13 @@ namespace Ogre {
         {
             pushInnerChunk(stream);
             unsigned short streamID = readChunk(stream);
-            while(streamID == SKELETON_ANIMATION_TRACK_KEYFRAME && !stream->eof())
+            while((streamID == SKELETON_ANIMATION_TRACK_KEYFRAME ||
+                streamID == SKELETON_ANIMATION_TRACK_COMPRESSED) && !stream->eof())
             {
-                readKeyFrame(stream, pTrack, pSkel);
+                if (streamID == SKELETON_ANIMATION_TRACK_COMPRESSED)
+                    readCompressedKeyFrames(stream, pTrack);
+                else
+                    readKeyFrame(stream, pTrack, pSkel);
 
                 if (!stream->eof())
                 {
@@ -639,6 +759,62 @@ namespace Ogre {
         }
     }
     //---------------------------------------------------------------------
+    void SkeletonSerializer::readCompressedKeyFrames(DataStreamPtr& stream, NodeAnimationTrack* track)
+    {
+        CompressedTransformKeyFrames* keyFrames = OGRE_NEW CompressedTransformKeyFrames();
+
+        // unsigned short numKeyFrames
+        uint16 numKeyFrames;
+        readShorts(stream, &numKeyFrames, 1);
+        // unsigned short modes[3]
+        uint16 modes[CompressedTransformKeyFrames::CH_COUNT];
+        readShorts(stream, modes, CompressedTransformKeyFrames::CH_COUNT);
+        for (size_t c = 0; c < CompressedTransformKeyFrames::CH_COUNT; ++c)
+        {
+            if (modes[c] > CompressedTransformKeyFrames::CM_FULL ||
+                (c == CompressedTransformKeyFrames::CH_ROTATION && modes[c] == CompressedTransformKeyFrames::CM_FULL))
+            {
+                OGRE_DELETE keyFrames;
+                OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS,
+                    "Invalid compressed keyframe channel mode in " + stream->getName(),
+                    "SkeletonSerializer::readCompressedKeyFrames");
+            }
+            keyFrames->mModes[c] = static_cast<uint8>(modes[c]);
+        }
+        keyFrames->allocate(numKeyFrames);
+
+        // float times[numKeyFrames]
+        readFloats(stream, keyFrames->mTimes, numKeyFrames);
+
+        Vector3* bases[] = { &keyFrames->mTranslateBase, 0, &keyFrames->mScaleBase };
+        Vector3* steps[] = { &keyFrames->mTranslateStep, 0, &keyFrames->mScaleStep };
+        for (size_t c = 0; c < CompressedTransformKeyFrames::CH_COUNT; ++c)
+        {
+            switch (modes[c])
+            {
+            case CompressedTransformKeyFrames::CM_CONSTANT:
+                if (bases[c])
+                    readObject(stream, *bases[c]);
+                else
+                    readObject(stream, keyFrames->mRotation);
+                break;
+            case CompressedTransformKeyFrames::CM_QUANTISED:
+                if (bases[c])
+                {
+                    readObject(stream, *bases[c]);
+                    readObject(stream, *steps[c]);
+                }
+                readShorts(stream, keyFrames->mQuantised[c], 3 * numKeyFrames);
+                break;
+            case CompressedTransformKeyFrames::CM_FULL:
+                readFloats(stream, keyFrames->mFull[c], 3 * numKeyFrames);
+                break;
+            }
+        }
+
+        track->_setCompressedKeyFrames(keyFrames);
+    }
+    //---------------------------------------------------------------------
     void SkeletonSerializer::writeSkeletonAnimationLink(const Skeleton* pSkel, 
         const LinkedSkeletonAnimationSource& link)
     {
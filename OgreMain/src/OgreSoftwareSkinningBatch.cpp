@@ -0,0 +1,202 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "OgreSoftwareSkinningBatch.h"
+#include "OgreEntity.h"
+#include "OgreVertexIndexData.h"
+#include "OgreHardwareVertexBuffer.h"
+#include "OgreOptimisedUtil.h"
+#include "OgreTaskScheduler.h"
+
+namespace Ogre {
+
+    //---------------------------------------------------------------------
+    struct SoftwareSkinningBatch::SkinChunks
+    {
+        const SoftwareSkinningBatch* mBatch;
+
+        SkinChunks(const SoftwareSkinningBatch* batch) : mBatch(batch) {}
+
+        void operator()(size_t begin, size_t end) const
+        {
+            OptimisedUtil* util = OptimisedUtil::getImplementation();
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Chunk& chunk = mBatch->mChunks[i];
+                const Job& job = mBatch->mJobs[chunk.mJob];
+                size_t first = chunk.mBegin;
+                util->softwareVertexSkinning(
+                    rawOffsetPointer(job.mSrcPos, first * job.mSrcPosStride),
+                    rawOffsetPointer(job.mDestPos, first * job.mDestPosStride),
+                    job.mSrcNorm ? rawOffsetPointer(job.mSrcNorm, first * job.mSrcNormStride) : 0,
+                    job.mSrcNorm ? rawOffsetPointer(job.mDestNorm, first * job.mDestNormStride) : 0,
+                    rawOffsetPointer(job.mBlendWeight, first * job.mBlendWeightStride),
+                    rawOffsetPointer(job.mBlendIndex, first * job.mBlendIndexStride),
+                    &mBatch->mBlendMatrices[job.mFirstMatrix],
+                    job.mSrcPosStride, job.mDestPosStride,
+                    job.mSrcNormStride, job.mDestNormStride,
+                    job.mBlendWeightStride, job.mBlendIndexStride,
+                    job.mNumWeightsPerVertex,
+                    chunk.mEnd - chunk.mBegin);
+            }
+        }
+    };
+    //---------------------------------------------------------------------
+    const size_t SoftwareSkinningBatch::CHUNK_VERTICES;
+    //---------------------------------------------------------------------
+    SoftwareSkinningBatch::SoftwareSkinningBatch()
+    {
+    }
+    //---------------------------------------------------------------------
+    SoftwareSkinningBatch::~SoftwareSkinningBatch()
+    {
+        clear();
+    }
+    //---------------------------------------------------------------------
+    size_t SoftwareSkinningBatch::update(Entity* const* entities, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            entities[i]->updateAnimation(this);
+
+        size_t numJobs = mJobs.size();
+        run();
+        return numJobs;
+    }
+    //---------------------------------------------------------------------
+    void* SoftwareSkinningBatch::lock(HardwareBuffer* buffer, HardwareBuffer::LockOptions options)
+    {
+        std::pair<map<HardwareBuffer*, void*>::type::iterator, bool> inserted =
+            mLockedBuffers.insert(std::make_pair(buffer, static_cast<void*>(0)));
+        if (inserted.second)
+            inserted.first->second = buffer->lock(options);
+        return inserted.first->second;
+    }
+    //---------------------------------------------------------------------
+    void SoftwareSkinningBatch::addVertexBlend(const VertexData* sourceVertexData,
+        const VertexData* targetVertexData, const Matrix4* const* blendMatrices,
+        size_t numMatrices, bool blendNormals)
+    {
+        // Same buffer layout as Mesh::softwareVertexBlend
+        const VertexDeclaration* srcDecl = sourceVertexData->vertexDeclaration;
+        const VertexDeclaration* destDecl = targetVertexData->vertexDeclaration;
+        const VertexElement* srcElemPos = srcDecl->findElementBySemantic(VES_POSITION);
+        const VertexElement* srcElemNorm = srcDecl->findElementBySemantic(VES_NORMAL);
+        const VertexElement* srcElemBlendIndices = srcDecl->findElementBySemantic(VES_BLEND_INDICES);
+        const VertexElement* srcElemBlendWeights = srcDecl->findElementBySemantic(VES_BLEND_WEIGHTS);
+        OgreAssert(srcElemPos && srcElemBlendIndices && srcElemBlendWeights,
+            "You must supply at least positions, blend indices and blend weights");
+        assert(srcElemBlendIndices->getType() == VET_UBYTE4 &&
+               "Blend indices must be VET_UBYTE4");
+        const VertexElement* destElemPos = destDecl->findElementBySemantic(VES_POSITION);
+        const VertexElement* destElemNorm = destDecl->findElementBySemantic(VES_NORMAL);
+        bool includeNormals = blendNormals && srcElemNorm && destElemNorm;
+
+        const VertexBufferBinding* srcBinding = sourceVertexData->vertexBufferBinding;
+        const VertexBufferBinding* destBinding = targetVertexData->vertexBufferBinding;
+        HardwareVertexBuffer* srcPosBuf = srcBinding->getBuffer(srcElemPos->getSource()).get();
+        HardwareVertexBuffer* srcIdxBuf = srcBinding->getBuffer(srcElemBlendIndices->getSource()).get();
+        HardwareVertexBuffer* srcWeightBuf = srcBinding->getBuffer(srcElemBlendWeights->getSource()).get();
+        HardwareVertexBuffer* destPosBuf = destBinding->getBuffer(destElemPos->getSource()).get();
+
+        Job job;
+        job.mSrcPosStride = srcPosBuf->getVertexSize();
+        job.mDestPosStride = destPosBuf->getVertexSize();
+        job.mBlendIndexStride = srcIdxBuf->getVertexSize();
+        job.mBlendWeightStride = srcWeightBuf->getVertexSize();
+        job.mNumWeightsPerVertex = VertexElement::getTypeCount(srcElemBlendWeights->getType());
+        job.mNumVertices = targetVertexData->vertexCount;
+
+        float* pFloat;
+        unsigned char* pIndex;
+        srcElemPos->baseVertexPointerToElement(lock(srcPosBuf, HardwareBuffer::HBL_READ_ONLY), &pFloat);
+        job.mSrcPos = pFloat;
+        srcElemBlendIndices->baseVertexPointerToElement(lock(srcIdxBuf, HardwareBuffer::HBL_READ_ONLY), &pIndex);
+        job.mBlendIndex = pIndex;
+        srcElemBlendWeights->baseVertexPointerToElement(lock(srcWeightBuf, HardwareBuffer::HBL_READ_ONLY), &pFloat);
+        job.mBlendWeight = pFloat;
+
+        // Discard the destination unless it holds other elements
+        HardwareVertexBuffer* destNormBuf = includeNormals ?
+            destBinding->getBuffer(destElemNorm->getSource()).get() : 0;
+        size_t destPosElemsSize = destElemPos->getSize() +
+            (destNormBuf == destPosBuf ? destElemNorm->getSize() : 0);
+        destElemPos->baseVertexPointerToElement(lock(destPosBuf,
+            job.mDestPosStride == destPosElemsSize ? HardwareBuffer::HBL_DISCARD : HardwareBuffer::HBL_NORMAL),
+            &job.mDestPos);
+
+        job.mSrcNorm = 0;
+        job.mDestNorm = 0;
+        job.mSrcNormStride = 0;
+        job.mDestNormStride = 0;
+        if (includeNormals)
+        {
+            HardwareVertexBuffer* srcNormBuf = srcBinding->getBuffer(srcElemNorm->getSource()).get();
+            job.mSrcNormStride = srcNormBuf->getVertexSize();
+            job.mDestNormStride = destNormBuf->getVertexSize();
+            srcElemNorm->baseVertexPointerToElement(lock(srcNormBuf, HardwareBuffer::HBL_READ_ONLY), &pFloat);
+            job.mSrcNorm = pFloat;
+            destElemNorm->baseVertexPointerToElement(lock(destNormBuf,
+                job.mDestNormStride == destElemNorm->getSize() ? HardwareBuffer::HBL_DISCARD : HardwareBuffer::HBL_NORMAL),
+                &job.mDestNorm);
+        }
+
+        job.mFirstMatrix = mBlendMatrices.size();
+        mBlendMatrices.insert(mBlendMatrices.end(), blendMatrices, blendMatrices + numMatrices);
+
+        for (size_t begin = 0; begin < job.mNumVertices; begin += CHUNK_VERTICES)
+        {
+            Chunk chunk;
+            chunk.mJob = mJobs.size();
+            chunk.mBegin = begin;
+            chunk.mEnd = std::min(begin + CHUNK_VERTICES, job.mNumVertices);
+            mChunks.push_back(chunk);
+        }
+        mJobs.push_back(job);
+    }
+    //---------------------------------------------------------------------
+    void SoftwareSkinningBatch::run(void)
+    {
+        if (!mChunks.empty())
+            parallelFor(0, mChunks.size(), 1, SkinChunks(this), "SoftwareSkinningBatch");
+        clear();
+    }
+    //---------------------------------------------------------------------
+    void SoftwareSkinningBatch::clear(void)
+    {
+        for (map<HardwareBuffer*, void*>::type::iterator i = mLockedBuffers.begin();
+            i != mLockedBuffers.end(); ++i)
+        {
+            i->first->unlock();
+        }
+        mLockedBuffers.clear();
+        mJobs.clear();
+        mChunks.clear();
+        mBlendMatrices.clear();
+    }
+
+}
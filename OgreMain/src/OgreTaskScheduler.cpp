@@ -0,0 +1,223 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "OgreTaskScheduler.h"
+#include "OgreRoot.h"
+#include "OgreProfiler.h"
+
+namespace Ogre {
+    //---------------------------------------------------------------------
+    TaskScheduler::TaskScheduler(WorkQueue* queue)
+        : mQueue(queue)
+        , mChannel(0)
+    {
+#if OGRE_THREAD_SUPPORT
+        mMainThreadID = OGRE_THREAD_CURRENT_ID;
+#endif
+        if (mQueue)
+        {
+            mChannel = mQueue->getChannel("Ogre/TaskScheduler");
+            mQueue->addRequestHandler(mChannel, this);
+        }
+    }
+    //---------------------------------------------------------------------
+    TaskScheduler::~TaskScheduler()
+    {
+        if (mQueue)
+        {
+            // Requests left in the queue then are deleted without warning,
+            // releasing their batches
+            mQueue->abortRequestsByChannel(mChannel);
+            mQueue->removeRequestHandler(mChannel, this);
+        }
+    }
+    //---------------------------------------------------------------------
+    size_t TaskScheduler::getConcurrency() const
+    {
+#if OGRE_THREAD_SUPPORT
+        if (mQueue && mQueue->isRunning())
+            return mQueue->getWorkerThreadCount() + 1;
+#endif
+        return 1;
+    }
+    //---------------------------------------------------------------------
+    bool TaskScheduler::isMainThread() const
+    {
+#if OGRE_THREAD_SUPPORT
+        return OGRE_THREAD_CURRENT_ID == mMainThreadID;
+#else
+        return true;
+#endif
+    }
+    //---------------------------------------------------------------------
+    bool TaskScheduler::canHandleRequest(const WorkQueue::Request* req, const WorkQueue* srcQ)
+    {
+        // Even aborted requests must release their batch
+        return true;
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Response* TaskScheduler::handleRequest(const WorkQueue::Request* req, const WorkQueue* srcQ)
+    {
+        // The batch is released when the request is deleted
+        if (!req->getAborted())
+            any_cast<TaskGroup::BatchRef>(&req->getData())->mBatch->work();
+        // Nothing to report to the main thread: marked aborted, the queue deletes
+        // the request right away instead of warning that it was not handled
+        req->abortRequest();
+        return 0;
+    }
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    TaskGroup::Batch::Batch(Task* task, size_t begin, size_t end, size_t grainSize, bool queued)
+        : mTask(task)
+        , mBegin(begin)
+        , mEnd(end)
+        , mGrainSize(grainSize)
+        , mNumChunks((end - begin + grainSize - 1) / grainSize)
+        , mQueued(queued)
+        , mNextChunk(0)
+        , mNumChunksLeft(mNumChunks)
+        , mRefCount(1)
+    {
+    }
+    //---------------------------------------------------------------------
+    void TaskGroup::Batch::work()
+    {
+        size_t numDone = 0;
+        for (;;)
+        {
+            // Once all the chunks were claimed the task may be gone, don't touch it
+            size_t chunk = mNextChunk++;
+            if (chunk >= mNumChunks)
+                break;
+            size_t begin = mBegin + chunk * mGrainSize;
+            mTask->execute(begin, std::min(begin + mGrainSize, mEnd));
+            ++numDone;
+        }
+
+        if (numDone && (mNumChunksLeft -= numDone) == 0)
+        {
+#if OGRE_THREAD_SUPPORT
+            // Notify under the lock so the waiter can't miss it between testing and waiting
+            OGRE_LOCK_MUTEX(mMutex);
+            OGRE_THREAD_NOTIFY_ALL(mDoneSync);
+#endif
+        }
+    }
+    //---------------------------------------------------------------------
+    void TaskGroup::Batch::waitDone()
+    {
+#if OGRE_THREAD_SUPPORT
+        // cas is a full barrier, so the results of the workers are visible afterwards
+        if (mNumChunksLeft.cas(0, 0))
+            return;
+
+        OGRE_LOCK_MUTEX_NAMED(mMutex, lock);
+        while (!mNumChunksLeft.cas(0, 0))
+        {
+            OGRE_THREAD_WAIT(mDoneSync, mMutex, lock);
+        }
+#endif
+    }
+    //---------------------------------------------------------------------
+    void TaskGroup::Batch::release()
+    {
+        if (--mRefCount == 0)
+            OGRE_DELETE this;
+    }
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    TaskGroup::TaskGroup(const String& name, TaskScheduler* scheduler)
+        : mName(name)
+        , mScheduler(scheduler)
+    {
+        if (!mScheduler && Root::getSingletonPtr())
+            mScheduler = Root::getSingleton().getTaskScheduler();
+    }
+    //---------------------------------------------------------------------
+    TaskGroup::~TaskGroup()
+    {
+        wait();
+    }
+    //---------------------------------------------------------------------
+    void TaskGroup::run(Task* task, size_t begin, size_t end, size_t grainSize)
+    {
+        if (begin >= end)
+            return;
+        if (grainSize == 0)
+            grainSize = 1;
+
+        size_t numChunks = (end - begin + grainSize - 1) / grainSize;
+        size_t numRequests = 0;
+        if (mScheduler)
+            numRequests = std::min(numChunks, mScheduler->getConcurrency() - 1);
+
+        Batch* batch = OGRE_NEW Batch(task, begin, end, grainSize, numRequests > 0);
+        mBatches.push_back(batch);
+
+        if (numRequests)
+        {
+            // Each request pulls chunks until there are none left, so one per worker is enough
+            WorkQueue* queue = mScheduler->getWorkQueue();
+            vector<Any>::type data(numRequests, Any(BatchRef(batch)));
+            queue->addRequests(mScheduler->getChannel(), 0, &data[0], numRequests);
+        }
+    }
+    //---------------------------------------------------------------------
+    void TaskGroup::wait(bool participate)
+    {
+        if (mBatches.empty())
+            return;
+
+#if OGRE_PROFILING
+        bool profile = !mScheduler || mScheduler->isMainThread();
+        if (profile)
+            OgreProfileBeginGroup(mName, OGREPROF_GENERAL);
+#endif
+
+        for (BatchList::iterator i = mBatches.begin(); i != mBatches.end(); ++i)
+        {
+            Batch* batch = *i;
+            // Without requests posted for it, or workers to process them, nobody
+            // else would process the batch
+            if (participate || !batch->mQueued || !mScheduler->getWorkQueue()->isRunning())
+            {
+                batch->work();
+            }
+            batch->waitDone();
+            batch->release();
+        }
+        mBatches.clear();
+
+#if OGRE_PROFILING
+        if (profile)
+            OgreProfileEndGroup(mName, OGREPROF_GENERAL);
+#endif
+    }
+
+}
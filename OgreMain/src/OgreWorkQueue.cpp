@@ -45,8 +45,20 @@ namespace Ogre {
         return i->second;
     }
     //---------------------------------------------------------------------
+    void WorkQueue::addRequests(uint16 channel, uint16 requestType, const Any* rData, size_t count,
+        uint8 retryCount, RequestID* outIDs)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            RequestID rid = addRequest(channel, requestType, rData[i], retryCount);
+            if (outIDs)
+                outIDs[i] = rid;
+        }
+    }
+    //---------------------------------------------------------------------
     WorkQueue::Request::Request(uint16 channel, uint16 rtype, const Any& rData, uint8 retry, RequestID rid)
         : mChannel(channel), mType(rtype), mData(rData), mRetryCount(retry), mID(rid), mAborted(false)
+        , mNextQueued(0)
     {
 
     }
@@ -58,7 +70,7 @@ namespace Ogre {
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     WorkQueue::Response::Response(const Request* rq, bool success, const Any& data, const String& msg)
-        : mRequest(rq), mSuccess(success), mMessages(msg), mData(data)
+        : mRequest(rq), mSuccess(success), mMessages(msg), mData(data), mNextQueued(0)
     {
         
     }
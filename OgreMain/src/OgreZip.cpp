@@ -33,9 +33,11 @@ THE SOFTWARE.
 
 #include "OgreLogManager.h"
 #include "OgreException.h"
+#include "OgreTaskScheduler.h"
 
 #include <zzip/zzip.h>
 #include <zzip/plugin.h>
+#include <zlib.h>
 
 
 namespace Ogre {
@@ -690,6 +692,682 @@ namespace Ogre {
     {
         EmbeddedZipArchiveFactory_mFileNameToIndexMap->erase(name);
     }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    //  MappedZipArchive
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    // Signatures and fixed sizes of the zip records
+    static const uint32 ZIP_LOCAL_HEADER_SIG = 0x04034b50;
+    static const uint32 ZIP_DIR_HEADER_SIG = 0x02014b50;
+    static const uint32 ZIP_END_SIG = 0x06054b50;
+    static const uint32 ZIP64_LOCATOR_SIG = 0x07064b50;
+    static const uint32 ZIP64_END_SIG = 0x06064b50;
+    static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+    static const size_t ZIP_DIR_HEADER_SIZE = 46;
+    static const size_t ZIP_END_SIZE = 22;
+    static const size_t ZIP64_LOCATOR_SIZE = 20;
+    static const size_t ZIP64_END_SIZE = 56;
+    static const uint16 ZIP64_EXTRA_ID = 0x0001;
+    static const uint16 ZIP_METHOD_STORED = 0;
+    static const uint16 ZIP_METHOD_DEFLATED = 8;
+    static const uint16 ZIP_FLAG_ENCRYPTED = 0x0001;
+    //-----------------------------------------------------------------------
+    // Zip files are little endian, and their fields unaligned
+    static uint16 readZipUInt16(const uchar* p)
+    {
+        return static_cast<uint16>(p[0] | (p[1] << 8));
+    }
+    //-----------------------------------------------------------------------
+    static uint32 readZipUInt32(const uchar* p)
+    {
+        return static_cast<uint32>(p[0]) | (static_cast<uint32>(p[1]) << 8) |
+            (static_cast<uint32>(p[2]) << 16) | (static_cast<uint32>(p[3]) << 24);
+    }
+    //-----------------------------------------------------------------------
+    static uint64 readZipUInt64(const uchar* p)
+    {
+        return readZipUInt32(p) | (static_cast<uint64>(readZipUInt32(p + 4)) << 32);
+    }
+    //-----------------------------------------------------------------------
+    /// Inflates raw deflate data in one go, returns whether it filled dest exactly
+    static bool inflateZipData(const uchar* src, uint64 srcSize, uchar* dest, size_t destSize)
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+            return false;
+
+        // zlib counts in uInt, so anything over 4GB has to be passed in pieces
+        const uint64 maxChunk = static_cast<uInt>(-1);
+        zs.next_in = const_cast<Bytef*>(src);
+        zs.next_out = dest;
+        uint64 inLeft = srcSize;
+        uint64 outLeft = destSize;
+        int ret = Z_OK;
+        while (ret == Z_OK)
+        {
+            if (zs.avail_in == 0 && inLeft)
+            {
+                zs.avail_in = static_cast<uInt>(std::min(inLeft, maxChunk));
+                inLeft -= zs.avail_in;
+            }
+            if (zs.avail_out == 0 && outLeft)
+            {
+                zs.avail_out = static_cast<uInt>(std::min(outLeft, maxChunk));
+                outLeft -= zs.avail_out;
+            }
+            ret = inflate(&zs, Z_NO_FLUSH);
+        }
+        inflateEnd(&zs);
+
+        return ret == Z_STREAM_END && zs.avail_out == 0 && outLeft == 0;
+    }
+    //-----------------------------------------------------------------------
+    /** Recycles the buffers deflated files are inflated to.
+    @remarks
+        Loaders mostly close a stream before opening the next one, so a few
+        buffers save allocating and faulting in fresh memory for each file.
+    */
+    class ZipBufferPool : public GeneralAllocatedObject
+    {
+    protected:
+        struct Buffer
+        {
+            uchar* data;
+            size_t capacity;
+        };
+        typedef vector<Buffer>::type BufferList;
+
+        /// Most buffers kept around
+        static const size_t MAX_BUFFERS = 16;
+        /// Most memory kept around
+        static const size_t MAX_POOLED_SIZE = 32 * 1024 * 1024;
+
+        BufferList mBuffers;
+        size_t mPooledSize;
+        OGRE_MUTEX(mMutex);
+    public:
+        ZipBufferPool() : mPooledSize(0) {}
+        ~ZipBufferPool()
+        {
+            for (BufferList::iterator i = mBuffers.begin(); i != mBuffers.end(); ++i)
+                OGRE_FREE(i->data, MEMCATEGORY_GENERAL);
+        }
+
+        /** Gets a buffer of at least size bytes.
+        @param capacity Receives the actual size of the buffer
+        */
+        uchar* acquire(size_t size, size_t& capacity)
+        {
+            {
+                OGRE_LOCK_MUTEX(mMutex);
+                // Take the smallest buffer that fits, unless it would waste over half of it
+                BufferList::iterator best = mBuffers.end();
+                for (BufferList::iterator i = mBuffers.begin(); i != mBuffers.end(); ++i)
+                {
+                    if (i->capacity >= size && i->capacity / 2 <= size &&
+                        (best == mBuffers.end() || i->capacity < best->capacity))
+                        best = i;
+                }
+                if (best != mBuffers.end())
+                {
+                    uchar* data = best->data;
+                    capacity = best->capacity;
+                    mPooledSize -= capacity;
+                    mBuffers.erase(best);
+                    return data;
+                }
+            }
+            capacity = size;
+            return OGRE_ALLOC_T(uchar, size, MEMCATEGORY_GENERAL);
+        }
+
+        /// Returns a buffer got from acquire
+        void release(uchar* data, size_t capacity)
+        {
+            {
+                OGRE_LOCK_MUTEX(mMutex);
+                if (mBuffers.size() < MAX_BUFFERS && capacity <= MAX_POOLED_SIZE - mPooledSize)
+                {
+                    Buffer buffer = { data, capacity };
+                    mBuffers.push_back(buffer);
+                    mPooledSize += capacity;
+                    return;
+                }
+            }
+            OGRE_FREE(data, MEMCATEGORY_GENERAL);
+        }
+    };
+    //-----------------------------------------------------------------------
+    /** Stream over a file of a MappedZipArchive, viewing either the mapping or
+        a buffer of the pool, which it gives back on close.
+    */
+    class MappedZipDataStream : public MemoryDataStream
+    {
+    protected:
+        MemoryDataStreamPtr mMapping;
+        SharedPtr<ZipBufferPool> mBufferPool;
+        size_t mCapacity;
+    public:
+        /// Constructor for stored files, viewing the mapping
+        MappedZipDataStream(const String& name, const MemoryDataStreamPtr& mapping,
+            const uchar* data, size_t size)
+            : MemoryDataStream(name, const_cast<uchar*>(data), size, false, true)
+            , mMapping(mapping), mCapacity(0)
+        {
+        }
+        /// Constructor for inflated files, taking over a buffer of the pool
+        MappedZipDataStream(const String& name, const SharedPtr<ZipBufferPool>& bufferPool,
+            uchar* data, size_t size, size_t capacity)
+            : MemoryDataStream(name, data, size, false, true)
+            , mBufferPool(bufferPool), mCapacity(capacity)
+        {
+        }
+        ~MappedZipDataStream()
+        {
+            close();
+        }
+        /// @copydoc DataStream::close
+        void close(void)
+        {
+            if (mData && mBufferPool)
+                mBufferPool->release(mData, mCapacity);
+            mBufferPool.reset();
+            mMapping.reset();
+            mData = mPos = mEnd = 0;
+        }
+    };
+    //-----------------------------------------------------------------------
+    /// Opens a range of the files passed to MappedZipArchive::openMultiple
+    struct OpenZipFiles
+    {
+        const MappedZipArchive* mArchive;
+        const StringVector* mFilenames;
+        vector<DataStreamPtr>::type* mStreams;
+        vector<Exception::ExceptionCodes>::type* mErrorCodes;
+        StringVector* mErrors;
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                // Exceptions can't cross threads, keep them for the caller
+                try
+                {
+                    (*mStreams)[i] = mArchive->open((*mFilenames)[i]);
+                }
+                catch (FileNotFoundException& e)
+                {
+                    (*mErrorCodes)[i] = Exception::ERR_FILE_NOT_FOUND;
+                    (*mErrors)[i] = e.getDescription();
+                }
+                catch (UnimplementedException& e)
+                {
+                    (*mErrorCodes)[i] = Exception::ERR_NOT_IMPLEMENTED;
+                    (*mErrors)[i] = e.getDescription();
+                }
+                catch (Exception& e)
+                {
+                    // Left as ERR_INTERNAL_ERROR
+                    (*mErrors)[i] = e.getDescription();
+                }
+                catch (std::exception& e)
+                {
+                    (*mErrors)[i] = e.what();
+                }
+            }
+        }
+    };
+    //-----------------------------------------------------------------------
+    MappedZipArchive::MappedZipArchive(const String& name, const String& archType)
+        : Archive(name, archType)
+        , mDirectory(OGRE_NEW Directory())
+    {
+    }
+    //-----------------------------------------------------------------------
+    MappedZipArchive::~MappedZipArchive()
+    {
+        unload();
+    }
+    //-----------------------------------------------------------------------
+    void MappedZipArchive::load()
+    {
+        OGRE_LOCK_AUTO_MUTEX;
+        if (!mDirectory->mMapping)
+        {
+            // Only published once complete, so a failed load leaves nothing behind
+            DirectoryPtr dir(OGRE_NEW Directory());
+            dir->mMapping = MemoryDataStreamPtr(OGRE_NEW MemoryMappedDataStream(mName, mName));
+            dir->mBufferPool = SharedPtr<ZipBufferPool>(OGRE_NEW ZipBufferPool());
+            readCentralDirectory(*dir);
+            mDirectory = dir;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void MappedZipArchive::unload()
+    {
+        OGRE_LOCK_AUTO_MUTEX;
+        // Files being opened and open streams hold their own references
+        if (mDirectory->mMapping)
+            mDirectory = DirectoryPtr(OGRE_NEW Directory());
+    }
+    //-----------------------------------------------------------------------
+    MappedZipArchive::DirectoryPtr MappedZipArchive::getDirectory() const
+    {
+        OGRE_LOCK_AUTO_MUTEX;
+        return mDirectory;
+    }
+    //-----------------------------------------------------------------------
+    void MappedZipArchive::readCentralDirectory(Directory& dir)
+    {
+        const uchar* data = dir.mMapping->getPtr();
+        const size_t size = dir.mMapping->size();
+
+        // The end of central directory record is last, followed by a comment of up to 64KB
+        size_t endPos = 0;
+        bool found = false;
+        if (size >= ZIP_END_SIZE)
+        {
+            size_t lastPos = size - ZIP_END_SIZE;
+            size_t firstPos = lastPos > 0xFFFF ? lastPos - 0xFFFF : 0;
+            for (endPos = lastPos + 1; endPos-- > firstPos; )
+            {
+                if (readZipUInt32(data + endPos) == ZIP_END_SIG)
+                {
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found)
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                mName + " - Zip-file's central directory record missing.",
+                "MappedZipArchive::load");
+        }
+
+        uint64 numEntries = readZipUInt16(data + endPos + 10);
+        uint64 dirSize = readZipUInt32(data + endPos + 12);
+        uint64 dirOffset = readZipUInt32(data + endPos + 16);
+
+        // zip64 archives keep the real values in another record, found through a locator
+        if (endPos >= ZIP64_LOCATOR_SIZE &&
+            readZipUInt32(data + endPos - ZIP64_LOCATOR_SIZE) == ZIP64_LOCATOR_SIG)
+        {
+            uint64 end64Pos = readZipUInt64(data + endPos - ZIP64_LOCATOR_SIZE + 8);
+            if (size < ZIP64_END_SIZE || end64Pos > size - ZIP64_END_SIZE ||
+                readZipUInt32(data + end64Pos) != ZIP64_END_SIG)
+            {
+                OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                    mName + " - Corrupted archive.", "MappedZipArchive::load");
+            }
+            numEntries = readZipUInt64(data + end64Pos + 32);
+            dirSize = readZipUInt64(data + end64Pos + 40);
+            dirOffset = readZipUInt64(data + end64Pos + 48);
+        }
+
+        if (dirOffset > size || dirSize > size - dirOffset ||
+            numEntries > dirSize / ZIP_DIR_HEADER_SIZE)
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                mName + " - Corrupted archive.", "MappedZipArchive::load");
+        }
+
+        dir.mFileList.reserve(static_cast<size_t>(numEntries));
+        dir.mEntries.reserve(static_cast<size_t>(numEntries));
+
+        const uchar* record = data + dirOffset;
+        const uchar* dirEnd = record + dirSize;
+        for (uint64 n = 0; n < numEntries; ++n)
+        {
+            if (static_cast<size_t>(dirEnd - record) < ZIP_DIR_HEADER_SIZE ||
+                readZipUInt32(record) != ZIP_DIR_HEADER_SIG)
+            {
+                OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                    mName + " - Corrupted archive.", "MappedZipArchive::load");
+            }
+            Entry entry;
+            entry.flags = readZipUInt16(record + 8);
+            entry.method = readZipUInt16(record + 10);
+            entry.compressedSize = readZipUInt32(record + 20);
+            entry.uncompressedSize = readZipUInt32(record + 24);
+            entry.headerOffset = readZipUInt32(record + 42);
+            size_t nameLength = readZipUInt16(record + 28);
+            size_t extraLength = readZipUInt16(record + 30);
+            size_t commentLength = readZipUInt16(record + 32);
+            size_t recordSize = ZIP_DIR_HEADER_SIZE + nameLength + extraLength + commentLength;
+            if (static_cast<size_t>(dirEnd - record) < recordSize)
+            {
+                OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                    mName + " - Corrupted archive.", "MappedZipArchive::load");
+            }
+
+            // The zip64 extra field holds the values too big for their field, in this order
+            const uchar* extra = record + ZIP_DIR_HEADER_SIZE + nameLength;
+            const uchar* extraEnd = extra + extraLength;
+            while (extraEnd - extra >= 4)
+            {
+                uint16 id = readZipUInt16(extra);
+                size_t fieldSize = readZipUInt16(extra + 2);
+                extra += 4;
+                if (static_cast<size_t>(extraEnd - extra) < fieldSize)
+                    break;
+                if (id == ZIP64_EXTRA_ID)
+                {
+                    const uchar* field = extra;
+                    const uchar* fieldEnd = extra + fieldSize;
+                    if (entry.uncompressedSize == 0xFFFFFFFF && fieldEnd - field >= 8)
+                    {
+                        entry.uncompressedSize = readZipUInt64(field);
+                        field += 8;
+                    }
+                    if (entry.compressedSize == 0xFFFFFFFF && fieldEnd - field >= 8)
+                    {
+                        entry.compressedSize = readZipUInt64(field);
+                        field += 8;
+                    }
+                    if (entry.headerOffset == 0xFFFFFFFF && fieldEnd - field >= 8)
+                    {
+                        entry.headerOffset = readZipUInt64(field);
+                    }
+                }
+                extra += fieldSize;
+            }
+
+            FileInfo info;
+            info.archive = this;
+            String fullName(reinterpret_cast<const char*>(record + ZIP_DIR_HEADER_SIZE), nameLength);
+            record += recordSize;
+
+            // Get basename / path
+            StringUtil::splitFilename(fullName, info.basename, info.path);
+            info.filename = fullName;
+            // Get sizes
+            info.compressedSize = static_cast<size_t>(entry.compressedSize);
+            info.uncompressedSize = static_cast<size_t>(entry.uncompressedSize);
+            // folder entries
+            if (info.basename.empty())
+            {
+                info.filename = info.filename.substr (0, info.filename.length () - 1);
+                StringUtil::splitFilename(info.filename, info.basename, info.path);
+                // Set compressed size to -1 for folders, like ZipArchive does
+                info.compressedSize = size_t (-1);
+            }
+#if !OGRE_RESOURCEMANAGER_STRICT
+            else
+            {
+                info.filename = info.basename;
+                // Files can be opened without their path, as long as the name is unique
+                std::pair<EntryIndex::iterator, bool> inserted =
+                    dir.mBaseNameIndex.insert(EntryIndex::value_type(getLookupKey(info.basename), dir.mFileList.size()));
+                if (!inserted.second)
+                    inserted.first->second = size_t(-1);
+            }
+#endif
+            dir.mIndex.insert(EntryIndex::value_type(getLookupKey(info.path + info.basename), dir.mFileList.size()));
+            dir.mFileList.push_back(info);
+            dir.mEntries.push_back(entry);
+        }
+    }
+    //-----------------------------------------------------------------------
+    String MappedZipArchive::getLookupKey(const String& filename) const
+    {
+#if OGRE_RESOURCEMANAGER_STRICT
+        return filename;
+#else
+        String key = filename;
+        StringUtil::toLowerCase(key);
+        return key;
+#endif
+    }
+    //-----------------------------------------------------------------------
+    size_t MappedZipArchive::findEntry(const Directory& dir, const String& filename) const
+    {
+        EntryIndex::const_iterator i = dir.mIndex.find(getLookupKey(filename));
+        if (i != dir.mIndex.end())
+            return i->second;
+#if !OGRE_RESOURCEMANAGER_STRICT
+        // Try if we find the file without its path
+        String basename, path;
+        StringUtil::splitFilename(filename, basename, path);
+        i = dir.mBaseNameIndex.find(getLookupKey(basename));
+        if (i != dir.mBaseNameIndex.end())
+            return i->second;
+#endif
+        return size_t(-1);
+    }
+    //-----------------------------------------------------------------------
+    const uchar* MappedZipArchive::getEntryData(const Directory& dir, const Entry& entry,
+        const String& filename) const
+    {
+        const uchar* data = dir.mMapping->getPtr();
+        const uint64 size = dir.mMapping->size();
+
+        uint64 dataOffset = 0;
+        if (size >= ZIP_LOCAL_HEADER_SIZE && entry.headerOffset <= size - ZIP_LOCAL_HEADER_SIZE &&
+            readZipUInt32(data + entry.headerOffset) == ZIP_LOCAL_HEADER_SIG)
+        {
+            // The local header has its own name and extra field lengths
+            const uchar* header = data + entry.headerOffset;
+            dataOffset = entry.headerOffset + ZIP_LOCAL_HEADER_SIZE +
+                readZipUInt16(header + 26) + readZipUInt16(header + 28);
+        }
+        if (!dataOffset || dataOffset > size || entry.compressedSize > size - dataOffset)
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                mName + " Cannot open file: " + filename + " - Corrupted archive.",
+                "MappedZipArchive::open");
+        }
+        return data + dataOffset;
+    }
+    //-----------------------------------------------------------------------
+    DataStreamPtr MappedZipArchive::openEntry(const Directory& dir, size_t index, const String& filename) const
+    {
+        const Entry& entry = dir.mEntries[index];
+        if (entry.flags & ZIP_FLAG_ENCRYPTED)
+        {
+            OGRE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED,
+                mName + " Cannot open file: " + filename + " - Encrypted files are not supported.",
+                "MappedZipArchive::open");
+        }
+        if (entry.method != ZIP_METHOD_STORED && entry.method != ZIP_METHOD_DEFLATED)
+        {
+            OGRE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED,
+                mName + " Cannot open file: " + filename + " - Unsupported compression format.",
+                "MappedZipArchive::open");
+        }
+        if (entry.uncompressedSize != static_cast<size_t>(entry.uncompressedSize))
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                mName + " Cannot open file: " + filename + " - File too large for this platform.",
+                "MappedZipArchive::open");
+        }
+
+        const uchar* src = getEntryData(dir, entry, filename);
+        if (entry.method == ZIP_METHOD_STORED)
+        {
+            // Zero copy, the stream reads straight from the mapping
+            return DataStreamPtr(OGRE_NEW MappedZipDataStream(filename, dir.mMapping,
+                src, static_cast<size_t>(entry.compressedSize)));
+        }
+
+        size_t size = static_cast<size_t>(entry.uncompressedSize);
+        size_t capacity = 0;
+        uchar* dest = size ? dir.mBufferPool->acquire(size, capacity) : 0;
+        // The stream owns the buffer from here, so it goes back to the pool on failure too
+        DataStreamPtr stream(OGRE_NEW MappedZipDataStream(filename, dir.mBufferPool, dest, size, capacity));
+        if (size && !inflateZipData(src, entry.compressedSize, dest, size))
+        {
+            OGRE_EXCEPT(Exception::ERR_INTERNAL_ERROR,
+                mName + " Cannot open file: " + filename + " - Corrupted archive.",
+                "MappedZipArchive::open");
+        }
+        return stream;
+    }
+    //-----------------------------------------------------------------------
+    DataStreamPtr MappedZipArchive::open(const String& filename, bool readOnly) const
+    {
+        // Inflating doesn't need the lock, the directory stays valid while referenced
+        DirectoryPtr dir = getDirectory();
+        size_t index = findEntry(*dir, filename);
+        if (index == size_t(-1) || dir->mFileList[index].compressedSize == size_t(-1))
+        {
+            OGRE_EXCEPT(Exception::ERR_FILE_NOT_FOUND,
+                mName + " Cannot open file: " + filename + " - File not in archive.",
+                "MappedZipArchive::open");
+        }
+        return openEntry(*dir, index, filename);
+    }
+    //-----------------------------------------------------------------------
+    void MappedZipArchive::openMultiple(const StringVector& filenames,
+        vector<DataStreamPtr>::type& streams) const
+    {
+        streams.clear();
+        streams.resize(filenames.size());
+        vector<Exception::ExceptionCodes>::type errorCodes(filenames.size(), Exception::ERR_INTERNAL_ERROR);
+        StringVector errors(filenames.size());
+
+        OpenZipFiles opener = { this, &filenames, &streams, &errorCodes, &errors };
+        parallelFor(0, filenames.size(), 1, opener, "MappedZipArchive::openMultiple");
+
+        for (size_t i = 0; i < errors.size(); ++i)
+        {
+            if (!errors[i].empty())
+            {
+                streams.clear();
+                OGRE_EXCEPT(errorCodes[i], errors[i], "MappedZipArchive::openMultiple");
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    DataStreamPtr MappedZipArchive::create(const String& filename)
+    {
+        OGRE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED,
+            "Modification of zipped archives is not supported",
+            "MappedZipArchive::create");
+    }
+    //---------------------------------------------------------------------
+    void MappedZipArchive::remove(const String& filename)
+    {
+        OGRE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED,
+            "Modification of zipped archives is not supported",
+            "MappedZipArchive::remove");
+    }
+    //-----------------------------------------------------------------------
+    StringVectorPtr MappedZipArchive::list(bool recursive, bool dirs) const
+    {
+        StringVectorPtr ret = StringVectorPtr(OGRE_NEW_T(StringVector, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
+
+        DirectoryPtr dir = getDirectory();
+        FileInfoList::const_iterator i, iend;
+        iend = dir->mFileList.end();
+        for (i = dir->mFileList.begin(); i != iend; ++i)
+            if ((dirs == (i->compressedSize == size_t (-1))) &&
+                (recursive || i->path.empty()))
+                ret->push_back(i->filename);
+
+        return ret;
+    }
+    //-----------------------------------------------------------------------
+    FileInfoListPtr MappedZipArchive::listFileInfo(bool recursive, bool dirs) const
+    {
+        FileInfoList* fil = OGRE_NEW_T(FileInfoList, MEMCATEGORY_GENERAL)();
+        DirectoryPtr dir = getDirectory();
+        FileInfoList::const_iterator i, iend;
+        iend = dir->mFileList.end();
+        for (i = dir->mFileList.begin(); i != iend; ++i)
+            if ((dirs == (i->compressedSize == size_t (-1))) &&
+                (recursive || i->path.empty()))
+                fil->push_back(*i);
+
+        return FileInfoListPtr(fil, SPFM_DELETE_T);
+    }
+    //-----------------------------------------------------------------------
+    StringVectorPtr MappedZipArchive::find(const String& pattern, bool recursive, bool dirs) const
+    {
+        StringVectorPtr ret = StringVectorPtr(OGRE_NEW_T(StringVector, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
+        // If pattern contains a directory name, do a full match
+        bool full_match = (pattern.find ('/') != String::npos) ||
+                          (pattern.find ('\\') != String::npos);
+        bool wildCard = pattern.find("*") != String::npos;
+
+        DirectoryPtr dir = getDirectory();
+        FileInfoList::const_iterator i, iend;
+        iend = dir->mFileList.end();
+        for (i = dir->mFileList.begin(); i != iend; ++i)
+            if ((dirs == (i->compressedSize == size_t (-1))) &&
+                (recursive || full_match || wildCard))
+                // Check basename matches pattern (zip is case insensitive)
+                if (StringUtil::match(full_match ? i->filename : i->basename, pattern, false))
+                    ret->push_back(i->filename);
+
+        return ret;
+    }
+    //-----------------------------------------------------------------------
+    FileInfoListPtr MappedZipArchive::findFileInfo(const String& pattern,
+        bool recursive, bool dirs) const
+    {
+        FileInfoListPtr ret = FileInfoListPtr(OGRE_NEW_T(FileInfoList, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
+        // If pattern contains a directory name, do a full match
+        bool full_match = (pattern.find ('/') != String::npos) ||
+                          (pattern.find ('\\') != String::npos);
+        bool wildCard = pattern.find("*") != String::npos;
+
+        DirectoryPtr dir = getDirectory();
+        FileInfoList::const_iterator i, iend;
+        iend = dir->mFileList.end();
+        for (i = dir->mFileList.begin(); i != iend; ++i)
+            if ((dirs == (i->compressedSize == size_t (-1))) &&
+                (recursive || full_match || wildCard))
+                // Check name matches pattern (zip is case insensitive)
+                if (StringUtil::match(full_match ? i->filename : i->basename, pattern, false))
+                    ret->push_back(*i);
+
+        return ret;
+    }
+    //-----------------------------------------------------------------------
+    bool MappedZipArchive::exists(const String& filename) const
+    {
+        DirectoryPtr dir = getDirectory();
+        return findEntry(*dir, filename) != size_t(-1);
+    }
+    //---------------------------------------------------------------------
+    time_t MappedZipArchive::getModifiedTime(const String& filename) const
+    {
+        // Like ZipArchive, use the mod time of the zip itself
+        struct stat tagStat;
+        bool ret = (stat(mName.c_str(), &tagStat) == 0);
+
+        if (ret)
+        {
+            return tagStat.st_mtime;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    //  MappedZipArchiveFactory
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    const String& MappedZipArchiveFactory::getType(void) const
+    {
+        static String name = "MappedZip";
+        return name;
+    }
+    //-----------------------------------------------------------------------
+    Archive* MappedZipArchiveFactory::createInstance( const String& name, bool readOnly )
+    {
+        if(!readOnly)
+            return NULL;
+
+        if (MemoryMappedDataStream::isSupported())
+            return OGRE_NEW MappedZipArchive(name, getType());
+        return OGRE_NEW ZipArchive(name, getType());
+    }
 }
 
 #endif
@@ -121,8 +121,12 @@ namespace Ogre
         mShuttingDown = true;
         abortAllRequests();
 #if OGRE_THREAD_SUPPORT
-        // wake all threads (they should check shutting down as first thing after wait)
-        OGRE_THREAD_NOTIFY_ALL(mRequestCondition);
+        {
+            // notify under the lock so a thread about to wait can't miss it
+            OGRE_LOCK_MUTEX(mRequestMutex);
+            // wake all threads (they should check shutting down as first thing after wait)
+            OGRE_THREAD_NOTIFY_ALL(mRequestCondition);
+        }
 
         // all our threads should have been woken now, so join
         for (WorkerThreadList::iterator i = mWorkers.begin(); i != mWorkers.end(); ++i)
@@ -151,7 +155,7 @@ namespace Ogre
 #if OGRE_THREAD_SUPPORT
         // Lock; note that OGRE_THREAD_WAIT will free the lock
             OGRE_LOCK_MUTEX_NAMED(mRequestMutex, queueLock);
-        if (mRequestQueue.empty())
+        if (mRequestQueue.empty() && !mShuttingDown)
         {
             // frees lock and suspends the thread
             OGRE_THREAD_WAIT(mRequestCondition, mRequestMutex, queueLock);
@@ -0,0 +1,1174 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+#include "Threading/OgreStealingWorkQueue.h"
+#include "OgreLogManager.h"
+#include "OgreRoot.h"
+#include "OgreRenderSystem.h"
+#include "OgreTimer.h"
+
+namespace Ogre
+{
+    namespace
+    {
+        /** Deque of requests which one thread pushes to, and any thread takes from
+            without locking (Chase & Lev, with the memory orders of Le et al.).
+        @remarks
+            Unlike the usual work stealing deque the owner takes from the same end as
+            thieves, so requests are processed in the order they were added.
+        */
+        class RequestDeque
+        {
+        public:
+            RequestDeque()
+                : mTop(0), mBottom(0), mBuffer(createBuffer(64, 0))
+            {
+            }
+
+            ~RequestDeque()
+            {
+                Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+                while (buffer)
+                {
+                    Buffer* previous = buffer->previous;
+                    destroyBuffer(buffer);
+                    buffer = previous;
+                }
+            }
+
+            /// Adds a request at the bottom, only called by the owning thread
+            void push(WorkQueue::Request* r)
+            {
+                const int64 bottom = mBottom.load(std::memory_order_relaxed);
+                const int64 top = mTop.load(std::memory_order_acquire);
+                Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+                if (bottom - top > static_cast<int64>(buffer->mask))
+                {
+                    // Thieves may still be reading the old buffer, it is freed with the deque
+                    Buffer* grown = createBuffer((buffer->mask + 1) * 2, buffer);
+                    for (int64 i = top; i < bottom; ++i)
+                    {
+                        grown->items[i & grown->mask].store(
+                            buffer->items[i & buffer->mask].load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+                    }
+                    mBuffer.store(grown, std::memory_order_release);
+                    buffer = grown;
+                }
+                buffer->items[bottom & buffer->mask].store(r, std::memory_order_relaxed);
+                mBottom.store(bottom + 1, std::memory_order_release);
+            }
+
+            /// Takes the request at the top, from any thread; null if empty
+            WorkQueue::Request* steal()
+            {
+                for (;;)
+                {
+                    int64 top = mTop.load(std::memory_order_acquire);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    const int64 bottom = mBottom.load(std::memory_order_acquire);
+                    if (top >= bottom)
+                        return 0;
+
+                    Buffer* buffer = mBuffer.load(std::memory_order_acquire);
+                    WorkQueue::Request* r = buffer->items[top & buffer->mask].load(std::memory_order_relaxed);
+                    if (mTop.compare_exchange_strong(top, top + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        return r;
+                    }
+                    // Another thread took it first, try the next one
+                }
+            }
+
+        private:
+            struct Buffer
+            {
+                size_t mask;
+                std::atomic<WorkQueue::Request*>* items;
+                /// Buffer this one replaced
+                Buffer* previous;
+            };
+
+            static Buffer* createBuffer(size_t size, Buffer* previous)
+            {
+                Buffer* buffer = OGRE_NEW_T(Buffer, MEMCATEGORY_GENERAL);
+                buffer->mask = size - 1;
+                buffer->items = OGRE_NEW_ARRAY_T(std::atomic<WorkQueue::Request*>, size, MEMCATEGORY_GENERAL);
+                buffer->previous = previous;
+                return buffer;
+            }
+
+            static void destroyBuffer(Buffer* buffer)
+            {
+                typedef std::atomic<WorkQueue::Request*> AtomicRequest;
+                OGRE_DELETE_ARRAY_T(buffer->items, AtomicRequest, buffer->mask + 1, MEMCATEGORY_GENERAL);
+                OGRE_DELETE_T(buffer, Buffer, MEMCATEGORY_GENERAL);
+            }
+
+            std::atomic<int64> mTop;
+            /// Keeps thieves and the owner on separate cache lines
+            char mPadding[64];
+            std::atomic<int64> mBottom;
+            std::atomic<Buffer*> mBuffer;
+        };
+
+        /// Worker of a StealingWorkQueue run by the current thread
+        thread_local void* tCurrentWorker = 0;
+
+        /// A request the current thread is handling, see RequestHandlerHolder::handleRequest
+        struct ActiveRequest
+        {
+            const void* holder;
+            /// The request this one is handled within, if any
+            const ActiveRequest* outer;
+        };
+        /// Innermost request handled by the current thread
+        thread_local const ActiveRequest* tActiveRequest = 0;
+
+        /// Counts the calling thread as a reader of the request handlers until destroyed
+        struct HandlerReadScope
+        {
+            std::atomic<size_t>* mReaders;
+
+            HandlerReadScope(std::atomic<size_t>* readers, const std::atomic<size_t>& epoch)
+            {
+                // Once counted, the epoch can't advance past ours without us being done
+                for (;;)
+                {
+                    const size_t current = epoch.load();
+                    mReaders = &readers[current & 1];
+                    mReaders->fetch_add(1);
+                    if (epoch.load() == current)
+                        break;
+                    mReaders->fetch_sub(1);
+                }
+            }
+            ~HandlerReadScope() { mReaders->fetch_sub(1); }
+        };
+    }
+    //---------------------------------------------------------------------
+    struct StealingWorkQueue::Worker
+    {
+        const StealingWorkQueue* mQueue;
+        size_t mIndex;
+        /// Stack of the requests added by other threads, newest first
+        std::atomic<Request*> mInbox;
+        char mPadding[64];
+        /// Requests taken from mInbox or added by this worker, in order
+        RequestDeque mDeque;
+
+        Worker(const StealingWorkQueue* queue, size_t index)
+            : mQueue(queue), mIndex(index), mInbox(0) {}
+    };
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::RequestHandlerHolder::disconnectHandler()
+    {
+        mHandler.store(0);
+        // A handler may remove itself, its requests on this thread are further up the stack
+        size_t numOwnRequests = 0;
+        for (const ActiveRequest* r = tActiveRequest; r; r = r->outer)
+        {
+            if (r->holder == this)
+                ++numOwnRequests;
+        }
+        while (mActiveCount.load() > numOwnRequests)
+            OGRE_THREAD_YIELD;
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Response* StealingWorkQueue::RequestHandlerHolder::handleRequest(
+        const Request* req, const WorkQueue* srcQ)
+    {
+        // Keeps the handler from being disconnected until we return, or throw
+        struct ActiveScope
+        {
+            std::atomic<size_t>& mCount;
+            ActiveRequest mRequest;
+
+            ActiveScope(const RequestHandlerHolder* holder, std::atomic<size_t>& count) : mCount(count)
+            {
+                mRequest.holder = holder;
+                mRequest.outer = tActiveRequest;
+                tActiveRequest = &mRequest;
+                mCount.fetch_add(1);
+            }
+            ~ActiveScope()
+            {
+                mCount.fetch_sub(1);
+                tActiveRequest = mRequest.outer;
+            }
+        } scope(this, mActiveCount);
+
+        Response* response = 0;
+        RequestHandler* handler = mHandler.load();
+        if (handler && handler->canHandleRequest(req, srcQ))
+        {
+            response = handler->handleRequest(req, srcQ);
+        }
+        return response;
+    }
+    //---------------------------------------------------------------------
+    StealingWorkQueue::StealingWorkQueue(const String& name)
+        : mName(name)
+        , mWorkerThreadCount(1)
+        , mWorkerRenderSystemAccess(false)
+        , mIsRunning(false)
+        , mResponseTimeLimitMS(8)
+        , mPaused(false)
+        , mAcceptRequests(true)
+        , mShuttingDown(false)
+        , mRequestCount(0)
+        , mNextWorker(0)
+        , mNumQueuedRequests(0)
+        , mNumOutstandingRequests(0)
+        , mIdleRequests(0)
+        , mIdleThreadRunning(false)
+        , mResponses(0)
+        , mRequestHandlers(0)
+        , mHandlerEpoch(0)
+        , mNumRetiredRequestHandlers(0)
+        , mMaxAbortedID(0)
+        , mNumWaitingWorkers(0)
+        , mNumThreadsRegisteredWithRS(0)
+    {
+        for (size_t i = 0; i < NUM_CHANNEL_BUCKETS; ++i)
+            mNumOutstandingByChannel[i].store(0);
+        mHandlerReaders[0].store(0);
+        mHandlerReaders[1].store(0);
+        setRequestHandlers(OGRE_NEW_T(RequestHandlerListByChannel, MEMCATEGORY_GENERAL)());
+        // Requests can be added before startup
+        resizeWorkers(1);
+    }
+    //---------------------------------------------------------------------
+    StealingWorkQueue::~StealingWorkQueue()
+    {
+        shutdown();
+
+        for (WorkerList::iterator i = mWorkers.begin(); i != mWorkers.end(); ++i)
+        {
+            while (Request* r = (*i)->mDeque.steal())
+                OGRE_DELETE r;
+            for (Request* r = (*i)->mInbox.load(); r; )
+            {
+                Request* next = r->mNextQueued;
+                OGRE_DELETE r;
+                r = next;
+            }
+            OGRE_DELETE_T(*i, Worker, MEMCATEGORY_GENERAL);
+        }
+        mWorkers.clear();
+
+        for (Request* r = mIdleRequests.load(); r; )
+        {
+            Request* next = r->mNextQueued;
+            OGRE_DELETE r;
+            r = next;
+        }
+
+        for (Response* r = mResponses.load(); r; )
+        {
+            Response* next = r->mNextQueued;
+            OGRE_DELETE r;
+            r = next;
+        }
+        for (ResponseQueue::iterator i = mPendingResponses.begin(); i != mPendingResponses.end(); ++i)
+        {
+            OGRE_DELETE (*i);
+        }
+        mPendingResponses.clear();
+
+        // The holders still connected are only in the current map
+        RequestHandlerListByChannel* handlers = mRequestHandlers.load();
+        for (RequestHandlerListByChannel::const_iterator i = handlers->begin(); i != handlers->end(); ++i)
+        {
+            for (size_t j = 0; j < i->second.size(); ++j)
+                OGRE_DELETE_T(i->second[j], RequestHandlerHolder, MEMCATEGORY_GENERAL);
+        }
+        OGRE_DELETE_T(handlers, RequestHandlerListByChannel, MEMCATEGORY_GENERAL);
+        for (size_t i = 0; i < mRetiredRequestHandlers.size(); ++i)
+        {
+            const RetiredRequestHandlers& retired = mRetiredRequestHandlers[i];
+            if (retired.handlers)
+                OGRE_DELETE_T(retired.handlers, RequestHandlerListByChannel, MEMCATEGORY_GENERAL);
+            if (retired.holder)
+                OGRE_DELETE_T(retired.holder, RequestHandlerHolder, MEMCATEGORY_GENERAL);
+        }
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::resizeWorkers(size_t numWorkers)
+    {
+        if (mWorkers.size() == numWorkers)
+            return;
+
+        // No thread is running, gather the requests of the old workers in order
+        Request* newest = 0;
+        Request* oldest = 0;
+        for (WorkerList::iterator i = mWorkers.begin(); i != mWorkers.end(); ++i)
+        {
+            Request* inbox = reverseRequests((*i)->mInbox.exchange(0));
+            for (;;)
+            {
+                Request* r = (*i)->mDeque.steal();
+                if (!r)
+                {
+                    r = inbox;
+                    if (!r)
+                        break;
+                    inbox = inbox->mNextQueued;
+                }
+                r->mNextQueued = newest;
+                newest = r;
+                if (!oldest)
+                    oldest = r;
+            }
+            OGRE_DELETE_T(*i, Worker, MEMCATEGORY_GENERAL);
+        }
+
+        mWorkers.clear();
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            mWorkers.push_back(OGRE_NEW_T(Worker, MEMCATEGORY_GENERAL)(this, i));
+        }
+        // The workers will share them out by stealing
+        if (newest)
+            pushRequests(mWorkers[0]->mInbox, newest, oldest);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::startup(bool forceRestart)
+    {
+        if (mIsRunning)
+        {
+            if (forceRestart)
+                shutdown();
+            else
+                return;
+        }
+
+        mShuttingDown.store(false);
+
+        LogManager::getSingleton().stream() <<
+            "StealingWorkQueue('" << mName << "') initialising on thread " <<
+#if OGRE_THREAD_SUPPORT
+            OGRE_THREAD_CURRENT_ID
+#else
+            "main"
+#endif
+            << ".";
+
+        resizeWorkers(std::max(mWorkerThreadCount, size_t(1)));
+
+#if OGRE_THREAD_SUPPORT
+        if (mWorkerRenderSystemAccess)
+            Root::getSingleton().getRenderSystem()->preExtraThreadsStarted();
+
+        mNumThreadsRegisteredWithRS = 0;
+        for (size_t i = 0; i < mWorkerThreadCount; ++i)
+        {
+            WorkerFunc* func = OGRE_NEW_T(WorkerFunc(this, i), MEMCATEGORY_GENERAL);
+            mWorkerFuncs.push_back(func);
+            OGRE_THREAD_CREATE(t, *func);
+            mWorkerThreads.push_back(t);
+        }
+
+        if (mWorkerRenderSystemAccess)
+        {
+            OGRE_LOCK_MUTEX_NAMED(mInitMutex, initLock);
+            // have to wait until all threads are registered with the render system
+            while (mNumThreadsRegisteredWithRS < mWorkerThreadCount)
+                OGRE_THREAD_WAIT(mInitSync, mInitMutex, initLock);
+
+            Root::getSingleton().getRenderSystem()->postExtraThreadsStarted();
+        }
+#endif
+
+        mIsRunning = true;
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::shutdown()
+    {
+        if (!mIsRunning)
+            return;
+
+        LogManager::getSingleton().stream() <<
+            "StealingWorkQueue('" << mName << "') shutting down on thread " <<
+#if OGRE_THREAD_SUPPORT
+            OGRE_THREAD_CURRENT_ID
+#else
+            "main"
+#endif
+            << ".";
+
+        mShuttingDown.store(true);
+        abortAllRequests();
+#if OGRE_THREAD_SUPPORT
+        {
+            // wake all threads, they check for shutting down after waiting
+            OGRE_LOCK_MUTEX(mWaitMutex);
+            OGRE_THREAD_NOTIFY_ALL(mWaitCondition);
+        }
+
+        for (WorkerThreadList::iterator i = mWorkerThreads.begin(); i != mWorkerThreads.end(); ++i)
+        {
+            (*i)->join();
+            OGRE_THREAD_DESTROY(*i);
+        }
+        mWorkerThreads.clear();
+#endif
+
+        for (WorkerFuncList::iterator i = mWorkerFuncs.begin(); i != mWorkerFuncs.end(); ++i)
+        {
+            OGRE_DELETE_T(*i, WorkerFunc, MEMCATEGORY_GENERAL);
+        }
+        mWorkerFuncs.clear();
+
+        mIsRunning = false;
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::_threadMain(size_t workerIndex)
+    {
+#if OGRE_THREAD_SUPPORT
+        LogManager::getSingleton().stream() <<
+            "StealingWorkQueue('" << mName << "')::WorkerFunc - thread "
+            << OGRE_THREAD_CURRENT_ID << " starting.";
+
+        // Initialise the thread for RS if necessary
+        if (mWorkerRenderSystemAccess)
+        {
+            Root::getSingleton().getRenderSystem()->registerThread();
+
+            OGRE_LOCK_MUTEX(mInitMutex);
+            ++mNumThreadsRegisteredWithRS;
+            OGRE_THREAD_NOTIFY_ALL(mInitSync);
+        }
+
+        tCurrentWorker = mWorkers[workerIndex];
+        while (!isShuttingDown())
+        {
+            if (!_processNextRequest())
+                waitForRequests();
+        }
+        tCurrentWorker = 0;
+
+        LogManager::getSingleton().stream() <<
+            "StealingWorkQueue('" << mName << "')::WorkerFunc - thread "
+            << OGRE_THREAD_CURRENT_ID << " stopped.";
+#endif
+    }
+    //---------------------------------------------------------------------
+    StealingWorkQueue::Worker* StealingWorkQueue::getCurrentWorker() const
+    {
+        Worker* worker = static_cast<Worker*>(tCurrentWorker);
+        return worker && worker->mQueue == this ? worker : 0;
+    }
+    //---------------------------------------------------------------------
+    bool StealingWorkQueue::hasRequests() const
+    {
+        if (isPaused())
+            return false;
+        return mNumQueuedRequests.load() ||
+            (mIdleRequests.load() && !mIdleThreadRunning.load());
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::waitForRequests()
+    {
+#if OGRE_THREAD_SUPPORT
+        if (hasRequests())
+        {
+            // Queued but not visible yet, or taken by another thread
+            OGRE_THREAD_YIELD;
+            return;
+        }
+
+        OGRE_LOCK_MUTEX_NAMED(mWaitMutex, waitLock);
+        mNumWaitingWorkers.fetch_add(1);
+        // Whoever queues a request after this sees us waiting and notifies us,
+        // once we have released the lock in OGRE_THREAD_WAIT
+        while (!isShuttingDown() && !hasRequests())
+            OGRE_THREAD_WAIT(mWaitCondition, mWaitMutex, waitLock);
+        mNumWaitingWorkers.fetch_sub(1);
+#endif
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::notifyWorkers(bool all)
+    {
+#if OGRE_THREAD_SUPPORT
+        // Pairs with the check of waitForRequests, so that either we see the worker
+        // waiting or it sees the requests
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!mNumWaitingWorkers.load())
+            return;
+
+        OGRE_LOCK_MUTEX(mWaitMutex);
+        if (all)
+            OGRE_THREAD_NOTIFY_ALL(mWaitCondition);
+        else
+            OGRE_THREAD_NOTIFY_ONE(mWaitCondition);
+#endif
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::pushRequests(std::atomic<Request*>& stack, Request* newest, Request* oldest)
+    {
+        Request* head = stack.load(std::memory_order_relaxed);
+        do
+        {
+            oldest->mNextQueued = head;
+        }
+        while (!stack.compare_exchange_weak(head, newest,
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Request* StealingWorkQueue::reverseRequests(Request* first)
+    {
+        Request* reversed = 0;
+        while (first)
+        {
+            Request* next = first->mNextQueued;
+            first->mNextQueued = reversed;
+            reversed = first;
+            first = next;
+        }
+        return reversed;
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::pushToDeque(Worker* worker, Request* newest)
+    {
+        for (Request* r = reverseRequests(newest); r; )
+        {
+            Request* next = r->mNextQueued;
+            r->mNextQueued = 0;
+            worker->mDeque.push(r);
+            r = next;
+        }
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::queueRequests(Request* newest, Request* oldest, size_t numRequests)
+    {
+        // Counted first so that the count is never lower than the requests queued
+        mNumQueuedRequests.fetch_add(numRequests);
+
+        Worker* self = getCurrentWorker();
+        if (self)
+        {
+            pushToDeque(self, newest);
+        }
+        else
+        {
+            size_t index = mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+            pushRequests(mWorkers[index]->mInbox, newest, oldest);
+        }
+
+        notifyWorkers(numRequests > 1);
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Request* StealingWorkQueue::takeRequest(Worker* self)
+    {
+        if (self)
+        {
+            if (Request* r = self->mDeque.steal())
+                return r;
+
+            // Move our inbox where the others can steal from
+            if (Request* inbox = self->mInbox.exchange(0, std::memory_order_acquire))
+            {
+                pushToDeque(self, inbox);
+                if (Request* r = self->mDeque.steal())
+                    return r;
+            }
+        }
+
+        const size_t numWorkers = mWorkers.size();
+        const size_t start = self ? self->mIndex + 1 : 0;
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            Worker* victim = mWorkers[(start + i) % numWorkers];
+            if (victim != self)
+            {
+                if (Request* r = victim->mDeque.steal())
+                    return r;
+            }
+        }
+
+        // The other workers may be busy with a long request, take their inboxes too
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            Worker* victim = mWorkers[(start + i) % numWorkers];
+            if (victim == self)
+                continue;
+            Request* inbox = victim->mInbox.exchange(0, std::memory_order_acquire);
+            if (!inbox)
+                continue;
+
+            if (self)
+            {
+                pushToDeque(self, inbox);
+                if (Request* r = self->mDeque.steal())
+                    return r;
+            }
+            else
+            {
+                // No deque of our own, keep the oldest and give the others back
+                Request* previous = 0;
+                Request* oldest = inbox;
+                while (oldest->mNextQueued)
+                {
+                    previous = oldest;
+                    oldest = oldest->mNextQueued;
+                }
+                if (previous)
+                {
+                    previous->mNextQueued = 0;
+                    pushRequests(victim->mInbox, inbox, previous);
+                }
+                return oldest;
+            }
+        }
+
+        return 0;
+    }
+    //---------------------------------------------------------------------
+    bool StealingWorkQueue::_processNextRequest()
+    {
+        if (isPaused())
+            return false;
+
+        if (processIdleRequests())
+            return true;
+
+        Request* request = takeRequest(getCurrentWorker());
+        if (!request)
+            return false;
+
+        mNumQueuedRequests.fetch_sub(1);
+        processRequestResponse(request, false);
+        return true;
+    }
+    //---------------------------------------------------------------------
+    bool StealingWorkQueue::processIdleRequests()
+    {
+        if (!mIdleRequests.load(std::memory_order_relaxed) || mIdleThreadRunning.exchange(true))
+            return false;
+
+        bool processed = false;
+        for (;;)
+        {
+            Request* r = reverseRequests(mIdleRequests.exchange(0, std::memory_order_acquire));
+            if (!r)
+            {
+                mIdleThreadRunning.store(false);
+                // Requests added while we were stopping would be left waiting otherwise
+                if (!mIdleRequests.load() || mIdleThreadRunning.exchange(true))
+                    return processed;
+                continue;
+            }
+
+            while (r)
+            {
+                Request* next = r->mNextQueued;
+                r->mNextQueued = 0;
+                processed = true;
+                try
+                {
+                    processRequestResponse(r, false);
+                }
+                catch (...)
+                {
+                    // Give back the rest, or the idle requests would be stuck forever
+                    if (next)
+                        pushRequests(mIdleRequests, reverseRequests(next), next);
+                    mIdleThreadRunning.store(false);
+                    LogManager::getSingleton().stream() << "Exception caught in top of worker thread!";
+                    return true;
+                }
+                r = next;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::RequestID StealingWorkQueue::addRequest(uint16 channel, uint16 requestType,
+        const Any& rData, uint8 retryCount, bool forceSynchronous, bool idleThread)
+    {
+        if (!getRequestsAccepted() || isShuttingDown())
+            return 0;
+
+        // Counted before getting an ID, see processResponses
+        addOutstandingRequests(channel, 1);
+        RequestID rid = mRequestCount.fetch_add(1) + 1;
+        Request* req = OGRE_NEW Request(channel, requestType, rData, retryCount, rid);
+
+#if OGRE_THREAD_SUPPORT
+        if (!forceSynchronous)
+        {
+            if (idleThread)
+            {
+                pushRequests(mIdleRequests, req, req);
+                notifyWorkers(false);
+            }
+            else
+            {
+                queueRequests(req, req, 1);
+            }
+            return rid;
+        }
+#endif
+        processRequestResponse(req, true);
+        return rid;
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::addRequests(uint16 channel, uint16 requestType, const Any* rData,
+        size_t count, uint8 retryCount, RequestID* outIDs)
+    {
+        if (!getRequestsAccepted() || isShuttingDown())
+        {
+            if (outIDs)
+                std::fill(outIDs, outIDs + count, RequestID(0));
+            return;
+        }
+        if (!count)
+            return;
+
+        addOutstandingRequests(channel, count);
+        const RequestID firstID = mRequestCount.fetch_add(count) + 1;
+
+        // A worker keeps them all in its deque, for the others to steal
+        const size_t numBatches = getCurrentWorker() ? 1 : std::min(count, mWorkers.size());
+        size_t begin = 0;
+        for (size_t batch = 0; batch < numBatches; ++batch)
+        {
+            const size_t end = count * (batch + 1) / numBatches;
+            Request* newest = 0;
+            Request* oldest = 0;
+            for (size_t i = begin; i < end; ++i)
+            {
+                Request* req = OGRE_NEW Request(channel, requestType, rData[i], retryCount, firstID + i);
+                if (outIDs)
+                    outIDs[i] = firstID + i;
+#if OGRE_THREAD_SUPPORT
+                req->mNextQueued = newest;
+                newest = req;
+                if (!oldest)
+                    oldest = req;
+#else
+                processRequestResponse(req, true);
+#endif
+            }
+            if (newest)
+                queueRequests(newest, oldest, end - begin);
+            begin = end;
+        }
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::processRequestResponse(Request* r, bool synchronous)
+    {
+        Response* response = processRequest(r);
+
+        if (response)
+        {
+            if (!response->succeeded())
+            {
+                // Failed, should we retry?
+                const Request* req = response->getRequest();
+                if (req->getRetryCount() && !isShuttingDown())
+                {
+                    Request* retry = OGRE_NEW Request(req->getChannel(), req->getType(), req->getData(),
+                        req->getRetryCount() - 1, req->getID());
+                    // discard response (this also deletes request)
+                    OGRE_DELETE response;
+#if OGRE_THREAD_SUPPORT
+                    queueRequests(retry, retry, 1);
+#else
+                    processRequestResponse(retry, true);
+#endif
+                    return;
+                }
+            }
+            if (synchronous)
+            {
+                const uint16 channel = r->getChannel();
+                processResponse(response);
+                OGRE_DELETE response;
+                removeOutstandingRequest(channel);
+            }
+            else
+            {
+                if (isAborted(response->getRequest(), true))
+                {
+                    // destroy response user data
+                    response->abortRequest();
+                }
+                // no need to wake thread, this is processed by the main thread
+                Response* head = mResponses.load(std::memory_order_relaxed);
+                do
+                {
+                    response->mNextQueued = head;
+                }
+                while (!mResponses.compare_exchange_weak(head, response,
+                    std::memory_order_release, std::memory_order_relaxed));
+            }
+        }
+        else
+        {
+            if (!r->getAborted())
+            {
+                // no response, delete request
+                LogManager::getSingleton().stream() <<
+                    "StealingWorkQueue('" << mName << "') warning: no handler processed request "
+                    << r->getID() << ", channel " << r->getChannel()
+                    << ", type " << r->getType();
+            }
+            const uint16 channel = r->getChannel();
+            OGRE_DELETE r;
+            removeOutstandingRequest(channel);
+        }
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Response* StealingWorkQueue::processRequest(Request* r)
+    {
+        // Sets the abort flag checked by RequestHandler::canHandleRequest
+        isAborted(r, false);
+
+        Response* response = 0;
+        {
+            HandlerReadScope scope(mHandlerReaders, mHandlerEpoch);
+            const RequestHandlerListByChannel* handlers = mRequestHandlers.load();
+            RequestHandlerListByChannel::const_iterator i = handlers->find(r->getChannel());
+            if (i != handlers->end())
+            {
+                const RequestHandlerList& channelHandlers = i->second;
+                for (RequestHandlerList::const_reverse_iterator j = channelHandlers.rbegin();
+                    j != channelHandlers.rend() && !response; ++j)
+                {
+                    // threadsafe call which tests canHandleRequest and calls it if so
+                    response = (*j)->handleRequest(r, this);
+                }
+            }
+        }
+
+        // The handlers changed while we may have been using the old ones
+        if (mNumRetiredRequestHandlers.load(std::memory_order_relaxed))
+        {
+            OGRE_LOCK_MUTEX(mRequestHandlerMutex);
+            reclaimRequestHandlers();
+        }
+        return response;
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::processResponses()
+    {
+        unsigned long msStart = Root::getSingleton().getTimer()->getMilliseconds();
+
+        // The stack holds the newest first
+        Response* stacked = mResponses.exchange(0, std::memory_order_acquire);
+        size_t numStacked = 0;
+        for (Response* r = stacked; r; r = r->mNextQueued)
+            ++numStacked;
+        mPendingResponses.resize(mPendingResponses.size() + numStacked);
+        for (ResponseQueue::reverse_iterator i = mPendingResponses.rbegin(); stacked; ++i)
+        {
+            *i = stacked;
+            stacked = stacked->mNextQueued;
+        }
+
+        // keep going until we run out of responses or out of time
+        while (!mPendingResponses.empty())
+        {
+            Response* response = mPendingResponses.front();
+            mPendingResponses.pop_front();
+
+            if (isAborted(response->getRequest(), true))
+                response->abortRequest();
+            const uint16 channel = response->getRequest()->getChannel();
+            processResponse(response);
+            OGRE_DELETE response;
+            removeOutstandingRequest(channel);
+
+            // time limit
+            if (mResponseTimeLimitMS)
+            {
+                unsigned long msCurrent = Root::getSingleton().getTimer()->getMilliseconds();
+                if (msCurrent - msStart > mResponseTimeLimitMS)
+                    break;
+            }
+        }
+
+        // Once every request added before them is done, the aborts can be forgotten.
+        // Requests are counted before getting their ID, so those added later are not
+        // matched by the aborts anyway. The aborts of a channel only wait for the
+        // requests of its bucket, the others for all of them.
+        if (mMaxAbortedID.load(std::memory_order_relaxed))
+        {
+            OGRE_LOCK_MUTEX(mAbortMutex);
+            const bool drained = !mNumOutstandingRequests.load();
+            RequestID maxID = 0;
+            size_t numKept = 0;
+            for (size_t i = 0; i < mAbortRecords.size(); ++i)
+            {
+                const AbortRecord& record = mAbortRecords[i];
+                if (drained || (!record.anyChannel &&
+                    !mNumOutstandingByChannel[getChannelBucket(record.channel)].load()))
+                {
+                    continue;
+                }
+                maxID = std::max(maxID, record.maxID);
+                mAbortRecords[numKept++] = record;
+            }
+            mAbortRecords.resize(numKept);
+            // Requests with a higher ID are not matched by the records left
+            mMaxAbortedID.store(maxID, std::memory_order_release);
+        }
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::addOutstandingRequests(uint16 channel, size_t numRequests)
+    {
+        mNumOutstandingByChannel[getChannelBucket(channel)].fetch_add(numRequests);
+        mNumOutstandingRequests.fetch_add(numRequests);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::removeOutstandingRequest(uint16 channel)
+    {
+        mNumOutstandingByChannel[getChannelBucket(channel)].fetch_sub(1);
+        mNumOutstandingRequests.fetch_sub(1);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::processResponse(Response* r)
+    {
+        ResponseHandlerListByChannel::iterator i = mResponseHandlers.find(r->getRequest()->getChannel());
+        if (i != mResponseHandlers.end())
+        {
+            ResponseHandlerList& handlers = i->second;
+            for (ResponseHandlerList::reverse_iterator j = handlers.rbegin(); j != handlers.rend(); ++j)
+            {
+                if ((*j)->canHandleResponse(r, this))
+                {
+                    (*j)->handleResponse(r, this);
+                }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    bool StealingWorkQueue::isAborted(const Request* r, bool processed)
+    {
+        if (r->getAborted())
+            return true;
+        if (r->getID() > mMaxAbortedID.load(std::memory_order_acquire))
+            return false;
+
+        OGRE_LOCK_MUTEX(mAbortMutex);
+        for (AbortRecordList::const_iterator i = mAbortRecords.begin(); i != mAbortRecords.end(); ++i)
+        {
+            if (r->getID() > i->maxID || (i->pendingOnly && processed))
+                continue;
+            if (i->id && i->id != r->getID())
+                continue;
+            if (!i->anyChannel && i->channel != r->getChannel())
+                continue;
+            r->abortRequest();
+            return true;
+        }
+        return false;
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::addAbortRecord(RequestID id, bool anyChannel, uint16 channel, bool pendingOnly)
+    {
+        OGRE_LOCK_MUTEX(mAbortMutex);
+
+        AbortRecord record;
+        record.maxID = id ? id : mRequestCount.load();
+        record.id = id;
+        record.anyChannel = anyChannel;
+        record.channel = channel;
+        record.pendingOnly = pendingOnly;
+        mAbortRecords.push_back(record);
+
+        if (record.maxID > mMaxAbortedID.load(std::memory_order_relaxed))
+            mMaxAbortedID.store(record.maxID, std::memory_order_release);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::abortRequest(RequestID id)
+    {
+        if (id)
+            addAbortRecord(id, true, 0, false);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::abortRequestsByChannel(uint16 channel)
+    {
+        addAbortRecord(0, false, channel, false);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::abortPendingRequestsByChannel(uint16 channel)
+    {
+        addAbortRecord(0, false, channel, true);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::abortAllRequests()
+    {
+        addAbortRecord(0, true, 0, false);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::setPaused(bool pause)
+    {
+        mPaused.store(pause);
+        if (!pause)
+            notifyWorkers(true);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::setRequestHandlers(RequestHandlerListByChannel* handlers,
+        RequestHandlerHolder* holder)
+    {
+        // Threads may still be reading the old map, it is deleted once they are done
+        RequestHandlerListByChannel* old = mRequestHandlers.exchange(handlers);
+        RetiredRequestHandlers retired;
+        retired.epoch = mHandlerEpoch.load();
+        retired.handlers = old;
+        retired.holder = holder;
+        if (old || holder)
+            mRetiredRequestHandlers.push_back(retired);
+        reclaimRequestHandlers();
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::reclaimRequestHandlers()
+    {
+        // Readers which started before the current epoch may be using anything retired
+        // until then; readers of the current epoch got a map published after it
+        while (!mRetiredRequestHandlers.empty())
+        {
+            const size_t epoch = mHandlerEpoch.load();
+            if (mHandlerReaders[(epoch + 1) & 1].load())
+                break;
+
+            size_t numKept = 0;
+            for (size_t i = 0; i < mRetiredRequestHandlers.size(); ++i)
+            {
+                const RetiredRequestHandlers& retired = mRetiredRequestHandlers[i];
+                if (retired.epoch == epoch)
+                {
+                    mRetiredRequestHandlers[numKept++] = retired;
+                    continue;
+                }
+                if (retired.handlers)
+                    OGRE_DELETE_T(retired.handlers, RequestHandlerListByChannel, MEMCATEGORY_GENERAL);
+                if (retired.holder)
+                    OGRE_DELETE_T(retired.holder, RequestHandlerHolder, MEMCATEGORY_GENERAL);
+            }
+            mRetiredRequestHandlers.resize(numKept);
+
+            // The ones left can go once the readers of the current epoch are done
+            if (numKept)
+                mHandlerEpoch.store(epoch + 1);
+        }
+        mNumRetiredRequestHandlers.store(mRetiredRequestHandlers.size(), std::memory_order_relaxed);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::addRequestHandler(uint16 channel, RequestHandler* rh)
+    {
+        OGRE_LOCK_MUTEX(mRequestHandlerMutex);
+
+        const RequestHandlerListByChannel* current = mRequestHandlers.load();
+        RequestHandlerListByChannel::const_iterator i = current->find(channel);
+        if (i != current->end())
+        {
+            for (RequestHandlerList::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+            {
+                if ((*j)->mHandler.load() == rh)
+                    return;
+            }
+        }
+
+        RequestHandlerHolder* holder = OGRE_NEW_T(RequestHandlerHolder, MEMCATEGORY_GENERAL)(rh);
+
+        RequestHandlerListByChannel* handlers =
+            OGRE_NEW_T(RequestHandlerListByChannel, MEMCATEGORY_GENERAL)(*current);
+        (*handlers)[channel].push_back(holder);
+        setRequestHandlers(handlers);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::removeRequestHandler(uint16 channel, RequestHandler* rh)
+    {
+        OGRE_LOCK_MUTEX(mRequestHandlerMutex);
+
+        const RequestHandlerListByChannel* current = mRequestHandlers.load();
+        RequestHandlerListByChannel::const_iterator i = current->find(channel);
+        if (i == current->end())
+            return;
+
+        for (size_t j = 0; j < i->second.size(); ++j)
+        {
+            RequestHandlerHolder* holder = i->second[j];
+            if (holder->mHandler.load() == rh)
+            {
+                RequestHandlerListByChannel* handlers =
+                    OGRE_NEW_T(RequestHandlerListByChannel, MEMCATEGORY_GENERAL)(*current);
+                RequestHandlerList& channelHandlers = (*handlers)[channel];
+                channelHandlers.erase(channelHandlers.begin() + j);
+
+                // Threads which got the handler before waits for the requests in progress
+                holder->disconnectHandler();
+                setRequestHandlers(handlers, holder);
+                break;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::addResponseHandler(uint16 channel, ResponseHandler* rh)
+    {
+        ResponseHandlerListByChannel::iterator i = mResponseHandlers.find(channel);
+        if (i == mResponseHandlers.end())
+            i = mResponseHandlers.insert(ResponseHandlerListByChannel::value_type(channel, ResponseHandlerList())).first;
+
+        ResponseHandlerList& handlers = i->second;
+        if (std::find(handlers.begin(), handlers.end(), rh) == handlers.end())
+            handlers.push_back(rh);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::removeResponseHandler(uint16 channel, ResponseHandler* rh)
+    {
+        ResponseHandlerListByChannel::iterator i = mResponseHandlers.find(channel);
+        if (i != mResponseHandlers.end())
+        {
+            ResponseHandlerList& handlers = i->second;
+            ResponseHandlerList::iterator j = std::find(
+                handlers.begin(), handlers.end(), rh);
+            if (j != handlers.end())
+                handlers.erase(j);
+        }
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::WorkerFunc::operator()()
+    {
+        mQueue->_threadMain(mIndex);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::WorkerFunc::operator()() const
+    {
+        mQueue->_threadMain(mIndex);
+    }
+    //---------------------------------------------------------------------
+    void StealingWorkQueue::WorkerFunc::run()
+    {
+        mQueue->_threadMain(mIndex);
+    }
+}
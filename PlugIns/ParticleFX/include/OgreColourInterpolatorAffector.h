@@ -73,6 +73,12 @@ namespace Ogre {
         /** See ParticleAffector. */
         void _affectParticles(ParticleSystem* pSystem, Real timeElapsed);
 
+        /** See ParticleAffector. */
+        bool _supportsParticleArrays(void) const { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticleArrays(ParticleArrays& particles, Real timeElapsed);
+
         void setColourAdjust(size_t index, ColourValue colour);
         ColourValue getColourAdjust(size_t index) const;
         
@@ -87,6 +93,9 @@ namespace Ogre {
         ColourValue             mColourAdj[MAX_STAGES];
         Real                    mTimeAdj[MAX_STAGES];
 
+        /** Sets the colour of a particle at the given fraction of its life,
+            leaving it alone if no stage covers that time. */
+        void interpolateColour(Real particleTime, ColourValue& colour) const;
     };
 
     /** @} */
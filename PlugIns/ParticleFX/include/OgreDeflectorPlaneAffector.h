@@ -81,6 +81,12 @@ namespace Ogre {
         /** See ParticleAffector. */
         void _affectParticles(ParticleSystem* pSystem, Real timeElapsed);
 
+        /** See ParticleAffector. */
+        bool _supportsParticleArrays(void) const { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticleArrays(ParticleArrays& particles, Real timeElapsed);
+
         /** Sets the plane point of the deflector plane. */
         void setPlanePoint(const Vector3& pos);
 
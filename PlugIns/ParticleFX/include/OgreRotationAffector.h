@@ -90,6 +90,12 @@ namespace Ogre {
         /** See ParticleAffector. */
         void _affectParticles(ParticleSystem* pSystem, Real timeElapsed);
 
+        /** See ParticleAffector. */
+        bool _supportsParticleArrays(void) const { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticleArrays(ParticleArrays& particles, Real timeElapsed);
+
 
 
         /** Sets the minimum rotation speed of particles to be emitted. */
@@ -29,6 +29,12 @@ THE SOFTWARE.
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
 
 
 namespace Ogre {
@@ -139,6 +145,47 @@ namespace Ogre {
 
     }
     //-----------------------------------------------------------------------
+    void ColourFaderAffector2::_affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        // Scale adjustments by time
+        const Real adjust1[4] = { mRedAdj1 * timeElapsed, mGreenAdj1 * timeElapsed,
+            mBlueAdj1 * timeElapsed, mAlphaAdj1 * timeElapsed };
+        const Real adjust2[4] = { mRedAdj2 * timeElapsed, mGreenAdj2 * timeElapsed,
+            mBlueAdj2 * timeElapsed, mAlphaAdj2 * timeElapsed };
+
+        Real* colours[4] = { particles.mColourR, particles.mColourG, particles.mColourB, particles.mColourA };
+        const Real* timeToLive = particles.mTimeToLive;
+        const size_t count = particles.mCount;
+        for (size_t c = 0; c < 4; ++c)
+        {
+            Real* colour = colours[c];
+            size_t i = 0;
+#if __OGRE_HAVE_SSE
+            __m128 adjust1_4 = _mm_set1_ps(adjust1[c]);
+            __m128 adjust2_4 = _mm_set1_ps(adjust2[c]);
+            __m128 stateChange = _mm_set1_ps(StateChangeVal);
+            __m128 zero = _mm_setzero_ps();
+            __m128 one = _mm_set1_ps(1.0f);
+            for (; i + 4 <= count; i += 4)
+            {
+                // Pick the adjustment of the state each particle is in
+                __m128 firstState = _mm_cmpgt_ps(_mm_load_ps(timeToLive + i), stateChange);
+                __m128 adjust = _mm_or_ps(_mm_and_ps(firstState, adjust1_4), _mm_andnot_ps(firstState, adjust2_4));
+                __m128 value = _mm_add_ps(_mm_load_ps(colour + i), adjust);
+                _mm_store_ps(colour + i, _mm_min_ps(_mm_max_ps(value, zero), one));
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                colour[i] += timeToLive[i] > StateChangeVal ? adjust1[c] : adjust2[c];
+                if (colour[i] < 0.0f)
+                    colour[i] = 0.0f;
+                else if (colour[i] > 1.0f)
+                    colour[i] = 1.0f;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void ColourFaderAffector2::setAdjust1(float red, float green, float blue, float alpha)
     {
         mRedAdj1 = red;
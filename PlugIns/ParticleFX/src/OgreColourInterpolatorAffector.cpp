@@ -29,6 +29,12 @@ THE SOFTWARE.
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
 
 
 namespace Ogre {
@@ -86,27 +92,88 @@ namespace Ogre {
             const Real      life_time       = p->mTotalTimeToLive;
             Real            particle_time   = 1.0f - (p->mTimeToLive / life_time);
 
-            if (particle_time <= mTimeAdj[0])
+            interpolateColour(particle_time, p->mColour);
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ColourInterpolatorAffector::_affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        Real* colours[4] = { particles.mColourR, particles.mColourG, particles.mColourB, particles.mColourA };
+        const Real* timeToLive = particles.mTimeToLive;
+        const Real* totalTimeToLive = particles.mTotalTimeToLive;
+        const size_t count = particles.mCount;
+        size_t i = 0;
+#if __OGRE_HAVE_SSE
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 firstTime = _mm_set1_ps(mTimeAdj[0]);
+        __m128 lastTime = _mm_set1_ps(mTimeAdj[MAX_STAGES - 1]);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 particleTime = _mm_sub_ps(one, _mm_div_ps(_mm_load_ps(timeToLive + i),
+                _mm_load_ps(totalTimeToLive + i)));
+            __m128 beforeFirst = _mm_cmple_ps(particleTime, firstTime);
+            __m128 afterLast = _mm_cmpge_ps(particleTime, lastTime);
+
+            // Which stages cover the time, and how far into each it is
+            __m128 inStage[MAX_STAGES - 1];
+            __m128 factor[MAX_STAGES - 1];
+            for (int s = 0; s < MAX_STAGES - 1; ++s)
             {
-                p->mColour = mColourAdj[0];
-            } else
-            if (particle_time >= mTimeAdj[MAX_STAGES - 1])
+                __m128 start = _mm_set1_ps(mTimeAdj[s]);
+                __m128 end = _mm_set1_ps(mTimeAdj[s + 1]);
+                inStage[s] = _mm_and_ps(_mm_cmpge_ps(particleTime, start), _mm_cmplt_ps(particleTime, end));
+                factor[s] = _mm_div_ps(_mm_sub_ps(particleTime, start), _mm_sub_ps(end, start));
+            }
+
+            for (size_t c = 0; c < 4; ++c)
             {
-                p->mColour = mColourAdj[MAX_STAGES-1];
-            } else
+                __m128 colour = _mm_load_ps(colours[c] + i);
+                // The first stage covering the time wins, as in interpolateColour
+                for (int s = MAX_STAGES - 2; s >= 0; --s)
+                {
+                    __m128 blended = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mColourAdj[s + 1][c]), factor[s]),
+                        _mm_mul_ps(_mm_set1_ps(mColourAdj[s][c]), _mm_sub_ps(one, factor[s])));
+                    colour = _mm_or_ps(_mm_and_ps(inStage[s], blended), _mm_andnot_ps(inStage[s], colour));
+                }
+                __m128 last = _mm_set1_ps(mColourAdj[MAX_STAGES - 1][c]);
+                colour = _mm_or_ps(_mm_and_ps(afterLast, last), _mm_andnot_ps(afterLast, colour));
+                __m128 first = _mm_set1_ps(mColourAdj[0][c]);
+                colour = _mm_or_ps(_mm_and_ps(beforeFirst, first), _mm_andnot_ps(beforeFirst, colour));
+                _mm_store_ps(colours[c] + i, colour);
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            ColourValue colour(colours[0][i], colours[1][i], colours[2][i], colours[3][i]);
+            interpolateColour(1.0f - (timeToLive[i] / totalTimeToLive[i]), colour);
+            for (size_t c = 0; c < 4; ++c)
+                colours[c][i] = colour[c];
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ColourInterpolatorAffector::interpolateColour(Real particle_time, ColourValue& colour) const
+    {
+        if (particle_time <= mTimeAdj[0])
+        {
+            colour = mColourAdj[0];
+        } else
+        if (particle_time >= mTimeAdj[MAX_STAGES - 1])
+        {
+            colour = mColourAdj[MAX_STAGES-1];
+        } else
+        {
+            for (int i=0;i<MAX_STAGES-1;i++)
             {
-                for (int i=0;i<MAX_STAGES-1;i++)
+                if (particle_time >= mTimeAdj[i] && particle_time < mTimeAdj[i + 1])
                 {
-                    if (particle_time >= mTimeAdj[i] && particle_time < mTimeAdj[i + 1])
-                    {
-                        particle_time -= mTimeAdj[i];
-                        particle_time /= (mTimeAdj[i+1]-mTimeAdj[i]);
-                        p->mColour.r = ((mColourAdj[i+1].r * particle_time) + (mColourAdj[i].r * (1.0f - particle_time)));
-                        p->mColour.g = ((mColourAdj[i+1].g * particle_time) + (mColourAdj[i].g * (1.0f - particle_time)));
-                        p->mColour.b = ((mColourAdj[i+1].b * particle_time) + (mColourAdj[i].b * (1.0f - particle_time)));
-                        p->mColour.a = ((mColourAdj[i+1].a * particle_time) + (mColourAdj[i].a * (1.0f - particle_time)));
-                        break;
-                    }
+                    particle_time -= mTimeAdj[i];
+                    particle_time /= (mTimeAdj[i+1]-mTimeAdj[i]);
+                    colour.r = ((mColourAdj[i+1].r * particle_time) + (mColourAdj[i].r * (1.0f - particle_time)));
+                    colour.g = ((mColourAdj[i+1].g * particle_time) + (mColourAdj[i].g * (1.0f - particle_time)));
+                    colour.b = ((mColourAdj[i+1].b * particle_time) + (mColourAdj[i].b * (1.0f - particle_time)));
+                    colour.a = ((mColourAdj[i+1].a * particle_time) + (mColourAdj[i].a * (1.0f - particle_time)));
+                    break;
                 }
             }
         }
@@ -28,7 +28,13 @@ THE SOFTWARE.
 #include "OgreDeflectorPlaneAffector.h"
 #include "OgreParticleSystem.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
 #include "OgreStringConverter.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
 
 
 namespace Ogre {
@@ -92,6 +98,94 @@ namespace Ogre {
         }
     }
     //-----------------------------------------------------------------------
+    void DeflectorPlaneAffector::_affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        // precalculate distance of plane from origin
+        Real planeDistance = - mPlaneNormal.dotProduct(mPlanePoint) / Math::Sqrt(mPlaneNormal.dotProduct(mPlaneNormal));
+
+        Real* posX = particles.mPositionX;
+        Real* posY = particles.mPositionY;
+        Real* posZ = particles.mPositionZ;
+        Real* dirX = particles.mDirectionX;
+        Real* dirY = particles.mDirectionY;
+        Real* dirZ = particles.mDirectionZ;
+        const size_t count = particles.mCount;
+        size_t i = 0;
+#if __OGRE_HAVE_SSE
+        __m128 nx = _mm_set1_ps(mPlaneNormal.x);
+        __m128 ny = _mm_set1_ps(mPlaneNormal.y);
+        __m128 nz = _mm_set1_ps(mPlaneNormal.z);
+        __m128 distance = _mm_set1_ps(planeDistance);
+        __m128 bounce = _mm_set1_ps(mBounce);
+        __m128 time = _mm_set1_ps(timeElapsed);
+        __m128 two = _mm_set1_ps(2.0f);
+        __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 px = _mm_load_ps(posX + i), py = _mm_load_ps(posY + i), pz = _mm_load_ps(posZ + i);
+            __m128 dx = _mm_load_ps(dirX + i), dy = _mm_load_ps(dirY + i), dz = _mm_load_ps(dirZ + i);
+            __m128 ex = _mm_mul_ps(dx, time), ey = _mm_mul_ps(dy, time), ez = _mm_mul_ps(dz, time);
+
+            // Particles crossing the plane this frame, from its front side
+            __m128 after = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_add_ps(px, ex)),
+                _mm_mul_ps(ny, _mm_add_ps(py, ey))), _mm_mul_ps(nz, _mm_add_ps(pz, ez))), distance);
+            __m128 a = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, px), _mm_mul_ps(ny, py)),
+                _mm_mul_ps(nz, pz)), distance);
+            __m128 hit = _mm_and_ps(_mm_cmple_ps(after, zero), _mm_cmpgt_ps(a, zero));
+            if (!_mm_movemask_ps(hit))
+                continue;
+
+            // for intersection point
+            __m128 s = _mm_div_ps(_mm_sub_ps(zero, a), _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, nx),
+                _mm_mul_ps(ey, ny)), _mm_mul_ps(ez, nz)));
+            __m128 partX = _mm_mul_ps(ex, s), partY = _mm_mul_ps(ey, s), partZ = _mm_mul_ps(ez, s);
+            // new position
+            __m128 newPX = _mm_add_ps(_mm_add_ps(px, partX), _mm_mul_ps(_mm_sub_ps(partX, ex), bounce));
+            __m128 newPY = _mm_add_ps(_mm_add_ps(py, partY), _mm_mul_ps(_mm_sub_ps(partY, ey), bounce));
+            __m128 newPZ = _mm_add_ps(_mm_add_ps(pz, partZ), _mm_mul_ps(_mm_sub_ps(partZ, ez), bounce));
+            // reflected direction
+            __m128 k = _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dy, ny)),
+                _mm_mul_ps(dz, nz)));
+            __m128 newDX = _mm_mul_ps(_mm_sub_ps(dx, _mm_mul_ps(k, nx)), bounce);
+            __m128 newDY = _mm_mul_ps(_mm_sub_ps(dy, _mm_mul_ps(k, ny)), bounce);
+            __m128 newDZ = _mm_mul_ps(_mm_sub_ps(dz, _mm_mul_ps(k, nz)), bounce);
+
+            _mm_store_ps(posX + i, _mm_or_ps(_mm_and_ps(hit, newPX), _mm_andnot_ps(hit, px)));
+            _mm_store_ps(posY + i, _mm_or_ps(_mm_and_ps(hit, newPY), _mm_andnot_ps(hit, py)));
+            _mm_store_ps(posZ + i, _mm_or_ps(_mm_and_ps(hit, newPZ), _mm_andnot_ps(hit, pz)));
+            _mm_store_ps(dirX + i, _mm_or_ps(_mm_and_ps(hit, newDX), _mm_andnot_ps(hit, dx)));
+            _mm_store_ps(dirY + i, _mm_or_ps(_mm_and_ps(hit, newDY), _mm_andnot_ps(hit, dy)));
+            _mm_store_ps(dirZ + i, _mm_or_ps(_mm_and_ps(hit, newDZ), _mm_andnot_ps(hit, dz)));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            Vector3 position(posX[i], posY[i], posZ[i]);
+            Vector3 dir(dirX[i], dirY[i], dirZ[i]);
+            Vector3 direction(dir * timeElapsed);
+            if (mPlaneNormal.dotProduct(position + direction) + planeDistance <= 0.0)
+            {
+                Real a = mPlaneNormal.dotProduct(position) + planeDistance;
+                if (a > 0.0)
+                {
+                    // for intersection point
+                    Vector3 directionPart = direction * (- a / direction.dotProduct( mPlaneNormal ));
+                    // set new position
+                    position = (position + ( directionPart )) + (((directionPart) - direction) * mBounce);
+                    posX[i] = position.x;
+                    posY[i] = position.y;
+                    posZ[i] = position.z;
+
+                    // reflect direction vector
+                    dir = (dir - (2.0f * dir.dotProduct( mPlaneNormal ) * mPlaneNormal)) * mBounce;
+                    dirX[i] = dir.x;
+                    dirY[i] = dir.y;
+                    dirZ[i] = dir.z;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void DeflectorPlaneAffector::setPlanePoint(const Vector3& pos)
     {
         mPlanePoint = pos;
@@ -28,7 +28,13 @@ THE SOFTWARE.
 #include "OgreLinearForceAffector.h"
 #include "OgreParticleSystem.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
 #include "OgreStringConverter.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
 
 
 namespace Ogre {
@@ -95,6 +101,38 @@ namespace Ogre {
         
     }
     //-----------------------------------------------------------------------
+    void LinearForceAffector::_affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        // Both ways of applying the force come down to (direction + offset) * scale
+        Vector3 offset = mForceVector;
+        Real scale = 0.5f;
+        if (mForceApplication == FA_ADD)
+        {
+            offset *= timeElapsed;
+            scale = 1.0f;
+        }
+
+        Real* directions[3] = { particles.mDirectionX, particles.mDirectionY, particles.mDirectionZ };
+        const size_t count = particles.mCount;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            Real* dir = directions[c];
+            size_t i = 0;
+#if __OGRE_HAVE_SSE
+            __m128 off4 = _mm_set1_ps(offset[c]);
+            __m128 scale4 = _mm_set1_ps(scale);
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_store_ps(dir + i, _mm_mul_ps(_mm_add_ps(_mm_load_ps(dir + i), off4), scale4));
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                dir[i] = (dir[i] + offset[c]) * scale;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void LinearForceAffector::setForceVector(const Vector3& force)
     {
         mForceVector = force;
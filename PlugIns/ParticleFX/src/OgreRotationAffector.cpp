@@ -29,6 +29,12 @@ THE SOFTWARE.
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
 
 
 namespace Ogre {
@@ -107,6 +113,31 @@ namespace Ogre {
 
     }
     //-----------------------------------------------------------------------
+    void RotationAffector::_affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        const size_t count = particles.mCount;
+        if (!count)
+            return;
+
+        Real* rotation = particles.mRotation;
+        const Real* rotationSpeed = particles.mRotationSpeed;
+        size_t i = 0;
+#if __OGRE_HAVE_SSE
+        __m128 ds = _mm_set1_ps(timeElapsed);
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_store_ps(rotation + i, _mm_add_ps(_mm_load_ps(rotation + i),
+                _mm_mul_ps(ds, _mm_load_ps(rotationSpeed + i))));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            rotation[i] += timeElapsed * rotationSpeed[i];
+        }
+
+        mParent->_notifyParticleRotated();
+    }
+    //-----------------------------------------------------------------------
     const Radian& RotationAffector::getRotationSpeedRangeStart(void) const
     {
         return mRotationSpeedRangeStart;
@@ -29,6 +29,12 @@ THE SOFTWARE.
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 #include "OgreParticle.h"
+#include "OgreParticleArrays.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
 
 
 namespace Ogre {
@@ -85,6 +91,56 @@ namespace Ogre {
 
     }
     //-----------------------------------------------------------------------
+    void ScaleAffector::_affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+    {
+        const size_t count = particles.mCount;
+        if (!count)
+            return;
+
+        // Scale adjustments by time
+        Real ds = mScaleAdj * timeElapsed;
+        Real defaultWidth = mParent->getDefaultWidth();
+        Real defaultHeight = mParent->getDefaultHeight();
+
+        Real* width = particles.mWidth;
+        Real* height = particles.mHeight;
+        uint8* ownDimensions = particles.mOwnDimensions;
+        size_t i = 0;
+#if __OGRE_HAVE_SSE
+        __m128 ds4 = _mm_set1_ps(ds);
+        __m128 defaultWidth4 = _mm_set1_ps(defaultWidth);
+        __m128 defaultHeight4 = _mm_set1_ps(defaultHeight);
+        __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            // Particles without dimensions of their own start from the default ones
+            __m128 own = _mm_cmpneq_ps(_mm_setr_ps(ownDimensions[i], ownDimensions[i + 1],
+                ownDimensions[i + 2], ownDimensions[i + 3]), zero);
+            __m128 w = _mm_or_ps(_mm_and_ps(own, _mm_load_ps(width + i)), _mm_andnot_ps(own, defaultWidth4));
+            __m128 h = _mm_or_ps(_mm_and_ps(own, _mm_load_ps(height + i)), _mm_andnot_ps(own, defaultHeight4));
+            _mm_store_ps(width + i, _mm_add_ps(w, ds4));
+            _mm_store_ps(height + i, _mm_add_ps(h, ds4));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            if (ownDimensions[i])
+            {
+                width[i] += ds;
+                height[i] += ds;
+            }
+            else
+            {
+                width[i] = defaultWidth + ds;
+                height[i] = defaultHeight + ds;
+            }
+        }
+
+        // All the particles have dimensions of their own now
+        memset(ownDimensions, 1, count);
+        mParent->_notifyParticleResized();
+    }
+    //-----------------------------------------------------------------------
     void ScaleAffector::setAdjust( Real rate )
     {
         mScaleAdj = rate;
@@ -109,6 +109,10 @@ namespace Ogre {
         /// @copydoc Resource::unloadImpl
         void unloadImpl(void);
 
+        /** Parameters all constants were last uploaded from, only uploaded again
+            where modified since mLastBoundVersion. */
+        GpuProgramParametersSharedPtr mLastBoundParams;
+        unsigned long mLastBoundVersion;
     };
 
 
@@ -157,6 +157,7 @@ GLArbGpuProgram::GLArbGpuProgram(ResourceManager* creator, const String& name,
     ResourceHandle handle, const String& group, bool isManual, 
     ManualResourceLoader* loader) 
     : GLGpuProgram(creator, name, handle, group, isManual, loader)
+    , mLastBoundVersion(0)
 {
     glGenProgramsARB(1, &mProgramID);
 }
@@ -193,10 +194,16 @@ void GLArbGpuProgram::bindProgramParameters(GpuProgramParametersSharedPtr params
     // only supports float constants
     GpuLogicalBufferStructPtr floatStruct = params->getFloatLogicalBufferStruct();
 
+    // Local parameters are kept by the program, so when all were uploaded from
+    // these parameters before only the modified ones need uploading again
+    bool incremental = params == mLastBoundParams;
+
     for (GpuLogicalIndexUseMap::const_iterator i = floatStruct->map.begin();
         i != floatStruct->map.end(); ++i)
     {
-        if (i->second.variability & mask)
+        if (incremental ? params->_isRangeModifiedSince(BCT_FLOAT, i->second.physicalIndex,
+                              i->second.currentSize, mLastBoundVersion)
+                        : (i->second.variability & mask) != 0)
         {
             GLuint logicalIndex = static_cast<GLuint>(i->first);
             const float* pFloat = params->getFloatPointer(i->second.physicalIndex);
@@ -209,6 +216,16 @@ void GLArbGpuProgram::bindProgramParameters(GpuProgramParametersSharedPtr params
             }
         }
     }
+
+    if (incremental || mask == GPV_ALL)
+    {
+        mLastBoundParams = params;
+        mLastBoundVersion = params->_markConstantsUploaded();
+    }
+    else
+    {
+        mLastBoundParams.reset();
+    }
 }
 
 void GLArbGpuProgram::bindProgramPassIterationParameters(GpuProgramParametersSharedPtr params)
@@ -227,6 +244,7 @@ void GLArbGpuProgram::bindProgramPassIterationParameters(GpuProgramParametersSha
 
 void GLArbGpuProgram::unloadImpl(void)
 {
+    mLastBoundParams.reset();
     glDeleteProgramsARB(1, &mProgramID);
 }
 
@@ -41,6 +41,9 @@ protected:
     String mTestPath;
     size_t mFileSizeRoot1;
     size_t mFileSizeRoot2;
+    /// Process wide settings changed by the memory mapping test
+    bool mUseMemoryMapping;
+    size_t mMemoryMappingThreshold;
 
 public:
     void SetUp();
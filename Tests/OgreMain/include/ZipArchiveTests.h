@@ -42,4 +42,14 @@ public:
     void TearDown();
 };
 
+class MappedZipArchiveTests : public ::testing::Test
+{
+
+protected:
+    Ogre::MappedZipArchive* arch;
+public:
+    void SetUp();
+    void TearDown();
+};
+
 #endif
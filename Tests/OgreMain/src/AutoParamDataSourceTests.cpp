@@ -0,0 +1,313 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreCamera.h"
+#include "OgreSceneNode.h"
+#include "OgreAutoParamDataSource.h"
+#include "OgreGpuProgramManager.h"
+#include "OgreControllerManager.h"
+#include "OgreMaterialManager.h"
+#include "OgreTechnique.h"
+#include "OgrePass.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Source with a fixed viewport size, as there is no render system for a viewport
+    class TestAutoParamDataSource : public AutoParamDataSource
+    {
+    public:
+        Real getViewportWidth() const { return 640; }
+        Real getViewportHeight() const { return 480; }
+        Real getInverseViewportWidth() const { return 1.0f / 640; }
+        Real getInverseViewportHeight() const { return 1.0f / 480; }
+    };
+
+    /// Holds the shared parameters, as there is no render system for a real one
+    class TestGpuProgramManager : public GpuProgramManager
+    {
+    protected:
+        Resource* createImpl(const String& name, ResourceHandle handle, const String& group,
+            bool isManual, ManualResourceLoader* loader, const NameValuePairList* params)
+        { return 0; }
+        Resource* createImpl(const String& name, ResourceHandle handle, const String& group,
+            bool isManual, ManualResourceLoader* loader, GpuProgramType gptype, const String& syntaxCode)
+        { return 0; }
+    };
+
+    /// Drawn in screen space, like an overlay
+    class IdentityViewRenderable : public Renderable
+    {
+    public:
+        IdentityViewRenderable() { setUseIdentityView(true); }
+        const MaterialPtr& getMaterial(void) const { return mMaterial; }
+        void getRenderOperation(RenderOperation& op) {}
+        void getWorldTransforms(Matrix4* xform) const { *xform = Matrix4::IDENTITY; }
+        Real getSquaredViewDepth(const Camera* cam) const { return 0; }
+        const LightList& getLights(void) const { return mLights; }
+
+    private:
+        MaterialPtr mMaterial;
+        LightList mLights;
+    };
+}
+
+class AutoParamDataSourceTests : public RootWithoutRenderSystemFixture
+{
+public:
+    GpuProgramManager* mGpuProgramMgr;
+    ControllerManager* mControllerMgr;
+    SceneManager* mSceneMgr;
+    Camera* mCamera;
+    SceneNode* mCameraNode;
+    TestAutoParamDataSource mSource;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        mGpuProgramMgr = OGRE_NEW TestGpuProgramManager();
+        mControllerMgr = OGRE_NEW ControllerManager();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+        mCamera = OGRE_NEW Camera("Camera", mSceneMgr);
+        mCameraNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+        mCameraNode->setFixedYawAxis(true);
+        mCameraNode->attachObject(mCamera);
+        placeCamera(Vector3(1, 2, 3));
+    }
+
+    void TearDown()
+    {
+        mSource.setSharedBlocksEnabled(false);
+        OGRE_DELETE mCamera;
+        OGRE_DELETE mControllerMgr;
+        OGRE_DELETE mGpuProgramMgr;
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    /// Cameras use the cached transform of their node, which is not derived from its position
+    void setCameraTransform(const Vector3& position, const Quaternion& orientation)
+    {
+        mCameraNode->setPosition(position);
+        mCameraNode->setOrientation(orientation);
+        Matrix4 transform;
+        transform.makeTransform(position, Vector3::UNIT_SCALE, orientation);
+        mCameraNode->overrideCachedTransform(transform);
+    }
+
+    void placeCamera(const Vector3& position)
+    {
+        mCameraNode->setPosition(position);
+        mCameraNode->lookAt(Vector3::ZERO, Node::TS_WORLD);
+        setCameraTransform(position, mCameraNode->getOrientation());
+    }
+
+    /// Makes a current camera and viewport for the frame block
+    void setCamera(void)
+    {
+        mSource.setCurrentCamera(mCamera, false);
+        // Only its size is used, which the test source makes up
+        mSource.setCurrentViewport(reinterpret_cast<Viewport*>(1));
+    }
+
+    static void expectEqual(const Matrix4& expected, const float* actual)
+    {
+        for (size_t i = 0; i < 16; ++i)
+            EXPECT_FLOAT_EQ(expected[i / 4][i % 4], actual[i]);
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(AutoParamDataSourceTests, FrameBlock)
+{
+    EXPECT_FALSE(mSource.getSharedBlocksEnabled());
+    EXPECT_FALSE(mSource.getSharedBlock(AutoParamDataSource::SB_FRAME));
+
+    mSource.setSharedBlocksEnabled(true);
+    GpuSharedParametersPtr block = mSource.getSharedBlock(AutoParamDataSource::SB_FRAME);
+    ASSERT_TRUE(block);
+    EXPECT_EQ(block, GpuProgramManager::getSingleton().getSharedParameters("OgreFrameParams"));
+
+    // Nothing to evaluate without a camera
+    block->_markClean();
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    EXPECT_FALSE(block->isDirty());
+
+    setCamera();
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    EXPECT_TRUE(block->isDirty());
+
+    const GpuSharedParameters* constBlock = block.get();
+    const GpuConstantDefinition& viewProj = constBlock->getConstantDefinition("viewproj_matrix");
+    EXPECT_EQ(GCT_MATRIX_4X4, viewProj.constType);
+    expectEqual(mSource.getViewProjectionMatrix(), constBlock->getFloatPointer(viewProj.physicalIndex));
+
+    const GpuConstantDefinition& position = constBlock->getConstantDefinition("camera_position");
+    EXPECT_EQ(GCT_FLOAT3, position.constType);
+    for (size_t i = 0; i < 3; ++i)
+        EXPECT_FLOAT_EQ(mCamera->getDerivedPosition()[i], constBlock->getFloatPointer(position.physicalIndex)[i]);
+
+    const float* viewport = constBlock->getFloatPointer(constBlock->getConstantDefinition("viewport_size").physicalIndex);
+    EXPECT_FLOAT_EQ(640, viewport[0]);
+    EXPECT_FLOAT_EQ(1.0f / 480, viewport[3]);
+
+    // Unchanged values leave it clean
+    block->_markClean();
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    EXPECT_FALSE(block->isDirty());
+
+    placeCamera(Vector3(4, 5, 6));
+    mSource.setCurrentCamera(mCamera, false);
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    EXPECT_TRUE(block->isDirty());
+    EXPECT_FLOAT_EQ(6, constBlock->getFloatPointer(position.physicalIndex)[2]);
+}
+//--------------------------------------------------------------------------
+TEST_F(AutoParamDataSourceTests, FrameBlockIgnoresLastRenderable)
+{
+    mSource.setSharedBlocksEnabled(true);
+    GpuSharedParametersPtr block = mSource.getSharedBlock(AutoParamDataSource::SB_FRAME);
+    ASSERT_TRUE(block);
+
+    // The last renderable of a frame, still current when the next frame starts
+    IdentityViewRenderable* overlay = new IdentityViewRenderable();
+    setCamera();
+    mSource.setCurrentRenderable(overlay);
+    EXPECT_EQ(Matrix4::IDENTITY, mSource.getViewMatrix());
+    delete overlay;
+
+    mSource.setCurrentCamera(mCamera, false);
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    EXPECT_TRUE(mSource.getCurrentRenderable() == 0);
+    const GpuSharedParameters* constBlock = block.get();
+    expectEqual(mCamera->getViewMatrix(true),
+        constBlock->getFloatPointer(constBlock->getConstantDefinition("view_matrix").physicalIndex));
+}
+//--------------------------------------------------------------------------
+TEST_F(AutoParamDataSourceTests, PassBlock)
+{
+    mSource.setSharedBlocksEnabled(true);
+    GpuSharedParametersPtr block = mSource.getSharedBlock(AutoParamDataSource::SB_PASS);
+    ASSERT_TRUE(block);
+
+    MaterialPtr mat = MaterialManager::getSingleton().create("PassBlock",
+        ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    Pass* pass = mat->getTechnique(0)->getPass(0);
+    pass->setAmbient(0.25f, 0.5f, 0.75f);
+    pass->setShininess(12);
+
+    mSource.setCurrentPass(pass);
+    mSource.setAmbientLightColour(ColourValue(0.5f, 0.5f, 0.5f));
+    mSource.updateSharedBlock(AutoParamDataSource::SB_PASS);
+
+    const GpuSharedParameters* constBlock = block.get();
+    const float* ambient = constBlock->getFloatPointer(
+        constBlock->getConstantDefinition("surface_ambient_colour").physicalIndex);
+    EXPECT_FLOAT_EQ(0.5f, ambient[1]);
+    const float* derived = constBlock->getFloatPointer(
+        constBlock->getConstantDefinition("derived_ambient_light_colour").physicalIndex);
+    EXPECT_FLOAT_EQ(0.375f, derived[2]);
+    EXPECT_FLOAT_EQ(12, *constBlock->getFloatPointer(
+        constBlock->getConstantDefinition("surface_shininess").physicalIndex));
+}
+//--------------------------------------------------------------------------
+TEST_F(AutoParamDataSourceTests, ExistingBlock)
+{
+    // A block made by a script, with a constant of its own
+    GpuSharedParametersPtr block = GpuProgramManager::getSingleton().createSharedParameters("OgreFrameParams");
+    block->addConstantDefinition("wind", GCT_FLOAT2);
+    block->addConstantDefinition("view_matrix", GCT_MATRIX_4X4);
+    block->setNamedConstant("wind", Vector2(3, 4));
+
+    mSource.setSharedBlocksEnabled(true);
+    EXPECT_EQ(block, mSource.getSharedBlock(AutoParamDataSource::SB_FRAME));
+
+    setCamera();
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    const GpuSharedParameters* constBlock = block.get();
+    expectEqual(mSource.getViewMatrix(),
+        constBlock->getFloatPointer(constBlock->getConstantDefinition("view_matrix").physicalIndex));
+    expectEqual(mSource.getProjectionMatrix(),
+        constBlock->getFloatPointer(constBlock->getConstantDefinition("projection_matrix").physicalIndex));
+    const float* wind = constBlock->getFloatPointer(constBlock->getConstantDefinition("wind").physicalIndex);
+    EXPECT_FLOAT_EQ(3, wind[0]);
+    EXPECT_FLOAT_EQ(4, wind[1]);
+
+    // Definitions added later are picked up
+    block->addConstantDefinition("gust", GCT_FLOAT1);
+    placeCamera(Vector3(7, 8, 9));
+    mSource.setCurrentCamera(mCamera, false);
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+    expectEqual(mSource.getViewMatrix(),
+        constBlock->getFloatPointer(constBlock->getConstantDefinition("view_matrix").physicalIndex));
+}
+//--------------------------------------------------------------------------
+TEST_F(AutoParamDataSourceTests, CopyToProgramParameters)
+{
+    mSource.setSharedBlocksEnabled(true);
+    setCamera();
+    mSource.updateSharedBlock(AutoParamDataSource::SB_FRAME);
+
+    // Parameters of a program using the frame block
+    GpuNamedConstantsPtr namedConstants(OGRE_NEW GpuNamedConstants());
+    GpuConstantDefinition def;
+    def.constType = GCT_MATRIX_4X4;
+    def.elementSize = 16;
+    def.arraySize = 1;
+    def.physicalIndex = 0;
+    def.logicalIndex = 0;
+    namedConstants->map["viewproj_matrix"] = def;
+    namedConstants->floatBufferSize = 16;
+    GpuProgramParametersSharedPtr params(OGRE_NEW GpuProgramParameters());
+    params->_setNamedConstants(namedConstants);
+    params->addSharedParameters("OgreFrameParams");
+
+    unsigned long version = params->_markConstantsUploaded();
+    params->_copySharedParams();
+    expectEqual(mSource.getViewProjectionMatrix(), params->getFloatPointer(0));
+    EXPECT_TRUE(params->_isRangeModifiedSince(BCT_FLOAT, 0, 16, version));
+
+    // Copying the same values again needs no upload
+    version = params->_markConstantsUploaded();
+    params->_copySharedParams();
+    EXPECT_FALSE(params->_isRangeModifiedSince(BCT_FLOAT, 0, 16, version));
+}
+//--------------------------------------------------------------------------
+TEST_F(AutoParamDataSourceTests, SceneManagerOption)
+{
+    EXPECT_FALSE(mSceneMgr->getSharedAutoParamBlocks());
+    mSceneMgr->setSharedAutoParamBlocks(true);
+    EXPECT_TRUE(mSceneMgr->getSharedAutoParamBlocks());
+    // Kept when the scene is cleared
+    mSceneMgr->clearScene();
+    EXPECT_TRUE(mSceneMgr->getSharedAutoParamBlocks());
+    mSceneMgr->setSharedAutoParamBlocks(false);
+    EXPECT_FALSE(mSceneMgr->getSharedAutoParamBlocks());
+}
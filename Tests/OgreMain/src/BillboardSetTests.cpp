@@ -0,0 +1,277 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreCamera.h"
+#include "OgreSceneNode.h"
+#include "OgreBillboardSet.h"
+#include "OgreBillboard.h"
+#include "OgreRenderQueue.h"
+#include "OgreMaterialManager.h"
+#include "OgreTechnique.h"
+#include "OgreMath.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Without a render system no technique of a material is supported, so
+    /// this gives the render queue one anyway
+    class TestBillboardSet : public BillboardSet
+    {
+    public:
+        Technique* mTechnique;
+
+        TestBillboardSet(unsigned int poolSize, Technique* technique)
+            : BillboardSet("", poolSize), mTechnique(technique) {}
+
+        Technique* getTechnique(void) const { return mTechnique; }
+    };
+}
+
+class BillboardSetTests : public RootWithoutRenderSystemFixture
+{
+public:
+    SceneManager* mSceneMgr;
+    Camera* mCamera;
+    SceneNode* mCameraNode;
+    MaterialPtr mMaterial;
+    vector<BillboardSet*>::type mSets;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        DefaultWorkQueue* queue = static_cast<DefaultWorkQueue*>(mRoot->getWorkQueue());
+        queue->setWorkerThreadCount(4);
+        queue->startup();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+
+        mMaterial = MaterialManager::getSingleton().create("BillboardSetTests",
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+        mMaterial->getTechnique(0)->getPass(0);
+
+        mCamera = OGRE_NEW Camera("Camera", mSceneMgr);
+        mCameraNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+        mCameraNode->setFixedYawAxis(true);
+        mCameraNode->attachObject(mCamera);
+        placeCamera(Vector3(30, 40, 500));
+    }
+
+    void TearDown()
+    {
+        destroySets();
+        mMaterial.reset();
+        OGRE_DELETE mCamera;
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    /// Cameras use the cached transform of their node, which is not derived from its position
+    void setCameraTransform(const Vector3& position, const Quaternion& orientation)
+    {
+        mCameraNode->setPosition(position);
+        mCameraNode->setOrientation(orientation);
+        Matrix4 transform;
+        transform.makeTransform(position, Vector3::UNIT_SCALE, orientation);
+        mCameraNode->overrideCachedTransform(transform);
+    }
+
+    void placeCamera(const Vector3& position)
+    {
+        mCameraNode->setPosition(position);
+        mCameraNode->lookAt(Vector3::ZERO, Node::TS_WORLD);
+        setCameraTransform(position, mCameraNode->getOrientation());
+    }
+
+    BillboardSet* createEmptySet(size_t poolSize)
+    {
+        BillboardSet* set = OGRE_NEW TestBillboardSet(static_cast<unsigned int>(poolSize),
+            mMaterial->getTechnique(0));
+        set->setBillboardsInWorldSpace(true);
+        mSets.push_back(set);
+        return set;
+    }
+
+    void destroySets(void)
+    {
+        for (size_t i = 0; i < mSets.size(); ++i)
+            OGRE_DELETE mSets[i];
+        mSets.clear();
+    }
+
+    /// A set of randomly placed, sized, rotated and textured billboards
+    BillboardSet* createSet(BillboardType type, bool accurateFacing, size_t count)
+    {
+        BillboardSet* set = createEmptySet(count);
+        set->setBillboardType(type);
+        set->setUseAccurateFacing(accurateFacing);
+        set->setCommonDirection(Vector3(0, 1, 1).normalisedCopy());
+        set->setTextureStacksAndSlices(2, 2);
+        set->setBillboardRotationType(type == BBT_POINT ? BBR_TEXCOORD : BBR_VERTEX);
+
+        srand(0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            Billboard* bb = set->createBillboard(
+                Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * 200,
+                ColourValue(Math::UnitRandom(), Math::UnitRandom(), Math::UnitRandom(), Math::UnitRandom()));
+            bb->mDirection = Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), 1).normalisedCopy();
+            bb->setTexcoordIndex(static_cast<uint16>(i % 4));
+            if (i % 3 == 0)
+                bb->setDimensions(Math::RangeRandom(1, 50), Math::RangeRandom(1, 50));
+            if (i % 4 == 0)
+                bb->setRotation(Radian(Math::UnitRandom() * Math::TWO_PI));
+        }
+        return set;
+    }
+
+    void update(BillboardSet* set)
+    {
+        set->_notifyCurrentCamera(mCamera);
+        set->_updateRenderQueue(mSceneMgr->getRenderQueue());
+        mSceneMgr->getRenderQueue()->clear();
+    }
+
+    /// The vertices the set last rendered
+    static vector<float>::type readVertices(BillboardSet* set)
+    {
+        RenderOperation op;
+        set->getRenderOperation(op);
+        HardwareVertexBufferSharedPtr buf = op.vertexData->vertexBufferBinding->getBuffer(0);
+        size_t numFloats = op.vertexData->vertexCount * buf->getVertexSize() / sizeof(float);
+        vector<float>::type vertices(numFloats);
+        buf->readData(op.vertexData->vertexStart * buf->getVertexSize(),
+            numFloats * sizeof(float), numFloats ? &vertices[0] : 0);
+        return vertices;
+    }
+
+    /// Checks bit for bit, so the colours compare as well
+    static void expectSameVertices(const vector<float>::type& expected, const vector<float>::type& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        EXPECT_TRUE(expected.empty() || memcmp(&expected[0], &actual[0], expected.size() * sizeof(float)) == 0);
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(BillboardSetTests, QuadVertices)
+{
+    BillboardSet* set = createEmptySet(1);
+    set->setDefaultDimensions(20, 10);
+    set->createBillboard(Vector3(1, 2, 3), ColourValue(1, 0.5f, 0, 1));
+    setCameraTransform(Vector3::ZERO, Quaternion::IDENTITY);
+    update(set);
+
+    RGBA colour = VertexElement::convertColourValue(ColourValue(1, 0.5f, 0, 1),
+        VertexElement::getBestColourVertexElementType());
+    const float corners[4][5] = {
+        { -9, 7, 3, 0, 0 }, { 11, 7, 3, 1, 0 }, { -9, -3, 3, 0, 1 }, { 11, -3, 3, 1, 1 } };
+
+    vector<float>::type vertices = readVertices(set);
+    ASSERT_EQ(24u, vertices.size());
+    for (size_t v = 0; v < 4; ++v)
+    {
+        const float* vertex = &vertices[v * 6];
+        EXPECT_EQ(corners[v][0], vertex[0]);
+        EXPECT_EQ(corners[v][1], vertex[1]);
+        EXPECT_EQ(corners[v][2], vertex[2]);
+        EXPECT_EQ(colour, *reinterpret_cast<const RGBA*>(vertex + 3));
+        EXPECT_EQ(corners[v][3], vertex[4]);
+        EXPECT_EQ(corners[v][4], vertex[5]);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(BillboardSetTests, StreamingAndParallelMatchDefault)
+{
+    const BillboardType types[] = { BBT_POINT, BBT_ORIENTED_COMMON, BBT_ORIENTED_SELF,
+        BBT_PERPENDICULAR_COMMON, BBT_PERPENDICULAR_SELF };
+    for (size_t t = 0; t < 5; ++t)
+    {
+        for (int accurate = 0; accurate < 2; ++accurate)
+        {
+            SCOPED_TRACE(::testing::Message() << "type " << types[t] << ", accurate facing " << accurate);
+            BillboardSet* reference = createSet(types[t], accurate != 0, 1000);
+            BillboardSet* streamed = createSet(types[t], accurate != 0, 1000);
+            streamed->setStreamingFrames(3);
+            BillboardSet* parallel = createSet(types[t], accurate != 0, 1000);
+            parallel->setParallelBillboardThreshold(1);
+
+            for (size_t frame = 0; frame < 4; ++frame)
+            {
+                placeCamera(Vector3(30, 40, 500) + Vector3(10, -5, 20) * Real(frame));
+                update(reference);
+                update(streamed);
+                update(parallel);
+
+                vector<float>::type expected = readVertices(reference);
+                EXPECT_EQ(4000u * 6, expected.size());
+                expectSameVertices(expected, readVertices(streamed));
+                expectSameVertices(expected, readVertices(parallel));
+
+                // The ring holds 3 updates before it starts over
+                RenderOperation op;
+                streamed->getRenderOperation(op);
+                EXPECT_EQ(frame % 3 * 4000, op.vertexData->vertexStart);
+            }
+
+            destroySets();
+        }
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(BillboardSetTests, InjectBillboards)
+{
+    BillboardSet* source = createSet(BBT_ORIENTED_SELF, false, 3000);
+    vector<Billboard>::type billboards;
+    for (size_t i = 0; i < 3000; ++i)
+        billboards.push_back(*source->getBillboard(static_cast<unsigned int>(i)));
+
+    BillboardSet* serial = createEmptySet(3000);
+    BillboardSet* parallel = createEmptySet(3000);
+    BillboardSet* sets[] = { serial, parallel };
+    parallel->setParallelBillboardThreshold(1000);
+    for (size_t s = 0; s < 2; ++s)
+    {
+        sets[s]->setBillboardType(BBT_ORIENTED_SELF);
+        sets[s]->setTextureStacksAndSlices(2, 2);
+        sets[s]->_notifyCurrentCamera(mCamera);
+        sets[s]->beginBillboards(billboards.size());
+        for (size_t i = 0; i < 1000; ++i)
+            sets[s]->injectBillboard(billboards[i]);
+        // More than the pool has room for
+        sets[s]->injectBillboards(&billboards[1000], 2500);
+        sets[s]->endBillboards();
+    }
+    expectSameVertices(readVertices(serial), readVertices(parallel));
+    EXPECT_EQ(3000u * 4 * 6, readVertices(parallel).size());
+
+    EXPECT_EQ(1000u, parallel->getParallelBillboardThreshold());
+    EXPECT_EQ(0u, serial->getParallelBillboardThreshold());
+    EXPECT_EQ(0u, serial->getStreamingFrames());
+}
@@ -0,0 +1,360 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSkeleton.h"
+#include "OgreSkeletonManager.h"
+#include "OgreSkeletonSerializer.h"
+#include "OgreBone.h"
+#include "OgreAnimation.h"
+#include "OgreAnimationTrack.h"
+#include "OgreKeyFrame.h"
+#include "OgreCompressedTransformKeyFrames.h"
+#include "OgreDataStream.h"
+#include "OgreLogManager.h"
+#include "OgreTimer.h"
+#include "OgreMath.h"
+
+using namespace Ogre;
+
+class CompressedAnimationTrackTests : public RootWithoutRenderSystemFixture
+{
+public:
+    SkeletonPtr mSkeleton;
+
+    static const Real TOLERANCE;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        mSkeleton = SkeletonManager::getSingleton().create("CompressionTest.skeleton",
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, true);
+        srand(0);
+    }
+
+    void TearDown()
+    {
+        mSkeleton.reset();
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    /** Animation of numBones bones with numKeys keyframes each: smooth curves,
+        straight segments and constant or identity channels. */
+    Animation* createAnimation(const String& name, unsigned short numBones, unsigned short numKeys)
+    {
+        const Real length = 4;
+        Animation* anim = mSkeleton->createAnimation(name, length);
+        for (unsigned short h = 0; h < numBones; ++h)
+        {
+            Bone* bone = h < mSkeleton->getNumBones() ? mSkeleton->getBone(h) : mSkeleton->createBone(h);
+            NodeAnimationTrack* track = anim->createNodeTrack(h, bone);
+            track->setUseShortestRotationPath(h % 5 != 0);
+
+            Vector3 axis = Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), 1).normalisedCopy();
+            Real speed = Math::RangeRandom(0.2f, 3);
+            Real range = h % 7 == 0 ? 2000 : Math::RangeRandom(0.1f, 5);
+            for (unsigned short k = 0; k < numKeys; ++k)
+            {
+                Real t = k * length / numKeys;
+                // Straight for the first quarter, then curved
+                Real curve = std::max(Real(0), t - 1);
+                TransformKeyFrame* key = track->createNodeKeyFrame(t);
+                if (h % 4 != 1)
+                    key->setTranslate(Vector3(t, Math::Sin(curve * speed), Math::Cos(curve)) * range);
+                if (h % 4 != 2)
+                    key->setRotation(Quaternion(Radian(t + curve * curve * speed), axis));
+                if (h % 3 == 0)
+                    key->setScale(Vector3(1 + 0.2f * Math::Sin(curve * speed), 1, 2));
+            }
+        }
+        return anim;
+    }
+
+    /// Allows for the float error on large values
+    static Real tolerance(Real expected, Real error)
+    {
+        return error * std::max(Real(1), Math::Abs(expected) * 1e-3f);
+    }
+
+    /// Samples 2 tracks across and beyond the animation, including on their keyframes
+    static void expectSameSamples(const NodeAnimationTrack* expected, const NodeAnimationTrack* actual,
+        Real error = TOLERANCE)
+    {
+        const Animation* anim = expected->getParent();
+        for (int s = 0; s < 500; ++s)
+        {
+            Real time = s * anim->getLength() * 1.2f / 500;
+            TransformKeyFrame kf1(0, time), kf2(0, time);
+            expected->getInterpolatedKeyFrame(anim->_getTimeIndex(time), &kf1);
+            actual->getInterpolatedKeyFrame(actual->getParent()->_getTimeIndex(time), &kf2);
+            for (size_t c = 0; c < 3; ++c)
+            {
+                EXPECT_NEAR(kf1.getTranslate()[c], kf2.getTranslate()[c], tolerance(kf1.getTranslate()[c], error))
+                    << expected->getHandle() << " " << time;
+                EXPECT_NEAR(kf1.getScale()[c], kf2.getScale()[c], error);
+            }
+            EXPECT_LE(CompressedTransformKeyFrames::getRotationError(kf1.getRotation(), kf2.getRotation()).valueRadians(),
+                error) << expected->getHandle() << " " << time;
+        }
+    }
+
+    static void compressAll(Animation* anim)
+    {
+        Animation::NodeTrackIterator it = anim->getNodeTrackIterator();
+        while (it.hasMoreElements())
+        {
+            it.getNext()->compress(TOLERANCE, Radian(TOLERANCE), TOLERANCE);
+        }
+    }
+
+    static size_t totalSize(Animation* anim)
+    {
+        size_t size = 0;
+        Animation::NodeTrackIterator it = anim->getNodeTrackIterator();
+        while (it.hasMoreElements())
+        {
+            size += it.getNext()->calculateSize();
+        }
+        return size;
+    }
+
+    void expectSameAnimations(Animation* expected, Animation* actual, Real error = TOLERANCE)
+    {
+        ASSERT_EQ(expected->getNumNodeTracks(), actual->getNumNodeTracks());
+        Animation::NodeTrackIterator it = expected->getNodeTrackIterator();
+        while (it.hasMoreElements())
+        {
+            NodeAnimationTrack* track = it.getNext();
+            expectSameSamples(track, actual->getNodeTrack(track->getHandle()), error);
+        }
+    }
+};
+const Real CompressedAnimationTrackTests::TOLERANCE = 1e-3f;
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, MatchesUncompressed)
+{
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        String name = "Anim" + StringConverter::toString(mode);
+        Animation* anim = createAnimation(name, 24, 120);
+        if (mode == 1)
+            anim->setRotationInterpolationMode(Animation::RIM_SPHERICAL);
+        else if (mode == 2)
+            anim->setInterpolationMode(Animation::IM_SPLINE);
+        Animation* compressed = anim->clone(name + "Compressed");
+        compressAll(compressed);
+
+        for (unsigned short h = 0; h < anim->getNumNodeTracks(); ++h)
+        {
+            NodeAnimationTrack* track = compressed->getNodeTrack(h);
+            EXPECT_TRUE(track->isCompressed());
+            // Splines need every keyframe, the straight segments go otherwise
+            if (mode == 2)
+            {
+                EXPECT_EQ(anim->getNodeTrack(h)->getNumKeyFrames(), track->getNumKeyFrames());
+            }
+            else
+            {
+                EXPECT_LT(track->getNumKeyFrames(), anim->getNodeTrack(h)->getNumKeyFrames());
+            }
+            EXPECT_LT(track->calculateSize(), anim->getNodeTrack(h)->calculateSize());
+        }
+        expectSameAnimations(anim, compressed);
+
+        // Compressed tracks clone as they are
+        Animation* copy = compressed->clone(name + "Copy");
+        EXPECT_TRUE(copy->getNodeTrack(0)->isCompressed());
+        expectSameAnimations(compressed, copy);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, ChannelModes)
+{
+    Animation* anim = createAnimation("Anim", 8, 50);
+    compressAll(anim);
+
+    typedef CompressedTransformKeyFrames CTK;
+    // No translation on bone 1, no rotation on bone 2, no scale unless h % 3 == 0
+    const CTK* keys = anim->getNodeTrack(1)->getCompressedKeyFrames();
+    EXPECT_EQ(CTK::CM_IDENTITY, keys->getChannelMode(CTK::CH_TRANSLATE));
+    EXPECT_EQ(CTK::CM_QUANTISED, keys->getChannelMode(CTK::CH_ROTATION));
+    EXPECT_EQ(CTK::CM_IDENTITY, keys->getChannelMode(CTK::CH_SCALE));
+    keys = anim->getNodeTrack(2)->getCompressedKeyFrames();
+    EXPECT_EQ(CTK::CM_QUANTISED, keys->getChannelMode(CTK::CH_TRANSLATE));
+    EXPECT_EQ(CTK::CM_IDENTITY, keys->getChannelMode(CTK::CH_ROTATION));
+    keys = anim->getNodeTrack(3)->getCompressedKeyFrames();
+    EXPECT_EQ(CTK::CM_QUANTISED, keys->getChannelMode(CTK::CH_SCALE));
+    // Too wide a range to quantise within tolerance
+    keys = anim->getNodeTrack(7)->getCompressedKeyFrames();
+    EXPECT_EQ(CTK::CM_FULL, keys->getChannelMode(CTK::CH_TRANSLATE));
+
+    // A track which doesn't move at all keeps its first and last keyframes
+    NodeAnimationTrack* still = anim->createNodeTrack(8, mSkeleton->createBone(8));
+    for (int k = 0; k < 10; ++k)
+        still->createNodeKeyFrame(k * 0.4f)->setTranslate(Vector3(1, 2, 3));
+    EXPECT_TRUE(still->hasNonZeroKeyFrames());
+    still->compress();
+    EXPECT_EQ(2u, still->getNumKeyFrames());
+    keys = still->getCompressedKeyFrames();
+    EXPECT_EQ(CTK::CM_CONSTANT, keys->getChannelMode(CTK::CH_TRANSLATE));
+    EXPECT_EQ(CTK::CM_IDENTITY, keys->getChannelMode(CTK::CH_ROTATION));
+    EXPECT_EQ(Vector3(1, 2, 3), keys->getTranslate(1));
+    EXPECT_TRUE(still->hasNonZeroKeyFrames());
+}
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, Decompress)
+{
+    Animation* anim = createAnimation("Anim", 6, 40);
+    Animation* compressed = anim->clone("Compressed");
+    compressAll(compressed);
+
+    NodeAnimationTrack* track = compressed->getNodeTrack(3);
+    EXPECT_THROW(track->getNodeKeyFrame(0), Exception);
+    EXPECT_THROW(track->getKeyFrame(0), Exception);
+    EXPECT_THROW(track->createNodeKeyFrame(0.5f), Exception);
+    EXPECT_THROW(track->removeKeyFrame(0), Exception);
+
+    unsigned short numKeyFrames = track->getNumKeyFrames();
+    Real lastTime = track->getNodeKeyFrameTime(numKeyFrames - 1);
+    track->decompress();
+    EXPECT_FALSE(track->isCompressed());
+    EXPECT_EQ(numKeyFrames, track->getNumKeyFrames());
+    EXPECT_EQ(lastTime, track->getNodeKeyFrame(numKeyFrames - 1)->getTime());
+    expectSameSamples(anim->getNodeTrack(3), track);
+
+    // Editable again
+    track->createNodeKeyFrame(0.01f);
+    EXPECT_EQ(numKeyFrames + 1, track->getNumKeyFrames());
+}
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, BaseKeyFrame)
+{
+    Animation* anim = createAnimation("Anim", 6, 40);
+    Animation* compressed = anim->clone("Compressed");
+    compressAll(compressed);
+
+    anim->setUseBaseKeyFrame(true, 1.5f);
+    anim->_applyBaseKeyFrame();
+    compressed->setUseBaseKeyFrame(true, 1.5f);
+    compressed->_applyBaseKeyFrame();
+    // The error of the base keyframe adds to that of the others
+    expectSameAnimations(anim, compressed, 3 * TOLERANCE);
+}
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, SerializerRoundTrip)
+{
+    Animation* anim = createAnimation("Anim", 16, 60);
+    compressAll(anim);
+
+    SkeletonVersion versions[] = { SKELETON_VERSION_LATEST, SKELETON_VERSION_1_8 };
+    for (int v = 0; v < 2; ++v)
+    {
+        const size_t bufferSize = 1024 * 1024;
+        DataStreamPtr stream(OGRE_NEW MemoryDataStream(bufferSize));
+        SkeletonSerializer serializer;
+        serializer.exportSkeleton(mSkeleton.get(), stream, versions[v]);
+        size_t size = stream->tell();
+        ASSERT_LT(size, bufferSize);
+
+        DataStreamPtr input(OGRE_NEW MemoryDataStream(
+            static_cast<MemoryDataStream*>(stream.get())->getPtr(), size));
+        SkeletonPtr loaded = SkeletonManager::getSingleton().create(
+            "Loaded" + StringConverter::toString(v) + ".skeleton",
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, true);
+        serializer.importSkeleton(input, loaded.get());
+
+        Animation* loadedAnim = loaded->getAnimation("Anim");
+        // Not stored in the file
+        for (unsigned short h = 0; h < anim->getNumNodeTracks(); ++h)
+            loadedAnim->getNodeTrack(h)->setUseShortestRotationPath(anim->getNodeTrack(h)->getUseShortestRotationPath());
+        // Older versions store the decoded keyframes
+        EXPECT_EQ(v == 0, loadedAnim->getNodeTrack(0)->isCompressed());
+        expectSameAnimations(anim, loadedAnim);
+        SkeletonManager::getSingleton().remove(loaded->getHandle());
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, SerializerVersion)
+{
+    Animation* anim = createAnimation("Anim", 4, 20);
+
+    // The new version only when there is something compressed to write
+    for (int compressed = 0; compressed < 2; ++compressed)
+    {
+        if (compressed)
+            anim->getNodeTrack(2)->compress();
+        DataStreamPtr stream(OGRE_NEW MemoryDataStream(1024 * 1024));
+        SkeletonSerializer serializer;
+        serializer.exportSkeleton(mSkeleton.get(), stream);
+
+        const String header(reinterpret_cast<const char*>(
+            static_cast<MemoryDataStream*>(stream.get())->getPtr()) + sizeof(uint16), 32);
+        EXPECT_EQ(0u, header.find(compressed ? "[Serializer_v1.100]" : "[Serializer_v1.80]")) << header;
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(CompressedAnimationTrackTests, DISABLED_Benchmark)
+{
+    const unsigned short numBones = 60;
+    const unsigned short numKeys = 300;
+    Animation* anim = createAnimation("Anim", numBones, numKeys);
+    Animation* compressed = anim->clone("Compressed");
+
+    Timer timer;
+    compressAll(compressed);
+    unsigned long compressTime = timer.getMicroseconds();
+
+    const int numSamples = 200;
+    unsigned long elapsed[2];
+    Animation* anims[2] = { anim, compressed };
+    for (int c = 0; c < 2; ++c)
+    {
+        Real sum = 0;
+        timer.reset();
+        for (int s = 0; s < numSamples; ++s)
+        {
+            TimeIndex timeIndex = anims[c]->_getTimeIndex(s * anim->getLength() / numSamples);
+            TransformKeyFrame kf(0, 0);
+            for (unsigned short h = 0; h < numBones; ++h)
+            {
+                anims[c]->getNodeTrack(h)->getInterpolatedKeyFrame(timeIndex, &kf);
+                sum += kf.getTranslate().x;
+            }
+        }
+        elapsed[c] = timer.getMicroseconds();
+        EXPECT_TRUE(Math::isNaN(sum) == false);
+    }
+
+    LogManager::getSingleton().stream() << "Animation of " << numBones << " bones with "
+        << numKeys << " keyframes: " << totalSize(anim) << " bytes, compressed to "
+        << totalSize(compressed) << " bytes in " << compressTime / 1000.0f << " ms. Sampling "
+        << numSamples << " times: " << elapsed[0] / 1000.0f << " ms, compressed "
+        << elapsed[1] / 1000.0f << " ms";
+    EXPECT_LT(totalSize(compressed) * 3, totalSize(anim));
+}
@@ -49,10 +49,15 @@ void FileSystemArchiveTests::SetUp()
     Ogre::ConfigFile cf;
     cf.load(Ogre::FileSystemLayer(OGRE_VERSION_NAME).getConfigFilePath("resources.cfg"));
     mTestPath = cf.getSettings("Tests").begin()->second+"/misc/ArchiveTest";
+
+    mUseMemoryMapping = FileSystemArchive::getUseMemoryMapping();
+    mMemoryMappingThreshold = FileSystemArchive::getMemoryMappingThreshold();
 }
 //--------------------------------------------------------------------------
 void FileSystemArchiveTests::TearDown()
 {
+    FileSystemArchive::setUseMemoryMapping(mUseMemoryMapping);
+    FileSystemArchive::setMemoryMappingThreshold(mMemoryMappingThreshold);
 }
 //--------------------------------------------------------------------------
 TEST_F(FileSystemArchiveTests,ListNonRecursive)
@@ -277,6 +282,36 @@ TEST_F(FileSystemArchiveTests,FileRead)
     EXPECT_TRUE(stream->eof());
 }
 //--------------------------------------------------------------------------
+TEST_F(FileSystemArchiveTests,FileReadMemoryMapped)
+{
+    FileSystemArchive::setUseMemoryMapping(true);
+    FileSystemArchive::setMemoryMappingThreshold(0);
+
+    FileSystemArchive arch(mTestPath, "FileSystem", true);
+    arch.load();
+
+    DataStreamPtr stream = arch.open("rootfile.txt");
+    MemoryMappedDataStream* mapped = dynamic_cast<MemoryMappedDataStream*>(stream.get());
+    ASSERT_TRUE(mapped != 0);
+    EXPECT_EQ(mFileSizeRoot1, mapped->size());
+    EXPECT_EQ(0, memcmp(mapped->getPtr(), "this is line 1 in file 1", 24));
+    EXPECT_EQ(String("this is line 1 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 2 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 3 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 4 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 5 in file 1"), stream->getLine());
+    EXPECT_EQ(BLANKSTRING, stream->getLine()); // blank at end of file
+    EXPECT_TRUE(stream->eof());
+    stream->close();
+    EXPECT_TRUE(mapped->getPtr() == 0);
+
+    // Files below the threshold are streamed
+    FileSystemArchive::setMemoryMappingThreshold(mFileSizeRoot1 + 1);
+    stream = arch.open("rootfile.txt");
+    EXPECT_TRUE(dynamic_cast<MemoryMappedDataStream*>(stream.get()) == 0);
+    EXPECT_EQ(String("this is line 1 in file 1"), stream->getLine());
+}
+//--------------------------------------------------------------------------
 TEST_F(FileSystemArchiveTests,ReadInterleave)
 {
     // Test overlapping reads from same archive
@@ -0,0 +1,196 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "OgreGpuProgramParams.h"
+#include "OgreVector4.h"
+#include "OgreMatrix4.h"
+
+using namespace Ogre;
+
+class GpuProgramParametersTests : public ::testing::Test
+{
+public:
+    GpuProgramParametersSharedPtr mParams;
+
+    void SetUp()
+    {
+        mParams = GpuProgramParametersSharedPtr(OGRE_NEW GpuProgramParameters());
+        mParams->_setLogicalIndexes(
+            GpuLogicalBufferStructPtr(OGRE_NEW GpuLogicalBufferStruct()),
+            GpuLogicalBufferStructPtr(OGRE_NEW GpuLogicalBufferStruct()),
+            GpuLogicalBufferStructPtr(OGRE_NEW GpuLogicalBufferStruct()),
+            GpuLogicalBufferStructPtr(OGRE_NEW GpuLogicalBufferStruct()),
+            GpuLogicalBufferStructPtr(OGRE_NEW GpuLogicalBufferStruct()));
+
+        // Physical layout follows the order of the first writes
+        for (size_t i = 0; i < 8; ++i)
+            mParams->setConstant(i, Vector4::ZERO);
+        mParams->setConstant(8, Matrix4::ZERO);
+        int zero[4] = { 0, 0, 0, 0 };
+        mParams->setConstant(0, zero, 1);
+    }
+
+    bool isModifiedSince(size_t index, unsigned long version)
+    {
+        return mParams->_isRangeModifiedSince(BCT_FLOAT, index * 4, 4, version);
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(GpuProgramParametersTests, SameValueNotModified)
+{
+    EXPECT_EQ(48u, mParams->getFloatConstantList().size());
+    EXPECT_TRUE(isModifiedSince(3, 0));
+
+    unsigned long version = mParams->_markConstantsUploaded();
+    for (size_t i = 0; i < 8; ++i)
+        EXPECT_FALSE(isModifiedSince(i, version));
+
+    mParams->setConstant(3, Vector4::ZERO);
+    EXPECT_FALSE(isModifiedSince(3, version));
+
+    mParams->setConstant(3, Vector4(1, 2, 3, 4));
+    EXPECT_TRUE(isModifiedSince(3, version));
+    EXPECT_FALSE(isModifiedSince(2, version));
+    EXPECT_FALSE(isModifiedSince(4, version));
+    EXPECT_TRUE(mParams->_isRangeModifiedSince(BCT_FLOAT, 0, 32, version));
+
+    // Ints are tracked separately
+    EXPECT_FALSE(mParams->_isRangeModifiedSince(BCT_INT, 0, 4, version));
+    int five[4] = { 5, 0, 0, 0 };
+    mParams->setConstant(0, five, 1);
+    EXPECT_TRUE(mParams->_isRangeModifiedSince(BCT_INT, 0, 4, version));
+}
+//--------------------------------------------------------------------------
+TEST_F(GpuProgramParametersTests, VersionPerConsumer)
+{
+    unsigned long first = mParams->_markConstantsUploaded();
+    mParams->setConstant(1, Vector4(1, 0, 0, 0));
+    unsigned long second = mParams->_markConstantsUploaded();
+    mParams->setConstant(6, Vector4(0, 1, 0, 0));
+
+    // The first consumer has yet to see both changes, the second only the last
+    EXPECT_TRUE(isModifiedSince(1, first));
+    EXPECT_TRUE(isModifiedSince(6, first));
+    EXPECT_FALSE(isModifiedSince(1, second));
+    EXPECT_TRUE(isModifiedSince(6, second));
+
+    unsigned long third = mParams->_markConstantsUploaded();
+    EXPECT_FALSE(isModifiedSince(6, third));
+    EXPECT_TRUE(isModifiedSince(6, second));
+}
+//--------------------------------------------------------------------------
+TEST_F(GpuProgramParametersTests, PackedRanges)
+{
+    unsigned long version = mParams->_markConstantsUploaded();
+    GpuConstantRangeList ranges;
+    mParams->_getRangesModifiedSince(BCT_FLOAT, version, ranges);
+    EXPECT_TRUE(ranges.empty());
+
+    mParams->setConstant(1, Vector4(1, 0, 0, 0));
+    mParams->setConstant(2, Vector4(0, 1, 0, 0));
+    mParams->setConstant(3, Vector4(0, 0, 1, 0));
+    mParams->setConstant(7, Vector4(0, 0, 0, 1));
+    mParams->_getRangesModifiedSince(BCT_FLOAT, version, ranges);
+    ASSERT_EQ(2u, ranges.size());
+    EXPECT_EQ(4u, ranges[0].physicalIndex);
+    EXPECT_EQ(12u, ranges[0].count);
+    EXPECT_EQ(28u, ranges[1].physicalIndex);
+    EXPECT_EQ(4u, ranges[1].count);
+
+    // A matrix spans 4 consecutive registers
+    version = mParams->_markConstantsUploaded();
+    mParams->setConstant(8, Matrix4::IDENTITY);
+    mParams->_getRangesModifiedSince(BCT_FLOAT, version, ranges);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(32u, ranges[0].physicalIndex);
+    EXPECT_EQ(16u, ranges[0].count);
+
+    // Everything is modified since version 0
+    mParams->_getRangesModifiedSince(BCT_INT, 0, ranges);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(0u, ranges[0].physicalIndex);
+    EXPECT_EQ(mParams->getIntConstantList().size(), ranges[0].count);
+}
+//--------------------------------------------------------------------------
+TEST_F(GpuProgramParametersTests, CopyModifiesAll)
+{
+    GpuProgramParameters copy(*mParams);
+    unsigned long version = copy._markConstantsUploaded();
+    EXPECT_FALSE(copy._isRangeModifiedSince(BCT_FLOAT, 0, 48, version));
+
+    copy.copyConstantsFrom(*mParams);
+    EXPECT_TRUE(copy._isRangeModifiedSince(BCT_FLOAT, 0, 4, version));
+    EXPECT_TRUE(copy._isRangeModifiedSince(BCT_FLOAT, 28, 4, version));
+
+    // Constants added later count as modified too
+    version = copy._markConstantsUploaded();
+    copy.setConstant(12, Vector4::ZERO);
+    EXPECT_TRUE(copy._isRangeModifiedSince(BCT_FLOAT, 48, 4, version));
+
+    // Writes through pointers are recorded by the writer
+    version = copy._markConstantsUploaded();
+    copy.getFloatPointer(8)[0] = 1;
+    EXPECT_FALSE(copy._isRangeModifiedSince(BCT_FLOAT, 8, 1, version));
+    copy._markRangeModified(BCT_FLOAT, 8, 1);
+    EXPECT_TRUE(copy._isRangeModifiedSince(BCT_FLOAT, 8, 1, version));
+}
+//--------------------------------------------------------------------------
+TEST_F(GpuProgramParametersTests, CopyNamedMarksOnlyBufferedTypes)
+{
+    GpuNamedConstantsPtr named(OGRE_NEW GpuNamedConstants());
+    GpuConstantDefinition def;
+    def.constType = GCT_FLOAT4;
+    def.physicalIndex = 0;
+    def.elementSize = 4;
+    named->map["colour"] = def;
+    def.constType = GCT_SAMPLER2D;
+    def.physicalIndex = 0;
+    def.elementSize = 1;
+    named->map["diffuseMap"] = def;
+    // Unrecognised types have no buffer to copy into or mark
+    def.constType = GCT_UNKNOWN;
+    named->map["unknown"] = def;
+    named->floatBufferSize = 4;
+    named->intBufferSize = 1;
+
+    GpuProgramParameters source;
+    source._setNamedConstants(named);
+    source.setNamedConstant("colour", Vector4(1, 1, 1, 1));
+    source.setNamedConstant("diffuseMap", 3);
+
+    GpuProgramParameters dest;
+    dest._setNamedConstants(named);
+    unsigned long version = dest._markConstantsUploaded();
+    EXPECT_NO_THROW(dest.copyMatchingNamedConstantsFrom(source));
+
+    EXPECT_EQ(1.0f, dest.getFloatPointer(0)[0]);
+    EXPECT_EQ(3, dest.getIntPointer(0)[0]);
+    EXPECT_TRUE(dest._isRangeModifiedSince(BCT_FLOAT, 0, 4, version));
+    EXPECT_TRUE(dest._isRangeModifiedSince(BCT_INT, 0, 1, version));
+}
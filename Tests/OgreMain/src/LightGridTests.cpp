@@ -0,0 +1,209 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManagerEnumerator.h"
+#include "OgreSceneNode.h"
+#include "OgreCamera.h"
+#include "OgreLight.h"
+#include "OgreManualObject.h"
+#include "OgreMath.h"
+
+using namespace Ogre;
+
+namespace
+{
+    Vector3 randomVector(Real range)
+    {
+        return Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * range;
+    }
+
+    bool sameLights(const LightList& a, const LightList& b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+    /// Gives access to findLightsAffectingFrustum, called when rendering otherwise
+    class LightGridSceneManager : public DefaultSceneManager
+    {
+    public:
+        LightGridSceneManager() : DefaultSceneManager("LightGridTests") {}
+        using SceneManager::findLightsAffectingFrustum;
+    };
+}
+
+class LightGridTests : public RootWithoutRenderSystemFixture
+{
+public:
+    LightGridSceneManager* mSceneMgr;
+    Camera* mCamera;
+    vector<SceneNode*>::type mLightNodes;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        mSceneMgr = OGRE_NEW LightGridSceneManager();
+        // Looking at the whole scene
+        mCamera = OGRE_NEW Camera("Camera", mSceneMgr);
+        mCamera->setNearClipDistance(1);
+        mCamera->setFarClipDistance(3000);
+        createNode(Vector3(0, 0, 1000))->attachObject(mCamera);
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mCamera;
+        OGRE_DELETE mSceneMgr;
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    /// World bounds come from the cached transform, which is not derived from the position
+    static void setNodePosition(SceneNode* node, const Vector3& position)
+    {
+        node->setPosition(position);
+        node->overrideCachedTransform(Matrix4::getTrans(position));
+    }
+
+    SceneNode* createNode(const Vector3& position)
+    {
+        SceneNode* node = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+        setNodePosition(node, position);
+        return node;
+    }
+
+    /// Creates numLights point and spot lights with random ranges, and two directional lights
+    void createLights(size_t numLights, Real range)
+    {
+        srand(0);
+        for (size_t n = 0; n < numLights; ++n)
+        {
+            Light* light = mSceneMgr->createLight("Light" + StringConverter::toString(n));
+            light->setType(n % 4 ? Light::LT_POINT : Light::LT_SPOTLIGHT);
+            light->setDirection(randomVector(1).normalisedCopy());
+            light->setAttenuation(Math::RangeRandom(5, 40), 1, 0, 0);
+            light->setLightMask(1 << (rand() % 3));
+            SceneNode* node = createNode(randomVector(range));
+            node->attachObject(light);
+            mLightNodes.push_back(node);
+        }
+        for (int n = 0; n < 2; ++n)
+        {
+            Light* light = mSceneMgr->createLight("Directional" + StringConverter::toString(n));
+            light->setType(Light::LT_DIRECTIONAL);
+        }
+        mSceneMgr->_updateSceneGraph(mCamera);
+        mSceneMgr->findLightsAffectingFrustum(mCamera);
+    }
+
+    /// The light lists of many random spheres, with or without the grid
+    vector<LightList>::type populateLightLists(bool grid, size_t numSpheres, Real range)
+    {
+        mSceneMgr->setLightGridEnabled(grid);
+        mSceneMgr->findLightsAffectingFrustum(mCamera);
+        if (grid)
+        {
+            EXPECT_NE(0ull, mSceneMgr->_getLightListSignature(Vector3::ZERO, 10));
+        }
+
+        srand(1);
+        vector<LightList>::type lists(numSpheres);
+        for (size_t n = 0; n < numSpheres; ++n)
+        {
+            // Some too large for the grid
+            const Real radius = n % 50 ? Math::RangeRandom(0, 30) : 1000;
+            const uint32 mask = n % 3 ? 0xFFFFFFFF : 0x5;
+            mSceneMgr->_populateLightList(randomVector(range), radius, lists[n], mask);
+        }
+        return lists;
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(LightGridTests, GridMatchesLinear)
+{
+    createLights(300, 300);
+    EXPECT_GT(mSceneMgr->_getLightsAffectingFrustum().size(), 100u);
+
+    const vector<LightList>::type linear = populateLightLists(false, 2000, 350);
+    const vector<LightList>::type grid = populateLightLists(true, 2000, 350);
+    size_t numLights = 0;
+    for (size_t n = 0; n < linear.size(); ++n)
+    {
+        EXPECT_TRUE(sameLights(linear[n], grid[n])) << n;
+        numLights += linear[n].size();
+    }
+    // Neither only the directional lights nor everything
+    EXPECT_GT(numLights, linear.size() * 3);
+    EXPECT_LT(numLights, linear.size() * 50);
+
+    // Too few lights for the grid
+    mSceneMgr->destroyAllLights();
+    mSceneMgr->createLight("Light");
+    mSceneMgr->findLightsAffectingFrustum(mCamera);
+    EXPECT_EQ(0ull, mSceneMgr->_getLightListSignature(Vector3::ZERO, 10));
+}
+//--------------------------------------------------------------------------
+TEST_F(LightGridTests, CachedLightLists)
+{
+    // Off by default, so existing scenes behave as before
+    EXPECT_FALSE(mSceneMgr->getLightGridEnabled());
+    mSceneMgr->setLightGridEnabled(true);
+    createLights(100, 200);
+
+    vector<ManualObject*>::type objects;
+    for (size_t n = 0; n < 500; ++n)
+    {
+        ManualObject* obj = mSceneMgr->createManualObject("Object" + StringConverter::toString(n));
+        obj->setBoundingBox(AxisAlignedBox(Vector3(-5, -5, -5), Vector3(5, 5, 5)));
+        createNode(randomVector(200))->attachObject(obj);
+        objects.push_back(obj);
+    }
+
+    // Lights moving around the objects, and objects moving around the lights
+    for (size_t frame = 0; frame < 20; ++frame)
+    {
+        for (size_t n = frame; n < mLightNodes.size(); n += 10)
+        {
+            setNodePosition(mLightNodes[n], randomVector(200));
+        }
+        setNodePosition(objects[frame]->getParentSceneNode(), randomVector(200));
+        // Ranges changing without the lights moving
+        static_cast<Light*>(mLightNodes[frame + 1]->getAttachedObject(0))->setAttenuation(
+            Math::RangeRandom(5, 40), 1, 0, 0);
+        mSceneMgr->_updateSceneGraph(mCamera);
+        mSceneMgr->findLightsAffectingFrustum(mCamera);
+
+        for (size_t n = 0; n < objects.size(); ++n)
+        {
+            LightList expected;
+            mSceneMgr->_populateLightList(objects[n]->getParentSceneNode(),
+                objects[n]->getBoundingRadius(), expected);
+            EXPECT_TRUE(sameLights(expected, objects[n]->queryLights())) << frame << " " << n;
+        }
+    }
+}
@@ -0,0 +1,248 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreMesh.h"
+#include "OgreSubMesh.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshSerializer.h"
+#include "OgreMeshFileFormat.h"
+#include "OgreDataStream.h"
+#include "OgreConfigFile.h"
+
+using namespace Ogre;
+
+class MeshCompactTests : public RootWithoutRenderSystemFixture
+{
+public:
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+
+        ConfigFile cf;
+        cf.load(mFSLayer->getConfigFilePath("resources.cfg"));
+        String modelsPath = cf.getSettings("Tests").begin()->second + "/../../Samples/Media/models";
+        ResourceGroupManager::getSingleton().addResourceLocation(modelsPath, "FileSystem", "Models");
+        ResourceGroupManager::getSingleton().initialiseResourceGroup("Models");
+    }
+
+    static DataStreamPtr exportMesh(const MeshPtr& mesh, MeshVersion version,
+        Serializer::Endian endian = Serializer::ENDIAN_NATIVE)
+    {
+        MeshSerializer serializer;
+        // Sized by a first export, as the memory stream does not grow
+        DataStreamPtr sizing(OGRE_NEW MemoryDataStream(64 * 1024 * 1024, true));
+        serializer.exportMesh(mesh.get(), sizing, version, endian);
+        DataStreamPtr stream(OGRE_NEW MemoryDataStream(sizing->tell(), true));
+        serializer.exportMesh(mesh.get(), stream, version, endian);
+        stream->seek(0);
+        return stream;
+    }
+
+    static MeshPtr importMesh(DataStreamPtr& stream, const String& name)
+    {
+        MeshPtr mesh = MeshManager::getSingleton().createManual(name, "Models");
+        MeshSerializer().importMesh(stream, mesh.get());
+        return mesh;
+    }
+
+    /// The first chunk with this id and this uint16 at offset from its start, or null
+    static uchar* findChunk(const DataStreamPtr& stream, uint16 id, size_t offset, uint16 value)
+    {
+        uchar* data = static_cast<MemoryDataStream*>(stream.get())->getPtr();
+        for (size_t i = 0; i + offset + sizeof(uint16) <= stream->size(); ++i)
+        {
+            uint16 chunkId, chunkValue;
+            memcpy(&chunkId, data + i, sizeof(uint16));
+            memcpy(&chunkValue, data + i + offset, sizeof(uint16));
+            if (chunkId == id && chunkValue == value)
+                return data + i;
+        }
+        return 0;
+    }
+
+    static void expectVertexDataNear(const VertexData* a, const VertexData* b, const AxisAlignedBox& bounds)
+    {
+        ASSERT_EQ(a == 0, b == 0);
+        if (!a)
+            return;
+        ASSERT_EQ(a->vertexCount, b->vertexCount);
+        ASSERT_EQ(a->vertexDeclaration->getElementCount(), b->vertexDeclaration->getElementCount());
+        // Quantised to 16 bits within the extent of the buffer
+        Real positionTolerance = bounds.getSize().length() / 65535;
+        for (unsigned short e = 0; e < a->vertexDeclaration->getElementCount(); ++e)
+        {
+            const VertexElement* ea = a->vertexDeclaration->getElement(e);
+            const VertexElement* eb = b->vertexDeclaration->getElement(e);
+            ASSERT_TRUE(*ea == *eb);
+            HardwareVertexBufferSharedPtr va = a->vertexBufferBinding->getBuffer(ea->getSource());
+            HardwareVertexBufferSharedPtr vb = b->vertexBufferBinding->getBuffer(eb->getSource());
+            const uchar* pa = static_cast<const uchar*>(va->lock(HardwareBuffer::HBL_READ_ONLY));
+            const uchar* pb = static_cast<const uchar*>(vb->lock(HardwareBuffer::HBL_READ_ONLY));
+            for (size_t v = 0; v < a->vertexCount; ++v)
+            {
+                const uchar* elemA = pa + v * va->getVertexSize() + ea->getOffset();
+                const uchar* elemB = pb + v * vb->getVertexSize() + eb->getOffset();
+                if (VertexElement::getBaseType(ea->getType()) != VET_FLOAT1)
+                {
+                    EXPECT_EQ(0, memcmp(elemA, elemB, ea->getSize()));
+                    continue;
+                }
+                const float* fa = reinterpret_cast<const float*>(elemA);
+                const float* fb = reinterpret_cast<const float*>(elemB);
+                size_t count = VertexElement::getTypeCount(ea->getType());
+                if (ea->getType() == VET_FLOAT3 && ea->getSemantic() == VES_POSITION)
+                {
+                    for (size_t c = 0; c < 3; ++c)
+                        EXPECT_NEAR(fa[c], fb[c], positionTolerance);
+                }
+                else if (ea->getType() == VET_FLOAT3 && (ea->getSemantic() == VES_NORMAL ||
+                    ea->getSemantic() == VES_TANGENT || ea->getSemantic() == VES_BINORMAL))
+                {
+                    Vector3 na(fa), nb(fb);
+                    Real length = na.length();
+                    if (Math::Abs(length - 1) > 1e-3f)
+                    {
+                        EXPECT_EQ(na, nb);
+                    }
+                    else
+                    {
+                        EXPECT_LT(na.angleBetween(nb).valueDegrees(), 0.05f);
+                    }
+                }
+                else
+                {
+                    for (size_t c = 0; c < count; ++c)
+                        EXPECT_NEAR(fa[c], fb[c], 1.0f / 4096);
+                }
+            }
+            va->unlock();
+            vb->unlock();
+        }
+    }
+
+    static void expectIndexesEqual(const IndexData* a, const IndexData* b)
+    {
+        ASSERT_EQ(a->indexCount, b->indexCount);
+        ASSERT_EQ(a->indexBuffer->getType(), b->indexBuffer->getType());
+        size_t size = a->indexCount * a->indexBuffer->getIndexSize();
+        const void* pa = a->indexBuffer->lock(HardwareBuffer::HBL_READ_ONLY);
+        const void* pb = b->indexBuffer->lock(HardwareBuffer::HBL_READ_ONLY);
+        EXPECT_EQ(0, memcmp(pa, pb, size));
+        a->indexBuffer->unlock();
+        b->indexBuffer->unlock();
+    }
+
+    static void expectMeshNear(const MeshPtr& a, const MeshPtr& b)
+    {
+        const AxisAlignedBox& bounds = a->getBounds();
+        expectVertexDataNear(a->sharedVertexData, b->sharedVertexData, bounds);
+        ASSERT_EQ(a->getNumSubMeshes(), b->getNumSubMeshes());
+        for (unsigned short i = 0; i < a->getNumSubMeshes(); ++i)
+        {
+            SubMesh* sa = a->getSubMesh(i);
+            SubMesh* sb = b->getSubMesh(i);
+            EXPECT_EQ(sa->getMaterialName(), sb->getMaterialName());
+            if (!sa->useSharedVertices)
+                expectVertexDataNear(sa->vertexData, sb->vertexData, bounds);
+            expectIndexesEqual(sa->indexData, sb->indexData);
+        }
+        EXPECT_EQ(a->getNumLodLevels(), b->getNumLodLevels());
+        EXPECT_EQ(a->getPoseList().size(), b->getPoseList().size());
+        EXPECT_EQ(a->getNumAnimations(), b->getNumAnimations());
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(MeshCompactTests, RoundTripWithinTolerance)
+{
+    const char* names[] = { "knot.mesh", "ninja.mesh", "facial.mesh", "robot.mesh", "athene.mesh" };
+    for (size_t n = 0; n < 5; ++n)
+    {
+        MeshPtr mesh = MeshManager::getSingleton().load(names[n], "Models");
+        DataStreamPtr full = exportMesh(mesh, MESH_VERSION_1_10);
+        DataStreamPtr compact = exportMesh(mesh, MESH_VERSION_1_10_COMPACT);
+        EXPECT_LT(compact->size(), full->size()) << names[n];
+
+        MeshPtr decoded = importMesh(compact, String("Compact_") + names[n]);
+        expectMeshNear(mesh, decoded);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(MeshCompactTests, RoundTripOtherEndian)
+{
+    MeshPtr mesh = MeshManager::getSingleton().load("ninja.mesh", "Models");
+    Serializer::Endian other = OGRE_ENDIAN == OGRE_ENDIAN_BIG ? Serializer::ENDIAN_LITTLE : Serializer::ENDIAN_BIG;
+    DataStreamPtr native = exportMesh(mesh, MESH_VERSION_1_10_COMPACT);
+    DataStreamPtr swapped = exportMesh(mesh, MESH_VERSION_1_10_COMPACT, other);
+    EXPECT_EQ(native->size(), swapped->size());
+
+    MeshPtr a = importMesh(native, "Native.mesh");
+    MeshPtr b = importMesh(swapped, "Swapped.mesh");
+    expectMeshNear(a, b);
+}
+//--------------------------------------------------------------------------
+TEST_F(MeshCompactTests, CorruptEncodingThrows)
+{
+    MeshPtr mesh = MeshManager::getSingleton().load("knot.mesh", "Models");
+    DataStreamPtr compact = exportMesh(mesh, MESH_VERSION_1_10_COMPACT);
+
+    // The first element of the first compact buffer is the quantised position
+    const size_t encodingOffset = sizeof(uint16) + sizeof(uint32) + sizeof(uint16) * 2;
+    uchar* chunk = findChunk(compact, M_GEOMETRY_COMPACT_VERTEX_BUFFER, encodingOffset, 1);
+    ASSERT_TRUE(chunk != 0);
+    uchar* pEncoding = chunk + encodingOffset;
+
+    // An unknown encoding on a VET_FLOAT3 element
+    uint16 corrupt = 0x7F;
+    memcpy(pEncoding, &corrupt, sizeof(uint16));
+    EXPECT_THROW(importMesh(compact, "Corrupt.mesh"), InvalidParametersException);
+}
+//--------------------------------------------------------------------------
+TEST_F(MeshCompactTests, EmptyCompactBufferThrows)
+{
+    MeshPtr mesh = MeshManager::getSingleton().load("knot.mesh", "Models");
+    DataStreamPtr compact = exportMesh(mesh, MESH_VERSION_1_10_COMPACT);
+
+    // The geometry holding the first compact buffer, the vertex count before its declaration
+    const size_t countOffset = sizeof(uint16) + sizeof(uint32);
+    uchar* chunk = findChunk(compact, M_GEOMETRY, countOffset + sizeof(uint32), M_GEOMETRY_VERTEX_DECLARATION);
+    ASSERT_TRUE(chunk != 0);
+    uint32 vertexCount = 0;
+    memcpy(chunk + countOffset, &vertexCount, sizeof(uint32));
+    // Rejected by the buffer, before anything reads the empty vertices
+    try
+    {
+        importMesh(compact, "Empty.mesh");
+        ADD_FAILURE() << "Expected an exception";
+    }
+    catch (InvalidParametersException& e)
+    {
+        EXPECT_NE(String::npos, e.getDescription().find("without vertices")) << e.getDescription();
+    }
+}
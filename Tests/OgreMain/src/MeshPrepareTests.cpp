@@ -0,0 +1,235 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreMesh.h"
+#include "OgreSubMesh.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshSerializer.h"
+#include "OgreSkeleton.h"
+#include "OgreSkeletonManager.h"
+#include "OgreResourceBackgroundQueue.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+#include "OgreHardwareBufferManager.h"
+#include "OgreDataStream.h"
+#include "OgreConfigFile.h"
+
+#include <fstream>
+
+using namespace Ogre;
+
+namespace
+{
+    /// Records the thread which parsed a mesh, and whether its skeleton was loaded by then
+    class ParseThreadListener : public MeshSerializerListener
+    {
+    public:
+        OGRE_THREAD_ID_TYPE mThread;
+        bool mSkeletonLoaded;
+
+        ParseThreadListener() : mSkeletonLoaded(false) {}
+
+        void processMaterialName(Mesh*, String*) {}
+        void processSkeletonName(Mesh*, String*) {}
+        void processMeshCompleted(Mesh* mesh)
+        {
+            mThread = OGRE_THREAD_CURRENT_ID;
+            mSkeletonLoaded = SkeletonManager::getSingleton().resourceExists(
+                mesh->getSkeletonName(), mesh->getGroup());
+        }
+    };
+}
+
+class MeshPrepareTests : public RootWithoutRenderSystemFixture
+{
+public:
+    String mModelsPath;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+
+        ConfigFile cf;
+        cf.load(mFSLayer->getConfigFilePath("resources.cfg"));
+        mModelsPath = cf.getSettings("Tests").begin()->second + "/../../Samples/Media/models";
+        ResourceGroupManager::getSingleton().addResourceLocation(mModelsPath, "FileSystem", "Models");
+        ResourceGroupManager::getSingleton().initialiseResourceGroup("Models");
+    }
+
+    /// The manager of buffers created through the HardwareBufferManager
+    static HardwareBufferManagerBase* getSystemManager(void)
+    {
+        return HardwareBufferManager::getSingleton().createVertexBuffer(
+            4, 1, HardwareBuffer::HBU_STATIC)->getManager();
+    }
+
+    static String getBytes(HardwareBuffer* buf)
+    {
+        String bytes(buf->getSizeInBytes(), '\0');
+        buf->readData(0, bytes.size(), &bytes[0]);
+        return bytes;
+    }
+
+    static void appendVertexData(const VertexData* vertexData, StringVector& contents,
+        vector<HardwareBufferManagerBase*>::type& managers)
+    {
+        if (!vertexData)
+            return;
+        const VertexBufferBinding::VertexBufferBindingMap& bindings =
+            vertexData->vertexBufferBinding->getBindings();
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator i = bindings.begin();
+            i != bindings.end(); ++i)
+        {
+            contents.push_back(getBytes(i->second.get()));
+            managers.push_back(i->second->getManager());
+        }
+    }
+
+    /// The contents of the buffers of a mesh, and the managers of its vertex buffers
+    static StringVector getContents(const MeshPtr& mesh,
+        vector<HardwareBufferManagerBase*>::type& managers)
+    {
+        StringVector contents;
+        appendVertexData(mesh->sharedVertexData, contents, managers);
+        for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+        {
+            SubMesh* sm = mesh->getSubMesh(i);
+            if (!sm->useSharedVertices)
+                appendVertexData(sm->vertexData, contents, managers);
+            contents.push_back(getBytes(sm->indexData->indexBuffer.get()));
+            contents.push_back(sm->getMaterialName());
+        }
+        return contents;
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(MeshPrepareTests, ParseOnPrepareMatchesLoad)
+{
+    const char* names[] = { "knot.mesh", "ninja.mesh", "facial.mesh", "robot.mesh" };
+    HardwareBufferManagerBase* systemManager = getSystemManager();
+    for (size_t n = 0; n < 4; ++n)
+    {
+        vector<HardwareBufferManagerBase*>::type managers;
+        MeshPtr mesh = MeshManager::getSingleton().load(names[n], "Models");
+        StringVector expected = getContents(mesh, managers);
+        size_t numPoses = mesh->getPoseList().size();
+        unsigned short numAnimations = mesh->getNumAnimations();
+        AxisAlignedBox bounds = mesh->getBounds();
+        MeshManager::getSingleton().remove(mesh);
+        mesh.reset();
+
+        MeshManager::getSingleton().setParseMeshesOnPrepare(true);
+        mesh = MeshManager::getSingleton().prepare(names[n], "Models");
+        EXPECT_TRUE(mesh->isPrepared());
+
+        // Already parsed, into buffers of its own
+        managers.clear();
+        EXPECT_EQ(expected, getContents(mesh, managers));
+        for (size_t i = 0; i < managers.size(); ++i)
+            EXPECT_NE(systemManager, managers[i]);
+
+        mesh->load();
+        managers.clear();
+        EXPECT_EQ(expected, getContents(mesh, managers));
+        for (size_t i = 0; i < managers.size(); ++i)
+            EXPECT_EQ(systemManager, managers[i]);
+        EXPECT_EQ(numPoses, mesh->getPoseList().size());
+        EXPECT_EQ(numAnimations, mesh->getNumAnimations());
+        EXPECT_EQ(bounds, mesh->getBounds());
+        MeshManager::getSingleton().remove(mesh);
+
+        // Prepared but never loaded
+        MeshManager::getSingleton().prepare(names[n], "Models");
+        MeshManager::getSingleton().remove(names[n], "Models");
+        MeshManager::getSingleton().setParseMeshesOnPrepare(false);
+    }
+}
+//--------------------------------------------------------------------------
+#if OGRE_THREAD_SUPPORT
+TEST_F(MeshPrepareTests, ParseOnPrepareInBackground)
+{
+    vector<HardwareBufferManagerBase*>::type managers;
+    MeshPtr mesh = MeshManager::getSingleton().load("robot.mesh", "Models");
+    StringVector expected = getContents(mesh, managers);
+    String skeletonName = mesh->getSkeletonName();
+    ASSERT_FALSE(skeletonName.empty());
+    MeshManager::getSingleton().remove(mesh);
+    mesh.reset();
+    SkeletonManager::getSingleton().remove(skeletonName, "Models");
+
+    DefaultWorkQueue* queue = static_cast<DefaultWorkQueue*>(mRoot->getWorkQueue());
+    queue->setWorkerThreadCount(2);
+    ResourceBackgroundQueue::getSingleton().initialise();
+    queue->startup();
+
+    MeshManager::getSingleton().setParseMeshesOnPrepare(true);
+    ParseThreadListener listener;
+    MeshManager::getSingleton().setListener(&listener);
+    BackgroundProcessTicket ticket = ResourceBackgroundQueue::getSingleton().prepare(
+        MeshManager::getSingleton().getResourceType(), "robot.mesh", "Models");
+    while (!ResourceBackgroundQueue::getSingleton().isProcessComplete(ticket))
+        queue->processResponses();
+    MeshManager::getSingleton().setListener(0);
+    MeshManager::getSingleton().setParseMeshesOnPrepare(false);
+
+    mesh = MeshManager::getSingleton().getByName("robot.mesh", "Models");
+    ASSERT_TRUE(mesh);
+    EXPECT_TRUE(mesh->isPrepared());
+    EXPECT_NE(OGRE_THREAD_CURRENT_ID, listener.mThread);
+    // The skeleton is only named while parsing, and loaded with the mesh
+    EXPECT_FALSE(listener.mSkeletonLoaded);
+    EXPECT_EQ(skeletonName, mesh->getSkeletonName());
+    EXPECT_FALSE(SkeletonManager::getSingleton().resourceExists(skeletonName, "Models"));
+
+    mesh->load();
+    managers.clear();
+    EXPECT_EQ(expected, getContents(mesh, managers));
+    ASSERT_TRUE(mesh->getSkeleton());
+    EXPECT_TRUE(mesh->getSkeleton()->isLoaded());
+}
+#endif
+//--------------------------------------------------------------------------
+TEST_F(MeshPrepareTests, ImportFromFileMatchesMemory)
+{
+    MeshSerializer serializer;
+    MeshPtr fromMemory = MeshManager::getSingleton().createManual("Memory.mesh", "Models");
+    DataStreamPtr stream = ResourceGroupManager::getSingleton().openResource("ninja.mesh", "Models");
+    stream.reset(OGRE_NEW MemoryDataStream(stream));
+    serializer.importMesh(stream, fromMemory.get());
+
+    MeshPtr fromFile = MeshManager::getSingleton().createManual("File.mesh", "Models");
+    std::ifstream* file = OGRE_NEW_T(std::ifstream, MEMCATEGORY_GENERAL)(
+        (mModelsPath + "/ninja.mesh").c_str(), std::ios::in | std::ios::binary);
+    ASSERT_TRUE(file->is_open());
+    stream.reset(OGRE_NEW FileStreamDataStream(file));
+    serializer.importMesh(stream, fromFile.get());
+
+    vector<HardwareBufferManagerBase*>::type managers;
+    EXPECT_EQ(getContents(fromFile, managers), getContents(fromMemory, managers));
+}
@@ -0,0 +1,451 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreParticleSystem.h"
+#include "OgreParticleSystemManager.h"
+#include "OgreParticleEmitter.h"
+#include "OgreParticleEmitterFactory.h"
+#include "OgreParticleAffector.h"
+#include "OgreParticleAffectorFactory.h"
+#include "OgreParticleIterator.h"
+#include "OgreParticleArrays.h"
+#include "OgreParticle.h"
+#include "OgreControllerManager.h"
+#include "OgreMath.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Emits from its position, as the ParticleFX point emitter does
+    class TestEmitter : public ParticleEmitter
+    {
+    public:
+        TestEmitter(ParticleSystem* psys) : ParticleEmitter(psys) { mType = "Test"; }
+
+        void _initParticle(Particle* pParticle)
+        {
+            ParticleEmitter::_initParticle(pParticle);
+            pParticle->mPosition = mPosition;
+            genEmissionColour(pParticle->mColour);
+            genEmissionDirection(pParticle->mPosition, pParticle->mDirection);
+            genEmissionVelocity(pParticle->mDirection);
+            pParticle->mTimeToLive = pParticle->mTotalTimeToLive = genEmissionTTL();
+            // Some particles with a size of their own
+            if (Math::UnitRandom() < 0.25f)
+                pParticle->setDimensions(Math::RangeRandom(1, 50), Math::RangeRandom(1, 50));
+        }
+
+        unsigned short _getEmissionCount(Real timeElapsed) { return genConstantEmissionCount(timeElapsed); }
+    };
+
+    class TestEmitterFactory : public ParticleEmitterFactory
+    {
+    public:
+        String getName() const { return "Test"; }
+        ParticleEmitter* createEmitter(ParticleSystem* psys)
+        {
+            ParticleEmitter* emitter = OGRE_NEW TestEmitter(psys);
+            mEmitters.push_back(emitter);
+            return emitter;
+        }
+    };
+
+    /// Accelerates and fades the particles, through ParticleArrays if arrays is set
+    class TestAffector : public ParticleAffector
+    {
+    public:
+        bool mArrays;
+
+        TestAffector(ParticleSystem* psys, bool arrays) : ParticleAffector(psys), mArrays(arrays)
+        {
+            mType = arrays ? "TestArrays" : "TestList";
+        }
+
+        void _initParticle(Particle* pParticle)
+        {
+            // Recycled particles keep their rotation otherwise
+            pParticle->mRotation = 0;
+        }
+
+        static void affect(Vector3& direction, Real& alpha, Real& rotation, Real timeElapsed)
+        {
+            direction += Vector3(0, -9.8f, 1) * timeElapsed;
+            alpha -= 0.25f * timeElapsed;
+            rotation += timeElapsed;
+        }
+
+        void _affectParticles(ParticleSystem* pSystem, Real timeElapsed)
+        {
+            ParticleIterator it = pSystem->_getIterator();
+            while (!it.end())
+            {
+                Particle* p = it.getNext();
+                Real rotation = p->mRotation.valueRadians();
+                affect(p->mDirection, p->mColour.a, rotation, timeElapsed);
+                p->mRotation = Radian(rotation);
+            }
+        }
+
+        bool _supportsParticleArrays(void) const { return mArrays; }
+
+        void _affectParticleArrays(ParticleArrays& particles, Real timeElapsed)
+        {
+            for (size_t i = 0; i < particles.mCount; ++i)
+            {
+                Vector3 direction(particles.mDirectionX[i], particles.mDirectionY[i], particles.mDirectionZ[i]);
+                affect(direction, particles.mColourA[i], particles.mRotation[i], timeElapsed);
+                particles.mDirectionX[i] = direction.x;
+                particles.mDirectionY[i] = direction.y;
+                particles.mDirectionZ[i] = direction.z;
+            }
+        }
+    };
+
+    class TestAffectorFactory : public ParticleAffectorFactory
+    {
+    public:
+        bool mArrays;
+
+        TestAffectorFactory(bool arrays) : mArrays(arrays) {}
+        String getName() const { return mArrays ? "TestArrays" : "TestList"; }
+        ParticleAffector* createAffector(ParticleSystem* psys)
+        {
+            ParticleAffector* affector = OGRE_NEW TestAffector(psys, mArrays);
+            mAffectors.push_back(affector);
+            return affector;
+        }
+    };
+
+    /// The attributes of a particle, to compare them whichever the storage
+    struct ParticleState
+    {
+        Real values[14];
+
+        ParticleState(const Particle& p)
+        {
+            Real v[14] = { p.mTimeToLive, p.mTotalTimeToLive, p.mPosition.x, p.mPosition.y, p.mPosition.z,
+                p.mDirection.x, p.mDirection.y, p.mDirection.z, p.mColour.r, p.mColour.a,
+                p.mRotation.valueRadians(), p.mOwnDimensions ? p.mWidth : -1, p.mOwnDimensions ? p.mHeight : -1,
+                p.mRotationSpeed.valueRadians() };
+            memcpy(values, v, sizeof(values));
+        }
+
+        bool operator<(const ParticleState& rhs) const
+        {
+            return std::lexicographical_compare(values, values + 14, rhs.values, rhs.values + 14);
+        }
+    };
+    typedef vector<ParticleState>::type ParticleStateList;
+}
+
+class ParticleSystemTests : public RootWithoutRenderSystemFixture
+{
+public:
+    ControllerManager* mControllerMgr;
+    SceneManager* mSceneMgr;
+    TestEmitterFactory mEmitterFactory;
+    TestAffectorFactory mListAffectorFactory;
+    TestAffectorFactory mArraysAffectorFactory;
+
+    ParticleSystemTests() : mListAffectorFactory(false), mArraysAffectorFactory(true) {}
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        // Created by Root::initialise, the systems need one when attached
+        mControllerMgr = OGRE_NEW ControllerManager();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+
+        // Registers the billboard renderer, as Root::initialise does
+        ParticleSystemManager::getSingleton()._initialise();
+        ParticleSystemManager::getSingleton().addEmitterFactory(&mEmitterFactory);
+        ParticleSystemManager::getSingleton().addAffectorFactory(&mListAffectorFactory);
+        ParticleSystemManager::getSingleton().addAffectorFactory(&mArraysAffectorFactory);
+    }
+
+    void TearDown()
+    {
+        // The systems go with the scene manager, before the factories their emitters came from
+        RootWithoutRenderSystemFixture::TearDown();
+        OGRE_DELETE mControllerMgr;
+    }
+
+    /// A system with an emitter and the given affectors
+    ParticleSystem* createSystem(size_t quota, bool contiguous, const char* affector1, const char* affector2)
+    {
+        ParticleSystem* system = mSceneMgr->createParticleSystem(quota);
+        system->setContiguousStorage(contiguous);
+        SceneNode* node = mSceneMgr->getRootSceneNode()->createChildSceneNode(Vector3(10, 0, 0));
+        // The full transform is not derived from the position in these tests
+        node->overrideCachedTransform(Matrix4::getTrans(Vector3(10, 0, 0)));
+        node->attachObject(system);
+
+        ParticleEmitter* emitter = system->addEmitter("Test");
+        emitter->setEmissionRate(Real(quota));
+        emitter->setTimeToLive(0.5f, 2);
+        emitter->setAngle(Degree(30));
+        emitter->setParticleVelocity(5, 20);
+        emitter->setColour(ColourValue(0, 0, 0, 1), ColourValue(1, 1, 1, 1));
+        if (affector1)
+            system->addAffector(affector1);
+        if (affector2)
+            system->addAffector(affector2);
+        return system;
+    }
+
+    static ParticleStateList getStates(ParticleSystem* system)
+    {
+        ParticleStateList states;
+        for (size_t i = 0; i < system->getNumParticles(); ++i)
+            states.push_back(ParticleState(*system->getParticle(i)));
+        std::sort(states.begin(), states.end());
+        return states;
+    }
+
+    /// Updates a system for some frames, returning the sorted particles after each
+    static vector<ParticleStateList>::type run(ParticleSystem* system, int frames)
+    {
+        srand(7);
+        vector<ParticleStateList>::type result;
+        for (int f = 0; f < frames; ++f)
+        {
+            system->_update(1 / 30.0f);
+            result.push_back(getStates(system));
+        }
+        return result;
+    }
+
+    static void expectSame(const ParticleStateList& expected, const ParticleStateList& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            for (size_t v = 0; v < 14; ++v)
+                ASSERT_NEAR(expected[i].values[v], actual[i].values[v], 1e-4f) << "particle " << i << " value " << v;
+        }
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(ParticleSystemTests, ParticleArrays)
+{
+    ParticleArrays arrays;
+    arrays.reserve(5);
+    EXPECT_EQ(8u, arrays.getCapacity());
+
+    Particle p;
+    for (int i = 0; i < 5; ++i)
+    {
+        p.mTimeToLive = Real(i);
+        p.mPosition = Vector3(Real(i), 0, 0);
+        p.mOwnDimensions = i == 3;
+        arrays.append(p);
+    }
+
+    // The last takes the place of the removed one
+    arrays.remove(1);
+    ASSERT_EQ(4u, arrays.mCount);
+    EXPECT_EQ(4, arrays.mTimeToLive[1]);
+    arrays.remove(3);
+    ASSERT_EQ(3u, arrays.mCount);
+
+    // Grown with the particles kept
+    arrays.reserve(100);
+    EXPECT_EQ(100u, arrays.getCapacity());
+    const Real expected[] = { 0, 4, 2 };
+    for (size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(expected[i], arrays.mTimeToLive[i]);
+        EXPECT_EQ(expected[i], arrays.mPositionX[i]);
+    }
+
+    const uint32 order[] = { 2, 0, 1 };
+    arrays.reorder(order);
+    arrays.getParticle(0, p);
+    EXPECT_EQ(2, p.mTimeToLive);
+    EXPECT_EQ(Vector3(2, 0, 0), p.mPosition);
+    arrays.getParticle(2, p);
+    EXPECT_EQ(4, p.mTimeToLive);
+    EXPECT_FALSE(p.mOwnDimensions);
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleSystemTests, ContiguousStorageMatchesList)
+{
+    // Affectors working on arrays, on Particle instances, and both
+    const char* affectors[][2] = { { 0, 0 }, { "TestArrays", 0 }, { "TestList", 0 }, { "TestArrays", "TestList" } };
+    for (int a = 0; a < 4; ++a)
+    {
+        SCOPED_TRACE(a);
+        ParticleSystem* list = createSystem(300, false, affectors[a][0], affectors[a][1]);
+        ParticleSystem* contiguous = createSystem(300, true, affectors[a][0], affectors[a][1]);
+
+        vector<ParticleStateList>::type expected = run(list, 90);
+        vector<ParticleStateList>::type actual = run(contiguous, 90);
+        EXPECT_FALSE(list->isUsingContiguousStorage());
+        EXPECT_TRUE(contiguous->isUsingContiguousStorage());
+        for (size_t f = 0; f < expected.size(); ++f)
+            expectSame(expected[f], actual[f]);
+
+        // The quota was reached
+        EXPECT_EQ(list->getNumParticles(), contiguous->getNumParticles());
+        EXPECT_GT(contiguous->getNumParticles(), 200u);
+
+        const AxisAlignedBox& listBounds = list->getBoundingBox();
+        const AxisAlignedBox& contiguousBounds = contiguous->getBoundingBox();
+        for (int c = 0; c < 3; ++c)
+        {
+            EXPECT_NEAR(listBounds.getMinimum()[c], contiguousBounds.getMinimum()[c], 1e-3f);
+            EXPECT_NEAR(listBounds.getMaximum()[c], contiguousBounds.getMaximum()[c], 1e-3f);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleSystemTests, ParticleInstancesCopiedBack)
+{
+    ParticleSystem* system = createSystem(100, true, "TestArrays", 0);
+    system->fastForward(1, 0.1f);
+    ASSERT_TRUE(system->isUsingContiguousStorage());
+    size_t count = system->getNumParticles();
+    ASSERT_GT(count, 10u);
+
+    // Changes made through Particle instances are kept
+    system->setEmitting(false);
+    for (size_t i = 0; i < count; i += 2)
+        system->getParticle(i)->mTimeToLive = 0;
+    Particle* manual = system->createParticle();
+    manual->mTimeToLive = 100;
+    system->_update(0.01f);
+    EXPECT_EQ(count - (count + 1) / 2 + 1, system->getNumParticles());
+
+    // Back to Particle instances
+    count = system->getNumParticles();
+    system->setContiguousStorage(false);
+    system->_update(0.01f);
+    EXPECT_FALSE(system->isUsingContiguousStorage());
+    EXPECT_EQ(count, system->getNumParticles());
+
+    system->clear();
+    EXPECT_EQ(0u, system->getNumParticles());
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleSystemTests, ContiguousStorageOption)
+{
+    ParticleSystem* system = createSystem(10, false, 0, 0);
+    EXPECT_EQ("false", system->getParameter("contiguous_storage"));
+    system->setParameter("contiguous_storage", "true");
+    EXPECT_TRUE(system->getContiguousStorage());
+
+    system->_update(0.1f);
+    EXPECT_TRUE(system->isUsingContiguousStorage());
+
+    // Not with emitters emitting emitters
+    ParticleSystem* emitting = createSystem(10, true, 0, 0);
+    emitting->getEmitter(0)->setEmittedEmitter("Child");
+    emitting->addEmitter("Test")->setName("Child");
+    emitting->_update(0.1f);
+    EXPECT_FALSE(emitting->isUsingContiguousStorage());
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleSystemTests, ParallelUpdateMatchesSerial)
+{
+    // Systems whose particles can be updated concurrently, and ones which can't
+    const bool contiguous[] = { true, true, false, true, true };
+    const char* affectors[] = { "TestArrays", "TestList", "TestArrays", 0, "TestArrays" };
+    const size_t numSystems = 5;
+    const int frames = 60;
+    ParticleSystemManager& mgr = ParticleSystemManager::getSingleton();
+
+    vector<ParticleStateList>::type expected[numSystems];
+    for (int parallel = 0; parallel < 2; ++parallel)
+    {
+        vector<ParticleSystem*>::type systems;
+        for (size_t s = 0; s < numSystems; ++s)
+            systems.push_back(createSystem(200 + 50 * s, contiguous[s], affectors[s], 0));
+        systems[4]->setIterationInterval(0.01f);
+        mgr.setParallelUpdate(parallel != 0);
+
+        srand(7);
+        for (int f = 0; f < frames; ++f)
+        {
+            if (parallel)
+            {
+                mgr._updateSystems(1 / 30.0f);
+            }
+            else
+            {
+                // Emitting in the same order as the manager
+                for (size_t s = 0; s < numSystems; ++s)
+                    systems[s]->_update(1 / 30.0f);
+            }
+
+            for (size_t s = 0; s < numSystems; ++s)
+            {
+                SCOPED_TRACE(s);
+                if (parallel)
+                    expectSame(expected[s][f], getStates(systems[s]));
+                else
+                    expected[s].push_back(getStates(systems[s]));
+            }
+        }
+        EXPECT_TRUE(systems[0]->isUsingContiguousStorage());
+        EXPECT_GT(systems[0]->getNumParticles(), 100u);
+        mSceneMgr->destroyAllParticleSystems();
+    }
+    mgr.setParallelUpdate(false);
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleSystemTests, ParallelUpdateOption)
+{
+    ParticleSystemManager& mgr = ParticleSystemManager::getSingleton();
+    EXPECT_FALSE(mgr.getParallelUpdate());
+    ParticleSystem* system = createSystem(100, true, "TestArrays", 0);
+    ParticleSystem* detached = createSystem(100, true, "TestArrays", 0);
+    detached->detachFromParent();
+
+    // Updated in the frame started event, and no longer by the controllers
+    mgr.setParallelUpdate(true);
+    EXPECT_TRUE(mgr.getParallelUpdate());
+    FrameEvent evt;
+    evt.timeSinceLastFrame = 0.1f;
+    mRoot->_fireFrameStarted(evt);
+    EXPECT_EQ(10u, system->getNumParticles());
+    mRoot->_fireFrameRenderingQueued(evt);
+    mControllerMgr->updateAllControllers();
+    EXPECT_EQ(10u, system->getNumParticles());
+    EXPECT_EQ(0u, detached->getNumParticles());
+
+    mgr.setParallelUpdate(false);
+    mRoot->_fireFrameStarted(evt);
+    mRoot->_fireFrameRenderingQueued(evt);
+    mControllerMgr->updateAllControllers();
+    EXPECT_EQ(20u, system->getNumParticles());
+}
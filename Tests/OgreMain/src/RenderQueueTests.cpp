@@ -0,0 +1,292 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreRenderQueueSortingGrouping.h"
+#include "OgreRenderable.h"
+#include "OgreMaterialManager.h"
+#include "OgreTechnique.h"
+#include "OgrePass.h"
+#include "OgreMath.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Renderable at a fixed view depth
+    class DepthRenderable : public Renderable
+    {
+    public:
+        Real mDepth;
+
+        DepthRenderable(Real depth) : mDepth(depth) {}
+
+        const MaterialPtr& getMaterial(void) const { static MaterialPtr none; return none; }
+        void getRenderOperation(RenderOperation& op) {}
+        void getWorldTransforms(Matrix4* xform) const { *xform = Matrix4::IDENTITY; }
+        Real getSquaredViewDepth(const Camera* cam) const { return mDepth; }
+        const LightList& getLights(void) const { static LightList none; return none; }
+    };
+
+    /// Records what the collection visits, passes as a null renderable
+    class RecordingVisitor : public QueuedRenderableVisitor
+    {
+    public:
+        vector<std::pair<const Pass*, Renderable*> >::type mVisits;
+        const Pass* mSkippedPass;
+
+        RecordingVisitor() : mSkippedPass(0) {}
+
+        void visit(RenderablePass* rp) { mVisits.push_back(std::make_pair(rp->pass, rp->renderable)); }
+        bool visit(const Pass* p)
+        {
+            mVisits.push_back(std::make_pair(p, static_cast<Renderable*>(0)));
+            return p != mSkippedPass;
+        }
+        void visit(Renderable* r) { mVisits.push_back(std::make_pair(static_cast<const Pass*>(0), r)); }
+    };
+
+    struct QueuedItem
+    {
+        Pass* pass;
+        DepthRenderable* rend;
+        size_t order;
+    };
+
+    /// The order of the pass groups before they were sorted by key
+    struct GroupedLess
+    {
+        bool operator()(const QueuedItem& a, const QueuedItem& b) const
+        {
+            if (a.pass->getHash() != b.pass->getHash())
+                return a.pass->getHash() < b.pass->getHash();
+            if (a.pass != b.pass)
+                return a.pass < b.pass;
+            return a.order < b.order;
+        }
+    };
+
+    /// The order of the radix sorted depths before they were sorted by key
+    struct DescendingLess
+    {
+        bool operator()(const QueuedItem& a, const QueuedItem& b) const
+        {
+            if (a.rend->mDepth != b.rend->mDepth)
+                return a.rend->mDepth > b.rend->mDepth;
+            if (a.pass->getHash() != b.pass->getHash())
+                return a.pass->getHash() < b.pass->getHash();
+            return a.order < b.order;
+        }
+    };
+}
+
+class RenderQueueTests : public RootWithoutRenderSystemFixture
+{
+public:
+    vector<Pass*>::type mPasses;
+    vector<DepthRenderable*>::type mRenderables;
+    vector<QueuedItem>::type mItems;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        DefaultWorkQueue* queue = static_cast<DefaultWorkQueue*>(mRoot->getWorkQueue());
+        queue->setWorkerThreadCount(4);
+        queue->startup();
+
+        // Passes without textures share their hash with the passes of the
+        // same index in other materials
+        for (int m = 0; m < 20; ++m)
+        {
+            MaterialPtr mat = MaterialManager::getSingleton().create(
+                "RenderQueueTests" + StringConverter::toString(m),
+                ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+            Technique* tech = mat->getTechnique(0);
+            for (int p = 0; p < 3; ++p)
+            {
+                Pass* pass = p ? tech->createPass() : tech->getPass(0);
+                if (m % 2)
+                    pass->createTextureUnitState("Texture" + StringConverter::toString(m * 3 + p));
+                pass->_recalculateHash();
+                mPasses.push_back(pass);
+            }
+        }
+    }
+
+    void TearDown()
+    {
+        for (size_t i = 0; i < mRenderables.size(); ++i)
+            OGRE_DELETE mRenderables[i];
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    /// Fills the collection with random renderables, some at equal depths
+    void fill(QueuedRenderableCollection& collection, size_t count)
+    {
+        srand(0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (mRenderables.size() <= i)
+                mRenderables.push_back(OGRE_NEW DepthRenderable(0));
+            DepthRenderable* rend = mRenderables[i];
+            rend->mDepth = rand() % 4 ? Math::RangeRandom(0, 10000) : Real(rand() % 10);
+            QueuedItem item = { mPasses[rand() % mPasses.size()], rend, mItems.size() };
+            mItems.push_back(item);
+            collection.addRenderable(item.pass, rend);
+        }
+    }
+
+    void expectGrouped(const QueuedRenderableCollection& collection, const Pass* skippedPass = 0)
+    {
+        vector<QueuedItem>::type expected = mItems;
+        std::sort(expected.begin(), expected.end(), GroupedLess());
+
+        RecordingVisitor visitor;
+        visitor.mSkippedPass = skippedPass;
+        collection.acceptVisitor(&visitor, QueuedRenderableCollection::OM_PASS_GROUP);
+
+        size_t v = 0;
+        const Pass* lastPass = 0;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            if (expected[i].pass != lastPass)
+            {
+                ASSERT_LT(v, visitor.mVisits.size());
+                EXPECT_EQ(expected[i].pass, visitor.mVisits[v++].first);
+                lastPass = expected[i].pass;
+            }
+            if (lastPass == skippedPass)
+                continue;
+            ASSERT_LT(v, visitor.mVisits.size());
+            EXPECT_EQ(0, visitor.mVisits[v].first);
+            EXPECT_EQ(expected[i].rend, visitor.mVisits[v++].second);
+        }
+        EXPECT_EQ(v, visitor.mVisits.size());
+    }
+
+    void expectDescending(const QueuedRenderableCollection& collection)
+    {
+        vector<QueuedItem>::type expected = mItems;
+        std::sort(expected.begin(), expected.end(), DescendingLess());
+
+        RecordingVisitor descending, ascending;
+        collection.acceptVisitor(&descending, QueuedRenderableCollection::OM_SORT_DESCENDING);
+        collection.acceptVisitor(&ascending, QueuedRenderableCollection::OM_SORT_ASCENDING);
+        ASSERT_EQ(expected.size(), descending.mVisits.size());
+        ASSERT_EQ(expected.size(), ascending.mVisits.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_EQ(expected[i].pass, descending.mVisits[i].first);
+            EXPECT_EQ(expected[i].rend, descending.mVisits[i].second);
+            EXPECT_EQ(expected[i].rend, ascending.mVisits[expected.size() - 1 - i].second);
+        }
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(RenderQueueTests, PassGroups)
+{
+    const size_t counts[] = { 0, 1, 100, 5000 };
+    for (size_t c = 0; c < 4; ++c)
+    {
+        SCOPED_TRACE(counts[c]);
+        QueuedRenderableCollection collection;
+        collection.addOrganisationMode(QueuedRenderableCollection::OM_PASS_GROUP);
+        mItems.clear();
+        fill(collection, counts[c]);
+
+        // Grouped even without sorting first
+        expectGrouped(collection);
+        collection.sort(0);
+        expectGrouped(collection, mPasses[4]);
+
+        // Renderables added later join their pass groups
+        fill(collection, counts[c] / 2);
+        collection.sort(0);
+        expectGrouped(collection);
+
+        collection.clear();
+        mItems.clear();
+        expectGrouped(collection);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(RenderQueueTests, DepthSorting)
+{
+    const size_t counts[] = { 0, 1, 100, 5000 };
+    for (size_t c = 0; c < 4; ++c)
+    {
+        SCOPED_TRACE(counts[c]);
+        QueuedRenderableCollection collection;
+        collection.addOrganisationMode(QueuedRenderableCollection::OM_SORT_ASCENDING);
+        collection.addOrganisationMode(QueuedRenderableCollection::OM_PASS_GROUP);
+        mItems.clear();
+        fill(collection, counts[c]);
+        collection.sort(0);
+        expectDescending(collection);
+        expectGrouped(collection);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(RenderQueueTests, ParallelSortMatchesSerial)
+{
+    EXPECT_EQ(0u, QueuedRenderableCollection::getParallelSortThreshold());
+    QueuedRenderableCollection::setParallelSortThreshold(1000);
+    EXPECT_EQ(1000u, QueuedRenderableCollection::getParallelSortThreshold());
+
+    QueuedRenderableCollection collection;
+    collection.addOrganisationMode(QueuedRenderableCollection::OM_SORT_DESCENDING);
+    collection.addOrganisationMode(QueuedRenderableCollection::OM_PASS_GROUP);
+    fill(collection, 40000);
+    collection.sort(0);
+    QueuedRenderableCollection::setParallelSortThreshold(0);
+
+    expectDescending(collection);
+    expectGrouped(collection);
+}
+//--------------------------------------------------------------------------
+TEST_F(RenderQueueTests, RemovePassGroup)
+{
+    QueuedRenderableCollection collection;
+    collection.addOrganisationMode(QueuedRenderableCollection::OM_SORT_DESCENDING);
+    collection.addOrganisationMode(QueuedRenderableCollection::OM_PASS_GROUP);
+    fill(collection, 1000);
+    collection.removePassGroup(mPasses[7]);
+    collection.sort(0);
+
+    vector<QueuedItem>::type remaining;
+    for (size_t i = 0; i < mItems.size(); ++i)
+    {
+        if (mItems[i].pass != mPasses[7])
+            remaining.push_back(mItems[i]);
+    }
+    mItems.swap(remaining);
+    expectDescending(collection);
+    expectGrouped(collection);
+}
@@ -0,0 +1,194 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreRenderStateCache.h"
+#include "OgreSceneManager.h"
+#include "OgreMaterialManager.h"
+#include "OgreTechnique.h"
+#include "OgrePass.h"
+#include "OgreLogManager.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// The states SceneManager::_setPass sets for a fixed function pass
+    void setPassStates(RenderStateCache& cache, const Pass* pass)
+    {
+        cache.unbindGpuProgram(GPT_VERTEX_PROGRAM);
+        cache.unbindGpuProgram(GPT_FRAGMENT_PROGRAM);
+        if (pass->getLightingEnabled())
+        {
+            cache.setSurfaceParams(pass->getAmbient(), pass->getDiffuse(), pass->getSpecular(),
+                pass->getSelfIllumination(), pass->getShininess(), pass->getVertexColourTracking());
+        }
+        cache.setLightingEnabled(pass->getLightingEnabled());
+        cache.setFog(pass->getFogMode(), pass->getFogColour(), pass->getFogDensity(),
+            pass->getFogStart(), pass->getFogEnd());
+        cache.setSceneBlending(pass->getSourceBlendFactor(), pass->getDestBlendFactor(),
+            pass->getSceneBlendingOperation());
+        cache.setDepthBufferFunction(pass->getDepthFunction());
+        cache.setDepthBufferCheckEnabled(pass->getDepthCheckEnabled());
+        cache.setDepthBufferWriteEnabled(pass->getDepthWriteEnabled());
+        cache.setDepthBias(pass->getDepthBiasConstant(), pass->getDepthBiasSlopeScale());
+        cache.setAlphaRejectSettings(pass->getAlphaRejectFunction(), pass->getAlphaRejectValue(),
+            pass->isAlphaToCoverageEnabled());
+        bool colWrite = pass->getColourWriteEnabled();
+        cache.setColourBufferWriteEnabled(colWrite, colWrite, colWrite, colWrite);
+        cache.setCullingMode(pass->getCullingMode());
+        cache.setShadingType(pass->getShadingMode());
+        cache.setPolygonMode(pass->getPolygonMode());
+    }
+}
+
+typedef RootWithoutRenderSystemFixture RenderStateCacheTests;
+//--------------------------------------------------------------------------
+TEST_F(RenderStateCacheTests, FiltersRedundantChanges)
+{
+    RenderStateCache cache;
+    EXPECT_TRUE(cache.getEnabled());
+    EXPECT_EQ(0, cache.getRenderSystem());
+
+    // Nothing is known at first
+    cache.setCullingMode(CULL_CLOCKWISE);
+    cache.setDepthBufferParams(true, true, CMPF_LESS_EQUAL);
+    EXPECT_EQ(2u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(0u, cache.getStatistics().redundantChanges);
+
+    cache.setCullingMode(CULL_CLOCKWISE);
+    cache.setDepthBufferCheckEnabled(true);
+    cache.setDepthBufferWriteEnabled(true);
+    cache.setDepthBufferFunction(CMPF_LESS_EQUAL);
+    cache.setDepthBufferParams();
+    EXPECT_EQ(2u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(5u, cache.getStatistics().redundantChanges);
+
+    cache.setCullingMode(CULL_NONE);
+    cache.setDepthBufferWriteEnabled(false);
+    cache.setDepthBufferParams();
+    EXPECT_EQ(5u, cache.getStatistics().appliedChanges);
+
+    // Blending without separate alpha settings is the same as with equal ones
+    cache.setSceneBlending(SBF_SOURCE_ALPHA, SBF_ONE_MINUS_SOURCE_ALPHA, SBO_ADD);
+    cache.setSeparateSceneBlending(SBF_SOURCE_ALPHA, SBF_ONE_MINUS_SOURCE_ALPHA,
+        SBF_SOURCE_ALPHA, SBF_ONE_MINUS_SOURCE_ALPHA, SBO_ADD, SBO_ADD);
+    cache.setSeparateSceneBlending(SBF_SOURCE_ALPHA, SBF_ONE_MINUS_SOURCE_ALPHA,
+        SBF_ONE, SBF_ZERO, SBO_ADD, SBO_ADD);
+    cache.setSceneBlending(SBF_SOURCE_ALPHA, SBF_ONE_MINUS_SOURCE_ALPHA, SBO_ADD);
+    EXPECT_EQ(8u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(6u, cache.getStatistics().redundantChanges);
+
+    cache.resetStatistics();
+    EXPECT_EQ(0u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(0u, cache.getStatistics().redundantChanges);
+}
+//--------------------------------------------------------------------------
+TEST_F(RenderStateCacheTests, InvalidateAndDisable)
+{
+    RenderStateCache cache;
+    cache.setPolygonMode(PM_WIREFRAME);
+    cache.setDepthBias(1, 2);
+    cache.setLightingEnabled(true);
+
+    cache.invalidateDepthBias();
+    cache.setPolygonMode(PM_WIREFRAME);
+    cache.setDepthBias(1, 2);
+    EXPECT_EQ(4u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(1u, cache.getStatistics().redundantChanges);
+
+    cache.invalidate();
+    cache.setPolygonMode(PM_WIREFRAME);
+    cache.setLightingEnabled(true);
+    EXPECT_EQ(6u, cache.getStatistics().appliedChanges);
+
+    // Everything is passed on while disabled
+    cache.setEnabled(false);
+    EXPECT_FALSE(cache.getEnabled());
+    cache.setPolygonMode(PM_WIREFRAME);
+    cache.setPolygonMode(PM_WIREFRAME);
+    EXPECT_EQ(8u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(1u, cache.getStatistics().redundantChanges);
+
+    cache.setEnabled(true);
+    cache.setPolygonMode(PM_WIREFRAME);
+    cache.setPolygonMode(PM_WIREFRAME);
+    EXPECT_EQ(9u, cache.getStatistics().appliedChanges);
+    EXPECT_EQ(2u, cache.getStatistics().redundantChanges);
+
+    // Texture units are always set
+    cache.disableTextureUnitsFrom(0);
+    cache.disableTextureUnitsFrom(0);
+    EXPECT_EQ(11u, cache.getStatistics().appliedChanges);
+}
+//--------------------------------------------------------------------------
+TEST_F(RenderStateCacheTests, PassSequence)
+{
+    // A typical mix: opaque passes sharing most states, a few blended and two sided
+    vector<Pass*>::type passes;
+    for (int m = 0; m < 12; ++m)
+    {
+        MaterialPtr mat = MaterialManager::getSingleton().create(
+            "RenderStateCacheTests" + StringConverter::toString(m),
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+        Pass* pass = mat->getTechnique(0)->getPass(0);
+        pass->setDiffuse(ColourValue(m / 12.0f, 1, 1));
+        if (m >= 9)
+            pass->setSceneBlending(SBT_TRANSPARENT_ALPHA);
+        if (m % 4 == 3)
+            pass->setCullingMode(CULL_NONE);
+        passes.push_back(pass);
+    }
+
+    RenderStateCache cache;
+    for (size_t i = 0; i < passes.size(); ++i)
+        setPassStates(cache, passes[i]);
+
+    const RenderStateCache::Statistics& stats = cache.getStatistics();
+    // The first pass sets everything, the rest only the diffuse colour and
+    // the few states which differ
+    EXPECT_EQ(15u + 11 + 1 + 5, stats.appliedChanges);
+    EXPECT_EQ(15u * passes.size(), stats.appliedChanges + stats.redundantChanges);
+
+    LogManager::getSingleton().stream() << "RenderStateCache: " << stats.redundantChanges
+        << " of " << stats.appliedChanges + stats.redundantChanges << " state changes filtered";
+}
+//--------------------------------------------------------------------------
+TEST_F(RenderStateCacheTests, SceneManagerOption)
+{
+    SceneManager* sceneMgr = mRoot->createSceneManager(ST_GENERIC);
+
+    EXPECT_TRUE(sceneMgr->getRenderStateCaching());
+    EXPECT_EQ(0u, sceneMgr->getRenderStateStatistics().appliedChanges);
+    EXPECT_EQ(0u, sceneMgr->getRenderStateStatistics().redundantChanges);
+    sceneMgr->setRenderStateCaching(false);
+    EXPECT_FALSE(sceneMgr->getRenderStateCaching());
+    sceneMgr->setRenderStateCaching(true);
+    EXPECT_TRUE(sceneMgr->getRenderStateCaching());
+}
@@ -0,0 +1,430 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "OgreRoot.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreResourceManager.h"
+#include "OgreConfigFile.h"
+#include "OgreFileSystemLayer.h"
+#include "OgreScriptLoader.h"
+#include "OgreScriptCompiler.h"
+#include "OgreMaterialManager.h"
+#include "OgreTechnique.h"
+#include "OgrePass.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Resource recording how it was prepared and loaded
+    class DummyResource : public Resource
+    {
+    public:
+        AtomicScalar<uint32> mPrepareCount;
+        bool mLoadedAfterPrepare;
+
+        DummyResource(ResourceManager* creator, const String& name, ResourceHandle handle,
+            const String& group)
+            : Resource(creator, name, handle, group)
+            , mPrepareCount(0)
+            , mLoadedAfterPrepare(false)
+        {
+        }
+
+    protected:
+        void prepareImpl(void)
+        {
+            if (StringUtil::startsWith(mName, "fail", false))
+            {
+                OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS, "Cannot prepare " + mName,
+                    "DummyResource::prepareImpl");
+            }
+            ++mPrepareCount;
+        }
+        void loadImpl(void) { mLoadedAfterPrepare = mPrepareCount.get() == 1; }
+        void unloadImpl(void) {}
+    };
+
+    class DummyResourceManager : public ResourceManager
+    {
+    public:
+        DummyResourceManager()
+        {
+            mResourceType = "DummyResource";
+            mLoadOrder = 100.0f;
+            ResourceGroupManager::getSingleton()._registerResourceManager(mResourceType, this);
+        }
+        ~DummyResourceManager()
+        {
+            ResourceGroupManager::getSingleton()._unregisterResourceManager(mResourceType);
+        }
+
+    protected:
+        Resource* createImpl(const String& name, ResourceHandle handle, const String& group,
+            bool isManual, ManualResourceLoader* loader, const NameValuePairList* createParams)
+        {
+            return OGRE_NEW DummyResource(this, name, handle, group);
+        }
+    };
+
+    /// Counts the events of the group being prepared
+    class CountingListener : public ResourceGroupListener
+    {
+    public:
+        size_t mExpected;
+        size_t mStarted;
+        size_t mEnded;
+
+        CountingListener() : mExpected(0), mStarted(0), mEnded(0) {}
+
+        void resourceGroupPrepareStarted(const String& groupName, size_t resourceCount)
+        {
+            mExpected = resourceCount;
+        }
+        void resourcePrepareStarted(const ResourcePtr& resource) { ++mStarted; }
+        void resourcePrepareEnded(void) { ++mEnded; }
+    };
+}
+
+class ResourceGroupManagerTests : public ::testing::Test
+{
+public:
+    Root* mRoot;
+    DummyResourceManager* mManager;
+
+    void SetUp()
+    {
+        mRoot = OGRE_NEW Root("");
+        DefaultWorkQueue* queue = static_cast<DefaultWorkQueue*>(mRoot->getWorkQueue());
+        queue->setWorkerThreadCount(4);
+        queue->startup();
+        mManager = OGRE_NEW DummyResourceManager();
+
+        ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+        rgm.createResourceGroup("Parallel");
+        for (int i = 0; i < 100; ++i)
+            mManager->createResource("Dummy" + StringConverter::toString(i), "Parallel");
+        rgm.setParallelPrepare(true);
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mManager;
+        OGRE_DELETE mRoot;
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(ResourceGroupManagerTests, PrepareInParallel)
+{
+    ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+    CountingListener listener;
+    rgm.addResourceGroupListener(&listener);
+    rgm.prepareResourceGroup("Parallel");
+    rgm.removeResourceGroupListener(&listener);
+
+    EXPECT_EQ(100u, listener.mExpected);
+    EXPECT_EQ(100u, listener.mStarted);
+    EXPECT_EQ(100u, listener.mEnded);
+
+    ResourceManager::ResourceMapIterator it = mManager->getResourceIterator();
+    while (it.hasMoreElements())
+    {
+        DummyResource* res = static_cast<DummyResource*>(it.getNext().get());
+        EXPECT_EQ(Resource::LOADSTATE_PREPARED, res->getLoadingState());
+        EXPECT_EQ(1u, res->mPrepareCount.get());
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ResourceGroupManagerTests, LoadPreparesInParallel)
+{
+    ResourceGroupManager::getSingleton().loadResourceGroup("Parallel");
+
+    ResourceManager::ResourceMapIterator it = mManager->getResourceIterator();
+    while (it.hasMoreElements())
+    {
+        DummyResource* res = static_cast<DummyResource*>(it.getNext().get());
+        EXPECT_EQ(Resource::LOADSTATE_LOADED, res->getLoadingState());
+        EXPECT_TRUE(res->mLoadedAfterPrepare);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ResourceGroupManagerTests, PrepareFailureIsRethrown)
+{
+    ResourcePtr failing = mManager->createResource("failing", "Parallel");
+    EXPECT_THROW(ResourceGroupManager::getSingleton().prepareResourceGroup("Parallel"), Exception);
+
+    // The group is no longer the current one, so removing takes it out of the group
+    mManager->remove(failing);
+    EXPECT_NO_THROW(ResourceGroupManager::getSingleton().prepareResourceGroup("Parallel"));
+}
+//--------------------------------------------------------------------------
+class ResourceLocationIndexTests : public ::testing::Test
+{
+public:
+    Root* mRoot;
+    String mTestPath;
+
+    void SetUp()
+    {
+        mRoot = OGRE_NEW Root("");
+
+        ConfigFile cf;
+        cf.load(FileSystemLayer(OGRE_VERSION_NAME).getConfigFilePath("resources.cfg"));
+        mTestPath = cf.getSettings("Tests").begin()->second + "/misc/ArchiveTest";
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mRoot;
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(ResourceLocationIndexTests, FindGroupContainingResource)
+{
+    ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+    rgm.addResourceLocation(mTestPath, "FileSystem", "Root");
+    rgm.addResourceLocation(mTestPath + "/level1/materials/scripts", "FileSystem", "Scripts");
+    rgm.addResourceLocation(mTestPath, "FileSystem", "ZRoot");
+
+    EXPECT_EQ(String("Root"), rgm.findGroupContainingResource("rootfile.txt"));
+    EXPECT_EQ(String("Scripts"), rgm.findGroupContainingResource("file.material"));
+    EXPECT_FALSE(rgm.resourceExistsInAnyGroup("missing.txt"));
+
+    // The first group by name wins
+    rgm.removeResourceLocation(mTestPath, "Root");
+    EXPECT_EQ(String("ZRoot"), rgm.findGroupContainingResource("rootfile.txt"));
+    rgm.destroyResourceGroup("ZRoot");
+    EXPECT_FALSE(rgm.resourceExistsInAnyGroup("rootfile.txt"));
+}
+//--------------------------------------------------------------------------
+TEST_F(ResourceLocationIndexTests, PrebuiltIndex)
+{
+    ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+
+    // The prebuilt list is used instead of scanning the location
+    String index = "L\tFileSystem\t0\t" + mTestPath + "\nF\tprebuilt.txt\n";
+    rgm.loadResourceLocationIndex(DataStreamPtr(OGRE_NEW MemoryDataStream(&index[0], index.size())));
+    rgm.addResourceLocation(mTestPath, "FileSystem", "Prebuilt");
+    EXPECT_TRUE(rgm.resourceExists("Prebuilt", "prebuilt.txt"));
+    EXPECT_FALSE(rgm.resourceExists("Prebuilt", "rootfile.txt"));
+
+    // Locations which are not in the index are scanned
+    rgm.addResourceLocation(mTestPath, "FileSystem", "Scanned", true);
+    EXPECT_TRUE(rgm.resourceExists("Scanned", "rootfile.txt"));
+
+    String filename = "ResourceLocationIndexTests.idx";
+    rgm.saveResourceLocationIndex(filename);
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    DataStreamPtr saved(OGRE_NEW FileStreamDataStream(&file, false));
+    String contents = saved->getAsString();
+    saved->close();
+    file.close();
+    std::remove(filename.c_str());
+
+    EXPECT_NE(String::npos, contents.find("L\tFileSystem\t0\t" + mTestPath + "\nF\tprebuilt.txt\n"));
+    EXPECT_NE(String::npos, contents.find("L\tFileSystem\t1\t" + mTestPath + "\n"));
+    EXPECT_NE(String::npos, contents.find("F\trootfile.txt\n"));
+}
+//--------------------------------------------------------------------------
+namespace
+{
+    /// Script loader recording the order scripts were finished in
+    class RecordingScriptLoader : public ScriptLoader
+    {
+    public:
+        class ParsedNumber : public ParsedScript
+        {
+        public:
+            String text;
+        };
+
+        StringVector mPatterns;
+        StringVector mFinished;
+        AtomicScalar<uint32> mPreParsed;
+
+        RecordingScriptLoader() : mPreParsed(0)
+        {
+            mPatterns.push_back("*.recscript");
+            ResourceGroupManager::getSingleton()._registerScriptLoader(this);
+        }
+        ~RecordingScriptLoader()
+        {
+            ResourceGroupManager::getSingleton()._unregisterScriptLoader(this);
+        }
+
+        const StringVector& getScriptPatterns(void) const { return mPatterns; }
+        Real getLoadingOrder(void) const { return 1000.0f; }
+
+        void parseScript(DataStreamPtr& stream, const String& groupName)
+        {
+            mFinished.push_back("serial " + stream->getAsString());
+        }
+
+        ParsedScriptPtr preParseScript(DataStreamPtr& stream, const String& groupName)
+        {
+            String text = stream->getAsString();
+            if (StringUtil::startsWith(text, "fail", false))
+            {
+                OGRE_EXCEPT(Exception::ERR_INVALIDPARAMS, "Cannot parse " + stream->getName(),
+                    "RecordingScriptLoader::preParseScript");
+            }
+            ++mPreParsed;
+            ParsedNumber* parsed = OGRE_NEW ParsedNumber();
+            parsed->text = text;
+            return ParsedScriptPtr(parsed);
+        }
+
+        void finishParseScript(DataStreamPtr& stream, const String& groupName, const ParsedScriptPtr& parsed)
+        {
+            if (!parsed)
+                parseScript(stream, groupName);
+            else
+                mFinished.push_back("parallel " + static_cast<ParsedNumber*>(parsed.get())->text);
+        }
+    };
+
+    /// Counts the script events
+    class ScriptCountingListener : public ResourceGroupListener
+    {
+    public:
+        size_t mStarted;
+        size_t mEnded;
+
+        ScriptCountingListener() : mStarted(0), mEnded(0) {}
+
+        void scriptParseStarted(const String& scriptName, bool& skipThisScript) { ++mStarted; }
+        void scriptParseEnded(const String& scriptName, bool skipped) { ++mEnded; }
+    };
+}
+
+class ParallelScriptParsingTests : public ::testing::Test
+{
+public:
+    Root* mRoot;
+    RecordingScriptLoader* mLoader;
+    String mPath;
+    StringVector mFiles;
+
+    void SetUp()
+    {
+        mRoot = OGRE_NEW Root("");
+        DefaultWorkQueue* queue = static_cast<DefaultWorkQueue*>(mRoot->getWorkQueue());
+        queue->setWorkerThreadCount(4);
+        queue->startup();
+        mLoader = OGRE_NEW RecordingScriptLoader();
+
+        mPath = "ParallelScriptParsingTests";
+        FileSystemLayer::createDirectory(mPath);
+        for (int i = 0; i < 100; ++i)
+        {
+            // Parsing fails for every tenth script
+            String contents = (i % 10 == 3 ? "fail" : "") + StringConverter::toString(i);
+            addFile("Script" + StringConverter::toString(i, 3, '0') + ".recscript", contents);
+        }
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mLoader;
+        OGRE_DELETE mRoot;
+        for (size_t i = 0; i < mFiles.size(); ++i)
+            FileSystemLayer::removeFile(mFiles[i]);
+        FileSystemLayer::removeDirectory(mPath);
+    }
+
+    void addFile(const String& name, const String& contents)
+    {
+        String path = mPath + "/" + name;
+        std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+        file << contents;
+        mFiles.push_back(path);
+    }
+
+    void initialiseGroup(const String& group)
+    {
+        ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+        rgm.addResourceLocation(mPath, "FileSystem", group);
+        rgm.initialiseResourceGroup(group);
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(ParallelScriptParsingTests, SameOrderAsSerial)
+{
+    ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+    EXPECT_FALSE(rgm.getParallelScriptParsing());
+    initialiseGroup("Serial");
+    StringVector serial = mLoader->mFinished;
+    ASSERT_EQ(100u, serial.size());
+    EXPECT_EQ(0u, mLoader->mPreParsed.get());
+
+    mLoader->mFinished.clear();
+    rgm.setParallelScriptParsing(true);
+    ScriptCountingListener listener;
+    rgm.addResourceGroupListener(&listener);
+    initialiseGroup("Parallel");
+    rgm.removeResourceGroupListener(&listener);
+
+    EXPECT_EQ(100u, listener.mStarted);
+    EXPECT_EQ(100u, listener.mEnded);
+    EXPECT_EQ(90u, mLoader->mPreParsed.get());
+    ASSERT_EQ(100u, mLoader->mFinished.size());
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+        // Scripts failing to pre-parse are parsed as usual, from the start
+        String expected = serial[i];
+        if (!StringUtil::startsWith(expected, "serial fail", false))
+            expected.replace(0, 6, "parallel");
+        EXPECT_EQ(expected, mLoader->mFinished[i]);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParallelScriptParsingTests, CompilesMaterials)
+{
+    MaterialManager::getSingleton().initialise();
+    addFile("Base.material", "abstract material Base\n{\n    technique\n    {\n        pass\n        {\n"
+        "            diffuse $colour\n        }\n    }\n}\n");
+    for (int i = 0; i < 20; ++i)
+    {
+        addFile("Material" + StringConverter::toString(i, 2, '0') + ".material",
+            "import Base from \"Base.material\"\nmaterial Material" + StringConverter::toString(i) +
+            " : Base\n{\n    set $colour \"0 0 1 1\"\n}\n");
+    }
+    ResourceGroupManager::getSingleton().setParallelScriptParsing(true);
+    ScriptCompilerManager::getSingleton().setSaveCompiledScriptsToCache(true);
+    initialiseGroup("Materials");
+
+    for (int i = 0; i < 20; ++i)
+    {
+        MaterialPtr mat = MaterialManager::getSingleton().getByName("Material" + StringConverter::toString(i));
+        ASSERT_TRUE(mat);
+        EXPECT_EQ(ColourValue::Blue, mat->getTechnique(0)->getPass(0)->getDiffuse());
+    }
+    EXPECT_TRUE(ScriptCompilerManager::getSingleton().isCompiledScriptCacheDirty());
+}
@@ -43,7 +43,8 @@ void RootWithoutRenderSystemFixture::SetUp()
 
 void RootWithoutRenderSystemFixture::TearDown()
 {
-    delete mHBM;
+    // Scene objects and meshes release their buffers before the buffer manager goes
     delete mRoot;
+    delete mHBM;
     delete mFSLayer;
 }
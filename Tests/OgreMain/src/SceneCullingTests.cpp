@@ -0,0 +1,223 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreCamera.h"
+#include "OgreMovableObject.h"
+#include "OgreOptimisedUtil.h"
+#include "OgreMath.h"
+
+using namespace Ogre;
+
+namespace
+{
+    Vector3 randomVector(Real range)
+    {
+        return Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * range;
+    }
+
+    /// Records the order in which the objects are added to the render queue
+    class RecordingObject : public MovableObject
+    {
+    public:
+        RecordingObject(const String& name, const AxisAlignedBox& box,
+            vector<String>::type& record)
+            : MovableObject(name), mBox(box), mRecord(record) {}
+
+        const String& getMovableType(void) const
+        {
+            static String type = "RecordingObject";
+            return type;
+        }
+        const AxisAlignedBox& getBoundingBox(void) const { return mBox; }
+        Real getBoundingRadius(void) const { return mBox.getHalfSize().length(); }
+        void _updateRenderQueue(RenderQueue*) { mRecord.push_back(mName); }
+        void visitRenderables(Renderable::Visitor*, bool) {}
+
+    private:
+        AxisAlignedBox mBox;
+        vector<String>::type& mRecord;
+    };
+}
+
+class SceneCullingTests : public RootWithoutRenderSystemFixture
+{
+public:
+    SceneManager* mSceneMgr;
+    Camera* mCamera;
+    vector<String>::type mRecord;
+    vector<RecordingObject*>::type mObjects;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+        // Not created through the scene manager, which expects a render system to destroy it
+        mCamera = OGRE_NEW Camera("Camera", mSceneMgr);
+        mCamera->setNearClipDistance(1);
+        mCamera->setFarClipDistance(1000);
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mCamera;
+        RootWithoutRenderSystemFixture::TearDown();
+        for (size_t i = 0; i < mObjects.size(); ++i)
+        {
+            OGRE_DELETE mObjects[i];
+        }
+    }
+
+    /// Builds a random hierarchy of numNodes nodes, most of them with an object
+    void buildScene(size_t numNodes, Real range)
+    {
+        srand(0);
+        vector<SceneNode*>::type nodes;
+        nodes.push_back(mSceneMgr->getRootSceneNode());
+        for (size_t n = 0; n < numNodes; ++n)
+        {
+            // Children near their parent, so that some subtrees are culled as a whole
+            SceneNode* parent = nodes[rand() % nodes.size()];
+            const Vector3 position = parent == nodes[0] ? randomVector(range) :
+                parent->_getFullTransform().getTrans() + randomVector(range * 0.1f);
+            SceneNode* node = parent->createChildSceneNode();
+            node->setPosition(position);
+            // World bounds come from the cached transform, which is not derived from the position
+            node->overrideCachedTransform(Matrix4::getTrans(position));
+            nodes.push_back(node);
+
+            if (n % 5)
+            {
+                const Vector3 halfSize(Math::RangeRandom(0.1f, 2), Math::RangeRandom(0.1f, 2),
+                    Math::RangeRandom(0.1f, 2));
+                RecordingObject* obj = OGRE_NEW RecordingObject(
+                    "Object" + StringConverter::toString(n), AxisAlignedBox(-halfSize, halfSize),
+                    mRecord);
+                mObjects.push_back(obj);
+                node->attachObject(obj);
+            }
+        }
+        mSceneMgr->_updateSceneGraph(0);
+    }
+
+    vector<String>::type findVisibleObjects(bool parallel)
+    {
+        mRecord.clear();
+        mSceneMgr->setParallelCulling(parallel);
+        mSceneMgr->_findVisibleObjects(mCamera, 0, false);
+        mSceneMgr->getRenderQueue()->clear();
+        return mRecord;
+    }
+
+    void expectSameVisibleObjects(size_t numViews, Real range)
+    {
+        srand(1);
+        size_t numVisible = 0;
+        for (size_t v = 0; v < numViews; ++v)
+        {
+            mCamera->setPosition(randomVector(range));
+            mCamera->setDirection(randomVector(1));
+            const vector<String>::type recursive = findVisibleObjects(false);
+            const vector<String>::type parallel = findVisibleObjects(true);
+            EXPECT_EQ(recursive, parallel);
+            numVisible += recursive.size();
+        }
+        // Neither everything nor nothing
+        EXPECT_GT(numVisible, numViews);
+        EXPECT_LT(numVisible, numViews * mObjects.size() / 2);
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(SceneCullingTests, CullBoxesMatchesFrustum)
+{
+    const size_t numBoxes = 1003;
+    const Real infinity = std::numeric_limits<Real>::infinity();
+    const Plane* planes = mCamera->getFrustumPlanes();
+    Vector4 packedPlanes[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        packedPlanes[p] = Vector4(planes[p].normal.x, planes[p].normal.y, planes[p].normal.z,
+            planes[p].d);
+    }
+
+    srand(0);
+    vector<AxisAlignedBox>::type boxes(numBoxes);
+    vector<Vector4>::type centres(numBoxes), halfSizes(numBoxes);
+    vector<char>::type visibilities(numBoxes, 1);
+    for (size_t n = 0; n < numBoxes; ++n)
+    {
+        const Vector3 minimum = randomVector(1200);
+        boxes[n].setExtents(minimum, minimum + Vector3(Math::UnitRandom(), Math::UnitRandom(),
+            Math::UnitRandom()) * 100);
+        if (n % 100 == 7)
+            boxes[n].setInfinite();
+        const Vector3 centre = boxes[n].isInfinite() ? Vector3::ZERO : boxes[n].getCenter();
+        const Vector3 halfSize = boxes[n].isInfinite() ?
+            Vector3(infinity, infinity, infinity) : boxes[n].getHalfSize();
+        centres[n] = Vector4(centre.x, centre.y, centre.z, 0);
+        halfSizes[n] = Vector4(halfSize.x, halfSize.y, halfSize.z, 0);
+    }
+    // Boxes already culled are left alone
+    visibilities[1] = 0;
+
+    OptimisedUtil::getImplementation()->cullBoxes(packedPlanes, 6, &centres[0], &halfSizes[0],
+        &visibilities[0], numBoxes);
+
+    size_t numVisible = 0;
+    for (size_t n = 0; n < numBoxes; ++n)
+    {
+        EXPECT_EQ(n != 1 && mCamera->isVisible(boxes[n]), visibilities[n] != 0) << n;
+        numVisible += visibilities[n] != 0;
+    }
+    EXPECT_GT(numVisible, 10u);
+    EXPECT_LT(numVisible, numBoxes - 10);
+}
+//--------------------------------------------------------------------------
+TEST_F(SceneCullingTests, ParallelMatchesRecursive)
+{
+    buildScene(3000, 300);
+    expectSameVisibleObjects(20, 300);
+
+    // With worker threads, and after changing the scene graph
+    mSceneMgr->setNumWorkerThreads(3);
+    expectSameVisibleObjects(20, 300);
+    SceneNode* node = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+    node->overrideCachedTransform(Matrix4::IDENTITY);
+    RecordingObject* obj = OGRE_NEW RecordingObject("Infinite",
+        AxisAlignedBox(AxisAlignedBox::BOX_INFINITE), mRecord);
+    mObjects.push_back(obj);
+    node->attachObject(obj);
+    mSceneMgr->getRootSceneNode()->getChild(0)->removeAllChildren();
+    mSceneMgr->_updateSceneGraph(0);
+    expectSameVisibleObjects(20, 300);
+    const vector<String>::type visible = findVisibleObjects(true);
+    EXPECT_TRUE(std::find(visible.begin(), visible.end(), "Infinite") != visible.end());
+}
@@ -0,0 +1,165 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreLogManager.h"
+#include "OgreTimer.h"
+#include "OgreMath.h"
+
+using namespace Ogre;
+
+class SceneGraphUpdateTests : public RootWithoutRenderSystemFixture
+{
+public:
+    vector<SceneNode*>::type mNodes[2];
+    SceneManager* mSceneMgr[2];
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        for (int i = 0; i < 2; ++i)
+        {
+            mSceneMgr[i] = mRoot->createSceneManager(ST_GENERIC);
+        }
+        mSceneMgr[1]->setParallelTransformUpdate(true);
+    }
+
+    /// Builds the same random tree of numNodes nodes in both scene managers
+    void buildTrees(size_t numNodes, size_t maxChildren)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            srand(0);
+            mNodes[i].clear();
+            mNodes[i].push_back(mSceneMgr[i]->getRootSceneNode());
+            for (size_t n = 0; mNodes[i].size() < numNodes; ++n)
+            {
+                SceneNode* parent = mNodes[i][n];
+                size_t numChildren = 1 + rand() % maxChildren;
+                for (size_t c = 0; c < numChildren && mNodes[i].size() < numNodes; ++c)
+                {
+                    SceneNode* child = parent->createChildSceneNode(randomPosition());
+                    child->setInheritScale(rand() % 4 != 0);
+                    child->setInheritOrientation(rand() % 4 != 0);
+                    mNodes[i].push_back(child);
+                }
+            }
+        }
+    }
+
+    /// Moves every step'th node, starting at offset, identically in both scene managers
+    void animate(size_t offset, size_t step)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            srand(static_cast<unsigned int>(offset));
+            for (size_t n = offset; n < mNodes[i].size(); n += step)
+            {
+                mNodes[i][n]->setPosition(randomPosition());
+                mNodes[i][n]->setOrientation(Quaternion(Radian(Math::UnitRandom() * Math::TWO_PI),
+                    Vector3(Math::SymmetricRandom(), 1, Math::SymmetricRandom()).normalisedCopy()));
+                mNodes[i][n]->setScale(Vector3::UNIT_SCALE * Math::RangeRandom(0.5, 2));
+            }
+        }
+    }
+
+    void expectTreesEqual()
+    {
+        ASSERT_EQ(mNodes[0].size(), mNodes[1].size());
+        for (size_t n = 0; n < mNodes[0].size(); ++n)
+        {
+            EXPECT_TRUE(mNodes[0][n]->_getDerivedPosition().positionEquals(
+                mNodes[1][n]->_getDerivedPosition()));
+            EXPECT_TRUE(mNodes[0][n]->_getDerivedOrientation().orientationEquals(
+                mNodes[1][n]->_getDerivedOrientation()));
+            EXPECT_TRUE(mNodes[0][n]->_getDerivedScale().positionEquals(
+                mNodes[1][n]->_getDerivedScale()));
+        }
+    }
+
+    static Vector3 randomPosition()
+    {
+        return Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * 10;
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(SceneGraphUpdateTests, ParallelMatchesRecursive)
+{
+    mSceneMgr[1]->setNumWorkerThreads(3);
+    buildTrees(20000, 4);
+
+    for (size_t frame = 0; frame < 4; ++frame)
+    {
+        animate(frame, 7);
+        for (int i = 0; i < 2; ++i)
+        {
+            mSceneMgr[i]->_updateSceneGraph(0);
+        }
+        expectTreesEqual();
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(SceneGraphUpdateTests, NoWorkerThreads)
+{
+    buildTrees(1000, 3);
+    animate(0, 3);
+    for (int i = 0; i < 2; ++i)
+    {
+        mSceneMgr[i]->_updateSceneGraph(0);
+    }
+    expectTreesEqual();
+}
+//--------------------------------------------------------------------------
+TEST_F(SceneGraphUpdateTests, DISABLED_Benchmark)
+{
+    const size_t numFrames = 20;
+    mSceneMgr[1]->setNumWorkerThreads(3);
+    buildTrees(50000, 8);
+
+    unsigned long elapsed[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        Timer timer;
+        for (size_t frame = 0; frame < numFrames; ++frame)
+        {
+            // Every node moves, as with a fully animated scene
+            mNodes[i][0]->needUpdate();
+            mSceneMgr[i]->_updateSceneGraph(0);
+        }
+        elapsed[i] = timer.getMicroseconds();
+    }
+
+    LogManager::getSingleton().stream() << "Scene graph update of " << mNodes[0].size()
+        << " nodes, " << numFrames << " frames: recursive " << elapsed[0] / 1000.0f
+        << " ms, parallel (" << mSceneMgr[1]->getNumWorkerThreads() << " workers) "
+        << elapsed[1] / 1000.0f << " ms";
+    expectTreesEqual();
+}
@@ -0,0 +1,445 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreManualObject.h"
+#include "OgreDynamicAABBTree.h"
+#include "OgreLogManager.h"
+#include "OgreTimer.h"
+#include "OgreMath.h"
+
+using namespace Ogre;
+
+namespace
+{
+    Vector3 randomVector(Real range)
+    {
+        return Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * range;
+    }
+
+    AxisAlignedBox randomBox(Real range, Real maxSize)
+    {
+        const Vector3 minimum = randomVector(range);
+        return AxisAlignedBox(minimum, minimum + Vector3(Math::UnitRandom(), Math::UnitRandom(),
+            Math::UnitRandom()) * maxSize);
+    }
+
+    /// Collects the proxies reported by a DynamicAABBTree query
+    struct ProxyCollector
+    {
+        vector<int>::type proxies;
+        bool operator()(int proxy) { proxies.push_back(proxy); return true; }
+    };
+
+    /// Collects the names of the objects and pairs reported by scene queries
+    struct ResultCollector : public SceneQueryListener, public RaySceneQueryListener,
+        public IntersectionSceneQueryListener
+    {
+        vector<String>::type names;
+        bool queryResult(MovableObject* object)
+        {
+            names.push_back(object->getName());
+            return true;
+        }
+        bool queryResult(MovableObject* object, Real distance)
+        {
+            names.push_back(object->getName() + " " + StringConverter::toString(distance));
+            return true;
+        }
+        bool queryResult(MovableObject* first, MovableObject* second)
+        {
+            // Either order is fine
+            names.push_back(std::min(first->getName(), second->getName()) + " " +
+                std::max(first->getName(), second->getName()));
+            return true;
+        }
+        bool queryResult(SceneQuery::WorldFragment*) { return true; }
+        bool queryResult(SceneQuery::WorldFragment*, Real) { return true; }
+        bool queryResult(MovableObject*, SceneQuery::WorldFragment*) { return true; }
+
+        vector<String>::type sorted(void)
+        {
+            std::sort(names.begin(), names.end());
+            return names;
+        }
+    };
+}
+
+class SceneQueryTests : public RootWithoutRenderSystemFixture
+{
+public:
+    /// Linear queries in the first scene manager, tree queries in the second
+    SceneManager* mSceneMgr[2];
+    vector<SceneNode*>::type mNodes[2];
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        for (int i = 0; i < 2; ++i)
+        {
+            mSceneMgr[i] = mRoot->createSceneManager(ST_GENERIC);
+        }
+    }
+
+    /// Creates the same numObjects objects, with random bounds and query flags, in both scenes
+    void buildScenes(size_t numObjects, Real range)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            srand(0);
+            mNodes[i].clear();
+            for (size_t n = 0; n < numObjects; ++n)
+            {
+                ManualObject* obj = mSceneMgr[i]->createManualObject(
+                    "Object" + StringConverter::toString(n));
+                const Vector3 halfSize(Math::RangeRandom(0.1f, 2), Math::RangeRandom(0.1f, 2),
+                    Math::RangeRandom(0.1f, 2));
+                obj->setBoundingBox(AxisAlignedBox(-halfSize, halfSize));
+                obj->setQueryFlags(1 << (rand() % 4));
+
+                SceneNode* node = mSceneMgr[i]->getRootSceneNode()->createChildSceneNode();
+                placeNode(node, randomVector(range));
+                node->attachObject(obj);
+                mNodes[i].push_back(node);
+            }
+            mSceneMgr[i]->_updateSceneGraph(0);
+        }
+    }
+
+    /// Moves every step'th node identically in both scenes
+    void moveNodes(size_t offset, size_t step, Real range)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            srand(static_cast<unsigned int>(offset));
+            for (size_t n = offset; n < mNodes[i].size(); n += step)
+            {
+                placeNode(mNodes[i][n], randomVector(range));
+            }
+            mSceneMgr[i]->_updateSceneGraph(0);
+        }
+    }
+
+    /// World bounds come from the cached transform, which is not derived from the position
+    static void placeNode(SceneNode* node, const Vector3& position)
+    {
+        node->setPosition(position);
+        node->overrideCachedTransform(Matrix4::getTrans(position));
+    }
+
+    template <typename Query>
+    void expectSameResults(Query* queries[2])
+    {
+        ResultCollector results[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            queries[i]->execute(&results[i]);
+        }
+        EXPECT_EQ(results[0].sorted(), results[1].sorted());
+    }
+
+    void expectSameQueryResults(size_t numQueries, Real range)
+    {
+        srand(1);
+        for (size_t q = 0; q < numQueries; ++q)
+        {
+            const AxisAlignedBox box = randomBox(range, range / 4);
+            const Ray ray(randomVector(range), randomVector(1).normalisedCopy());
+            PlaneBoundedVolume volume(Plane::NEGATIVE_SIDE);
+            volume.planes.push_back(Plane(Vector3::UNIT_X, box.getMinimum()));
+            volume.planes.push_back(Plane(Vector3::NEGATIVE_UNIT_X, box.getMaximum()));
+            volume.planes.push_back(Plane(Vector3(1, 1, 0).normalisedCopy(), box.getCenter()));
+            PlaneBoundedVolumeList volumes;
+            volumes.push_back(volume);
+            volumes.push_back(volume);
+            const uint32 mask = q % 2 ? 0xFFFFFFFF : 0x5;
+
+            AxisAlignedBoxSceneQuery* boxQueries[2];
+            RaySceneQuery* rayQueries[2];
+            PlaneBoundedVolumeListSceneQuery* volumeQueries[2];
+            for (int i = 0; i < 2; ++i)
+            {
+                boxQueries[i] = mSceneMgr[i]->createAABBQuery(box, mask);
+                rayQueries[i] = mSceneMgr[i]->createRayQuery(ray, mask);
+                volumeQueries[i] = mSceneMgr[i]->createPlaneBoundedVolumeQuery(volumes, mask);
+            }
+            expectSameResults(boxQueries);
+            expectSameResults(rayQueries);
+            expectSameResults(volumeQueries);
+            for (int i = 0; i < 2; ++i)
+            {
+                mSceneMgr[i]->destroyQuery(boxQueries[i]);
+                mSceneMgr[i]->destroyQuery(rayQueries[i]);
+                mSceneMgr[i]->destroyQuery(volumeQueries[i]);
+            }
+        }
+
+        IntersectionSceneQuery* intersectionQueries[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            intersectionQueries[i] = mSceneMgr[i]->createIntersectionQuery(0x3);
+        }
+        expectSameResults(intersectionQueries);
+        for (int i = 0; i < 2; ++i)
+        {
+            mSceneMgr[i]->destroyQuery(intersectionQueries[i]);
+        }
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(SceneQueryTests, DynamicAABBTreeMatchesBruteForce)
+{
+    const size_t numBoxes = 2000;
+    DynamicAABBTree tree;
+    vector<AxisAlignedBox>::type boxes(numBoxes);
+    vector<int>::type proxies(numBoxes);
+
+    srand(0);
+    for (size_t n = 0; n < numBoxes; ++n)
+    {
+        boxes[n] = randomBox(100, 5);
+        proxies[n] = tree.createProxy(boxes[n], &boxes[n]);
+    }
+    // Move some, remove some
+    for (size_t n = 0; n < numBoxes; n += 3)
+    {
+        boxes[n] = randomBox(100, 5);
+        tree.moveProxy(proxies[n], boxes[n]);
+    }
+    for (size_t n = 1; n < numBoxes; n += 5)
+    {
+        tree.destroyProxy(proxies[n]);
+        boxes[n].setNull();
+    }
+    EXPECT_EQ(numBoxes - numBoxes / 5, tree.getProxyCount());
+    // Balanced: far from the height of a list
+    EXPECT_LT(tree.getHeight(), 40);
+
+    for (size_t q = 0; q < 100; ++q)
+    {
+        const AxisAlignedBox queryBox = randomBox(100, 20);
+        ProxyCollector collector;
+        tree.query(queryBox, collector);
+        std::set<void*> found;
+        for (size_t i = 0; i < collector.proxies.size(); ++i)
+        {
+            found.insert(tree.getUserData(collector.proxies[i]));
+        }
+        EXPECT_EQ(collector.proxies.size(), found.size());
+        // Every box intersecting the query must be reported
+        for (size_t n = 0; n < numBoxes; ++n)
+        {
+            if (queryBox.intersects(boxes[n]))
+            {
+                EXPECT_TRUE(found.count(&boxes[n]));
+            }
+        }
+
+        const Ray ray(randomVector(100), randomVector(1).normalisedCopy());
+        ProxyCollector rayCollector;
+        tree.raycast(ray, rayCollector);
+        found.clear();
+        for (size_t i = 0; i < rayCollector.proxies.size(); ++i)
+        {
+            found.insert(tree.getUserData(rayCollector.proxies[i]));
+        }
+        for (size_t n = 0; n < numBoxes; ++n)
+        {
+            if (ray.intersects(boxes[n]).first)
+            {
+                EXPECT_TRUE(found.count(&boxes[n]));
+            }
+        }
+    }
+
+    // Infinite boxes are always reported
+    AxisAlignedBox infinite(AxisAlignedBox::BOX_INFINITE);
+    const int infiniteProxy = tree.createProxy(infinite, &infinite);
+    ProxyCollector collector;
+    tree.query(AxisAlignedBox(Vector3(1000, 1000, 1000), Vector3(1001, 1001, 1001)), collector);
+    ASSERT_EQ(1u, collector.proxies.size());
+    EXPECT_EQ(infiniteProxy, collector.proxies[0]);
+
+    tree.clear();
+    EXPECT_EQ(0u, tree.getProxyCount());
+    EXPECT_EQ(-1, tree.getHeight());
+}
+//--------------------------------------------------------------------------
+TEST_F(SceneQueryTests, DynamicAABBTreePointMargin)
+{
+    DynamicAABBTree tree(0.1f, 0.5f);
+    const Vector3 point(10, 20, 30);
+    const int proxy = tree.createProxy(AxisAlignedBox(point, point), 0);
+
+    // A point object keeps its place in the tree for small moves
+    const Vector3 moved = point + Vector3(0.25f, -0.25f, 0.25f);
+    EXPECT_FALSE(tree.moveProxy(proxy, AxisAlignedBox(moved, moved)));
+    ProxyCollector collector;
+    tree.query(AxisAlignedBox(moved, moved), collector);
+    EXPECT_EQ(1u, collector.proxies.size());
+
+    const Vector3 far = point + Vector3(1, 0, 0);
+    EXPECT_TRUE(tree.moveProxy(proxy, AxisAlignedBox(far, far)));
+}
+//--------------------------------------------------------------------------
+TEST_F(SceneQueryTests, AcceleratedMatchesLinear)
+{
+    buildScenes(3000, 100);
+    mSceneMgr[1]->setSceneQueryAcceleration(true);
+    expectSameQueryResults(50, 100);
+
+    moveNodes(0, 3, 100);
+    expectSameQueryResults(50, 100);
+
+    // Detached and destroyed objects must leave the tree
+    for (int i = 0; i < 2; ++i)
+    {
+        for (size_t n = 1; n < mNodes[i].size(); n += 7)
+        {
+            mNodes[i][n]->detachAllObjects();
+        }
+        for (size_t n = 2; n < mNodes[i].size(); n += 7)
+        {
+            mSceneMgr[i]->destroyManualObject("Object" + StringConverter::toString(n));
+        }
+        // Out of the scene graph, still in the tree but filtered
+        mSceneMgr[i]->getRootSceneNode()->removeChild(mNodes[i][3]);
+        mSceneMgr[i]->_updateSceneGraph(0);
+    }
+    expectSameQueryResults(50, 100);
+
+    mSceneMgr[1]->setSceneQueryAcceleration(false);
+    EXPECT_EQ(static_cast<const DynamicAABBTree*>(0), mSceneMgr[1]->_getQueryTree());
+    expectSameQueryResults(10, 100);
+}
+//--------------------------------------------------------------------------
+TEST_F(SceneQueryTests, DISABLED_Benchmark)
+{
+    const size_t sizes[] = { 10000, 100000, 1000000 };
+    const size_t numQueries = 1000;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        // Objects spread with a constant density
+        const size_t numBoxes = sizes[s];
+        const Real range = 10 * Math::Pow(static_cast<Real>(numBoxes), 1.0f / 3);
+        vector<AxisAlignedBox>::type boxes(numBoxes);
+        vector<int>::type proxies(numBoxes);
+        srand(0);
+        for (size_t n = 0; n < numBoxes; ++n)
+        {
+            boxes[n] = randomBox(range, 2);
+        }
+
+        Timer timer;
+        DynamicAABBTree tree;
+        for (size_t n = 0; n < numBoxes; ++n)
+        {
+            proxies[n] = tree.createProxy(boxes[n], &boxes[n]);
+        }
+        const unsigned long buildTime = timer.getMicroseconds();
+
+        // A tenth of the objects move a little each frame
+        timer.reset();
+        for (size_t n = 0; n < numBoxes; n += 10)
+        {
+            const Vector3 offset = randomVector(0.5f);
+            boxes[n].setExtents(boxes[n].getMinimum() + offset, boxes[n].getMaximum() + offset);
+            tree.moveProxy(proxies[n], boxes[n]);
+        }
+        const unsigned long moveTime = timer.getMicroseconds();
+
+        vector<AxisAlignedBox>::type queryBoxes(numQueries);
+        vector<Ray>::type rays(numQueries);
+        for (size_t q = 0; q < numQueries; ++q)
+        {
+            queryBoxes[q] = randomBox(range, 10);
+            rays[q] = Ray(randomVector(range), randomVector(1).normalisedCopy());
+        }
+
+        size_t treeHits = 0;
+        timer.reset();
+        for (size_t q = 0; q < numQueries; ++q)
+        {
+            ProxyCollector collector;
+            tree.query(queryBoxes[q], collector);
+            tree.raycast(rays[q], collector);
+            treeHits += collector.proxies.size();
+        }
+        const unsigned long treeTime = timer.getMicroseconds();
+
+        // Brute force on a tenth of the queries, it is slow
+        size_t linearHits = 0;
+        timer.reset();
+        for (size_t q = 0; q < numQueries; q += 10)
+        {
+            for (size_t n = 0; n < numBoxes; ++n)
+            {
+                if (queryBoxes[q].intersects(boxes[n]))
+                    ++linearHits;
+                if (rays[q].intersects(boxes[n]).first)
+                    ++linearHits;
+            }
+        }
+        const unsigned long linearTime = timer.getMicroseconds() * 10;
+
+        LogManager::getSingleton().stream() << "DynamicAABBTree with " << numBoxes
+            << " boxes: build " << buildTime / 1000.0f << " ms, moving " << numBoxes / 10
+            << " boxes " << moveTime / 1000.0f << " ms, height " << tree.getHeight()
+            << ", " << numQueries << " box+ray queries " << treeTime / 1000.0f
+            << " ms (" << treeHits << " candidates), brute force " << linearTime / 1000.0f << " ms";
+        EXPECT_GE(treeHits, linearHits);
+    }
+
+    // Whole scene queries through the SceneManager
+    buildScenes(10000, 200);
+    mSceneMgr[1]->setSceneQueryAcceleration(true);
+    unsigned long elapsed[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        srand(1);
+        RaySceneQuery* rayQuery = mSceneMgr[i]->createRayQuery(Ray());
+        IntersectionSceneQuery* intersectionQuery = mSceneMgr[i]->createIntersectionQuery();
+        ResultCollector results;
+        Timer timer;
+        for (size_t q = 0; q < 100; ++q)
+        {
+            rayQuery->setRay(Ray(randomVector(200), randomVector(1).normalisedCopy()));
+            rayQuery->execute(&results);
+        }
+        intersectionQuery->execute(&results);
+        elapsed[i] = timer.getMicroseconds();
+        mSceneMgr[i]->destroyQuery(rayQuery);
+        mSceneMgr[i]->destroyQuery(intersectionQuery);
+    }
+    LogManager::getSingleton().stream() << "Scene with " << mNodes[0].size()
+        << " objects, 100 ray queries and 1 intersection query: linear "
+        << elapsed[0] / 1000.0f << " ms, accelerated " << elapsed[1] / 1000.0f << " ms";
+}
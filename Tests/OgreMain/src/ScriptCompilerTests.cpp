@@ -0,0 +1,608 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreScriptCompiler.h"
+#include "OgreScriptLexer.h"
+#include "OgreScriptParser.h"
+#include "OgreScriptTranslator.h"
+#include "OgreMaterialManager.h"
+#include "OgreTechnique.h"
+#include "OgrePass.h"
+#include "OgreDataStream.h"
+#include "OgreLogManager.h"
+#include "OgreTimer.h"
+#include "OgreFileSystem.h"
+#include "OgreConfigFile.h"
+#include "OgreFileSystemLayer.h"
+#include <fstream>
+
+using namespace Ogre;
+
+namespace
+{
+    /// Counts the test_object nodes it translates, reporting an error for each on demand
+    class CountingTranslator : public ScriptTranslator
+    {
+    public:
+        CountingTranslator() : mFail(false), mCount(0) {}
+
+        void translate(ScriptCompiler *compiler, const AbstractNodePtr &node)
+        {
+            ++mCount;
+            if (mFail)
+                compiler->addError(ScriptCompiler::CE_INVALIDPARAMETERS, node->file, node->line);
+        }
+
+        bool mFail;
+        size_t mCount;
+    };
+
+    class CountingTranslatorManager : public ScriptTranslatorManager
+    {
+    public:
+        CountingTranslator mTranslator;
+
+        size_t getNumTranslators() const { return 1; }
+
+        ScriptTranslator *getTranslator(const AbstractNodePtr &node)
+        {
+            if (node->type == ANT_OBJECT && static_cast<ObjectAbstractNode*>(node.get())->cls == "test_object")
+                return &mTranslator;
+            return 0;
+        }
+    };
+}
+
+class ScriptCompilerTests : public RootWithoutRenderSystemFixture
+{
+public:
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+    }
+
+    void TearDown()
+    {
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    static void parseScript(const String& name, const String& script)
+    {
+        DataStreamPtr stream(OGRE_NEW MemoryDataStream(name, const_cast<char*>(script.c_str()), script.size()));
+        ScriptCompilerManager::getSingleton().parseScript(stream, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    }
+
+    /// Materials inheriting from an abstract one, with variables to expand
+    static String buildScript(size_t first, size_t count, const String& diffuse)
+    {
+        StringStream script;
+        script << "abstract material Base" << first << "\n{\n"
+            << "    technique\n    {\n        pass\n        {\n"
+            << "            ambient 0.5 0.5 0.5\n            diffuse $diffuse\n"
+            << "            depth_bias $bias\n        }\n    }\n}\n";
+        for (size_t i = first; i < first + count; ++i)
+        {
+            script << "material Material" << i << " : Base" << first << "\n{\n"
+                << "    set $diffuse \"" << diffuse << "\"\n    set $bias \"" << i % 16 << "\"\n"
+                << "    technique\n    {\n        pass\n        {\n"
+                << "            lighting " << (i % 2 ? "on" : "off") << "\n        }\n    }\n}\n";
+        }
+        return script.str();
+    }
+
+    static Pass* getPass(const String& material)
+    {
+        MaterialPtr mat = MaterialManager::getSingleton().getByName(material);
+        if (!mat)
+            return 0;
+        return mat->getTechnique(0)->getPass(0);
+    }
+
+    /// The scripts of the sample media, with their names
+    void loadSampleScripts(StringVector& names, StringVector& scripts)
+    {
+        ConfigFile cf;
+        cf.load(mFSLayer->getConfigFilePath("resources.cfg"));
+        FileSystemArchive arch(cf.getSettings("Tests").begin()->second + "/../../Samples/Media", "FileSystem", true);
+        arch.load();
+
+        const char* patterns[] = { "*.material", "*.program", "*.compositor", "*.particle" };
+        for (size_t p = 0; p < 4; ++p)
+        {
+            StringVectorPtr files = arch.find(patterns[p], true);
+            for (StringVector::const_iterator i = files->begin(); i != files->end(); ++i)
+            {
+                names.push_back(*i);
+                scripts.push_back(arch.open(*i)->getAsString());
+            }
+        }
+    }
+
+    /// Scripts of each kind the compiler handles, with their names
+    static void getSampleScripts(StringVector& names, StringVector& scripts)
+    {
+        names.push_back("Sample.program");
+        scripts.push_back(
+            "vertex_program Sample/VP glsl\n{\n    source Sample.vert\n"
+            "    default_params\n    {\n        param_named_auto worldViewProj worldviewproj_matrix\n"
+            "        param_named_auto lightPosition light_position_object_space 0\n"
+            "        param_named scale float4 1 1 1 1\n    }\n}\n"
+            "fragment_program Sample/FP glsl\n{\n    source Sample.frag\n"
+            "    default_params { param_named diffuseMap int 0 }\n}\n"
+            "fragment_program Sample/FP/Unified unified\n{\n    delegate Sample/FP\n}\n");
+        names.push_back("Sample.material");
+        scripts.push_back(
+            "import * from \"Sample.program\"\n"
+            "// A shaded material with a fallback\n"
+            "material Sample/Shaded\n{\n    receive_shadows off\n"
+            "    technique\n    {\n        pass Ambient\n        {\n"
+            "            ambient 0.2 0.2 0.2\n            diffuse vertexcolour\n"
+            "            vertex_program_ref Sample/VP\n            {\n"
+            "                param_named scale float4 2 2 2 1\n            }\n"
+            "            fragment_program_ref Sample/FP/Unified\n            {\n            }\n"
+            "            texture_unit Diffuse\n            {\n"
+            "                texture \"Sample Diffuse.png\" 2d\n"
+            "                tex_address_mode clamp\n                filtering trilinear\n"
+            "                scroll_anim 0.1 0\n            }\n        }\n"
+            "        pass Lights\n        {\n            iteration once_per_light point\n"
+            "            scene_blend add\n            depth_write off\n        }\n    }\n"
+            "    /* Used without shaders */\n"
+            "    technique\n    {\n        pass\n        {\n"
+            "            lighting off\n            texture_unit\n            {\n"
+            "                cubic_texture Sample.jpg separateUV\n"
+            "                env_map cubic_reflection\n            }\n        }\n    }\n}\n");
+        names.push_back("Sample.compositor");
+        scripts.push_back(
+            "compositor Sample/Bloom\n{\n    technique\n    {\n"
+            "        texture rt0 target_width_scaled 0.25 target_height_scaled 0.25 PF_A8R8G8B8\n"
+            "        texture rt1 target_width target_height PF_A8R8G8B8\n"
+            "        target rt1 { input previous }\n"
+            "        target rt0\n        {\n            input none\n"
+            "            pass render_quad\n            {\n                material Sample/Shaded\n"
+            "                input 0 rt1\n            }\n        }\n"
+            "        target_output\n        {\n            input none\n"
+            "            pass clear { buffers colour depth }\n"
+            "            pass render_scene { first_render_queue 0 last_render_queue 50 }\n"
+            "        }\n    }\n}\n");
+        names.push_back("Sample.particle");
+        scripts.push_back(
+            "particle_system Sample/Smoke\n{\n    material Sample/Shaded\n"
+            "    particle_width 35\n    particle_height 35\n    quota 500\n"
+            "    billboard_type point\n    sorted true\n"
+            "    emitter Point\n    {\n        angle 11\n        emission_rate 15\n"
+            "        time_to_live 4\n        direction 0 1 0\n"
+            "        velocity_min 150\n        velocity_max 240\n    }\n"
+            "    affector ColourImage\n    {\n        image smokecolors.png\n    }\n"
+            "    affector Rotator\n    {\n        rotation_range_start 0\n"
+            "        rotation_range_end 360\n    }\n"
+            "    affector Scaler\n    {\n        rate 50\n    }\n}\n");
+    }
+
+    static void expectSameTree(const ConcreteNodeList& nodes, const ScriptNodeView* views, const ScriptNodeView* parent)
+    {
+        const ScriptNodeView* view = views;
+        for (ConcreteNodeList::const_iterator i = nodes.begin(); i != nodes.end(); ++i, view = view->next)
+        {
+            ASSERT_TRUE(view);
+            EXPECT_EQ((*i)->token, String(view->token, view->length));
+            EXPECT_EQ((*i)->file, *view->file);
+            EXPECT_EQ((*i)->line, view->line);
+            EXPECT_EQ((*i)->type, view->type);
+            EXPECT_EQ(parent, view->parent);
+            EXPECT_EQ((*i)->children.size(), view->numChildren);
+            expectSameTree((*i)->children, view->firstChild, view);
+        }
+        EXPECT_FALSE(view);
+    }
+
+    /// Checks the tokens and the tree of the arena parser against the ones of the original
+    static void expectSameParse(const String& name, const String& script)
+    {
+        SCOPED_TRACE(name);
+        ScriptArena arena(256);
+        ScriptTokenViewList views;
+        ScriptTokenListPtr tokens;
+        try
+        {
+            tokens = ScriptLexer::tokenize(script, name);
+        }
+        catch (Exception&)
+        {
+            EXPECT_THROW(ScriptLexer::tokenize(script, arena, views), Exception);
+            return;
+        }
+        ScriptLexer::tokenize(script, arena, views);
+
+        ASSERT_EQ(tokens->size(), views.size());
+        for (size_t i = 0; i < views.size(); ++i)
+        {
+            EXPECT_EQ((*tokens)[i]->lexeme, String(views[i].lexeme, views[i].length));
+            EXPECT_EQ((*tokens)[i]->type, views[i].type);
+            EXPECT_EQ((*tokens)[i]->line, views[i].line);
+        }
+
+        ConcreteNodeListPtr nodes;
+        try
+        {
+            nodes = ScriptParser::parse(tokens);
+        }
+        catch (Exception&)
+        {
+            EXPECT_THROW(ScriptParser::parse(views, name, arena), Exception);
+            return;
+        }
+        expectSameTree(*nodes, ScriptParser::parse(views, name, arena), 0);
+    }
+
+    static void removeMaterials(size_t first, size_t count)
+    {
+        for (size_t i = first; i < first + count; ++i)
+            MaterialManager::getSingleton().remove("Material" + StringConverter::toString(i),
+                ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+        // Done when rendering otherwise, the removed passes would pile up
+        Pass::processPendingPassUpdates();
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, CachedScriptMatchesSource)
+{
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    EXPECT_FALSE(compilers.getSaveCompiledScriptsToCache());
+    compilers.setSaveCompiledScriptsToCache(true);
+
+    String script = buildScript(0, 4, "1 0 0 1");
+    parseScript("Cached.material", script);
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+
+    // Write the cache and read it back, as on the next run
+    DataStreamPtr cache(OGRE_NEW MemoryDataStream(1 << 16, true));
+    compilers.saveCompiledScriptCache(cache);
+    cache->seek(0);
+    compilers.loadCompiledScriptCache(cache);
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+
+    removeMaterials(0, 4);
+    parseScript("Cached.material", script);
+    // Translated from the cache, so nothing new was added to it
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+
+    EXPECT_FALSE(MaterialManager::getSingleton().getByName("Base0"));
+    for (size_t i = 0; i < 4; ++i)
+    {
+        Pass* pass = getPass("Material" + StringConverter::toString(i));
+        ASSERT_TRUE(pass);
+        EXPECT_EQ(ColourValue(0.5, 0.5, 0.5), pass->getAmbient());
+        EXPECT_EQ(ColourValue::Red, pass->getDiffuse());
+        EXPECT_EQ(Real(i % 16), pass->getDepthBiasConstant());
+        EXPECT_EQ(i % 2 != 0, pass->getLightingEnabled());
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, ChangedScriptRecompiles)
+{
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    compilers.setSaveCompiledScriptsToCache(true);
+    parseScript("Changed.material", buildScript(0, 2, "1 0 0 1"));
+
+    DataStreamPtr cache(OGRE_NEW MemoryDataStream(1 << 16, true));
+    compilers.saveCompiledScriptCache(cache);
+    cache->seek(0);
+    compilers.loadCompiledScriptCache(cache);
+
+    removeMaterials(0, 2);
+    parseScript("Changed.material", buildScript(0, 2, "0 1 0 1"));
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+    EXPECT_EQ(ColourValue::Green, getPass("Material1")->getDiffuse());
+
+    // The cache holds the changed script now
+    removeMaterials(0, 2);
+    cache->seek(0);
+    compilers.saveCompiledScriptCache(cache);
+    cache->seek(0);
+    compilers.loadCompiledScriptCache(cache);
+    parseScript("Changed.material", buildScript(0, 2, "0 1 0 1"));
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+    EXPECT_EQ(ColourValue::Green, getPass("Material1")->getDiffuse());
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, CacheOnlyUsedWhenEnabledOrLoaded)
+{
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    parseScript("Uncached.material", buildScript(0, 2, "1 0 0 1"));
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+
+    // Scripts with errors are not cached
+    compilers.setSaveCompiledScriptsToCache(true);
+    parseScript("Broken.material", "material Broken : Missing\n{\n}\n");
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+
+    // A cache from another version of the format is ignored
+    uint32 version = 0xFFFFFFFF;
+    DataStreamPtr cache(OGRE_NEW MemoryDataStream(&version, sizeof(uint32)));
+    compilers.loadCompiledScriptCache(cache);
+    removeMaterials(0, 2);
+    parseScript("Uncached.material", buildScript(0, 2, "1 0 0 1"));
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, DamagedCacheIgnored)
+{
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    compilers.setSaveCompiledScriptsToCache(true);
+    parseScript("Damaged.material", buildScript(0, 2, "1 0 0 1"));
+
+    DataStreamPtr cache(OGRE_NEW MemoryDataStream(1 << 16, true));
+    compilers.saveCompiledScriptCache(cache);
+    size_t size = cache->tell();
+
+    // Cut off in the middle of the binary tree, whose length is then past the end
+    MemoryDataStream* truncated = OGRE_NEW MemoryDataStream(size - 8, true);
+    memcpy(truncated->getPtr(), static_cast<MemoryDataStream*>(cache.get())->getPtr(), size - 8);
+    compilers.loadCompiledScriptCache(DataStreamPtr(truncated));
+    removeMaterials(0, 2);
+    parseScript("Damaged.material", buildScript(0, 2, "1 0 0 1"));
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+    EXPECT_EQ(ColourValue::Red, getPass("Material1")->getDiffuse());
+
+    // Claiming more scripts than there are, the count follows the version
+    cache->seek(0);
+    compilers.saveCompiledScriptCache(cache);
+    size = cache->tell();
+    MemoryDataStream* extra = OGRE_NEW MemoryDataStream(size, true);
+    memcpy(extra->getPtr(), static_cast<MemoryDataStream*>(cache.get())->getPtr(), size);
+    reinterpret_cast<uint32*>(extra->getPtr())[1] += 1;
+    compilers.loadCompiledScriptCache(DataStreamPtr(extra));
+    removeMaterials(0, 2);
+    parseScript("Damaged.material", buildScript(0, 2, "1 0 0 1"));
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, CachedScriptErrorsNotRepeated)
+{
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    CountingTranslatorManager translators;
+    compilers.addTranslatorManager(&translators);
+    compilers.registerCustomWordId("test_object");
+    compilers.setSaveCompiledScriptsToCache(true);
+
+    String script = "test_object First\n{\n}\ntest_object Second\n{\n}\n";
+    parseScript("Counted.test", script);
+    EXPECT_EQ(2u, translators.mTranslator.mCount);
+
+    DataStreamPtr cache(OGRE_NEW MemoryDataStream(1 << 16, true));
+    compilers.saveCompiledScriptCache(cache);
+    cache->seek(0);
+    compilers.loadCompiledScriptCache(cache);
+
+    // Not compiled from source again once translated, but dropped from the cache
+    translators.mTranslator.mFail = true;
+    parseScript("Counted.test", script);
+    EXPECT_EQ(4u, translators.mTranslator.mCount);
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+
+    cache->seek(0);
+    compilers.saveCompiledScriptCache(cache);
+    cache->seek(0);
+    compilers.loadCompiledScriptCache(cache);
+    translators.mTranslator.mFail = false;
+    parseScript("Counted.test", script);
+    EXPECT_EQ(6u, translators.mTranslator.mCount);
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+
+    compilers.removeTranslatorManager(&translators);
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, MissingImportShowingUpRecompiles)
+{
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    compilers.setSaveCompiledScriptsToCache(true);
+    String script = "import * from \"Imported.material\"\n" + buildScript(0, 2, "1 0 0 1");
+    parseScript("Importing.material", script);
+
+    DataStreamPtr cache(OGRE_NEW MemoryDataStream(1 << 16, true));
+    compilers.saveCompiledScriptCache(cache);
+    cache->seek(0);
+    compilers.loadCompiledScriptCache(cache);
+
+    // Still missing, so the cached script is current
+    removeMaterials(0, 2);
+    parseScript("Importing.material", script);
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+
+    String dir = "ScriptCompilerTests";
+    String path = dir + "/Imported.material";
+    FileSystemLayer::createDirectory(dir);
+    {
+        std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+        file << "material Imported\n{\n}\n";
+    }
+    ResourceGroupManager& rgm = ResourceGroupManager::getSingleton();
+    rgm.addResourceLocation(dir, "FileSystem", ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    removeMaterials(0, 2);
+    parseScript("Importing.material", script);
+    EXPECT_TRUE(compilers.isCompiledScriptCacheDirty());
+
+    rgm.removeResourceLocation(dir, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    FileSystemLayer::removeFile(path);
+    FileSystemLayer::removeDirectory(dir);
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, DISABLED_Benchmark)
+{
+    const size_t numScripts = 200;
+    const size_t materialsPerScript = 50;
+    StringVector scripts;
+    for (size_t i = 0; i < numScripts; ++i)
+        scripts.push_back(buildScript(i * materialsPerScript, materialsPerScript, "1 0 0 1"));
+
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    unsigned long times[4];
+    Timer timer;
+    for (int run = 0; run < 4; ++run)
+    {
+        // A warm up run and one from source, then one filling the cache and one translating from it
+        compilers.setSaveCompiledScriptsToCache(run > 1);
+        if (run == 3)
+        {
+            DataStreamPtr cache(OGRE_NEW MemoryDataStream(64 << 20, true));
+            compilers.saveCompiledScriptCache(cache);
+            cache->seek(0);
+            compilers.loadCompiledScriptCache(cache);
+        }
+
+        timer.reset();
+        for (size_t i = 0; i < numScripts; ++i)
+            parseScript("Benchmark" + StringConverter::toString(i) + ".material", scripts[i]);
+        times[run] = timer.getMicroseconds();
+
+        removeMaterials(0, numScripts * materialsPerScript);
+    }
+    EXPECT_FALSE(compilers.isCompiledScriptCacheDirty());
+
+    LogManager::getSingleton().stream() << "Compiling " << numScripts * materialsPerScript
+        << " materials: from source " << times[1] << " us, filling the cache " << times[2]
+        << " us, from the cache " << times[3] << " us";
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, ArenaParsingMatchesConcreteTree)
+{
+    expectSameParse("Generated.material", buildScript(0, 4, "1 0 0 1"));
+    expectSameParse("Escapes.material",
+        "import * from \"Some File.material\"\r\n"
+        "// comment {\n/* multi\nline */material \"Quoted \\\"name\\\"\" : Base \"Other Base\"\n"
+        "{\n\n  set $v \"a\\b\\\\c\"\n  technique{pass{ lighting off }}\n  /value\n}\n$trailing");
+    expectSameParse("Unterminated.material", "material A\n{\n  texture \"open\n}\n");
+
+    StringVector names, scripts;
+    getSampleScripts(names, scripts);
+    size_t numInline = scripts.size();
+    loadSampleScripts(names, scripts);
+    EXPECT_GT(scripts.size(), numInline);
+    for (size_t i = 0; i < scripts.size(); ++i)
+        expectSameParse(names[i], scripts[i]);
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, ArenaParsingCompilesSameTree)
+{
+    String script = buildScript(0, 4, "1 0 0 1");
+    ScriptCompiler compiler;
+    String binaries[2];
+    for (int arena = 0; arena < 2; ++arena)
+    {
+        compiler.setArenaParsing(arena != 0);
+        ScriptCompiler::SourceHashList imports;
+        EXPECT_TRUE(compiler._compileToBinary(script, "Arena.material",
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, binaries[arena], imports));
+        for (size_t i = 0; i < 4; ++i)
+        {
+            Pass* pass = getPass("Material" + StringConverter::toString(i));
+            ASSERT_TRUE(pass);
+            EXPECT_EQ(ColourValue::Red, pass->getDiffuse());
+            EXPECT_EQ(Real(i % 16), pass->getDepthBiasConstant());
+        }
+        removeMaterials(0, 4);
+    }
+    EXPECT_EQ(binaries[0], binaries[1]);
+
+    // And through the manager, parsing up front as when parsing a resource group in parallel
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    EXPECT_FALSE(compilers.getArenaScriptParsing());
+    compilers.setArenaScriptParsing(true);
+    DataStreamPtr stream(OGRE_NEW MemoryDataStream("Arena.material", const_cast<char*>(script.c_str()), script.size()));
+    ScriptLoader::ParsedScriptPtr parsed = compilers.preParseScript(stream, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    ASSERT_TRUE(parsed);
+    compilers.finishParseScript(stream, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, parsed);
+    EXPECT_EQ(ColourValue::Red, getPass("Material3")->getDiffuse());
+    EXPECT_TRUE(getPass("Material3")->getLightingEnabled());
+}
+//--------------------------------------------------------------------------
+TEST_F(ScriptCompilerTests, DISABLED_BenchmarkArenaParsing)
+{
+    StringVector names, scripts;
+    loadSampleScripts(names, scripts);
+    size_t size = 0;
+    for (size_t i = 0; i < scripts.size(); ++i)
+        size += scripts[i].size();
+
+    const int repeats = 20;
+    unsigned long times[2];
+    ScriptArena arena;
+    ScriptTokenViewList views;
+    Timer timer;
+    for (int run = 0; run < 3; ++run)
+    {
+        // A warm up run, then the original lexer and parser, then the arena ones
+        timer.reset();
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (size_t i = 0; i < scripts.size(); ++i)
+            {
+                if (run < 2)
+                {
+                    ScriptParser::parse(ScriptLexer::tokenize(scripts[i], names[i]));
+                }
+                else
+                {
+                    arena.clear();
+                    ScriptLexer::tokenize(scripts[i], arena, views);
+                    ScriptParser::parse(views, names[i], arena);
+                }
+            }
+        }
+        if (run > 0)
+            times[run - 1] = timer.getMicroseconds();
+    }
+
+    // The whole compilation, translation included
+    const size_t numScripts = 100;
+    const size_t materialsPerScript = 50;
+    StringVector generated;
+    for (size_t i = 0; i < numScripts; ++i)
+        generated.push_back(buildScript(i * materialsPerScript, materialsPerScript, "1 0 0 1"));
+
+    ScriptCompilerManager& compilers = ScriptCompilerManager::getSingleton();
+    unsigned long compileTimes[3];
+    for (int run = 0; run < 3; ++run)
+    {
+        compilers.setArenaScriptParsing(run == 2);
+        timer.reset();
+        for (size_t i = 0; i < numScripts; ++i)
+            parseScript("Benchmark" + StringConverter::toString(i) + ".material", generated[i]);
+        compileTimes[run] = timer.getMicroseconds();
+        removeMaterials(0, numScripts * materialsPerScript);
+    }
+
+    LogManager::getSingleton().stream() << "Lexing and parsing " << scripts.size() << " sample scripts ("
+        << size << " bytes) " << repeats << " times: " << times[0] << " us, with an arena " << times[1]
+        << " us; compiling " << numScripts * materialsPerScript << " materials: " << compileTimes[1]
+        << " us, with an arena " << compileTimes[2] << " us";
+}
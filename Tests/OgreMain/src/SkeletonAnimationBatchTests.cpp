@@ -0,0 +1,338 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneManagerEnumerator.h"
+#include "OgreSceneNode.h"
+#include "OgreEntity.h"
+#include "OgreSubEntity.h"
+#include "OgreManualObject.h"
+#include "OgreMesh.h"
+#include "OgreSkeletonManager.h"
+#include "OgreSkeletonInstance.h"
+#include "OgreBone.h"
+#include "OgreAnimation.h"
+#include "OgreKeyFrame.h"
+#include "OgreSkeletonAnimationBatch.h"
+#include "OgreMath.h"
+#include "OgreFrameListener.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Exposes the layouts kept from frame to frame
+    class TestBatch : public SkeletonAnimationBatch
+    {
+    public:
+        size_t getNumLayouts(void) const { return mLayouts.size(); }
+        const void* getLayoutData(size_t i) const { return mLayouts[i].mData; }
+    };
+
+    /// Exposes the entities picked for the batch
+    class TestSceneManager : public DefaultSceneManager
+    {
+    public:
+        TestSceneManager() : DefaultSceneManager("SkeletonAnimationBatchTest") {}
+
+        const vector<Entity*>::type& collectSkeletalAnimations(void)
+        {
+            updateSkeletalAnimations();
+            return mAnimatedEntities;
+        }
+    };
+}
+
+class SkeletonAnimationBatchTests : public RootWithoutRenderSystemFixture
+{
+public:
+    SceneManager* mSceneMgr;
+    MeshPtr mMesh;
+    vector<Entity*>::type mEntities;
+
+    static const unsigned short NUM_BONES = 37;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+
+        srand(0);
+        SkeletonPtr skel = SkeletonManager::getSingleton().create("BatchTest.skeleton",
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, true);
+        buildSkeleton(skel.get());
+
+        ManualObject* manual = mSceneMgr->createManualObject();
+        manual->begin("BaseWhite", RenderOperation::OT_TRIANGLE_LIST);
+        manual->position(0, 0, 0);
+        manual->position(1, 0, 0);
+        manual->position(0, 1, 0);
+        manual->end();
+        mMesh = manual->convertToMesh("BatchTest.mesh");
+        mMesh->_notifySkeleton(skel);
+    }
+
+    void TearDown()
+    {
+        mMesh.reset();
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+
+    static Vector3 randomVector(Real range)
+    {
+        return Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * range;
+    }
+
+    static Quaternion randomOrientation()
+    {
+        return Quaternion(Radian(Math::UnitRandom() * Math::TWO_PI), randomVector(1).normalisedCopy());
+    }
+
+    /// Random bone tree with a few roots, and animations of some of its bones
+    static void buildSkeleton(Skeleton* skel)
+    {
+        for (unsigned short h = 0; h < NUM_BONES; ++h)
+        {
+            Bone* bone;
+            if (h < 3)
+                bone = skel->createBone(h);
+            else
+                bone = skel->getBone(static_cast<unsigned short>(rand() % h))->createChild(h);
+            bone->setPosition(randomVector(5));
+            bone->setOrientation(randomOrientation());
+            bone->setScale(Vector3(Math::RangeRandom(0.5, 2), Math::RangeRandom(0.5, 2), Math::RangeRandom(0.5, 2)));
+            bone->setInheritOrientation(rand() % 5 != 0);
+            bone->setInheritScale(rand() % 5 != 0);
+        }
+        skel->setBindingPose();
+
+        const char* names[] = { "Walk", "Wave", "Turn" };
+        for (int a = 0; a < 3; ++a)
+        {
+            Animation* anim = skel->createAnimation(names[a], 4);
+            if (a == 2)
+                anim->setRotationInterpolationMode(Animation::RIM_SPHERICAL);
+            for (unsigned short h = 0; h < NUM_BONES; ++h)
+            {
+                if (rand() % 3 == 0)
+                    continue;
+                NodeAnimationTrack* track = anim->createNodeTrack(h);
+                track->setUseShortestRotationPath(rand() % 4 != 0);
+                int numKeys = 1 + rand() % 5;
+                for (int k = 0; k < numKeys; ++k)
+                {
+                    TransformKeyFrame* key = track->createNodeKeyFrame(k * 4.0f / numKeys);
+                    key->setTranslate(randomVector(2));
+                    key->setRotation(randomOrientation());
+                    key->setScale(rand() % 2 ? Vector3::UNIT_SCALE : Vector3(Math::RangeRandom(0.8, 1.2)));
+                }
+            }
+        }
+    }
+
+    Entity* createEntity(void)
+    {
+        Entity* entity = mSceneMgr->createEntity(mMesh);
+        mSceneMgr->getRootSceneNode()->createChildSceneNode()->attachObject(entity);
+        mEntities.push_back(entity);
+        return entity;
+    }
+
+    /// Enables a random set of animations of each entity
+    void randomiseStates(void)
+    {
+        for (size_t i = 0; i < mEntities.size(); ++i)
+        {
+            AnimationStateIterator it = mEntities[i]->getAllAnimationStates()->getAnimationStateIterator();
+            while (it.hasMoreElements())
+            {
+                AnimationState* state = it.getNext();
+                state->setEnabled(rand() % 3 != 0);
+                state->setTimePosition(Math::UnitRandom() * 6);
+                state->setWeight(Math::UnitRandom() * 1.5f);
+                if (rand() % 4 == 0)
+                {
+                    state->createBlendMask(NUM_BONES);
+                    for (unsigned short h = 0; h < NUM_BONES; ++h)
+                        state->setBlendMaskEntry(h, Math::UnitRandom());
+                }
+            }
+        }
+    }
+
+    /// Allows for the different order of the float operations
+    static Real tolerance(Real expected)
+    {
+        return 1e-4f * std::max(Real(1), Math::Abs(expected));
+    }
+
+    /// Checks the bone matrices of an entity against Skeleton::_getBoneMatrices
+    void expectMatchesSkeleton(Entity* entity)
+    {
+        ASSERT_EQ(NUM_BONES, entity->_getNumBoneMatrices());
+        vector<Matrix4>::type batched(entity->_getBoneMatrices(), entity->_getBoneMatrices() + NUM_BONES);
+
+        // The batch handed its local transforms to the bones
+        SkeletonInstance* skel = entity->getSkeleton();
+        vector<Vector3>::type positions;
+        for (unsigned short h = 0; h < NUM_BONES; ++h)
+            positions.push_back(skel->getBone(h)->_getDerivedPosition());
+
+        skel->setAnimationState(*entity->getAllAnimationStates());
+        Matrix4 expected[NUM_BONES];
+        skel->_getBoneMatrices(expected);
+        for (unsigned short h = 0; h < NUM_BONES; ++h)
+        {
+            for (size_t r = 0; r < 4; ++r)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                    EXPECT_NEAR(expected[h][r][c], batched[h][r][c], tolerance(expected[h][r][c]));
+            }
+            const Vector3& position = skel->getBone(h)->_getDerivedPosition();
+            for (size_t c = 0; c < 3; ++c)
+                EXPECT_NEAR(position[c], positions[h][c], tolerance(position[c]));
+        }
+    }
+
+    void nextFrame(void)
+    {
+        FrameEvent evt;
+        mRoot->_fireFrameRenderingQueued(evt);
+    }
+};
+const unsigned short SkeletonAnimationBatchTests::NUM_BONES;
+//--------------------------------------------------------------------------
+TEST_F(SkeletonAnimationBatchTests, MatchesSkeletonSetAnimationState)
+{
+    for (size_t i = 0; i < 40; ++i)
+        createEntity()->getSkeleton()->setBlendMode(i % 2 ? ANIMBLEND_AVERAGE : ANIMBLEND_CUMULATIVE);
+
+    SkeletonAnimationBatch batch;
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        nextFrame();
+        randomiseStates();
+        EXPECT_EQ(mEntities.size(), batch.update(&mEntities[0], mEntities.size()));
+        for (size_t i = 0; i < mEntities.size(); ++i)
+            expectMatchesSkeleton(mEntities[i]);
+
+        // Up to date for this frame now
+        EXPECT_EQ(0u, batch.update(&mEntities[0], mEntities.size()));
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(SkeletonAnimationBatchTests, SkipsUnsupportedEntities)
+{
+    Entity* plain = createEntity();
+    Entity* manual = createEntity();
+    manual->getSkeleton()->getBone(5)->setManuallyControlled(true);
+    Entity* spline = createEntity();
+    Entity* shared = createEntity();
+    shared->shareSkeletonInstanceWith(plain);
+
+    Animation* anim = mMesh->getSkeleton()->getAnimation("Walk");
+    anim->setInterpolationMode(Animation::IM_SPLINE);
+    spline->getAnimationState("Walk")->setEnabled(true);
+    plain->getAnimationState("Wave")->setEnabled(true);
+    manual->getAnimationState("Wave")->setEnabled(true);
+
+    EXPECT_TRUE(SkeletonAnimationBatch::isSupported(plain));
+    EXPECT_FALSE(SkeletonAnimationBatch::isSupported(manual));
+    EXPECT_FALSE(SkeletonAnimationBatch::isSupported(spline));
+
+    nextFrame();
+    SkeletonAnimationBatch batch;
+    // The plain entity and the one sharing its skeleton instance
+    EXPECT_EQ(1u, batch.update(&mEntities[0], mEntities.size()));
+    expectMatchesSkeleton(plain);
+    EXPECT_EQ(plain->_getBoneMatrices(), shared->_getBoneMatrices());
+}
+//--------------------------------------------------------------------------
+TEST_F(SkeletonAnimationBatchTests, SceneManagerOption)
+{
+    EXPECT_FALSE(mSceneMgr->getSkeletalAnimationBatching());
+    mSceneMgr->setSkeletalAnimationBatching(true);
+    EXPECT_TRUE(mSceneMgr->getSkeletalAnimationBatching());
+    mSceneMgr->setSkeletalAnimationBatching(true);
+    EXPECT_TRUE(mSceneMgr->getSkeletalAnimationBatching());
+    mSceneMgr->setSkeletalAnimationBatching(false);
+    EXPECT_FALSE(mSceneMgr->getSkeletalAnimationBatching());
+}
+//--------------------------------------------------------------------------
+TEST_F(SkeletonAnimationBatchTests, SceneManagerSkipsEntitiesOutOfView)
+{
+    TestSceneManager sceneMgr;
+    sceneMgr.setSkeletalAnimationBatching(true);
+    Entity* seen = sceneMgr.createEntity(mMesh);
+    Entity* unseen = sceneMgr.createEntity(mMesh);
+    sceneMgr.getRootSceneNode()->attachObject(seen);
+    sceneMgr.getRootSceneNode()->attachObject(unseen);
+    seen->getAnimationState("Wave")->setEnabled(true);
+    unseen->getAnimationState("Wave")->setEnabled(true);
+    // Without a render system, the materials have no techniques to queue
+    mMesh->setAutoBuildEdgeLists(false);
+    seen->getSubEntity(0)->setVisible(false);
+
+    // Only one of them is rendered in the first frame
+    nextFrame();
+    seen->_updateRenderQueue(sceneMgr.getRenderQueue());
+
+    nextFrame();
+    const vector<Entity*>::type& batched = sceneMgr.collectSkeletalAnimations();
+    ASSERT_EQ(1u, batched.size());
+    EXPECT_EQ(seen, batched[0]);
+
+    // Out of view for a whole frame
+    nextFrame();
+    EXPECT_TRUE(sceneMgr.collectSkeletalAnimations().empty());
+}
+//--------------------------------------------------------------------------
+TEST_F(SkeletonAnimationBatchTests, KeepsLayoutsAcrossFrames)
+{
+    for (size_t i = 0; i < 4; ++i)
+        createEntity()->getAnimationState("Wave")->setEnabled(true);
+
+    TestBatch batch;
+    nextFrame();
+    EXPECT_EQ(mEntities.size(), batch.update(&mEntities[0], mEntities.size()));
+    ASSERT_EQ(1u, batch.getNumLayouts());
+    const void* data = batch.getLayoutData(0);
+
+    // Not evaluated again until the animation state changes
+    nextFrame();
+    EXPECT_EQ(0u, batch.update(&mEntities[0], mEntities.size()));
+
+    nextFrame();
+    mEntities[0]->getAnimationState("Wave")->addTime(0.5f);
+    EXPECT_EQ(1u, batch.update(&mEntities[0], mEntities.size()));
+    expectMatchesSkeleton(mEntities[0]);
+    EXPECT_EQ(1u, batch.getNumLayouts());
+    EXPECT_EQ(data, batch.getLayoutData(0));
+}
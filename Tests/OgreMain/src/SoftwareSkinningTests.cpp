@@ -0,0 +1,525 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreOptimisedUtil.h"
+#include "OgrePlatformInformation.h"
+#include "OgreSoftwareSkinningBatch.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreEntity.h"
+#include "OgreMesh.h"
+#include "OgreSubMesh.h"
+#include "OgreSkeleton.h"
+#include "OgreMeshManager.h"
+#include "OgreSkeletonManager.h"
+#include "OgreBone.h"
+#include "OgreAnimation.h"
+#include "OgreKeyFrame.h"
+#include "OgreLogManager.h"
+#include "OgreTimer.h"
+#include "OgreTaskScheduler.h"
+#include "OgreMath.h"
+#include "OgreStringConverter.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /** Vertices to skin, in one of the layouts meshes use.
+    @remarks
+        The destination holds 2 floats after the normal of each vertex which
+        must be left alone.
+    */
+    struct SkinningData
+    {
+        enum Layout
+        {
+            /// Positions, normals, weights and indices interleaved in one buffer
+            INTERLEAVED,
+            /// Packed positions and normals, weights and indices in buffers of their own
+            SEPARATE,
+            /// As SEPARATE without normals
+            POSITIONS_ONLY
+        };
+
+        size_t numVertices;
+        bool normals;
+        vector<float>::type vertices;
+        vector<float>::type weights;
+        vector<uint32>::type indices;
+        vector<float>::type dest;
+        const float* srcPos;
+        const float* srcNorm;
+        const float* blendWeights;
+        const unsigned char* blendIndices;
+        size_t srcPosStride, srcNormStride, blendWeightStride, blendIndexStride;
+        size_t destStride;
+
+        static const float SENTINEL;
+
+        SkinningData(Layout layout, size_t count, size_t numMatrices)
+            : numVertices(count), normals(layout != POSITIONS_ONLY)
+        {
+            size_t vertexFloats = layout == INTERLEAVED ? 11 : (normals ? 6 : 3);
+            vertices.resize(vertexFloats * count);
+            weights.resize(4 * count);
+            indices.resize(count);
+            for (size_t v = 0; v < count; ++v)
+            {
+                float* p = &vertices[v * vertexFloats];
+                Vector3 normal(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom());
+                normal.normalise();
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    p[c] = Math::SymmetricRandom() * 10;
+                    if (normals)
+                        p[3 + c] = normal[c];
+                }
+
+                // Up to 4 weights summing to 1, some unused
+                float* w = &weights[v * 4];
+                float sum = 0;
+                unsigned char* idx = reinterpret_cast<unsigned char*>(&indices[v]);
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    w[i] = rand() % 3 ? Math::UnitRandom() : 0;
+                    sum += w[i];
+                    idx[i] = static_cast<unsigned char>(rand() % numMatrices);
+                }
+                if (sum == 0)
+                    w[0] = sum = 1;
+                for (size_t i = 0; i < 4; ++i)
+                    w[i] /= sum;
+
+                if (layout == INTERLEAVED)
+                {
+                    memcpy(p + 6, w, 4 * sizeof(float));
+                    memcpy(p + 10, idx, 4);
+                }
+            }
+
+            srcPos = &vertices[0];
+            srcNorm = normals ? srcPos + 3 : 0;
+            srcPosStride = srcNormStride = vertexFloats * sizeof(float);
+            if (layout == INTERLEAVED)
+            {
+                blendWeights = srcPos + 6;
+                blendIndices = reinterpret_cast<const unsigned char*>(srcPos + 10);
+                blendWeightStride = blendIndexStride = srcPosStride;
+            }
+            else
+            {
+                blendWeights = &weights[0];
+                blendIndices = reinterpret_cast<const unsigned char*>(&indices[0]);
+                blendWeightStride = 4 * sizeof(float);
+                blendIndexStride = 4;
+            }
+
+            destStride = layout == INTERLEAVED ? 8 : vertexFloats;
+            dest.assign(destStride * count, SENTINEL);
+        }
+
+        float* destPos() { return &dest[0]; }
+        float* destNorm() { return normals ? &dest[3] : 0; }
+
+        void skin(OptimisedUtil* impl, const Matrix4* const* blendMatrices)
+        {
+            impl->softwareVertexSkinning(srcPos, destPos(), srcNorm, destNorm(),
+                blendWeights, blendIndices, blendMatrices,
+                srcPosStride, destStride * sizeof(float), srcNormStride, destStride * sizeof(float),
+                blendWeightStride, blendIndexStride, 4, numVertices);
+        }
+
+        /// Same as OptimisedUtilGeneral
+        vector<float>::type skinReference(const Matrix4* const* blendMatrices) const
+        {
+            vector<float>::type result(dest.size(), SENTINEL);
+            for (size_t v = 0; v < numVertices; ++v)
+            {
+                const float* p = rawOffsetPointer(srcPos, v * srcPosStride);
+                const float* n = normals ? rawOffsetPointer(srcNorm, v * srcNormStride) : 0;
+                const float* w = rawOffsetPointer(blendWeights, v * blendWeightStride);
+                const unsigned char* idx = rawOffsetPointer(blendIndices, v * blendIndexStride);
+                Vector3 pos = Vector3::ZERO, norm = Vector3::ZERO;
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    const Matrix4& m = *blendMatrices[idx[i]];
+                    pos += (m * Vector3(p[0], p[1], p[2])) * w[i];
+                    if (n)
+                    {
+                        Matrix3 linear;
+                        m.extract3x3Matrix(linear);
+                        norm += (linear * Vector3(n[0], n[1], n[2])) * w[i];
+                    }
+                }
+                float* d = &result[v * destStride];
+                for (size_t c = 0; c < 3; ++c)
+                    d[c] = pos[c];
+                if (n)
+                {
+                    norm.normalise();
+                    for (size_t c = 0; c < 3; ++c)
+                        d[3 + c] = norm[c];
+                }
+            }
+            return result;
+        }
+    };
+    const float SkinningData::SENTINEL = 12345.0f;
+
+    /// The SIMD implementations normalise with an approximate reciprocal square root
+    void expectNear(const vector<float>::type& expected, const vector<float>::type& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        size_t failures = 0;
+        for (size_t i = 0; i < expected.size() && failures < 10; ++i)
+        {
+            Real tolerance = 1e-3f * std::max(Real(1), Math::Abs(expected[i]));
+            if (Math::Abs(expected[i] - actual[i]) > tolerance)
+            {
+                ADD_FAILURE() << "Float " << i << ": expected " << expected[i] << ", got " << actual[i];
+                ++failures;
+            }
+        }
+    }
+
+    /// Vertex morph the way OptimisedUtilGeneral does it
+    vector<float>::type morphReference(Real t, const vector<float>::type& a, const vector<float>::type& b,
+        size_t vertexFloats, bool morphNormals)
+    {
+        vector<float>::type result(a.size());
+        for (size_t i = 0; i < a.size(); ++i)
+            result[i] = a[i] + t * (b[i] - a[i]);
+        if (morphNormals)
+        {
+            for (size_t v = 0; v < a.size() / vertexFloats; ++v)
+            {
+                float* n = &result[v * vertexFloats + 3];
+                Vector3 normal(n[0], n[1], n[2]);
+                normal.normalise();
+                n[0] = normal.x; n[1] = normal.y; n[2] = normal.z;
+            }
+        }
+        return result;
+    }
+}
+
+class SoftwareSkinningTests : public RootWithoutRenderSystemFixture
+{
+public:
+    size_t mNumMatrices;
+    Matrix4* mMatrices;
+    const Matrix4* mBlendMatrices[256];
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        DefaultWorkQueue* queue = static_cast<DefaultWorkQueue*>(mRoot->getWorkQueue());
+        queue->setWorkerThreadCount(4);
+        queue->startup();
+
+        srand(0);
+        mNumMatrices = 60;
+        mMatrices = OGRE_ALLOC_T_SIMD(Matrix4, mNumMatrices, MEMCATEGORY_ANIMATION);
+        for (size_t i = 0; i < mNumMatrices; ++i)
+        {
+            Quaternion q(Radian(Math::UnitRandom() * Math::TWO_PI),
+                Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()).normalisedCopy());
+            mMatrices[i].makeTransform(
+                Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * 5,
+                Vector3::UNIT_SCALE, q);
+            mBlendMatrices[i] = &mMatrices[i];
+        }
+    }
+
+    void TearDown()
+    {
+        OptimisedUtil::setParallelVertexThreshold(0);
+        OGRE_FREE_SIMD(mMatrices, MEMCATEGORY_ANIMATION);
+        RootWithoutRenderSystemFixture::TearDown();
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(SoftwareSkinningTests, SkinningMatchesReference)
+{
+    const SkinningData::Layout layouts[] = {
+        SkinningData::INTERLEAVED, SkinningData::SEPARATE, SkinningData::POSITIONS_ONLY };
+    // Whole blocks of vertices, remainders, and the unrolled SSE paths
+    const size_t counts[] = { 1, 7, 8, 13, 16, 17, 64, 1001 };
+    for (size_t l = 0; l < 3; ++l)
+    {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+        {
+            SCOPED_TRACE(StringConverter::toString(l) + " " + StringConverter::toString(counts[c]));
+            SkinningData data(layouts[l], counts[c], mNumMatrices);
+            data.skin(OptimisedUtil::getImplementation(), mBlendMatrices);
+            expectNear(data.skinReference(mBlendMatrices), data.dest);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(SoftwareSkinningTests, MorphMatchesReference)
+{
+    const size_t counts[] = { 1, 3, 8, 11, 100, 1003 };
+    for (int normals = 0; normals < 2; ++normals)
+    {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+        {
+            SCOPED_TRACE(StringConverter::toString(normals) + " " + StringConverter::toString(counts[c]));
+            size_t vertexFloats = normals ? 6 : 3;
+            vector<float>::type a(counts[c] * vertexFloats), b(a.size());
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                a[i] = Math::SymmetricRandom() * 10;
+                b[i] = Math::SymmetricRandom() * 10;
+            }
+            // One float past the end must be left alone
+            vector<float>::type dest(a.size() + 1, SkinningData::SENTINEL);
+            OptimisedUtil::getImplementation()->softwareVertexMorph(0.3f, &a[0], &b[0], &dest[0],
+                vertexFloats * sizeof(float), vertexFloats * sizeof(float), vertexFloats * sizeof(float),
+                counts[c], normals != 0);
+
+            vector<float>::type expected = morphReference(0.3f, a, b, vertexFloats, normals != 0);
+            expected.push_back(SkinningData::SENTINEL);
+            expectNear(expected, dest);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(SoftwareSkinningTests, ParallelVertexThreshold)
+{
+    OptimisedUtil* serial = OptimisedUtil::getImplementation();
+    EXPECT_EQ(0u, OptimisedUtil::getParallelVertexThreshold());
+    OptimisedUtil::setParallelVertexThreshold(1000);
+    EXPECT_EQ(1000u, OptimisedUtil::getParallelVertexThreshold());
+    EXPECT_NE(serial, OptimisedUtil::getImplementation());
+
+    // Above and below the threshold, with chunks not a multiple of the SIMD width
+    const size_t counts[] = { 999, 20011 };
+    for (size_t c = 0; c < 2; ++c)
+    {
+        SkinningData data(SkinningData::INTERLEAVED, counts[c], mNumMatrices);
+        data.skin(OptimisedUtil::getImplementation(), mBlendMatrices);
+        expectNear(data.skinReference(mBlendMatrices), data.dest);
+
+        vector<float>::type a(counts[c] * 6), b(a.size()), dest(a.size());
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            a[i] = Math::SymmetricRandom();
+            b[i] = Math::SymmetricRandom();
+        }
+        OptimisedUtil::getImplementation()->softwareVertexMorph(0.7f, &a[0], &b[0], &dest[0],
+            24, 24, 24, counts[c], true);
+        expectNear(morphReference(0.7f, a, b, 6, true), dest);
+    }
+
+    OptimisedUtil::setParallelVertexThreshold(0);
+    EXPECT_EQ(serial, OptimisedUtil::getImplementation());
+}
+//--------------------------------------------------------------------------
+class SoftwareSkinningBatchTests : public SoftwareSkinningTests
+{
+public:
+    SceneManager* mSceneMgr;
+    MeshPtr mMesh;
+
+    static const unsigned short NUM_BONES = 20;
+
+    void SetUp()
+    {
+        SoftwareSkinningTests::SetUp();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+
+        SkeletonPtr skel = SkeletonManager::getSingleton().create("SkinningTest.skeleton",
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, true);
+        Animation* anim = skel->createAnimation("Wave", 4);
+        for (unsigned short h = 0; h < NUM_BONES; ++h)
+        {
+            Bone* bone = h ? skel->getBone(static_cast<unsigned short>(rand() % h))->createChild(h) : skel->createBone(h);
+            bone->setPosition(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom());
+            NodeAnimationTrack* track = anim->createNodeTrack(h);
+            for (int k = 0; k < 3; ++k)
+            {
+                TransformKeyFrame* key = track->createNodeKeyFrame(k * 2.0f);
+                key->setTranslate(Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), 0));
+                key->setRotation(Quaternion(Radian(Math::SymmetricRandom()), Vector3::UNIT_Y));
+            }
+        }
+        skel->setBindingPose();
+
+        mMesh = createMesh("SkinningTest.mesh", 5000, skel);
+    }
+
+    void TearDown()
+    {
+        mMesh.reset();
+        SoftwareSkinningTests::TearDown();
+    }
+
+    /// A mesh with positions and normals in one buffer, and 2 bones per vertex
+    MeshPtr createMesh(const String& name, size_t numVertices, SkeletonPtr skel)
+    {
+        MeshPtr mesh = MeshManager::getSingleton().createManual(name,
+            ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+        mesh->sharedVertexData = OGRE_NEW VertexData();
+        mesh->sharedVertexData->vertexCount = numVertices;
+        VertexDeclaration* decl = mesh->sharedVertexData->vertexDeclaration;
+        decl->addElement(0, 0, VET_FLOAT3, VES_POSITION);
+        decl->addElement(0, 12, VET_FLOAT3, VES_NORMAL);
+        HardwareVertexBufferSharedPtr buf = HardwareBufferManager::getSingleton().createVertexBuffer(
+            24, numVertices, HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+        float* p = static_cast<float*>(buf->lock(HardwareBuffer::HBL_DISCARD));
+        for (size_t v = 0; v < numVertices; ++v, p += 6)
+        {
+            Vector3 normal = Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), 1).normalisedCopy();
+            for (size_t c = 0; c < 3; ++c)
+            {
+                p[c] = Math::SymmetricRandom() * 3;
+                p[3 + c] = normal[c];
+            }
+        }
+        buf->unlock();
+        mesh->sharedVertexData->vertexBufferBinding->setBinding(0, buf);
+
+        SubMesh* sub = mesh->createSubMesh();
+        sub->useSharedVertices = true;
+        sub->setMaterialName("BaseWhite");
+
+        mesh->_notifySkeleton(skel);
+        for (size_t v = 0; v < numVertices; ++v)
+        {
+            VertexBoneAssignment vba;
+            vba.vertexIndex = static_cast<unsigned int>(v);
+            vba.boneIndex = static_cast<unsigned short>(rand() % NUM_BONES);
+            vba.weight = 0.75f;
+            mesh->addBoneAssignment(vba);
+            vba.boneIndex = static_cast<unsigned short>((vba.boneIndex + 1) % NUM_BONES);
+            vba.weight = 0.25f;
+            mesh->addBoneAssignment(vba);
+        }
+        mesh->_compileBoneAssignments();
+        mesh->_setBounds(AxisAlignedBox(-10, -10, -10, 10, 10, 10));
+        // There are no triangles
+        mesh->setAutoBuildEdgeLists(false);
+        mesh->load();
+        return mesh;
+    }
+
+    Entity* createEntity(Real timePosition)
+    {
+        Entity* entity = mSceneMgr->createEntity(mMesh);
+        mSceneMgr->getRootSceneNode()->createChildSceneNode()->attachObject(entity);
+        AnimationState* state = entity->getAnimationState("Wave");
+        state->setEnabled(true);
+        state->setTimePosition(timePosition);
+        return entity;
+    }
+
+    /// Reads the blended positions and normals of an entity
+    static vector<float>::type readBlended(Entity* entity)
+    {
+        VertexData* data = entity->_getSkelAnimVertexData();
+        const VertexElement* posElem = data->vertexDeclaration->findElementBySemantic(VES_POSITION);
+        HardwareVertexBufferSharedPtr buf = data->vertexBufferBinding->getBuffer(posElem->getSource());
+        vector<float>::type result(buf->getSizeInBytes() / sizeof(float));
+        buf->readData(0, buf->getSizeInBytes(), &result[0]);
+        return result;
+    }
+};
+const unsigned short SoftwareSkinningBatchTests::NUM_BONES;
+//--------------------------------------------------------------------------
+TEST_F(SoftwareSkinningBatchTests, MatchesEntityUpdate)
+{
+    vector<Entity*>::type batched, reference;
+    for (size_t i = 0; i < 12; ++i)
+    {
+        Real time = i * 0.3f;
+        batched.push_back(createEntity(time));
+        reference.push_back(createEntity(time));
+    }
+
+    SoftwareSkinningBatch batch;
+    EXPECT_EQ(batched.size(), batch.update(&batched[0], batched.size()));
+    for (size_t i = 0; i < batched.size(); ++i)
+    {
+        reference[i]->_updateAnimation();
+        expectNear(readBlended(reference[i]), readBlended(batched[i]));
+    }
+
+    // Up to date for this frame now
+    EXPECT_EQ(0u, batch.update(&batched[0], batched.size()));
+}
+//--------------------------------------------------------------------------
+TEST_F(SoftwareSkinningBatchTests, SceneManagerOption)
+{
+    EXPECT_FALSE(mSceneMgr->getSoftwareSkinningBatching());
+    mSceneMgr->setSoftwareSkinningBatching(true);
+    EXPECT_TRUE(mSceneMgr->getSoftwareSkinningBatching());
+    mSceneMgr->setSoftwareSkinningBatching(true);
+    EXPECT_TRUE(mSceneMgr->getSoftwareSkinningBatching());
+    mSceneMgr->setSoftwareSkinningBatching(false);
+    EXPECT_FALSE(mSceneMgr->getSoftwareSkinningBatching());
+}
+//--------------------------------------------------------------------------
+TEST_F(SoftwareSkinningTests, DISABLED_Benchmark)
+{
+    LogManager::getSingleton().stream() << "Software skinning, AVX2: "
+        << PlatformInformation::hasCpuFeature(PlatformInformation::CPU_FEATURE_AVX2) << ", threads: "
+        << mRoot->getTaskScheduler()->getConcurrency();
+
+    Timer timer;
+    for (size_t numVertices = 1000; numVertices <= 1000000; numVertices *= 10)
+    {
+        SkinningData data(SkinningData::SEPARATE, numVertices, mNumMatrices);
+        const int repeats = static_cast<int>(std::max<size_t>(1, 1000000 / numVertices));
+
+        // Scalar reference, the SIMD implementation picked, then split across threads
+        timer.reset();
+        data.skinReference(mBlendMatrices);
+        unsigned long scalar = timer.getMicroseconds();
+
+        unsigned long elapsed[2];
+        for (int parallel = 0; parallel < 2; ++parallel)
+        {
+            OptimisedUtil::setParallelVertexThreshold(parallel ? 1000 : 0);
+            timer.reset();
+            for (int r = 0; r < repeats; ++r)
+                data.skin(OptimisedUtil::getImplementation(), mBlendMatrices);
+            elapsed[parallel] = timer.getMicroseconds() / repeats;
+        }
+        expectNear(data.skinReference(mBlendMatrices), data.dest);
+
+        LogManager::getSingleton().stream() << numVertices << " vertices: scalar "
+            << scalar / 1000.0f << " ms, SIMD " << elapsed[0] / 1000.0f << " ms, parallel "
+            << elapsed[1] / 1000.0f << " ms";
+    }
+    OptimisedUtil::setParallelVertexThreshold(0);
+}
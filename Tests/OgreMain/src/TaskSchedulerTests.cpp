@@ -0,0 +1,254 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "OgreRoot.h"
+#include "OgreTaskScheduler.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+
+using namespace Ogre;
+
+namespace
+{
+    /// Counts how many times each item was processed
+    struct CountItems
+    {
+        AtomicScalar<uint32>* mCounts;
+
+        CountItems(AtomicScalar<uint32>* counts) : mCounts(counts) {}
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t i = begin; i < end; ++i)
+                ++mCounts[i];
+        }
+    };
+
+    /// Runs a parallelFor over a row of items from each chunk
+    struct CountRows
+    {
+        AtomicScalar<uint32>* mCounts;
+        size_t mRowSize;
+        TaskScheduler* mScheduler;
+
+        CountRows(AtomicScalar<uint32>* counts, size_t rowSize, TaskScheduler* scheduler)
+            : mCounts(counts), mRowSize(rowSize), mScheduler(scheduler) {}
+
+        void operator()(size_t begin, size_t end) const
+        {
+            for (size_t row = begin; row < end; ++row)
+            {
+                CountItems counter(mCounts + row * mRowSize);
+                FunctorTask<CountItems> task(counter);
+                TaskGroup group("CountRow", mScheduler);
+                group.run(&task, 0, mRowSize, 7);
+            }
+        }
+    };
+
+    /// Counts the responses reaching the main thread
+    class CountResponses : public WorkQueue::ResponseHandler
+    {
+    public:
+        size_t mCount;
+
+        CountResponses() : mCount(0) {}
+
+        void handleResponse(const WorkQueue::Response* res, const WorkQueue* srcQ)
+        {
+            ++mCount;
+        }
+    };
+}
+
+class TaskSchedulerTests : public ::testing::Test
+{
+public:
+    Root* mRoot;
+    DefaultWorkQueue* mQueue;
+    TaskScheduler* mScheduler;
+
+    void SetUp()
+    {
+        mRoot = OGRE_NEW Root("");
+        mQueue = OGRE_NEW DefaultWorkQueue("TaskSchedulerTests");
+        mQueue->setWorkerThreadCount(4);
+        mQueue->startup();
+        mScheduler = OGRE_NEW TaskScheduler(mQueue);
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mScheduler;
+        mQueue->shutdown();
+        OGRE_DELETE mQueue;
+        OGRE_DELETE mRoot;
+    }
+
+    /// Checks each of the counts is expected, and resets them
+    void checkCounts(vector<AtomicScalar<uint32> >::type& counts, uint32 expected)
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            EXPECT_EQ(expected, counts[i].get());
+            counts[i].set(0);
+        }
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(TaskSchedulerTests, ProcessesEachItemOnce)
+{
+    const size_t numItems = 10007;
+    vector<AtomicScalar<uint32> >::type counts(numItems, AtomicScalar<uint32>(0));
+    CountItems counter(&counts[0]);
+    FunctorTask<CountItems> task(counter);
+
+    const size_t grainSizes[] = { 0, 1, 64, 1000, 20000 };
+    for (size_t i = 0; i < sizeof(grainSizes) / sizeof(grainSizes[0]); ++i)
+    {
+        TaskGroup group("ProcessesEachItemOnce", mScheduler);
+        group.run(&task, 0, numItems, grainSizes[i]);
+        group.wait();
+        checkCounts(counts, 1);
+    }
+
+    // Part of the range, several tasks in a group
+    {
+        TaskGroup group("ProcessesEachItemOnce", mScheduler);
+        group.run(&task, 0, 10, 3);
+        group.run(&task, 10, numItems, 100);
+        group.run(&task, 0, numItems, 50);
+        group.run(&task, 5, 5, 1);
+    }
+    for (size_t i = 0; i < numItems; ++i)
+        EXPECT_EQ(2u, counts[i].get());
+}
+//--------------------------------------------------------------------------
+TEST_F(TaskSchedulerTests, WaitWithoutParticipating)
+{
+    const size_t numItems = 5000;
+    vector<AtomicScalar<uint32> >::type counts(numItems, AtomicScalar<uint32>(0));
+    CountItems counter(&counts[0]);
+    FunctorTask<CountItems> task(counter);
+
+    TaskGroup group("WaitWithoutParticipating", mScheduler);
+    group.run(&task, 0, numItems, 16);
+    group.wait(false);
+    checkCounts(counts, 1);
+
+    // Without workers the waiting thread has to do the work anyway
+    TaskScheduler inlineScheduler(0);
+    EXPECT_EQ(1u, inlineScheduler.getConcurrency());
+    TaskGroup inlineGroup("WaitWithoutParticipating", &inlineScheduler);
+    inlineGroup.run(&task, 0, numItems, 16);
+    inlineGroup.wait(false);
+    checkCounts(counts, 1);
+
+    // Nor when the queue was never started
+    DefaultWorkQueue stoppedQueue("Stopped");
+    stoppedQueue.setWorkerThreadCount(4);
+    TaskScheduler stoppedScheduler(&stoppedQueue);
+    EXPECT_EQ(1u, stoppedScheduler.getConcurrency());
+    TaskGroup stoppedGroup("WaitWithoutParticipating", &stoppedScheduler);
+    stoppedGroup.run(&task, 0, numItems, 16);
+    stoppedGroup.wait(false);
+    checkCounts(counts, 1);
+}
+//--------------------------------------------------------------------------
+TEST_F(TaskSchedulerTests, NoResponsesQueued)
+{
+    const size_t numItems = 5000;
+    vector<AtomicScalar<uint32> >::type counts(numItems, AtomicScalar<uint32>(0));
+    CountItems counter(&counts[0]);
+    FunctorTask<CountItems> task(counter);
+    for (int i = 0; i < 10; ++i)
+    {
+        TaskGroup group("NoResponsesQueued", mScheduler);
+        group.run(&task, 0, numItems, 16);
+        group.wait(i % 2 == 0);
+    }
+    checkCounts(counts, 10);
+
+    // The chunks are done on the workers, nothing is left for the main thread
+    CountResponses responses;
+    mQueue->addResponseHandler(mScheduler->getChannel(), &responses);
+    mQueue->processResponses();
+    mQueue->removeResponseHandler(mScheduler->getChannel(), &responses);
+    EXPECT_EQ(0u, responses.mCount);
+}
+//--------------------------------------------------------------------------
+TEST_F(TaskSchedulerTests, DestroyWithRequestsQueued)
+{
+    const size_t numItems = 1000;
+    vector<AtomicScalar<uint32> >::type counts(numItems, AtomicScalar<uint32>(0));
+    CountItems counter(&counts[0]);
+    FunctorTask<CountItems> task(counter);
+
+    // The waiting thread does all the work, the requests stay queued
+    mQueue->setPaused(true);
+    {
+        TaskGroup group("DestroyWithRequestsQueued", mScheduler);
+        group.run(&task, 0, numItems, 10);
+        group.wait();
+    }
+    checkCounts(counts, 1);
+
+    // Their batch goes with them, without reaching the handler
+    OGRE_DELETE mScheduler;
+    mScheduler = OGRE_NEW TaskScheduler(mQueue);
+    mQueue->setPaused(false);
+    TaskGroup group("DestroyWithRequestsQueued", mScheduler);
+    group.run(&task, 0, numItems, 10);
+    group.wait();
+    checkCounts(counts, 1);
+}
+//--------------------------------------------------------------------------
+TEST_F(TaskSchedulerTests, NestedGroups)
+{
+    const size_t numRows = 64;
+    const size_t rowSize = 300;
+    vector<AtomicScalar<uint32> >::type counts(numRows * rowSize, AtomicScalar<uint32>(0));
+
+    CountRows counter(&counts[0], rowSize, mScheduler);
+    FunctorTask<CountRows> task(counter);
+    TaskGroup group("NestedGroups", mScheduler);
+    group.run(&task, 0, numRows, 1);
+    group.wait();
+    checkCounts(counts, 1);
+}
+//--------------------------------------------------------------------------
+TEST_F(TaskSchedulerTests, ParallelForUsesRootScheduler)
+{
+    ASSERT_TRUE(mRoot->getTaskScheduler() != 0);
+    EXPECT_EQ(mRoot->getWorkQueue(), mRoot->getTaskScheduler()->getWorkQueue());
+
+    const size_t numItems = 1000;
+    vector<AtomicScalar<uint32> >::type counts(numItems, AtomicScalar<uint32>(0));
+    parallelFor(0, numItems, 10, CountItems(&counts[0]));
+    checkCounts(counts, 1);
+}
@@ -0,0 +1,363 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreLogManager.h"
+#include "OgreTimer.h"
+#include "Threading/OgreDefaultWorkQueue.h"
+#include "Threading/OgreStealingWorkQueue.h"
+
+using namespace Ogre;
+
+namespace
+{
+    const uint16 TEST_CHANNEL = 1;
+
+    /** Handles requests holding an int, failing negative ones the first times,
+        and records the responses.
+    */
+    class CountingHandler : public WorkQueue::RequestHandler, public WorkQueue::ResponseHandler
+    {
+    public:
+        Timer mTimer;
+        std::atomic<size_t> mNumHandled;
+        std::atomic<size_t> mNumFailures;
+        /// Sum of the times from adding to handling the requests
+        std::atomic<unsigned long> mTotalLatency;
+        vector<int>::type mResponses;
+
+        CountingHandler() : mNumHandled(0), mNumFailures(0), mTotalLatency(0) {}
+
+        WorkQueue::Response* handleRequest(const WorkQueue::Request* req, const WorkQueue* srcQ)
+        {
+            ++mNumHandled;
+            if (req->getType() == 1)
+            {
+                // Latency test, the data is the time the request was added
+                mTotalLatency += mTimer.getMicroseconds() - any_cast<unsigned long>(req->getData());
+                return OGRE_NEW WorkQueue::Response(req, true, Any(0));
+            }
+            int value = any_cast<int>(req->getData());
+            if (value < 0 && mNumFailures++ < 2)
+                return OGRE_NEW WorkQueue::Response(req, false, Any());
+            return OGRE_NEW WorkQueue::Response(req, true, Any(value));
+        }
+
+        void handleResponse(const WorkQueue::Response* res, const WorkQueue* srcQ)
+        {
+            mResponses.push_back(any_cast<int>(res->getData()));
+        }
+    };
+
+    /// Removes itself from the queue while handling its first request
+    class SelfRemovingHandler : public WorkQueue::RequestHandler
+    {
+    public:
+        WorkQueue* mQueue;
+        std::atomic<size_t> mNumHandled;
+
+        SelfRemovingHandler(WorkQueue* queue) : mQueue(queue), mNumHandled(0) {}
+
+        WorkQueue::Response* handleRequest(const WorkQueue::Request* req, const WorkQueue* srcQ)
+        {
+            if (mNumHandled++ == 0)
+                mQueue->removeRequestHandler(req->getChannel(), this);
+            return OGRE_NEW WorkQueue::Response(req, true, Any(0));
+        }
+    };
+
+    /// Gives access to what the queue keeps around
+    class InspectedStealingWorkQueue : public StealingWorkQueue
+    {
+    public:
+        InspectedStealingWorkQueue() : StealingWorkQueue("Test") {}
+        size_t getNumRetiredRequestHandlers() const { return mNumRetiredRequestHandlers.load(); }
+        size_t getNumAbortRecords() const { return mAbortRecords.size(); }
+    };
+}
+
+class WorkQueueTests : public RootWithoutRenderSystemFixture
+{
+public:
+    /// Processes responses until there are numResponses, or a few seconds passed
+    void waitForResponses(WorkQueue* queue, CountingHandler& handler, size_t numResponses)
+    {
+        Timer timer;
+        while (handler.mResponses.size() < numResponses && timer.getMilliseconds() < 10000)
+        {
+            queue->processResponses();
+        }
+    }
+
+    /// Microseconds to get the responses of numRequests requests added at once
+    unsigned long measureThroughput(WorkQueue* queue, size_t numRequests, bool bulk)
+    {
+        CountingHandler handler;
+        queue->addRequestHandler(TEST_CHANNEL, &handler);
+        queue->addResponseHandler(TEST_CHANNEL, &handler);
+
+        vector<Any>::type data(numRequests);
+        for (size_t i = 0; i < numRequests; ++i)
+            data[i] = Any(static_cast<int>(i));
+
+        Timer timer;
+        if (bulk)
+        {
+            queue->addRequests(TEST_CHANNEL, 0, &data[0], numRequests);
+        }
+        else
+        {
+            for (size_t i = 0; i < numRequests; ++i)
+                queue->addRequest(TEST_CHANNEL, 0, data[i]);
+        }
+        waitForResponses(queue, handler, numRequests);
+        unsigned long elapsed = timer.getMicroseconds();
+        EXPECT_EQ(numRequests, handler.mResponses.size());
+
+        queue->removeRequestHandler(TEST_CHANNEL, &handler);
+        queue->removeResponseHandler(TEST_CHANNEL, &handler);
+        return elapsed;
+    }
+
+    /// Average microseconds from adding a request to handling it, with requests trickling in
+    float measureLatency(WorkQueue* queue, size_t numRequests)
+    {
+        CountingHandler handler;
+        queue->addRequestHandler(TEST_CHANNEL, &handler);
+        queue->addResponseHandler(TEST_CHANNEL, &handler);
+
+        for (size_t i = 0; i < numRequests; ++i)
+        {
+            queue->addRequest(TEST_CHANNEL, 1, Any(handler.mTimer.getMicroseconds()));
+            if (i % 16 == 15)
+                queue->processResponses();
+        }
+        waitForResponses(queue, handler, numRequests);
+        EXPECT_EQ(numRequests, handler.mResponses.size());
+
+        queue->removeRequestHandler(TEST_CHANNEL, &handler);
+        queue->removeResponseHandler(TEST_CHANNEL, &handler);
+        return static_cast<float>(handler.mTotalLatency) / numRequests;
+    }
+};
+//--------------------------------------------------------------------------
+TEST_F(WorkQueueTests, HandlerRemovesItself)
+{
+    DefaultWorkQueue defaultQueue("Default");
+    StealingWorkQueue stealingQueue("Stealing");
+    WorkQueue* queues[2] = { &defaultQueue, &stealingQueue };
+    defaultQueue.setWorkerThreadCount(2);
+    stealingQueue.setWorkerThreadCount(2);
+    for (int q = 0; q < 2; ++q)
+    {
+        SCOPED_TRACE(q ? "StealingWorkQueue" : "DefaultWorkQueue");
+        WorkQueue* queue = queues[q];
+        queue->startup();
+
+        SelfRemovingHandler handler(queue);
+        CountingHandler responses;
+        queue->addRequestHandler(TEST_CHANNEL, &handler);
+        queue->addResponseHandler(TEST_CHANNEL, &responses);
+        queue->addRequest(TEST_CHANNEL, 0, Any(0));
+        waitForResponses(queue, responses, 1);
+        EXPECT_EQ(1u, responses.mResponses.size());
+
+        // No longer handled
+        queue->addRequest(TEST_CHANNEL, 0, Any(0));
+        queue->removeResponseHandler(TEST_CHANNEL, &responses);
+        queue->shutdown();
+        EXPECT_EQ(1u, handler.mNumHandled.load());
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(WorkQueueTests, StealingProcessesAllRequests)
+{
+    StealingWorkQueue queue("Test");
+    queue.setWorkerThreadCount(4);
+    queue.setResponseProcessingTimeLimit(0);
+    queue.startup();
+
+    CountingHandler handler;
+    queue.addRequestHandler(TEST_CHANNEL, &handler);
+    queue.addResponseHandler(TEST_CHANNEL, &handler);
+
+    const int numRequests = 10000;
+    for (int i = 0; i < numRequests / 2; ++i)
+    {
+        EXPECT_NE(0u, queue.addRequest(TEST_CHANNEL, 0, Any(i)));
+    }
+    vector<Any>::type data;
+    for (int i = numRequests / 2; i < numRequests; ++i)
+    {
+        data.push_back(Any(i));
+    }
+    vector<WorkQueue::RequestID>::type ids(data.size());
+    queue.addRequests(TEST_CHANNEL, 0, &data[0], data.size(), 0, &ids[0]);
+    for (size_t i = 1; i < ids.size(); ++i)
+    {
+        EXPECT_EQ(ids[0] + i, ids[i]);
+    }
+    // Fails twice before succeeding
+    queue.addRequest(TEST_CHANNEL, 0, Any(-1), 2);
+    // Processed one at a time, in order
+    for (int i = 0; i < 100; ++i)
+    {
+        queue.addRequest(TEST_CHANNEL, 0, Any(numRequests + i), 0, false, true);
+    }
+
+    waitForResponses(&queue, handler, numRequests + 101);
+    ASSERT_EQ(size_t(numRequests + 101), handler.mResponses.size());
+
+    vector<int>::type idle;
+    for (size_t i = 0; i < handler.mResponses.size(); ++i)
+    {
+        if (handler.mResponses[i] >= numRequests)
+            idle.push_back(handler.mResponses[i]);
+    }
+    EXPECT_EQ(100u, idle.size());
+    EXPECT_TRUE(std::is_sorted(idle.begin(), idle.end()));
+
+    std::sort(handler.mResponses.begin(), handler.mResponses.end());
+    EXPECT_EQ(-1, handler.mResponses[0]);
+    for (int i = 0; i < numRequests + 100; ++i)
+    {
+        EXPECT_EQ(i, handler.mResponses[i + 1]);
+    }
+    EXPECT_EQ(size_t(numRequests + 103), handler.mNumHandled.load());
+
+    queue.removeRequestHandler(TEST_CHANNEL, &handler);
+    queue.shutdown();
+}
+//--------------------------------------------------------------------------
+TEST_F(WorkQueueTests, StealingAbortsPendingRequests)
+{
+    StealingWorkQueue queue("Test");
+    queue.setWorkerThreadCount(2);
+    queue.startup();
+
+    CountingHandler handler;
+    queue.addRequestHandler(TEST_CHANNEL, &handler);
+    queue.addResponseHandler(TEST_CHANNEL, &handler);
+
+    queue.setPaused(true);
+    for (int i = 0; i < 1000; ++i)
+    {
+        queue.addRequest(TEST_CHANNEL, 0, Any(i));
+    }
+    queue.abortRequestsByChannel(TEST_CHANNEL);
+    queue.setPaused(false);
+
+    // Added after the abort, so not aborted
+    for (int i = 0; i < 10; ++i)
+    {
+        queue.addRequest(TEST_CHANNEL, 0, Any(i));
+    }
+    waitForResponses(&queue, handler, 10);
+    EXPECT_EQ(10u, handler.mResponses.size());
+    EXPECT_EQ(10u, handler.mNumHandled.load());
+
+    queue.removeRequestHandler(TEST_CHANNEL, &handler);
+    queue.shutdown();
+}
+//--------------------------------------------------------------------------
+TEST_F(WorkQueueTests, StealingReclaimsHandlersAndAborts)
+{
+    InspectedStealingWorkQueue queue;
+    queue.setWorkerThreadCount(4);
+    queue.setResponseProcessingTimeLimit(0);
+    queue.startup();
+
+    CountingHandler handler;
+    CountingHandler transientHandler;
+    queue.addRequestHandler(TEST_CHANNEL, &handler);
+    queue.addResponseHandler(TEST_CHANNEL, &handler);
+
+    // Handlers changing while the workers are busy
+    for (int i = 0; i < 1000; ++i)
+    {
+        queue.addRequestHandler(TEST_CHANNEL, &transientHandler);
+        queue.addRequest(TEST_CHANNEL, 0, Any(i));
+        queue.removeRequestHandler(TEST_CHANNEL, &transientHandler);
+        queue.processResponses();
+    }
+    waitForResponses(&queue, handler, 1000);
+    EXPECT_EQ(1000u, handler.mResponses.size());
+    // Nothing uses the old handlers once the requests are done
+    EXPECT_EQ(0u, queue.getNumRetiredRequestHandlers());
+
+    // The aborts of a channel go once its requests are done, whatever the others do
+    const uint16 otherChannel = TEST_CHANNEL + 1;
+    queue.setPaused(true);
+    queue.addRequest(otherChannel, 0, Any(0));
+    queue.abortRequestsByChannel(TEST_CHANNEL);
+    queue.abortRequestsByChannel(otherChannel);
+    queue.processResponses();
+    EXPECT_EQ(1u, queue.getNumAbortRecords());
+    queue.setPaused(false);
+    Timer timer;
+    while (queue.getNumAbortRecords() && timer.getMilliseconds() < 10000)
+        queue.processResponses();
+    EXPECT_EQ(0u, queue.getNumAbortRecords());
+
+    queue.removeRequestHandler(TEST_CHANNEL, &handler);
+    EXPECT_EQ(0u, queue.getNumRetiredRequestHandlers());
+    queue.shutdown();
+}
+//--------------------------------------------------------------------------
+TEST_F(WorkQueueTests, DISABLED_Benchmark)
+{
+    const size_t numRequests = 200000;
+    const size_t numThreads = 4;
+
+    DefaultWorkQueue defaultQueue("Default");
+    StealingWorkQueue stealingQueue("Stealing");
+    WorkQueue* queues[2] = { &defaultQueue, &stealingQueue };
+    defaultQueue.setWorkerThreadCount(numThreads);
+    stealingQueue.setWorkerThreadCount(numThreads);
+    const char* names[2] = { "DefaultWorkQueue", "StealingWorkQueue" };
+
+    for (int q = 0; q < 2; ++q)
+    {
+        queues[q]->setResponseProcessingTimeLimit(0);
+        queues[q]->startup();
+
+        unsigned long single = measureThroughput(queues[q], numRequests, false);
+        unsigned long bulk = measureThroughput(queues[q], numRequests, true);
+        float latency = measureLatency(queues[q], numRequests / 10);
+
+        LogManager::getSingleton().stream() << names[q] << " with " << numThreads
+            << " threads: " << numRequests << " requests in " << single / 1000.0f
+            << " ms added one by one, " << bulk / 1000.0f << " ms added at once, "
+            << latency << " us average latency";
+
+        queues[q]->shutdown();
+    }
+}
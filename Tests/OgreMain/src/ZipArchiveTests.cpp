@@ -31,6 +31,9 @@ THE SOFTWARE.
 #include "OgreConfigFile.h"
 #include "OgreFileSystemLayer.h"
 
+#include <cstdio>
+#include <fstream>
+
 using namespace Ogre;
 
 static String fileId(const String& path) {
@@ -43,14 +46,16 @@ static String fileId(const String& path) {
     return path;
 }
 
-//--------------------------------------------------------------------------
-void ZipArchiveTests::SetUp()
-{
+static String testZipPath() {
     Ogre::ConfigFile cf;
     cf.load(Ogre::FileSystemLayer(OGRE_VERSION_NAME).getConfigFilePath("resources.cfg"));
-    Ogre::String testPath = cf.getSettings("Tests").begin()->second+"/misc/ArchiveTest.zip";
+    return cf.getSettings("Tests").begin()->second+"/misc/ArchiveTest.zip";
+}
 
-    arch = OGRE_NEW ZipArchive(testPath, "Zip");
+//--------------------------------------------------------------------------
+void ZipArchiveTests::SetUp()
+{
+    arch = OGRE_NEW ZipArchive(testZipPath(), "Zip");
     arch->load();
 }
 //--------------------------------------------------------------------------
@@ -250,3 +255,132 @@ TEST_F(ZipArchiveTests,ReadInterleave)
     EXPECT_TRUE(stream2->eof());
 }
 //--------------------------------------------------------------------------
+void MappedZipArchiveTests::SetUp()
+{
+    arch = OGRE_NEW MappedZipArchive(testZipPath(), "MappedZip");
+    arch->load();
+}
+//--------------------------------------------------------------------------
+void MappedZipArchiveTests::TearDown()
+{
+    OGRE_DELETE arch;
+}
+//--------------------------------------------------------------------------
+TEST_F(MappedZipArchiveTests,ListFileInfoMatchesZipArchive)
+{
+    ZipArchive zzipArch(testZipPath(), "Zip");
+    zzipArch.load();
+
+    FileInfoListPtr expected = zzipArch.listFileInfo(true, false);
+    FileInfoListPtr vec = arch->listFileInfo(true, false);
+    ASSERT_EQ(expected->size(), vec->size());
+    for (size_t i = 0; i < vec->size(); ++i)
+    {
+        EXPECT_EQ(expected->at(i).filename, vec->at(i).filename);
+        EXPECT_EQ(expected->at(i).path, vec->at(i).path);
+        EXPECT_EQ(expected->at(i).basename, vec->at(i).basename);
+        EXPECT_EQ(expected->at(i).compressedSize, vec->at(i).compressedSize);
+        EXPECT_EQ(expected->at(i).uncompressedSize, vec->at(i).uncompressedSize);
+        EXPECT_EQ(arch, vec->at(i).archive);
+    }
+
+    EXPECT_EQ(zzipArch.list(true, true)->size(), arch->list(true, true)->size());
+    EXPECT_EQ(zzipArch.find("*.material", false)->size(), arch->find("*.material", false)->size());
+}
+//--------------------------------------------------------------------------
+TEST_F(MappedZipArchiveTests,FileRead)
+{
+    EXPECT_TRUE(arch->exists("rootfile.txt"));
+    EXPECT_TRUE(arch->exists("level1/materials/scripts/file.material"));
+    EXPECT_FALSE(arch->exists("missing.txt"));
+
+    DataStreamPtr stream = arch->open("rootfile.txt");
+    EXPECT_EQ((size_t)130, stream->size());
+    EXPECT_EQ(String("this is line 1 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 2 in file 1"), stream->getLine());
+
+    // Inflated in one go, so seeking back is cheap
+    stream->seek(0);
+    EXPECT_EQ(String("this is line 1 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 2 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 3 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 4 in file 1"), stream->getLine());
+    EXPECT_EQ(String("this is line 5 in file 1"), stream->getLine());
+    EXPECT_TRUE(stream->eof());
+
+    // Stored files are views of the mapping
+    DataStreamPtr empty = arch->open("level1/materials/scripts/file.material");
+    EXPECT_EQ((size_t)0, empty->size());
+    EXPECT_TRUE(empty->eof());
+
+    EXPECT_THROW(arch->open("missing.txt"), Exception);
+}
+//--------------------------------------------------------------------------
+TEST_F(MappedZipArchiveTests,StreamOutlivesArchive)
+{
+    DataStreamPtr stream1 = arch->open("rootfile.txt");
+    DataStreamPtr stream2 = arch->open("rootfile2.txt");
+    EXPECT_EQ(String("this is line 1 in file 1"), stream1->getLine());
+    EXPECT_EQ(String("this is line 1 in file 2"), stream2->getLine());
+
+    arch->unload();
+    EXPECT_EQ(String("this is line 2 in file 1"), stream1->getLine());
+    EXPECT_EQ(String("this is line 2 in file 2"), stream2->getLine());
+}
+//--------------------------------------------------------------------------
+TEST_F(MappedZipArchiveTests,ReloadAfterUnload)
+{
+    DataStreamPtr stream = arch->open("rootfile.txt");
+    arch->unload();
+    EXPECT_FALSE(arch->exists("rootfile.txt"));
+    EXPECT_THROW(arch->open("rootfile.txt"), Exception);
+    EXPECT_TRUE(arch->list()->empty());
+
+    arch->load();
+    EXPECT_TRUE(arch->exists("rootfile.txt"));
+    EXPECT_EQ(String("this is line 1 in file 1"), arch->open("rootfile.txt")->getLine());
+    EXPECT_EQ(String("this is line 1 in file 1"), stream->getLine());
+}
+//--------------------------------------------------------------------------
+TEST_F(MappedZipArchiveTests,OpenMultiple)
+{
+    StringVector names;
+    for (int i = 0; i < 20; ++i)
+    {
+        names.push_back("rootfile.txt");
+        names.push_back("rootfile2.txt");
+    }
+
+    vector<DataStreamPtr>::type streams;
+    arch->openMultiple(names, streams);
+    ASSERT_EQ(names.size(), streams.size());
+    for (size_t i = 0; i < streams.size(); i += 2)
+    {
+        EXPECT_EQ(String("this is line 1 in file 1"), streams[i]->getLine());
+        EXPECT_EQ(String("this is line 1 in file 2"), streams[i + 1]->getLine());
+    }
+
+    names.push_back("missing.txt");
+    EXPECT_THROW(arch->openMultiple(names, streams), FileNotFoundException);
+}
+//--------------------------------------------------------------------------
+TEST_F(MappedZipArchiveTests,TruncatedArchive)
+{
+    // A zip64 locator and an end of central directory record, smaller than the
+    // zip64 end of central directory record they point to
+    uchar data[42] = { 0 };
+    const uchar locatorSig[4] = { 0x50, 0x4b, 0x06, 0x07 };
+    const uchar endSig[4] = { 0x50, 0x4b, 0x05, 0x06 };
+    memcpy(data, locatorSig, 4);
+    memcpy(data + 20, endSig, 4);
+    const String path = "TruncatedArchive.zip";
+    {
+        std::ofstream file(path.c_str(), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data), sizeof(data));
+    }
+
+    MappedZipArchive truncated(path, "MappedZip");
+    EXPECT_THROW(truncated.load(), Exception);
+    std::remove(path.c_str());
+}
+//--------------------------------------------------------------------------
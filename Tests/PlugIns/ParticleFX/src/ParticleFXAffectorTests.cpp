@@ -0,0 +1,237 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+
+#include "RootWithoutRenderSystemFixture.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreParticleSystem.h"
+#include "OgreParticleSystemManager.h"
+#include "OgreParticleArrays.h"
+#include "OgreParticle.h"
+#include "OgreControllerManager.h"
+#include "OgreLinearForceAffector.h"
+#include "OgreColourFaderAffector2.h"
+#include "OgreScaleAffector.h"
+#include "OgreRotationAffector.h"
+#include "OgreDeflectorPlaneAffector.h"
+#include "OgreColourInterpolatorAffector.h"
+
+using namespace Ogre;
+
+/** Checks the _affectParticleArrays implementations of the ParticleFX
+    affectors against _affectParticles, on the same particles. */
+class ParticleFXAffectorTests : public RootWithoutRenderSystemFixture
+{
+public:
+    ControllerManager* mControllerMgr;
+    SceneManager* mSceneMgr;
+    ParticleSystem* mSystem;
+    ParticleArrays* mArrays;
+
+    void SetUp()
+    {
+        RootWithoutRenderSystemFixture::SetUp();
+        // Created by Root::initialise, the systems need one when attached
+        mControllerMgr = OGRE_NEW ControllerManager();
+        // Registers the billboard renderer, as Root::initialise does
+        ParticleSystemManager::getSingleton()._initialise();
+        mSceneMgr = mRoot->createSceneManager(ST_GENERIC);
+        mSystem = 0;
+        mArrays = 0;
+        srand(0);
+    }
+
+    void TearDown()
+    {
+        OGRE_DELETE mArrays;
+        RootWithoutRenderSystemFixture::TearDown();
+        OGRE_DELETE mControllerMgr;
+    }
+
+    /** Creates count random particles in a system using Particle instances,
+        and copies them to mArrays in iteration order. */
+    void createParticles(size_t count)
+    {
+        if (mSystem)
+            mSceneMgr->destroyParticleSystem(mSystem);
+        mSystem = mSceneMgr->createParticleSystem(count);
+        mSystem->setDefaultDimensions(3, 2);
+        mSystem->setContiguousStorage(false);
+        // The particles are allocated by the first update
+        SceneNode* node = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+        node->overrideCachedTransform(Matrix4::IDENTITY);
+        node->attachObject(mSystem);
+        mSystem->_update(0);
+        OGRE_DELETE mArrays;
+        mArrays = OGRE_NEW ParticleArrays();
+        mArrays->reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Particle* p = mSystem->createParticle();
+            ASSERT_TRUE(p != 0);
+            p->mPosition = Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * 10;
+            p->mDirection = Vector3(Math::SymmetricRandom(), Math::SymmetricRandom(), Math::SymmetricRandom()) * 20;
+            p->mColour = ColourValue(Math::UnitRandom(), Math::UnitRandom(), Math::UnitRandom(), Math::UnitRandom());
+            p->mTotalTimeToLive = 1 + Math::UnitRandom() * 4;
+            p->mTimeToLive = p->mTotalTimeToLive * Math::UnitRandom();
+            p->mRotation = Radian(Math::SymmetricRandom() * Math::PI);
+            p->mRotationSpeed = Radian(Math::SymmetricRandom() * 5);
+            if (i % 3 == 0)
+                p->setDimensions(1 + Math::UnitRandom(), 1 + Math::UnitRandom());
+            else
+                p->resetDimensions();
+        }
+
+        ParticleIterator pi = mSystem->_getIterator();
+        while (!pi.end())
+            mArrays->append(*pi.getNext());
+    }
+
+    /** Applies the affector both ways and compares the particles. */
+    void expectSameResults(ParticleAffector* affector, Real timeElapsed)
+    {
+        affector->_affectParticles(mSystem, timeElapsed);
+        affector->_affectParticleArrays(*mArrays, timeElapsed);
+
+        ASSERT_EQ(mSystem->getNumParticles(), mArrays->mCount);
+        ParticleIterator pi = mSystem->_getIterator();
+        Particle arrayParticle;
+        for (size_t i = 0; !pi.end(); ++i)
+        {
+            const Particle* p = pi.getNext();
+            mArrays->getParticle(i, arrayParticle);
+            for (size_t c = 0; c < 3; ++c)
+            {
+                expectNear(p->mPosition[c], arrayParticle.mPosition[c], i);
+                expectNear(p->mDirection[c], arrayParticle.mDirection[c], i);
+            }
+            for (size_t c = 0; c < 4; ++c)
+                expectNear(p->mColour.ptr()[c], arrayParticle.mColour.ptr()[c], i);
+            expectNear(p->mRotation.valueRadians(), arrayParticle.mRotation.valueRadians(), i);
+            EXPECT_EQ(p->hasOwnDimensions(), arrayParticle.hasOwnDimensions()) << "particle " << i;
+            if (p->hasOwnDimensions() && arrayParticle.hasOwnDimensions())
+            {
+                expectNear(p->getOwnWidth(), arrayParticle.getOwnWidth(), i);
+                expectNear(p->getOwnHeight(), arrayParticle.getOwnHeight(), i);
+            }
+        }
+    }
+
+    static void expectNear(Real expected, Real actual, size_t index)
+    {
+        EXPECT_NEAR(expected, actual, 1e-4f * std::max(Real(1), Math::Abs(expected))) << "particle " << index;
+    }
+};
+/// Particle counts around and off the 4 particles processed at a time
+static const size_t PARTICLE_COUNTS[] = { 1, 3, 4, 7, 64, 131 };
+static const size_t NUM_PARTICLE_COUNTS = sizeof(PARTICLE_COUNTS) / sizeof(PARTICLE_COUNTS[0]);
+//--------------------------------------------------------------------------
+TEST_F(ParticleFXAffectorTests, LinearForce)
+{
+    for (size_t n = 0; n < NUM_PARTICLE_COUNTS; ++n)
+    {
+        createParticles(PARTICLE_COUNTS[n]);
+        LinearForceAffector affector(mSystem);
+        affector.setForceVector(Vector3(1, -9.8f, 3));
+        affector.setForceApplication(LinearForceAffector::FA_ADD);
+        expectSameResults(&affector, 0.1f);
+        affector.setForceApplication(LinearForceAffector::FA_AVERAGE);
+        expectSameResults(&affector, 0.1f);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleFXAffectorTests, ColourFader2)
+{
+    for (size_t n = 0; n < NUM_PARTICLE_COUNTS; ++n)
+    {
+        createParticles(PARTICLE_COUNTS[n]);
+        ColourFaderAffector2 affector(mSystem);
+        affector.setAdjust1(-0.5f, 0.25f, 1.5f, -2);
+        affector.setAdjust2(2, -1.5f, -0.25f, 0.5f);
+        affector.setStateChange(1.5f);
+        // Large enough steps for some components to be clamped
+        expectSameResults(&affector, 0.4f);
+        expectSameResults(&affector, 0.4f);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleFXAffectorTests, Scaler)
+{
+    for (size_t n = 0; n < NUM_PARTICLE_COUNTS; ++n)
+    {
+        createParticles(PARTICLE_COUNTS[n]);
+        ScaleAffector affector(mSystem);
+        affector.setAdjust(2.5f);
+        expectSameResults(&affector, 0.1f);
+        affector.setAdjust(-1.5f);
+        expectSameResults(&affector, 0.1f);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleFXAffectorTests, Rotator)
+{
+    for (size_t n = 0; n < NUM_PARTICLE_COUNTS; ++n)
+    {
+        createParticles(PARTICLE_COUNTS[n]);
+        RotationAffector affector(mSystem);
+        expectSameResults(&affector, 0.1f);
+        expectSameResults(&affector, 0.7f);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleFXAffectorTests, DeflectorPlane)
+{
+    for (size_t n = 0; n < NUM_PARTICLE_COUNTS; ++n)
+    {
+        createParticles(PARTICLE_COUNTS[n]);
+        DeflectorPlaneAffector affector(mSystem);
+        // Particles on both sides of the plane, some of them crossing it
+        affector.setPlanePoint(Vector3(0, 1, 0));
+        affector.setPlaneNormal(Vector3(0.2f, 1, -0.1f).normalisedCopy());
+        affector.setBounce(0.8f);
+        expectSameResults(&affector, 0.5f);
+    }
+}
+//--------------------------------------------------------------------------
+TEST_F(ParticleFXAffectorTests, ColourInterpolator)
+{
+    for (size_t n = 0; n < NUM_PARTICLE_COUNTS; ++n)
+    {
+        createParticles(PARTICLE_COUNTS[n]);
+        ColourInterpolatorAffector affector(mSystem);
+        affector.setTimeAdjust(0, 0);
+        affector.setColourAdjust(0, ColourValue(1, 0, 0, 1));
+        affector.setTimeAdjust(1, 0.3f);
+        affector.setColourAdjust(1, ColourValue(0, 1, 0, 0.5f));
+        affector.setTimeAdjust(2, 0.8f);
+        affector.setColourAdjust(2, ColourValue(0, 0, 1, 0));
+        expectSameResults(&affector, 0.1f);
+    }
+}
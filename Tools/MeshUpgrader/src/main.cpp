@@ -70,6 +70,7 @@ void help(void)
     cout << "-srcgl     = Interpret ambiguous colours as GL style" << endl;
     cout << "-E endian  = Set endian mode 'big' 'little' or 'native' (default)" << endl;
     cout << "-b         = Recalculate bounding box (static meshes only)" << endl;
+    cout << "-c         = Write compact, lossy vertex and index data (1.10 only)" << endl;
     cout << "-V version = Specify OGRE version format to write instead of latest" << endl;
     cout << "             Options are: 1.10, 1.8, 1.7, 1.4, 1.0" << endl;
     cout << "sourcefile = name of file to convert" << endl;
@@ -184,6 +185,8 @@ void parseOpts(UnaryOptionList& unOpts, BinaryOptionList& binOpts)
     if (ui->second) {
         opts.recalcBounds = true;
     }
+    ui = unOpts.find("-c");
+    bool compact = ui->second;
 
 
     BinaryOptionList::iterator bi = binOpts.find("-l");
@@ -250,6 +253,13 @@ void parseOpts(UnaryOptionList& unOpts, BinaryOptionList& binOpts)
             logMgr->stream() << "Unrecognised target mesh version '" << bi->second << "'";          
     }
     }
+    if (compact) {
+        if (opts.targetVersion == MESH_VERSION_LATEST || opts.targetVersion == MESH_VERSION_1_10) {
+            opts.targetVersion = MESH_VERSION_1_10_COMPACT;
+        } else {
+            logMgr->stream() << "Compact data can only be written in the 1.10 format, ignoring -c";
+        }
+    }
     
 }
 
@@ -1019,6 +1029,7 @@ int main(int numargs, char** args)
         unOptList["-srcd3d"] = false;
         unOptList["-autogen"] = false;
         unOptList["-b"] = false;
+        unOptList["-c"] = false;
         binOptList["-l"] = "";
         binOptList["-d"] = "";
         binOptList["-p"] = "";
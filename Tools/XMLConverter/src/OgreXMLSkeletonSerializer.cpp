@@ -592,7 +592,10 @@ namespace Ogre {
             trackNode->InsertEndChild(TiXmlElement("keyframes"))->ToElement();
         for (unsigned short i = 0; i < track->getNumKeyFrames(); ++i)
         {
-            writeKeyFrame(keysNode, track->getNodeKeyFrame(i));
+            // Decoded copies, compressed tracks have no keyframe objects
+            TransformKeyFrame key(0, track->getNodeKeyFrameTime(i));
+            track->getNodeKeyFrameTransform(i, &key);
+            writeKeyFrame(keysNode, &key);
         }
     }
     //---------------------------------------------------------------------
@@ -26,6 +26,7 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreCompositor.cpp \
 	OgreMain/src/OgreCompositorInstance.cpp \
 	OgreMain/src/OgreCompositorManager.cpp \
+	OgreMain/src/OgreCompressedTransformKeyFrames.cpp \
 	OgreMain/src/OgreConfigFile.cpp \
 	OgreMain/src/OgreControllerManager.cpp \
 	OgreMain/src/OgreConvexBody.cpp \
@@ -36,6 +37,7 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreDepthBuffer.cpp \
 	OgreMain/src/OgreDistanceLodStrategy.cpp \
 	OgreMain/src/OgreDualQuaternion.cpp \
+	OgreMain/src/OgreDynamicAABBTree.cpp \
 	OgreMain/src/OgreDynLib.cpp \
 	OgreMain/src/OgreDynLibManager.cpp \
 	OgreMain/src/OgreEdgeListBuilder.cpp \
@@ -93,9 +95,11 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreNode.cpp \
 	OgreMain/src/OgreNumerics.cpp \
 	OgreMain/src/OgreOptimisedUtil.cpp \
+	OgreMain/src/OgreOptimisedUtilAVX2.cpp \
 	OgreMain/src/OgreOptimisedUtilGeneral.cpp \
 	OgreMain/src/OgreOptimisedUtilSSE.cpp \
 	OgreMain/src/OgreParticle.cpp \
+	OgreMain/src/OgreParticleArrays.cpp \
 	OgreMain/src/OgreParticleEmitterCommands.cpp \
 	OgreMain/src/OgreParticleEmitter.cpp \
 	OgreMain/src/OgreParticleIterator.cpp \
@@ -121,6 +125,7 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreRenderQueue.cpp \
 	OgreMain/src/OgreRenderQueueInvocation.cpp \
 	OgreMain/src/OgreRenderQueueSortingGrouping.cpp \
+	OgreMain/src/OgreRenderStateCache.cpp \
 	OgreMain/src/OgreRenderSystemCapabilities.cpp \
 	OgreMain/src/OgreRenderSystemCapabilitiesManager.cpp \
 	OgreMain/src/OgreRenderSystemCapabilitiesSerializer.cpp \
@@ -157,9 +162,11 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreSimpleRenderable.cpp \
 	OgreMain/src/OgreSimpleSpline.cpp \
 	OgreMain/src/OgreSkeleton.cpp \
+	OgreMain/src/OgreSkeletonAnimationBatch.cpp \
 	OgreMain/src/OgreSkeletonInstance.cpp \
 	OgreMain/src/OgreSkeletonManager.cpp \
 	OgreMain/src/OgreSkeletonSerializer.cpp \
+	OgreMain/src/OgreSoftwareSkinningBatch.cpp \
 	OgreMain/src/OgreStaticGeometry.cpp \
 	OgreMain/src/OgreStringConverter.cpp \
 	OgreMain/src/OgreString.cpp \
@@ -167,6 +174,7 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreSubEntity.cpp \
 	OgreMain/src/OgreSubMesh.cpp \
 	OgreMain/src/OgreTagPoint.cpp \
+	OgreMain/src/OgreTaskScheduler.cpp \
 	OgreMain/src/OgreTangentSpaceCalc.cpp \
 	OgreMain/src/OgreTechnique.cpp \
 	OgreMain/src/OgreTexture.cpp \
@@ -184,7 +192,10 @@ OGRESHARED_WEAK_CPP_SRCS= \
 	OgreMain/src/OgreWireBoundingBox.cpp \
 	OgreMain/src/OgreWorkQueue.cpp \
 	OgreMain/src/OgreZip.cpp \
+	OgreMain/src/Threading/OgreBarrierPThreads.cpp \
 	OgreMain/src/Threading/OgreDefaultWorkQueueStandard.cpp \
+	OgreMain/src/Threading/OgreStealingWorkQueue.cpp \
+	OgreMain/src/Threading/OgreThreadsPThreads.cpp \
 
 
 OGRE_WEAK_CPP_SRCS= \